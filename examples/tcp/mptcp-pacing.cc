@@ -0,0 +1,293 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * MPTCP over a shared bottleneck, with and without pacing.
+ *
+ * The client has two access links to the router R1, one per subflow, and
+ * both subflows cross the bottleneck between R1 and R2:
+ *
+ *   client ==== 100Mbps, 1ms (x2) ==== R1 ---- bottleneck ---- R2 ---- server
+ *
+ * Without pacing, each subflow sends its window as soon as it opens, and
+ * the bursts of both subflows pile up in the queue of R1 towards the
+ * bottleneck, a pfifo_fast queue disc of --queueSize packets. With the
+ * TcpSocketImpl "Pacing" attribute, each subflow releases its segments at
+ * its own pacing rate, computed from its window and its smoothed RTT.
+ *
+ * The queue of the bottleneck is sampled every millisecond. For each
+ * mode, the program prints the mean, 99th percentile and maximum of the
+ * queueing delay, the drops at the bottleneck and the goodput. With the
+ * defaults, pacing lowers the mean queueing delay; with a short queue,
+ * e.g. --queueSize=10, it mostly avoids the drops of the bursts.
+ *
+ * Usage:
+ *   ./waf --run "mptcp-pacing --bottleneckRate=10Mbps --queueSize=100"
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/traffic-control-module.h"
+#include "ns3/mptcp-socket-factory.h"
+#include "ns3/mptcp-meta-socket.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpPacing");
+
+/**
+ * One simulation of the example
+ */
+class PacingRun
+{
+public:
+  PacingRun (bool pacing, DataRate bottleneckRate, Time bottleneckDelay, uint32_t queueSize,
+             double duration);
+
+  void Execute (void);
+  void Print (std::ostream &os) const;
+
+private:
+  void Setup (void);
+  void Connect (void);
+  void FullyEstablished (Ptr<MpTcpMetaSocket> meta);
+  void HandleSend (Ptr<Socket> sock, uint32_t available);
+  void Accept (Ptr<Socket> sock, const Address &from);
+  void HandleRecv (Ptr<Socket> sock);
+  void SampleQueue (void);
+  void Drop (Ptr<const QueueItem> item);
+
+  bool m_pacing;
+  DataRate m_bottleneckRate;
+  Time m_bottleneckDelay;
+  uint32_t m_queueSize;
+  double m_duration;
+  uint32_t m_writeSize;
+  Ipv4Address m_clientAddresses[2];
+  Ipv4Address m_serverAddress;
+  Ptr<MpTcpMetaSocket> m_meta;
+  std::vector<Ptr<Socket> > m_accepted;
+  std::vector<uint8_t> m_payload;
+  Ptr<QueueDisc> m_queueDisc;
+  Ptr<Queue> m_queue;
+  std::vector<double> m_delays;  //!< Queueing delay samples, in ms
+  uint64_t m_rxBytes;
+  uint32_t m_drops;
+};
+
+PacingRun::PacingRun (bool pacing, DataRate bottleneckRate, Time bottleneckDelay, uint32_t queueSize,
+                      double duration)
+  : m_pacing (pacing),
+    m_bottleneckRate (bottleneckRate),
+    m_bottleneckDelay (bottleneckDelay),
+    m_queueSize (queueSize),
+    m_duration (duration),
+    m_writeSize (1400),
+    m_rxBytes (0),
+    m_drops (0)
+{
+}
+
+void
+PacingRun::Setup (void)
+{
+  Config::SetDefault ("ns3::TcpSocketImpl::Pacing", BooleanValue (m_pacing));
+
+  NodeContainer client;
+  NodeContainer routers;
+  NodeContainer server;
+  client.Create (1);
+  routers.Create (2);
+  server.Create (1);
+  InternetStackHelper internet;
+  internet.InstallAll ();
+
+  PointToPointHelper access;
+  access.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  access.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  PointToPointHelper bottleneck;
+  bottleneck.SetDeviceAttribute ("DataRate", DataRateValue (m_bottleneckRate));
+  bottleneck.SetChannelAttribute ("Delay", TimeValue (m_bottleneckDelay));
+  bottleneck.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (1));
+
+  Ipv4AddressHelper address;
+  for (uint32_t k = 0; k < 2; ++k)
+    {
+      std::ostringstream base;
+      base << "10.1." << k + 1 << ".0";
+      address.SetBase (base.str ().c_str (), "255.255.255.0");
+      Ipv4InterfaceContainer itf = address.Assign (access.Install (client.Get (0), routers.Get (0)));
+      m_clientAddresses[k] = itf.GetAddress (0);
+    }
+  NetDeviceContainer bottleneckDevices = bottleneck.Install (routers);
+  address.SetBase ("10.2.1.0", "255.255.255.0");
+  address.Assign (bottleneckDevices);
+  address.SetBase ("10.3.1.0", "255.255.255.0");
+  m_serverAddress = address.Assign (access.Install (routers.Get (1), server.Get (0))).GetAddress (1);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  // The queue disc of R1 is the bottleneck queue, in front of a device
+  // queue of one packet
+  TrafficControlHelper tch;
+  tch.Uninstall (bottleneckDevices);
+  tch.SetRootQueueDisc ("ns3::PfifoFastQueueDisc", "Limit", UintegerValue (m_queueSize));
+  m_queueDisc = tch.Install (bottleneckDevices.Get (0)).Get (0);
+  m_queueDisc->TraceConnectWithoutContext ("Drop", MakeCallback (&PacingRun::Drop, this));
+  m_queue = DynamicCast<PointToPointNetDevice> (bottleneckDevices.Get (0))->GetQueue ();
+
+  Ptr<Socket> listening = server.Get (0)->GetObject<MpTcpSocketFactory> ()->CreateSocket ();
+  listening->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  listening->Listen ();
+  listening->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                                MakeCallback (&PacingRun::Accept, this));
+
+  m_payload.resize (m_writeSize, 'x');
+  m_meta = DynamicCast<MpTcpMetaSocket> (client.Get (0)->GetObject<MpTcpSocketFactory> ()->CreateSocket ());
+  NS_ABORT_MSG_UNLESS (m_meta, "MPTCP socket factory should create meta sockets");
+  m_meta->SetFullyEstablishedCallback (MakeCallback (&PacingRun::FullyEstablished, this));
+  m_meta->SetSendCallback (MakeCallback (&PacingRun::HandleSend, this));
+  // The queue discs of the devices are only set up once the nodes are initialized
+  Simulator::Schedule (MilliSeconds (1), &PacingRun::Connect, this);
+  Simulator::Schedule (MilliSeconds (1), &PacingRun::SampleQueue, this);
+}
+
+void
+PacingRun::Connect (void)
+{
+  m_meta->Bind (InetSocketAddress (m_clientAddresses[0], 0));
+  m_meta->Connect (InetSocketAddress (m_serverAddress, 50000));
+}
+
+void
+PacingRun::FullyEstablished (Ptr<MpTcpMetaSocket> meta)
+{
+  meta->ConnectNewSubflow (InetSocketAddress (m_clientAddresses[1], 0),
+                           InetSocketAddress (m_serverAddress, 50000));
+}
+
+void
+PacingRun::HandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  // The first data completes the MPTCP handshake
+  while (sock->GetTxAvailable () >= m_writeSize)
+    {
+      if (sock->Send (&m_payload[0], m_writeSize, 0) <= 0)
+        {
+          break;
+        }
+    }
+}
+
+void
+PacingRun::Accept (Ptr<Socket> sock, const Address &from)
+{
+  sock->SetRecvCallback (MakeCallback (&PacingRun::HandleRecv, this));
+  m_accepted.push_back (sock);
+}
+
+void
+PacingRun::HandleRecv (Ptr<Socket> sock)
+{
+  Ptr<Packet> p;
+  while ((p = sock->Recv ()))
+    {
+      m_rxBytes += p->GetSize ();
+    }
+}
+
+void
+PacingRun::SampleQueue (void)
+{
+  uint32_t bytes = m_queueDisc->GetNBytes () + m_queue->GetNBytes ();
+  m_delays.push_back (m_bottleneckRate.CalculateBytesTxTime (bytes).GetSeconds () * 1000);
+  Simulator::Schedule (MilliSeconds (1), &PacingRun::SampleQueue, this);
+}
+
+void
+PacingRun::Drop (Ptr<const QueueItem> item)
+{
+  ++m_drops;
+}
+
+void
+PacingRun::Execute (void)
+{
+  Setup ();
+  Simulator::Stop (Seconds (m_duration));
+  Simulator::Run ();
+  m_meta = 0;
+  m_accepted.clear ();
+  m_queueDisc = 0;
+  m_queue = 0;
+  Simulator::Destroy ();
+}
+
+void
+PacingRun::Print (std::ostream &os) const
+{
+  std::vector<double> delays (m_delays);
+  std::sort (delays.begin (), delays.end ());
+  double sum = 0;
+  for (uint32_t i = 0; i < delays.size (); ++i)
+    {
+      sum += delays[i];
+    }
+  os << std::setw (10) << (m_pacing ? "paced" : "bursts")
+     << std::setw (12) << sum / std::max<size_t> (delays.size (), 1)
+     << std::setw (12) << (delays.empty () ? 0 : delays[delays.size () * 99 / 100])
+     << std::setw (12) << (delays.empty () ? 0 : delays.back ())
+     << std::setw (8) << m_drops
+     << std::setw (14) << m_rxBytes * 8 / m_duration / 1e6 << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string bottleneckRate = "10Mbps";
+  std::string bottleneckDelay = "10ms";
+  uint32_t queueSize = 100;
+  double duration = 10.0;
+
+  CommandLine cmd;
+  cmd.AddValue ("bottleneckRate", "rate of the shared bottleneck", bottleneckRate);
+  cmd.AddValue ("bottleneckDelay", "delay of the shared bottleneck", bottleneckDelay);
+  cmd.AddValue ("queueSize", "packets in the queue of the shared bottleneck", queueSize);
+  cmd.AddValue ("duration", "simulated seconds of each run", duration);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1400));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (65535));
+  Config::SetDefault ("ns3::TcpSocketImpl::Timestamp", BooleanValue (false));
+
+  std::cout << "Queueing delay at the " << bottleneckRate << " bottleneck, in ms" << std::endl;
+  std::cout << std::setw (10) << "mode" << std::setw (12) << "mean" << std::setw (12) << "p99"
+            << std::setw (12) << "max" << std::setw (8) << "drops"
+            << std::setw (14) << "goodput Mbps" << std::endl;
+  for (uint32_t pacing = 0; pacing < 2; ++pacing)
+    {
+      PacingRun run (pacing == 1, DataRate (bottleneckRate), Time (bottleneckDelay), queueSize, duration);
+      run.Execute ();
+      run.Print (std::cout);
+    }
+  return 0;
+}
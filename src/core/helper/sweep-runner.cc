@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "sweep-runner.h"
+#include "ns3/isolated-simulation.h"
+#include "ns3/system-thread.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::SweepRunner implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SweepRunner");
+
+namespace {
+
+/** The results of the run of the current thread, if any. */
+thread_local std::vector<std::pair<std::string, double> > *g_results = 0;
+
+} // unnamed namespace
+
+SweepRunner::SweepRunner ()
+  : m_next (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+SweepRunner::AddRun (Callback<void> run)
+{
+  NS_LOG_FUNCTION (this);
+  m_runs.push_back (run);
+  return m_runs.size () - 1;
+}
+
+uint32_t
+SweepRunner::GetNRuns (void) const
+{
+  return m_runs.size ();
+}
+
+void
+SweepRunner::Execute (uint32_t threads)
+{
+  NS_LOG_FUNCTION (this << threads);
+  NS_ASSERT_MSG (threads > 0, "At least one thread is needed");
+  // Each run only touches its own results, which are never reallocated
+  m_results.clear ();
+  m_results.resize (m_runs.size ());
+  m_next = 0;
+
+  std::vector<Ptr<SystemThread> > pool;
+  for (uint32_t i = 0; i < threads && i < m_runs.size (); ++i)
+    {
+      pool.push_back (Create<SystemThread> (MakeCallback (&SweepRunner::Work, this)));
+      pool.back ()->Start ();
+    }
+  for (uint32_t i = 0; i < pool.size (); ++i)
+    {
+      pool[i]->Join ();
+    }
+}
+
+void
+SweepRunner::Work (void)
+{
+  // No logging out of the isolated simulations: the time printer of the
+  // process would look at the simulator of the main thread
+  while (true)
+    {
+      uint32_t run;
+      {
+        CriticalSection critical (m_mutex);
+        if (m_next == m_runs.size ())
+          {
+            return;
+          }
+        run = m_next++;
+      }
+      g_results = &m_results[run];
+      {
+        IsolatedSimulation isolation;
+        m_runs[run] ();
+      }
+      g_results = 0;
+    }
+}
+
+void
+SweepRunner::Record (std::string name, double value)
+{
+  NS_LOG_FUNCTION (name << value);
+  NS_ASSERT_MSG (g_results != 0, "Results can only be recorded by a run of a sweep");
+  g_results->push_back (std::make_pair (name, value));
+}
+
+bool
+SweepRunner::GetResult (uint32_t run, std::string name, double &value) const
+{
+  NS_LOG_FUNCTION (this << run << name);
+  if (run >= m_results.size ())
+    {
+      return false;
+    }
+  for (Results::const_reverse_iterator i = m_results[run].rbegin ();
+       i != m_results[run].rend (); ++i)
+    {
+      if (i->first == name)
+        {
+          value = i->second;
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+SweepRunner::Write (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  os << "run,name,value" << std::endl;
+  for (uint32_t run = 0; run < m_results.size (); ++run)
+    {
+      for (Results::const_iterator i = m_results[run].begin ();
+           i != m_results[run].end (); ++i)
+        {
+          os << run << "," << i->first << "," << i->second << std::endl;
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SWEEP_RUNNER_H
+#define SWEEP_RUNNER_H
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ns3/callback.h"
+#include "ns3/non-copyable.h"
+#include "ns3/system-mutex.h"
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::SweepRunner declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ * \brief Run independent simulations on a pool of threads.
+ *
+ * A parameter sweep runs the same scenario many times with different
+ * parameters. Instead of one process per run, the runs are added to a
+ * SweepRunner, which executes each of them in an IsolatedSimulation on
+ * one of its threads: the process starts, and registers the types, once.
+ *
+ * A run builds its simulation, runs it, and records its results with
+ * Record, which may be called from the code of the simulation itself.
+ * The results are written once all the runs are done, ordered by run,
+ * so that the output does not depend on the number of threads:
+ * \code
+ *   void RunOne (uint32_t segmentSize)
+ *   {
+ *     Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (segmentSize));
+ *     ... build the topology and run the simulation ...
+ *     SweepRunner::Record ("goodput", goodput);
+ *   }
+ *
+ *   SweepRunner sweep;
+ *   for (uint32_t size = 500; size <= 1500; size += 100)
+ *     {
+ *       sweep.AddRun (MakeBoundCallback (&RunOne, size));
+ *     }
+ *   sweep.Execute (8);
+ *   sweep.Write (std::cout);
+ * \endcode
+ *
+ * The defaults set with Config::SetDefault and the global values set by
+ * the main thread before Execute are seen by all the runs.
+ */
+class SweepRunner : private NonCopyable
+{
+public:
+  SweepRunner ();
+
+  /**
+   * Add a run to the sweep.
+   *
+   * \param [in] run The function running one simulation, called from an
+   *             isolated thread.
+   * \return The index of the run.
+   */
+  uint32_t AddRun (Callback<void> run);
+  /** \return The number of runs of the sweep. */
+  uint32_t GetNRuns (void) const;
+
+  /**
+   * Execute the runs, and return once they are all done.
+   *
+   * \param [in] threads The number of threads executing the runs.
+   */
+  void Execute (uint32_t threads);
+
+  /**
+   * Record a result of the run of the calling thread.
+   *
+   * \param [in] name The name of the result.
+   * \param [in] value The value of the result.
+   */
+  static void Record (std::string name, double value);
+
+  /**
+   * \param [in] run The index of a run.
+   * \param [in] name The name of a result.
+   * \param [out] value The last value recorded by the run under \p name.
+   * \return \c true if the run recorded a result named \p name.
+   */
+  bool GetResult (uint32_t run, std::string name, double &value) const;
+  /**
+   * Write the results as comma separated values, with the index of the
+   * run, the name and the value of each result, in the order of the runs
+   * and then in the order they were recorded.
+   *
+   * \param [in,out] os The output stream.
+   */
+  void Write (std::ostream &os) const;
+
+private:
+  /** Execute runs until none is left, in a thread of the pool. */
+  void Work (void);
+
+  /** The results of a run, by order of recording. */
+  typedef std::vector<std::pair<std::string, double> > Results;
+
+  std::vector<Callback<void> > m_runs;  //!< The runs
+  std::vector<Results> m_results;       //!< The results of each run
+  uint32_t m_next;                      //!< The next run to execute
+  SystemMutex m_mutex;                  //!< Protects m_next
+};
+
+} // namespace ns3
+
+#endif /* SWEEP_RUNNER_H */
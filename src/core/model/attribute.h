@@ -22,6 +22,7 @@
 
 #include <string>
 #include <stdint.h>
+#include <atomic>
 #include "ptr.h"
 #include "simple-ref-count.h"
 
@@ -64,8 +65,14 @@ class ObjectBase;
  * Instances of this class should always be wrapped into an Attribute object.
  * Most subclasses of this base class are implemented by the 
  * ATTRIBUTE_HELPER_* macros.
+ *
+ * The values, accessors and checkers held by TypeId are shared by the
+ * threads running an IsolatedSimulation, so these three classes count
+ * their references atomically.
  */
-class AttributeValue : public SimpleRefCount<AttributeValue>
+class AttributeValue : public SimpleRefCount<AttributeValue, empty,
+                                             DefaultDeleter<AttributeValue>,
+                                             std::atomic<uint32_t> >
 {
 public:
   AttributeValue ();
@@ -111,7 +118,9 @@ public:
  * of this base class are usually provided through the MakeAccessorHelper
  * template functions, hidden behind an ATTRIBUTE_HELPER_* macro.
  */
-class AttributeAccessor : public SimpleRefCount<AttributeAccessor>
+class AttributeAccessor : public SimpleRefCount<AttributeAccessor, empty,
+                                                DefaultDeleter<AttributeAccessor>,
+                                                std::atomic<uint32_t> >
 {
 public:
   AttributeAccessor ();
@@ -163,7 +172,9 @@ public:
  * Most subclasses of this base class are implemented by the 
  * ATTRIBUTE_HELPER_HEADER and ATTRIBUTE_HELPER_CPP macros.
  */
-class AttributeChecker : public SimpleRefCount<AttributeChecker>
+class AttributeChecker : public SimpleRefCount<AttributeChecker, empty,
+                                               DefaultDeleter<AttributeChecker>,
+                                               std::atomic<uint32_t> >
 {
 public:
   AttributeChecker ();
@@ -28,7 +28,9 @@
 #include "attribute.h"
 #include "attribute-helper.h"
 #include "simple-ref-count.h"
+#include "small-object-pool.h"
 #include <typeinfo>
+#include <atomic>
 
 /**
  * \file
@@ -135,12 +137,37 @@ struct CallbackTraits<T *>
  * \ingroup callbackimpl
  * Abstract base class for CallbackImpl
  * Provides reference counting and equality test.
+ *
+ * The count is atomic, since the constructors registered with TypeId are
+ * copied by the threads running an IsolatedSimulation.
  */
-class CallbackImplBase : public SimpleRefCount<CallbackImplBase>
+class CallbackImplBase : public SimpleRefCount<CallbackImplBase, empty,
+                                               DefaultDeleter<CallbackImplBase>,
+                                               std::atomic<uint32_t> >
 {
 public:
   /** Virtual destructor */
   virtual ~CallbackImplBase () {}
+  /**
+   * Allocate a callback implementation from the free lists of the thread.
+   *
+   * \param [in] size The size of the implementation.
+   * \return The storage of the implementation.
+   */
+  static void * operator new (std::size_t size)
+  {
+    return SmallObjectPool::Allocate (size);
+  }
+  /**
+   * Release a callback implementation to the free lists of the thread.
+   *
+   * \param [in] p The storage of the implementation.
+   * \param [in] size The size of the implementation.
+   */
+  static void operator delete (void *p, std::size_t size)
+  {
+    SmallObjectPool::Deallocate (p, size);
+  }
   /**
    * Equality test
    *
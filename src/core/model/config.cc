@@ -18,7 +18,7 @@
  * Authors: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "config.h"
-#include "singleton.h"
+#include "isolated-simulation.h"
 #include "object.h"
 #include "global-value.h"
 #include "object-ptr-container.h"
@@ -572,8 +572,11 @@ Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &conta
     }
 }
 
-/** Config system implementation class. */
-class ConfigImpl : public Singleton<ConfigImpl>
+/**
+ * Config system implementation class, of which each IsolatedSimulation has
+ * its own instance.
+ */
+class ConfigImpl : public IsolatedSingleton<ConfigImpl>
 {
 public:
   /** \copydoc Config::Set() */
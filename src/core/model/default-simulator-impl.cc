@@ -71,7 +71,7 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
-  m_eventsWithContextEmpty = true;
+  m_eventCount = 0;
   m_main = SystemThread::Self();
 }
 
@@ -146,6 +146,7 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
+  m_eventCount++;
   next.impl->Invoke ();
   next.impl->Unref ();
 
@@ -161,22 +162,14 @@ DefaultSimulatorImpl::IsFinished (void) const
 void
 DefaultSimulatorImpl::ProcessEventsWithContext (void)
 {
-  if (m_eventsWithContextEmpty)
+  if (m_eventsWithContext.IsEmpty ())
     {
       return;
     }
 
-  // swap queues
-  EventsWithContext eventsWithContext;
-  {
-    CriticalSection cs (m_eventsWithContextMutex);
-    m_eventsWithContext.swap(eventsWithContext);
-    m_eventsWithContextEmpty = true;
-  }
-  while (!eventsWithContext.empty ())
+  EventWithContext event;
+  while (m_eventsWithContext.Pop (event))
     {
-       EventWithContext event = eventsWithContext.front ();
-       eventsWithContext.pop_front ();
        Scheduler::Event ev;
        ev.impl = event.event;
        ev.key.m_ts = m_currentTs + event.timestamp;
@@ -269,11 +262,7 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
       // Current time added in ProcessEventsWithContext()
       ev.timestamp = delay.GetTimeStep ();
       ev.event = event;
-      {
-        CriticalSection cs (m_eventsWithContextMutex);
-        m_eventsWithContext.push_back(ev);
-        m_eventsWithContextEmpty = false;
-      }
+      m_eventsWithContext.Push (ev);
     }
 }
 
@@ -414,4 +403,10 @@ DefaultSimulatorImpl::GetContext (void) const
   return m_currentContext;
 }
 
+uint64_t
+DefaultSimulatorImpl::GetEventCount (void) const
+{
+  return m_eventCount;
+}
+
 } // namespace ns3
@@ -25,7 +25,7 @@
 #include "scheduler.h"
 #include "event-impl.h"
 #include "system-thread.h"
-#include "ns3/system-mutex.h"
+#include "mpsc-queue.h"
 
 #include "ptr.h"
 
@@ -77,6 +77,7 @@ public:
   virtual void SetScheduler (ObjectFactory schedulerFactory);
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
+  virtual uint64_t GetEventCount (void) const;
 
 private:
   virtual void DoDispose (void);
@@ -95,17 +96,11 @@ private:
     /** The event implementation. */
     EventImpl *event;
   };
-  /** Container type for the events from a different context. */
-  typedef std::list<struct EventWithContext> EventsWithContext;
-  /** The container of events from a different context. */
-  EventsWithContext m_eventsWithContext;
   /**
-   * Flag \c true if all events with context have been moved to the
-   * primary event queue.
+   * The events from a different context, pushed without a lock by the
+   * other threads and moved to the main event queue by the main thread.
    */
-  bool m_eventsWithContextEmpty;
-  /** Mutex to control access to the list of events with context. */
-  SystemMutex m_eventsWithContextMutex;
+  MpscQueue<struct EventWithContext> m_eventsWithContext;
 
   /** Container type for the events to run at Simulator::Destroy() */
   typedef std::list<EventId> DestroyEvents;
@@ -130,6 +125,9 @@ private:
    */
   int m_unscheduledEvents;
 
+  /** The number of events executed. */
+  uint64_t m_eventCount;
+
   /** Main execution thread. */
   SystemThread::ThreadId m_main;
 };
@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include "simple-ref-count.h"
+#include "small-object-pool.h"
 
 /**
  * \file
@@ -66,6 +67,27 @@ public:
    */
   bool IsCancelled (void);
 
+  /**
+   * Allocate an event from the free lists of the thread.
+   *
+   * \param [in] size The size of the event.
+   * \return The storage of the event.
+   */
+  static void * operator new (std::size_t size)
+  {
+    return SmallObjectPool::Allocate (size);
+  }
+  /**
+   * Release an event to the free lists of the thread.
+   *
+   * \param [in] p The storage of the event.
+   * \param [in] size The size of the event.
+   */
+  static void operator delete (void *p, std::size_t size)
+  {
+    SmallObjectPool::Deallocate (p, size);
+  }
+
 protected:
   /**
    * Implementation for Invoke().
@@ -23,11 +23,13 @@
 #include "string.h"
 #include "uinteger.h"
 #include "log.h"
+#include "isolated-simulation.h"
 
 #include "ns3/core-config.h"
 #ifdef HAVE_STDLIB_H
 #include <cstdlib>
 #endif
+#include <map>
 
 /**
  * \file
@@ -39,6 +41,20 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalValue");
 
+namespace {
+
+/**
+ * The values set by an IsolatedSimulation, which it sees instead of the
+ * current values of the process.
+ */
+struct IsolatedValues : public IsolatedSingleton<IsolatedValues>
+{
+  /** The values, by global value. */
+  std::map<const GlobalValue *, Ptr<AttributeValue> > values;
+};
+
+} // unnamed namespace
+
 GlobalValue::GlobalValue (std::string name, std::string help,
                           const AttributeValue &initialValue,
                           Ptr<const AttributeChecker> checker)
@@ -117,7 +133,18 @@ void
 GlobalValue::GetValue (AttributeValue &value) const
 {
   NS_LOG_FUNCTION (&value);
-  bool ok = m_checker->Copy (*m_currentValue, value);
+  const AttributeValue *current = PeekPointer (m_currentValue);
+  if (IsolatedSimulation::IsActive ())
+    {
+      const std::map<const GlobalValue *, Ptr<AttributeValue> > &values =
+        IsolatedValues::Get ()->values;
+      std::map<const GlobalValue *, Ptr<AttributeValue> >::const_iterator i = values.find (this);
+      if (i != values.end ())
+        {
+          current = PeekPointer (i->second);
+        }
+    }
+  bool ok = m_checker->Copy (*current, value);
   if (ok)
     {
       return;
@@ -127,7 +154,7 @@ GlobalValue::GetValue (AttributeValue &value) const
     {
       NS_FATAL_ERROR ("GlobalValue name="<<m_name<<": input value is not a string");
     }
-  str->Set (m_currentValue->SerializeToString (m_checker));
+  str->Set (current->SerializeToString (m_checker));
 }
 Ptr<const AttributeChecker> 
 GlobalValue::GetChecker (void) const
@@ -147,6 +174,11 @@ GlobalValue::SetValue (const AttributeValue &value)
     {
       return 0;
     }
+  if (IsolatedSimulation::IsActive ())
+    {
+      IsolatedValues::Get ()->values[this] = v;
+      return true;
+    }
   m_currentValue = v;
   return true;
 }
@@ -201,6 +233,11 @@ void
 GlobalValue::ResetInitialValue (void)
 {
   NS_LOG_FUNCTION (this);
+  if (IsolatedSimulation::IsActive ())
+    {
+      IsolatedValues::Get ()->values[this] = m_initialValue;
+      return;
+    }
   m_currentValue = m_initialValue;
 }
 
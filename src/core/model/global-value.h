@@ -50,6 +50,9 @@ namespace ns3 {
  * Users of the ns3::CommandLine class also get the ability to set global 
  * values through commandline arguments to their program: --Name=Value will
  * set global value Name to Value.
+ *
+ * The values set by a thread running an IsolatedSimulation are only seen
+ * by this thread, until the isolation ends.
  */
 class GlobalValue
 {
@@ -236,6 +236,12 @@ HeapScheduler::Remove (const Event &ev)
           NS_ASSERT (m_heap[i].impl == ev.impl);
           Exch (i, Last ());
           m_heap.pop_back ();
+          // The last item moved to i may be smaller than its new parent
+          while (!IsBottom (i) && !IsRoot (i) && IsLessStrictly (i, Parent (i)))
+            {
+              Exch (i, Parent (i));
+              i = Parent (i);
+            }
           TopDown (i);
           return;
         }
@@ -0,0 +1,76 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "isolated-simulation.h"
+#include "simulator.h"
+#include "assert.h"
+#include "log.h"
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::IsolatedSimulation implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("IsolatedSimulation");
+
+namespace {
+
+/** The isolation of the current thread, if any. */
+thread_local IsolatedSimulation *g_isolation = 0;
+
+} // unnamed namespace
+
+std::atomic<uint32_t> IsolatedSimulation::m_isolations (0);
+
+IsolatedSimulation::IsolatedSimulation ()
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (g_isolation == 0, "The thread is already isolated");
+  g_isolation = this;
+  m_isolations++;
+}
+
+IsolatedSimulation::~IsolatedSimulation ()
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Destroy ();
+  while (!m_cleanups.empty ())
+    {
+      void (*cleanup)(void) = m_cleanups.back ();
+      m_cleanups.pop_back ();
+      cleanup ();
+    }
+  g_isolation = 0;
+  m_isolations--;
+}
+
+bool
+IsolatedSimulation::IsThreadIsolated (void)
+{
+  return g_isolation != 0;
+}
+
+void
+IsolatedSimulation::ScheduleCleanup (void (*cleanup)(void))
+{
+  NS_ASSERT_MSG (g_isolation != 0, "The thread is not isolated");
+  g_isolation->m_cleanups.push_back (cleanup);
+}
+
+} // namespace ns3
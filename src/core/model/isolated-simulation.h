@@ -0,0 +1,185 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ISOLATED_SIMULATION_H
+#define ISOLATED_SIMULATION_H
+
+#include "non-copyable.h"
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::IsolatedSimulation and ns3::IsolatedSingleton declarations, and
+ * template implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ * \brief Run a simulation in a thread, independently of the other threads.
+ *
+ * While an instance exists, the thread which created it has its own
+ * simulation state, distinct from the one of the process and of the other
+ * threads:
+ *  - the Simulator implementation, and the SimulationSingleton objects;
+ *  - the NodeList and the ChannelList;
+ *  - the Names and the Config root namespace objects;
+ *  - the values set with GlobalValue::Bind and Config::SetGlobal, and the
+ *    attribute initial values set with Config::SetDefault: the thread
+ *    starts with the values of the process, and its changes are not seen
+ *    by the other threads;
+ *  - the stream indices handed out by RngSeedManager, which start from 0.
+ *
+ * The destructor destroys the simulation and this state. Independent
+ * simulations may thus run concurrently in the threads of a process, as
+ * SweepRunner does:
+ * \code
+ *   {
+ *     IsolatedSimulation isolation;
+ *     Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1400));
+ *     ... build the topology ...
+ *     Simulator::Run ();
+ *   }
+ * \endcode
+ *
+ * The TypeId registry, the log components, the Time resolution and the
+ * packet metadata settings remain shared: they should be set up before
+ * the threads are started, and left alone while they run.
+ */
+class IsolatedSimulation : private NonCopyable
+{
+public:
+  /** Isolate the calling thread, which must not be isolated already. */
+  IsolatedSimulation ();
+  /**
+   * Destroy the simulation of the thread, and call the cleanup functions
+   * scheduled, in the reverse order.
+   */
+  ~IsolatedSimulation ();
+
+  /**
+   * \return \c true if the calling thread runs an isolated simulation.
+   */
+  static inline bool IsActive (void);
+  /**
+   * Schedule a function releasing isolated state.
+   *
+   * Unlike Simulator::ScheduleDestroy, which runs when each simulation of
+   * the thread is destroyed, the function is called when the isolation
+   * ends.
+   *
+   * \param [in] cleanup The function, called from the isolated thread.
+   */
+  static void ScheduleCleanup (void (*cleanup)(void));
+
+private:
+  /** \return \c true if the calling thread is isolated. */
+  static bool IsThreadIsolated (void);
+
+  /** The cleanup functions, in the order they were scheduled. */
+  std::vector<void (*)(void)> m_cleanups;
+  /**
+   * The number of isolated threads, so that the threads of a process
+   * running no isolated simulation do not look up the thread state.
+   */
+  static std::atomic<uint32_t> m_isolations;
+};
+
+/**
+ * \ingroup access
+ * \brief A singleton of which each isolated simulation has its own instance.
+ *
+ * Like Singleton, the instance of the process lives until the process
+ * exits. A thread running an IsolatedSimulation gets an instance of its
+ * own instead, created by the first call to Get and deleted when the
+ * isolation ends.
+ */
+template <typename T>
+class IsolatedSingleton : private NonCopyable
+{
+public:
+  /**
+   * Get a pointer to the instance of the calling thread.
+   *
+   * \return The isolated instance if the thread runs an IsolatedSimulation,
+   *         the instance of the process otherwise.
+   */
+  static T *Get (void);
+
+private:
+  /** \return The address of the isolated instance of the thread. */
+  static T **PeekIsolated (void);
+  /** Delete the isolated instance of the thread. */
+  static void DeleteIsolated (void);
+};
+
+} // namespace ns3
+
+
+/********************************************************************
+ *  Implementation of the inline functions and templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+bool
+IsolatedSimulation::IsActive (void)
+{
+  return m_isolations.load (std::memory_order_relaxed) != 0 && IsThreadIsolated ();
+}
+
+template <typename T>
+T *
+IsolatedSingleton<T>::Get (void)
+{
+  if (IsolatedSimulation::IsActive ())
+    {
+      T **isolated = PeekIsolated ();
+      if (*isolated == 0)
+        {
+          *isolated = new T ();
+          IsolatedSimulation::ScheduleCleanup (&IsolatedSingleton<T>::DeleteIsolated);
+        }
+      return *isolated;
+    }
+  static T object;
+  return &object;
+}
+
+template <typename T>
+T **
+IsolatedSingleton<T>::PeekIsolated (void)
+{
+  static thread_local T *object = 0;
+  return &object;
+}
+
+template <typename T>
+void
+IsolatedSingleton<T>::DeleteIsolated (void)
+{
+  T **isolated = PeekIsolated ();
+  delete *isolated;
+  *isolated = 0;
+}
+
+} // namespace ns3
+
+#endif /* ISOLATED_SIMULATION_H */
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+
+/**
+ * \file
+ * \ingroup thread
+ * Declaration and implementation of the ns3::MpscQueue template.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup thread
+ * \brief A lock-free multiple producer, single consumer FIFO queue.
+ *
+ * Any number of threads may Push items concurrently while a single thread,
+ * the consumer, calls IsEmpty and Pop. The queue is a singly linked list
+ * with a dummy node at its head:
+ *  - Push is wait-free: it swaps the new node into the tail with one atomic
+ *    exchange, then links the previous tail to it;
+ *  - IsEmpty is wait-free: it loads the link of the head node, which is only
+ *    written when a producer links the first item;
+ *  - Pop never blocks, but an item whose producer has swapped the tail and
+ *    not yet linked it is not visible until the link is written. Pop then
+ *    returns \c false, and the item is found by a later call.
+ *
+ * Items pushed by the same thread are popped in the order they were pushed.
+ *
+ * \tparam T \deduced The type of the items, copied in and out of the queue.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+  /** Constructor. */
+  MpscQueue ();
+  /** Destructor: the items left in the queue are dropped. */
+  ~MpscQueue ();
+
+  /**
+   * Append an item to the queue. May be called from any thread.
+   *
+   * \param [in] item The item to append.
+   */
+  void Push (const T &item);
+  /**
+   * Check if the queue holds linked items. Only called by the consumer.
+   *
+   * \return \c true if Pop would fail.
+   */
+  bool IsEmpty (void) const;
+  /**
+   * Remove the item at the head of the queue. Only called by the consumer.
+   *
+   * \param [out] item The item removed.
+   * \return \c false if the queue was empty, in which case \p item is not
+   *         modified.
+   */
+  bool Pop (T &item);
+
+private:
+  /** Copy constructor, not implemented. */
+  MpscQueue (const MpscQueue &);
+  /**
+   * Assignment operator, not implemented.
+   * \returns The queue.
+   */
+  MpscQueue & operator = (const MpscQueue &);
+
+  /** A node of the list. */
+  struct Node
+  {
+    std::atomic<Node *> next;  //!< The next node, written once by a producer
+    T item;                    //!< The item
+  };
+
+  /** The last node, swapped by the producers. */
+  std::atomic<Node *> m_tail;
+  /** Keeps m_head off the cache line the producers write m_tail to. */
+  char m_padding[64 - sizeof (std::atomic<Node *>)];
+  /** The dummy node before the first item, only used by the consumer. */
+  Node *m_head;
+};
+
+} // namespace ns3
+
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+template <typename T>
+MpscQueue<T>::MpscQueue ()
+{
+  Node *stub = new Node;
+  stub->next.store (0, std::memory_order_relaxed);
+  m_head = stub;
+  m_tail.store (stub, std::memory_order_relaxed);
+}
+
+template <typename T>
+MpscQueue<T>::~MpscQueue ()
+{
+  while (m_head != 0)
+    {
+      Node *next = m_head->next.load (std::memory_order_relaxed);
+      delete m_head;
+      m_head = next;
+    }
+}
+
+template <typename T>
+void
+MpscQueue<T>::Push (const T &item)
+{
+  Node *node = new Node;
+  node->next.store (0, std::memory_order_relaxed);
+  node->item = item;
+  Node *prev = m_tail.exchange (node, std::memory_order_acq_rel);
+  // From here to the store, the consumer sees the queue as ending at prev
+  prev->next.store (node, std::memory_order_release);
+}
+
+template <typename T>
+bool
+MpscQueue<T>::IsEmpty (void) const
+{
+  return m_head->next.load (std::memory_order_acquire) == 0;
+}
+
+template <typename T>
+bool
+MpscQueue<T>::Pop (T &item)
+{
+  Node *next = m_head->next.load (std::memory_order_acquire);
+  if (next == 0)
+    {
+      return false;
+    }
+  // The first item node becomes the new dummy node
+  item = next->item;
+  delete m_head;
+  m_head = next;
+  return true;
+}
+
+} // namespace ns3
+
+#endif /* MPSC_QUEUE_H */
@@ -22,7 +22,7 @@
 #include "assert.h"
 #include "abort.h"
 #include "names.h"
-#include "singleton.h"
+#include "isolated-simulation.h"
 
 /**
  * \file
@@ -116,9 +116,10 @@ NameNode::~NameNode ()
 
 /**
  * \ingroup config
- * The singleton root Names object.
+ * The singleton root Names object, of which each IsolatedSimulation has
+ * its own instance.
  */
-class NamesPriv : public Singleton<NamesPriv>
+class NamesPriv : public IsolatedSingleton<NamesPriv>
 {
 public:
   /** Constructor. */
@@ -0,0 +1,233 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "quad-heap-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <string.h>
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::QuadHeapScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("QuadHeapScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (QuadHeapScheduler);
+
+/** Alignment of the keys, the size of a cache line. */
+static const uintptr_t KEY_ALIGNMENT = 64;
+
+const uint32_t QuadHeapScheduler::ROOT;
+
+TypeId
+QuadHeapScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::QuadHeapScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<QuadHeapScheduler> ()
+  ;
+  return tid;
+}
+
+QuadHeapScheduler::QuadHeapScheduler ()
+  : m_buffer (0),
+    m_keys (0),
+    m_impls (0),
+    m_end (ROOT),
+    m_capacity (0)
+{
+  NS_LOG_FUNCTION (this);
+  Grow ();
+}
+
+QuadHeapScheduler::~QuadHeapScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+  delete [] m_buffer;
+  delete [] m_impls;
+}
+
+uint32_t
+QuadHeapScheduler::Parent (uint32_t index)
+{
+  return index / 4 + 2;
+}
+
+uint32_t
+QuadHeapScheduler::FirstChild (uint32_t index)
+{
+  return 4 * index - 8;
+}
+
+void
+QuadHeapScheduler::Grow (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t capacity = (m_capacity == 0) ? 256 : 2 * m_capacity;
+  NS_ASSERT_MSG (capacity / 4 + 2 < capacity, "Heap too large");
+
+  char *buffer = new char [capacity * sizeof (EventKey) + KEY_ALIGNMENT];
+  uintptr_t address = reinterpret_cast<uintptr_t> (buffer);
+  address = (address + KEY_ALIGNMENT - 1) & ~(KEY_ALIGNMENT - 1);
+  EventKey *keys = reinterpret_cast<EventKey *> (address);
+  EventImpl **impls = new EventImpl * [capacity];
+  if (m_capacity != 0)
+    {
+      memcpy (keys, m_keys, m_end * sizeof (EventKey));
+      memcpy (impls, m_impls, m_end * sizeof (EventImpl *));
+    }
+  delete [] m_buffer;
+  delete [] m_impls;
+  m_buffer = buffer;
+  m_keys = keys;
+  m_impls = impls;
+  m_capacity = capacity;
+}
+
+void
+QuadHeapScheduler::SiftUp (uint32_t index, const EventKey &key, EventImpl *impl)
+{
+  while (index != ROOT)
+    {
+      uint32_t parent = Parent (index);
+      if (!(key < m_keys[parent]))
+        {
+          break;
+        }
+      m_keys[index] = m_keys[parent];
+      m_impls[index] = m_impls[parent];
+      index = parent;
+    }
+  m_keys[index] = key;
+  m_impls[index] = impl;
+}
+
+void
+QuadHeapScheduler::SiftDown (uint32_t index, const EventKey &key, EventImpl *impl)
+{
+  while (true)
+    {
+      uint32_t child = FirstChild (index);
+      if (child >= m_end)
+        {
+          break;
+        }
+      uint32_t last = std::min (child + 4, m_end);
+      uint32_t smallest = child;
+      for (++child; child < last; ++child)
+        {
+          if (m_keys[child] < m_keys[smallest])
+            {
+              smallest = child;
+            }
+        }
+      if (!(m_keys[smallest] < key))
+        {
+          break;
+        }
+      m_keys[index] = m_keys[smallest];
+      m_impls[index] = m_impls[smallest];
+      index = smallest;
+    }
+  m_keys[index] = key;
+  m_impls[index] = impl;
+}
+
+void
+QuadHeapScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  if (m_end == m_capacity)
+    {
+      Grow ();
+    }
+  SiftUp (m_end++, ev.key, ev.impl);
+}
+
+bool
+QuadHeapScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_end == ROOT;
+}
+
+Scheduler::Event
+QuadHeapScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Event ev;
+  ev.impl = m_impls[ROOT];
+  ev.key = m_keys[ROOT];
+  return ev;
+}
+
+Scheduler::Event
+QuadHeapScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Event ev;
+  ev.impl = m_impls[ROOT];
+  ev.key = m_keys[ROOT];
+  m_end--;
+  if (m_end != ROOT)
+    {
+      SiftDown (ROOT, m_keys[m_end], m_impls[m_end]);
+    }
+  return ev;
+}
+
+void
+QuadHeapScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint32_t uid = ev.key.m_uid;
+  for (uint32_t i = ROOT; i < m_end; i++)
+    {
+      if (m_keys[i].m_uid == uid)
+        {
+          NS_ASSERT (m_impls[i] == ev.impl);
+          m_end--;
+          if (i == m_end)
+            {
+              return;
+            }
+          // Fill the hole with the last event, which may belong above or below it
+          EventKey key = m_keys[m_end];
+          EventImpl *impl = m_impls[m_end];
+          if (i != ROOT && key < m_keys[Parent (i)])
+            {
+              SiftUp (i, key, impl);
+            }
+          else
+            {
+              SiftDown (i, key, impl);
+            }
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+} // namespace ns3
@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUAD_HEAP_SCHEDULER_H
+#define QUAD_HEAP_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::QuadHeapScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a cache-aligned 4-ary heap event scheduler
+ *
+ * An implicit heap in which every node has four children, laid out so that
+ * the four children of a node share one cache line:
+ *  - the keys of the events (time stamp, uid and context, 16 bytes) are kept
+ *    in their own array, aligned on 64 bytes, and the event implementations
+ *    in a parallel array: sifting an event down only reads the keys of the
+ *    children, one cache line per level;
+ *  - the root is stored at index 3, so that the children of the node at
+ *    index i are at indexes 4i-8 to 4i-5, the first of which is a multiple
+ *    of 4;
+ *  - events are moved into a hole rather than swapped.
+ *
+ * The heap is half as deep as a binary heap, which makes RemoveNext, the
+ * dominant operation, cheaper. Events with the same time stamp are ordered by
+ * uid like in the other schedulers. Remove is a linear search over the keys.
+ */
+class QuadHeapScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  QuadHeapScheduler ();
+  /** Destructor. */
+  virtual ~QuadHeapScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Index of the root. */
+  static const uint32_t ROOT = 3;
+
+  /**
+   * Get the parent index of a given entry.
+   *
+   * \param [in] index The child index.
+   * \return The index of the parent of \p index.
+   */
+  static inline uint32_t Parent (uint32_t index);
+  /**
+   * Get the first child of a given entry.
+   *
+   * \param [in] index The parent index.
+   * \returns The index of the first of the four children.
+   */
+  static inline uint32_t FirstChild (uint32_t index);
+  /** Double the capacity of the arrays. */
+  void Grow (void);
+  /**
+   * Move the hole at an index up until an event fits in it.
+   *
+   * \param [in] index The index of the hole.
+   * \param [in] key The key of the event to store.
+   * \param [in] impl The implementation of the event to store.
+   */
+  void SiftUp (uint32_t index, const EventKey &key, EventImpl *impl);
+  /**
+   * Move the hole at an index down until an event fits in it.
+   *
+   * \param [in] index The index of the hole.
+   * \param [in] key The key of the event to store.
+   * \param [in] impl The implementation of the event to store.
+   */
+  void SiftDown (uint32_t index, const EventKey &key, EventImpl *impl);
+
+  char *m_buffer;          //!< Storage of m_keys, with room for its alignment
+  EventKey *m_keys;        //!< Keys of the events
+  EventImpl **m_impls;     //!< Implementations of the events
+  uint32_t m_end;          //!< One past the index of the last event
+  uint32_t m_capacity;     //!< Size of the arrays
+};
+
+} // namespace ns3
+
+#endif /* QUAD_HEAP_SCHEDULER_H */
@@ -34,6 +34,7 @@
 
 
 #include <cmath>
+#include <algorithm>
 
 
 /**
@@ -90,6 +91,7 @@ RealtimeSimulatorImpl::RealtimeSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
+  m_eventCount = 0;
 
   m_main = SystemThread::Self();
 
@@ -107,6 +109,7 @@ void
 RealtimeSimulatorImpl::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  ProcessEventsWithContext ();
   while (!m_events->IsEmpty ())
     {
       Scheduler::Event next = m_events->RemoveNext ();
@@ -208,6 +211,16 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
 
       { 
         CriticalSection cs (m_mutex);
+        //
+        // This resets the synchronizer so that any future event will cause it
+        // to interrupt.  It has to be done before we look at the events scheduled
+        // from other threads, since those do not take the critical section: an
+        // event pushed after we have looked will do a synchronizer Signal() after
+        // this reset.
+        //
+        m_synchronizer->SetCondition (false);
+        ProcessEventsWithContext ();
+
         //
         // Since we are in realtime mode, the time to delay has got to be the 
         // difference between the current realtime and the timestamp of the next 
@@ -249,14 +262,6 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
             tsDelay = tsNext - tsNow;
           }
 
-        //
-        // We've figured out how long we need to delay in order to pace the 
-        // simulation time with the real time.  We're going to sleep, but need
-        // to work with the synchronizer to make sure we're awakened if something 
-        // external happens (like a packet is received).  This next line resets
-        // the synchronizer so that any future event will cause it to interrupt.
-        //
-        m_synchronizer->SetCondition (false);
       }
 
       //
@@ -320,6 +325,12 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
   { 
     CriticalSection cs (m_mutex);
 
+    //
+    // An event scheduled from another thread since we last looked may be due
+    // before the one we waited for.
+    //
+    ProcessEventsWithContext ();
+
     // 
     // We do know we're waiting for an event, so there had better be an event on the 
     // event queue.  Let's pull it off.  When we release the critical section, the
@@ -349,6 +360,7 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
     m_currentTs = next.key.m_ts;
     m_currentContext = next.key.m_context;
     m_currentUid = next.key.m_uid;
+    m_eventCount++;
 
     // 
     // We're about to run the event and we've done our best to synchronize this
@@ -399,12 +411,38 @@ RealtimeSimulatorImpl::IsFinished (void) const
   bool rc;
   {
     CriticalSection cs (m_mutex);
-    rc = m_events->IsEmpty () || m_stop;
+    rc = (m_events->IsEmpty () && m_eventsWithContext.IsEmpty ()) || m_stop;
   }
 
   return rc;
 }
 
+void
+RealtimeSimulatorImpl::ProcessEventsWithContext (void)
+{
+  if (m_eventsWithContext.IsEmpty ())
+    {
+      return;
+    }
+
+  EventWithContext event;
+  while (m_eventsWithContext.Pop (event))
+    {
+      //
+      // The timestamp was taken from the realtime clock when the event was
+      // pushed; an event executed since then may have moved m_currentTs past it.
+      //
+      Scheduler::Event ev;
+      ev.impl = event.event;
+      ev.key.m_ts = std::max (event.timestamp, m_currentTs);
+      ev.key.m_context = event.context;
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_unscheduledEvents++;
+      m_events->Insert (ev);
+    }
+}
+
 //
 // Peeks into event list.  Should be called with critical section locked.
 //
@@ -442,6 +480,7 @@ RealtimeSimulatorImpl::Run (void)
       {
         CriticalSection cs (m_mutex);
 
+        ProcessEventsWithContext ();
         if (!m_events->IsEmpty ())
           {
             process = true;
@@ -543,23 +582,30 @@ RealtimeSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
 {
   NS_LOG_FUNCTION (this << context << delay << impl);
 
+  if (!SystemThread::Equals (m_main) && m_running)
+    {
+      //
+      // We're pacing and have a meaningful realtime clock, which does not
+      // need the critical section.  The event is queued without locking and
+      // the main thread moves it to the event list when it next looks at it.
+      //
+      EventWithContext ev;
+      ev.context = context;
+      ev.timestamp = m_synchronizer->GetCurrentRealtime () + delay.GetTimeStep ();
+      ev.event = impl;
+      m_eventsWithContext.Push (ev);
+      m_synchronizer->Signal ();
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
-    uint64_t ts;
 
-    if (SystemThread::Equals (m_main))
-      {
-        ts = m_currentTs + delay.GetTimeStep ();
-      }
-    else
-      {
-        //
-        // If the simulator is running, we're pacing and have a meaningful 
-        // realtime clock.  If we're not, then m_currentTs is where we stopped.
-        // 
-        ts = m_running ? m_synchronizer->GetCurrentRealtime () : m_currentTs;
-        ts += delay.GetTimeStep ();
-      }
+    //
+    // Either we're in the main thread, or the simulator is not running and
+    // m_currentTs is where we stopped.
+    //
+    uint64_t ts = m_currentTs + delay.GetTimeStep ();
 
     NS_ASSERT_MSG (ts >= m_currentTs, "RealtimeSimulatorImpl::ScheduleRealtime(): schedule for time < m_currentTs");
     Scheduler::Event ev;
@@ -820,6 +866,12 @@ RealtimeSimulatorImpl::GetContext (void) const
   return m_currentContext;
 }
 
+uint64_t
+RealtimeSimulatorImpl::GetEventCount (void) const
+{
+  return m_eventCount;
+}
+
 void 
 RealtimeSimulatorImpl::SetSynchronizationMode (enum SynchronizationMode mode)
 {
@@ -30,7 +30,9 @@
 #include "assert.h"
 #include "log.h"
 #include "system-mutex.h"
+#include "mpsc-queue.h"
 
+#include <atomic>
 #include <list>
 
 /**
@@ -107,6 +109,7 @@ public:
   virtual void SetScheduler (ObjectFactory schedulerFactory);
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
+  virtual uint64_t GetEventCount (void) const;
 
   /** \copydoc ScheduleWithContext(uint32_t,const Time&,EventImpl*) */
   void ScheduleRealtimeWithContext (uint32_t context, const Time &delay, EventImpl *event);
@@ -172,6 +175,11 @@ private:
   uint64_t NextTs (void) const;
   /** Process the next event. */
   void ProcessOneEvent (void);
+  /**
+   * Move events scheduled from other threads into the event list.
+   * Should be called with #m_mutex locked.
+   */
+  void ProcessEventsWithContext (void);
   /** Destructor implementation. */
   virtual void DoDispose (void);
 
@@ -181,8 +189,11 @@ private:
   DestroyEvents m_destroyEvents;
   /** Has the stopping condition been reached? */
   bool m_stop;
-  /** Is the simulator currently running. */
-  bool m_running;
+  /**
+   * Is the simulator currently running.
+   * Atomic, as ScheduleWithContext reads it from other threads without the lock.
+   */
+  std::atomic<bool> m_running;
 
   /**
    * \name Mutex-protected variables.
@@ -194,6 +205,8 @@ private:
   Ptr<Scheduler> m_events;
   /**< Number of events in the event list. */
   int m_unscheduledEvents;
+  /** The number of events executed. */
+  uint64_t m_eventCount;
   /**< Unique id for the next event to be scheduled. */
   uint32_t m_uid;
   /**< Unique id of the current event. */
@@ -207,6 +220,22 @@ private:
   /** Mutex to control access to key state. */  
   mutable SystemMutex m_mutex;  
 
+  /** Wrap an event scheduled from another thread with its context. */
+  struct EventWithContext {
+    /** The event context. */
+    uint32_t context;
+    /** The realtime timestamp at which the event is due. */
+    uint64_t timestamp;
+    /** The event implementation. */
+    EventImpl *event;
+  };
+  /**
+   * The events scheduled while running from threads other than the main
+   * one: they are pushed without taking #m_mutex, then moved to the event
+   * list by the main thread.
+   */
+  MpscQueue<struct EventWithContext> m_eventsWithContext;
+
   /** The synchronizer in use to track real time. */
   Ptr<Synchronizer> m_synchronizer;
 
@@ -22,6 +22,7 @@
 #include "attribute-helper.h"
 #include "integer.h"
 #include "config.h"
+#include "isolated-simulation.h"
 #include "log.h"
 
 /**
@@ -34,12 +35,23 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("RngSeedManager");
 
+namespace {
+
 /**
  * \relates RngSeedManager
  * The next random number generator stream number to use
- * for automatic assignment.
+ * for automatic assignment, of the process or of an IsolatedSimulation.
  */
-static uint64_t g_nextStreamIndex = 0;
+struct NextStreamIndex : public IsolatedSingleton<NextStreamIndex>
+{
+  NextStreamIndex ()
+    : index (0)
+  {}
+  uint64_t index; //!< The next stream number
+};
+
+} // unnamed namespace
+
 /**
  * \relates RngSeedManager
  * The random number generator seed number global value.  This is used to
@@ -100,9 +112,8 @@ uint64_t RngSeedManager::GetRun ()
 uint64_t RngSeedManager::GetNextStreamIndex (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  uint64_t next = g_nextStreamIndex;
-  g_nextStreamIndex++;
-  return next;
+  NextStreamIndex *next = NextStreamIndex::Get ();
+  return next->index++;
 }
 
 } // namespace ns3
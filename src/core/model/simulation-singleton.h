@@ -36,6 +36,8 @@ namespace ns3 {
  * type will be automatically deleted upon a call
  * to Simulator::Destroy.
  *
+ * A thread running an IsolatedSimulation has instances of its own.
+ *
  * For a singleton with a lifetime bounded by the process,
  * not the simulation run, see Singleton.
  */
@@ -99,6 +101,7 @@ private:
  ********************************************************************/
 
 #include "simulator.h"
+#include "isolated-simulation.h"
 
 namespace ns3 {
 
@@ -115,12 +118,14 @@ T **
 SimulationSingleton<T>::GetObject (void)
 {
   static T *pobject = 0;
-  if (pobject == 0)
+  static thread_local T *isolatedObject = 0;
+  T **ppobject = IsolatedSimulation::IsActive () ? &isolatedObject : &pobject;
+  if (*ppobject == 0)
     {
-      pobject = new T ();
+      *ppobject = new T ();
       Simulator::ScheduleDestroy (&SimulationSingleton<T>::DeleteObject);
     }
-  return &pobject;
+  return ppobject;
 }
 
 template <typename T>
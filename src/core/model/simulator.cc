@@ -28,6 +28,7 @@
 #include "string.h"
 #include "object-factory.h"
 #include "global-value.h"
+#include "isolated-simulation.h"
 #include "assert.h"
 #include "log.h"
 
@@ -109,11 +110,19 @@ NodePrinter (std::ostream &os)
 /**
  * \ingroup simulator
  * \brief Get the static SimulatorImpl instance.
+ *
+ * A thread running an IsolatedSimulation has an instance of its own.
+ *
  * \return The SimulatorImpl instance pointer.
  */
 static SimulatorImpl **PeekImpl (void)
 {
   static SimulatorImpl *impl = 0;
+  if (IsolatedSimulation::IsActive ())
+    {
+      static thread_local SimulatorImpl *isolatedImpl = 0;
+      return &isolatedImpl;
+    }
   return &impl;
 }
 
@@ -154,8 +163,14 @@ static SimulatorImpl * GetImpl (void)
 // Simulator::Now which would call Simulator::GetImpl, and, thus, get us 
 // in an infinite recursion until the stack explodes.
 //
-      LogSetTimePrinter (&TimePrinter);
-      LogSetNodePrinter (&NodePrinter);
+// The printers are shared by the threads of the process: an isolated
+// simulation leaves them alone.
+//
+      if (!IsolatedSimulation::IsActive ())
+        {
+          LogSetTimePrinter (&TimePrinter);
+          LogSetNodePrinter (&NodePrinter);
+        }
     }
   return *pimpl;
 }
@@ -175,8 +190,11 @@ Simulator::Destroy (void)
    * legal), Simulator::GetImpl will trigger again an infinite recursion until
    * the stack explodes.
    */
-  LogSetTimePrinter (0);
-  LogSetNodePrinter (0);
+  if (!IsolatedSimulation::IsActive ())
+    {
+      LogSetTimePrinter (0);
+      LogSetNodePrinter (0);
+    }
   (*pimpl)->Destroy ();
   (*pimpl)->Unref ();
   *pimpl = 0;
@@ -345,6 +363,12 @@ Simulator::GetContext (void)
   return GetImpl ()->GetContext ();
 }
 
+uint64_t
+Simulator::GetEventCount (void)
+{
+  return GetImpl ()->GetEventCount ();
+}
+
 uint32_t
 Simulator::GetSystemId (void)
 {
@@ -382,8 +406,11 @@ Simulator::SetImplementation (Ptr<SimulatorImpl> impl)
 // Simulator::Now which would call Simulator::GetImpl, and, thus, get us 
 // in an infinite recursion until the stack explodes.
 //
-  LogSetTimePrinter (&TimePrinter);
-  LogSetNodePrinter (&NodePrinter);
+  if (!IsolatedSimulation::IsActive ())
+    {
+      LogSetTimePrinter (&TimePrinter);
+      LogSetNodePrinter (&NodePrinter);
+    }
 }
 
 Ptr<SimulatorImpl>
@@ -1182,6 +1182,16 @@ public:
    * @return The system id for this simulator.
    */
   static uint32_t GetSystemId (void);
+
+  /**
+   * Get the number of events processed so far.
+   *
+   * Cancelled events are counted too, they are taken from the event
+   * list like the others. Benchmarks divide it by the wall clock time
+   * to get the event rate.
+   * @return The total number of events processed.
+   */
+  static uint64_t GetEventCount (void);
   
 private:
   /** Default constructor. */
@@ -0,0 +1,141 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "small-object-pool.h"
+#include <new>
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup core
+ * Implementation of ns3::SmallObjectPool class.
+ */
+
+namespace ns3 {
+
+namespace {
+
+/** Granularity of the block sizes. */
+const std::size_t GRANULARITY = 16;
+/** Number of free lists, for blocks of up to GRANULARITY * N_LISTS bytes. */
+const std::size_t N_LISTS = 8;
+/** Maximum number of blocks kept on a free list. */
+const uint32_t MAX_FREE = 4096;
+
+/** A block on a free list. */
+struct FreeBlock
+{
+  FreeBlock *next;  //!< The next free block
+};
+
+/**
+ * The free lists of a thread. Trivially destructible, so that it can be
+ * used until the thread is gone.
+ */
+struct FreeLists
+{
+  FreeBlock *head[N_LISTS];   //!< The first free block of each size
+  uint32_t count[N_LISTS];    //!< The number of free blocks of each size
+  bool registered;            //!< Has the reaper of the thread been set up
+  bool released;              //!< Has the reaper run
+};
+
+/** The free lists of the current thread. */
+thread_local FreeLists g_freeLists;
+
+/** Releases the free lists of a thread when it exits. */
+struct FreeListsReaper
+{
+  ~FreeListsReaper ()
+  {
+    for (std::size_t i = 0; i < N_LISTS; ++i)
+      {
+        while (g_freeLists.head[i] != 0)
+          {
+            FreeBlock *block = g_freeLists.head[i];
+            g_freeLists.head[i] = block->next;
+            ::operator delete (block);
+          }
+        g_freeLists.count[i] = 0;
+      }
+    // The blocks released from now on go back to the heap
+    g_freeLists.released = true;
+  }
+};
+
+/** The reaper of the current thread, constructed with its first free block. */
+thread_local FreeListsReaper g_freeListsReaper;
+
+/**
+ * Get the free list of a size.
+ * \param [in] size The size of a block.
+ * \return The index of the free list, N_LISTS and more if too large.
+ */
+inline std::size_t
+GetList (std::size_t size)
+{
+  return (size + GRANULARITY - 1) / GRANULARITY - 1;
+}
+
+} // unnamed namespace
+
+void *
+SmallObjectPool::Allocate (std::size_t size)
+{
+  std::size_t list = GetList (size);
+  if (list >= N_LISTS)
+    {
+      return ::operator new (size);
+    }
+  FreeBlock *block = g_freeLists.head[list];
+  if (block == 0)
+    {
+      return ::operator new ((list + 1) * GRANULARITY);
+    }
+  g_freeLists.head[list] = block->next;
+  g_freeLists.count[list]--;
+  return block;
+}
+
+void
+SmallObjectPool::Deallocate (void *p, std::size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  std::size_t list = GetList (size);
+  if (list >= N_LISTS
+      || g_freeLists.count[list] >= MAX_FREE
+      || g_freeLists.released)
+    {
+      ::operator delete (p);
+      return;
+    }
+  if (!g_freeLists.registered)
+    {
+      // Odr-use the reaper so that it is constructed, and destroyed when
+      // the thread exits
+      (void)&g_freeListsReaper;
+      g_freeLists.registered = true;
+    }
+  FreeBlock *block = static_cast<FreeBlock *> (p);
+  block->next = g_freeLists.head[list];
+  g_freeLists.head[list] = block;
+  g_freeLists.count[list]++;
+}
+
+} // namespace ns3
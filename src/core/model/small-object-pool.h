@@ -0,0 +1,71 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SMALL_OBJECT_POOL_H
+#define SMALL_OBJECT_POOL_H
+
+#include <cstddef>
+
+/**
+ * \file
+ * \ingroup core
+ * Declaration of ns3::SmallObjectPool class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ * \brief Per-thread free lists for small, short-lived objects.
+ *
+ * The events and the callback implementations are allocated and released
+ * at a high rate, with a handful of sizes. Classes which define their
+ * operator new and operator delete with Allocate and Deallocate reuse the
+ * blocks released by the same thread instead of going to the heap:
+ *  - the sizes are rounded up to a multiple of 16 bytes, each size up to
+ *    128 bytes having its own free list; larger blocks use the heap;
+ *  - the free lists are thread local, so that a block may be released by
+ *    another thread than the one which allocated it, as is the case of the
+ *    events scheduled with a context from another thread;
+ *  - each list keeps at most 4096 blocks, and the lists of a thread are
+ *    released when it exits.
+ *
+ * Deallocate must be given the size the block was allocated with: with a
+ * virtual destructor, the sized operator delete of the class receives the
+ * size of the dynamic type.
+ */
+class SmallObjectPool
+{
+public:
+  /**
+   * Allocate a block.
+   *
+   * \param [in] size The size of the block.
+   * \return The block.
+   */
+  static void * Allocate (std::size_t size);
+  /**
+   * Release a block.
+   *
+   * \param [in] p The block, returned by Allocate.
+   * \param [in] size The size the block was allocated with.
+   */
+  static void Deallocate (void *p, std::size_t size);
+};
+
+} // namespace ns3
+
+#endif /* SMALL_OBJECT_POOL_H */
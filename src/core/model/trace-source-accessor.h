@@ -21,6 +21,7 @@
 #define TRACE_SOURCE_ACCESSOR_H
 
 #include <stdint.h>
+#include <atomic>
 #include "callback.h"
 #include "ptr.h"
 #include "simple-ref-count.h"
@@ -43,7 +44,9 @@ class ObjectBase;
  * This class abstracts the kind of trace source to which we want to connect
  * and provides services to Connect and Disconnect a sink to a trace source.
  */
-class TraceSourceAccessor : public SimpleRefCount<TraceSourceAccessor>
+class TraceSourceAccessor : public SimpleRefCount<TraceSourceAccessor, empty,
+                                                  DefaultDeleter<TraceSourceAccessor>,
+                                                  std::atomic<uint32_t> >
 {
 public:
   /** Constructor. */
@@ -21,6 +21,8 @@
 #include "hash.h"
 #include "type-id.h"
 #include "singleton.h"
+#include "isolated-simulation.h"
+#include "system-mutex.h"
 #include "trace-source-accessor.h"
 
 #include <map>
@@ -50,8 +52,14 @@ NS_LOG_COMPONENT_DEFINE ("TypeId");
  * \ingroup object
  * \brief TypeId information manager
  *
- * Information records are stored in a vector.  Name and hash lookup
- * are performed by maps to the vector index.
+ * Information records are stored in chunks allocated as needed, so that
+ * they never move.  Name and hash lookup are performed by maps to the
+ * record index.
+ *
+ * The records are shared by the threads of the process, which read them
+ * without locking: the registration and the lookups by name or hash are
+ * serialized by the registry mutex, and the attribute initial values set
+ * by an IsolatedSimulation are kept apart, see IsolatedInitialValues.
  *
  * \internal
  * <b>Hash Chaining</b>
@@ -78,6 +86,10 @@ NS_LOG_COMPONENT_DEFINE ("TypeId");
 class IidManager : public Singleton<IidManager>
 {
 public:
+  /** Constructor. */
+  IidManager ();
+  /** Destructor. */
+  ~IidManager ();
   /**
    * Create a new unique type id.
    * \param [in] name The name of this type id.
@@ -308,9 +320,6 @@ private:
     /** The container of TraceSources. */
     std::vector<struct TypeId::TraceSourceInformation> traceSources;
   };
-  /** Iterator type. */
-  typedef std::vector<struct IidInformation>::const_iterator Iterator;
-
   /**
    * Retrieve the information record for a type.
    * \param [in] uid The id.
@@ -318,8 +327,12 @@ private:
    */
   struct IidManager::IidInformation *LookupInformation (uint16_t uid) const;
 
-  /** The container of all type id records. */
-  std::vector<struct IidInformation> m_information;
+  /** The number of records of a chunk. */
+  static const uint32_t CHUNK_SIZE = 256;
+  /** The chunks of type id records, by index / CHUNK_SIZE. */
+  struct IidInformation *m_chunks[0x10000 / CHUNK_SIZE];
+  /** The number of type id records. */
+  uint32_t m_n;
 
   /** Type of the by-name index. */
   typedef std::map<std::string, uint16_t> namemap_t;
@@ -345,6 +358,53 @@ private:
 };
 
 
+namespace {
+
+/**
+ * \ingroup object
+ * The mutex serializing the registration of the type ids and the lookups
+ * by name or hash.
+ * \returns The mutex.
+ */
+SystemMutex &
+GetRegistryMutex (void)
+{
+  static SystemMutex mutex;
+  return mutex;
+}
+
+/**
+ * \ingroup object
+ * The attribute initial values set by an IsolatedSimulation, which it
+ * sees instead of the ones of the process.
+ */
+struct IsolatedInitialValues : public IsolatedSingleton<IsolatedInitialValues>
+{
+  /** Type of the map from the (type id, attribute index) to the value. */
+  typedef std::map<std::pair<uint16_t, uint32_t>, Ptr<const AttributeValue> > Map;
+  /** The values. */
+  Map values;
+};
+
+} // unnamed namespace
+
+IidManager::IidManager ()
+  : m_n (0)
+{
+  for (uint32_t i = 0; i < 0x10000 / CHUNK_SIZE; ++i)
+    {
+      m_chunks[i] = 0;
+    }
+}
+
+IidManager::~IidManager ()
+{
+  for (uint32_t i = 0; i < 0x10000 / CHUNK_SIZE; ++i)
+    {
+      delete [] m_chunks[i];
+    }
+}
+
 //static
 TypeId::hash_t
 IidManager::Hasher (const std::string name)
@@ -414,9 +474,15 @@ IidManager::AllocateUid (std::string name)
   information.size = (std::size_t)(-1);
   information.hasConstructor = false;
   information.mustHideFromDocumentation = false;
-  m_information.push_back (information);
-  uint32_t uid = m_information.size ();
+  uint32_t uid = m_n + 1;
   NS_ASSERT (uid <= 0xffff);
+  struct IidInformation *&chunk = m_chunks[(uid - 1) / CHUNK_SIZE];
+  if (chunk == 0)
+    {
+      chunk = new struct IidInformation [CHUNK_SIZE];
+    }
+  chunk[(uid - 1) % CHUNK_SIZE] = information;
+  m_n = uid;
 
   // Add to both maps:
   m_namemap.insert (std::make_pair (name, uid));
@@ -428,15 +494,15 @@ struct IidManager::IidInformation *
 IidManager::LookupInformation (uint16_t uid) const
 {
   NS_LOG_FUNCTION (this << uid);
-  NS_ASSERT (uid <= m_information.size () && uid != 0);
-  return const_cast<struct IidInformation *> (&m_information[uid-1]);
+  NS_ASSERT (uid <= m_n && uid != 0);
+  return &m_chunks[(uid - 1) / CHUNK_SIZE][(uid - 1) % CHUNK_SIZE];
 }
 
 void 
 IidManager::SetParent (uint16_t uid, uint16_t parent)
 {
   NS_LOG_FUNCTION (this << uid << parent);
-  NS_ASSERT (parent <= m_information.size ());
+  NS_ASSERT (parent <= m_n);
   struct IidInformation *information = LookupInformation (uid);
   information->parent = parent;
 }
@@ -562,7 +628,7 @@ uint32_t
 IidManager::GetRegisteredN (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_information.size ();
+  return m_n;
 }
 uint16_t 
 IidManager::GetRegistered (uint32_t i) const
@@ -633,6 +699,11 @@ IidManager::SetAttributeInitialValue(uint16_t uid,
   NS_LOG_FUNCTION (this << uid << i << initialValue);
   struct IidInformation *information = LookupInformation (uid);
   NS_ASSERT (i < information->attributes.size ());
+  if (IsolatedSimulation::IsActive ())
+    {
+      IsolatedInitialValues::Get ()->values[std::make_pair (uid, i)] = initialValue;
+      return;
+    }
   information->attributes[i].initialValue = initialValue;
 }
 
@@ -651,7 +722,17 @@ IidManager::GetAttribute(uint16_t uid, uint32_t i) const
   NS_LOG_FUNCTION (this << uid << i);
   struct IidInformation *information = LookupInformation (uid);
   NS_ASSERT (i < information->attributes.size ());
-  return information->attributes[i];
+  struct TypeId::AttributeInformation info = information->attributes[i];
+  if (IsolatedSimulation::IsActive ())
+    {
+      const IsolatedInitialValues::Map &values = IsolatedInitialValues::Get ()->values;
+      IsolatedInitialValues::Map::const_iterator j = values.find (std::make_pair (uid, i));
+      if (j != values.end ())
+        {
+          info.initialValue = j->second;
+        }
+    }
+  return info;
 }
 
 bool
@@ -737,6 +818,7 @@ namespace ns3 {
 TypeId::TypeId (const char *name)
 {
   NS_LOG_FUNCTION (this << name);
+  CriticalSection critical (GetRegistryMutex ());
   uint16_t uid = IidManager::Get ()->AllocateUid (name);
   NS_ASSERT (uid != 0);
   m_tid = uid;
@@ -752,7 +834,11 @@ TypeId
 TypeId::LookupByName (std::string name)
 {
   NS_LOG_FUNCTION (name);
-  uint16_t uid = IidManager::Get ()->GetUid (name);
+  uint16_t uid;
+  {
+    CriticalSection critical (GetRegistryMutex ());
+    uid = IidManager::Get ()->GetUid (name);
+  }
   NS_ASSERT_MSG (uid != 0, "Assert in TypeId::LookupByName: " << name << " not found");
   return TypeId (uid);
 }
@@ -760,7 +846,11 @@ bool
 TypeId::LookupByNameFailSafe (std::string name, TypeId *tid)
 {
   NS_LOG_FUNCTION (name << tid);
-  uint16_t uid = IidManager::Get ()->GetUid (name);
+  uint16_t uid;
+  {
+    CriticalSection critical (GetRegistryMutex ());
+    uid = IidManager::Get ()->GetUid (name);
+  }
   if (uid == 0)
     {
       return false;
@@ -771,7 +861,11 @@ TypeId::LookupByNameFailSafe (std::string name, TypeId *tid)
 TypeId
 TypeId::LookupByHash (hash_t hash)
 {
-  uint16_t uid = IidManager::Get ()->GetUid (hash);
+  uint16_t uid;
+  {
+    CriticalSection critical (GetRegistryMutex ());
+    uid = IidManager::Get ()->GetUid (hash);
+  }
   NS_ASSERT_MSG (uid != 0, "Assert in TypeId::LookupByHash: 0x"
                  << std::hex << hash << std::dec << " not found");
   return TypeId (uid);
@@ -779,7 +873,11 @@ TypeId::LookupByHash (hash_t hash)
 bool
 TypeId::LookupByHashFailSafe (hash_t hash, TypeId *tid)
 {
-  uint16_t uid = IidManager::Get ()->GetUid (hash);
+  uint16_t uid;
+  {
+    CriticalSection critical (GetRegistryMutex ());
+    uid = IidManager::Get ()->GetUid (hash);
+  }
   if (uid == 0)
     {
       return false;
@@ -922,6 +1020,7 @@ TypeId::AddAttribute (std::string name,
                       Ptr<const AttributeChecker> checker)
 {
   NS_LOG_FUNCTION (this << name << help << &initialValue << accessor << checker);
+  CriticalSection critical (GetRegistryMutex ());
   IidManager::Get ()->AddAttribute (m_tid, name, help, ATTR_SGC, initialValue.Copy (), accessor, checker);
   return *this;
 }
@@ -935,6 +1034,7 @@ TypeId::AddAttribute (std::string name,
                       Ptr<const AttributeChecker> checker)
 {
   NS_LOG_FUNCTION (this << name << help << flags << &initialValue << accessor << checker);
+  CriticalSection critical (GetRegistryMutex ());
   IidManager::Get ()->AddAttribute (m_tid, name, help, flags, initialValue.Copy (), accessor, checker);
   return *this;
 }
@@ -1014,6 +1114,7 @@ TypeId::AddTraceSource (std::string name,
                         std::string callback)
 {
   NS_LOG_FUNCTION (this << name << help << accessor);
+  CriticalSection critical (GetRegistryMutex ());
   IidManager::Get ()->AddTraceSource (m_tid, name, help, accessor, callback);
   return *this;
 }
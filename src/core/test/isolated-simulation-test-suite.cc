@@ -0,0 +1,221 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/isolated-simulation.h"
+#include "ns3/sweep-runner.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/global-value.h"
+#include "ns3/names.h"
+#include "ns3/double.h"
+#include "ns3/integer.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/system-thread.h"
+
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * Check that the state changed by an isolated simulation is not seen
+ * by the rest of the process.
+ */
+class IsolatedSimulationStateTestCase : public TestCase
+{
+public:
+  IsolatedSimulationStateTestCase ();
+private:
+  virtual void DoRun (void);
+  /** Run a simulation in an isolated thread. */
+  void Isolated (void);
+  /** Record the time of the event of the isolated simulation. */
+  void Event (void);
+
+  int64_t m_run;       //!< RngRun seen by the isolated thread
+  double m_max;        //!< UniformRandomVariable::Max seen by the isolated thread
+  bool m_named;        //!< Did the isolated thread find its name
+  uint64_t m_stream;   //!< First stream index of the isolated thread
+  Time m_eventTime;    //!< Time of the event of the isolated thread
+  Time m_end;          //!< Time at the end of the isolated simulation
+};
+
+IsolatedSimulationStateTestCase::IsolatedSimulationStateTestCase ()
+  : TestCase ("Check that an isolated simulation keeps its state to itself"),
+    m_run (0),
+    m_max (0),
+    m_named (false),
+    m_stream (1)
+{
+}
+
+void
+IsolatedSimulationStateTestCase::Event (void)
+{
+  m_eventTime = Simulator::Now ();
+}
+
+void
+IsolatedSimulationStateTestCase::Isolated (void)
+{
+  IsolatedSimulation isolation;
+  m_stream = RngSeedManager::GetNextStreamIndex ();
+  Config::SetGlobal ("RngRun", IntegerValue (7));
+  Config::SetDefault ("ns3::UniformRandomVariable::Max", DoubleValue (5.0));
+  IntegerValue run;
+  GlobalValue::GetValueByName ("RngRun", run);
+  m_run = run.Get ();
+  m_max = CreateObject<UniformRandomVariable> ()->GetMax ();
+  Names::Add ("isolated", CreateObject<UniformRandomVariable> ());
+  m_named = Names::Find<UniformRandomVariable> ("isolated") != 0;
+  Simulator::Schedule (Seconds (10), &IsolatedSimulationStateTestCase::Event, this);
+  Simulator::Run ();
+  m_end = Simulator::Now ();
+}
+
+void
+IsolatedSimulationStateTestCase::DoRun (void)
+{
+  Time now = Simulator::Now ();
+  IntegerValue run;
+  GlobalValue::GetValueByName ("RngRun", run);
+  int64_t processRun = run.Get ();
+
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&IsolatedSimulationStateTestCase::Isolated, this));
+  thread->Start ();
+  thread->Join ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_run, 7, "RngRun not set in the isolated simulation");
+  NS_TEST_EXPECT_MSG_EQ (m_max, 5.0, "Default not set in the isolated simulation");
+  NS_TEST_EXPECT_MSG_EQ (m_named, true, "Name not found in the isolated simulation");
+  NS_TEST_EXPECT_MSG_EQ (m_stream, 0u, "Stream indices of an isolated simulation start from 0");
+  NS_TEST_EXPECT_MSG_EQ (m_eventTime, Seconds (10), "Event not run by the isolated simulation");
+  NS_TEST_EXPECT_MSG_EQ (m_end, Seconds (10), "Isolated simulation did not end with its event");
+
+  GlobalValue::GetValueByName ("RngRun", run);
+  NS_TEST_EXPECT_MSG_EQ (run.Get (), processRun, "RngRun of the process changed");
+  NS_TEST_EXPECT_MSG_EQ (CreateObject<UniformRandomVariable> ()->GetMax (), 1.0,
+                         "Default of the process changed");
+  NS_TEST_EXPECT_MSG_EQ ((Names::Find<UniformRandomVariable> ("isolated") == 0), true,
+                         "Name of the isolated simulation seen by the process");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), now, "Simulator of the process changed");
+}
+
+/**
+ * Check that the results of a sweep do not depend on the number of threads
+ * executing it.
+ */
+class SweepRunnerTestCase : public TestCase
+{
+public:
+  SweepRunnerTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Draw random numbers in scheduled events.
+   * \param [in] run The RngRun of the simulation.
+   */
+  static void Draws (uint32_t run);
+  /**
+   * Draw a number and schedule the next draw.
+   * \param [in] variable The random variable.
+   * \param [in] left The number of draws left.
+   * \param [in] sum The sum of the previous draws.
+   */
+  static void Draw (Ptr<UniformRandomVariable> variable, uint32_t left, double sum);
+};
+
+SweepRunnerTestCase::SweepRunnerTestCase ()
+  : TestCase ("Check that a sweep gives the same results on any number of threads")
+{
+}
+
+void
+SweepRunnerTestCase::Draw (Ptr<UniformRandomVariable> variable, uint32_t left, double sum)
+{
+  sum += variable->GetValue ();
+  if (left > 1)
+    {
+      Simulator::Schedule (MilliSeconds (1), &SweepRunnerTestCase::Draw, variable, left - 1, sum);
+      return;
+    }
+  SweepRunner::Record ("sum", sum);
+  SweepRunner::Record ("time", Simulator::Now ().GetSeconds ());
+}
+
+void
+SweepRunnerTestCase::Draws (uint32_t run)
+{
+  RngSeedManager::SetRun (run);
+  Ptr<UniformRandomVariable> variable = CreateObject<UniformRandomVariable> ();
+  Simulator::Schedule (Seconds (1), &SweepRunnerTestCase::Draw, variable, 1000, 0.0);
+  Simulator::Run ();
+}
+
+void
+SweepRunnerTestCase::DoRun (void)
+{
+  const uint32_t runs = 16;
+  SweepRunner sequential;
+  SweepRunner parallel;
+  for (uint32_t run = 1; run <= runs; ++run)
+    {
+      sequential.AddRun (MakeBoundCallback (&SweepRunnerTestCase::Draws, run));
+      parallel.AddRun (MakeBoundCallback (&SweepRunnerTestCase::Draws, run));
+    }
+  NS_TEST_ASSERT_MSG_EQ (parallel.GetNRuns (), runs, "Runs not added");
+  sequential.Execute (1);
+  parallel.Execute (4);
+
+  for (uint32_t run = 0; run < runs; ++run)
+    {
+      double sum = 0;
+      double expected = 0;
+      double time = 0;
+      NS_TEST_ASSERT_MSG_EQ (sequential.GetResult (run, "sum", expected), true, "Result not recorded");
+      NS_TEST_ASSERT_MSG_EQ (parallel.GetResult (run, "sum", sum), true, "Result not recorded");
+      NS_TEST_EXPECT_MSG_EQ (sum, expected, "Result of run " << run << " depends on the threads");
+      NS_TEST_ASSERT_MSG_EQ (parallel.GetResult (run, "time", time), true, "Result not recorded");
+      NS_TEST_EXPECT_MSG_EQ_TOL (time, 1.999, 1e-9, "Simulation of run " << run << " not run to its end");
+      if (run > 0)
+        {
+          double previous = 0;
+          parallel.GetResult (run - 1, "sum", previous);
+          NS_TEST_EXPECT_MSG_NE (sum, previous, "Runs " << run - 1 << " and " << run << " drew the same numbers");
+        }
+    }
+
+  std::ostringstream sequentialOutput;
+  std::ostringstream parallelOutput;
+  sequential.Write (sequentialOutput);
+  parallel.Write (parallelOutput);
+  NS_TEST_EXPECT_MSG_EQ (parallelOutput.str (), sequentialOutput.str (), "Outputs differ");
+}
+
+/**
+ * The isolated simulation test suite.
+ */
+class IsolatedSimulationTestSuite : public TestSuite
+{
+public:
+  IsolatedSimulationTestSuite ()
+    : TestSuite ("isolated-simulation")
+  {
+    AddTestCase (new IsolatedSimulationStateTestCase (), TestCase::QUICK);
+    AddTestCase (new SweepRunnerTestCase (), TestCase::QUICK);
+  }
+} g_isolatedSimulationTestSuite;
@@ -21,8 +21,10 @@
 #include "ns3/simulator.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/heap-scheduler.h"
+#include "ns3/quad-heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -131,7 +133,10 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (!a.IsExpired (), true, "");
   Simulator::Cancel (a);
   NS_TEST_EXPECT_MSG_EQ (a.IsExpired (), true, "");
+  uint64_t eventCount = Simulator::GetEventCount ();
   Simulator::Run ();
+  // A was cancelled but is still taken from the list, B removes C and schedules D
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetEventCount () - eventCount, 3u, "Wrong number of events processed");
   NS_TEST_EXPECT_MSG_EQ (m_a, true, "Event A did not run ?");
   NS_TEST_EXPECT_MSG_EQ (m_b, true, "Event B did not run ?");
   NS_TEST_EXPECT_MSG_EQ (m_c, true, "Event C did not run ?");
@@ -459,6 +464,67 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Drives a scheduler directly with many events sharing few time stamps,
+ * removes some of them and checks that the others come out in (time stamp,
+ * uid) order.
+ */
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  ObjectFactory m_schedulerFactory;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the order of the events with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  std::vector<Scheduler::Event> events;
+  uint32_t seed = 1;
+  for (uint32_t uid = 1; uid <= 5000; ++uid)
+    {
+      seed = seed * 1103515245 + 12345;
+      Scheduler::Event ev;
+      // The scheduler never dereferences the implementation
+      ev.impl = reinterpret_cast<EventImpl *> (uintptr_t (uid));
+      ev.key.m_ts = (seed >> 16) % 200;
+      ev.key.m_uid = uid;
+      ev.key.m_context = 0;
+      scheduler->Insert (ev);
+      events.push_back (ev);
+    }
+  uint32_t removed = 0;
+  for (uint32_t i = 0; i < events.size (); i += 7)
+    {
+      scheduler->Remove (events[i]);
+      removed++;
+    }
+
+  uint32_t count = 0;
+  Scheduler::EventKey previous = { 0, 0, 0 };
+  while (!scheduler->IsEmpty ())
+    {
+      Scheduler::Event next = scheduler->PeekNext ();
+      Scheduler::Event ev = scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, next.key.m_uid, "PeekNext and RemoveNext differ");
+      NS_TEST_ASSERT_MSG_EQ (((ev.key.m_uid - 1) % 7 != 0), true, "Removed event returned");
+      NS_TEST_ASSERT_MSG_EQ (ev.impl, events[ev.key.m_uid - 1].impl, "Wrong event implementation");
+      NS_TEST_ASSERT_MSG_EQ ((previous < ev.key), true, "Events out of order");
+      previous = ev.key;
+      count++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (count + removed, events.size (), "Events lost");
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -473,7 +539,22 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (HeapScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (QuadHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    TypeId schedulers[] = {
+      ListScheduler::GetTypeId (),
+      MapScheduler::GetTypeId (),
+      HeapScheduler::GetTypeId (),
+      QuadHeapScheduler::GetTypeId (),
+      CalendarScheduler::GetTypeId ()
+    };
+    for (uint32_t i = 0; i < sizeof (schedulers) / sizeof (schedulers[0]); ++i)
+      {
+        factory.SetTypeId (schedulers[i]);
+        AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+      }
   }
 } g_simulatorTestSuite;
@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/small-object-pool.h"
+#include "ns3/make-event.h"
+#include "ns3/event-impl.h"
+#include "ns3/callback.h"
+
+using namespace ns3;
+
+/**
+ * Check that the blocks released to the pool are reused for the
+ * allocations of the same rounded size only.
+ */
+class SmallObjectPoolReuseTestCase : public TestCase
+{
+public:
+  SmallObjectPoolReuseTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+SmallObjectPoolReuseTestCase::SmallObjectPoolReuseTestCase ()
+  : TestCase ("Check the reuse of the blocks of each size")
+{
+}
+
+void
+SmallObjectPoolReuseTestCase::DoRun (void)
+{
+  void *p = SmallObjectPool::Allocate (40);
+  SmallObjectPool::Deallocate (p, 40);
+  // p stays on the 33-48 bytes list, so the heap cannot return it
+  void *q = SmallObjectPool::Allocate (17);
+  NS_TEST_EXPECT_MSG_NE (q, p, "A block reused for another size");
+  void *r = SmallObjectPool::Allocate (48);
+  NS_TEST_EXPECT_MSG_EQ (r, p, "A block not reused for the same rounded size");
+  SmallObjectPool::Deallocate (q, 17);
+  SmallObjectPool::Deallocate (r, 48);
+
+  void *large = SmallObjectPool::Allocate (1000);
+  NS_TEST_EXPECT_MSG_NE (large, 0, "Large block not allocated");
+  SmallObjectPool::Deallocate (large, 1000);
+}
+
+/**
+ * Check that the events and the callback implementations are allocated
+ * from the pool.
+ */
+class SmallObjectPoolEventTestCase : public TestCase
+{
+public:
+  SmallObjectPoolEventTestCase ();
+private:
+  virtual void DoRun (void);
+  void Target (int a, double b);
+};
+
+SmallObjectPoolEventTestCase::SmallObjectPoolEventTestCase ()
+  : TestCase ("Check that the events and callbacks reuse their storage")
+{
+}
+
+void
+SmallObjectPoolEventTestCase::Target (int a, double b)
+{
+}
+
+void
+SmallObjectPoolEventTestCase::DoRun (void)
+{
+  EventImpl *first = MakeEvent (&SmallObjectPoolEventTestCase::Target, this, 1, 2.0);
+  first->Unref ();
+  EventImpl *second = MakeEvent (&SmallObjectPoolEventTestCase::Target, this, 3, 4.0);
+  NS_TEST_EXPECT_MSG_EQ (second, first, "Event storage not reused");
+  second->Unref ();
+
+  const CallbackImplBase *impl;
+  {
+    Callback<void, int, double> cb = MakeCallback (&SmallObjectPoolEventTestCase::Target, this);
+    impl = PeekPointer (cb.GetImpl ());
+  }
+  Callback<void, int, double> cb = MakeCallback (&SmallObjectPoolEventTestCase::Target, this);
+  NS_TEST_EXPECT_MSG_EQ (PeekPointer (cb.GetImpl ()), impl, "Callback storage not reused");
+}
+
+/**
+ * The small object pool test suite.
+ */
+class SmallObjectPoolTestSuite : public TestSuite
+{
+public:
+  SmallObjectPoolTestSuite ()
+    : TestSuite ("small-object-pool")
+  {
+    AddTestCase (new SmallObjectPoolReuseTestCase (), TestCase::QUICK);
+    AddTestCase (new SmallObjectPoolEventTestCase (), TestCase::QUICK);
+  }
+} g_smallObjectPoolTestSuite;
@@ -21,18 +21,24 @@
 #include "ns3/simulator.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/heap-scheduler.h"
+#include "ns3/quad-heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
 #include "ns3/config.h"
 #include "ns3/string.h"
 #include "ns3/system-thread.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/log.h"
 
 #include <ctime>
 #include <list>
 #include <utility>
+#include <vector>
 
 using namespace ns3;
 
+NS_LOG_COMPONENT_DEFINE ("ThreadedSimulatorTestSuite");
+
 #define MAXTHREADS 64
 
 class ThreadedSimulatorEventsTestCase : public TestCase
@@ -225,6 +231,135 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+/**
+ * Check that the events scheduled from several threads at once are all
+ * executed, in the order each thread scheduled them.
+ *
+ * The threads schedule their events back to back, without waiting for the
+ * previous ones to run, while the main thread runs the simulation.
+ */
+class ThreadedSimulatorInjectionTestCase : public TestCase
+{
+public:
+  ThreadedSimulatorInjectionTestCase (const std::string &simulatorType, unsigned int threads, uint32_t events);
+  static void InjectingThread (std::pair<ThreadedSimulatorInjectionTestCase *, unsigned int> context);
+  void Receive (unsigned int threadno, uint32_t seq);
+  void Poll (void);
+
+  std::string m_simulatorType;
+  unsigned int m_threads;
+  uint32_t m_events;                     //!< Events scheduled by each thread
+  std::vector<uint32_t> m_next;          //!< Next sequence number expected from each thread
+  std::vector<uint32_t> m_outOfOrder;    //!< Events received out of order from each thread
+  uint64_t m_received;
+  SystemWallClockMs m_wallClock;
+  std::list<Ptr<SystemThread> > m_threadlist;
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+};
+
+ThreadedSimulatorInjectionTestCase::ThreadedSimulatorInjectionTestCase (const std::string &simulatorType, unsigned int threads, uint32_t events)
+  : TestCase ("Check that the events scheduled concurrently by " + std::to_string (threads) +
+              " threads are executed in order in " + simulatorType),
+    m_simulatorType (simulatorType),
+    m_threads (threads),
+    m_events (events),
+    m_received (0)
+{
+}
+
+void
+ThreadedSimulatorInjectionTestCase::InjectingThread (std::pair<ThreadedSimulatorInjectionTestCase *, unsigned int> context)
+{
+  ThreadedSimulatorInjectionTestCase *me = context.first;
+  unsigned int threadno = context.second;
+
+  for (uint32_t seq = 0; seq < me->m_events; ++seq)
+    {
+      Simulator::ScheduleWithContext (threadno, Seconds (0),
+                                      &ThreadedSimulatorInjectionTestCase::Receive, me, threadno, seq);
+    }
+}
+
+void
+ThreadedSimulatorInjectionTestCase::Receive (unsigned int threadno, uint32_t seq)
+{
+  if (seq != m_next[threadno])
+    {
+      m_outOfOrder[threadno]++;
+    }
+  m_next[threadno] = seq + 1;
+  m_received++;
+}
+
+void
+ThreadedSimulatorInjectionTestCase::Poll (void)
+{
+  // Keep the default simulator running until all the events are in, or
+  // give up after 30 seconds if some were lost
+  if (m_received == uint64_t (m_threads) * m_events
+      || m_wallClock.End () > 30000)
+    {
+      Simulator::Stop ();
+      return;
+    }
+  Simulator::Schedule (MicroSeconds (10), &ThreadedSimulatorInjectionTestCase::Poll, this);
+}
+
+void
+ThreadedSimulatorInjectionTestCase::DoSetup (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (m_simulatorType));
+  m_next.assign (m_threads, 0);
+  m_outOfOrder.assign (m_threads, 0);
+  m_received = 0;
+  for (unsigned int i = 0; i < m_threads; ++i)
+    {
+      m_threadlist.push_back (
+        Create<SystemThread> (MakeBoundCallback (
+            &ThreadedSimulatorInjectionTestCase::InjectingThread,
+                std::pair<ThreadedSimulatorInjectionTestCase *, unsigned int> (this, i))));
+    }
+}
+
+void
+ThreadedSimulatorInjectionTestCase::DoTeardown (void)
+{
+  m_threadlist.clear ();
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+void
+ThreadedSimulatorInjectionTestCase::DoRun (void)
+{
+  Simulator::Schedule (MicroSeconds (10), &ThreadedSimulatorInjectionTestCase::Poll, this);
+
+  m_wallClock.Start ();
+  for (std::list<Ptr<SystemThread> >::iterator it = m_threadlist.begin (); it != m_threadlist.end (); ++it)
+    {
+      (*it)->Start ();
+    }
+  Simulator::Run ();
+  for (std::list<Ptr<SystemThread> >::iterator it = m_threadlist.begin (); it != m_threadlist.end (); ++it)
+    {
+      (*it)->Join ();
+    }
+  int64_t elapsed = m_wallClock.End ();
+  Simulator::Destroy ();
+
+  NS_LOG_INFO (m_simulatorType << ": " << m_received << " events from " << m_threads <<
+               " threads in " << elapsed << " ms");
+  NS_TEST_EXPECT_MSG_EQ (m_received, uint64_t (m_threads) * m_events, "Events lost");
+  for (unsigned int i = 0; i < m_threads; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_next[i], m_events, "Events lost from thread " << i);
+      NS_TEST_EXPECT_MSG_EQ (m_outOfOrder[i], 0u, "Events out of order from thread " << i);
+    }
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -240,6 +375,7 @@ public:
     std::string schedulerTypes[] = {
       "ns3::ListScheduler",
       "ns3::HeapScheduler",
+      "ns3::QuadHeapScheduler",
       "ns3::MapScheduler",
       "ns3::CalendarScheduler"
     };
@@ -262,5 +398,10 @@ public:
               }
           }
       }
+    for (unsigned int i=0; i < (sizeof(simulatorTypes) / sizeof(simulatorTypes[0])); ++i)
+      {
+        AddTestCase (new ThreadedSimulatorInjectionTestCase (simulatorTypes[i], 1, 50000), TestCase::QUICK);
+        AddTestCase (new ThreadedSimulatorInjectionTestCase (simulatorTypes[i], 8, 20000), TestCase::QUICK);
+      }
   }
 } g_threadedSimulatorTestSuite;
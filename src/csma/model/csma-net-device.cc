@@ -30,6 +30,7 @@
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
 #include "ns3/trace-source-accessor.h"
+#include "ns3/gso-tag.h"
 #include "csma-net-device.h"
 #include "csma-channel.h"
 
@@ -217,6 +218,7 @@ CsmaNetDevice::DoDispose ()
   NS_LOG_FUNCTION_NOARGS ();
   m_channel = 0;
   m_node = 0;
+  m_gsoFrames.clear ();
   NetDevice::DoDispose ();
 }
 
@@ -558,15 +560,14 @@ CsmaNetDevice::TransmitAbort (void)
   // get that out.  If the queue is empty we just wait until someone puts one
   // in.
   //
-  if (m_queue->IsEmpty ())
+  if (m_gsoFrames.empty () && m_queue->IsEmpty ())
     {
       return;
     }
   else
     {
-      Ptr<QueueItem> item = m_queue->Dequeue ();
-      NS_ASSERT_MSG (item != 0, "CsmaNetDevice::TransmitAbort(): IsEmpty false but no Packet on queue?");
-      m_currentPkt = item->GetPacket ();
+      m_currentPkt = NextFrame ();
+      NS_ASSERT_MSG (m_currentPkt != 0, "CsmaNetDevice::TransmitAbort(): IsEmpty false but no Packet on queue?");
       m_snifferTrace (m_currentPkt);
       m_promiscSnifferTrace (m_currentPkt);
       TransmitStart ();
@@ -627,21 +628,68 @@ CsmaNetDevice::TransmitReadyEvent (void)
   //
   // Get the next packet from the queue for transmitting
   //
-  if (m_queue->IsEmpty ())
+  if (m_gsoFrames.empty () && m_queue->IsEmpty ())
     {
       return;
     }
   else
     {
-      Ptr<QueueItem> item = m_queue->Dequeue ();
-      NS_ASSERT_MSG (item != 0, "CsmaNetDevice::TransmitReadyEvent(): IsEmpty false but no Packet on queue?");
-      m_currentPkt = item->GetPacket ();
+      m_currentPkt = NextFrame ();
+      NS_ASSERT_MSG (m_currentPkt != 0, "CsmaNetDevice::TransmitReadyEvent(): IsEmpty false but no Packet on queue?");
       m_snifferTrace (m_currentPkt);
       m_promiscSnifferTrace (m_currentPkt);
       TransmitStart ();
     }
 }
 
+Ptr<Packet>
+CsmaNetDevice::NextFrame (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  Ptr<Packet> p;
+  if (!m_gsoFrames.empty ())
+    {
+      p = m_gsoFrames.front ();
+      m_gsoFrames.pop_front ();
+      return p;
+    }
+  Ptr<QueueItem> item = m_queue->Dequeue ();
+  if (item == 0)
+    {
+      return 0;
+    }
+  p = item->GetPacket ();
+  GsoTag tag;
+  if (!p->PeekPacketTag (tag))
+    {
+      return p;
+    }
+
+  //
+  // A super-segment, queued as a whole: take its Ethernet header and
+  // trailer off, and give one to each of its frames
+  //
+  NS_ASSERT_MSG (m_encapMode == DIX, "CsmaNetDevice::NextFrame(): super-segment in LLC mode");
+  Ptr<Packet> packet = p->Copy ();
+  EthernetTrailer trailer;
+  packet->RemoveTrailer (trailer);
+  EthernetHeader header (false);
+  packet->RemoveHeader (header);
+  if (!GsoTag::Segment (packet, header.GetLengthType (), m_gsoFrames))
+    {
+      return p;
+    }
+  for (std::list<Ptr<Packet> >::iterator it = m_gsoFrames.begin (); it != m_gsoFrames.end (); ++it)
+    {
+      AddHeader (*it, header.GetSource (), header.GetDestination (), header.GetLengthType ());
+    }
+  NS_LOG_LOGIC ("Super-segment cut into " << m_gsoFrames.size () << " frames");
+  p = m_gsoFrames.front ();
+  m_gsoFrames.pop_front ();
+  return p;
+}
+
 bool
 CsmaNetDevice::Attach (Ptr<CsmaChannel> ch)
 {
@@ -983,11 +1031,10 @@ CsmaNetDevice::SendFrom (Ptr<Packet> packet, const Address& src, const Address&
   //
   if (m_txMachineState == READY) 
     {
-      if (m_queue->IsEmpty () == false)
+      if (m_gsoFrames.empty () == false || m_queue->IsEmpty () == false)
         {
-          Ptr<QueueItem> item = m_queue->Dequeue ();
-          NS_ASSERT_MSG (item != 0, "CsmaNetDevice::SendFrom(): IsEmpty false but no Packet on queue?");
-          m_currentPkt = item->GetPacket ();
+          m_currentPkt = NextFrame ();
+          NS_ASSERT_MSG (m_currentPkt != 0, "CsmaNetDevice::SendFrom(): IsEmpty false but no Packet on queue?");
           m_promiscSnifferTrace (m_currentPkt);
           m_snifferTrace (m_currentPkt);
           TransmitStart ();
@@ -1047,6 +1094,12 @@ CsmaNetDevice::SupportsSendFrom () const
   return true;
 }
 
+bool
+CsmaNetDevice::SupportsGso (void) const
+{
+  return m_encapMode == DIX;
+}
+
 int64_t
 CsmaNetDevice::AssignStreams (int64_t stream)
 {
@@ -22,6 +22,7 @@
 #define CSMA_NET_DEVICE_H
 
 #include <cstring>
+#include <list>
 #include "ns3/node.h"
 #include "ns3/backoff.h"
 #include "ns3/address.h"
@@ -327,6 +328,11 @@ public:
   virtual void SetPromiscReceiveCallback (PromiscReceiveCallback cb);
   virtual bool SupportsSendFrom (void) const;
 
+  /**
+   * \return true in DIX mode, where a frame has no length field
+   */
+  virtual bool SupportsGso (void) const;
+
  /**
   * Assign a fixed random variable stream number to the random variables
   * used by this model.  Return the number of streams (possibly zero) that
@@ -433,6 +439,15 @@ private:
    */
   void TransmitReadyEvent (void);
 
+  /**
+   * Takes the next frame to transmit: the next frame of the super-segment
+   * being transmitted, if any, or the next packet of the queue. A
+   * super-segment is cut into wire sized frames when it is dequeued.
+   *
+   * \return the next frame, or 0 if there is none
+   */
+  Ptr<Packet> NextFrame (void);
+
   /**
    * Aborts the transmission of the current packet
    *
@@ -516,6 +531,12 @@ private:
    */
   Ptr<Packet> m_currentPkt;
 
+  /**
+   * Frames left of the super-segment being transmitted, sent before the
+   * next packet of the queue.
+   */
+  std::list<Ptr<Packet> > m_gsoFrames;
+
   /**
    * The CsmaChannel to which this CsmaNetDevice has been
    * attached.
@@ -62,7 +62,7 @@ uint32_t
 GlobalRouteManager::AllocateRouterId (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  static uint32_t routerId = 0;
+  static thread_local uint32_t routerId = 0;
   return routerId++;
 }
 
@@ -28,6 +28,45 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
+bool
+Ipv4EndPointDemux::FourTuple::operator== (const FourTuple &other) const
+{
+  return localPort == other.localPort && peerPort == other.peerPort
+         && localAddress == other.localAddress && peerAddress == other.peerAddress;
+}
+
+size_t
+Ipv4EndPointDemux::FourTupleHash::operator() (const FourTuple &tuple) const
+{
+  uint64_t addresses = (uint64_t (tuple.localAddress.Get ()) << 32) | tuple.peerAddress.Get ();
+  uint64_t ports = (uint64_t (tuple.localPort) << 16) | tuple.peerPort;
+  // 64 bit mix of the addresses, then of the ports (from MurmurHash3)
+  uint64_t h = addresses ^ (ports * 0x9e3779b97f4a7c15ULL);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return static_cast<size_t> (h);
+}
+
+Ipv4EndPointDemux::FourTuple
+Ipv4EndPointDemux::GetFourTuple (Ipv4EndPoint *endPoint)
+{
+  FourTuple tuple;
+  tuple.localAddress = endPoint->GetLocalAddress ();
+  tuple.localPort = endPoint->GetLocalPort ();
+  tuple.peerAddress = endPoint->GetPeerAddress ();
+  tuple.peerPort = endPoint->GetPeerPort ();
+  return tuple;
+}
+
+bool
+Ipv4EndPointDemux::IsConnected (Ipv4EndPoint *endPoint)
+{
+  return endPoint->GetLocalAddress () != Ipv4Address::GetAny ()
+         && endPoint->GetPeerAddress () != Ipv4Address::GetAny ()
+         && endPoint->GetPeerPort () != 0;
+}
+
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
   : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
 {
@@ -40,38 +79,96 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
     {
       Ipv4EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
 }
 
-bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv4EndPoint *
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  endPoint->m_demuxPosition = m_endPoints.insert (m_endPoints.end (), endPoint);
+  endPoint->m_demux = this;
+  Index (endPoint);
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  return endPoint;
+}
+
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  FourTuple tuple = GetFourTuple (endPoint);
+  ++m_nLocalPort[tuple.localPort];
+  if (IsConnected (endPoint))
     {
-      if ((*i)->GetLocalPort  () == port) 
+      m_connected.insert (std::make_pair (tuple, endPoint));
+    }
+  else
+    {
+      m_wildcards[tuple.localPort].push_back (endPoint);
+    }
+  tuple.peerAddress = Ipv4Address::GetAny ();
+  tuple.peerPort = 0;
+  ++m_nLocal[tuple];
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  FourTuple tuple = GetFourTuple (endPoint);
+  std::unordered_map<uint16_t, uint32_t>::iterator port = m_nLocalPort.find (tuple.localPort);
+  if (--port->second == 0)
+    {
+      m_nLocalPort.erase (port);
+    }
+  if (IsConnected (endPoint))
+    {
+      std::pair<ConnectedEndPoints::iterator, ConnectedEndPoints::iterator> range = m_connected.equal_range (tuple);
+      for (ConnectedEndPoints::iterator i = range.first; i != range.second; i++)
+        {
+          if (i->second == endPoint)
+            {
+              m_connected.erase (i);
+              break;
+            }
+        }
+    }
+  else
+    {
+      std::unordered_map<uint16_t, EndPoints>::iterator wildcards = m_wildcards.find (tuple.localPort);
+      wildcards->second.remove (endPoint);
+      if (wildcards->second.empty ())
         {
-          return true;
+          m_wildcards.erase (wildcards);
         }
     }
-  return false;
+  tuple.peerAddress = Ipv4Address::GetAny ();
+  tuple.peerPort = 0;
+  std::unordered_map<FourTuple, uint32_t, FourTupleHash>::iterator local = m_nLocal.find (tuple);
+  if (--local->second == 0)
+    {
+      m_nLocal.erase (local);
+    }
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_nLocalPort.find (port) != m_nLocalPort.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
-        {
-          return true;
-        }
-    }
-  return false;
+  FourTuple tuple;
+  tuple.localAddress = addr;
+  tuple.localPort = port;
+  tuple.peerAddress = Ipv4Address::GetAny ();
+  tuple.peerPort = 0;
+  return m_nLocal.find (tuple) != m_nLocal.end ();
 }
 
 Ipv4EndPoint *
@@ -84,10 +181,7 @@ Ipv4EndPointDemux::Allocate (void)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (Ipv4Address::GetAny (), port));
 }
 
 Ipv4EndPoint *
@@ -100,10 +194,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -123,10 +214,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       NS_LOG_WARN ("Duplicate address/port; failing.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -134,39 +222,53 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  FourTuple tuple;
+  tuple.localAddress = localAddress;
+  tuple.localPort = localPort;
+  tuple.peerAddress = peerAddress;
+  tuple.peerPort = peerPort;
+  bool exists = false;
+  if (m_connected.find (tuple) != m_connected.end ())
+    {
+      exists = true;
+    }
+  else
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
+      // a tuple with a wildcard can only be held by a non connected end point
+      std::unordered_map<uint16_t, EndPoints>::iterator wildcards = m_wildcards.find (localPort);
+      if (wildcards != m_wildcards.end ())
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          for (EndPointsI i = wildcards->second.begin (); i != wildcards->second.end (); i++)
+            {
+              if (GetFourTuple (*i) == tuple)
+                {
+                  exists = true;
+                  break;
+                }
+            }
         }
     }
+  if (exists)
+    {
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
+    }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
-  return endPoint;
+  return Insert (endPoint);
 }
 
 void 
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (endPoint->m_demux == this)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      Unindex (endPoint);
+      m_endPoints.erase (endPoint->m_demuxPosition);
+      endPoint->m_demux = 0;
+      delete endPoint;
     }
 }
 
@@ -205,8 +307,43 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval3; // Matches all but local address
   EndPoints retval4; // Exact match on all 4
 
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+    {
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+        {
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
+        }
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
+
+  // A fully specified end point can only match exactly, on the address of
+  // the interface when the packet is a broadcast. The other candidates are
+  // the end points with a wildcard on the same port.
+  m_candidates.clear ();
+  FourTuple tuple;
+  tuple.localAddress = incomingInterfaceAddr;
+  tuple.localPort = dport;
+  tuple.peerAddress = saddr;
+  tuple.peerPort = sport;
+  std::pair<ConnectedEndPoints::iterator, ConnectedEndPoints::iterator> range = m_connected.equal_range (tuple);
+  for (ConnectedEndPoints::iterator i = range.first; i != range.second; i++)
+    {
+      m_candidates.push_back (i->second);
+    }
+  std::unordered_map<uint16_t, EndPoints>::iterator wildcards = m_wildcards.find (dport);
+  if (wildcards != m_wildcards.end ())
+    {
+      m_candidates.insert (m_candidates.end (), wildcards->second.begin (), wildcards->second.end ());
+    }
+
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (std::vector<Ipv4EndPoint *>::iterator i = m_candidates.begin (); i != m_candidates.end (); i++)
     {
       Ipv4EndPoint* endP = *i;
 
@@ -222,14 +359,6 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
           continue;
         }
 
-      if (endP->GetLocalPort () != dport) 
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
       if (endP->GetBoundNetDevice ())
         {
           if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
@@ -241,20 +370,6 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
               continue;
             }
         }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-        {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
-            {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
-            }
-        }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
       bool localAddressMatchesWildCard = 
         endP->GetLocalAddress () == Ipv4Address::GetAny ();
       bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
@@ -326,6 +441,17 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport);
 
+  FourTuple tuple;
+  tuple.localAddress = daddr;
+  tuple.localPort = dport;
+  tuple.peerAddress = saddr;
+  tuple.peerPort = sport;
+  ConnectedEndPoints::iterator exact = m_connected.find (tuple);
+  if (exact != m_connected.end ())
+    {
+      return exact->second;
+    }
+
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
   uint32_t genericity = 3;
@@ -384,4 +510,3 @@ Ipv4EndPointDemux::AllocateEphemeralPort (void)
 }
 
 } // namespace ns3
-
@@ -33,6 +33,8 @@
 #include "ns3/boolean.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/traffic-control-layer.h"
+#include "ns3/gso-tag.h"
+#include "ns3/abort.h"
 
 #include "loopback-net-device.h"
 #include "arp-l3-protocol.h"
@@ -743,6 +745,14 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
       tos = ipTosTag.GetTos ();
     }
 
+  // A super-segment takes an identification for each of its wire segments
+  uint16_t identifications = 1;
+  GsoTag gsoTag;
+  if (packet->PeekPacketTag (gsoTag))
+    {
+      identifications = (packet->GetSize () + gsoTag.GetSegmentSize () - 1) / gsoTag.GetSegmentSize ();
+    }
+
   // Handle a few cases:
   // 1) packet is destined to limited broadcast address
   // 2) packet is destined to a subnet-directed broadcast address
@@ -815,7 +825,8 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
   if (route && route->GetGateway () != Ipv4Address ())
     {
       NS_LOG_LOGIC ("Ipv4L3Protocol::Send case 3:  passed in with route");
-      ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment);
+      ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment,
+                              identifications);
       int32_t interface = GetInterfaceForDevice (route->GetOutputDevice ());
       m_sendOutgoingTrace (ipHeader, packet, interface);
       SendRealOut (route, packet->Copy (), ipHeader);
@@ -834,7 +845,8 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
   NS_LOG_LOGIC ("Ipv4L3Protocol::Send case 5:  passed in with no route " << destination);
   Socket::SocketErrno errno_; 
   Ptr<NetDevice> oif (0); // unused for now
-  ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment);
+  ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment,
+                          identifications);
   Ptr<Ipv4Route> newRoute;
   if (m_routingProtocol != 0)
     {
@@ -868,9 +880,10 @@ Ipv4L3Protocol::BuildHeader (
   uint16_t payloadSize,
   uint8_t ttl,
   uint8_t tos,
-  bool mayFragment)
+  bool mayFragment,
+  uint16_t identifications)
 {
-  NS_LOG_FUNCTION (this << source << destination << (uint16_t)protocol << payloadSize << (uint16_t)ttl << (uint16_t)tos << mayFragment);
+  NS_LOG_FUNCTION (this << source << destination << (uint16_t)protocol << payloadSize << (uint16_t)ttl << (uint16_t)tos << mayFragment << identifications);
   Ipv4Header ipHeader;
   ipHeader.SetSource (source);
   ipHeader.SetDestination (destination);
@@ -888,7 +901,7 @@ Ipv4L3Protocol::BuildHeader (
     {
       ipHeader.SetMayFragment ();
       ipHeader.SetIdentification (m_identification[key]);
-      m_identification[key]++;
+      m_identification[key] += identifications;
     }
   else
     {
@@ -898,7 +911,7 @@ Ipv4L3Protocol::BuildHeader (
       // >> Originating sources MAY set the IPv4 ID field of atomic datagrams
       //    to any value.
       ipHeader.SetIdentification (m_identification[key]);
-      m_identification[key]++;
+      m_identification[key] += identifications;
     }
   if (Node::ChecksumEnabled ())
     {
@@ -925,12 +938,35 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
   Ptr<Ipv4Interface> outInterface = GetInterface (interface);
   NS_LOG_LOGIC ("Send via NetDevice ifIndex " << outDev->GetIfIndex () << " ipv4InterfaceIndex " << interface);
 
+  // A super-segment goes down as a whole to a device that segments it,
+  // unless a queue disc sits in between: queue discs count it as one
+  // packet, so their limits would hold as many super-segments. Otherwise
+  // it is segmented here
+  GsoTag gsoTag;
+  bool gso = packet->PeekPacketTag (gsoTag);
+  if (gso && (!outDev->SupportsGso ()
+              || m_node->GetObject<TrafficControlLayer> ()->GetRootQueueDiscOnDevice (outDev) != 0))
+    {
+      Ptr<Packet> superSegment = packet->Copy ();
+      superSegment->AddHeader (ipHeader);
+      std::list<Ptr<Packet> > segments;
+      NS_ABORT_MSG_UNLESS (GsoTag::Segment (superSegment, PROT_NUMBER, segments), "No segmenter for IPv4");
+      NS_LOG_LOGIC ("Super-segment cut into " << segments.size () << " segments before the queue disc or device");
+      for (std::list<Ptr<Packet> >::iterator it = segments.begin (); it != segments.end (); ++it)
+        {
+          Ipv4Header segmentHeader;
+          (*it)->RemoveHeader (segmentHeader);
+          SendRealOut (route, *it, segmentHeader);
+        }
+      return;
+    }
+
   if (!route->GetGateway ().IsEqual (Ipv4Address ("0.0.0.0")))
     {
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to gateway " << route->GetGateway ());
-          if ( packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu () )
+          if (!gso && packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu ())
             {
               std::list<Ipv4PayloadHeaderPair> listFragments;
               DoFragmentation (packet, ipHeader, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -957,7 +993,7 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to destination " << ipHeader.GetDestination ());
-          if ( packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu () )
+          if (!gso && packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu ())
             {
               std::list<Ipv4PayloadHeaderPair> listFragments;
               DoFragmentation (packet, ipHeader, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -302,6 +302,8 @@ private:
    * \param ttl Time to Live
    * \param tos Type of Service
    * \param mayFragment true if the packet can be fragmented
+   * \param identifications the identifications taken by the packet, one
+   * per wire segment of a super-segment
    * \return newly created IPv4 header
    */
   Ipv4Header BuildHeader (
@@ -311,7 +313,8 @@ private:
     uint16_t payloadSize,
     uint8_t ttl,
     uint8_t tos,
-    bool mayFragment);
+    bool mayFragment,
+    uint16_t identifications = 1);
 
   /**
    * \brief Send packet with route.
@@ -26,6 +26,39 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux");
 
+bool Ipv6EndPointDemux::FourTuple::operator== (const FourTuple &other) const
+{
+  return localPort == other.localPort && peerPort == other.peerPort
+         && localAddress == other.localAddress && peerAddress == other.peerAddress;
+}
+
+size_t Ipv6EndPointDemux::FourTupleHash::operator() (const FourTuple &tuple) const
+{
+  Ipv6AddressHash addressHash;
+  uint64_t h = addressHash (tuple.localAddress);
+  h = h * 0x9e3779b97f4a7c15ULL + addressHash (tuple.peerAddress);
+  h = h * 0x9e3779b97f4a7c15ULL + ((uint32_t (tuple.localPort) << 16) | tuple.peerPort);
+  h ^= h >> 33;
+  return static_cast<size_t> (h);
+}
+
+Ipv6EndPointDemux::FourTuple Ipv6EndPointDemux::GetFourTuple (Ipv6EndPoint *endPoint)
+{
+  FourTuple tuple;
+  tuple.localAddress = endPoint->GetLocalAddress ();
+  tuple.localPort = endPoint->GetLocalPort ();
+  tuple.peerAddress = endPoint->GetPeerAddress ();
+  tuple.peerPort = endPoint->GetPeerPort ();
+  return tuple;
+}
+
+bool Ipv6EndPointDemux::IsConnected (Ipv6EndPoint *endPoint)
+{
+  return endPoint->GetLocalAddress () != Ipv6Address::GetAny ()
+         && endPoint->GetPeerAddress () != Ipv6Address::GetAny ()
+         && endPoint->GetPeerPort () != 0;
+}
+
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
@@ -40,36 +73,91 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
       Ipv6EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
 }
 
-bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv6EndPoint* Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  endPoint->m_demuxPosition = m_endPoints.insert (m_endPoints.end (), endPoint);
+  endPoint->m_demux = this;
+  Index (endPoint);
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  return endPoint;
+}
+
+void Ipv6EndPointDemux::Index (Ipv6EndPoint *endPoint)
+{
+  FourTuple tuple = GetFourTuple (endPoint);
+  ++m_nLocalPort[tuple.localPort];
+  if (IsConnected (endPoint))
     {
-      if ((*i)->GetLocalPort  () == port)
-        {
-          return true;
-        }
+      m_connected.insert (std::make_pair (tuple, endPoint));
+    }
+  else
+    {
+      m_wildcards[tuple.localPort].push_back (endPoint);
     }
-  return false;
+  tuple.peerAddress = Ipv6Address::GetAny ();
+  tuple.peerPort = 0;
+  ++m_nLocal[tuple];
 }
 
-bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
+void Ipv6EndPointDemux::Unindex (Ipv6EndPoint *endPoint)
 {
-  NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  FourTuple tuple = GetFourTuple (endPoint);
+  std::unordered_map<uint16_t, uint32_t>::iterator port = m_nLocalPort.find (tuple.localPort);
+  if (--port->second == 0)
     {
-      if ((*i)->GetLocalPort () == port
-          && (*i)->GetLocalAddress () == addr)
+      m_nLocalPort.erase (port);
+    }
+  if (IsConnected (endPoint))
+    {
+      std::pair<ConnectedEndPoints::iterator, ConnectedEndPoints::iterator> range = m_connected.equal_range (tuple);
+      for (ConnectedEndPoints::iterator i = range.first; i != range.second; i++)
         {
-          return true;
+          if (i->second == endPoint)
+            {
+              m_connected.erase (i);
+              break;
+            }
         }
     }
-  return false;
+  else
+    {
+      std::unordered_map<uint16_t, EndPoints>::iterator wildcards = m_wildcards.find (tuple.localPort);
+      wildcards->second.remove (endPoint);
+      if (wildcards->second.empty ())
+        {
+          m_wildcards.erase (wildcards);
+        }
+    }
+  tuple.peerAddress = Ipv6Address::GetAny ();
+  tuple.peerPort = 0;
+  std::unordered_map<FourTuple, uint32_t, FourTupleHash>::iterator local = m_nLocal.find (tuple);
+  if (--local->second == 0)
+    {
+      m_nLocal.erase (local);
+    }
+}
+
+bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_nLocalPort.find (port) != m_nLocalPort.end ();
+}
+
+bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
+{
+  NS_LOG_FUNCTION (this << addr << port);
+  FourTuple tuple;
+  tuple.localAddress = addr;
+  tuple.localPort = port;
+  tuple.peerAddress = Ipv6Address::GetAny ();
+  tuple.peerPort = 0;
+  return m_nLocal.find (tuple) != m_nLocal.end ();
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
@@ -81,10 +169,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (Ipv6Address::GetAny (), port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
@@ -96,10 +181,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (address, port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (uint16_t port)
@@ -117,48 +199,59 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address, uint16_t port)
       NS_LOG_WARN ("Duplicate address/port; failing.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (address, port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t localPort,
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  FourTuple tuple;
+  tuple.localAddress = localAddress;
+  tuple.localPort = localPort;
+  tuple.peerAddress = peerAddress;
+  tuple.peerPort = peerPort;
+  bool exists = false;
+  if (m_connected.find (tuple) != m_connected.end ())
+    {
+      exists = true;
+    }
+  else
     {
-      if ((*i)->GetLocalPort () == localPort
-          && (*i)->GetLocalAddress () == localAddress
-          && (*i)->GetPeerPort () == peerPort
-          && (*i)->GetPeerAddress () == peerAddress)
+      /* a tuple with a wildcard can only be held by a non connected end point */
+      std::unordered_map<uint16_t, EndPoints>::iterator wildcards = m_wildcards.find (localPort);
+      if (wildcards != m_wildcards.end ())
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          for (EndPointsI i = wildcards->second.begin (); i != wildcards->second.end (); i++)
+            {
+              if (GetFourTuple (*i) == tuple)
+                {
+                  exists = true;
+                  break;
+                }
+            }
         }
     }
+  if (exists)
+    {
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
+    }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
-  return endPoint;
+  return Insert (endPoint);
 }
 
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (endPoint->m_demux == this)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      Unindex (endPoint);
+      m_endPoints.erase (endPoint->m_demuxPosition);
+      endPoint->m_demux = 0;
+      delete endPoint;
     }
 }
 
@@ -178,8 +271,27 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval3; /* Matches all but local address */
   EndPoints retval4; /* Exact match on all 4 */
 
+  /* A fully specified end point can only match exactly. The other candidates
+     are the end points with a wildcard on the same port. */
+  m_candidates.clear ();
+  FourTuple tuple;
+  tuple.localAddress = daddr;
+  tuple.localPort = dport;
+  tuple.peerAddress = saddr;
+  tuple.peerPort = sport;
+  std::pair<ConnectedEndPoints::iterator, ConnectedEndPoints::iterator> range = m_connected.equal_range (tuple);
+  for (ConnectedEndPoints::iterator i = range.first; i != range.second; i++)
+    {
+      m_candidates.push_back (i->second);
+    }
+  std::unordered_map<uint16_t, EndPoints>::iterator wildcards = m_wildcards.find (dport);
+  if (wildcards != m_wildcards.end ())
+    {
+      m_candidates.insert (m_candidates.end (), wildcards->second.begin (), wildcards->second.end ());
+    }
+
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (std::vector<Ipv6EndPoint *>::iterator i = m_candidates.begin (); i != m_candidates.end (); i++)
     {
       Ipv6EndPoint* endP = *i;
 
@@ -195,15 +307,6 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
           continue;
         }
 
-      if (endP->GetLocalPort () != dport)
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
-
       if (endP->GetBoundNetDevice ())
         {
           if (!incomingInterface)
@@ -293,6 +396,17 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
 
 Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport, Ipv6Address src, uint16_t sport)
 {
+  FourTuple tuple;
+  tuple.localAddress = dst;
+  tuple.localPort = dport;
+  tuple.peerAddress = src;
+  tuple.peerPort = sport;
+  ConnectedEndPoints::iterator exact = m_connected.find (tuple);
+  if (exact != m_connected.end ())
+    {
+      return exact->second;
+    }
+
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
 
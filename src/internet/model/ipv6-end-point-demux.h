@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <list>
+#include <unordered_map>
+#include <vector>
 #include "ns3/ipv6-address.h"
 #include "ipv6-interface.h"
 
@@ -34,6 +36,10 @@ class Ipv6EndPoint;
  * \ingroup ipv6
  *
  * \brief Demultiplexer for end points.
+ *
+ * Fully specified endpoints are hashed on their four-tuple, the others are
+ * grouped by local port, so that a lookup does not depend on the number of
+ * established connections.
  */
 class Ipv6EndPointDemux
 {
@@ -147,6 +153,78 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief Local and peer address and port of an end point.
+   */
+  struct FourTuple
+  {
+    Ipv6Address localAddress; //!< Local address
+    uint16_t localPort;        //!< Local port
+    Ipv6Address peerAddress;  //!< Peer address
+    uint16_t peerPort;         //!< Peer port
+
+    /**
+     * \brief Comparison operator
+     * \param other tuple to compare with
+     * \return true if the tuples are equal
+     */
+    bool operator== (const FourTuple &other) const;
+  };
+
+  /**
+   * \brief Hash function for FourTuple
+   */
+  struct FourTupleHash
+  {
+    /**
+     * \param tuple the tuple to hash
+     * \return the hash of the tuple
+     */
+    size_t operator() (const FourTuple &tuple) const;
+  };
+
+  /**
+   * \brief Container of the fully specified end points, by four-tuple.
+   */
+  typedef std::unordered_multimap<FourTuple, Ipv6EndPoint *, FourTupleHash> ConnectedEndPoints;
+
+  /**
+   * \brief Build the four-tuple of an end point.
+   * \param endPoint the end point
+   * \return the tuple
+   */
+  static FourTuple GetFourTuple (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Check if none of the addresses and ports of an end point is a wildcard.
+   * \param endPoint the end point
+   * \return true if the end point can only match one four-tuple
+   */
+  static bool IsConnected (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Register a new end point.
+   * \param endPoint the end point
+   * \return endPoint
+   */
+  Ipv6EndPoint *Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add an end point to the lookup indexes.
+   *
+   * Called again by the end point each time its addresses or ports change.
+   * \param endPoint the end point
+   */
+  void Index (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the lookup indexes.
+   * \param endPoint the end point
+   */
+  void Unindex (Ipv6EndPoint *endPoint);
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
@@ -172,6 +250,31 @@ private:
    * \brief A list of IPv6 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The fully specified end points, by four-tuple.
+   */
+  ConnectedEndPoints m_connected;
+
+  /**
+   * \brief The end points with a wildcard, by local port, in allocation order.
+   */
+  std::unordered_map<uint16_t, EndPoints> m_wildcards;
+
+  /**
+   * \brief Number of end points using each local port.
+   */
+  std::unordered_map<uint16_t, uint32_t> m_nLocalPort;
+
+  /**
+   * \brief Number of end points using each local address and port (peer left empty).
+   */
+  std::unordered_map<FourTuple, uint32_t, FourTupleHash> m_nLocal;
+
+  /**
+   * \brief End points examined by Lookup, kept to reuse its storage.
+   */
+  std::vector<Ipv6EndPoint *> m_candidates;
 };
 
 } /* namespace ns3 */
@@ -65,6 +65,20 @@ void Ipv6QueueDiscItem::AddHeader(void)
   m_headerAdded = true;
 }
 
+bool
+Ipv6QueueDiscItem::Mark (void)
+{
+  NS_LOG_FUNCTION (this);
+  // The ECN field is the two low order bits of the traffic class
+  uint8_t tc = m_header.GetTrafficClass ();
+  if (m_headerAdded || (tc & 0x3) == 0)
+    {
+      return false;
+    }
+  m_header.SetTrafficClass (tc | 0x3);
+  return true;
+}
+
 void
 Ipv6QueueDiscItem::Print (std::ostream& os) const
 {
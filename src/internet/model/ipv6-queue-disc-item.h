@@ -64,6 +64,15 @@ public:
    */
   virtual void AddHeader (void);
 
+  /**
+   * \brief Set the ECN field of the header to CE, if the packet is ECN-capable
+   *
+   * The header can only be marked before it is added to the packet.
+   *
+   * \return true if the packet is marked
+   */
+  virtual bool Mark (void);
+
   /**
    * \brief Print the item contents.
    * \param os output stream in which the data should be printed.
@@ -19,102 +19,317 @@
  */
 
 #include <stdint.h>
+#include <cstring>
+#include <algorithm>
 #include "ns3/mptcp-crypto.h"
 #include "ns3/log.h"
-#include "ns3/node.h"
-#include "ns3/buffer.h"
 #include "ns3/assert.h"
-#include <cstddef> // for size_t
-
-#ifdef HAVE_CRYPTO
-    #include <gcrypt.h> // for the sha1 hash
-#else
-    #include <functional> // to emulate some hash function
-    #include <iostream>
-    #include <string>
-//    #include "ns3/hash.h"
-//    Create<Hash::Function::Fnv1a> ()
-#endif
+#include "ns3/random-variable-stream.h"
 
 NS_LOG_COMPONENT_DEFINE ("MpTcpCrypto");
 
 namespace ns3 {
 
-//#ifdef HAVE_CRYPTO
-//static gcry_md_algos
-//map_ns_to_gcrypt_alg(mptcp_crypto_alg_t alg)
-//{
-//    return GCRY_MD_SHA1;
-//}
-//
-//#endif
+const uint32_t MpTcpSha1::DIGEST_SIZE;
+const uint32_t MpTcpSha1::BLOCK_SIZE;
 
+namespace {
+
+inline void
+WriteHtonU64 (uint8_t* buf, uint64_t value)
+{
+  for (int i = 7; i >= 0; --i)
+    {
+      buf[i] = static_cast<uint8_t> (value);
+      value >>= 8;
+    }
+}
+
+inline void
+WriteHtonU32 (uint8_t* buf, uint32_t value)
+{
+  for (int i = 3; i >= 0; --i)
+    {
+      buf[i] = static_cast<uint8_t> (value);
+      value >>= 8;
+    }
+}
+
+inline uint64_t
+ReadNtohU64 (const uint8_t* buf)
+{
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i)
+    {
+      value = (value << 8) | buf[i];
+    }
+  return value;
+}
+
+inline uint32_t
+RotateLeft (uint32_t value, uint32_t bits)
+{
+  return (value << bits) | (value >> (32 - bits));
+}
+
+} // anonymous namespace
+
+MpTcpSha1::MpTcpSha1 ()
+  : m_length (0),
+    m_blockLength (0)
+{
+  m_state[0] = 0x67452301;
+  m_state[1] = 0xEFCDAB89;
+  m_state[2] = 0x98BADCFE;
+  m_state[3] = 0x10325476;
+  m_state[4] = 0xC3D2E1F0;
+}
 
-//https://www.gnupg.org/documentation/manuals/gcrypt/Working-with-hash-algorithms.html#Working-with-hash-algorithms
 void
-GenerateTokenForKey( mptcp_crypto_alg_t ns_alg, uint64_t key, uint32_t& token, uint64_t& idsn)
+MpTcpSha1::Update (const uint8_t* data, uint32_t length)
 {
+  m_length += length;
+  if (m_blockLength > 0)
+    {
+      uint32_t n = std::min (length, BLOCK_SIZE - m_blockLength);
+      memcpy (m_block + m_blockLength, data, n);
+      m_blockLength += n;
+      data += n;
+      length -= n;
+      if (m_blockLength < BLOCK_SIZE)
+        {
+          return;
+        }
+      ProcessBlock (m_block);
+      m_blockLength = 0;
+    }
+  for (; length >= BLOCK_SIZE; data += BLOCK_SIZE, length -= BLOCK_SIZE)
+    {
+      ProcessBlock (data);
+    }
+  memcpy (m_block, data, length);
+  m_blockLength = length;
+}
+
+void
+MpTcpSha1::Final (uint8_t digest[DIGEST_SIZE])
+{
+  uint64_t bits = m_length * 8;
+  // Padding: a one bit, zeros, then the message length on the last 8 bytes of a block
+  m_block[m_blockLength++] = 0x80;
+  if (m_blockLength > BLOCK_SIZE - 8)
+    {
+      memset (m_block + m_blockLength, 0, BLOCK_SIZE - m_blockLength);
+      ProcessBlock (m_block);
+      m_blockLength = 0;
+    }
+  memset (m_block + m_blockLength, 0, BLOCK_SIZE - 8 - m_blockLength);
+  for (uint32_t i = 0; i < 8; ++i)
+    {
+      m_block[BLOCK_SIZE - 1 - i] = static_cast<uint8_t> (bits >> (8 * i));
+    }
+  ProcessBlock (m_block);
+
+  for (uint32_t i = 0; i < 5; ++i)
+    {
+      digest[4 * i] = static_cast<uint8_t> (m_state[i] >> 24);
+      digest[4 * i + 1] = static_cast<uint8_t> (m_state[i] >> 16);
+      digest[4 * i + 2] = static_cast<uint8_t> (m_state[i] >> 8);
+      digest[4 * i + 3] = static_cast<uint8_t> (m_state[i]);
+    }
+}
+
+void
+MpTcpSha1::ProcessBlock (const uint8_t* block)
+{
+  uint32_t w[80];
+  for (uint32_t i = 0; i < 16; ++i)
+    {
+      w[i] = (uint32_t (block[4 * i]) << 24) | (uint32_t (block[4 * i + 1]) << 16)
+        | (uint32_t (block[4 * i + 2]) << 8) | uint32_t (block[4 * i + 3]);
+    }
+  for (uint32_t i = 16; i < 80; ++i)
+    {
+      w[i] = RotateLeft (w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+  uint32_t a = m_state[0];
+  uint32_t b = m_state[1];
+  uint32_t c = m_state[2];
+  uint32_t d = m_state[3];
+  uint32_t e = m_state[4];
+  for (uint32_t i = 0; i < 80; ++i)
+    {
+      uint32_t f, k;
+      if (i < 20)
+        {
+          f = (b & c) | (~b & d);
+          k = 0x5A827999;
+        }
+      else if (i < 40)
+        {
+          f = b ^ c ^ d;
+          k = 0x6ED9EBA1;
+        }
+      else if (i < 60)
+        {
+          f = (b & c) | (b & d) | (c & d);
+          k = 0x8F1BBCDC;
+        }
+      else
+        {
+          f = b ^ c ^ d;
+          k = 0xCA62C1D6;
+        }
+      uint32_t temp = RotateLeft (a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = RotateLeft (b, 30);
+      b = a;
+      a = temp;
+    }
+  m_state[0] += a;
+  m_state[1] += b;
+  m_state[2] += c;
+  m_state[3] += d;
+  m_state[4] += e;
+}
+
+void
+ComputeHmacSha1 (const uint8_t* key, uint32_t keyLength,
+                 const uint8_t* message, uint32_t messageLength,
+                 uint8_t digest[MpTcpSha1::DIGEST_SIZE])
+{
+  // RFC 2104
+  uint8_t block[MpTcpSha1::BLOCK_SIZE];
+  memset (block, 0, sizeof (block));
+  if (keyLength > MpTcpSha1::BLOCK_SIZE)
+    {
+      MpTcpSha1 keyHash;
+      keyHash.Update (key, keyLength);
+      keyHash.Final (block);
+    }
+  else
+    {
+      memcpy (block, key, keyLength);
+    }
+
+  uint8_t pad[MpTcpSha1::BLOCK_SIZE];
+  for (uint32_t i = 0; i < MpTcpSha1::BLOCK_SIZE; ++i)
+    {
+      pad[i] = block[i] ^ 0x36;
+    }
+  MpTcpSha1 inner;
+  inner.Update (pad, MpTcpSha1::BLOCK_SIZE);
+  inner.Update (message, messageLength);
+  uint8_t innerDigest[MpTcpSha1::DIGEST_SIZE];
+  inner.Final (innerDigest);
+
+  for (uint32_t i = 0; i < MpTcpSha1::BLOCK_SIZE; ++i)
+    {
+      pad[i] = block[i] ^ 0x5c;
+    }
+  MpTcpSha1 outer;
+  outer.Update (pad, MpTcpSha1::BLOCK_SIZE);
+  outer.Update (innerDigest, MpTcpSha1::DIGEST_SIZE);
+  outer.Final (digest);
+}
+
 
+void
+GenerateTokenForKey( mptcp_crypto_alg_t ns_alg, uint64_t key, uint32_t& token, uint64_t& idsn)
+{
   NS_LOG_LOGIC("Generating token/key from key=" << key);
+  NS_ASSERT (ns_alg == HMAC_SHA1);
 
+  uint8_t keyBuf[8];
+  WriteHtonU64 (keyBuf, key);
 
-//  uint8_t digest[DIGEST_SIZE_IN_BYTES];
-  #ifdef HAVE_CRYPTO
-//  gcry_md_algos gcry_algo = map_ns_to_gcrypt_alg(ns_alg);
-  gcry_md_algos gcry_algo = GCRY_MD_SHA1;
-//  NS_LOG_UNCOND("Used algorithm [" << gcry_md_algo_name(alg) << "]");
-
-  static const int KEY_SIZE_IN_BYTES = sizeof(key);
-  /* converts the key into a buffer */
-  Buffer keyBuff;
-
-  keyBuff.AddAtStart(KEY_SIZE_IN_BYTES);
-  Buffer::Iterator it = keyBuff.Begin();
-  it.WriteHtonU64(key);
-
-
-    NS_LOG_DEBUG("Used algorithm [" << gcry_md_algo_name(gcry_algo) << "]");
-    int hash_length = gcry_md_get_algo_dlen( gcry_algo );
-//    unsigned char digest[ hash_length ];
-    unsigned char digest[ 20 ];
-
-    NS_LOG_DEBUG("Key length=" <<KEY_SIZE_IN_BYTES << " and hash_len=" << hash_length);
-
-    Buffer digestBuf; /* to store the generated hash */
-    digestBuf.AddAtStart(hash_length);
-
-    /*
-    gcry_md_hash_buffer (int algo, void *digest, const void *buffer, size_t length);
-    gcry_md_hash_buffer is a shortcut function to calculate a message digest of a buffer.
-    This function does not require a context and immediately returns the message digest
-    of the length bytes at buffer. digest must be allocated by the caller,
-    large enough to hold the message digest yielded by the the specified algorithm algo.
-    This required size may be obtained by using the function gcry_md_get_algo_dlen.
-    */
-    gcry_md_hash_buffer( GCRY_MD_SHA1, digest, keyBuff.PeekData(), KEY_SIZE_IN_BYTES );
-
-    Buffer::Iterator it_digest = digestBuf.Begin();
-    it_digest.Write( digest , hash_length ); // strlen( (const char*)digest)
-    it_digest = digestBuf.Begin();
-    token = it_digest.ReadNtohU32();
-    it_digest.Next( 8 );
-    idsn = it_digest.ReadNtohU64();
-  #else
-    /* the cryptographic library is not available so we rely on a ns3 specific implementation
-    that does not comply with the standard.
-    In the following, the idsn = the key (could be 0) and the token a truncated key
-
-    */
-    idsn = key;
-    token = (uint32_t)key;
-
-//     Hasher hasher = Hasher ( Create<Hash::Function::Fnv1a> () );
-//uint32_t hash = Hasher.GetHash32 (data);
-//     Create<Hash::Function::Fnv1a> ();
-  #endif // HAVE_CRYPTO
+  uint8_t digest[MpTcpSha1::DIGEST_SIZE];
+  MpTcpSha1 sha;
+  sha.Update (keyBuf, sizeof (keyBuf));
+  sha.Final (digest);
+
+  token = static_cast<uint32_t> (ReadNtohU64 (digest) >> 32);
+  idsn = ReadNtohU64 (digest + 12);
 
   NS_LOG_DEBUG("Resulting token=" << token << " and idsn=" << idsn);
 }
 
+void
+GenerateJoinHmac (uint64_t localKey, uint64_t peerKey, uint32_t localNonce, uint32_t peerNonce,
+                  uint8_t hmac[MpTcpSha1::DIGEST_SIZE])
+{
+  uint8_t key[16];
+  uint8_t message[8];
+  WriteHtonU64 (key, localKey);
+  WriteHtonU64 (key + 8, peerKey);
+  WriteHtonU32 (message, localNonce);
+  WriteHtonU32 (message + 4, peerNonce);
+  ComputeHmacSha1 (key, sizeof (key), message, sizeof (message), hmac);
+}
+
+uint64_t
+GenerateTruncatedJoinHmac (uint64_t localKey, uint64_t peerKey, uint32_t localNonce, uint32_t peerNonce)
+{
+  uint8_t hmac[MpTcpSha1::DIGEST_SIZE];
+  GenerateJoinHmac (localKey, peerKey, localNonce, peerNonce, hmac);
+  return ReadNtohU64 (hmac);
+}
+
+
+MpTcpKeyPool::MpTcpKeyPool (uint32_t batchSize)
+  : m_entries (std::max (batchSize, 1u)),
+    m_next (0),
+    m_random (CreateObject<UniformRandomVariable> ())
+{
+  Refill ();
+}
+
+MpTcpKeyPool::~MpTcpKeyPool ()
+{
+}
+
+void
+MpTcpKeyPool::Refill ()
+{
+  NS_LOG_FUNCTION (this << m_entries.size ());
+  for (std::vector<Entry>::iterator it = m_entries.begin (); it != m_entries.end (); ++it)
+    {
+      do
+        {
+          it->key = (static_cast<uint64_t> (m_random->GetInteger (0, 0xFFFFFFFF)) << 32)
+            | m_random->GetInteger (0, 0xFFFFFFFF);
+        }
+      while (it->key == 0);
+      GenerateTokenForKey (HMAC_SHA1, it->key, it->token, it->idsn);
+    }
+  m_next = 0;
+}
+
+void
+MpTcpKeyPool::Draw (uint64_t& key, uint32_t& token, uint64_t& idsn)
+{
+  if (m_next == m_entries.size ())
+    {
+      Refill ();
+    }
+  const Entry& entry = m_entries[m_next++];
+  key = entry.key;
+  token = entry.token;
+  idsn = entry.idsn;
+}
+
+uint32_t
+MpTcpKeyPool::DrawNonce ()
+{
+  return m_random->GetInteger (0, 0xFFFFFFFF);
+}
+
+uint32_t
+MpTcpKeyPool::GetNAvailable () const
+{
+  return m_entries.size () - m_next;
+}
 
 } // end of 'ns3'
@@ -37,8 +37,15 @@ In this specification, with only the SHA-1 algorithm
    bits may choose to specify different algorithms for token and IDSN
    generation.
 */
+#include <stdint.h>
+#include <vector>
+#include "ns3/simple-ref-count.h"
+#include "ns3/ptr.h"
+
 namespace ns3
 {
+  class UniformRandomVariable;
+
   /**
    * \brief Only SHA1 is defined in the RFC up to now.
    */
@@ -48,13 +55,47 @@ namespace ns3
       /* more may come in the future depending on the standardization */
   };
 
+  /**
+   * \brief SHA-1 hash (FIPS 180-4) computed incrementally, without heap allocation
+   */
+  class MpTcpSha1
+  {
+  public:
+    static const uint32_t DIGEST_SIZE = 20;  //!< Size of the digest in bytes
+    static const uint32_t BLOCK_SIZE = 64;   //!< Size of the blocks hashed at once
+
+    MpTcpSha1 ();
+
+    /**
+     * \brief Append data to the hashed message
+     */
+    void Update (const uint8_t* data, uint32_t length);
+
+    /**
+     * \brief Pad the message and write its digest. The object must not be used afterwards.
+     */
+    void Final (uint8_t digest[DIGEST_SIZE]);
+
+  private:
+    void ProcessBlock (const uint8_t* block);
+
+    uint32_t m_state[5];             //!< Intermediate hash value
+    uint64_t m_length;               //!< Number of bytes hashed
+    uint8_t m_block[BLOCK_SIZE];     //!< Bytes waiting for a full block
+    uint32_t m_blockLength;          //!< Number of bytes in m_block
+  };
+
+  /**
+   * \brief HMAC-SHA1 as defined in \rfc{2104}
+   */
+  void
+  ComputeHmacSha1 (const uint8_t* key, uint32_t keyLength,
+                   const uint8_t* message, uint32_t messageLength,
+                   uint8_t digest[MpTcpSha1::DIGEST_SIZE]);
+
   /**
    * \brief This function generates the token and idsn based on the passed key
    *
-   * \note This function operates in different modes depending on if the library libgcrypt
-   *   was available when running ./waf config . The result conforms to the standard when libgcrypt
-   *  is present, otherwise it relies on a simpler incompatible ns3 implementation.
-   *
    * In the case of sha1 (only one standardized), the token MUST be a truncated (most
    * significant 32 bits) SHA-1 hash according to \rfc{6824}.
    * The least significant 64 bits of the SHA-1 hash
@@ -67,6 +108,78 @@ namespace ns3
    */
   void
   GenerateTokenForKey( mptcp_crypto_alg_t alg, uint64_t key, uint32_t& token, uint64_t& idsn);
+
+  /**
+   * \brief Generates the HMAC a host sends in an MP_JOIN
+   *
+   * HMAC-A = HMAC(Key=(Key-A+Key-B), Msg=(R-A+R-B)), keys and nonces in network
+   * byte order, A being the sender (\rfc{6824} section 3.2).
+   *
+   * \param localKey Key of the sender
+   * \param peerKey Key of the receiver
+   * \param localNonce Nonce of the sender
+   * \param peerNonce Nonce of the receiver
+   * \param hmac Resulting HMAC
+   */
+  void
+  GenerateJoinHmac (uint64_t localKey, uint64_t peerKey, uint32_t localNonce, uint32_t peerNonce,
+                    uint8_t hmac[MpTcpSha1::DIGEST_SIZE]);
+
+  /**
+   * \return The most significant 64 bits of the MP_JOIN HMAC, as sent in the SYN/ACK
+   * \see GenerateJoinHmac
+   */
+  uint64_t
+  GenerateTruncatedJoinHmac (uint64_t localKey, uint64_t peerKey, uint32_t localNonce, uint32_t peerNonce);
+
+  /**
+   * \brief MPTCP keys drawn in advance along with their token and IDSN
+   *
+   * Each TcpL4Protocol owns one, so that a new connection takes its key in
+   * constant time. The keys are hashed by batches, the next batch being
+   * generated when the current one is exhausted.
+   */
+  class MpTcpKeyPool : public SimpleRefCount<MpTcpKeyPool>
+  {
+  public:
+    /**
+     * \param batchSize Number of keys hashed at once
+     */
+    MpTcpKeyPool (uint32_t batchSize);
+    ~MpTcpKeyPool ();
+
+    /**
+     * \brief Take the next key of the pool
+     */
+    void Draw (uint64_t& key, uint32_t& token, uint64_t& idsn);
+
+    /**
+     * \return A random nonce, as used by MP_JOIN
+     */
+    uint32_t DrawNonce ();
+
+    /**
+     * \return Number of keys left before the next batch
+     */
+    uint32_t GetNAvailable () const;
+
+  private:
+    MpTcpKeyPool (const MpTcpKeyPool&);
+    MpTcpKeyPool& operator= (const MpTcpKeyPool&);
+
+    void Refill ();
+
+    struct Entry
+    {
+      uint64_t key;
+      uint32_t token;
+      uint64_t idsn;
+    };
+
+    std::vector<Entry> m_entries;        //!< Current batch
+    uint32_t m_next;                     //!< Index of the next key to draw in m_entries
+    Ptr<UniformRandomVariable> m_random;  //!< Draws the keys and nonces
+  };
 }
 
 
@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "mptcp-dctcp.h"
+#include "mptcp-lia.h"
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpDctcp");
+
+namespace ns3
+{
+
+NS_OBJECT_ENSURE_REGISTERED (MpTcpDctcp);
+
+TypeId
+MpTcpDctcp::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpDctcp")
+    .SetParent<TcpDctcp> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<MpTcpDctcp> ()
+  ;
+  return tid;
+}
+
+MpTcpDctcp::MpTcpDctcp ()
+  : TcpDctcp (),
+    m_lia (CreateObject<MpTcpLia> ())
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MpTcpDctcp::MpTcpDctcp (const MpTcpDctcp& sock)
+  : TcpDctcp (sock),
+    m_lia (CreateObject<MpTcpLia> ())
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MpTcpDctcp::~MpTcpDctcp ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+std::string
+MpTcpDctcp::GetName () const
+{
+  return "MpTcpDctcp";
+}
+
+void
+MpTcpDctcp::IncreaseWindow (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked)
+{
+  NS_LOG_FUNCTION (this << tcb << segmentsAcked);
+  m_lia->IncreaseWindow (tcb, segmentsAcked);
+}
+
+Ptr<TcpCongestionOps>
+MpTcpDctcp::Fork ()
+{
+  return CopyObject<MpTcpDctcp> (this);
+}
+
+}
@@ -0,0 +1,77 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef MPTCP_CC_DCTCP_H
+#define MPTCP_CC_DCTCP_H
+
+#include "tcp-dctcp.h"
+
+namespace ns3
+{
+
+class MpTcpLia;
+
+/**
+ * \ingroup congestionOps
+ *
+ * \brief Coupled DCTCP for the MPTCP subflows
+ *
+ * Each subflow estimates the extent of the congestion on its own path and
+ * reduces its window on ECN-Echo as TcpDctcp does, while the windows of the
+ * subflows grow with the coupled increase of LIA (RFC 6356), so that the
+ * connection takes no more than a single TCP flow on a shared bottleneck.
+ *
+ * Set it as the MpTcpSocketFactory "CongestionControl" attribute, with the
+ * MpTcpMetaSocket "ForkCongestionControl" attribute so that each subflow
+ * forks its own instance.
+ */
+class MpTcpDctcp : public TcpDctcp
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  MpTcpDctcp ();
+
+  /**
+   * \brief Copy constructor
+   * \param sock the object to copy
+   */
+  MpTcpDctcp (const MpTcpDctcp& sock);
+  virtual ~MpTcpDctcp ();
+
+  virtual std::string GetName () const;
+
+  /**
+   * \brief Coupled increase of LIA
+   *
+   * \param tcb internal congestion state of the subflow
+   * \param segmentsAcked count of segments acked
+   */
+  virtual void IncreaseWindow (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked);
+
+  virtual Ptr<TcpCongestionOps> Fork ();
+
+private:
+  Ptr<MpTcpLia> m_lia;     //!< Coupled increase
+};
+
+}
+
+#endif /* MPTCP_CC_DCTCP_H */
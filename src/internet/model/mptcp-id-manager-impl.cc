@@ -188,7 +188,7 @@ MpTcpPathIdManagerImpl::GetLocalAddrId(const InetSocketAddress& address)
 {
   //TODO should be able to improve AddrId allocation to allow for more choices
   // converts Static into member function ? add a modulo in case we add too many local addr ?
-  static uint8_t addrId = 0;
+  static thread_local uint8_t addrId = 0;
   addrId++;
 
   // TODO check if it's owned by the node ? or not ?
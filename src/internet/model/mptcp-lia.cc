@@ -83,28 +83,17 @@ MpTcpLia::ComputeAlpha (Ptr<MpTcpMetaSocket> metaSock, Ptr<TcpSocketState> tcb)
   
   NS_LOG_FUNCTION(this);
   
-  double alpha = 0;
-  double maxi = 0; // Matches the MAX(cwnd_i / rtt_i^2) part
-  double sumi = 0; // SUM(cwnd_i / rtt_i)
-
-  
   NS_ASSERT (metaSock);
-  // TODO here
-  for (uint32_t i = 0; i < metaSock->GetNActiveSubflows(); i++)
-    {
-      Ptr<MpTcpSubflow> sFlow = metaSock->GetActiveSubflow(i);
+  // The meta socket keeps the sums up to date as the subflows' windows and RTTs change
+  double maxi = metaSock->GetMaxCwndOverRtt2 (); // Matches the MAX(cwnd_i / rtt_i^2) part
+  double sumi = metaSock->GetSumCwndOverRtt (); // SUM(cwnd_i / rtt_i)
 
-      Time time = sFlow->GetRttEstimator()->GetEstimate();
-      double rtt = time.GetSeconds();
-      double tmpi = tcb->m_cWnd.Get() / (rtt * rtt);
-      
-      if (maxi < tmpi)
-        maxi = tmpi;
-
-      sumi += tcb->m_cWnd.Get() / rtt;
+  if (sumi == 0)
+    {
+      // No RTT estimate yet
+      return 1;
     }
-  alpha = (metaSock->GetTotalCwnd() * maxi) / (sumi * sumi);
-  return alpha;
+  return (metaSock->GetTotalCwnd() * maxi) / (sumi * sumi);
 }
 
 void
@@ -65,9 +65,8 @@ public:
 protected:
 
   /**
-   * TODO should update m_totalCwnd as well ?
-   // TODO just return alpha and put const everywhere
-   * assume metaSock->totalCwnd is already computed
+   * Computed in constant time from the aggregates maintained by the meta socket
+   * \see MpTcpMetaSocket::GetTotalCwnd
    */
   double ComputeAlpha (Ptr<MpTcpMetaSocket> metaSock, Ptr<TcpSocketState> tcb) const;
 
@@ -23,8 +23,11 @@
 #include <set>
 #include <iterator>
 #include <algorithm>
+#include <cstdlib>
+#include <new>
 #include "ns3/mptcp-mapping.h"
 #include "ns3/simulator.h"
+#include "ns3/abort.h"
 #include "ns3/log.h"
 
 
@@ -38,7 +41,6 @@ m_dataSequenceNumber(0),
 m_subflowSequenceNumber(0),
 m_dataLevelLength(0)
 {
-  NS_LOG_FUNCTION(this);
 }
 
 MpTcpMapping::MpTcpMapping (SequenceNumber64 dataSequence,
@@ -48,14 +50,8 @@ MpTcpMapping::MpTcpMapping (SequenceNumber64 dataSequence,
   m_subflowSequenceNumber(subflowSequence),
   m_dataLevelLength(length)
 {
-  NS_LOG_FUNCTION(this);
 }
 
-MpTcpMapping::~MpTcpMapping(void)
-{
-  NS_LOG_FUNCTION(this);
-};
-
 
 void
 MpTcpMapping::SetMappingSize(uint16_t const& length)
@@ -198,10 +194,119 @@ MpTcpMapping::OverlapRangeDSN(const SequenceNumber64& headDSN, const uint16_t& l
   return true;
 }
 
+///////////////////////////////////////////////////////////
+///// MpTcpMappingPool
+/////
+MpTcpMappingPool::MpTcpMappingPool(void) :
+  m_nRequests(0),
+  m_nHeapAllocations(0)
+{
+  NS_LOG_FUNCTION(this);
+  for(size_t i = 0; i < N_SMALL_CLASSES; i++)
+  {
+    m_smallFree[i] = 0;
+  }
+}
+
+MpTcpMappingPool::~MpTcpMappingPool(void)
+{
+  NS_LOG_FUNCTION(this << m_nRequests << m_nHeapAllocations);
+  for(vector<void*>::iterator it = m_slabs.begin(); it != m_slabs.end(); ++it)
+  {
+    std::free(*it);
+  }
+  for(map<size_t, vector<void*> >::iterator it = m_largeFree.begin(); it != m_largeFree.end(); ++it)
+  {
+    for(vector<void*>::iterator block = it->second.begin(); block != it->second.end(); ++block)
+    {
+      std::free(*block);
+    }
+  }
+}
+
+void*
+MpTcpMappingPool::Allocate(size_t size)
+{
+  m_nRequests++;
+  if(size > N_SMALL_CLASSES * SMALL_GRANULARITY)
+  {
+    vector<void*>& blocks = m_largeFree[size];
+    if(!blocks.empty())
+    {
+      void* block = blocks.back();
+      blocks.pop_back();
+      return block;
+    }
+    m_nHeapAllocations++;
+    void* block = std::malloc(size);
+    NS_ABORT_MSG_UNLESS(block, "Out of memory");
+    return block;
+  }
+
+  size_t sizeClass = (size + SMALL_GRANULARITY - 1) / SMALL_GRANULARITY - 1;
+  if(!m_smallFree[sizeClass])
+  {
+    // Carve a new slab into blocks of this class
+    size_t blockSize = (sizeClass + 1) * SMALL_GRANULARITY;
+    char* slab = static_cast<char*>(std::malloc(SLAB_SIZE));
+    NS_ABORT_MSG_UNLESS(slab, "Out of memory");
+    m_nHeapAllocations++;
+    m_slabs.push_back(slab);
+    for(size_t offset = 0; offset + blockSize <= SLAB_SIZE; offset += blockSize)
+    {
+      FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + offset);
+      block->next = m_smallFree[sizeClass];
+      m_smallFree[sizeClass] = block;
+    }
+  }
+  FreeBlock* block = m_smallFree[sizeClass];
+  m_smallFree[sizeClass] = block->next;
+  return block;
+}
+
+void
+MpTcpMappingPool::Deallocate(void* block, size_t size)
+{
+  if(size > N_SMALL_CLASSES * SMALL_GRANULARITY)
+  {
+    m_largeFree[size].push_back(block);
+    return;
+  }
+  size_t sizeClass = (size + SMALL_GRANULARITY - 1) / SMALL_GRANULARITY - 1;
+  FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+  freeBlock->next = m_smallFree[sizeClass];
+  m_smallFree[sizeClass] = freeBlock;
+}
+
+uint64_t
+MpTcpMappingPool::GetNRequests(void) const
+{
+  return m_nRequests;
+}
+
+uint64_t
+MpTcpMappingPool::GetNHeapAllocations(void) const
+{
+  return m_nHeapAllocations;
+}
+
 ///////////////////////////////////////////////////////////
 ///// MpTcpMappingContainer
 /////
-MpTcpMappingContainer::MpTcpMappingContainer(void)
+NS_OBJECT_ENSURE_REGISTERED(MpTcpMappingContainer);
+
+TypeId
+MpTcpMappingContainer::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpMappingContainer")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+  ;
+  return tid;
+}
+
+MpTcpMappingContainer::MpTcpMappingContainer(void) :
+  m_pool(Create<MpTcpMappingPool>())
 {
   NS_LOG_LOGIC(this);
 }
@@ -212,39 +317,102 @@ MpTcpMappingContainer::~MpTcpMappingContainer(void)
 }
 
 void
-MpTcpMappingContainer::Dump() const
+MpTcpMappingContainer::SetPool(Ptr<MpTcpMappingPool> pool)
+{
+  NS_ASSERT(pool);
+  NS_ASSERT_MSG(GetNMappings() == 0, "Can't change the pool of a non empty container");
+  m_pool = pool;
+}
+
+Ptr<MpTcpMappingPool>
+MpTcpMappingContainer::GetPool(void) const
+{
+  return m_pool;
+}
+
+bool
+MpTcpMappingContainer::GetMappingsFromSSN(SequenceNumber32 ssn, vector<MpTcpMapping>& mappings) const
+{
+  NS_LOG_FUNCTION(this << ssn);
+  GetMappingsStartingFromSSN(ssn, mappings);
+  
+  MpTcpMapping head;
+  if(GetMappingForSSN(ssn, head) && head.HeadSSN() != ssn)
+  {
+    MpTcpMapping tail(head.GetDSNFromSSN(ssn), ssn, head.TailSSN() - ssn + 1);
+    mappings.insert(mappings.begin(), tail);
+  }
+  return !mappings.empty();
+}
+
+///////////////////////////////////////////////////////////
+///// MpTcpMappingSet
+/////
+NS_OBJECT_ENSURE_REGISTERED(MpTcpMappingSet);
+
+TypeId
+MpTcpMappingSet::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpMappingSet")
+    .SetParent<MpTcpMappingContainer> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<MpTcpMappingSet> ()
+  ;
+  return tid;
+}
+
+MpTcpMappingSet::MpTcpMappingSet(void) :
+  m_mappings(CompareMappingSsn(), MpTcpMappingPoolAllocator<MpTcpMapping>(PeekPointer(m_pool))),
+  m_reverseMappings(CompareMappingDsn(), MpTcpMappingPoolAllocator<const MpTcpMapping*>(PeekPointer(m_pool)))
+{
+  NS_LOG_LOGIC(this);
+}
+
+void
+MpTcpMappingSet::SetPool(Ptr<MpTcpMappingPool> pool)
+{
+  NS_ASSERT(m_mappings.empty());
+  // Both sets are empty, rebuild them on top of the new pool
+  m_reverseMappings = ReverseMappingSet(CompareMappingDsn(),
+                                        MpTcpMappingPoolAllocator<const MpTcpMapping*>(PeekPointer(pool)));
+  m_mappings = MappingSet(CompareMappingSsn(), MpTcpMappingPoolAllocator<MpTcpMapping>(PeekPointer(pool)));
+  MpTcpMappingContainer::SetPool(pool);
+}
+
+MpTcpMappingSet::~MpTcpMappingSet(void)
+{
+  NS_LOG_LOGIC(this);
+}
+
+void
+MpTcpMappingSet::Dump() const
 {
   NS_LOG_UNCOND("\n==== Dumping list of mappings ====");
   for(MappingSet::const_iterator it = m_mappings.begin(); it != m_mappings.end(); it++ )
   {
-    NS_LOG_UNCOND( **it );
+    NS_LOG_UNCOND( *it );
   }
   NS_LOG_UNCOND("==== End of dump ====\n");
 }
 
-Ptr<MpTcpMapping> MpTcpMappingContainer::AddMapping(const SequenceNumber64& dsn,
-                                                    const SequenceNumber32& ssn,
-                                                    uint16_t length)
+bool
+MpTcpMappingSet::AddMapping(const SequenceNumber64& dsn,
+                            const SequenceNumber32& ssn,
+                            uint16_t length)
 {
   NS_LOG_LOGIC("Adding mapping");
   NS_ASSERT(length != 0);
   
-  Ptr<MpTcpMapping> mapping = Create<MpTcpMapping>(dsn, ssn, length);
-  
-  pair<MappingSet::iterator,bool> res = m_mappings.insert(mapping);
+  pair<MappingSet::iterator,bool> res = m_mappings.insert(MpTcpMapping(dsn, ssn, length));
   
   if(res.second){
-    m_reverseMappings.insert(mapping);
-    return mapping;
-  }
-  else
-  {
-    return nullptr;
+    m_reverseMappings.insert(&*res.first);
   }
+  return res.second;
 }
 
 bool
-MpTcpMappingContainer::FirstUnmappedSSN(SequenceNumber32& ssn) const
+MpTcpMappingSet::FirstUnmappedSSN(SequenceNumber32& ssn) const
 {
   //  NS_ASSERT(m_txBuffer);
   NS_LOG_FUNCTION_NOARGS();
@@ -252,99 +420,125 @@ MpTcpMappingContainer::FirstUnmappedSSN(SequenceNumber32& ssn) const
   {
     return false;
   }
-  Ptr<MpTcpMapping> mapping = *(m_mappings.rbegin());
-  ssn = mapping->TailSSN() + 1;
+  ssn = m_mappings.rbegin()->TailSSN() + 1;
   return true;
 }
 
 
-bool
-MpTcpMappingContainer::DiscardMapping(Ptr<MpTcpMapping> mapping)
+void
+MpTcpMappingSet::DiscardMapping(MappingSet::const_iterator it)
 {
-  NS_LOG_LOGIC("discard mapping "<< mapping);
-  bool erased = m_mappings.erase(mapping);
-  m_reverseMappings.erase(mapping);
-  return erased;
+  NS_LOG_LOGIC("discard mapping "<< *it);
+  // The DSN index may refer to another mapping with the same head DSN
+  ReverseMappingSet::iterator reverse = m_reverseMappings.find(&*it);
+  if(reverse != m_reverseMappings.end() && *reverse == &*it)
+  {
+    m_reverseMappings.erase(reverse);
+  }
+  m_mappings.erase(it);
 }
 
-void MpTcpMappingContainer::DiscardMappingsInSSNRange(SequenceNumber32 ssn, uint32_t length)
+void
+MpTcpMappingSet::DiscardMappingsInSSNRange(SequenceNumber32 ssn, uint32_t length)
 {
-  Ptr<MpTcpMapping> mapping = GetMappingForSSN(ssn);
+  MappingSet::const_iterator it = LookupSSN(ssn);
   SequenceNumber32 currentSsn = ssn;
   uint32_t totalLength = 0;
-  while(mapping && (totalLength < length))
+  while(it != m_mappings.end() && (totalLength < length))
   {
-    if((currentSsn + (length - totalLength)) < mapping->TailSSN())
+    if((currentSsn + (length - totalLength)) < it->TailSSN())
     {
       break;
     }
-    DiscardMapping(mapping);
-    totalLength += mapping->GetLength();
-    currentSsn += mapping->GetLength();
-    mapping = GetMappingForSSN(currentSsn);
+    uint16_t mappingLength = it->GetLength();
+    DiscardMapping(it);
+    totalLength += mappingLength;
+    currentSsn += mappingLength;
+    it = LookupSSN(currentSsn);
   }
 }
 
 bool
-MpTcpMappingContainer::GetMappingsStartingFromSSN(SequenceNumber32 ssn, set<Ptr<MpTcpMapping>>& missing)
+MpTcpMappingSet::GetMappingsStartingFromSSN(SequenceNumber32 ssn, vector<MpTcpMapping>& missing) const
 {
   NS_LOG_FUNCTION(this << ssn );
   missing.clear();
-  //  std::copy(it,m_mappings.end(),);
   //    http://www.cplusplus.com/reference/algorithm/equal_range/
   
   
   CompareMappingSsn comp;
   MappingSet::const_iterator it = lower_bound( m_mappings.begin(), m_mappings.end(), ssn, comp);
   
-  copy(it, m_mappings.end(), inserter(missing, missing.begin()));
-  return false;
+  for(; it != m_mappings.end(); ++it)
+  {
+    missing.push_back(*it);
+  }
+  return !missing.empty();
 }
 
-Ptr<MpTcpMapping>
-MpTcpMappingContainer::GetMappingForDSN(const SequenceNumber64& dsn) const
+bool
+MpTcpMappingSet::GetMappingForDSN(const SequenceNumber64& dsn, MpTcpMapping& result) const
 {
   NS_LOG_FUNCTION(dsn);
   if(m_mappings.empty())
   {
-    return nullptr;
+    return false;
   }
   
   // Returns the first mapping that has a larger DSN
   // upper_bound returns the greater (using binary search)
   
-  Ptr<MpTcpMapping> temp = Create<MpTcpMapping>();
-  temp->SetHeadDSN(dsn);
+  MpTcpMapping temp;
+  temp.SetHeadDSN(dsn);
   
-  ReverseMappingSet::const_iterator it = m_reverseMappings.upper_bound(temp);
+  ReverseMappingSet::const_iterator it = m_reverseMappings.upper_bound(&temp);
   
   if(it == m_reverseMappings.begin())
   {
-    return nullptr;
+    return false;
   }
   
   it--;
-  Ptr<MpTcpMapping> mapping = *it;
-  NS_LOG_DEBUG("Is ssn in " << mapping << " ?");
-  if (mapping->IsSSNInRange(dsn))
+  const MpTcpMapping* mapping = *it;
+  NS_LOG_DEBUG("Is dsn in " << *mapping << " ?");
+  if (mapping->IsDSNInRange(dsn))
   {
-    return mapping;
+    result = *mapping;
+    return true;
   }
   
-  return nullptr;
+  return false;
+}
+
+bool
+MpTcpMappingSet::GetMappingForSSN(const SequenceNumber32& ssn, MpTcpMapping& result) const
+{
+  MappingSet::const_iterator it = LookupSSN(ssn);
+  if (it == m_mappings.end())
+  {
+    return false;
+  }
+  result = *it;
+  return true;
 }
 
-Ptr<MpTcpMapping>
-MpTcpMappingContainer::GetMappingForSSN(const SequenceNumber32& ssn) const
+uint32_t
+MpTcpMappingSet::GetNMappings(void) const
+{
+  return m_mappings.size();
+}
+
+MpTcpMappingSet::MappingSet::const_iterator
+MpTcpMappingSet::LookupSSN(const SequenceNumber32& ssn) const
 {
   NS_LOG_FUNCTION(ssn);
   if(m_mappings.empty())
   {
-    return nullptr;
+    return m_mappings.end();
   }
   
-  Ptr<MpTcpMapping> temp = Create<MpTcpMapping>();
-  temp->SetHeadSSN(ssn);
+  MpTcpMapping temp;
+  temp.SetHeadSSN(ssn);
   
   // Returns the first mapping that has a larger SSN
   // upper_bound returns the greater
@@ -353,19 +547,325 @@ MpTcpMappingContainer::GetMappingForSSN(const SequenceNumber32& ssn) const
   
   if(it == m_mappings.begin())
   {
-    return nullptr;
+    return m_mappings.end();
   }
   
   it--;
-  Ptr<MpTcpMapping> mapping = *it;
-  NS_LOG_DEBUG("Is ssn in " << mapping << " ?");
-  if (mapping->IsSSNInRange(ssn))
+  NS_LOG_DEBUG("Is ssn in " << *it << " ?");
+  if (it->IsSSNInRange(ssn))
   {
-    return mapping;
+    return it;
   }
   
-  return nullptr;
+  return m_mappings.end();
   
 }
+
+///////////////////////////////////////////////////////////
+///// MpTcpMappingRing
+/////
+NS_OBJECT_ENSURE_REGISTERED(MpTcpMappingRing);
+
+TypeId
+MpTcpMappingRing::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpMappingRing")
+    .SetParent<MpTcpMappingContainer> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<MpTcpMappingRing> ()
+  ;
+  return tid;
+}
+
+MpTcpMappingRing::MpTcpMappingRing(void) :
+  m_ring(0),
+  m_capacity(0),
+  m_head(0),
+  m_size(0),
+  m_dsnOrdered(true)
+{
+  NS_LOG_LOGIC(this);
+}
+
+MpTcpMappingRing::~MpTcpMappingRing(void)
+{
+  NS_LOG_LOGIC(this);
+  ReleaseStorage();
+}
+
+void
+MpTcpMappingRing::ReleaseStorage(void)
+{
+  if(m_ring)
+  {
+    // MpTcpMapping is trivially destructible
+    m_pool->Deallocate(m_ring, m_capacity * sizeof(MpTcpMapping));
+    m_ring = 0;
+    m_capacity = 0;
+  }
+}
+
+void
+MpTcpMappingRing::SetPool(Ptr<MpTcpMappingPool> pool)
+{
+  NS_ASSERT(m_size == 0);
+  ReleaseStorage();
+  m_head = 0;
+  MpTcpMappingContainer::SetPool(pool);
+}
+
+void
+MpTcpMappingRing::Dump() const
+{
+  NS_LOG_UNCOND("\n==== Dumping list of mappings ====");
+  for(uint32_t i = 0; i < m_size; i++)
+  {
+    NS_LOG_UNCOND( At(i) );
+  }
+  NS_LOG_UNCOND("==== End of dump ====\n");
+}
+
+uint32_t
+MpTcpMappingRing::UpperBoundSSN(const SequenceNumber32& ssn) const
+{
+  uint32_t first = 0;
+  uint32_t count = m_size;
+  while(count > 0)
+  {
+    uint32_t step = count / 2;
+    if(!(ssn < At(first + step).HeadSSN()))
+    {
+      first += step + 1;
+      count -= step + 1;
+    }
+    else
+    {
+      count = step;
+    }
+  }
+  return first;
+}
+
+bool
+MpTcpMappingRing::FindSSN(const SequenceNumber32& ssn, uint32_t& index) const
+{
+  uint32_t upper = UpperBoundSSN(ssn);
+  if(upper == 0)
+  {
+    return false;
+  }
+  index = upper - 1;
+  return At(index).IsSSNInRange(ssn);
+}
+
+void
+MpTcpMappingRing::Grow(void)
+{
+  uint32_t capacity = (m_capacity == 0) ? 16 : 2 * m_capacity;
+  NS_LOG_LOGIC("Growing ring to " << capacity << " mappings");
+  MpTcpMapping* ring = static_cast<MpTcpMapping*>(m_pool->Allocate(capacity * sizeof(MpTcpMapping)));
+  for(uint32_t i = 0; i < capacity; i++)
+  {
+    new (&ring[i]) MpTcpMapping(i < m_size ? At(i) : MpTcpMapping());
+  }
+  ReleaseStorage();
+  m_ring = ring;
+  m_capacity = capacity;
+  m_head = 0;
+}
+
+void
+MpTcpMappingRing::InsertAt(uint32_t index, const MpTcpMapping& mapping)
+{
+  if(m_size == m_capacity)
+  {
+    Grow();
+  }
+  uint32_t mask = m_capacity - 1;
+  if(index < m_size / 2)
+  {
+    // Cheaper to move the front one slot towards the head
+    m_head = (m_head + mask) & mask;
+    for(uint32_t i = 0; i < index; i++)
+    {
+      At(i) = At(i + 1);
+    }
+  }
+  else
+  {
+    for(uint32_t i = m_size; i > index; i--)
+    {
+      At(i) = At(i - 1);
+    }
+  }
+  At(index) = mapping;
+  m_size++;
+}
+
+void
+MpTcpMappingRing::EraseAt(uint32_t index)
+{
+  NS_ASSERT(index < m_size);
+  uint32_t mask = m_capacity - 1;
+  if(index < m_size / 2)
+  {
+    for(uint32_t i = index; i > 0; i--)
+    {
+      At(i) = At(i - 1);
+    }
+    m_head = (m_head + 1) & mask;
+  }
+  else
+  {
+    for(uint32_t i = index; i + 1 < m_size; i++)
+    {
+      At(i) = At(i + 1);
+    }
+  }
+  m_size--;
+  if(m_size == 0)
+  {
+    m_head = 0;
+    m_dsnOrdered = true;
+  }
+}
+
+bool
+MpTcpMappingRing::AddMapping(const SequenceNumber64& dsn,
+                             const SequenceNumber32& ssn,
+                             uint16_t length)
+{
+  NS_LOG_LOGIC("Adding mapping");
+  NS_ASSERT(length != 0);
+
+  // Common case: the mapping goes after the last one
+  uint32_t index = m_size;
+  if(m_size > 0 && !(At(m_size - 1).HeadSSN() < ssn))
+  {
+    index = UpperBoundSSN(ssn);
+    if(index > 0 && At(index - 1).HeadSSN() == ssn)
+    {
+      return false;
+    }
+  }
+
+  if((index > 0 && !(At(index - 1).HeadDSN() < dsn))
+     || (index < m_size && !(dsn < At(index).HeadDSN())))
+  {
+    m_dsnOrdered = false;
+  }
+
+  InsertAt(index, MpTcpMapping(dsn, ssn, length));
+  return true;
+}
+
+bool
+MpTcpMappingRing::FirstUnmappedSSN(SequenceNumber32& ssn) const
+{
+  NS_LOG_FUNCTION_NOARGS();
+  if(m_size == 0)
+  {
+    return false;
+  }
+  ssn = At(m_size - 1).TailSSN() + 1;
+  return true;
+}
+
+void
+MpTcpMappingRing::DiscardMappingsInSSNRange(SequenceNumber32 ssn, uint32_t length)
+{
+  SequenceNumber32 currentSsn = ssn;
+  uint32_t totalLength = 0;
+  uint32_t index = 0;
+  while((totalLength < length) && FindSSN(currentSsn, index))
+  {
+    const MpTcpMapping& mapping = At(index);
+    if((currentSsn + (length - totalLength)) < mapping.TailSSN())
+    {
+      break;
+    }
+    uint16_t mappingLength = mapping.GetLength();
+    NS_LOG_LOGIC("discard mapping "<< mapping);
+    EraseAt(index);
+    totalLength += mappingLength;
+    currentSsn += mappingLength;
+  }
+}
+
+bool
+MpTcpMappingRing::GetMappingsStartingFromSSN(SequenceNumber32 ssn, vector<MpTcpMapping>& mappings) const
+{
+  NS_LOG_FUNCTION(this << ssn );
+  mappings.clear();
+  uint32_t i = UpperBoundSSN(ssn);
+  if(i > 0 && At(i - 1).HeadSSN() == ssn)
+  {
+    i--;
+  }
+  for(; i < m_size; i++)
+  {
+    mappings.push_back(At(i));
+  }
+  return !mappings.empty();
+}
+
+bool
+MpTcpMappingRing::GetMappingForDSN(const SequenceNumber64& dsn, MpTcpMapping& mapping) const
+{
+  NS_LOG_FUNCTION(dsn);
+  if(!m_dsnOrdered)
+  {
+    for(uint32_t i = 0; i < m_size; i++)
+    {
+      if(At(i).IsDSNInRange(dsn))
+      {
+        mapping = At(i);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  uint32_t first = 0;
+  uint32_t count = m_size;
+  while(count > 0)
+  {
+    uint32_t step = count / 2;
+    if(!(dsn < At(first + step).HeadDSN()))
+    {
+      first += step + 1;
+      count -= step + 1;
+    }
+    else
+    {
+      count = step;
+    }
+  }
+  if(first == 0 || !At(first - 1).IsDSNInRange(dsn))
+  {
+    return false;
+  }
+  mapping = At(first - 1);
+  return true;
+}
+
+bool
+MpTcpMappingRing::GetMappingForSSN(const SequenceNumber32& ssn, MpTcpMapping& mapping) const
+{
+  NS_LOG_FUNCTION(ssn);
+  uint32_t index = 0;
+  if(!FindSSN(ssn, index))
+  {
+    return false;
+  }
+  mapping = At(index);
+  return true;
+}
+
+uint32_t
+MpTcpMappingRing::GetNMappings(void) const
+{
+  return m_size;
+}
   
 } // namespace ns3
\ No newline at end of file
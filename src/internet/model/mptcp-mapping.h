@@ -28,6 +28,7 @@
 #include <list>
 #include <set>
 #include <map>
+#include <type_traits>
 #include "ns3/object.h"
 #include "ns3/simple-ref-count.h"
 #include "ns3/sequence-number.h"
@@ -47,17 +48,18 @@ namespace ns3
    
    \todo DSN should be a uint64_t but that has implications over a lot of code,
    especially TCP buffers so it should be thought out with ns3 people beforehand
+
+   Mappings are small values: they are copied in and out of the mapping containers
+   and must stay trivially copyable (no virtual member, no user-defined destructor).
    */
   
-  class MpTcpMapping : public SimpleRefCount<MpTcpMapping>
+  class MpTcpMapping
   {
   public:
     MpTcpMapping(void);
     
     MpTcpMapping(SequenceNumber64 dataSequence, SequenceNumber32 subflowSequence, uint16_t length);
     
-    virtual ~MpTcpMapping(void);
-    
     /**
      * \brief Set subflow sequence number
      * \param headSSN
@@ -72,14 +74,14 @@ namespace ns3
     /**
      * \brief Set mapping length
      */
-    virtual void
+    void
     SetMappingSize(uint16_t const&);
     
     
-    virtual bool
+    bool
     OverlapRangeSSN(const SequenceNumber32& headSSN, const uint16_t& len) const;
     
-    virtual bool
+    bool
     OverlapRangeDSN(const SequenceNumber64& headDSN, const uint16_t& len) const;
     
     /**
@@ -126,28 +128,28 @@ namespace ns3
     /**
      * \return MPTCP sequence number for the first mapped byte
      */
-    virtual SequenceNumber64 HeadDSN() const;
+    SequenceNumber64 HeadDSN() const;
     
     // TODO rename into GetMappedSSN Head ?
     /**
      * \return subflow sequence number for the first mapped byte
      */
-    virtual SequenceNumber32 HeadSSN() const;
+    SequenceNumber32 HeadSSN() const;
     
     /**
      * \return mapping length
      */
-    virtual uint16_t GetLength() const ;
+    uint16_t GetLength() const ;
     
     /**
      * \brief Mapping are equal if everything concord, SSN/DSN and length
      */
-    virtual bool operator==( const MpTcpMapping&) const;
+    bool operator==( const MpTcpMapping&) const;
     
     /**
      * \return Not ==
      */
-    virtual bool operator!=( const MpTcpMapping& mapping) const;
+    bool operator!=( const MpTcpMapping& mapping) const;
     
     
     // TODO should be SequenceNumber64
@@ -157,6 +159,96 @@ namespace ns3
     SequenceNumber32 m_subflowSequenceNumber;  //!< subflow sequence number
     uint16_t m_dataLevelLength;  //!< mapping length / size
   };
+
+  static_assert(std::is_trivially_copyable<MpTcpMapping>::value, "MpTcpMapping must stay trivially copyable");
+
+  /**
+   * \class MpTcpMappingPool
+   * Slab allocator for the storage of the mapping containers.
+   *
+   * A pool belongs to a meta socket and is shared by the containers of all its subflows,
+   * so that the memory released by acked mappings is reused for the next ones instead
+   * of going back to the heap. Small blocks (tree nodes) are carved out of slabs,
+   * larger blocks (ring storage) are kept in per-size free lists.
+   */
+  class MpTcpMappingPool : public SimpleRefCount<MpTcpMappingPool>
+  {
+  public:
+    MpTcpMappingPool(void);
+    ~MpTcpMappingPool(void);
+
+    void* Allocate(size_t size);
+    void Deallocate(void* block, size_t size);
+
+    /**
+     * \return Number of blocks requested to the pool
+     */
+    uint64_t GetNRequests(void) const;
+
+    /**
+     * \return Number of times the pool had to call the heap allocator
+     */
+    uint64_t GetNHeapAllocations(void) const;
+
+  private:
+    MpTcpMappingPool(const MpTcpMappingPool&);
+    MpTcpMappingPool& operator=(const MpTcpMappingPool&);
+
+    static const size_t SLAB_SIZE = 4096;       //!< Size of the chunks small blocks are carved from
+    static const size_t SMALL_GRANULARITY = 8;  //!< Small block sizes are rounded to this
+    static const size_t N_SMALL_CLASSES = 16;   //!< Blocks up to 128 bytes are small
+
+    struct FreeBlock
+    {
+      FreeBlock* next;
+    };
+
+    FreeBlock* m_smallFree[N_SMALL_CLASSES];            //!< Free small blocks, per size class
+    vector<void*> m_slabs;                               //!< Slabs to release on destruction
+    map<size_t, vector<void*> > m_largeFree;            //!< Free large blocks, per size
+    uint64_t m_nRequests;
+    uint64_t m_nHeapAllocations;
+  };
+
+  /**
+   * \brief STL allocator drawing from a MpTcpMappingPool
+   */
+  template <class T>
+  class MpTcpMappingPoolAllocator
+  {
+  public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+
+    MpTcpMappingPoolAllocator(MpTcpMappingPool* pool) : m_pool(pool) {}
+
+    template <class U>
+    MpTcpMappingPoolAllocator(const MpTcpMappingPoolAllocator<U>& other) : m_pool(other.m_pool) {}
+
+    T* allocate(size_t n)
+    {
+      return static_cast<T*>(m_pool->Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+      m_pool->Deallocate(p, n * sizeof(T));
+    }
+
+    template <class U>
+    bool operator==(const MpTcpMappingPoolAllocator<U>& other) const
+    {
+      return m_pool == other.m_pool;
+    }
+
+    template <class U>
+    bool operator!=(const MpTcpMappingPoolAllocator<U>& other) const
+    {
+      return m_pool != other.m_pool;
+    }
+
+    MpTcpMappingPool* m_pool;
+  };
   
   
   
@@ -169,107 +261,234 @@ namespace ns3
    * Mapping handling
    Once a mapping has been advertised on a subflow, it must be honored. If the remote host already received the data
    (because it was sent in parallel over another subflow), then the received data must be discarded.
-   
-   For now, the map is a vector to allow for fast binary search using upper bound. We need a random access
-   iterator container, otherwise upper_bound would be linear in size of set.
-   
-   TODO: it might be best to use a
-   std::lower_bound on map
-   Could be fun implemented as an interval tree
-   http://www.geeksforgeeks.org/interval-tree/
+
+   This is the interface shared by the different storage backends, selected through
+   the "MappingContainer" attribute of MpTcpSubflow. Mappings are handed out by value
+   so that a backend is free to store them contiguously.
    */
-  class MpTcpMappingContainer
+  class MpTcpMappingContainer : public Object
   {
   public:
+    static TypeId GetTypeId (void);
+
     MpTcpMappingContainer(void);
     virtual ~MpTcpMappingContainer(void);
-    
-    
-    void DiscardMappingsInSSNRange(SequenceNumber32 ssn, uint32_t length);
-    
+
+    /**
+     * \brief Discard the mappings fully covered by [ssn, ssn+length)
+     */
+    virtual void DiscardMappingsInSSNRange(SequenceNumber32 ssn, uint32_t length) = 0;
+
     /**
      * \param firstUnmappedSsn last mapped SSN.
      * \return true if non empty
      *
      */
-    bool FirstUnmappedSSN(SequenceNumber32& firstUnmappedSsn) const;
-    
+    virtual bool FirstUnmappedSSN(SequenceNumber32& firstUnmappedSsn) const = 0;
+
     /**
      For debug purpose. Dump all registered mappings
      **/
-    virtual void Dump() const;
-    
-    Ptr<MpTcpMapping> AddMapping(const SequenceNumber64& dsn, const SequenceNumber32& ssn, uint16_t length);
-    
+    virtual void Dump() const = 0;
+
+    /**
+     * \return false if a mapping starting at the same SSN is already registered
+     */
+    virtual bool AddMapping(const SequenceNumber64& dsn, const SequenceNumber32& ssn, uint16_t length) = 0;
+
     /**
      * \param ssn The sequence number to look up
-     * \returns The corresponding mapping, or nullptr if mapping is not found
+     * \param mapping Filled with the mapping covering ssn
+     * \returns false if no mapping covers ssn
      */
-    Ptr<MpTcpMapping>
-    GetMappingForSSN(const SequenceNumber32& ssn) const;
-    
-    Ptr<MpTcpMapping>
-    GetMappingForDSN(const SequenceNumber64& dsn) const;
-    
+    virtual bool GetMappingForSSN(const SequenceNumber32& ssn, MpTcpMapping& mapping) const = 0;
+
     /**
-     * \param dsn
+     * \param dsn The data sequence number to look up
+     * \param mapping Filled with the mapping covering dsn
+     * \returns false if no mapping covers dsn
      */
-    virtual bool GetMappingsStartingFromSSN(SequenceNumber32 ssn, set<Ptr<MpTcpMapping>>& mappings);
-    
-  protected:
-    
+    virtual bool GetMappingForDSN(const SequenceNumber64& dsn, MpTcpMapping& mapping) const = 0;
+
     /**
-     When Buffers work in non renegotiable mode,
-     it should be possible to remove them one by one
-     **/
-    bool DiscardMapping(Ptr<MpTcpMapping> mapping);
-    
+     * \brief Copies, in SSN order, the mappings starting at or after ssn
+     * \return true if at least one mapping was found
+     */
+    virtual bool GetMappingsStartingFromSSN(SequenceNumber32 ssn, vector<MpTcpMapping>& mappings) const = 0;
+
+    /**
+     * \brief Copies, in SSN order, the mappings of the data from ssn onwards
+     *
+     * Unlike GetMappingsStartingFromSSN, a mapping covering ssn without starting
+     * there is included, trimmed to its part from ssn.
+     * \return true if at least one mapping was found
+     */
+    bool GetMappingsFromSSN(SequenceNumber32 ssn, vector<MpTcpMapping>& mappings) const;
+
+    /**
+     * \return Number of registered mappings
+     */
+    virtual uint32_t GetNMappings(void) const = 0;
+
+    /**
+     * \brief Draw storage from pool. Can only be called while the container is empty.
+     *
+     * Until then, the container uses a private pool.
+     */
+    virtual void SetPool(Ptr<MpTcpMappingPool> pool);
+
+    Ptr<MpTcpMappingPool> GetPool(void) const;
+
+  protected:
+    Ptr<MpTcpMappingPool> m_pool;  //!< Storage, must outlive the backend containers
+  };
+
+  /**
+   * \class MpTcpMappingSet
+   * Original backend: two trees of refcounted mappings, one ordered by SSN and one by DSN.
+   */
+  class MpTcpMappingSet : public MpTcpMappingContainer
+  {
+  public:
+    static TypeId GetTypeId (void);
+
+    MpTcpMappingSet(void);
+    virtual ~MpTcpMappingSet(void);
+
+    virtual void DiscardMappingsInSSNRange(SequenceNumber32 ssn, uint32_t length);
+    virtual bool FirstUnmappedSSN(SequenceNumber32& firstUnmappedSsn) const;
+    virtual void Dump() const;
+    virtual bool AddMapping(const SequenceNumber64& dsn, const SequenceNumber32& ssn, uint16_t length);
+    virtual bool GetMappingForSSN(const SequenceNumber32& ssn, MpTcpMapping& mapping) const;
+    virtual bool GetMappingForDSN(const SequenceNumber64& dsn, MpTcpMapping& mapping) const;
+    virtual bool GetMappingsStartingFromSSN(SequenceNumber32 ssn, vector<MpTcpMapping>& mappings) const;
+    virtual uint32_t GetNMappings(void) const;
+    virtual void SetPool(Ptr<MpTcpMappingPool> pool);
+
+  protected:
+
     class CompareMappingSsn
     {
     public:
-      bool operator()(const Ptr<MpTcpMapping> first, const Ptr<MpTcpMapping> second) const
+      bool operator()(const MpTcpMapping& first, const MpTcpMapping& second) const
       {
-        return first->HeadSSN() < second->HeadSSN();
+        return first.HeadSSN() < second.HeadSSN();
       }
-      
-      bool operator()(const SequenceNumber32& seq, const Ptr<MpTcpMapping> mapping)
+
+      bool operator()(const SequenceNumber32& seq, const MpTcpMapping& mapping)
       {
-        return seq < mapping->HeadSSN();
+        return seq < mapping.HeadSSN();
       }
-      bool operator()(const Ptr<MpTcpMapping> mapping, const SequenceNumber32& seq)
+      bool operator()(const MpTcpMapping& mapping, const SequenceNumber32& seq)
       {
-        return mapping->HeadSSN() < seq;
+        return mapping.HeadSSN() < seq;
       }
     };
-    
-    
+
+
     class CompareMappingDsn
     {
     public:
-      bool operator()(const Ptr<MpTcpMapping> first, const Ptr<MpTcpMapping> second) const
+      bool operator()(const MpTcpMapping* first, const MpTcpMapping* second) const
       {
         return first->HeadDSN() < second->HeadDSN();
       }
-      
-      bool operator()(const SequenceNumber64& seq, const Ptr<MpTcpMapping> mapping)
+
+      bool operator()(const SequenceNumber64& seq, const MpTcpMapping* mapping)
       {
         return seq < mapping->HeadDSN();
       }
-      bool operator()(const Ptr<MpTcpMapping> mapping, const SequenceNumber64& seq)
+      bool operator()(const MpTcpMapping* mapping, const SequenceNumber64& seq)
       {
         return mapping->HeadDSN() < seq;
       }
-      
+
     };
-    
-    typedef set<Ptr<MpTcpMapping>, CompareMappingSsn> MappingSet;
-    typedef set<Ptr<MpTcpMapping>, CompareMappingDsn> ReverseMappingSet;
-    
+
+    typedef set<MpTcpMapping, CompareMappingSsn, MpTcpMappingPoolAllocator<MpTcpMapping> > MappingSet;
+    //! Points into MappingSet, whose elements never move
+    typedef set<const MpTcpMapping*, CompareMappingDsn, MpTcpMappingPoolAllocator<const MpTcpMapping*> > ReverseMappingSet;
+
+    MappingSet::const_iterator LookupSSN(const SequenceNumber32& ssn) const;
+
+    /**
+     When Buffers work in non renegotiable mode,
+     it should be possible to remove them one by one
+     **/
+    void DiscardMapping(MappingSet::const_iterator it);
+
     MappingSet m_mappings;     //!< it is a set ordered by SSN
     ReverseMappingSet m_reverseMappings; //!< the DSN mapped to SSN, ordered by DSN
-    
+
   };
-  
+
+  /**
+   * \class MpTcpMappingRing
+   * Mappings stored by value in a power-of-two ring, kept sorted by SSN.
+   *
+   * Lookups are binary searches over the ring (O(log n)). Mappings are acked,
+   * and thus discarded, from the head of the ring which only moves the head
+   * index. Appending at the tail is amortized O(1); an out of order insertion
+   * shifts the shorter side of the ring.
+   *
+   * DSN lookups are binary searches as long as DSNs grow along with SSNs, which is
+   * always the case unless data is reinjected; they fall back to a linear scan otherwise.
+   */
+  class MpTcpMappingRing : public MpTcpMappingContainer
+  {
+  public:
+    static TypeId GetTypeId (void);
+
+    MpTcpMappingRing(void);
+    virtual ~MpTcpMappingRing(void);
+
+    virtual void DiscardMappingsInSSNRange(SequenceNumber32 ssn, uint32_t length);
+    virtual bool FirstUnmappedSSN(SequenceNumber32& firstUnmappedSsn) const;
+    virtual void Dump() const;
+    virtual bool AddMapping(const SequenceNumber64& dsn, const SequenceNumber32& ssn, uint16_t length);
+    virtual bool GetMappingForSSN(const SequenceNumber32& ssn, MpTcpMapping& mapping) const;
+    virtual bool GetMappingForDSN(const SequenceNumber64& dsn, MpTcpMapping& mapping) const;
+    virtual bool GetMappingsStartingFromSSN(SequenceNumber32 ssn, vector<MpTcpMapping>& mappings) const;
+    virtual uint32_t GetNMappings(void) const;
+    virtual void SetPool(Ptr<MpTcpMappingPool> pool);
+
+  protected:
+    /**
+     * \return the i-th mapping in SSN order
+     */
+    const MpTcpMapping& At(uint32_t i) const
+    {
+      return m_ring[(m_head + i) & (m_capacity - 1)];
+    }
+
+    MpTcpMapping& At(uint32_t i)
+    {
+      return m_ring[(m_head + i) & (m_capacity - 1)];
+    }
+
+    /**
+     * \return index of the first mapping whose head SSN is greater than ssn
+     */
+    uint32_t UpperBoundSSN(const SequenceNumber32& ssn) const;
+
+    /**
+     * \param index set to the index of the mapping covering ssn
+     * \return false if no mapping covers ssn
+     */
+    bool FindSSN(const SequenceNumber32& ssn, uint32_t& index) const;
+
+    void InsertAt(uint32_t index, const MpTcpMapping& mapping);
+    void EraseAt(uint32_t index);
+    void Grow(void);
+    void ReleaseStorage(void);
+
+    MpTcpMapping* m_ring;         //!< Storage allocated from m_pool
+    uint32_t m_capacity;          //!< Size of m_ring, 0 or a power of 2
+    uint32_t m_head;              //!< Position of the mapping with the lowest SSN
+    uint32_t m_size;              //!< Number of mappings stored
+    bool m_dsnOrdered;            //!< True if DSN order matches SSN order
+  };
+
   /**
    This should be a set to prevent duplication and keep it ordered
    */
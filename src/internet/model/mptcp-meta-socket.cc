@@ -148,6 +148,10 @@ void MpTcpSubflowTag::SetDestToken (uint32_t token)
 
 MpTcpMetaSocket::MpTcpMetaSocket() :  TcpSocketImpl()
                                     , m_remotePathIdManager(0)
+                                    , m_totalCwnd (0)
+                                    , m_sumCwndOverRtt (0)
+                                    , m_maxCwndOverRtt2 (0)
+                                    , m_maxCwndOverRtt2Stale (false)
                                     , m_master (0)
                                     , m_scheduler (0)
                                     , m_state (MptcpMetaClosed)
@@ -161,6 +165,7 @@ MpTcpMetaSocket::MpTcpMetaSocket() :  TcpSocketImpl()
                                     , m_tagSubflows(false)
                                     , m_subflowTypeId(MpTcpSubflow::GetTypeId ())
                                     , m_schedulerTypeId(MpTcpSchedulerRoundRobin::GetTypeId())
+                                    , m_forkCongestionControl(false)
                                     , m_rWnd(0)
                                     , m_initialCWnd(0)
                                     , m_initialSsThresh(0)
@@ -170,6 +175,18 @@ MpTcpMetaSocket::MpTcpMetaSocket() :  TcpSocketImpl()
                                     , m_nextTxSequence (0)
                                     , m_errno (ERROR_NOTERROR)
                                     , m_sendPendingDataEvent ()
+                                    , m_opportunisticReinjection (false)
+                                    , m_penalisation (false)
+                                    , m_lastBlockingDsn (0)
+                                    , m_reinjectedHigh (0)
+                                    , m_reinjectedBytes (0)
+                                    , m_penalties (0)
+                                    , m_coalesceDataAcks (false)
+                                    , m_coalescedDataAck (0)
+                                    , m_coalescedAckSubflow (0)
+                                    , m_coalescedAckArrived (false)
+                                    , m_coalescedDataAcks (0)
+                                    , m_sendPasses (0)
                                     , m_retxEvent ()
                                     , m_lastAckEvent()
                                     , m_timeWaitEvent()
@@ -181,6 +198,7 @@ MpTcpMetaSocket::MpTcpMetaSocket() :  TcpSocketImpl()
   
   //not considered as an Object
   m_remotePathIdManager = Create<MpTcpPathIdManagerImpl>();
+  m_mappingPool = Create<MpTcpMappingPool>();
   
   CreateScheduler(m_schedulerTypeId);
   
@@ -193,6 +211,10 @@ MpTcpMetaSocket::MpTcpMetaSocket() :  TcpSocketImpl()
 
 MpTcpMetaSocket::MpTcpMetaSocket(const MpTcpMetaSocket& sock) : TcpSocketImpl(sock)
                                                               , m_remotePathIdManager(0)
+                                                              , m_totalCwnd (0)
+                                                              , m_sumCwndOverRtt (0)
+                                                              , m_maxCwndOverRtt2 (0)
+                                                              , m_maxCwndOverRtt2Stale (false)
                                                               , m_master (0)
                                                               , m_scheduler (0)
                                                               , m_state(sock.m_state)
@@ -206,6 +228,7 @@ MpTcpMetaSocket::MpTcpMetaSocket(const MpTcpMetaSocket& sock) : TcpSocketImpl(so
                                                               , m_tagSubflows(sock.m_tagSubflows)
                                                               , m_subflowTypeId(sock.m_subflowTypeId)
                                                               , m_schedulerTypeId(sock.m_schedulerTypeId)
+                                                              , m_forkCongestionControl(sock.m_forkCongestionControl)
                                                               , m_rWnd(0)
                                                               , m_initialCWnd(sock.m_initialCWnd)
                                                               , m_initialSsThresh(sock.m_initialSsThresh)
@@ -220,9 +243,21 @@ MpTcpMetaSocket::MpTcpMetaSocket(const MpTcpMetaSocket& sock) : TcpSocketImpl(so
                                                               , m_subflowConnectionCreated(sock.m_subflowConnectionCreated)
                                                               , m_subflowAdded(sock.m_subflowAdded)
                                                               , m_sendPendingDataEvent ()
-                                                              , m_retxEvent ()
-                                                              , m_lastAckEvent()
-                                                              , m_timeWaitEvent()
+                                                              , m_opportunisticReinjection (sock.m_opportunisticReinjection)
+                                                              , m_penalisation (sock.m_penalisation)
+                                                              , m_lastBlockingDsn (0)
+                                                              , m_reinjectedHigh (0)
+                                                              , m_reinjectedBytes (0)
+                                                              , m_penalties (0)
+                                                              , m_coalesceDataAcks (sock.m_coalesceDataAcks)
+                                                              , m_coalescedDataAck (0)
+                                                              , m_coalescedAckSubflow (0)
+                                                              , m_coalescedAckArrived (false)
+                                                              , m_coalescedDataAcks (0)
+                                                              , m_sendPasses (0)
+                                                              , m_retxEvent (sock.m_retxEvent)
+                                                              , m_lastAckEvent (sock.m_lastAckEvent)
+                                                              , m_timeWaitEvent (sock.m_timeWaitEvent)
 {
   NS_LOG_FUNCTION(this);
   NS_LOG_LOGIC ("Invoked the copy constructor");
@@ -232,6 +267,7 @@ MpTcpMetaSocket::MpTcpMetaSocket(const MpTcpMetaSocket& sock) : TcpSocketImpl(so
   
   //! Scheduler may have some states, thus generate a new one
   m_remotePathIdManager = Create<MpTcpPathIdManagerImpl>();
+  m_mappingPool = Create<MpTcpMappingPool>();
 
 
   CreateScheduler(m_schedulerTypeId);
@@ -263,6 +299,17 @@ MpTcpMetaSocket::~MpTcpMetaSocket(void)
   m_connectionFullyEstablished = MakeNullCallback<void, Ptr<MpTcpMetaSocket>>();
   m_subflowAdded = MakeNullCallback<void, Ptr<MpTcpSubflow>, bool> ();
 }
+
+void
+MpTcpMetaSocket::SetTcp (Ptr<TcpL4Protocol> tcp)
+{
+  NS_LOG_FUNCTION (this << tcp);
+  TcpSocketImpl::SetTcp (tcp);
+  Ptr<TcpTimerWheel> wheel = tcp->GetTimerWheel ();
+  m_retxEvent.SetWheel (wheel);
+  m_lastAckEvent.SetWheel (wheel);
+  m_timeWaitEvent.SetWheel (wheel);
+}
   
 TypeId
 MpTcpMetaSocket::GetTypeId(void)
@@ -278,8 +325,14 @@ MpTcpMetaSocket::GetTypeId(void)
   .AddAttribute ("Scheduler",
                  "How to generate the mappings",
                  TypeIdValue (MpTcpSchedulerRoundRobin::GetTypeId ()),
-                 MakeTypeIdAccessor (&MpTcpMetaSocket::m_schedulerTypeId),
+                 MakeTypeIdAccessor (&MpTcpMetaSocket::SetSchedulerTypeId,
+                                     &MpTcpMetaSocket::GetSchedulerTypeId),
                  MakeTypeIdChecker ())
+  .AddAttribute ("ForkCongestionControl",
+                 "Give each subflow its own copy of the congestion control, instead of sharing the meta socket's.",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&MpTcpMetaSocket::m_forkCongestionControl),
+                 MakeBooleanChecker())
   .AddAttribute ("TxBuffer",
                  "TCP Tx buffer",
                  PointerValue (),
@@ -296,6 +349,43 @@ MpTcpMetaSocket::GetTypeId(void)
                  MakeBooleanAccessor (&MpTcpMetaSocket::SetTagSubflows,
                                       &MpTcpMetaSocket::GetTagSubflows),
                  MakeBooleanChecker())
+  .AddAttribute ("VirtualPayload",
+                 "Don't store the payload in the meta and subflow buffers, send zero-filled packets instead.",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&MpTcpMetaSocket::SetVirtualPayload,
+                                      &MpTcpMetaSocket::GetVirtualPayload),
+                 MakeBooleanChecker())
+  .AddAttribute ("OpportunisticReinjection",
+                 "When the receive window is full, send the data at its head again on a faster subflow.",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&MpTcpMetaSocket::m_opportunisticReinjection),
+                 MakeBooleanChecker())
+  .AddAttribute ("Penalisation",
+                 "Halve the window of a subflow holding the head of a full receive window, at most once per RTT.",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&MpTcpMetaSocket::m_penalisation),
+                 MakeBooleanChecker())
+  .AddAttribute ("CoalesceDataAcks",
+                 "Process the DATA_ACKs received at the same instant once, with the highest of them.",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&MpTcpMetaSocket::m_coalesceDataAcks),
+                 MakeBooleanChecker())
+  .AddTraceSource ("ReinjectedBytes",
+                   "Number of bytes sent again on another subflow than the one they were mapped on",
+                   MakeTraceSourceAccessor (&MpTcpMetaSocket::m_reinjectedBytes),
+                   "ns3::TracedValue::Uint64Callback")
+  .AddTraceSource ("Penalties",
+                   "Number of times a subflow window was halved for blocking the receive window",
+                   MakeTraceSourceAccessor (&MpTcpMetaSocket::m_penalties),
+                   "ns3::TracedValue::Uint32Callback")
+  .AddTraceSource ("CoalescedDataAcks",
+                   "Number of DATA_ACKs merged into another one received at the same instant",
+                   MakeTraceSourceAccessor (&MpTcpMetaSocket::m_coalescedDataAcks),
+                   "ns3::TracedValue::Uint32Callback")
+  .AddTraceSource ("SendPasses",
+                   "Number of passes of the scheduler over the data pending to be sent",
+                   MakeTraceSourceAccessor (&MpTcpMetaSocket::m_sendPasses),
+                   "ns3::TracedValue::Uint32Callback")
   // TODO rehabilitate
   //      .AddAttribute("Subflows", "The list of subflows associated to this protocol.",
   //          ObjectVectorValue(),
@@ -317,7 +407,55 @@ void MpTcpMetaSocket::SetTagSubflows (bool value)
 {
   m_tagSubflows = value;
 }
+
+bool MpTcpMetaSocket::GetVirtualPayload () const
+{
+  return m_txBuffer->GetVirtualPayload ();
+}
+
+void MpTcpMetaSocket::SetVirtualPayload (bool value)
+{
+  // Subflows follow the meta when they are attached, see MpTcpSubflow::SetMeta
+  m_txBuffer->SetVirtualPayload (value);
+  m_rxBuffer->SetVirtualPayload (value);
+}
+  
+uint64_t MpTcpMetaSocket::GetReinjectedBytes () const
+{
+  return m_reinjectedBytes;
+}
+
+uint32_t MpTcpMetaSocket::GetNPenalties () const
+{
+  return m_penalties;
+}
+
+uint32_t MpTcpMetaSocket::GetNCoalescedDataAcks () const
+{
+  return m_coalescedDataAcks;
+}
+
+uint32_t MpTcpMetaSocket::GetNSendPasses () const
+{
+  return m_sendPasses;
+}
   
+void
+MpTcpMetaSocket::SetSchedulerTypeId(TypeId schedulerTypeId)
+{
+  NS_LOG_FUNCTION(this << schedulerTypeId);
+  NS_ASSERT_MSG(m_subflows.empty(), "Can't change the scheduler once subflows exist");
+  // Attributes are set after the constructor created the default scheduler
+  m_schedulerTypeId = schedulerTypeId;
+  CreateScheduler(m_schedulerTypeId);
+}
+
+TypeId
+MpTcpMetaSocket::GetSchedulerTypeId() const
+{
+  return m_schedulerTypeId;
+}
+
 void
 MpTcpMetaSocket::CreateScheduler(TypeId schedulerTypeId)
 {
@@ -391,6 +529,8 @@ MpTcpMetaSocket::NewSubflowJoinRequest (Ptr<MpTcpSubflow> listenSubflow,
   
   //Copy the listening subflow to get all the correct tcp parameters set
   Ptr<MpTcpSubflow> subflow = CopyObject(listenSubflow);
+  subflow->m_peerNonce = join->GetNonce();
+  subflow->m_localNonce = m_tcp->DrawMpTcpNonce();
   subflow->SetMeta(this);
   AddSubflow (subflow, false);
   
@@ -511,7 +651,7 @@ Ptr<MpTcpSubflow>
 MpTcpMetaSocket::GetActiveSubflow(uint32_t index) const
 {
   NS_ASSERT_MSG(index < GetNActiveSubflows(), "Subflow index is out of range.");
-  return m_subflows[index];
+  return m_activeSubflows[index];
 }
 
 Ptr<MpTcpSubflow> MpTcpMetaSocket::GetMaster ()
@@ -575,6 +715,7 @@ MpTcpMetaSocket::OnSubflowClosed(Ptr<MpTcpSubflow> subflow, bool reset)
 // m_containers[Closing].erase(it);
 //NS_ASSERT(it != m_subflows[Closing].end());
   SubflowList::iterator it = remove(m_subflows.begin(), m_subflows.end(), subflow);
+  m_scheduler->RemoveSubflow(subflow);
 }
 
 void
@@ -596,11 +737,11 @@ MpTcpMetaSocket::DumpRxBuffers(Ptr<MpTcpSubflow> sf) const
 bool MpTcpMetaSocket::AddToReceiveBuffer(Ptr<MpTcpSubflow> sf,
                                          Ptr<Packet> p,
                                          const TcpHeader& tcpHeader,
-                                         Ptr<MpTcpMapping> mapping)
+                                         const MpTcpMapping& mapping)
 {
   //Add the packet to the receive buffer.
   //We shouldn't use HeadDSN, but rather the actual dsn number based on the SSN.
-  SequenceNumber64 dsn = mapping->GetDSNFromSSN(tcpHeader.GetSequenceNumber());
+  SequenceNumber64 dsn = mapping.GetDSNFromSSN(tcpHeader.GetSequenceNumber());
   if (!m_rxBuffer->Add(p, dsn))
   { // Insert failed: No data or RX buffer full
     NS_LOG_WARN("Insert failed, No data (" << p->GetSize() << ") ?");
@@ -615,7 +756,7 @@ void MpTcpMetaSocket::OnSubflowRecv(Ptr<MpTcpSubflow> sf,
                                     Ptr<Packet> p,
                                     const TcpHeader& tcpHeader,
                                     SequenceNumber64 expectedDSN,
-                                    Ptr<MpTcpMapping> mapping)
+                                    const MpTcpMapping& mapping)
 {
   NS_LOG_FUNCTION(this << "Received data from subflow=" << sf);
   
@@ -660,7 +801,8 @@ MpTcpMetaSocket::OnSubflowUpdateCwnd(Ptr<MpTcpSubflow> subflow, uint32_t oldCwnd
 
   //TODO: this was used to compute total cwnd, that is not really valid for a meta socket.
   
-  if ((newCwnd > oldCwnd) && (!m_sendPendingDataEvent.IsRunning ()))
+  //A coalesced DATA_ACK pending for this instant sends the data once processed
+  if ((newCwnd > oldCwnd) && !m_sendPendingDataEvent.IsRunning () && !m_coalescedAckEvent.IsRunning ())
   {
     m_sendPendingDataEvent = Simulator::Schedule (TimeStep (1),
                                                   &MpTcpMetaSocket::SendPendingData,
@@ -749,7 +891,7 @@ MpTcpMetaSocket::OnSubflowNewState(Ptr<MpTcpSubflow> sf,
       }
       
       //Add the subflow to the active subflows list
-      m_activeSubflows.push_back(sf);
+      AddActiveSubflow(sf);
       
       // subflow did SYN_RCVD -> ESTABLISHED
       if(oldState == SYN_RCVD)
@@ -780,7 +922,9 @@ MpTcpMetaSocket::CreateSubflow(bool masterSocket)
 {
   NS_LOG_FUNCTION (this << m_subflowTypeId.GetName());
   
-  Ptr<Socket> socket = m_tcp->CreateSocket(m_congestionControl, m_subflowTypeId);
+  // The subflows share the congestion control, unless they need their own state (e.g. DCTCP)
+  Ptr<TcpCongestionOps> congestionControl = m_forkCongestionControl ? m_congestionControl->Fork() : m_congestionControl;
+  Ptr<Socket> socket = m_tcp->CreateSocket(congestionControl, m_subflowTypeId);
   Ptr<MpTcpSubflow> subflow = DynamicCast<MpTcpSubflow>(socket);
   
   //Set the subflow parameters
@@ -850,7 +994,7 @@ MpTcpMetaSocket::AddSubflow(Ptr<MpTcpSubflow> sflow, bool isMaster)
   
   if(sflow->GetState() == ESTABLISHED)
   {
-    m_activeSubflows.push_back(sflow);
+    AddActiveSubflow(sflow);
   }
   
   if(!m_subflowAdded.IsNull())
@@ -1049,6 +1193,12 @@ SequenceNumber64 MpTcpMetaSocket::GetNextTxSequence() const
   return m_nextTxSequence;
 }
 
+Ptr<MpTcpMappingPool>
+MpTcpMetaSocket::GetMappingPool() const
+{
+  return m_mappingPool;
+}
+
 /**
  * Sending data via subflows with available window size.
  * we should not care about IsInfiniteMapping()
@@ -1064,9 +1214,13 @@ MpTcpMetaSocket::SendPendingData()
       NS_LOG_DEBUG("Nothing to send");
       return false;                           // Nothing to send
     }
+  m_sendPasses++;
   
   int nbMappingsDispatched = 0; // mimic nbPackets in TcpSocketBase::SendPendingData
   
+  //Data lost on a subflow goes before new data
+  nbMappingsDispatched += SendReinjections();
+  
   while (m_txBuffer->SizeFromSequence(m_nextTxSequence))
   {
     uint32_t dataToSend = m_txBuffer->SizeFromSequence(m_nextTxSequence);
@@ -1078,43 +1232,225 @@ MpTcpMetaSocket::SendPendingData()
       break;
     }
     
-    //Ask the scheduler for a possible subflow to send on
-    Ptr<MpTcpSubflow> subflow = m_scheduler->GetAvailableSubflow(dataToSend, metaWindow);
-    
-    if(!subflow)
+    //Ask the scheduler for a possible subflow to send on, and how much
+    MpTcpSchedulerDecision decision;
+    if(!m_scheduler->GetNextDecision(dataToSend, metaWindow, decision))
     {
       break;
     }
     
-    uint32_t length = m_scheduler->GetSendSizeForSubflow(subflow, subflow->GetSegSize(), dataToSend);
+    NS_LOG_LOGIC("Sending " << decision.budget << " bytes on subflow " << decision.subflow);
+    
+    /*
+     Ideally we should be able to send data out of order so that it arrives in order at the
+     receiver but to do that we need SACK support (IMO). Once SACK is implemented it should
+     be reasonably easy to add
+     */
+    nbMappingsDispatched += SendOnSubflow(decision.subflow, m_nextTxSequence, decision.budget);
+    m_nextTxSequence += decision.budget;
+    m_highTxMark += decision.budget;
+    
+    NS_LOG_LOGIC("m_nextTxSequence=" << m_nextTxSequence);
+  }
+  
+  //The receive window is full, check whether a slow subflow holds it back
+  uint32_t dataLeft = m_txBuffer->SizeFromSequence(m_nextTxSequence);
+  if (m_opportunisticReinjection && dataLeft > 0 && AvailableWindow() < std::min(dataLeft, m_segmentSize))
+  {
+    for (uint32_t i = 0; i < m_activeSubflows.size(); ++i)
+    {
+      QueueMissingData(m_activeSubflows[i]);
+    }
+    nbMappingsDispatched += SendReinjections();
+    nbMappingsDispatched += ReinjectBlockingData();
+  }
+  
+  //Let the scheduler send in-flight data again on idle subflows
+  MpTcpSchedulerDecision duplicate;
+  SequenceNumber64 dsn;
+  while (m_scheduler->GetDuplicateDecision(m_txBuffer->HeadSequence(), m_nextTxSequence, duplicate, dsn))
+  {
+    NS_LOG_LOGIC("Sending " << duplicate.budget << " bytes from " << dsn << " again on subflow " << duplicate.subflow);
+    nbMappingsDispatched += SendOnSubflow(duplicate.subflow, dsn, duplicate.budget);
+  }
+
+//  NS_LOG_LOGIC ("Dispatched " << nPacketsSent << " mappings");
+  return nbMappingsDispatched > 0;
+}
+
+int
+MpTcpMetaSocket::SendOnSubflow(Ptr<MpTcpSubflow> subflow, SequenceNumber64 dsn, uint32_t budget)
+{
+  uint32_t segSize = subflow->GetSegSize();
+  int nbMappings = 0;
+  
+  // With GSO, one mapping covers each super-segment
+  uint32_t mappingSize = segSize;
+  if (subflow->m_tcpParams->m_gso && segSize < subflow->m_tcpParams->m_gsoMaxSize)
+  {
+    mappingSize = subflow->m_tcpParams->m_gsoMaxSize - subflow->m_tcpParams->m_gsoMaxSize % segSize;
+  }
+  
+  while (budget > 0)
+  {
+    uint32_t length = std::min(budget, mappingSize);
     
     //Create the DSN->SSN mapping in the subflow
-    Ptr<MpTcpMapping> mapping = subflow->AddLooseMapping(m_nextTxSequence, length);
-    NS_ASSERT(mapping);
+    subflow->AddLooseMapping(dsn, length);
     
     //Send packet on subflow right away
-    Ptr<Packet> p = m_txBuffer->CopyFromSequence(length, m_nextTxSequence);
+    Ptr<Packet> p = m_txBuffer->CopyFromSequence(length, dsn);
     
     int ret = subflow->Send(p, 0);
     
     NS_LOG_DEBUG("Send result=" << ret);
     
-    /*
-     Ideally we should be able to send data out of order so that it arrives in order at the
-     receiver but to do that we need SACK support (IMO). Once SACK is implemented it should
-     be reasonably easy to add
-     */
+    dsn += length;
+    budget -= length;
+    nbMappings++;
+  }
+  return nbMappings;
+}
+
+int
+MpTcpMetaSocket::SendReinjections()
+{
+  int nbMappings = 0;
+  
+  while (!m_reinjectQueue.empty())
+  {
+    Reinjection& reinjection = m_reinjectQueue.front();
     
-    m_nextTxSequence += length;
-    m_highTxMark += length;
-    nbMappingsDispatched++;
+    //Skip what was acknowledged in the meantime
+    SequenceNumber64 head = m_txBuffer->HeadSequence();
+    if (reinjection.dsn + reinjection.length <= head)
+    {
+      m_reinjectQueue.pop_front();
+      continue;
+    }
+    if (reinjection.dsn < head)
+    {
+      reinjection.length -= head - reinjection.dsn;
+      reinjection.dsn = head;
+    }
     
-    NS_LOG_LOGIC("m_nextTxSequence=" << m_nextTxSequence);
+    MpTcpSchedulerDecision decision;
+    if (!m_scheduler->GetReinjectDecision(reinjection.subflow, reinjection.length, false, decision))
+    {
+      break;
+    }
+    NS_LOG_LOGIC("Reinjecting " << decision.budget << " bytes from " << reinjection.dsn
+                 << " on subflow " << decision.subflow);
+    nbMappings += SendOnSubflow(decision.subflow, reinjection.dsn, decision.budget);
+    m_reinjectedBytes += decision.budget;
     
+    reinjection.dsn += decision.budget;
+    reinjection.length -= decision.budget;
+    if (reinjection.length == 0)
+    {
+      m_reinjectQueue.pop_front();
+    }
   }
+  return nbMappings;
+}
 
-//  NS_LOG_LOGIC ("Dispatched " << nPacketsSent << " mappings");
-  return nbMappingsDispatched > 0;
+int
+MpTcpMetaSocket::ReinjectBlockingData()
+{
+  SequenceNumber64 head = m_txBuffer->HeadSequence();
+  if (head >= m_nextTxSequence || head == m_lastBlockingDsn)
+  {
+    return 0;
+  }
+  
+  //Find the subflow the head of the window was mapped on
+  Ptr<MpTcpSubflow> holder;
+  MpTcpMapping mapping;
+  for (uint32_t i = 0; i < m_activeSubflows.size(); ++i)
+  {
+    if (m_activeSubflows[i]->m_TxMappings->GetMappingForDSN(head, mapping))
+    {
+      holder = m_activeSubflows[i];
+      break;
+    }
+  }
+  if (!holder)
+  {
+    return 0;
+  }
+  
+  uint32_t length = mapping.TailDSN() - head + 1;
+  MpTcpSchedulerDecision decision;
+  if (!m_scheduler->GetReinjectDecision(holder, length, true, decision))
+  {
+    return 0;
+  }
+  
+  if (m_penalisation)
+  {
+    PenaliseSubflow(holder);
+  }
+  
+  NS_LOG_LOGIC("Receive window blocked by subflow " << holder << ", reinjecting "
+               << decision.budget << " bytes from " << head << " on subflow " << decision.subflow);
+  m_lastBlockingDsn = head;
+  m_reinjectedBytes += decision.budget;
+  return SendOnSubflow(decision.subflow, head, decision.budget);
+}
+
+void
+MpTcpMetaSocket::PenaliseSubflow(Ptr<MpTcpSubflow> sf)
+{
+  Time now = Simulator::Now();
+  if (now < sf->m_lastPenalty + sf->m_rtt->GetEstimate())
+  {
+    return;
+  }
+  
+  sf->ReduceWindow();
+  sf->m_lastPenalty = now;
+  m_penalties++;
+  NS_LOG_LOGIC("Penalised subflow " << sf << ", cwnd=" << sf->m_tcb->m_cWnd);
+}
+
+void
+MpTcpMetaSocket::ReinjectSubflowData(Ptr<MpTcpSubflow> sf)
+{
+  NS_LOG_FUNCTION(this << sf);
+  
+  if (QueueMissingData(sf) > 0 && !m_sendPendingDataEvent.IsRunning ())
+  {
+    m_sendPendingDataEvent = Simulator::Schedule (TimeStep (1),
+                                                  &MpTcpMetaSocket::SendPendingData,
+                                                  this);
+  }
+}
+
+uint32_t
+MpTcpMetaSocket::QueueMissingData(Ptr<MpTcpSubflow> sf)
+{
+  vector<MpTcpMapping> missing;
+  sf->GetMappedButMissingData(missing);
+  
+  uint32_t queued = 0;
+  SequenceNumber64 head = m_txBuffer->HeadSequence();
+  for (vector<MpTcpMapping>::const_iterator it = missing.begin(); it != missing.end(); ++it)
+  {
+    //Acknowledged at the connection level already, or queued before
+    SequenceNumber64 start = std::max(it->HeadDSN(), std::max(head, m_reinjectedHigh));
+    if (start > it->TailDSN())
+    {
+      continue;
+    }
+    Reinjection reinjection;
+    reinjection.dsn = start;
+    reinjection.length = it->TailDSN() - start + 1;
+    reinjection.subflow = sf;
+    m_reinjectQueue.push_back(reinjection);
+    m_reinjectedHigh = std::max(m_reinjectedHigh, it->TailDSN() + 1);
+    queued += reinjection.length;
+  }
+  return queued;
 }
 
 /**
@@ -1162,6 +1498,19 @@ MpTcpMetaSocket::OnSubflowDupAck(Ptr<MpTcpSubflow> sf)
 
 }
 
+void
+MpTcpMetaSocket::OnSubflowWindowOpened(Ptr<MpTcpSubflow> sf)
+{
+  NS_LOG_LOGIC("Window opened on subflow " << sf);
+  //A coalesced DATA_ACK pending for this instant sends the data once processed
+  if (!m_sendPendingDataEvent.IsRunning () && !m_coalescedAckEvent.IsRunning ())
+  {
+    m_sendPendingDataEvent = Simulator::Schedule (TimeStep (1),
+                                                  &MpTcpMetaSocket::SendPendingData,
+                                                  this);
+  }
+}
+
 /**
 Retransmit timeout
 
@@ -1271,7 +1620,7 @@ MpTcpMetaSocket::SendDataFin(bool withAck)
     NS_LOG_LOGIC ("Schedule retransmission timeout at time "
                   << Simulator::Now ().GetSeconds () << " to expire at time "
                   << (Simulator::Now () + subflow->m_rto.Get ()).GetSeconds ());
-    m_retxEvent = Simulator::Schedule (subflow->m_rto, &MpTcpMetaSocket::SendDataFin, this, withAck);
+    m_retxEvent.Schedule (subflow->m_rto, &MpTcpMetaSocket::SendDataFin, this, withAck);
   }
 }
 
@@ -1302,14 +1651,10 @@ MpTcpMetaSocket::GenerateUniqueMpTcpKey()
   
   uint64_t idsn;
   
-  Ptr<UniformRandomVariable> uniformVar = CreateObject<UniformRandomVariable>() ;
-  uniformVar->SetAttribute("Min", DoubleValue(1));
-  uniformVar->SetAttribute("Max", DoubleValue(numeric_limits<uint64_t>::max()));
-  
+  //The pool hands out keys already hashed; only token collisions need a retry
   do
   {
-    m_localKey = uniformVar->GetValue();
-    GenerateTokenForKey(HMAC_SHA1, m_localKey, m_localToken, idsn);
+    m_tcp->DrawMpTcpKey(m_localKey, m_localToken, idsn);
   }
   while(m_tcp->LookupMpTcpToken(m_localToken));
   
@@ -1493,7 +1838,7 @@ MpTcpMetaSocket::OnSubflowClosing(Ptr<MpTcpSubflow> sf)
 
 
 void
-MpTcpMetaSocket::OnSubflowDupack(Ptr<MpTcpSubflow> sf, MpTcpMapping mapping)
+MpTcpMetaSocket::OnSubflowDupack(Ptr<MpTcpSubflow> sf, const MpTcpMapping& mapping)
 {
   NS_LOG_LOGIC("Subflow Dupack TODO.Nothing done by meta");
 }
@@ -1534,22 +1879,111 @@ uint32_t MpTcpMetaSocket::GetRwndSize ()
 
 uint32_t MpTcpMetaSocket::GetTotalCwnd ()
 {
-  uint32_t totalCwnd = 0;
-  for (SubflowList::iterator it = m_activeSubflows.begin(); it != m_activeSubflows.end(); ++it)
+  return m_totalCwnd;
+}
+
+double MpTcpMetaSocket::GetSumCwndOverRtt ()
+{
+  return m_sumCwndOverRtt;
+}
+
+double MpTcpMetaSocket::GetMaxCwndOverRtt2 ()
+{
+  if (m_maxCwndOverRtt2Stale)
   {
-    Ptr<MpTcpSubflow> subflow = (*it);
-    // when in fast recovery, use SS threshold instead of cwnd
-    if(subflow->m_tcb->m_congState == TcpSocketState::CA_RECOVERY)
-    {
-      NS_LOG_DEBUG("Is in Fast recovery");
-      totalCwnd += subflow->m_tcb->m_ssThresh;
-    }
-    else
+    m_maxCwndOverRtt2 = 0;
+    for (uint32_t i = 0; i < m_ccRateOverRtt.size(); ++i)
     {
-      totalCwnd += subflow->m_tcb->m_cWnd;
+      m_maxCwndOverRtt2 = std::max(m_maxCwndOverRtt2, m_ccRateOverRtt[i]);
     }
+    m_maxCwndOverRtt2Stale = false;
+  }
+  return m_maxCwndOverRtt2;
+}
+
+void
+MpTcpMetaSocket::AddActiveSubflow(Ptr<MpTcpSubflow> sf)
+{
+  NS_LOG_FUNCTION(this << sf);
+  uint32_t i = GetNActiveSubflows();
+  m_activeSubflows.push_back(sf);
+  m_scheduler->AddSubflow(sf);
+
+  m_ccWnd.push_back(0);
+  m_ccRate.push_back(0);
+  m_ccRateOverRtt.push_back(0);
+  UpdateCoupledAggregates(i, sf->m_tcb->m_cWnd, sf->m_tcb->m_ssThresh, sf->m_tcb->m_congState);
+
+  bool ok;
+  ok = sf->m_tcb->TraceConnectWithoutContext("CongestionWindow",
+                                             MakeCallback(&MpTcpMetaSocket::SubflowCwndChanged, this).Bind(i));
+  NS_ASSERT(ok);
+  ok = sf->m_tcb->TraceConnectWithoutContext("SlowStartThreshold",
+                                             MakeCallback(&MpTcpMetaSocket::SubflowSsThreshChanged, this).Bind(i));
+  NS_ASSERT(ok);
+  ok = sf->m_tcb->TraceConnectWithoutContext("CongState",
+                                             MakeCallback(&MpTcpMetaSocket::SubflowCongStateChanged, this).Bind(i));
+  NS_ASSERT(ok);
+  ok = sf->TraceConnectWithoutContext("RTT", MakeCallback(&MpTcpMetaSocket::SubflowRttChanged, this).Bind(i));
+  NS_ASSERT(ok);
+}
+
+void
+MpTcpMetaSocket::UpdateCoupledAggregates(uint32_t i, uint32_t cwnd, uint32_t ssThresh,
+                                         TcpSocketState::TcpCongState_t congState)
+{
+  // when in fast recovery, use SS threshold instead of cwnd
+  uint32_t wnd = (congState == TcpSocketState::CA_RECOVERY) ? ssThresh : cwnd;
+  double rtt = m_activeSubflows[i]->m_rtt->GetEstimate().GetSeconds();
+  double rate = (rtt > 0) ? cwnd / rtt : 0;
+  double rateOverRtt = (rtt > 0) ? rate / rtt : 0;
+
+  m_totalCwnd += wnd - m_ccWnd[i];
+  m_sumCwndOverRtt += rate - m_ccRate[i];
+  if (rateOverRtt >= m_maxCwndOverRtt2)
+  {
+    // Even a stale max is an upper bound of the other subflows' values
+    m_maxCwndOverRtt2 = rateOverRtt;
+    m_maxCwndOverRtt2Stale = false;
+  }
+  else if (m_ccRateOverRtt[i] >= m_maxCwndOverRtt2)
+  {
+    // The subflow may have held the max, recompute it on the next read
+    m_maxCwndOverRtt2Stale = true;
   }
-  return totalCwnd;
+  m_ccWnd[i] = wnd;
+  m_ccRate[i] = rate;
+  m_ccRateOverRtt[i] = rateOverRtt;
+}
+
+// The traced values are only updated once their callbacks return
+void
+MpTcpMetaSocket::SubflowCwndChanged(uint32_t i, uint32_t oldValue, uint32_t newValue)
+{
+  Ptr<TcpSocketState> tcb = m_activeSubflows[i]->m_tcb;
+  UpdateCoupledAggregates(i, newValue, tcb->m_ssThresh, tcb->m_congState);
+}
+
+void
+MpTcpMetaSocket::SubflowSsThreshChanged(uint32_t i, uint32_t oldValue, uint32_t newValue)
+{
+  Ptr<TcpSocketState> tcb = m_activeSubflows[i]->m_tcb;
+  UpdateCoupledAggregates(i, tcb->m_cWnd, newValue, tcb->m_congState);
+}
+
+void
+MpTcpMetaSocket::SubflowCongStateChanged(uint32_t i, TcpSocketState::TcpCongState_t oldValue,
+                                         TcpSocketState::TcpCongState_t newValue)
+{
+  Ptr<TcpSocketState> tcb = m_activeSubflows[i]->m_tcb;
+  UpdateCoupledAggregates(i, tcb->m_cWnd, tcb->m_ssThresh, newValue);
+}
+
+void
+MpTcpMetaSocket::SubflowRttChanged(uint32_t i, Time oldValue, Time newValue)
+{
+  Ptr<TcpSocketState> tcb = m_activeSubflows[i]->m_tcb;
+  UpdateCoupledAggregates(i, tcb->m_cWnd, tcb->m_ssThresh, tcb->m_congState);
 }
 
 uint32_t
@@ -1601,6 +2035,53 @@ MpTcpMetaSocket::ReceivedAck(Ptr<MpTcpSubflow> sf, const SequenceNumber64& dack)
     return;
   }
   
+  if (!m_coalesceDataAcks)
+  {
+    ProcessDataAck(sf, dack);
+    return;
+  }
+  
+  //Only the highest DATA_ACK of this instant is processed, once the others arrived
+  m_coalescedAckArrived = true;
+  if (m_coalescedAckEvent.IsRunning())
+  {
+    m_coalescedDataAcks++;
+    if (dack > m_coalescedDataAck)
+    {
+      m_coalescedDataAck = dack;
+      m_coalescedAckSubflow = sf;
+    }
+    return;
+  }
+  m_coalescedDataAck = dack;
+  m_coalescedAckSubflow = sf;
+  m_coalescedAckEvent = Simulator::ScheduleNow(&MpTcpMetaSocket::ProcessCoalescedDataAck, this);
+}
+
+void
+MpTcpMetaSocket::ProcessCoalescedDataAck()
+{
+  NS_LOG_FUNCTION(this << m_coalescedDataAck);
+  // ScheduleNow runs after the events already queued for this instant, but
+  // before those they queue in turn, which may bring more DATA_ACKs: wait
+  // for a round of them without any
+  if (m_coalescedAckArrived)
+  {
+    m_coalescedAckArrived = false;
+    m_coalescedAckEvent = Simulator::ScheduleNow(&MpTcpMetaSocket::ProcessCoalescedDataAck, this);
+    return;
+  }
+  Ptr<MpTcpSubflow> sf = m_coalescedAckSubflow;
+  m_coalescedAckSubflow = 0;
+  ProcessDataAck(sf, m_coalescedDataAck);
+  //Windows that grew before the DATA_ACKs were all in are filled by this pass
+  m_sendPendingDataEvent.Cancel ();
+  SendPendingData();
+}
+
+void
+MpTcpMetaSocket::ProcessDataAck(Ptr<MpTcpSubflow> sf, const SequenceNumber64& dack)
+{
   SequenceNumber64 firstUnacked = m_txBuffer->HeadSequence();
   if (dack < firstUnacked)
   { // Case 1: Old ACK, ignored.
@@ -1655,7 +2136,7 @@ MpTcpMetaSocket::TimeWait()
   CancelAllEvents();
 //  // Move from TIME_WAIT to CLOSED after 2*MSL. Max segment lifetime is 2 min
 //  // according to RFC793, p.28
-  m_timeWaitEvent = Simulator::Schedule(duration, &MpTcpMetaSocket::CloseAndNotify, this);
+  m_timeWaitEvent.Schedule (duration, &MpTcpMetaSocket::CloseAndNotify, this);
 }
 
 void
@@ -1797,7 +2278,7 @@ MpTcpMetaSocket::DoPeerClose(Ptr<MpTcpSubflow> sf)
   {
     NS_LOG_LOGIC ("TcpSocketBase " << this << " scheduling Last Ack Timeout");
     Time lastRto = sf->ComputeRTO();
-    m_lastAckEvent = Simulator::Schedule (lastRto, &MpTcpMetaSocket::LastAckTimeout, this);
+    m_lastAckEvent.Schedule (lastRto, &MpTcpMetaSocket::LastAckTimeout, this);
   }
 }
 
@@ -1896,10 +2377,10 @@ MpTcpMetaSocket::CloseAllSubflows()
   
 bool MpTcpMetaSocket::CheckAndAppendDataFin (Ptr<MpTcpSubflow> subflow,
                                              SequenceNumber32 ssn,
-                                             uint32_t length, Ptr<MpTcpMapping> mapping)
+                                             uint32_t length, const MpTcpMapping& mapping)
 {
   //Map the ssn to a dsn
-  SequenceNumber64 dsn = mapping->GetDSNFromSSN(ssn);
+  SequenceNumber64 dsn = mapping.GetDSNFromSSN(ssn);
   //If we have no remaining data to send, set the DATA_FIN flag
   uint32_t remainingData = m_txBuffer->SizeFromSequence(dsn + length);
   if (m_tcpParams->m_closeOnEmpty && (remainingData == 0))
@@ -1955,6 +2436,7 @@ MpTcpMetaSocket::CancelAllEvents ()
   m_lastAckEvent.Cancel ();
   m_timeWaitEvent.Cancel ();
   m_sendPendingDataEvent.Cancel ();
+  m_coalescedAckEvent.Cancel ();
 }
 
 /* Below are the attribute get/set functions */
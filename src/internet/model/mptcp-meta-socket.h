@@ -23,6 +23,7 @@
 #ifndef MPTCP_SOCKET_BASE_H
 #define MPTCP_SOCKET_BASE_H
 
+#include <deque>
 #include "ns3/callback.h"
 #include "mptcp-mapping.h"
 #include "tcp-socket-impl.h"
@@ -118,6 +119,12 @@ public:
   MpTcpMetaSocket(const MpTcpMetaSocket& sock);
   
   virtual ~MpTcpMetaSocket();
+
+  /**
+   * \brief Associate the L4 protocol, and run the timers with its timer wheel
+   * \param tcp the L4 protocol
+   */
+  virtual void SetTcp (Ptr<TcpL4Protocol> tcp) override;
   
   typedef enum {
     MptcpMetaClosed = 0,      /**< Socket is closed  */
@@ -153,6 +160,34 @@ public:
   
   bool GetTagSubflows () const;
   void SetTagSubflows (bool value);
+
+  /*
+   * Whether the meta and subflow buffers only track byte counts and sequence
+   * ranges, the packets being zero-filled
+   */
+
+  bool GetVirtualPayload () const;
+  void SetVirtualPayload (bool value);
+
+  /**
+   * \return Number of bytes sent again on another subflow than the one they were mapped on
+   */
+  uint64_t GetReinjectedBytes () const;
+
+  /**
+   * \return Number of times the window of a subflow was halved for blocking the receive window
+   */
+  uint32_t GetNPenalties () const;
+
+  /**
+   * \return Number of DATA_ACKs merged into another one received at the same instant
+   */
+  uint32_t GetNCoalescedDataAcks () const;
+
+  /**
+   * \return Number of passes of the scheduler over the data pending to be sent
+   */
+  uint32_t GetNSendPasses () const;
   
   /*********************************************
    * Interface methods inherited from Socket
@@ -188,6 +223,11 @@ public:
   virtual uint32_t GetRxAvailable(void) const override;
   
   virtual SequenceNumber64 GetNextTxSequence() const;
+
+  /**
+   * \return Pool the mappings of all the subflows are allocated from
+   */
+  Ptr<MpTcpMappingPool> GetMappingPool() const;
   
   /** Inherit from Socket class: Return data to upper-layer application. Parameter flags
    is not used. Data is returned as a packet of size no larger than maxSize */
@@ -286,6 +326,23 @@ public:
   
   // MPTCP specfic version
   virtual void ReceivedAck (Ptr<MpTcpSubflow> sf, const SequenceNumber64& dack);
+
+  /**
+   * \brief Update the connection state with a DATA_ACK
+   *
+   * Called by ReceivedAck, or with the highest DATA_ACK of the instant when they
+   * are coalesced.
+   */
+  void ProcessDataAck (Ptr<MpTcpSubflow> sf, const SequenceNumber64& dack);
+
+  /**
+   * \brief Process the DATA_ACK coalesced during the instant, then send what its window allows
+   *
+   * Reschedules itself at the same instant as long as DATA_ACKs arrived since it
+   * was last scheduled, so that those carried by events queued later at this
+   * instant are merged too.
+   */
+  void ProcessCoalescedDataAck ();
   
   /**
    We need to update the connection level receive buffer on receiving new data,
@@ -295,12 +352,12 @@ public:
                              Ptr<Packet> p,
                              const TcpHeader& tcpHeader,
                              SequenceNumber64 expectedDSN,
-                             Ptr<MpTcpMapping> mapping);
+                             const MpTcpMapping& mapping);
   
   virtual bool AddToReceiveBuffer(Ptr<MpTcpSubflow> sf,
                                   Ptr<Packet> p,
                                   const TcpHeader& tcpHeader,
-                                  Ptr<MpTcpMapping> mapping);
+                                  const MpTcpMapping& mapping);
   
   /***************************************
    * Subflow Callbacks
@@ -395,6 +452,20 @@ public:
   virtual uint32_t GetRwndSize ();
   virtual uint32_t UnAckDataCount ();
   virtual uint32_t GetTotalCwnd ();
+
+  /**
+   * \return Sum over the active subflows of cwnd_i / rtt_i, in bytes per second
+   *
+   * Subflows without RTT estimate yet are left out. Maintained as the subflows'
+   * windows and RTTs change, like GetTotalCwnd, so coupled congestion controls
+   * can read it on every ACK.
+   */
+  double GetSumCwndOverRtt ();
+
+  /**
+   * \return Max over the active subflows of cwnd_i / rtt_i^2
+   */
+  double GetMaxCwndOverRtt2 ();
   
   virtual void PersistTimeout();
   
@@ -479,7 +550,7 @@ protected: // protected methods
   //close on empty is enabled
   //Changes the state
   virtual bool CheckAndAppendDataFin (Ptr<MpTcpSubflow> subflow, SequenceNumber32 ssn,
-                                      uint32_t length, Ptr<MpTcpMapping> mapping);
+                                      uint32_t length, const MpTcpMapping& mapping);
   
   /**
    * Should be called after having receiving a Data ACK in response to a sent DataFIN
@@ -510,6 +581,25 @@ protected: // protected methods
    * Add subflow to the subflows list, and register trace functions
    */
   virtual void AddSubflow(Ptr<MpTcpSubflow> sf,  bool isMaster);
+
+  /**
+   * Add an established subflow to the active subflows, the scheduler and the
+   * coupled congestion control aggregates
+   */
+  void AddActiveSubflow(Ptr<MpTcpSubflow> sf);
+
+  /**
+   * Replace the contribution of active subflow i to the coupled congestion
+   * control aggregates with the given window state and its current RTT
+   */
+  void UpdateCoupledAggregates(uint32_t i, uint32_t cwnd, uint32_t ssThresh,
+                               TcpSocketState::TcpCongState_t congState);
+
+  void SubflowCwndChanged(uint32_t i, uint32_t oldValue, uint32_t newValue);
+  void SubflowSsThreshChanged(uint32_t i, uint32_t oldValue, uint32_t newValue);
+  void SubflowCongStateChanged(uint32_t i, TcpSocketState::TcpCongState_t oldValue,
+                               TcpSocketState::TcpCongState_t newValue);
+  void SubflowRttChanged(uint32_t i, Time oldValue, Time newValue);
   
   /*
    Remove subflow from containers
@@ -520,6 +610,12 @@ protected: // protected methods
   void OnSubflowClosed(Ptr<MpTcpSubflow> sf, bool reset);
   
   void OnSubflowDupAck(Ptr<MpTcpSubflow> sf);
+
+  /**
+   Called when acks free room in the window of a subflow without growing
+   its congestion window, e.g. after an ECN-Echo or a loss
+   */
+  void OnSubflowWindowOpened(Ptr<MpTcpSubflow> sf);
   
   /**
    Called when a subflow that initiated the connection
@@ -557,9 +653,18 @@ protected: // protected methods
    * @param mapping
    add count param ?
    */
-  virtual void OnSubflowDupack(Ptr<MpTcpSubflow> sf, MpTcpMapping mapping);
+  virtual void OnSubflowDupack(Ptr<MpTcpSubflow> sf, const MpTcpMapping& mapping);
   
   virtual void OnSubflowRetransmit(Ptr<MpTcpSubflow> sf);
+
+  /**
+   * \brief Queue the data mapped on a subflow but missing from its send buffer
+   * to be sent on the other subflows
+   *
+   * Called upon a retransmission timeout of the subflow. SendPendingData does
+   * the same for all the subflows when the receive window is blocked.
+   */
+  virtual void ReinjectSubflowData(Ptr<MpTcpSubflow> sf);
   
   /****************************
    * Notify upper layer callbacks
@@ -627,6 +732,41 @@ protected: // protected methods
    */
   virtual bool SendPendingData();
   
+  /**
+   * \brief Map budget bytes of the send buffer from dsn onto subflow and send them,
+   * in segments of the subflow's size
+   * \return Number of mappings created
+   */
+  int SendOnSubflow(Ptr<MpTcpSubflow> subflow, SequenceNumber64 dsn, uint32_t budget);
+
+  /**
+   * \brief Queue the mappings returned by MpTcpSubflow::GetMappedButMissingData,
+   * less what was acknowledged or queued before
+   * \return Number of bytes queued
+   */
+  uint32_t QueueMissingData(Ptr<MpTcpSubflow> sf);
+
+  /**
+   * \brief Send the queued reinjections on the subflows that can take them
+   * \return Number of mappings created
+   */
+  int SendReinjections();
+
+  /**
+   * \brief Opportunistic retransmission, when the receive window is full
+   *
+   * If the data at the head of the window is in flight on a subflow slower than
+   * another one with room in its window, sends it again on the faster subflow and
+   * penalises the slow subflow.
+   * \return Number of mappings created
+   */
+  int ReinjectBlockingData();
+
+  /**
+   * \brief Halve the window of a subflow holding back the receive window, at most once per RTT
+   */
+  void PenaliseSubflow(Ptr<MpTcpSubflow> sf);
+  
   
   virtual void ReTxTimeout();
 
@@ -660,6 +800,12 @@ protected: // protected methods
   //  virtual void OnRemAddress();
   
   virtual void CreateScheduler(TypeId schedulerTypeId);
+
+  /**
+   * \brief Replace the scheduler, only possible before any subflow is created
+   */
+  void SetSchedulerTypeId(TypeId schedulerTypeId);
+  TypeId GetSchedulerTypeId() const;
   
   /**
    * Generate a unique key for this host
@@ -694,6 +840,15 @@ protected: // protected methods
   
   SubflowList m_subflows;
   SubflowList m_activeSubflows; //Keep track of all the established subflows
+
+  // Coupled congestion control aggregates, per active subflow then summed up
+  vector<uint32_t> m_ccWnd;          //!< Window counted in the total: ssthresh in fast recovery, cwnd otherwise
+  vector<double> m_ccRate;           //!< cwnd_i / rtt_i, 0 without RTT estimate
+  vector<double> m_ccRateOverRtt;    //!< cwnd_i / rtt_i^2, 0 without RTT estimate
+  uint32_t m_totalCwnd;              //!< Sum of m_ccWnd
+  double m_sumCwndOverRtt;           //!< Sum of m_ccRate
+  double m_maxCwndOverRtt2;          //!< Max of m_ccRateOverRtt, valid unless m_maxCwndOverRtt2Stale
+  bool m_maxCwndOverRtt2Stale;       //!< Whether the subflow holding the max decreased
   
   Ptr<MpTcpSubflow> m_master;
   
@@ -703,6 +858,8 @@ protected: // protected methods
   
   
   Ptr<MpTcpScheduler> m_scheduler;  //!<
+
+  Ptr<MpTcpMappingPool> m_mappingPool;  //!< Shared by the subflows' mapping containers
   
   MpTcpMetaSocketState m_state;
   
@@ -720,6 +877,7 @@ protected: // protected methods
   //!
   TypeId m_subflowTypeId;
   TypeId m_schedulerTypeId;
+  bool   m_forkCongestionControl;  //!< Whether each subflow gets its own copy of the congestion control
   
   TracedValue<uint32_t>   m_rWnd;        //!< Receiver window (RCV.WND in RFC793)
   uint32_t                m_initialCWnd;     //!< Initial cWnd value
@@ -730,9 +888,34 @@ protected: // protected methods
   TracedValue<SequenceNumber64> m_nextTxSequence; //!< Next seqnum to be sent (SND.NXT), ReTx pushes it back
   mutable enum SocketErrno m_errno;         //!< Socket error code
   EventId m_sendPendingDataEvent; //!< micro-delay event to send pending data
-  EventId           m_retxEvent;       //!< Retransmission event
-  EventId           m_lastAckEvent;
-  EventId           m_timeWaitEvent;
+
+  /**
+   * Data to send again on another subflow than the one it was mapped on
+   */
+  struct Reinjection
+  {
+    SequenceNumber64 dsn;        //!< First data sequence number
+    uint32_t length;             //!< Number of bytes
+    Ptr<MpTcpSubflow> subflow;   //!< Subflow the data was mapped on
+  };
+  std::deque<Reinjection> m_reinjectQueue;  //!< Reinjections waiting for a subflow
+  bool m_opportunisticReinjection;          //!< Whether to reinject the data blocking the receive window
+  bool m_penalisation;                      //!< Whether to penalise the subflows blocking the receive window
+  SequenceNumber64 m_lastBlockingDsn;       //!< Last data sequence number reinjected opportunistically
+  SequenceNumber64 m_reinjectedHigh;        //!< End of the data queued for reinjection
+  TracedValue<uint64_t> m_reinjectedBytes;  //!< Number of bytes reinjected
+  TracedValue<uint32_t> m_penalties;        //!< Number of penalties applied
+
+  bool m_coalesceDataAcks;                    //!< Whether to process the DATA_ACKs of an instant once
+  SequenceNumber64 m_coalescedDataAck;        //!< Highest DATA_ACK of the instant
+  Ptr<MpTcpSubflow> m_coalescedAckSubflow;    //!< Subflow it was received on
+  bool m_coalescedAckArrived;                 //!< Whether a DATA_ACK arrived since the processing was scheduled
+  EventId m_coalescedAckEvent;                //!< Processing of the coalesced DATA_ACK
+  TracedValue<uint32_t> m_coalescedDataAcks;  //!< Number of DATA_ACKs merged into another one
+  TracedValue<uint32_t> m_sendPasses;         //!< Number of SendPendingData passes with data to send
+  TcpTimer          m_retxEvent;       //!< Retransmission event
+  TcpTimer          m_lastAckEvent;
+  TcpTimer          m_timeWaitEvent;
   
   //Inherited from TcpSocket, setting the TCP parameters
   
@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#include "ns3/mptcp-scheduler-blest.h"
+#include "ns3/mptcp-subflow.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("MpTcpSchedulerBlest");
+NS_OBJECT_ENSURE_REGISTERED(MpTcpSchedulerBlest);
+
+TypeId
+MpTcpSchedulerBlest::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpSchedulerBlest")
+    .SetParent<MpTcpSchedulerFastestRTT> ()
+    .AddConstructor<MpTcpSchedulerBlest> ()
+    .AddAttribute ("Lambda",
+                   "Scaling of the number of bytes the fastest subflow is expected to send "
+                   "during one RTT of a slower subflow",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&MpTcpSchedulerBlest::m_lambda),
+                   MakeDoubleChecker<double> (0))
+  ;
+  return tid;
+}
+
+MpTcpSchedulerBlest::MpTcpSchedulerBlest() :
+  MpTcpSchedulerFastestRTT(),
+  m_lambda(1.0)
+{
+  NS_LOG_FUNCTION(this);
+}
+
+MpTcpSchedulerBlest::~MpTcpSchedulerBlest (void)
+{
+  NS_LOG_FUNCTION(this);
+}
+
+bool MpTcpSchedulerBlest::CanUseSlowSubflow (uint32_t fast, uint32_t slow) const
+{
+  // Number of RTTs of the fast subflow during one RTT of the slow one, rounded up
+  int64_t fastRtt = m_rtt[fast].GetNanoSeconds();
+  uint64_t rounds = (fastRtt > 0) ? (m_rtt[slow].GetNanoSeconds() / fastRtt) + 1 : 1;
+  
+  // Segments sent by the fast subflow meanwhile, its window growing by one segment per RTT
+  double segments = (static_cast<double>(m_cwnd[fast]) / GetSegSize(fast) + (rounds - 1) / 2.0) * rounds;
+  double fastBytes = m_lambda * segments * GetSegSize(fast);
+  
+  // Room left in the meta window once the slow subflow has sent one more segment
+  uint32_t slowBytes = GetSegSize(slow) + (m_nextTx[slow] - m_unacked[slow]);
+  uint32_t space = (m_metaRwnd > slowBytes) ? (m_metaRwnd - slowBytes) : 0;
+  
+  NS_LOG_LOGIC("fast subflow expected to send " << fastBytes << " bytes, space left " << space);
+  return fastBytes <= space;
+}
+
+Ptr<MpTcpSubflow> MpTcpSchedulerBlest::GetAvailableSubflow (uint32_t dataToSend, uint32_t metaWindow)
+{
+  MpTcpSchedulerDecision decision;
+  return GetNextDecision(dataToSend, metaWindow, decision) ? decision.subflow : nullptr;
+}
+
+bool MpTcpSchedulerBlest::GetNextDecision (uint32_t dataToSend, uint32_t metaWindow, MpTcpSchedulerDecision& decision)
+{
+  uint32_t i = SelectSubflow(dataToSend, metaWindow);
+  if (i == GetNSubflows())
+  {
+    return false;
+  }
+  
+  decision.subflow = m_subflows[i];
+  decision.budget = GetBudget(i, dataToSend, metaWindow);
+  
+  uint32_t fastest = GetFastestSubflow();
+  if (fastest != i)
+  {
+    if (!CanUseSlowSubflow(fastest, i))
+    {
+      NS_LOG_LOGIC("Waiting for subflow " << fastest << " rather than blocking on subflow " << i);
+      return false;
+    }
+    // The fast subflow could get room at any ack, decide again after each segment
+    decision.budget = std::min(decision.budget, GetSegSize(i));
+  }
+  return true;
+}
+
+} // namespace ns3
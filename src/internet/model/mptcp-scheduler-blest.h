@@ -0,0 +1,65 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef MPTCP_SCHEDULER_BLEST_H
+#define MPTCP_SCHEDULER_BLEST_H
+
+#include "ns3/mptcp-scheduler-fastest-rtt.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Blocking estimation scheduler (BLEST)
+ *
+ * Sends on the available subflow with lowest RTT, like MpTcpSchedulerFastestRTT,
+ * except when that subflow is slower than the fastest established one. Data
+ * sent on a slow subflow occupies the receiver's window until it arrives, so
+ * the slow subflow is skipped when the bytes the fastest subflow could send
+ * during one RTT of the slow subflow would not fit in the remaining meta window.
+ *
+ * The estimate assumes the fastest subflow grows its window by one segment per
+ * RTT, and is scaled by the Lambda attribute.
+ *
+ * See Ferlin et al., "BLEST: Blocking Estimation-based MPTCP Scheduler for
+ * Heterogeneous Networks", IFIP Networking 2016.
+ */
+class MpTcpSchedulerBlest : public MpTcpSchedulerFastestRTT
+{
+
+public:
+  static TypeId GetTypeId (void);
+
+  MpTcpSchedulerBlest();
+  virtual ~MpTcpSchedulerBlest ();
+
+  virtual Ptr<MpTcpSubflow> GetAvailableSubflow (uint32_t dataToSend, uint32_t metaWindow) override;
+
+  virtual bool GetNextDecision(uint32_t dataToSend, uint32_t metaWindow, MpTcpSchedulerDecision& decision) override;
+
+protected:
+  /**
+   * \return Whether sending one segment on the slow subflow would not block the fast subflow
+   */
+  bool CanUseSlowSubflow(uint32_t fast, uint32_t slow) const;
+
+  double m_lambda;  //!< Scaling of the number of bytes the fast subflow is expected to send
+};
+
+
+} // end of 'ns3'
+
+#endif /* MPTCP_SCHEDULER_BLEST_H */
@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#include "ns3/mptcp-scheduler-ecf.h"
+#include "ns3/mptcp-subflow.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("MpTcpSchedulerEcf");
+NS_OBJECT_ENSURE_REGISTERED(MpTcpSchedulerEcf);
+
+TypeId
+MpTcpSchedulerEcf::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpSchedulerEcf")
+    .SetParent<MpTcpSchedulerFastestRTT> ()
+    .AddConstructor<MpTcpSchedulerEcf> ()
+    .AddAttribute ("Beta",
+                   "Hysteresis applied to the completion time of the slow subflow "
+                   "once waiting for the fastest subflow",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&MpTcpSchedulerEcf::m_beta),
+                   MakeDoubleChecker<double> (0))
+  ;
+  return tid;
+}
+
+MpTcpSchedulerEcf::MpTcpSchedulerEcf() :
+  MpTcpSchedulerFastestRTT(),
+  m_beta(0.25),
+  m_waiting(false)
+{
+  NS_LOG_FUNCTION(this);
+}
+
+MpTcpSchedulerEcf::~MpTcpSchedulerEcf (void)
+{
+  NS_LOG_FUNCTION(this);
+}
+
+bool MpTcpSchedulerEcf::ShouldWait (uint32_t fast, uint32_t slow, uint32_t dataToSend)
+{
+  double rttFast = m_rtt[fast].GetSeconds();
+  double rttSlow = m_rtt[slow].GetSeconds();
+  double delta = std::max(m_rttVar[fast], m_rttVar[slow]).GetSeconds();
+  
+  double rounds = 1 + static_cast<double>(dataToSend) / std::max(m_cwnd[fast], GetSegSize(fast));
+  double hysteresis = m_waiting ? (1 + m_beta) : 1;
+  
+  if (rounds * rttFast < hysteresis * (rttSlow + delta))
+  {
+    double slowRounds = static_cast<double>(dataToSend) / std::max(m_cwnd[slow], GetSegSize(slow));
+    if (slowRounds * rttSlow >= 2 * rttFast + delta)
+    {
+      m_waiting = true;
+      return true;
+    }
+  }
+  else
+  {
+    m_waiting = false;
+  }
+  return false;
+}
+
+Ptr<MpTcpSubflow> MpTcpSchedulerEcf::GetAvailableSubflow (uint32_t dataToSend, uint32_t metaWindow)
+{
+  MpTcpSchedulerDecision decision;
+  return GetNextDecision(dataToSend, metaWindow, decision) ? decision.subflow : nullptr;
+}
+
+bool MpTcpSchedulerEcf::GetNextDecision (uint32_t dataToSend, uint32_t metaWindow, MpTcpSchedulerDecision& decision)
+{
+  uint32_t i = SelectSubflow(dataToSend, metaWindow);
+  if (i == GetNSubflows())
+  {
+    return false;
+  }
+  
+  decision.subflow = m_subflows[i];
+  decision.budget = GetBudget(i, dataToSend, metaWindow);
+  
+  uint32_t fastest = GetFastestSubflow();
+  if (fastest != i)
+  {
+    if (ShouldWait(fastest, i, dataToSend))
+    {
+      NS_LOG_LOGIC("Waiting for subflow " << fastest << " rather than sending on subflow " << i);
+      return false;
+    }
+    // Less data is queued after each segment, decide again
+    decision.budget = std::min(decision.budget, GetSegSize(i));
+  }
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,71 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef MPTCP_SCHEDULER_ECF_H
+#define MPTCP_SCHEDULER_ECF_H
+
+#include "ns3/mptcp-scheduler-fastest-rtt.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Earliest completion first scheduler (ECF)
+ *
+ * Sends on the available subflow with lowest RTT, like MpTcpSchedulerFastestRTT,
+ * except when that subflow is slower than the fastest established one. The
+ * slow subflow is then skipped when waiting for the fast subflow to get room
+ * would complete the transfer of the queued data earlier than sending on the
+ * slow subflow right away.
+ *
+ * With n = 1 + queued / cwnd_f the number of RTTs the fast subflow needs for the
+ * queued data, and delta the largest RTT variation of both subflows, the
+ * scheduler waits when
+ *   n * rtt_f < (1 + waiting * beta) * (rtt_s + delta)
+ * and
+ *   queued / cwnd_s * rtt_s >= 2 * rtt_f + delta
+ * The Beta attribute adds hysteresis once the scheduler is waiting.
+ *
+ * See Lim et al., "ECF: An MPTCP Path Scheduler to Manage Heterogeneous
+ * Paths", CoNEXT 2017.
+ */
+class MpTcpSchedulerEcf : public MpTcpSchedulerFastestRTT
+{
+
+public:
+  static TypeId GetTypeId (void);
+
+  MpTcpSchedulerEcf();
+  virtual ~MpTcpSchedulerEcf ();
+
+  virtual Ptr<MpTcpSubflow> GetAvailableSubflow (uint32_t dataToSend, uint32_t metaWindow) override;
+
+  virtual bool GetNextDecision(uint32_t dataToSend, uint32_t metaWindow, MpTcpSchedulerDecision& decision) override;
+
+protected:
+  /**
+   * \return Whether the queued data completes earlier by waiting for the fast subflow
+   */
+  bool ShouldWait(uint32_t fast, uint32_t slow, uint32_t dataToSend);
+
+  double m_beta;    //!< Hysteresis applied while waiting for the fast subflow
+  bool m_waiting;   //!< Whether the last decision was to wait for the fast subflow
+};
+
+
+} // end of 'ns3'
+
+#endif /* MPTCP_SCHEDULER_ECF_H */
@@ -60,40 +60,51 @@ MpTcpSchedulerFastestRTT::GetAvailableControlSubflow()
   return  m_metaSock->GetActiveSubflow(0);
 }
   
-Ptr<MpTcpSubflow> MpTcpSchedulerFastestRTT::GetAvailableSubflow (uint32_t dataToSend, uint32_t metaWindow)
+uint32_t MpTcpSchedulerFastestRTT::SelectSubflow (uint32_t dataToSend, uint32_t metaWindow)
 {
   NS_LOG_FUNCTION(this);
   NS_ASSERT(m_metaSock);
   
-  uint32_t subflowCount = m_metaSock->GetNActiveSubflows();
+  uint32_t subflowCount = GetNSubflows();
   Time lowestEstimate = Time::Max();
   
-  Ptr<MpTcpSubflow> available = nullptr;
+  uint32_t available = subflowCount;
   
+  UpdateMetaRwnd();
   for(uint32_t index = 0; index < subflowCount; ++index)
   {
-    Ptr<MpTcpSubflow> subflow = m_metaSock->GetActiveSubflow(index);
-    uint32_t subflowWindow = subflow->AvailableWindow();
-    
-    NS_LOG_DEBUG("subflow AvailableWindow  [" << subflowWindow << "]");
-    uint32_t canSend = std::min(subflowWindow, metaWindow);
-    //uint32_t canSend = subflowWindow;
+    NS_LOG_DEBUG("subflow AvailableWindow  [" << AvailableWindow(index) << "]");
     
     //Check whether we can send (check silly window)
-    if(canSend > 0 && subflow->CanSendPendingData(dataToSend))
+    if(CanSend(index, dataToSend, metaWindow) && m_rtt[index] < lowestEstimate)
     {
-      //Get the RTT estimate
-      Time subflowRtt = subflow->GetRttEstimator()->GetEstimate ();
-      if(subflowRtt < lowestEstimate)
-      {
-        lowestEstimate = subflowRtt;
-        available = subflow;
-      }
+      lowestEstimate = m_rtt[index];
+      available = index;
     }
   }
   
   return available;
 }
+
+Ptr<MpTcpSubflow> MpTcpSchedulerFastestRTT::GetAvailableSubflow (uint32_t dataToSend, uint32_t metaWindow)
+{
+  uint32_t i = SelectSubflow(dataToSend, metaWindow);
+  return (i < GetNSubflows()) ? m_subflows[i] : nullptr;
+}
+
+bool MpTcpSchedulerFastestRTT::GetNextDecision (uint32_t dataToSend, uint32_t metaWindow, MpTcpSchedulerDecision& decision)
+{
+  uint32_t i = SelectSubflow(dataToSend, metaWindow);
+  if (i == GetNSubflows())
+  {
+    return false;
+  }
+  // The RTTs don't change while sending, the same subflow would be picked
+  // again until it stops accepting data
+  decision.subflow = m_subflows[i];
+  decision.budget = GetBudget(i, dataToSend, metaWindow);
+  return true;
+}
   
 } // namespace ns3
 
@@ -44,7 +44,17 @@ public:
   
   virtual Ptr<MpTcpSubflow> GetAvailableSubflow (uint32_t dataToSend, uint32_t metaWindow) override;
 
+  /**
+   Send on the available subflow with lowest RTT as long as it accepts data
+   */
+  virtual bool GetNextDecision(uint32_t dataToSend, uint32_t metaWindow, MpTcpSchedulerDecision& decision) override;
+
 protected:
+  /**
+   * \return Index of the available subflow with lowest RTT, or GetNSubflows() if none
+   */
+  uint32_t SelectSubflow(uint32_t dataToSend, uint32_t metaWindow);
+
 //  uint8_t  m_lastUsedFlowId;        //!< keep track of last used subflow
 };
 
@@ -0,0 +1,88 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#include "ns3/mptcp-scheduler-redundant.h"
+#include "ns3/mptcp-subflow.h"
+#include "ns3/log.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("MpTcpSchedulerRedundant");
+NS_OBJECT_ENSURE_REGISTERED(MpTcpSchedulerRedundant);
+
+TypeId
+MpTcpSchedulerRedundant::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpSchedulerRedundant")
+    .SetParent<MpTcpSchedulerFastestRTT> ()
+    .AddConstructor<MpTcpSchedulerRedundant> ()
+  ;
+  return tid;
+}
+
+MpTcpSchedulerRedundant::MpTcpSchedulerRedundant() :
+  MpTcpSchedulerFastestRTT()
+{
+  NS_LOG_FUNCTION(this);
+}
+
+MpTcpSchedulerRedundant::~MpTcpSchedulerRedundant (void)
+{
+  NS_LOG_FUNCTION(this);
+}
+
+void MpTcpSchedulerRedundant::AddSubflow (Ptr<MpTcpSubflow> subflow)
+{
+  MpTcpSchedulerFastestRTT::AddSubflow(subflow);
+  m_duplicated.push_back(SequenceNumber64(0));
+}
+
+bool MpTcpSchedulerRedundant::GetDuplicateDecision (SequenceNumber64 metaUnacked, SequenceNumber64 metaNextTx,
+                                                    MpTcpSchedulerDecision& decision, SequenceNumber64& dsn)
+{
+  UpdateMetaRwnd();
+  for (uint32_t i = 0; i < GetNSubflows(); ++i)
+  {
+    // Only idle subflows, a subflow with data in flight would delay its own data
+    if (m_nextTx[i] != m_unacked[i])
+    {
+      continue;
+    }
+    
+    SequenceNumber64 start = std::max(metaUnacked, m_duplicated[i]);
+    if (start >= metaNextTx)
+    {
+      continue;
+    }
+    uint32_t length = metaNextTx - start;
+    uint32_t budget = GetBudget(i, length, length);
+    if (budget == 0)
+    {
+      continue;
+    }
+    
+    NS_LOG_LOGIC("Sending " << budget << " bytes from dsn " << start << " again on subflow " << i);
+    m_duplicated[i] = start + budget;
+    decision.subflow = m_subflows[i];
+    decision.budget = budget;
+    dsn = start;
+    return true;
+  }
+  return false;
+}
+
+} // namespace ns3
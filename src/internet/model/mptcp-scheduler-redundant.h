@@ -0,0 +1,57 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef MPTCP_SCHEDULER_REDUNDANT_H
+#define MPTCP_SCHEDULER_REDUNDANT_H
+
+#include "ns3/mptcp-scheduler-fastest-rtt.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Scheduler duplicating in-flight data on idle subflows
+ *
+ * New data is sent on the available subflow with lowest RTT, as
+ * MpTcpSchedulerFastestRTT does. Once no new data can be sent, because the
+ * application has nothing more to send or the meta window is full, the
+ * subflows with nothing in flight send again the data that was not yet
+ * acknowledged by a DATA_ACK. Whichever copy arrives first fills the
+ * receiver's reordering buffer, so the tail of a transfer no longer waits on
+ * the slowest subflow.
+ */
+class MpTcpSchedulerRedundant : public MpTcpSchedulerFastestRTT
+{
+
+public:
+  static TypeId GetTypeId (void);
+
+  MpTcpSchedulerRedundant();
+  virtual ~MpTcpSchedulerRedundant ();
+
+  virtual void AddSubflow(Ptr<MpTcpSubflow> subflow) override;
+
+  virtual bool GetDuplicateDecision(SequenceNumber64 metaUnacked, SequenceNumber64 metaNextTx,
+                                    MpTcpSchedulerDecision& decision, SequenceNumber64& dsn) override;
+
+protected:
+  vector<SequenceNumber64> m_duplicated;  //!< Per subflow, end of the data it last sent again
+};
+
+
+} // end of 'ns3'
+
+#endif /* MPTCP_SCHEDULER_REDUNDANT_H */
@@ -57,35 +57,49 @@ MpTcpSchedulerRoundRobin::~MpTcpSchedulerRoundRobin (void)
   NS_LOG_FUNCTION(this);
 }
   
-Ptr<MpTcpSubflow> MpTcpSchedulerRoundRobin::GetAvailableSubflow (uint32_t dataToSend, uint32_t metaWindow)
+uint32_t MpTcpSchedulerRoundRobin::SelectSubflow (uint32_t dataToSend, uint32_t metaWindow)
 {
   NS_LOG_FUNCTION(this);
   NS_ASSERT(m_metaSock);
   
-  int nbOfSubflows = m_metaSock->GetNActiveSubflows();
-  int attempt = 0;
+  uint32_t nbOfSubflows = GetNSubflows();
+  uint32_t attempt = 0;
   
   NS_LOG_DEBUG ("Able to choose between [" << nbOfSubflows << "] subflows");
   
+  UpdateMetaRwnd();
   while(attempt < nbOfSubflows)
   {
     attempt++;
     m_lastUsedFlowId = (m_lastUsedFlowId + 1) % nbOfSubflows;
-    Ptr<MpTcpSubflow> subflow = m_metaSock->GetActiveSubflow(m_lastUsedFlowId);
-    uint32_t subflowWindow = subflow->AvailableWindow();
-    
-    NS_LOG_DEBUG("subflow AvailableWindow  [" << subflowWindow << "]");
-    uint32_t canSend = std::min(subflowWindow, metaWindow);
-    //uint32_t canSend = subflowWindow;
+    NS_LOG_DEBUG("subflow AvailableWindow  [" << AvailableWindow(m_lastUsedFlowId) << "]");
     
     //Check whether we can send (check silly window)
-    if(canSend > 0 && subflow->CanSendPendingData(dataToSend))
+    if(CanSend(m_lastUsedFlowId, dataToSend, metaWindow))
     {
-      return subflow;
+      return m_lastUsedFlowId;
     }
   }
   NS_LOG_DEBUG("No subflow available");
-  return nullptr;
+  return nbOfSubflows;
+}
+
+Ptr<MpTcpSubflow> MpTcpSchedulerRoundRobin::GetAvailableSubflow (uint32_t dataToSend, uint32_t metaWindow)
+{
+  uint32_t i = SelectSubflow(dataToSend, metaWindow);
+  return (i < GetNSubflows()) ? m_subflows[i] : nullptr;
+}
+
+bool MpTcpSchedulerRoundRobin::GetNextDecision (uint32_t dataToSend, uint32_t metaWindow, MpTcpSchedulerDecision& decision)
+{
+  uint32_t i = SelectSubflow(dataToSend, metaWindow);
+  if (i == GetNSubflows())
+  {
+    return false;
+  }
+  decision.subflow = m_subflows[i];
+  decision.budget = std::min(std::min(AvailableWindow(i), dataToSend), GetSegSize(i));
+  return true;
 }
 
 Ptr<MpTcpSubflow> MpTcpSchedulerRoundRobin::GetAvailableControlSubflow ()
@@ -43,10 +43,20 @@ public:
      in a round robin fashion from amongst active subflows.
    */
   virtual Ptr<MpTcpSubflow> GetAvailableSubflow (uint32_t dataToSend, uint32_t metaWindow) override;
+
+  /*
+     One segment on the next available subflow
+   */
+  virtual bool GetNextDecision(uint32_t dataToSend, uint32_t metaWindow, MpTcpSchedulerDecision& decision) override;
   
   virtual Ptr<MpTcpSubflow> GetAvailableControlSubflow () override;
 
 protected:
+  /**
+   * \return Index of the next subflow able to send, or GetNSubflows() if none
+   */
+  uint32_t SelectSubflow(uint32_t dataToSend, uint32_t metaWindow);
+
   uint32_t  m_lastUsedFlowId;        //!< keep track of last used subflow
 };
 
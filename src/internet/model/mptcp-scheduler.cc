@@ -18,16 +18,19 @@
  * Author: Matthieu Coudron <matthieu.coudron@lip6.fr>
  */
 
+#include <algorithm>
 #include "mptcp-scheduler.h"
 #include "mptcp-meta-socket.h"
 #include "mptcp-subflow.h"
+#include "ns3/log.h"
 
 namespace ns3
 {
 
+NS_LOG_COMPONENT_DEFINE("MpTcpScheduler");
 NS_OBJECT_ENSURE_REGISTERED(MpTcpScheduler);
   
-MpTcpScheduler::MpTcpScheduler () : m_metaSock(0)
+MpTcpScheduler::MpTcpScheduler () : m_metaSock(0), m_metaRwnd(0)
 {
 }
 
@@ -41,13 +44,244 @@ void MpTcpScheduler::SetMeta(Ptr<MpTcpMetaSocket> metaSock)
   m_metaSock = metaSock;
 }
 
+void MpTcpScheduler::AddSubflow(Ptr<MpTcpSubflow> subflow)
+{
+  NS_LOG_FUNCTION(this << subflow);
+  uint32_t i = GetNSubflows();
+  m_subflows.push_back(subflow);
+  m_cwnd.push_back(subflow->m_tcb->m_cWnd.Get());
+  m_nextTx.push_back(subflow->m_tcb->m_nextTxSequence.Get());
+  m_unacked.push_back(subflow->m_txBuffer->HeadSequence());
+  m_rtt.push_back(subflow->m_rtt->GetEstimate());
+  m_rttVar.push_back(subflow->m_rtt->GetVariation());
+  m_canSend.push_back(subflow->m_state == TcpSocket::ESTABLISHED || subflow->m_state == TcpSocket::CLOSE_WAIT);
+  m_noDelay.push_back(subflow->m_tcpParams->m_noDelay);
+
+  TraceSubflow(i, true);
+}
+
+void MpTcpScheduler::RemoveSubflow(Ptr<MpTcpSubflow> subflow)
+{
+  NS_LOG_FUNCTION(this << subflow);
+  uint32_t n = GetNSubflows();
+  uint32_t i = std::find(m_subflows.begin(), m_subflows.end(), subflow) - m_subflows.begin();
+  if (i == n)
+  {
+    return;
+  }
+  
+  // The callbacks of the subflows after it are bound to their old index
+  for (uint32_t j = i; j < n; ++j)
+  {
+    TraceSubflow(j, false);
+  }
+  m_subflows.erase(m_subflows.begin() + i);
+  m_cwnd.erase(m_cwnd.begin() + i);
+  m_nextTx.erase(m_nextTx.begin() + i);
+  m_unacked.erase(m_unacked.begin() + i);
+  m_rtt.erase(m_rtt.begin() + i);
+  m_rttVar.erase(m_rttVar.begin() + i);
+  m_canSend.erase(m_canSend.begin() + i);
+  m_noDelay.erase(m_noDelay.begin() + i);
+  for (uint32_t j = i; j < n - 1; ++j)
+  {
+    TraceSubflow(j, true);
+  }
+}
+
+void MpTcpScheduler::TraceSubflow(uint32_t i, bool connect)
+{
+  Ptr<MpTcpSubflow> subflow = m_subflows[i];
+  bool (ObjectBase::*trace)(std::string, const CallbackBase&) =
+    connect ? &ObjectBase::TraceConnectWithoutContext : &ObjectBase::TraceDisconnectWithoutContext;
+  
+  bool ok;
+  ok = (PeekPointer(subflow->m_tcb)->*trace)("CongestionWindow",
+                                              MakeCallback(&MpTcpScheduler::CwndChanged, this).Bind(i));
+  NS_ASSERT(ok);
+  ok = (PeekPointer(subflow->m_tcb)->*trace)("NextTxSequence",
+                                              MakeCallback(&MpTcpScheduler::NextTxChanged, this).Bind(i));
+  NS_ASSERT(ok);
+  ok = (PeekPointer(subflow->m_txBuffer)->*trace)("UnackSequence",
+                                                  MakeCallback(&MpTcpScheduler::UnackedChanged, this).Bind(i));
+  NS_ASSERT(ok);
+  ok = (PeekPointer(subflow)->*trace)("RTT", MakeCallback(&MpTcpScheduler::RttChanged, this).Bind(i));
+  NS_ASSERT(ok);
+  ok = (PeekPointer(subflow)->*trace)("State", MakeCallback(&MpTcpScheduler::StateChanged, this).Bind(i));
+  NS_ASSERT(ok);
+}
+
+void MpTcpScheduler::CwndChanged(uint32_t i, uint32_t oldValue, uint32_t newValue)
+{
+  m_cwnd[i] = newValue;
+}
+
+void MpTcpScheduler::NextTxChanged(uint32_t i, SequenceNumber32 oldValue, SequenceNumber32 newValue)
+{
+  m_nextTx[i] = newValue;
+}
+
+void MpTcpScheduler::UnackedChanged(uint32_t i, SequenceNumber32 oldValue, SequenceNumber32 newValue)
+{
+  m_unacked[i] = newValue;
+}
+
+void MpTcpScheduler::RttChanged(uint32_t i, Time oldValue, Time newValue)
+{
+  m_rtt[i] = newValue;
+  m_rttVar[i] = m_subflows[i]->m_rtt->GetVariation();
+}
+
+void MpTcpScheduler::StateChanged(uint32_t i, TcpSocket::TcpStates_t oldValue, TcpSocket::TcpStates_t newValue)
+{
+  m_canSend[i] = (newValue == TcpSocket::ESTABLISHED || newValue == TcpSocket::CLOSE_WAIT);
+}
+
+uint32_t MpTcpScheduler::GetNSubflows() const
+{
+  return m_subflows.size();
+}
+
+uint32_t MpTcpScheduler::GetSegSize(uint32_t i) const
+{
+  return m_subflows[i]->GetSegSize();
+}
+
+uint32_t MpTcpScheduler::GetFastestSubflow() const
+{
+  uint32_t fastest = GetNSubflows();
+  for (uint32_t i = 0; i < GetNSubflows(); ++i)
+  {
+    if (m_canSend[i] && (fastest == GetNSubflows() || m_rtt[i] < m_rtt[fastest]))
+    {
+      fastest = i;
+    }
+  }
+  return fastest;
+}
+
+void MpTcpScheduler::UpdateMetaRwnd()
+{
+  m_metaRwnd = m_metaSock->GetRwndSize();
+}
+
+uint32_t MpTcpScheduler::AvailableWindow(uint32_t i) const
+{
+  // A paced subflow queues the data it was given until its pacing timer
+  // expires: count it as sent, or all the meta window ends up queued there
+  uint32_t unack = m_nextTx[i] - m_unacked[i]
+    + m_subflows[i]->m_txBuffer->SizeFromSequence(m_nextTx[i]);
+  uint32_t win = std::min(m_metaRwnd, m_cwnd[i]);
+  return (win < unack) ? 0 : (win - unack);
+}
+
+bool MpTcpScheduler::CanSend(uint32_t i, uint32_t dataToSend, uint32_t metaWindow) const
+{
+  if (!m_canSend[i] || metaWindow == 0)
+  {
+    return false;
+  }
+  uint32_t w = AvailableWindow(i);
+  // Silly window syndrome avoidance, then Nagle's algorithm
+  if (w < GetSegSize(i) && dataToSend > w)
+  {
+    return false;
+  }
+  if (!m_noDelay[i] && m_nextTx[i] != m_unacked[i] && dataToSend < GetSegSize(i))
+  {
+    return false;
+  }
+  return w > 0;
+}
+
+uint32_t MpTcpScheduler::GetBudget(uint32_t i, uint32_t dataToSend, uint32_t metaWindow) const
+{
+  // Replay the checks the subflow would go through before each segment
+  uint32_t budget = 0;
+  uint32_t w = AvailableWindow(i);
+  bool unacked = m_nextTx[i] != m_unacked[i];
+  while (m_canSend[i] && dataToSend > 0 && metaWindow > 0 && w > 0
+         && !(w < GetSegSize(i) && dataToSend > w)
+         && !(!m_noDelay[i] && unacked && dataToSend < GetSegSize(i)))
+  {
+    uint32_t length = std::min(std::min(w, dataToSend), GetSegSize(i));
+    budget += length;
+    w -= length;
+    dataToSend -= length;
+    metaWindow = (metaWindow > length) ? metaWindow - length : 0;
+    unacked = true;
+  }
+  return budget;
+}
+
+bool MpTcpScheduler::GetNextDecision(uint32_t dataToSend, uint32_t metaWindow, MpTcpSchedulerDecision& decision)
+{
+  decision.subflow = GetAvailableSubflow(dataToSend, metaWindow);
+  if (!decision.subflow)
+  {
+    return false;
+  }
+  decision.budget = GetSendSizeForSubflow(decision.subflow, decision.subflow->GetSegSize(), dataToSend);
+  return true;
+}
+
+bool MpTcpScheduler::GetDuplicateDecision(SequenceNumber64 metaUnacked, SequenceNumber64 metaNextTx,
+                                          MpTcpSchedulerDecision& decision, SequenceNumber64& dsn)
+{
+  return false;
+}
+
+bool MpTcpScheduler::GetReinjectDecision(Ptr<MpTcpSubflow> from, uint32_t length, bool fasterOnly,
+                                         MpTcpSchedulerDecision& decision)
+{
+  uint32_t n = GetNSubflows();
+  uint32_t origin = std::find(m_subflows.begin(), m_subflows.end(), from) - m_subflows.begin();
+  uint32_t best = n;
+  
+  UpdateMetaRwnd();
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    if (i == origin || !CanSend(i, length, length))
+    {
+      continue;
+    }
+    if (fasterOnly && origin < n && m_rtt[i] >= m_rtt[origin])
+    {
+      continue;
+    }
+    if (best == n || m_rtt[i] < m_rtt[best])
+    {
+      best = i;
+    }
+  }
+  
+  if (best == n)
+  {
+    return false;
+  }
+  decision.subflow = m_subflows[best];
+  decision.budget = GetBudget(best, length, length);
+  return decision.budget > 0;
+}
+
 uint32_t MpTcpScheduler::GetSendSizeForSubflow(Ptr<MpTcpSubflow> subflow, uint32_t segSize, uint32_t dataToSend)
 {
   uint32_t subflowWindow = subflow->AvailableWindow();
+  uint32_t queued = subflow->m_txBuffer->SizeFromSequence(subflow->m_tcb->m_nextTxSequence);
+  subflowWindow = (subflowWindow > queued) ? subflowWindow - queued : 0;
   
   uint32_t length = std::min(subflowWindow, dataToSend);
-  // For now we limit ourselves to a per packet length
-  length = std::min(length, segSize);
+  if (subflow->m_tcpParams->m_gso && length > segSize)
+  {
+    // A super-segment of whole segments
+    length = std::min(length, static_cast<uint32_t>(subflow->m_tcpParams->m_gsoMaxSize));
+    length = std::max(length - length % segSize, segSize);
+  }
+  else
+  {
+    // For now we limit ourselves to a per packet length
+    length = std::min(length, segSize);
+  }
   
   return length;
 }
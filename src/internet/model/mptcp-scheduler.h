@@ -20,7 +20,11 @@
 #ifndef MPTCP_SCHEDULER_H
 #define MPTCP_SCHEDULER_H
 
+#include <vector>
 #include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/sequence-number.h"
+#include "ns3/tcp-socket.h"
 
 namespace ns3
 {
@@ -30,6 +34,16 @@ using namespace std;
 class MpTcpMetaSocket;
 class MpTcpSubflow;
 
+/**
+ * What the meta socket should send next: up to budget bytes on subflow, cut
+ * into segments of the subflow's size.
+ */
+struct MpTcpSchedulerDecision
+{
+  Ptr<MpTcpSubflow> subflow;  //!< Subflow to send on
+  uint32_t budget;            //!< Number of bytes to send on it
+};
+
 /**
  * This class is responsible for selecting the available subflow to schedule the next MSS on.
  *
@@ -37,6 +51,11 @@ class MpTcpSubflow;
  * -get_available_subflow
  * -get_next_segment
  *
+ * The meta socket registers its subflows as they get established. From then on
+ * the subflows push their congestion window, sequence numbers, RTT and state
+ * through their trace sources into arrays owned by the scheduler (one entry
+ * per subflow), so that schedulers can select a subflow without querying it.
+ * The meta unregisters them once closed.
  */
 class MpTcpScheduler : public Object
 {
@@ -48,16 +67,133 @@ public:
 
   virtual void SetMeta(Ptr<MpTcpMetaSocket> metaSock);
   
+  /**
+   * \brief Start tracking the state of an established subflow
+   */
+  virtual void AddSubflow(Ptr<MpTcpSubflow> subflow);
+
+  /**
+   * \brief Stop tracking a closed subflow
+   *
+   * The subflows registered after it move down one index.
+   */
+  virtual void RemoveSubflow(Ptr<MpTcpSubflow> subflow);
+
   uint32_t GetSendSizeForSubflow(Ptr<MpTcpSubflow> subflow, uint32_t segSize, uint32_t dataToSend);
   
   virtual Ptr<MpTcpSubflow> GetAvailableSubflow (uint32_t dataToSend, uint32_t metaWindow) = 0;
   
+  /**
+   * \brief Select the subflow to send on and how many bytes
+   *
+   * Defaults to one segment on the subflow returned by GetAvailableSubflow.
+   *
+   * \param dataToSend number of bytes waiting in the meta send buffer
+   * \param metaWindow available window of the meta socket
+   * \param decision filled with the subflow and the number of bytes to send on it
+   * \return false if no subflow can send
+   */
+  virtual bool GetNextDecision(uint32_t dataToSend, uint32_t metaWindow, MpTcpSchedulerDecision& decision);
+
+  /**
+   * \brief Select data already sent to send again on another subflow
+   *
+   * Called by the meta socket once GetNextDecision has nothing more to send.
+   * Defaults to never duplicating data.
+   *
+   * \param metaUnacked first data sequence number not acknowledged by a DATA_ACK
+   * \param metaNextTx next data sequence number the meta socket would send
+   * \param decision filled with the subflow and the number of bytes to send on it
+   * \param dsn filled with the data sequence number to send from
+   * \return false if nothing should be duplicated
+   */
+  virtual bool GetDuplicateDecision(SequenceNumber64 metaUnacked, SequenceNumber64 metaNextTx,
+                                    MpTcpSchedulerDecision& decision, SequenceNumber64& dsn);
+
+  /**
+   * \brief Select the subflow to send data again on, that was mapped on another subflow
+   *
+   * Defaults to the subflow with lowest RTT that accepts data, other than the
+   * one the data was mapped on.
+   *
+   * \param from subflow the data was mapped on
+   * \param length number of bytes to send again
+   * \param fasterOnly only consider subflows with a lower RTT than from
+   * \param decision filled with the subflow and the number of bytes to send on it
+   * \return false if no subflow can send
+   */
+  virtual bool GetReinjectDecision(Ptr<MpTcpSubflow> from, uint32_t length, bool fasterOnly,
+                                   MpTcpSchedulerDecision& decision);
+
   //Get subflow to send empty control packets on, e.g. DATA_FIN.
   virtual Ptr<MpTcpSubflow> GetAvailableControlSubflow () = 0;
   
 protected:
+  /**
+   * \return Number of subflows tracked, the index of a subflow is its registration order
+   */
+  uint32_t GetNSubflows() const;
+
+  /**
+   * \return Segment size of subflow i, read from the subflow as it may be
+   * renegotiated after the subflow is registered
+   */
+  uint32_t GetSegSize(uint32_t i) const;
+
+  /**
+   * \return Available window of subflow i, as MpTcpSubflow::AvailableWindow
+   * less the data queued in the subflow and not sent yet
+   */
+  uint32_t AvailableWindow(uint32_t i) const;
+
+  /**
+   * \return Whether subflow i accepts data, as MpTcpSubflow::CanSendPendingData,
+   * with room left in the meta window
+   */
+  bool CanSend(uint32_t i, uint32_t dataToSend, uint32_t metaWindow) const;
+
+  /**
+   * \return Number of bytes subflow i would accept if it was asked again after each segment
+   */
+  uint32_t GetBudget(uint32_t i, uint32_t dataToSend, uint32_t metaWindow) const;
+
+  /**
+   * \return Index of the ESTABLISHED or CLOSE_WAIT subflow with lowest RTT, whether or
+   * not it has room in its window, or GetNSubflows() if none
+   */
+  uint32_t GetFastestSubflow() const;
+
+  /**
+   * \brief Read the window advertised to the meta socket, used by the subflows' windows
+   *
+   * To be called before evaluating the subflows for a decision.
+   */
+  void UpdateMetaRwnd();
+
   Ptr<MpTcpMetaSocket> m_metaSock;  //!<A pointer back to the owning meta socket.
 
+  // Per subflow state, indexed by registration order
+  vector<Ptr<MpTcpSubflow> > m_subflows;  //!< Subflows tracked
+  vector<uint32_t> m_cwnd;                //!< Congestion windows
+  vector<SequenceNumber32> m_nextTx;      //!< Next sequence numbers to send (SND.NXT)
+  vector<SequenceNumber32> m_unacked;     //!< First unacknowledged sequence numbers (SND.UNA)
+  vector<Time> m_rtt;                     //!< Smoothed RTT estimates
+  vector<Time> m_rttVar;                  //!< RTT variations
+  vector<bool> m_canSend;                 //!< Whether the subflows are ESTABLISHED or CLOSE_WAIT
+  vector<bool> m_noDelay;                 //!< Whether Nagle's algorithm is disabled
+  uint32_t m_metaRwnd;                    //!< Window advertised to the meta socket
+
+private:
+  /**
+   * \brief Connect (or disconnect) the trace sources of subflow i to the arrays
+   */
+  void TraceSubflow(uint32_t i, bool connect);
+
+  void CwndChanged(uint32_t i, uint32_t oldValue, uint32_t newValue);
+  void NextTxChanged(uint32_t i, SequenceNumber32 oldValue, SequenceNumber32 newValue);
+  void UnackedChanged(uint32_t i, SequenceNumber32 oldValue, SequenceNumber32 newValue);
+  void RttChanged(uint32_t i, Time oldValue, Time newValue);
+  void StateChanged(uint32_t i, TcpSocket::TcpStates_t oldValue, TcpSocket::TcpStates_t newValue);
 };
 
 
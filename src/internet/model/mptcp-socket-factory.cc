@@ -21,6 +21,7 @@
 #include "tcp-l4-protocol.h"
 #include "ns3/socket.h"
 #include "ns3/assert.h"
+#include "ns3/type-id.h"
 #include "tcp-congestion-ops.h"
 #include "mptcp-lia.h"
 #include "mptcp-meta-socket.h"
@@ -44,6 +45,11 @@ MpTcpSocketFactory::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::MpTcpSocketFactory")
                               .SetParent<SocketFactory> ()
                               .SetGroupName ("Internet")
+                              .AddAttribute ("CongestionControl",
+                                             "Congestion control of the subflows, e.g. MpTcpLia or MpTcpDctcp",
+                                             TypeIdValue (MpTcpLia::GetTypeId ()),
+                                             MakeTypeIdAccessor (&MpTcpSocketFactory::m_congestionTypeId),
+                                             MakeTypeIdChecker ())
   ;
 return tid;
 }
@@ -57,7 +63,7 @@ MpTcpSocketFactory::SetTcp (Ptr<TcpL4Protocol> tcp)
 Ptr<Socket>
 MpTcpSocketFactory::CreateSocket (void)
 {
-  return m_tcp->CreateSocket (MpTcpLia::GetTypeId (), MpTcpMetaSocket::GetTypeId());
+  return m_tcp->CreateSocket (m_congestionTypeId, MpTcpMetaSocket::GetTypeId());
 }
 
 void 
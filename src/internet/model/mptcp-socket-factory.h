@@ -69,6 +69,7 @@ protected:
   virtual void DoDispose (void);
 private:
   Ptr<TcpL4Protocol> m_tcp; //!< the associated TCP L4 protocol
+  TypeId m_congestionTypeId; //!< Congestion control of the subflows
 };
 
 } // namespace ns3
@@ -34,6 +34,7 @@
 #include "mptcp-subflow.h"
 #include "tcp-socket-base.h"
 #include "tcp-l4-protocol.h"
+#include "tcp-congestion-ops.h"
 #include "ns3/ipv4-address.h"
 #include "ipv4-end-point.h"
 #include "ipv6-end-point.h" // it is not exported in ns3.19
@@ -43,8 +44,10 @@
 #include "ns3/ptr.h"
 #include "tcp-option-mptcp.h"
 #include "mptcp-id-manager.h"
+#include "mptcp-crypto.h"
 //#include "ns3/ipv4-address.h"
 #include "ns3/trace-helper.h"
+#include "ns3/object-factory.h"
 #include <algorithm>
 //#include <openssl/sha.h>
 
@@ -71,6 +74,11 @@ MpTcpSubflow::GetTypeId(void)
       .SetParent<TcpSocketBase>()
       .SetGroupName ("Internet")
       .AddConstructor<MpTcpSubflow>()
+      .AddAttribute ("MappingContainer",
+                     "How the DSN/SSN mappings of the subflow are stored",
+                     TypeIdValue (MpTcpMappingRing::GetTypeId ()),
+                     MakeTypeIdAccessor (&MpTcpSubflow::m_mappingContainerTypeId),
+                     MakeTypeIdChecker ())
     ;
   return tid;
 }
@@ -89,6 +97,14 @@ MpTcpSubflow::SetMeta(Ptr<MpTcpMetaSocket> metaSocket)
   NS_LOG_FUNCTION(this);
   m_metaSocket = metaSocket;
   m_tcb->m_socket = metaSocket;
+  // Mappings of all the subflows are recycled through the meta
+  m_TxMappings->SetPool(metaSocket->GetMappingPool());
+  m_RxMappings->SetPool(metaSocket->GetMappingPool());
+  if (metaSocket->GetVirtualPayload())
+  {
+    m_txBuffer->SetVirtualPayload(true);
+    m_rxBuffer->SetVirtualPayload(true);
+  }
 }
 
 void MpTcpSubflow::SetMptcpEnabled (bool flag)
@@ -133,6 +149,7 @@ MpTcpSubflow::CancelAllTimers()
   m_retxEvent.Cancel();
   m_lastAckEvent.Cancel();
   m_timewaitEvent.Cancel();
+  m_pacingTimer.Cancel();
   NS_LOG_LOGIC( "CancelAllTimers");
 }
 
@@ -160,23 +177,33 @@ MpTcpSubflow::MpTcpSubflow(const MpTcpSubflow& sock)
   : TcpSocketBase(sock),
   m_masterSocket(false),  //!always set to false, should be explicitly set later
   m_localNonce(sock.m_localNonce),
+  m_peerNonce(sock.m_peerNonce),
+  m_joinHmacMismatch(false),
   m_id(0),
   m_dssFlags(0),
   m_routeId(0),
+  m_mappingContainerTypeId(sock.m_mappingContainerTypeId),
   m_metaSocket(0),
+  m_lastPenalty(Time::Min()),
   m_backupSubflow(sock.m_backupSubflow)
 {
   NS_LOG_FUNCTION (this << &sock);
   NS_LOG_LOGIC ("Invoked the copy constructor");
+  // Mappings are not shared with the listening subflow
+  CreateMappingContainers();
 }
 
 MpTcpSubflow::MpTcpSubflow () :
     TcpSocketBase(),
     m_routeId(0),
+    m_mappingContainerTypeId(MpTcpMappingRing::GetTypeId ()),
     m_metaSocket(0),
+    m_lastPenalty(Time::Min()),
     m_backupSubflow(false),
     m_masterSocket(false),
     m_localNonce(0),
+    m_peerNonce(0),
+    m_joinHmacMismatch(false),
     m_id(0),
     m_dssFlags(0)
 {
@@ -188,6 +215,23 @@ MpTcpSubflow::~MpTcpSubflow()
   NS_LOG_FUNCTION(this);
 }
 
+void
+MpTcpSubflow::NotifyConstructionCompleted(void)
+{
+  TcpSocketBase::NotifyConstructionCompleted();
+  CreateMappingContainers();
+}
+
+void
+MpTcpSubflow::CreateMappingContainers(void)
+{
+  NS_LOG_FUNCTION(this << m_mappingContainerTypeId.GetName());
+  ObjectFactory factory;
+  factory.SetTypeId(m_mappingContainerTypeId);
+  m_TxMappings = factory.Create<MpTcpMappingContainer>();
+  m_RxMappings = factory.Create<MpTcpMappingContainer>();
+}
+
 
 /**
 TODO maybe override that not to have the callbacks
@@ -226,8 +270,9 @@ MpTcpSubflow::Send(Ptr<Packet> p, uint32_t flags)
 // Check that the packet is covered by mapping (TODO: remove)
   
     SequenceNumber32 ssnHead = m_txBuffer->TailSequence() - p->GetSize();
-    Ptr<MpTcpMapping> temp = m_TxMappings.GetMappingForSSN(ssnHead);
-    NS_ASSERT(temp);
+    MpTcpMapping temp;
+    bool ok = m_TxMappings->GetMappingForSSN(ssnHead, temp);
+    NS_ASSERT(ok);
 
   return 0;
 }
@@ -249,14 +294,14 @@ MpTcpSubflow::SendEmptyPacket(TcpHeader& header)
   TcpSocketBase::SendEmptyPacket(header);
 }
 
-Ptr<MpTcpMapping>
+bool
 MpTcpSubflow::AddLooseMapping(SequenceNumber64 dsnHead, uint16_t length)
 {
   NS_LOG_LOGIC("Adding mapping with dsn=" << dsnHead << " len=" << length);
   
-  Ptr<MpTcpMapping> mapping = m_TxMappings.AddMapping (dsnHead, FirstUnmappedSSN(), length);
-  NS_ASSERT_MSG(mapping, "Can't add mapping: 2 mappings overlap");
-  return mapping;
+  bool added = m_TxMappings->AddMapping (dsnHead, FirstUnmappedSSN(), length);
+  NS_ASSERT_MSG(added, "Can't add mapping: 2 mappings overlap");
+  return added;
 }
 
 SequenceNumber32
@@ -279,7 +324,7 @@ MpTcpSubflow::FirstUnmappedSSN()
 //                SequenceNumber64 headDsn,
 //                std::vector< std::pair<SequenceNumber64, uint16_t> >& missing
 void
-MpTcpSubflow::GetMappedButMissingData(set<Ptr<MpTcpMapping>>& missing)
+MpTcpSubflow::GetMappedButMissingData(vector<MpTcpMapping>& missing)
 {
     //!
     NS_LOG_FUNCTION(this);
@@ -287,7 +332,7 @@ MpTcpSubflow::GetMappedButMissingData(set<Ptr<MpTcpMapping>>& missing)
 
     SequenceNumber32 startingSsn = m_txBuffer->TailSequence();
 
-    m_TxMappings.GetMappingsStartingFromSSN(startingSsn, missing);
+    m_TxMappings->GetMappingsStartingFromSSN(startingSsn, missing);
 }
 
   /* We don't automatically embed mappings since we want the possibility to create mapping spanning over several segments
@@ -322,13 +367,13 @@ MpTcpSubflow::SendPacket(TcpHeader header, Ptr<Packet> p)
     ///============================
     SequenceNumber32 ssnHead = header.GetSequenceNumber();
     
-    Ptr<MpTcpMapping> mapping = m_TxMappings.GetMappingForSSN(ssnHead);
-    if(!mapping)
+    MpTcpMapping mapping;
+    if(!m_TxMappings->GetMappingForSSN(ssnHead, mapping))
     {
-      m_TxMappings.Dump();
+      m_TxMappings->Dump();
       NS_FATAL_ERROR("Could not find mapping associated to ssn");
     }
-    NS_ASSERT_MSG(mapping->TailSSN() >= ssnHead +p->GetSize() -1, "mapping should cover the whole packet" );
+    NS_ASSERT_MSG(mapping.TailSSN() >= ssnHead +p->GetSize() -1, "mapping should cover the whole packet" );
     
     AppendDSSMapping(mapping);
     // For now we append the data ack everytime
@@ -354,15 +399,16 @@ MpTcpSubflow::SendDataPacket(TcpHeader& header, SequenceNumber32 ssnHead, uint32
 //  if(p->GetSize() && !IsInfiniteMappingEnabled())
 //  {
 
-      Ptr<MpTcpMapping> mapping = m_TxMappings.GetMappingForSSN(ssnHead);
-      if(!mapping)
+      MpTcpMapping mapping;
+      if(!m_TxMappings->GetMappingForSSN(ssnHead, mapping))
       {
-        m_TxMappings.Dump();
+        m_TxMappings->Dump();
         NS_FATAL_ERROR("Could not find mapping associated to ssn");
       }
   
-  // Here we set the maxsize to the size of the mapping
-  return TcpSocketBase::SendDataPacket(header, ssnHead, std::min(maxSize, (uint32_t)mapping->GetLength()));
+  // Here we set the maxsize to what is left of the mapping
+  uint32_t left = mapping.TailSSN() - ssnHead + 1;
+  return TcpSocketBase::SendDataPacket(header, ssnHead, std::min(maxSize, left));
 }
 
 
@@ -381,9 +427,28 @@ void
 MpTcpSubflow::Retransmit(void)
 {
   NS_LOG_FUNCTION (this);
+  // Let the other subflows deliver what this one has lost
+  GetMeta()->ReinjectSubflowData(this);
   TcpSocketBase::Retransmit();
 }
 
+void
+MpTcpSubflow::ReduceWindow(void)
+{
+  NS_LOG_FUNCTION(this);
+  if (m_tcb->m_congState != TcpSocketState::CA_OPEN && m_tcb->m_congState != TcpSocketState::CA_DISORDER)
+  {
+    return;
+  }
+  NS_LOG_DEBUG(TcpSocketState::TcpCongStateName[m_tcb->m_congState] << " -> CWR");
+  m_congestionControl->CongestionStateSet(m_tcb, TcpSocketState::CA_CWR);
+  m_tcb->m_congState = TcpSocketState::CA_CWR;
+  m_tcb->m_ssThresh = m_congestionControl->GetSsThresh(m_tcb, BytesInFlight());
+  m_tcb->m_cWnd = m_tcb->m_ssThresh.Get();
+  // Left on the next ACK covering the data in flight, as after an ECN-Echo
+  m_ecnRecover = m_tcb->m_highTxMark;
+}
+
 
 // TODO this could be replaced
 void
@@ -404,8 +469,8 @@ MpTcpSubflow::ProcessListen(Ptr<Packet> packet, const TcpHeader& tcpHeader, cons
 {
   NS_LOG_FUNCTION (this << tcpHeader);
   
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags() & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags() & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
   
   //Check to see if this is a SYN, and whether it has the MP_JOIN option
   Ptr<const TcpOptionMpTcpMain> option = GetMptcpOptionWithSubtype(tcpHeader, TcpOptionMpTcpMain::MP_JOIN);
@@ -470,7 +535,7 @@ MpTcpSubflow::TimeWait()
   CancelAllTimers();
   // Move from TIME_WAIT to CLOSED after 2*MSL. Max segment lifetime is 2 min
   // according to RFC793, p.28
-  m_timewaitEvent = Simulator::Schedule(Seconds(m_tcpParams->m_msl), &MpTcpSubflow::CloseAndNotify, this);
+  m_timewaitEvent.Schedule (Seconds(m_tcpParams->m_msl), &MpTcpSubflow::CloseAndNotify, this);
 }
 
 void
@@ -495,6 +560,10 @@ MpTcpSubflow::AddMpTcpOptions (TcpHeader& header)
 
   if((header.GetFlags () & TcpHeader::SYN))
   {
+    if(!IsMaster() && m_localNonce == 0)
+    {
+      m_localNonce = m_tcp->DrawMpTcpNonce();
+    }
     AddOptionMpTcp3WHS (header);
   }
   // as long as we've not received an ack from the peer we
@@ -523,7 +592,8 @@ MpTcpSubflow::AddOptionMpTcp3WHS(TcpHeader& hdr) const
   {
     //! Use an MP_CAPABLE option
     Ptr<TcpOptionMpTcpCapable> mpc =  CreateObject<TcpOptionMpTcpCapable>();
-    switch(hdr.GetFlags())
+    // The ECN flags of the SYN and SYN-ACK do not change the option
+    switch(hdr.GetFlags() & ~(TcpHeader::ECE | TcpHeader::CWR))
     {
       case TcpHeader::SYN:
       case (TcpHeader::SYN | TcpHeader::ACK):
@@ -544,19 +614,20 @@ MpTcpSubflow::AddOptionMpTcp3WHS(TcpHeader& hdr) const
   {
     Ptr<TcpOptionMpTcpJoin> join =  CreateObject<TcpOptionMpTcpJoin>();
     
-    switch(hdr.GetFlags())
+    switch(hdr.GetFlags() & ~(TcpHeader::ECE | TcpHeader::CWR))
     {
       case TcpHeader::SYN:
       {
         join->SetMode(TcpOptionMpTcpJoin::Syn);
         join->SetPeerToken(GetMeta()->GetPeerToken());
-        join->SetNonce(0);
+        join->SetNonce(m_localNonce);
         break;
       }
         
       case TcpHeader::ACK:
       {
         uint8_t hmac[20];
+        GenerateJoinHmac(GetMeta()->GetLocalKey(), GetMeta()->GetPeerKey(), m_localNonce, m_peerNonce, hmac);
         
         join->SetMode(TcpOptionMpTcpJoin::Ack);
         join->SetHmac(hmac);
@@ -567,13 +638,14 @@ MpTcpSubflow::AddOptionMpTcp3WHS(TcpHeader& hdr) const
       {
         join->SetMode(TcpOptionMpTcpJoin::SynAck);
         //! TODO request from idmanager an id
-        static uint8_t id = 0;
+        static thread_local uint8_t id = 0;
         // TODO
         NS_LOG_WARN("IDs are incremental, there is no real logic behind it yet");
         //id = GetIdManager()->GetLocalAddrId( InetSocketAddress(m_endPoint->GetLocalAddress(),m_endPoint->GetLocalPort()) );
         join->SetAddressId(id++);
-        join->SetTruncatedHmac(424242); // who cares
-        join->SetNonce(4242); //! truly random :)
+        join->SetTruncatedHmac(GenerateTruncatedJoinHmac(GetMeta()->GetLocalKey(), GetMeta()->GetPeerKey(),
+                                                         m_localNonce, m_peerNonce));
+        join->SetNonce(m_localNonce);
         
         break;
       }
@@ -594,7 +666,8 @@ void
 MpTcpSubflow::AddMpTcpOptionDSS(TcpHeader& header)
 {
   NS_LOG_FUNCTION(this);
-  Ptr<TcpOptionMpTcpDSS> dss = Create<TcpOptionMpTcpDSS>();
+  // Written in place in the header: this option is on every segment
+  MpTcpDss dss;
   const bool sendDataFin = m_dssFlags &  TcpOptionMpTcpDSS::DataFin;
   const bool sendDataAck = m_dssFlags & TcpOptionMpTcpDSS::DataAckPresent;
   
@@ -603,24 +676,24 @@ MpTcpSubflow::AddMpTcpOptionDSS(TcpHeader& header)
     // TODO replace with member function to keep isolation
     uint64_t dack = GetMeta()->GetRxBuffer()->NextRxSequence().GetValue();
     //Make sure ACK is 64 bits
-    dss->SetDataAck (dack, false);
+    dss.SetDataAck (dack, false);
   }
   
   // If no mapping set but DATA_FIN set, we have to create the mapping from scratch
   if(sendDataFin && !(m_dssFlags & TcpOptionMpTcpDSS::DSNMappingPresent))
   {
     //The ssn should be 0 for packets without any data
-    m_dssMapping = Create<MpTcpMapping>(GetMeta()->GetNextTxSequence(), SequenceNumber32(0), 1);
+    m_dssMapping = MpTcpMapping(GetMeta()->GetNextTxSequence(), SequenceNumber32(0), 1);
     m_dssFlags |= TcpOptionMpTcpDSS::DSNMappingPresent;
   }
   
   // if there is a mapping to send
   if(m_dssFlags & TcpOptionMpTcpDSS::DSNMappingPresent)
   {
-    dss->SetMapping(m_dssMapping->HeadDSN(), m_dssMapping->HeadSSN(),
-                    m_dssMapping->GetLength(), sendDataFin);
+    dss.SetMapping(m_dssMapping.HeadDSN(), m_dssMapping.HeadSSN(),
+                   m_dssMapping.GetLength(), sendDataFin);
   }
-  bool success = header.AppendOption(dss);
+  bool success = dss.AppendTo(header);
   NS_ASSERT(success);
 }
 
@@ -696,6 +769,15 @@ MpTcpSubflow::ProcessSynSent(Ptr<Packet> packet, const TcpHeader& tcpHeader)
   NS_ASSERT(m_state == SYN_SENT);
 
   NS_LOG_DEBUG("endp=" << m_endPoint);
+  if (m_joinHmacMismatch)
+  {
+    // RFC 6824 section 3.2: the initiator of a subflow whose SYN/ACK fails the
+    // HMAC check must close it with a RST
+    NS_LOG_WARN("Resetting the subflow, the HMAC of the MP_JOIN does not match the keys of the connection");
+    SendRST();
+    CloseAndNotify();
+    return;
+  }
   TcpSocketBase::ProcessSynSent(packet, tcpHeader);
 }
 
@@ -758,9 +840,14 @@ MpTcpSubflow::ProcessOptionMpTcpJoin(Ptr<const TcpOptionMpTcpMain> option)
   // NS_ASSERT_MSG( join && join->GetMode() == TcpOptionMpTcpJoin::SynAck, "the MPTCP join option received is not of the expected 1 out of 3 MP_JOIN types." );
   
   uint8_t addressId = join->GetAddressId(); //!< each mptcp subflow has a uid assigned
-  // TODO Here we should check the tokens
-  //        uint8_t buf[20] =
-  //        opt3->GetTruncatedHmac();
+  if(join->GetMode() == TcpOptionMpTcpJoin::SynAck)
+  {
+    m_peerNonce = join->GetNonce();
+    uint64_t expected = GenerateTruncatedJoinHmac(GetMeta()->GetPeerKey(), GetMeta()->GetLocalKey(),
+                                                  m_peerNonce, m_localNonce);
+    // Checked here, the subflow is reset by ProcessSynSent
+    m_joinHmacMismatch = (join->GetTruncatedHmac() != expected);
+  }
   NS_LOG_DEBUG("Id manager");
   GetIdManager()->AddRemoteAddr(addressId, m_endPoint->GetPeerAddress(), m_endPoint->GetPeerPort());
 }
@@ -794,7 +881,7 @@ MpTcpSubflow::PreProcessOption (Ptr<const TcpOption> option)
     case TcpOptionMpTcpMain::MP_DSS:
     {
       Ptr<const TcpOptionMpTcpDSS> dss = DynamicCast<const TcpOptionMpTcpDSS>(option);
-      PreProcessOptionMpTcpDSS(dss);
+      PreProcessOptionMpTcpDSS(*dss);
       break;
     }
       
@@ -822,7 +909,43 @@ MpTcpSubflow::PostProcessOption (Ptr<const TcpOption> option)
       Ptr<const TcpOptionMpTcpDSS> dss = DynamicCast<const TcpOptionMpTcpDSS>(option);
       NS_ASSERT(dss);
       // Update later on
-      PostProcessOptionMpTcpDSS(dss);
+      PostProcessOptionMpTcpDSS(*dss);
+  }
+}
+
+void
+MpTcpSubflow::ProcessOptions (const TcpHeader& header, bool post)
+{
+  for (const uint8_t *it = header.FindOption (TcpOption::MPTCP); it != 0;
+       it = header.FindOption (TcpOption::MPTCP, it))
+  {
+    if ((it[2] >> 4) == TcpOptionMpTcpMain::MP_DSS)
+    {
+      MpTcpDss dss;
+      if (!dss.Read (it))
+      {
+        NS_LOG_WARN ("Malformed DSS option, ignored");
+        continue;
+      }
+      if (post)
+      {
+        PostProcessOptionMpTcpDSS (dss);
+      }
+      else
+      {
+        PreProcessOptionMpTcpDSS (dss);
+      }
+      continue;
+    }
+    Ptr<const TcpOption> option = TcpHeader::DeserializeOption (it);
+    if (post)
+    {
+      PostProcessOption (option);
+    }
+    else
+    {
+      PreProcessOption (option);
+    }
   }
 }
 
@@ -953,14 +1076,10 @@ MpTcpSubflow::UpdateWindowSize(const TcpHeader& header)
     }
     else
     {
-      Ptr<const TcpOptionMpTcpMain> option = GetMptcpOptionWithSubtype(header, TcpOptionMpTcpMain::MP_DSS);
-      if(option)
+      MpTcpDss dss;
+      if(dss.ReadFrom(header) && (dss.GetFlags() & MpTcpDss::DataAckPresent))
       {
-        Ptr<const TcpOptionMpTcpDSS> dssOption = StaticCast<const TcpOptionMpTcpDSS>(option);
-        if(dssOption->GetFlags() & TcpOptionMpTcpDSS::DataAckPresent)
-        {
-          GetMeta()->UpdateWindowSize(m_rWnd);
-        }
+        GetMeta()->UpdateWindowSize(m_rWnd);
       }
     }
   }
@@ -976,7 +1095,7 @@ MpTcpSubflow::UpdateTxBuffer(SequenceNumber32 ack)
   TcpSocketBase::UpdateTxBuffer(ack);
   uint32_t length = m_txBuffer->HeadSequence() - startSeq;
   
-  m_TxMappings.DiscardMappingsInSSNRange(startSeq, length);
+  m_TxMappings->DiscardMappingsInSSNRange(startSeq, length);
 }
 
 /**
@@ -1014,22 +1133,12 @@ MpTcpSubflow::NewAck(const TcpHeader& header, bool resetRTO)
   
 Ptr<const TcpOptionMpTcpMain> MpTcpSubflow::GetMptcpOptionWithSubtype (const TcpHeader& header, TcpOptionMpTcpMain::SubType subtype)
 {
-  if(header.HasOption(TcpOption::MPTCP))
+  for (const uint8_t *it = header.FindOption (TcpOption::MPTCP); it != 0;
+       it = header.FindOption (TcpOption::MPTCP, it))
   {
-    TcpHeader::TcpOptionList options;
-    header.GetOptions (options);
-    
-    for(TcpHeader::TcpOptionList::const_iterator it(options.begin()); it != options.end(); ++it)
+    if ((it[2] >> 4) == subtype)
     {
-      Ptr<const TcpOption> option = *it;
-      if(option->GetKind() == TcpOption::MPTCP)
-      {
-        Ptr<const TcpOptionMpTcpMain> main = DynamicCast<const TcpOptionMpTcpMain>(option);
-        if(main->GetSubType() == subtype)
-        {
-          return main;
-        }
-      }
+      return DynamicCast<const TcpOptionMpTcpMain> (TcpHeader::DeserializeOption (it));
     }
   }
   return nullptr;
@@ -1040,7 +1149,6 @@ Ptr<NetDevice>
 MpTcpSubflow::MapIpv4ToDevice (Ipv4Address addr) const
 {
   NS_LOG_DEBUG(addr);
-  cout << addr << endl;
   Ptr<Ipv4> ipv4client = m_node->GetObject<Ipv4>();
 
   for (uint32_t n = 0; n < ipv4client->GetNInterfaces(); n++)
@@ -1050,7 +1158,8 @@ MpTcpSubflow::MapIpv4ToDevice (Ipv4Address addr) const
       //NS_LOG_UNCOND( "Client addr " << n <<"/" << a << "=" << ipv4client->GetAddress(n,a));
       if(addr ==ipv4client->GetAddress(n,a).GetLocal()) {
         //NS_LOG_UNCOND("EUREKA same ip=" << addr);
-        return m_node->GetDevice(n);
+        // Interface and device indices differ, e.g. the loopback comes first
+        return ipv4client->GetNetDevice(n);
       }
     }
   }
@@ -1061,7 +1170,6 @@ Ptr<NetDevice>
 MpTcpSubflow::MapIpv6ToDevice (Ipv6Address addr) const
 {
   NS_LOG_DEBUG(addr);
-  cout << addr << endl;
   Ptr<Ipv6> ipv6client = m_node->GetObject<Ipv6>();
 
   for (uint32_t n = 0; n < ipv6client->GetNInterfaces(); n++)
@@ -1071,7 +1179,7 @@ MpTcpSubflow::MapIpv6ToDevice (Ipv6Address addr) const
       //NS_LOG_UNCOND( "Client addr " << n <<"/" << a << "=" << ipv4client->GetAddress(n,a));
       if(addr ==ipv6client->GetAddress(n,a).GetAddress()) {
         //NS_LOG_UNCOND("EUREKA same ip=" << addr);
-        return m_node->GetDevice(n);
+        return ipv6client->GetNetDevice(n);
       }
     }
   }
@@ -1203,17 +1311,17 @@ MpTcpSubflow::UpdateRxBuffer()
     NS_LOG_DEBUG("Extracting at most " << maxSize << " bytes ");
     p = m_rxBuffer->Extract(maxSize);
     
-    m_RxMappings.DiscardMappingsInSSNRange(headSSN, maxSize);
+    m_RxMappings->DiscardMappingsInSSNRange(headSSN, maxSize);
   }
 }
 
 
 void
-MpTcpSubflow::AppendDSSMapping(Ptr<const MpTcpMapping> mapping)
+MpTcpSubflow::AppendDSSMapping(const MpTcpMapping& mapping)
 {
     NS_LOG_FUNCTION(this << mapping);
     m_dssFlags |= TcpOptionMpTcpDSS::DSNMappingPresent;
-    m_dssMapping = Copy<MpTcpMapping>(mapping);
+    m_dssMapping = mapping;
 }
 
 void
@@ -1245,15 +1353,15 @@ MpTcpSubflow::ReceivedData(Ptr<Packet> p, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  Ptr<MpTcpMapping> mapping = m_RxMappings.GetMappingForSSN(tcpHeader.GetSequenceNumber());
+  MpTcpMapping mapping;
   bool sendAck = false;
 
 
   // OutOfRange
   // If cannot find an adequate mapping, then it should [check RFC]
-  if(!mapping)
+  if(!m_RxMappings->GetMappingForSSN(tcpHeader.GetSequenceNumber(), mapping))
   {
-    m_RxMappings.Dump();
+    m_RxMappings->Dump();
     NS_FATAL_ERROR("Could not find mapping associated ");
     return;
   }
@@ -1269,7 +1377,7 @@ MpTcpSubflow::ReceivedData(Ptr<Packet> p, const TcpHeader& tcpHeader)
     
     //This is possibly a duplicate, discard the mapping from the rxMappings
     SequenceNumber32 ssn = tcpHeader.GetSequenceNumber();
-    m_RxMappings.DiscardMappingsInSSNRange(ssn, p->GetSize());
+    m_RxMappings->DiscardMappingsInSSNRange(ssn, p->GetSize());
     
     //Don't need to add to the meta socket if this is a duplicate
     //Send ACK immediately
@@ -1305,10 +1413,10 @@ MpTcpSubflow::ReceivedData(Ptr<Packet> p, const TcpHeader& tcpHeader)
       }
       else if (m_delAckEvent.IsExpired ())
       {
-        m_delAckEvent = Simulator::Schedule (m_tcpParams->m_delAckTimeout,
-                                             &MpTcpSubflow::DelAckTimeout, this);
+        m_delAckEvent.Schedule (m_tcpParams->m_delAckTimeout,
+                                &MpTcpSubflow::DelAckTimeout, this);
         NS_LOG_LOGIC (this << " scheduled delayed ACK at "
-                      << (Simulator::Now () + Simulator::GetDelayLeft (m_delAckEvent)).GetSeconds ());
+                      << (Simulator::Now () + m_delAckEvent.GetDelayLeft ()).GetSeconds ());
       }
     }
   
@@ -1382,7 +1490,7 @@ Quote from rfc 6824:
 */
 
 void
-MpTcpSubflow::PreProcessOptionMpTcpDSS(Ptr<const TcpOptionMpTcpDSS> dss)
+MpTcpSubflow::PreProcessOptionMpTcpDSS(const MpTcpDss& dss)
 {
   NS_LOG_FUNCTION (this << dss << " from subflow ");
   
@@ -1395,42 +1503,48 @@ MpTcpSubflow::PreProcessOptionMpTcpDSS(Ptr<const TcpOptionMpTcpDSS> dss)
   }
   
   //! datafin case handled at the start of the function
-  if( (dss->GetFlags() & TcpOptionMpTcpDSS::DSNMappingPresent) && !dss->DataFinMappingOnly() )
+  if( (dss.GetFlags() & TcpOptionMpTcpDSS::DSNMappingPresent) && !dss.DataFinMappingOnly() )
   {
     
     // Add peer mapping
-    Ptr<MpTcpMapping> mapping = m_RxMappings.AddMapping(dss->GetDataSequenceNumber(),
-                                                        dss->GetSubflowSequenceNumber(),
-                                                        dss->GetMappingLength());
-    if(!mapping)
+    // Each segment of a super-segment carries the mapping of the whole
+    MpTcpMapping existing;
+    bool repeated = m_RxMappings->GetMappingForSSN(dss.GetSubflowSequenceNumber(), existing)
+                    && existing.HeadSSN() == dss.GetSubflowSequenceNumber()
+                    && existing.HeadDSN() == dss.GetDataSequenceNumber()
+                    && existing.GetLength() == dss.GetMappingLength();
+    bool added = repeated || m_RxMappings->AddMapping(dss.GetDataSequenceNumber(),
+                                                      dss.GetSubflowSequenceNumber(),
+                                                      dss.GetMappingLength());
+    if(!added)
     {
       //We hit this when we time out after a loss, and retransmit something which has already
       //been received.
       NS_LOG_WARN("Could not insert mapping: It already exists.");
       NS_LOG_UNCOND("Dumping Rx mappings...");
-      m_RxMappings.Dump();
+      m_RxMappings->Dump();
     }
   }
   
-  if((dss->GetFlags() & TcpOptionMpTcpDSS::DataAckPresent))
+  if((dss.GetFlags() & TcpOptionMpTcpDSS::DataAckPresent))
   {
     //    NS_LOG_DEBUG("DataAck detected");
-    GetMeta()->ReceivedAck(this, dss->GetDataAck());
+    GetMeta()->ReceivedAck(this, dss.GetDataAck());
   }
 }
   
-void MpTcpSubflow::PostProcessOptionMpTcpDSS(Ptr<const TcpOptionMpTcpDSS> dss)
+void MpTcpSubflow::PostProcessOptionMpTcpDSS(const MpTcpDss& dss)
 {
-  if (dss->GetFlags() & TcpOptionMpTcpDSS::DataFin)
+  if (dss.GetFlags() & TcpOptionMpTcpDSS::DataFin)
   {
-    NS_LOG_LOGIC("Data FIN detected " << dss->GetDataFinDSN());
+    NS_LOG_LOGIC("Data FIN detected " << dss.GetDataFinDSN());
     
     SequenceNumber64 dack;
-    if (dss->GetFlags() & TcpOptionMpTcpDSS::DataAckPresent)
+    if (dss.GetFlags() & TcpOptionMpTcpDSS::DataAckPresent)
     {
-      dack = dss->GetDataAck();
+      dack = dss.GetDataAck();
     }
-    GetMeta()->PeerClose(SequenceNumber32(dss->GetDataFinDSN()), dack, this);
+    GetMeta()->PeerClose(SequenceNumber32(dss.GetDataFinDSN()), dack, this);
   }
 }
 
@@ -1447,9 +1561,19 @@ MpTcpSubflow::ReceivedAck(Ptr<Packet> p, const TcpHeader& header)
 {
   NS_LOG_FUNCTION (this << header);
 
+  // The meta socket sends on window increases: tell it when acked data
+  // frees room in a window which did not grow, e.g. after an ECN-Echo
+  SequenceNumber32 head = m_txBuffer->HeadSequence();
+  uint32_t cWnd = m_tcb->m_cWnd;
+
   // if packet size > 0 then it will call ReceivedData
   TcpSocketBase::ReceivedAck(p, header );
 
+  if (m_txBuffer->HeadSequence() > head && m_tcb->m_cWnd <= cWnd)
+  {
+    GetMeta()->OnSubflowWindowOpened(this);
+  }
+
   // By default we always append a DACK
   // We should consider more advanced schemes
   AppendDSSAck();
@@ -52,6 +52,7 @@ namespace ns3
 class MpTcpMetaSocket;
 class MpTcpPathIdManager;
 class TcpOptionMpTcpDSS;
+class MpTcpDss;
 class TcpOptionMpTcpMain;
 
 /**
@@ -107,8 +108,9 @@ public:
    * Thus you should call it with increased dsn.
    *
    * \param dsnHead
+   * \return false if the mapping overlaps an existing one
    */
-  Ptr<MpTcpMapping> AddLooseMapping(SequenceNumber64 dsnHead, uint16_t length);
+  bool AddLooseMapping(SequenceNumber64 dsnHead, uint16_t length);
 
   /**
   \warning for prototyping purposes, we let the user free to advertise an IP that doesn't belong to the node
@@ -209,12 +211,21 @@ public:
   */
   virtual void Retransmit(void);
 
+  /**
+   * \brief Reduce the window as the congestion control would upon congestion
+   *
+   * Enters CA_CWR with the slow start threshold given by the congestion control,
+   * until the data in flight is acknowledged. Does nothing if the window is
+   * already being reduced.
+   */
+  void ReduceWindow(void);
+
   /**
    * Parse DSS essentially
    */
 //  virtual int ProcessOptionMpTcpEstablished(const Ptr<const TcpOption> option);
-  virtual void PreProcessOptionMpTcpDSS(Ptr<const TcpOptionMpTcpDSS> option);
-  virtual void PostProcessOptionMpTcpDSS(Ptr<const TcpOptionMpTcpDSS> option);
+  virtual void PreProcessOptionMpTcpDSS(const MpTcpDss& dss);
+  virtual void PostProcessOptionMpTcpDSS(const MpTcpDss& dss);
   virtual void ProcessOptionMpTcpJoin(Ptr<const TcpOptionMpTcpMain> option);
   virtual void ProcessOptionMpTcpCapable(Ptr<const TcpOptionMpTcpMain> option);
 //  virtual int ProcessTcpOptionMpTcpDSS(Ptr<const TcpOptionMpTcpDSS> dss);
@@ -239,6 +250,7 @@ public:
 
 protected:
   friend class MpTcpMetaSocket;
+  friend class MpTcpScheduler;  // Caches the subflow state
 
   virtual void EstablishConnection(Ptr<Packet> packet, const TcpHeader& tcpHeader, bool withAck) override;
 
@@ -252,7 +264,7 @@ protected:
 
   virtual void CloseAndNotify(void);
 
-  virtual void GetMappedButMissingData(set<Ptr<MpTcpMapping>>& missing);
+  virtual void GetMappedButMissingData(vector<MpTcpMapping>& missing);
 
   /**
    * Depending on if this subflow is master or not, we want to
@@ -296,6 +308,12 @@ protected:
    * Process an option after we call the main TCP functionality on receiving a segment
    */
   virtual void PostProcessOption(Ptr<const TcpOption> option) override;
+
+  /**
+   * Reads the DSS option in place, and hands the other MPTCP options to
+   * PreProcessOption or PostProcessOption
+   */
+  virtual void ProcessOptions (const TcpHeader& header, bool post) override;
   
   // Return the max possible number of unacked bytes. Note that we take the connection level rWnd into consideration
   // not the subflow rWnd.
@@ -334,7 +352,7 @@ protected:
    * rename to addDSSFin
    */
   virtual void AppendDSSFin();
-  virtual void AppendDSSMapping(Ptr<const MpTcpMapping> mapping);
+  virtual void AppendDSSMapping(const MpTcpMapping& mapping);
 
   virtual void ReceivedAck(Ptr<Packet>, const TcpHeader&); // Received an ACK packet
 
@@ -370,11 +388,20 @@ protected:
   uint16_t m_routeId;   //!< Subflow's ID (TODO rename into subflowId ). Position of this subflow in MetaSock's subflows std::vector
 
 
-  MpTcpMappingContainer m_TxMappings;  //!< List of mappings to send
-  MpTcpMappingContainer m_RxMappings;  //!< List of mappings to receive
+  /**
+   * \brief Instantiates the Tx/Rx mapping containers from m_mappingContainerTypeId
+   */
+  void CreateMappingContainers(void);
+
+  virtual void NotifyConstructionCompleted(void) override;
+
+  TypeId m_mappingContainerTypeId;  //!< Backend used to store mappings
+  Ptr<MpTcpMappingContainer> m_TxMappings;  //!< List of mappings to send
+  Ptr<MpTcpMappingContainer> m_RxMappings;  //!< List of mappings to receive
 
 
   Ptr<MpTcpMetaSocket> m_metaSocket;    //!< Meta
+  Time m_lastPenalty;   //!< Last time the meta socket halved the window for blocking the receive window
   virtual void SendPacket(TcpHeader header, Ptr<Packet> p);
 
 //private:
@@ -382,13 +409,15 @@ protected:
 private:
   // Delayed values to
   uint8_t m_dssFlags;           //!< used to know if AddMpTcpOptions should send a flag
-  Ptr<MpTcpMapping> m_dssMapping;    //!< Pending ds configuration to be sent in next packet
+  MpTcpMapping m_dssMapping;    //!< Pending ds configuration to be sent in next packet
 
 
   bool m_backupSubflow; //!< Priority
   bool m_masterSocket;  //!< True if this is the first subflow established (with MP_CAPABLE)
 
   uint32_t m_localNonce;  //!< Store local host token, generated during the 3-way handshake
+  uint32_t m_peerNonce;   //!< Nonce received in the MP_JOIN of the peer
+  bool m_joinHmacMismatch;  //!< Whether the HMAC of the SYN/ACK MP_JOIN was wrong, the subflow is then reset
 
   uint32_t m_id; //!<Subflow identifier, used for debug purposes
 
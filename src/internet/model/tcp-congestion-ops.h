@@ -136,11 +136,41 @@ public:
   {
   }
 
+  /**
+   * \brief ECN information on received ACK
+   *
+   * This function mimics the function in_ack_event in Linux. It is called
+   * for every ACK received on a connection which negotiated ECN, before
+   * the socket reacts to the ECN-Echo flag, and after the last acked
+   * sequence of the state is updated. The default implementation does
+   * nothing.
+   *
+   * \param tcb internal congestion state
+   * \param bytesAcked bytes newly acked, 0 for a duplicate ACK
+   * \param ece true if the ACK carries the ECN-Echo flag
+   */
+  virtual void InAckEvent (Ptr<TcpSocketState> tcb, uint32_t bytesAcked, bool ece)
+  {
+  }
+
+  /**
+   * \brief Tell if the algorithm relies on ECN
+   *
+   * When true, the socket negotiates ECN whatever its "Ecn" attribute, and
+   * the receiver echoes the CE codepoint of each data segment in the
+   * ECN-Echo flag (RFC 8257), instead of setting it until the sender
+   * signals the window reduction with the CWR flag (RFC 3168).
+   *
+   * \return true if the algorithm needs ECN
+   */
+  virtual bool NeedsEcn () const
+  {
+    return false;
+  }
+
   // Present in Linux but not in ns-3 yet:
   /* call when cwnd event occurs (optional) */
   // void (*cwnd_event)(struct sock *sk, enum tcp_ca_event ev);
-  /* call when ack arrives (optional) */
-  // void (*in_ack_event)(struct sock *sk, u32 flags);
   /* new value of cwnd after loss (optional) */
   // u32  (*undo_cwnd)(struct sock *sk);
   /* hook for packet ack accounting (optional) */
@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tcp-dctcp.h"
+#include "ns3/tcp-socket-base.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpDctcp");
+NS_OBJECT_ENSURE_REGISTERED (TcpDctcp);
+
+TypeId
+TcpDctcp::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpDctcp")
+    .SetParent<TcpNewReno> ()
+    .AddConstructor<TcpDctcp> ()
+    .SetGroupName ("Internet")
+    .AddAttribute ("G", "Weight of the last window in the estimate of alpha",
+                   DoubleValue (0.0625),
+                   MakeDoubleAccessor (&TcpDctcp::m_g),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("InitialAlpha", "Initial value of alpha",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&TcpDctcp::m_alpha),
+                   MakeDoubleChecker<double> (0, 1))
+  ;
+  return tid;
+}
+
+TcpDctcp::TcpDctcp (void)
+  : TcpNewReno (),
+    m_alpha (1.0),
+    m_g (0.0625),
+    m_ackedBytesEcn (0),
+    m_ackedBytesTotal (0),
+    m_nextSeq (0),
+    m_nextSeqSet (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpDctcp::TcpDctcp (const TcpDctcp& sock)
+  : TcpNewReno (sock),
+    m_alpha (sock.m_alpha),
+    m_g (sock.m_g),
+    m_ackedBytesEcn (sock.m_ackedBytesEcn),
+    m_ackedBytesTotal (sock.m_ackedBytesTotal),
+    m_nextSeq (sock.m_nextSeq),
+    m_nextSeqSet (sock.m_nextSeqSet)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpDctcp::~TcpDctcp (void)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ptr<TcpCongestionOps>
+TcpDctcp::Fork (void)
+{
+  return CopyObject<TcpDctcp> (this);
+}
+
+std::string
+TcpDctcp::GetName () const
+{
+  return "TcpDctcp";
+}
+
+bool
+TcpDctcp::NeedsEcn () const
+{
+  return true;
+}
+
+double
+TcpDctcp::GetAlpha (void) const
+{
+  return m_alpha;
+}
+
+void
+TcpDctcp::InAckEvent (Ptr<TcpSocketState> tcb, uint32_t bytesAcked, bool ece)
+{
+  NS_LOG_FUNCTION (this << tcb << bytesAcked << ece);
+
+  if (bytesAcked == 0)
+    {
+      bytesAcked = tcb->m_segmentSize;
+    }
+  m_ackedBytesTotal += bytesAcked;
+  if (ece)
+    {
+      m_ackedBytesEcn += bytesAcked;
+    }
+
+  if (!m_nextSeqSet)
+    {
+      m_nextSeq = tcb->m_highTxMark;
+      m_nextSeqSet = true;
+    }
+  if (tcb->m_lastAckedSeq >= m_nextSeq)
+    { // End of the window: Equation 1
+      double f = static_cast<double> (m_ackedBytesEcn) / m_ackedBytesTotal;
+      m_alpha = (1.0 - m_g) * m_alpha + m_g * f;
+      NS_LOG_INFO ("Window of " << m_ackedBytesTotal << " bytes, " << m_ackedBytesEcn <<
+                   " marked: alpha updated to " << m_alpha);
+      m_ackedBytesEcn = 0;
+      m_ackedBytesTotal = 0;
+      m_nextSeq = tcb->m_highTxMark;
+    }
+}
+
+uint32_t
+TcpDctcp::GetSsThresh (Ptr<const TcpSocketState> tcb,
+                       uint32_t bytesInFlight)
+{
+  NS_LOG_FUNCTION (this << tcb << bytesInFlight);
+
+  if (tcb->m_congState != TcpSocketState::CA_CWR)
+    {
+      return TcpNewReno::GetSsThresh (tcb, bytesInFlight);
+    }
+
+  // Equation 2
+  uint32_t ssThresh = static_cast<uint32_t> (tcb->m_cWnd * (1.0 - m_alpha / 2.0));
+  NS_LOG_DEBUG ("Calculated ssThresh=" << ssThresh << " with alpha=" << m_alpha);
+
+  return std::max (ssThresh, 2 * tcb->m_segmentSize);
+}
+
+} // namespace ns3
@@ -0,0 +1,110 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef TCPDCTCP_H
+#define TCPDCTCP_H
+
+#include "ns3/tcp-congestion-ops.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup congestionOps
+ *
+ * \brief An implementation of DCTCP (RFC 8257)
+ *
+ * DCTCP needs ECN, and a switch which marks the packets as soon as its
+ * queue exceeds a threshold K (e.g. a RedQueueDisc with MinTh = MaxTh = K,
+ * QW = 1 and UseEcn). The receiver echoes the CE codepoint of each segment,
+ * and the sender estimates the fraction F of the bytes marked over each
+ * window of data:
+ *
+ *         alpha = (1 - g) * alpha + g * F           (1)
+ *
+ * On the first ECN-Echo of a window, the window is reduced in proportion
+ * to the extent of the congestion, instead of being halved:
+ *
+ *         cwnd = cwnd * (1 - alpha / 2)             (2)
+ *
+ * The window grows as in NewReno, and is halved on a loss.
+ *
+ * More information: http://doi.acm.org/10.1145/1851182.1851192
+ */
+class TcpDctcp : public TcpNewReno
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TcpDctcp (void);
+
+  /**
+   * \brief Copy constructor
+   * \param sock the object to copy
+   */
+  TcpDctcp (const TcpDctcp& sock);
+  virtual ~TcpDctcp (void);
+
+  virtual std::string GetName () const;
+
+  /**
+   * \brief Get the slow start threshold: Equation 2 on ECN-Echo, half the flight on a loss
+   *
+   * \param tcb internal congestion state
+   * \param bytesInFlight bytes in flight
+   *
+   * \return the slow start threshold value
+   */
+  virtual uint32_t GetSsThresh (Ptr<const TcpSocketState> tcb,
+                                uint32_t bytesInFlight);
+
+  /**
+   * \brief Count the bytes acked, and those marked, and update alpha once per window (Equation 1)
+   *
+   * A duplicate ACK counts for one segment.
+   *
+   * \param tcb internal congestion state
+   * \param bytesAcked bytes newly acked
+   * \param ece true if the ACK carries the ECN-Echo flag
+   */
+  virtual void InAckEvent (Ptr<TcpSocketState> tcb, uint32_t bytesAcked, bool ece);
+
+  virtual bool NeedsEcn () const;
+
+  virtual Ptr<TcpCongestionOps> Fork ();
+
+  /**
+   * \brief Get the estimate of the fraction of the bytes marked
+   * \return alpha
+   */
+  double GetAlpha (void) const;
+
+private:
+  double m_alpha;                  //!< Estimate of the fraction of the bytes marked
+  double m_g;                      //!< Weight of the last window in the estimate
+  uint32_t m_ackedBytesEcn;        //!< Bytes acked with ECN-Echo in the window
+  uint32_t m_ackedBytesTotal;      //!< Bytes acked in the window
+  SequenceNumber32 m_nextSeq;      //!< End of the window of the estimate
+  bool m_nextSeqSet;               //!< The end of the window is set
+};
+
+} // namespace ns3
+
+#endif // TCPDCTCP_H
@@ -19,6 +19,7 @@
  */
 
 #include <stdint.h>
+#include <cstring>
 #include <iostream>
 #include "tcp-header.h"
 #include "tcp-option.h"
@@ -33,6 +34,61 @@ NS_LOG_COMPONENT_DEFINE ("TcpHeader");
 
 NS_OBJECT_ENSURE_REGISTERED (TcpHeader);
 
+/**
+ * \brief Serialized size of a stored option
+ * \param option kind of the option, followed by its length but for NOP
+ * \return the size of the option
+ */
+static inline uint8_t
+OptionSize (const uint8_t *option)
+{
+  return option[0] == TcpOption::NOP ? 1 : option[1];
+}
+
+/**
+ * \brief Check the length of a received option against its kind
+ * \param kind kind of the option
+ * \param size serialized size of the option
+ * \return true if an option of this kind can have this size
+ */
+static bool
+IsOptionSizeValid (uint8_t kind, uint8_t size)
+{
+  switch (kind)
+    {
+    case TcpOption::MSS:
+      return size == 4;
+    case TcpOption::WINSCALE:
+      return size == 3;
+    case TcpOption::SACKPERMITTED:
+      return size == 2;
+    case TcpOption::TS:
+      return size == 10;
+    case TcpOption::SACK:
+      return size >= 2 && (size - 2) % 8 == 0;
+    case TcpOption::MPTCP:
+      // The subtype is in the third byte
+      return size >= 3;
+    default:
+      return size >= 2;
+    }
+}
+
+static inline uint32_t
+ReadU32 (const uint8_t *data)
+{
+  return (uint32_t (data[0]) << 24) | (uint32_t (data[1]) << 16) | (uint32_t (data[2]) << 8) | data[3];
+}
+
+static inline void
+WriteU32 (uint8_t *data, uint32_t value)
+{
+  data[0] = (value >> 24) & 0xff;
+  data[1] = (value >> 16) & 0xff;
+  data[2] = (value >> 8) & 0xff;
+  data[3] = value & 0xff;
+}
+
 TcpHeader::TcpHeader ()
   : m_sourcePort (0),
     m_destinationPort (0),
@@ -296,12 +352,11 @@ TcpHeader::Print (std::ostream &os)  const
 
   os << " Seq=" << m_sequenceNumber << " Ack=" << m_ackNumber << " Win=" << m_windowSize;
 
-  TcpOptionList::const_iterator op;
-
-  for (op = m_options.begin (); op != m_options.end (); ++op)
+  for (const uint8_t *option = NextOption (); option != 0; option = NextOption (option))
     {
-      os << " " << (*op)->GetInstanceTypeId ().GetName () << "(";
-      (*op)->Print (os);
+      Ptr<TcpOption> op = DeserializeOption (option);
+      os << " " << op->GetInstanceTypeId ().GetName () << "(";
+      op->Print (os);
       os << ")";
     }
 }
@@ -328,14 +383,8 @@ TcpHeader::Serialize (Buffer::Iterator start)  const
   // Serialize options if they exist
   // This implementation does not presently try to align options on word
   // boundaries using NOP options
-  uint32_t optionLen = 0;
-  TcpOptionList::const_iterator op;
-  for (op = m_options.begin (); op != m_options.end (); ++op)
-    {
-      optionLen += (*op)->GetSerializedSize ();
-      (*op)->Serialize (i);
-      i.Next ((*op)->GetSerializedSize ());
-    }
+  uint32_t optionLen = m_optionsLen;
+  i.Write (m_options, m_optionsLen);
 
   // padding to word alignment; add ENDs and/or pad values (they are the same)
   while (optionLen % 4)
@@ -367,70 +416,58 @@ TcpHeader::Deserialize (Buffer::Iterator start)
   m_sequenceNumber = i.ReadNtohU32 ();
   m_ackNumber = i.ReadNtohU32 ();
   uint16_t field = i.ReadNtohU16 ();
-  m_flags = field & 0x3F;
+  m_flags = field & 0xFF;
   m_length = field >> 12;
   m_windowSize = i.ReadNtohU16 ();
   i.Next (2);
   m_urgentPointer = i.ReadNtohU16 ();
 
-  // Deserialize options if they exist
-  m_options.clear ();
+  // Deserialize options if they exist: they are copied as they are, once
+  // checked to fit in the option space, and only decoded when read
   uint32_t optionLen = (m_length - 5) * 4;
   if (optionLen > m_maxOptionsLen)
     {
       NS_LOG_ERROR ("Illegal TCP option length " << optionLen << "; options discarded");
       return 20;
     }
-  while (optionLen)
+  uint8_t options[m_maxOptionsLen];
+  i.Read (options, optionLen);
+  while (m_optionsLen < optionLen)
     {
-      uint8_t kind = i.PeekU8 ();
-      Ptr<TcpOption> op;
-      uint32_t optionSize;
-      if( kind == TcpOption::MPTCP)
-      {
-        i.ReadU16(); // skip TCP kind & length
-        uint8_t subtype = i.ReadU8() >> 4;  // read MPTCP subtype
-        i.Prev(3); // revert the iterator back to where it should be
-        op = TcpOptionMpTcpMain::CreateMpTcpOption(subtype);
-      }
-      else if (TcpOption::IsKindKnown (kind))
-        {
-          op = TcpOption::CreateOption (kind);
-        }
-      else
-        {
-          op = TcpOption::CreateOption (TcpOption::UNKNOWN);
-          NS_LOG_WARN ("Option kind " << static_cast<int> (kind) << " unknown, skipping.");
-        }
-      optionSize = op->Deserialize (i);
-      if (optionSize != op->GetSerializedSize ())
-        {
-          NS_LOG_ERROR ("Option did not deserialize correctly");
-          break;
-        }
-      if (optionLen >= optionSize)
-        {
-          optionLen -= optionSize;
-          i.Next (optionSize);
-          m_options.push_back (op);
-          m_optionsLen += optionSize;
-        }
-      else
+      const uint8_t *option = options + m_optionsLen;
+      uint8_t kind = option[0];
+      if (kind == TcpOption::END)
         {
-          NS_LOG_ERROR ("Option exceeds TCP option space; option discarded");
+          // The rest is padding
           break;
         }
-      if (op->GetKind () == TcpOption::END)
+      uint32_t optionSize = 1;
+      if (kind != TcpOption::NOP)
         {
-          while (optionLen)
+          if (optionLen - m_optionsLen < 2)
+            {
+              NS_LOG_ERROR ("Option exceeds TCP option space; option discarded");
+              break;
+            }
+          optionSize = option[1];
+          if (!IsOptionSizeValid (kind, optionSize))
+            {
+              NS_LOG_ERROR ("Option did not deserialize correctly");
+              break;
+            }
+          if (optionSize > optionLen - m_optionsLen)
             {
-              // Discard padding bytes without adding to option list
-              i.Next (1);
-              --optionLen;
-              ++m_optionsLen;
+              NS_LOG_ERROR ("Option exceeds TCP option space; option discarded");
+              break;
+            }
+          if (!TcpOption::IsKindKnown (kind))
+            {
+              NS_LOG_WARN ("Option kind " << static_cast<int> (kind) << " unknown, skipping.");
             }
         }
+      m_optionsLen += optionSize;
     }
+  std::memcpy (m_options, options, m_optionsLen);
 
   if (m_length != CalculateHeaderLength ())
     {
@@ -452,13 +489,7 @@ TcpHeader::Deserialize (Buffer::Iterator start)
 uint8_t
 TcpHeader::CalculateHeaderLength () const
 {
-  uint32_t len = 20;
-  TcpOptionList::const_iterator i;
-
-  for (i = m_options.begin (); i != m_options.end (); ++i)
-    {
-      len += (*i)->GetSerializedSize ();
-    }
+  uint32_t len = 20 + m_optionsLen;
   // Option list may not include padding; need to pad up to word boundary
   if (len % 4)
     {
@@ -480,11 +511,11 @@ TcpHeader::AppendOption (Ptr<TcpOption> option)
 
       if (option->GetKind () != TcpOption::END)
         {
-          m_options.push_back (option);
-          m_optionsLen += option->GetSerializedSize ();
-
-          uint32_t totalLen = 20 + 3 + m_optionsLen;
-          m_length = totalLen >> 2;
+          uint32_t size = option->GetSerializedSize ();
+          Buffer buffer;
+          buffer.AddAtStart (size);
+          option->Serialize (buffer.Begin ());
+          buffer.CopyData (AllocateOption (size), size);
         }
 
       return true;
@@ -493,42 +524,159 @@ TcpHeader::AppendOption (Ptr<TcpOption> option)
   return false;
 }
 
-Ptr<TcpOption>
-TcpHeader::GetOption (uint8_t kind) const
+uint8_t*
+TcpHeader::AllocateOption (uint8_t length)
+{
+  if (m_optionsLen + length > m_maxOptionsLen)
+    {
+      return 0;
+    }
+  uint8_t *option = m_options + m_optionsLen;
+  m_optionsLen += length;
+
+  uint32_t totalLen = 20 + 3 + m_optionsLen;
+  m_length = totalLen >> 2;
+  return option;
+}
+
+const uint8_t*
+TcpHeader::NextOption (const uint8_t *after) const
 {
-  TcpOptionList::const_iterator i;
+  const uint8_t *option = (after == 0) ? m_options : after + OptionSize (after);
+  return (option < m_options + m_optionsLen) ? option : 0;
+}
 
-  for (i = m_options.begin (); i != m_options.end (); ++i)
+const uint8_t*
+TcpHeader::FindOption (uint8_t kind, const uint8_t *after) const
+{
+  for (const uint8_t *option = NextOption (after); option != 0; option = NextOption (option))
     {
-      if ((*i)->GetKind () == kind)
+      if (option[0] == kind)
         {
-          return (*i);
+          return option;
         }
     }
-
   return 0;
 }
 
+uint8_t*
+TcpHeader::FindOption (uint8_t kind, const uint8_t *after)
+{
+  return const_cast<uint8_t *> (static_cast<const TcpHeader *> (this)->FindOption (kind, after));
+}
+
+Ptr<TcpOption>
+TcpHeader::DeserializeOption (const uint8_t *option)
+{
+  uint8_t kind = option[0];
+  Ptr<TcpOption> op;
+  if (kind == TcpOption::MPTCP)
+    {
+      op = TcpOptionMpTcpMain::CreateMpTcpOption (option[2] >> 4);
+    }
+  else if (TcpOption::IsKindKnown (kind))
+    {
+      op = TcpOption::CreateOption (kind);
+    }
+  else
+    {
+      op = TcpOption::CreateOption (TcpOption::UNKNOWN);
+    }
+  uint32_t size = OptionSize (option);
+  Buffer buffer;
+  buffer.AddAtStart (size);
+  buffer.Begin ().Write (option, size);
+  op->Deserialize (buffer.Begin ());
+  return op;
+}
+
+Ptr<TcpOption>
+TcpHeader::GetOption (uint8_t kind) const
+{
+  const uint8_t *option = FindOption (kind);
+  return (option == 0) ? 0 : DeserializeOption (option);
+}
+
 void
 TcpHeader::GetOptions (TcpHeader::TcpOptionList& l) const
 {
-  l = m_options;
+  l.clear ();
+  for (const uint8_t *option = NextOption (); option != 0; option = NextOption (option))
+    {
+      l.push_back (DeserializeOption (option));
+    }
 }
   
 bool
 TcpHeader::HasOption (uint8_t kind) const
 {
-  TcpOptionList::const_iterator i;
+  return FindOption (kind) != 0;
+}
 
-  for (i = m_options.begin (); i != m_options.end (); ++i)
+bool
+TcpHeader::GetTimestamp (uint32_t &value, uint32_t &echo) const
+{
+  const uint8_t *option = FindOption (TcpOption::TS);
+  if (option == 0)
     {
-      if ((*i)->GetKind () == kind)
-        {
-          return true;
-        }
+      return false;
     }
+  value = ReadU32 (option + 2);
+  echo = ReadU32 (option + 6);
+  return true;
+}
 
-  return false;
+bool
+TcpHeader::AppendTimestamp (uint32_t value, uint32_t echo)
+{
+  uint8_t *option = AllocateOption (10);
+  if (option == 0)
+    {
+      return false;
+    }
+  option[0] = TcpOption::TS;
+  option[1] = 10;
+  WriteU32 (option + 2, value);
+  WriteU32 (option + 6, echo);
+  return true;
+}
+
+bool
+TcpHeader::SetTimestampValue (uint32_t value)
+{
+  uint8_t *option = FindOption (TcpOption::TS);
+  if (option == 0)
+    {
+      return false;
+    }
+  WriteU32 (option + 2, value);
+  return true;
+}
+
+bool
+TcpHeader::GetWindowScale (uint8_t &scale) const
+{
+  const uint8_t *option = FindOption (TcpOption::WINSCALE);
+  if (option == 0)
+    {
+      return false;
+    }
+  scale = option[2];
+  return true;
+}
+
+bool
+TcpHeader::AppendWindowScale (uint8_t scale)
+{
+  uint8_t *option = AllocateOption (3);
+  if (option == 0)
+    {
+      return false;
+    }
+  option[0] = TcpOption::WINSCALE;
+  option[1] = 3;
+  option[2] = scale;
+  return true;
 }
 
 bool
@@ -180,6 +180,12 @@ public:
 
   /**
    * \brief Get the option specified
+   *
+   * The options are stored serialized in the header: the option returned
+   * is a new object, deserialized from them, and modifying it does not
+   * modify the header. The typed accessors below, and FindOption, avoid
+   * the allocation.
+   *
    * \param kind the option to retrieve
    * \return Whether the header contains a specific kind of option, or 0
    */
@@ -190,9 +196,90 @@ public:
   /**
    * \brief Copy all options in a list
    * \note The list should be empty
-   * \param options Return a copy of the options
+   * \param options Return a copy of the options, deserialized as in GetOption
    */
   void GetOptions (TcpHeader::TcpOptionList& options) const;
+
+  /**
+   * \brief Iterate over the serialized options, NOPs included
+   *
+   * Each option starts with its kind; all but NOP have their length in
+   * their second byte. The options have been checked to fit in the header.
+   *
+   * \param after option returned by the previous call, or 0 for the first one
+   * \return the next option, or 0 after the last one
+   */
+  const uint8_t* NextOption (const uint8_t *after = 0) const;
+
+  /**
+   * \brief Find a serialized option, without deserializing it
+   * \param kind the option to find
+   * \param after option returned by the previous call, or 0 to search from the first one
+   * \return the option, or 0 if the header has no (more) option of this kind
+   */
+  const uint8_t* FindOption (uint8_t kind, const uint8_t *after = 0) const;
+
+  /**
+   * \copydoc FindOption
+   *
+   * The option can be modified in place, e.g. to update the value of a
+   * timestamp, as long as its kind and length are kept.
+   */
+  uint8_t* FindOption (uint8_t kind, const uint8_t *after = 0);
+
+  /**
+   * \brief Reserve room for an option at the end of the options
+   *
+   * The caller writes the whole option, kind and length included.
+   *
+   * \param length serialized size of the option
+   * \return where to write the option, or 0 if it does not fit
+   */
+  uint8_t* AllocateOption (uint8_t length);
+
+  /**
+   * \brief Deserialize an option, as stored in a TcpHeader, into a new TcpOption
+   * \param option option returned by NextOption or FindOption
+   * \return the option, TcpOptionUnknown for an unknown kind
+   */
+  static Ptr<TcpOption> DeserializeOption (const uint8_t *option);
+
+  /**
+   * \brief Read the timestamp option (RFC 1323)
+   * \param value TSval of the option
+   * \param echo TSecr of the option
+   * \return false if the header has no timestamp option
+   */
+  bool GetTimestamp (uint32_t &value, uint32_t &echo) const;
+
+  /**
+   * \brief Append a timestamp option
+   * \param value TSval of the option
+   * \param echo TSecr of the option
+   * \return true if the option has been appended, false otherwise
+   */
+  bool AppendTimestamp (uint32_t value, uint32_t echo);
+
+  /**
+   * \brief Update the TSval of the timestamp option
+   * \param value new TSval
+   * \return false if the header has no timestamp option
+   */
+  bool SetTimestampValue (uint32_t value);
+
+  /**
+   * \brief Read the window scale option (RFC 1323)
+   * \param scale shift count of the option
+   * \return false if the header has no window scale option
+   */
+  bool GetWindowScale (uint8_t &scale) const;
+
+  /**
+   * \brief Append a window scale option
+   * \param scale shift count of the option
+   * \return true if the option has been appended, false otherwise
+   */
+  bool AppendWindowScale (uint8_t scale);
   
   /**
    * \brief Get the total length of appended options
@@ -215,6 +302,10 @@ public:
 
   /**
    * \brief Append an option to the TCP header
+   *
+   * The option is serialized into the header: modifying it afterwards does
+   * not modify the header.
+   *
    * \param option The option to append
    * \return true if option has been appended, false otherwise
    */
@@ -338,7 +429,7 @@ private:
   SequenceNumber32 m_sequenceNumber;  //!< Sequence number
   SequenceNumber32 m_ackNumber;       //!< ACK number
   uint8_t m_length;             //!< Length (really a uint4_t) in words.
-  uint8_t m_flags;              //!< Flags (really a uint6_t)
+  uint8_t m_flags;              //!< Flags, with ECE and CWR (RFC 3168)
   uint16_t m_windowSize;        //!< Window size
   uint16_t m_urgentPointer;     //!< Urgent pointer
 
@@ -350,7 +441,7 @@ private:
   bool m_goodChecksum;    //!< Flag to indicate that checksum is correct
 
   static const uint8_t m_maxOptionsLen = 40;         //!< Maximum options length
-  TcpOptionList m_options;     //!< TcpOption present in the header
+  uint8_t m_options[m_maxOptionsLen];  //!< Serialized options, without the END padding
   uint8_t m_optionsLen;        //!< Tcp options length.
 };
 
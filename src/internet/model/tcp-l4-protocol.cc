@@ -22,6 +22,7 @@
 #include "ns3/log.h"
 #include "ns3/nstime.h"
 #include "ns3/boolean.h"
+#include "ns3/uinteger.h"
 #include "ns3/object-vector.h"
 
 #include "ns3/packet.h"
@@ -29,9 +30,11 @@
 #include "ns3/simulator.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv6-route.h"
+#include "ns3/gso-tag.h"
 
 #include "tcp-l4-protocol.h"
 #include "tcp-header.h"
+#include "tcp-option-ts.h"
 #include "ipv4-end-point-demux.h"
 #include "ipv6-end-point-demux.h"
 #include "ipv4-end-point.h"
@@ -48,6 +51,8 @@
 #include "mptcp-subflow.h"
 #include "tcp-socket-impl.h"
 #include "tcp-option-mptcp.h"
+#include "mptcp-crypto.h"
+#include "tcp-timer-wheel.h"
 
 #include <vector>
 #include <sstream>
@@ -62,6 +67,70 @@ NS_LOG_COMPONENT_DEFINE ("TcpL4Protocol");
 
 NS_OBJECT_ENSURE_REGISTERED (TcpL4Protocol);
 
+/**
+ * Registers TcpL4Protocol::SegmentIpv4 as the segmenter of the IPv4
+ * super-segments, when the library is loaded
+ */
+static class TcpGsoRegistration
+{
+public:
+  TcpGsoRegistration ()
+  {
+    GsoTag::SetSegmenter (Ipv4L3Protocol::PROT_NUMBER, MakeCallback (&TcpL4Protocol::SegmentIpv4));
+  }
+} g_tcpGsoRegistration;
+
+// Static, so defined before NS_LOG_APPEND_CONTEXT, which needs m_node
+void
+TcpL4Protocol::SegmentIpv4 (Ptr<Packet> packet, uint16_t segmentSize, std::list<Ptr<Packet> > &segments)
+{
+  NS_LOG_FUNCTION (packet << segmentSize);
+  NS_ASSERT (segmentSize > 0);
+
+  Ipv4Header ipHeader;
+  packet->RemoveHeader (ipHeader);
+  NS_ASSERT_MSG (ipHeader.GetProtocol () == PROT_NUMBER, "Not a TCP super-segment");
+  TcpHeader tcpHeader;
+  uint32_t headerSize = packet->PeekHeader (tcpHeader);
+  uint32_t payloadSize = packet->GetSize () - headerSize;
+  // The options are shared by the segments, which are all sent now
+  tcpHeader.SetTimestampValue (TcpOptionTS::NowToTsValue ());
+  if (Node::ChecksumEnabled ())
+    {
+      tcpHeader.EnableChecksums ();
+    }
+
+  uint16_t identification = ipHeader.GetIdentification ();
+  for (uint32_t offset = 0; offset < payloadSize; offset += segmentSize)
+    {
+      uint32_t size = std::min<uint32_t> (segmentSize, payloadSize - offset);
+      Ptr<Packet> segment = packet->CreateFragment (headerSize + offset, size);
+
+      TcpHeader header = tcpHeader;
+      header.SetSequenceNumber (tcpHeader.GetSequenceNumber () + offset);
+      if (offset + size < payloadSize)
+        {
+          header.SetFlags (header.GetFlags () & ~(TcpHeader::FIN | TcpHeader::PSH));
+        }
+      if (offset > 0)
+        { // The window reduction is signalled once, by the first segment
+          header.SetFlags (header.GetFlags () & ~TcpHeader::CWR);
+        }
+      header.InitializeChecksum (ipHeader.GetSource (), ipHeader.GetDestination (), PROT_NUMBER);
+      segment->AddHeader (header);
+
+      Ipv4Header segmentIpHeader = ipHeader;
+      segmentIpHeader.SetPayloadSize (segment->GetSize ());
+      segmentIpHeader.SetIdentification (identification++);
+      if (Node::ChecksumEnabled ())
+        {
+          segmentIpHeader.EnableChecksum ();
+        }
+      segment->AddHeader (segmentIpHeader);
+      segments.push_back (segment);
+    }
+}
+
 //TcpL4Protocol stuff----------------------------------------------------------
 
 #undef NS_LOG_APPEND_CONTEXT
@@ -92,6 +161,17 @@ TcpL4Protocol::GetTypeId (void)
 //                   BooleanValue (false),
 //                   MakeBooleanAccessor (&TcpL4Protocol::m_mptcpEnabled),
 //                   MakeBooleanChecker ())
+    .AddAttribute ("MpTcpKeyPoolSize",
+                   "Number of MPTCP keys (and their token and IDSN) generated at once.",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&TcpL4Protocol::m_mptcpKeyPoolSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("TimerWheelGranularity",
+                   "Tick of the timer wheel running the TCP timers of the node; "
+                   "zero schedules every timer in the simulator instead.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&TcpL4Protocol::m_timerWheelGranularity),
+                   MakeTimeChecker (Seconds (0)))
     .AddAttribute ("SocketList", "The list of sockets associated to this protocol.",
                    ObjectVectorValue (),
                    MakeObjectVectorAccessor (&TcpL4Protocol::m_sockets),
@@ -104,7 +184,8 @@ TcpL4Protocol::TcpL4Protocol ()
   :
     m_mptcpEnabled(false),
     m_endPoints (new Ipv4EndPointDemux ()),
-    m_endPoints6 (new Ipv6EndPointDemux ())
+    m_endPoints6 (new Ipv6EndPointDemux ()),
+    m_mptcpKeyPoolSize (64)
 {
   NS_LOG_FUNCTION_NOARGS ();
   NS_LOG_LOGIC ("Made a TcpL4Protocol " << this);
@@ -185,6 +266,12 @@ TcpL4Protocol::DoDispose (void)
       m_endPoints6 = 0;
     }
 
+  if (m_timerWheel != 0)
+    {
+      m_timerWheel->Dispose ();
+      m_timerWheel = 0;
+    }
+
   m_node = 0;
   m_downTarget.Nullify ();
   m_downTarget6.Nullify ();
@@ -472,6 +559,38 @@ void TcpL4Protocol::AddTokenMapping(uint32_t token, Ptr<MpTcpMetaSocket> meta)
   m_mptcpMetaSockets[token] = meta;
 }
 
+void
+TcpL4Protocol::DrawMpTcpKey (uint64_t& key, uint32_t& token, uint64_t& idsn)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_mptcpKeyPool)
+    {
+      m_mptcpKeyPool = Create<MpTcpKeyPool> (m_mptcpKeyPoolSize);
+    }
+  m_mptcpKeyPool->Draw (key, token, idsn);
+}
+
+uint32_t
+TcpL4Protocol::DrawMpTcpNonce (void)
+{
+  if (!m_mptcpKeyPool)
+    {
+      m_mptcpKeyPool = Create<MpTcpKeyPool> (m_mptcpKeyPoolSize);
+    }
+  return m_mptcpKeyPool->DrawNonce ();
+}
+
+Ptr<TcpTimerWheel>
+TcpL4Protocol::GetTimerWheel (void)
+{
+  if (m_timerWheel == 0 && m_timerWheelGranularity.IsStrictlyPositive ())
+    {
+      m_timerWheel = CreateObject<TcpTimerWheel> ();
+      m_timerWheel->SetGranularity (m_timerWheelGranularity);
+    }
+  return m_timerWheel;
+}
+
 
 enum IpL4Protocol::RxStatus
 TcpL4Protocol::Receive (Ptr<Packet> packet,
@@ -22,6 +22,7 @@
 #define TCP_L4_PROTOCOL_H
 
 #include <stdint.h>
+#include <list>
 #include <unordered_map>
 
 #include "ns3/ipv4-address.h"
@@ -44,6 +45,8 @@ class Ipv6EndPoint;
 //class MpTcpSubflow;
 class TcpSocketBase;
 class MpTcpMetaSocket;
+class MpTcpKeyPool;
+class TcpTimerWheel;
 class TcpCongestionOps;
 class TcpSocketImpl;
 
@@ -192,6 +195,24 @@ public:
   Ptr<MpTcpMetaSocket> LookupMpTcpToken (uint32_t token);
 
   void AddTokenMapping(uint32_t token, Ptr<MpTcpMetaSocket> meta);
+
+  /**
+   * \brief Take a new MPTCP key, along with its token and IDSN, from the node's key pool
+   *
+   * The token is not checked against the connections already open.
+   */
+  void DrawMpTcpKey (uint64_t& key, uint32_t& token, uint64_t& idsn);
+
+  /**
+   * \return A random nonce for the MP_JOIN handshake
+   */
+  uint32_t DrawMpTcpNonce (void);
+
+  /**
+   * \return The timer wheel of the node's sockets, created on first use, or
+   * 0 if the TimerWheelGranularity attribute is zero
+   */
+  Ptr<TcpTimerWheel> GetTimerWheel (void);
   
 
   /**
@@ -207,6 +228,20 @@ public:
                    const Address &saddr, const Address &daddr,
                    Ptr<NetDevice> oif = 0) const;
 
+  /**
+   * \brief Cut a TCP super-segment over IPv4 into wire segments
+   *
+   * This is the GsoTag::Segmenter of IPv4, registered when the library is
+   * loaded. Each segment gets its sequence number, the FIN and PSH flags
+   * only if it is the last one, a timestamp of the time it is cut, its
+   * checksums and the next IPv4 identification.
+   *
+   * \param packet The super-segment, starting with its IPv4 header
+   * \param segmentSize The payload size of each segment
+   * \param segments The list to append the segments to
+   */
+  static void SegmentIpv4 (Ptr<Packet> packet, uint16_t segmentSize, std::list<Ptr<Packet> > &segments);
+
   /**
    * \brief Make a socket fully operational
    *
@@ -315,6 +350,10 @@ private:
   
   //Multipath meta sockets, keyed by their tokens.
   std::unordered_map<uint32_t, Ptr<MpTcpMetaSocket>> m_mptcpMetaSockets;
+  Ptr<MpTcpKeyPool> m_mptcpKeyPool;  //!< Keys hashed in advance, created on first use
+  uint32_t m_mptcpKeyPoolSize;       //!< Number of keys hashed at once by m_mptcpKeyPool
+  Ptr<TcpTimerWheel> m_timerWheel;   //!< Timer wheel of the sockets, created on first use
+  Time m_timerWheelGranularity;      //!< Tick of m_timerWheel, zero to disable it
 
   /**
    * \brief Copy constructor
@@ -20,6 +20,8 @@
 
 #include "tcp-option-mptcp.h"
 #include "ns3/log.h"
+#include "ns3/unused.h"
+#include <cstring>
 
 
 static inline
@@ -27,6 +29,45 @@ uint64_t TRUNC_TO_32(uint64_t seq) {
   return static_cast<uint32_t>(seq);
 }
 
+// Network order accessors for the options written in place (MpTcpDss)
+static inline uint8_t*
+WriteU16 (uint8_t *data, uint16_t value)
+{
+  data[0] = value >> 8;
+  data[1] = value & 0xff;
+  return data + 2;
+}
+
+static inline uint8_t*
+WriteU32 (uint8_t *data, uint32_t value)
+{
+  return WriteU16 (WriteU16 (data, value >> 16), value & 0xffff);
+}
+
+static inline uint8_t*
+WriteU64 (uint8_t *data, uint64_t value)
+{
+  return WriteU32 (WriteU32 (data, value >> 32), value & 0xffffffff);
+}
+
+static inline uint16_t
+ReadU16 (const uint8_t *data)
+{
+  return (uint16_t (data[0]) << 8) | data[1];
+}
+
+static inline uint32_t
+ReadU32 (const uint8_t *data)
+{
+  return (uint32_t (ReadU16 (data)) << 16) | ReadU16 (data + 2);
+}
+
+static inline uint64_t
+ReadU64 (const uint8_t *data)
+{
+  return (uint64_t (ReadU32 (data)) << 32) | ReadU32 (data + 4);
+}
+
 
 namespace ns3 {
 
@@ -452,7 +493,7 @@ TcpOptionMpTcpJoin::operator== (const TcpOptionMpTcpJoin& opt) const
                );
 
     case Ack:
-      return true;
+      return memcmp (GetHmac (), opt.GetHmac (), 20) == 0;
     }
 
   NS_FATAL_ERROR ( "This should never trigger. Contact ns3 team");
@@ -471,7 +512,7 @@ uint32_t
 TcpOptionMpTcpJoin::GetNonce () const
 {
   NS_ASSERT_MSG (m_mode & (Syn | SynAck), "Nonce only available in Syn and SynAck modes");
-  return m_buffer[0];
+  return (m_mode == Syn) ? m_buffer[1] : m_buffer[2];
 }
 
 
@@ -527,11 +568,8 @@ TcpOptionMpTcpJoin::Serialize (Buffer::Iterator i) const
       break;
 
     case Ack:
-      // +=4 cos' amount of bytes we write
-      for (int j = 0; j < m_mode / 4 - 1; j++)
-        {
-          i.WriteHtonU32 ( m_buffer[j]);
-        }
+      // the hmac is kept as raw bytes, in the order it is sent
+      i.Write ( (const uint8_t*)&m_buffer, 20);
       break;
     default:
       NS_FATAL_ERROR("Unhandled case");
@@ -542,10 +580,7 @@ const uint8_t*
 TcpOptionMpTcpJoin::GetHmac () const
 {
   NS_ASSERT_MSG (m_mode == Ack, "Only available in Ack mode");
-//  i.Read( &m_hmac[0], 20);
-//  m_buffer.Read();
-//  return &m_hmac[0];
-  return 0;
+  return (const uint8_t*)&m_buffer;
 }
 
 
@@ -591,8 +626,8 @@ TcpOptionMpTcpJoin::Deserialize (Buffer::Iterator i)
 void
 TcpOptionMpTcpJoin::SetHmac (uint8_t hmac[20])
 {
-  NS_LOG_ERROR ("Not implemented");
-//  std::copy(hmac, hmac+20,m_hmac);
+  NS_ASSERT_MSG (m_mode == Ack, "Only available in Ack mode");
+  memcpy (&m_buffer, hmac, 20);
 }
 
 
@@ -632,15 +667,20 @@ TcpOptionMpTcpJoin::GetTruncatedHmac () const
 ///////////////////////////////////////:
 //// MP_DSS
 ////
-TcpOptionMpTcpDSS::TcpOptionMpTcpDSS ()
-  : TcpOptionMpTcp (),
-    m_hasChecksum (false),
+MpTcpDss::MpTcpDss ()
+  : m_hasChecksum (false),
     m_checksum (0),
     m_flags (0),
     m_dataAck (0),
     m_dsn (0),
     m_ssn (0),
     m_dataLevelLength (0)
+{
+}
+
+TcpOptionMpTcpDSS::TcpOptionMpTcpDSS ()
+  : TcpOptionMpTcp (),
+    MpTcpDss ()
 {
   NS_LOG_FUNCTION (this);
 }
@@ -671,7 +711,7 @@ TcpOptionMpTcpDSS::GetInstanceTypeId (void) const
 
 
 void
-TcpOptionMpTcpDSS::TruncateDSS(bool truncate)
+MpTcpDss::TruncateDSS(bool truncate)
 {
     NS_ASSERT_MSG(m_flags & DSNMappingPresent, "Call it only after setting the mapping");
 
@@ -714,7 +754,7 @@ TcpOptionMpTcpDSS::TruncateDSS(bool truncate)
 
 
 void
-TcpOptionMpTcpDSS::SetMapping (const SequenceNumber64& headDsn,
+MpTcpDss::SetMapping (const SequenceNumber64& headDsn,
                                const SequenceNumber32& headSsn,
                                uint16_t length, bool enable_dfin)
 {
@@ -735,7 +775,7 @@ TcpOptionMpTcpDSS::SetMapping (const SequenceNumber64& headDsn,
 
 
 void
-TcpOptionMpTcpDSS::GetMapping (uint64_t& dsn, uint32_t& ssn, uint16_t& length) const
+MpTcpDss::GetMapping (uint64_t& dsn, uint32_t& ssn, uint16_t& length) const
 {
   NS_ASSERT ( (m_flags & DSNMappingPresent) && !IsInfiniteMapping () );
   ssn = m_ssn;
@@ -747,17 +787,17 @@ TcpOptionMpTcpDSS::GetMapping (uint64_t& dsn, uint32_t& ssn, uint16_t& length) c
     }
 }
   
-SequenceNumber64 TcpOptionMpTcpDSS::GetDataSequenceNumber () const
+SequenceNumber64 MpTcpDss::GetDataSequenceNumber () const
 {
   return SequenceNumber64(m_dsn);
 }
   
-SequenceNumber32 TcpOptionMpTcpDSS::GetSubflowSequenceNumber () const
+SequenceNumber32 MpTcpDss::GetSubflowSequenceNumber () const
 {
   return SequenceNumber32(m_ssn);
 }
   
-uint16_t TcpOptionMpTcpDSS::GetMappingLength () const
+uint16_t MpTcpDss::GetMappingLength () const
 {
   uint16_t length = m_dataLevelLength;
   /*if((m_flags & DataFin) && !DataFinMappingOnly())
@@ -769,14 +809,20 @@ uint16_t TcpOptionMpTcpDSS::GetMappingLength () const
 
 
 uint32_t
-TcpOptionMpTcpDSS::GetSerializedSize (void) const
+MpTcpDss::GetSerializedSize (void) const
 {
   uint32_t len = GetSizeFromFlags (m_flags) + ((m_hasChecksum) ? 2 : 0);
   return len;
 }
 
+uint32_t
+TcpOptionMpTcpDSS::GetSerializedSize (void) const
+{
+  return MpTcpDss::GetSerializedSize ();
+}
+
 SequenceNumber64
-TcpOptionMpTcpDSS::GetDataAck (void) const
+MpTcpDss::GetDataAck (void) const
 {
   NS_ASSERT_MSG (m_flags & DataAckPresent,
                  "Can't request DataAck value when DataAck flag was not set. Check for its presence first" );
@@ -785,14 +831,14 @@ TcpOptionMpTcpDSS::GetDataAck (void) const
 
 
 void
-TcpOptionMpTcpDSS::SetChecksum (const uint16_t& checksum)
+MpTcpDss::SetChecksum (const uint16_t& checksum)
 {
   m_hasChecksum = checksum;
 }
 
 
 uint16_t
-TcpOptionMpTcpDSS::GetChecksum (void) const
+MpTcpDss::GetChecksum (void) const
 {
   NS_ASSERT (m_hasChecksum);
   return m_checksum;
@@ -800,6 +846,12 @@ TcpOptionMpTcpDSS::GetChecksum (void) const
 
 void
 TcpOptionMpTcpDSS::Print (std::ostream& os) const
+{
+  MpTcpDss::Print (os);
+}
+
+void
+MpTcpDss::Print (std::ostream& os) const
 {
 
   os << " MP_DSS: ";
@@ -834,21 +886,23 @@ TcpOptionMpTcpDSS::Print (std::ostream& os) const
 
 
 void
-TcpOptionMpTcpDSS::Serialize (Buffer::Iterator i) const
+MpTcpDss::Write (uint8_t *option) const
 {
-  TcpOptionMpTcp::SerializeRef (i);
-  i.WriteU8 ( GetSubType () << 4);
-  i.WriteU8 ( m_flags );
+  option[0] = TcpOption::MPTCP;
+  option[1] = GetSerializedSize ();
+  option[2] = TcpOptionMpTcpMain::MP_DSS << 4;
+  option[3] = m_flags;
+  uint8_t *i = option + 4;
 
   if ( m_flags & DataAckPresent)
     {
       if ( m_flags & DataAckOf8Bytes)
         {
-          i.WriteHtonU64 ( m_dataAck );
+          i = WriteU64 (i, m_dataAck);
         }
       else
         {
-          i.WriteHtonU32 ( static_cast<uint32_t>(m_dataAck) );
+          i = WriteU32 (i, static_cast<uint32_t>(m_dataAck));
         }
     }
 
@@ -857,26 +911,46 @@ TcpOptionMpTcpDSS::Serialize (Buffer::Iterator i) const
 
       if ( m_flags & DSNOfEightBytes)
         {
-          i.WriteHtonU64 ( m_dsn );
+          i = WriteU64 (i, m_dsn);
         }
       else
         {
-          i.WriteHtonU32 (uint32_t(m_dsn));
+          i = WriteU32 (i, uint32_t(m_dsn));
         }
 
       // Write relative SSN
-      i.WriteHtonU32 ( m_ssn );
-      i.WriteHtonU16 ( m_dataLevelLength );
+      i = WriteU32 (i, m_ssn);
+      i = WriteU16 (i, m_dataLevelLength);
     }
 
   if (m_hasChecksum)
     {
-      i.WriteHtonU16 ( m_checksum );
+      WriteU16 (i, m_checksum);
+    }
+}
+
+void
+TcpOptionMpTcpDSS::Serialize (Buffer::Iterator i) const
+{
+  uint8_t option[MAX_SIZE];
+  Write (option);
+  i.Write (option, GetSerializedSize ());
+}
+
+bool
+MpTcpDss::AppendTo (TcpHeader &header) const
+{
+  uint8_t *option = header.AllocateOption (GetSerializedSize ());
+  if (option == 0)
+    {
+      return false;
     }
+  Write (option);
+  return true;
 }
 
 uint32_t
-TcpOptionMpTcpDSS::GetSizeFromFlags (uint16_t flags)
+MpTcpDss::GetSizeFromFlags (uint16_t flags)
 {
 
   uint32_t length = 4;
@@ -903,35 +977,36 @@ TcpOptionMpTcpDSS::GetSizeFromFlags (uint16_t flags)
   return length;
 }
 
-uint32_t
-TcpOptionMpTcpDSS::Deserialize (Buffer::Iterator i)
+bool
+MpTcpDss::Read (const uint8_t *option)
 {
-
-  uint32_t length =  TcpOptionMpTcpMain::DeserializeRef (i);
-
-  uint8_t subtype_and_reserved = i.ReadU8 ();
-
-  NS_ASSERT ( (subtype_and_reserved >> 4) == GetSubType ()  );
-  m_flags = i.ReadU8 ();
-
-  uint32_t shouldBeLength = GetSizeFromFlags (m_flags);
-
-  NS_ASSERT (shouldBeLength == length || shouldBeLength + 2 == length);
-
-  if (shouldBeLength + 2 == length)
+  uint32_t length = option[1];
+  if (option[0] != TcpOption::MPTCP || length < 4
+      || (option[2] >> 4) != TcpOptionMpTcpMain::MP_DSS)
+    {
+      return false;
+    }
+  uint8_t flags = option[3];
+  uint32_t shouldBeLength = GetSizeFromFlags (flags);
+  if (shouldBeLength != length && shouldBeLength + 2 != length)
     {
-      m_hasChecksum = true;
+      return false;
     }
+  m_flags = flags;
+  m_hasChecksum = (shouldBeLength + 2 == length);
+  const uint8_t *i = option + 4;
 
   if ( m_flags & DataAckPresent)
     {
       if ( m_flags & DataAckOf8Bytes)
         {
-          m_dataAck = i.ReadNtohU64 ();
+          m_dataAck = ReadU64 (i);
+          i += 8;
         }
       else
         {
-          m_dataAck = i.ReadNtohU32 ();
+          m_dataAck = ReadU32 (i);
+          i += 4;
         }
     }
 
@@ -941,36 +1016,61 @@ TcpOptionMpTcpDSS::Deserialize (Buffer::Iterator i)
 
       if ( m_flags & DSNOfEightBytes)
         {
-          m_dsn = i.ReadNtohU64 ();
+          m_dsn = ReadU64 (i);
+          i += 8;
         }
       else
         {
-          m_dsn = i.ReadNtohU32 ();
+          m_dsn = ReadU32 (i);
+          i += 4;
         }
 
-      m_ssn = i.ReadNtohU32 ();
-      m_dataLevelLength = i.ReadNtohU16 ();
-
-      // TODO
-//    if( (m_flags & DataFin) )
-//    {
-//        --dataLevelLength;
-//    }
-//
-//    m_mapping.Configure( SequenceNumber32(dataSeqNb ), dataLevelLength);
+      m_ssn = ReadU32 (i);
+      m_dataLevelLength = ReadU16 (i + 4);
+      i += 6;
     }
 
 
   if (m_hasChecksum)
     {
-      m_checksum = i.ReadNtohU16 ( );
+      m_checksum = ReadU16 (i);
     }
 
+  return true;
+}
+
+bool
+MpTcpDss::ReadFrom (const TcpHeader &header)
+{
+  for (const uint8_t *option = header.FindOption (TcpOption::MPTCP); option != 0;
+       option = header.FindOption (TcpOption::MPTCP, option))
+    {
+      if ((option[2] >> 4) == TcpOptionMpTcpMain::MP_DSS)
+        {
+          return Read (option);
+        }
+    }
+  return false;
+}
+
+uint32_t
+TcpOptionMpTcpDSS::Deserialize (Buffer::Iterator i)
+{
+  Buffer::Iterator start = i;
+  uint32_t length =  TcpOptionMpTcpMain::DeserializeRef (i);
+  NS_ASSERT (length >= 4 && length <= MAX_SIZE);
+
+  uint8_t option[MAX_SIZE];
+  start.Read (option, length);
+  bool valid = Read (option);
+  NS_ASSERT_MSG (valid, "Malformed DSS option");
+  NS_UNUSED (valid);
+
   return length;
 }
 
 uint8_t
-TcpOptionMpTcpDSS::GetFlags (void) const
+MpTcpDss::GetFlags (void) const
 {
   return m_flags;
 }
@@ -982,20 +1082,20 @@ sequence number of 0, a Data-Level Length of 1, and the data sequence
 number that corresponds with the DATA_FIN itself
 */
 bool
-TcpOptionMpTcpDSS::DataFinMappingOnly () const
+MpTcpDss::DataFinMappingOnly () const
 {
   return (m_flags & DataFin) && m_dataLevelLength == 1 && m_ssn == 0;
 }
 
 bool
-TcpOptionMpTcpDSS::IsInfiniteMapping () const
+MpTcpDss::IsInfiniteMapping () const
 {
   //  The checksum, in such a case, will also be set to zero
   return (GetFlags () & DSNMappingPresent) && m_dataLevelLength == 0;
 }
 
 uint64_t
-TcpOptionMpTcpDSS::GetDataFinDSN () const
+MpTcpDss::GetDataFinDSN () const
 {
   NS_ASSERT ( GetFlags () & DataFin);
 
@@ -1012,7 +1112,7 @@ TcpOptionMpTcpDSS::GetDataFinDSN () const
 
 
 void
-TcpOptionMpTcpDSS::SetDataAck (uint64_t dack, bool send_as_32bits)
+MpTcpDss::SetDataAck (uint64_t dack, bool send_as_32bits)
 {
   NS_LOG_LOGIC (this << dack);
 
@@ -1031,7 +1131,7 @@ TcpOptionMpTcpDSS::SetDataAck (uint64_t dack, bool send_as_32bits)
 }
 
 bool
-TcpOptionMpTcpDSS::operator== (const TcpOptionMpTcpDSS& opt) const
+MpTcpDss::operator== (const MpTcpDss& opt) const
 {
 
   bool ret = m_flags == opt.m_flags;
@@ -1042,6 +1142,13 @@ TcpOptionMpTcpDSS::operator== (const TcpOptionMpTcpDSS& opt) const
   return ( ret );
 }
 
+std::ostream&
+operator<< (std::ostream& os, const MpTcpDss& dss)
+{
+  dss.Print (os);
+  return os;
+}
+
 
 ///////////////////////////////////////:
 //// ADD_ADDR
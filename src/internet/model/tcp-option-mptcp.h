@@ -419,7 +419,7 @@ public:
   /**
   * \brief Returns hmac generated by the peer.
   * \warning Available in Ack mode only
-  * \return null for now (not implemented)
+  * \return Pointer to the 20 bytes of the hmac
   */
   virtual const uint8_t* GetHmac (void) const;
 
@@ -427,7 +427,6 @@ public:
   * \brief Available only in Ack mode. Sets Hmac computed from the nonce, tokens previously exchanged
   * \warning Available in Ack mode only
   * \param hmac
-  * \todo not implemented
   */
   virtual void SetHmac (uint8_t hmac[20]);
 
@@ -491,7 +490,7 @@ private:
 
 
 /**
- * \brief DSS option (Data Sequence Signaling)
+ * \brief Content of a DSS option (Data Sequence Signaling)
  *
  * This option can transport 3 different optional semantic information.
  * First it is important to understand that MPTCP uses an additional sequence number space
@@ -529,8 +528,12 @@ private:
  +-------------------------------+------------------------------+
 
 \endverbatim
+ *
+ * The DSS option is carried by almost every segment: this value class
+ * writes and reads it directly in the option space of a TcpHeader, without
+ * the allocation of a TcpOptionMpTcpDSS.
 */
-class TcpOptionMpTcpDSS : public TcpOptionMpTcp<TcpOptionMpTcpMain::MP_DSS>
+class MpTcpDss
 {
 
 public:
@@ -549,31 +552,31 @@ public:
 
   };
 
-  static TypeId GetTypeId (void);
-  virtual TypeId GetInstanceTypeId (void) const;
-
-  TcpOptionMpTcpDSS (void);
-  virtual ~TcpOptionMpTcpDSS (void);
+  /**
+   * Largest serialized size, with 8 bytes DACK and DSN and the checksum
+   */
+  static const uint8_t MAX_SIZE = 28;
 
+  MpTcpDss (void);
 
   /**
    * \brief Upon detecting an error, an MPTCP connection can fallback to legacy TCP.
    *
    * \return False (not implemented)
    */
-  virtual bool IsInfiniteMapping () const;
+  bool IsInfiniteMapping () const;
 
   /**
    * \brief when DataFin is set, the data level length is increased by one.
    * \return True if the mapping present is just because of the datafin
    */
-  virtual bool DataFinMappingOnly () const;
+  bool DataFinMappingOnly () const;
 
 
   /**
    *
    */
-  virtual void TruncateDSS(bool truncate);
+  void TruncateDSS(bool truncate);
 
   /**
    * \brief This returns a copy
@@ -583,74 +586,92 @@ public:
   // Disabled to remove dependancy towards MpTcpMapping
   // ToDo prepare a wrapper to create mapping from that
 //  MpTcpMapping GetMapping(void) const;
-  virtual void GetMapping (uint64_t& dsn, uint32_t& ssn, uint16_t& length) const;
+  void GetMapping (uint64_t& dsn, uint32_t& ssn, uint16_t& length) const;
   
-  virtual SequenceNumber64 GetDataSequenceNumber () const;
-  virtual SequenceNumber32 GetSubflowSequenceNumber () const;
-  virtual uint16_t GetMappingLength () const;
+  SequenceNumber64 GetDataSequenceNumber () const;
+  SequenceNumber32 GetSubflowSequenceNumber () const;
+  uint16_t GetMappingLength () const;
 
   /**
    * \brief
    * \param trunc_to_32bits Set to true to send a 32bit DSN
    * \warn Mapping can be set only once, otherwise it will crash ns3
    */
-  virtual void SetMapping (const SequenceNumber64& headDsn,
-                           const SequenceNumber32& headSsn,
-                           uint16_t length, bool enable_dfin);
+  void SetMapping (const SequenceNumber64& headDsn,
+                   const SequenceNumber32& headSsn,
+                   uint16_t length, bool enable_dfin);
 
   /**
    * \brief A DSS length depends on what content it embeds. This is defined by the flags.
    * \return All flags
    */
-  virtual uint8_t GetFlags (void) const;
+  uint8_t GetFlags (void) const;
 
 
-  virtual bool operator== (const TcpOptionMpTcpDSS&) const;
+  bool operator== (const MpTcpDss&) const;
 
   /**
   * \brief Set seq nb of acked data at MPTP level
   * \param dack Sequence number of the dataack
   * \param send_as_32bits Decides if the DACK should be sent as a 32 bits number
   */
-  virtual void SetDataAck (uint64_t dack, bool send_as_32bits = true);
+  void SetDataAck (uint64_t dack, bool send_as_32bits = true);
 
   /**
   * \brief Get data ack value
   *
   * \warning  check the flags to know if the returned value is a 32 or 64 bits DSN
   */
-  virtual SequenceNumber64 GetDataAck (void) const;
+  SequenceNumber64 GetDataAck (void) const;
 
   /**
    * \brief Unimplemented
    */
-  virtual void SetChecksum (const uint16_t&);
+  void SetChecksum (const uint16_t&);
 
   /**
    * \brief Unimplemented
    */
-  virtual uint16_t GetChecksum (void) const;
-
-  /**
-   * \brief Enable also a mapping flag
-   * \param final_dsn Last MPTCP sequence number. Will be ignored if a mapping had been previsouly set.
-   * \param send_as_32bits Set to true to truncate final_dsn to its 32 bits version
-   *
-   */
-//  virtual void AddDataFin ();
+  uint16_t GetChecksum (void) const;
 
   /**
   * \return If DFIN is set, returns its associated DSN
   *
   * \warning check the flags to know if it returns a 32 or 64 bits DSN
   */
-  virtual uint64_t GetDataFinDSN () const;
+  uint64_t GetDataFinDSN () const;
 
+  void Print (std::ostream &os) const;
 
-  virtual void Print (std::ostream &os) const;
-  virtual void Serialize (Buffer::Iterator ) const;
-  virtual uint32_t Deserialize (Buffer::Iterator start);
-  virtual uint32_t GetSerializedSize (void) const;
+  /**
+   * \return the serialized size of the option, kind and length included
+   */
+  uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \brief Write the whole option
+   * \param option at least GetSerializedSize bytes
+   */
+  void Write (uint8_t *option) const;
+
+  /**
+   * \brief Read a whole option
+   * \param option serialized option, e.g. from TcpHeader::FindOption
+   * \return false, without reading it, if the option is not a well formed DSS option
+   */
+  bool Read (const uint8_t *option);
+
+  /**
+   * \brief Read the DSS option of a header
+   * \return false if the header has no (well formed) DSS option
+   */
+  bool ReadFrom (const TcpHeader &header);
+
+  /**
+   * \brief Append the option to a header
+   * \return false if it does not fit in the option space of the header
+   */
+  bool AppendTo (TcpHeader &header) const;
 
   /**
   * \brief the DSS option size can change a lot
@@ -674,6 +695,30 @@ protected:
   uint64_t m_dsn;               /**< Data Sequence Number (Can be On 32 bits dependings on the flags) */
   uint32_t m_ssn;               /**< Subflow Sequence Number, always 32bits */
   uint16_t m_dataLevelLength;   /**< Length of the mapping and/or +1 if DFIN */
+};
+
+std::ostream& operator<< (std::ostream& os, const MpTcpDss& dss);
+
+/**
+ * \brief DSS option (Data Sequence Signaling), as a TcpOption
+ *
+ * \see MpTcpDss
+ */
+class TcpOptionMpTcpDSS : public TcpOptionMpTcp<TcpOptionMpTcpMain::MP_DSS>,
+                          public MpTcpDss
+{
+
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  TcpOptionMpTcpDSS (void);
+  virtual ~TcpOptionMpTcpDSS (void);
+
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator ) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
 
 private:
   //! Defined and unimplemented to avoid misuse
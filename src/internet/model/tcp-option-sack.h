@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_OPTION_SACK_H
+#define TCP_OPTION_SACK_H
+
+#include "ns3/tcp-option.h"
+#include "ns3/sequence-number.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Defines the TCP option of kind 5 (selective acknowledgment option) as in \RFC{2018}
+ *
+ * Each block of the option reports a contiguous range of data received
+ * above the cumulative acknowledgment, as its first sequence number and
+ * the sequence number following its last byte. The first block reports
+ * the range holding the most recently received segment.
+ *
+ * The option takes 2 + 8 * n bytes for n blocks; the 40 bytes of option
+ * space limit it to 4 blocks, or 3 with the timestamp option.
+ */
+class TcpOptionSack : public TcpOption
+{
+public:
+  /// A SACK block: the left edge and the right edge of the range
+  typedef std::pair<SequenceNumber32, SequenceNumber32> SackBlock;
+  /// The blocks of the option, in order
+  typedef std::vector<SackBlock> SackList;
+
+  /// The maximum number of blocks of an option
+  static const uint32_t MAX_BLOCKS = 4;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  TcpOptionSack ();
+  virtual ~TcpOptionSack ();
+
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  virtual uint8_t GetKind (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \brief Append a block to the option
+   *
+   * \param block The block, which must not be empty
+   */
+  void AddSackBlock (SackBlock block);
+
+  /**
+   * \brief Get the number of blocks of the option
+   * \return The number of blocks
+   */
+  uint32_t GetNumSackBlocks (void) const;
+
+  /**
+   * \brief Get the blocks of the option
+   * \return The blocks, in the order of the option
+   */
+  const SackList & GetSackList (void) const;
+
+  /**
+   * \brief Remove the blocks of the option
+   */
+  void ClearSackList (void);
+
+protected:
+  SackList m_sackList; //!< The blocks
+};
+
+} // namespace ns3
+
+#endif /* TCP_OPTION_SACK_H */
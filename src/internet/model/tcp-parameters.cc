@@ -27,10 +27,19 @@ namespace ns3 {
                                   , m_clockGranularity (Seconds (0.001))
                                   , m_retxThresh (3)
                                   , m_limitedTx (false)
+                                  , m_pacing (false)
+                                  , m_pacingSsRatio (200)
+                                  , m_pacingCaRatio (120)
+                                  , m_maxPacingRate (DataRate ("4Gb/s"))
+                                  , m_gso (false)
+                                  , m_gsoMaxSize (64000)
                                   , m_maxWinSize (0)
                                   , m_mptcpEnabled (false)
                                   , m_winScalingEnabled (false)
                                   , m_timestampEnabled (false)
+                                  , m_sackEnabled (false)
+                                  , m_rackEnabled (false)
+                                  , m_ecnEnabled (false)
                                   , m_cnTimeout (Seconds (0.0))
                                   , m_synRetries (0)
                                   , m_dataRetries (0)
@@ -53,10 +62,19 @@ namespace ns3 {
                                                               , m_clockGranularity (params.m_clockGranularity)
                                                               , m_retxThresh (params.m_retxThresh)
                                                               , m_limitedTx (params.m_limitedTx)
+                                                              , m_pacing (params.m_pacing)
+                                                              , m_pacingSsRatio (params.m_pacingSsRatio)
+                                                              , m_pacingCaRatio (params.m_pacingCaRatio)
+                                                              , m_maxPacingRate (params.m_maxPacingRate)
+                                                              , m_gso (params.m_gso)
+                                                              , m_gsoMaxSize (params.m_gsoMaxSize)
                                                               , m_maxWinSize (params.m_maxWinSize)
                                                               , m_mptcpEnabled (params.m_mptcpEnabled)
                                                               , m_winScalingEnabled (params.m_winScalingEnabled)
                                                               , m_timestampEnabled (params.m_timestampEnabled)
+                                                              , m_sackEnabled (params.m_sackEnabled)
+                                                              , m_rackEnabled (params.m_rackEnabled)
+                                                              , m_ecnEnabled (params.m_ecnEnabled)
                                                               , m_cnTimeout (params.m_cnTimeout)
                                                               , m_synRetries (params.m_synRetries)
                                                               , m_dataRetries (params.m_dataRetries)
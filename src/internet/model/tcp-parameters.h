@@ -23,6 +23,7 @@
 
 #include "ns3/simple-ref-count.h"
 #include "ns3/nstime.h"
+#include "ns3/data-rate.h"
 
 namespace ns3
 {
@@ -47,6 +48,14 @@ namespace ns3
     // Fast retransmit and recovery
     uint32_t          m_retxThresh;       //!< Fast Retransmit threshold
     bool              m_limitedTx;        //!< perform limited transmit
+    // Pacing
+    bool              m_pacing;           //!< Pace the segments instead of sending bursts
+    uint16_t          m_pacingSsRatio;    //!< Pacing rate over cWnd/RTT in slow start, in percent
+    uint16_t          m_pacingCaRatio;    //!< Pacing rate over cWnd/RTT in congestion avoidance, in percent
+    DataRate          m_maxPacingRate;    //!< Upper bound of the pacing rate
+    // Segmentation offload
+    bool              m_gso;              //!< Send super-segments, cut into segments by the device
+    uint16_t          m_gsoMaxSize;       //!< Largest payload of a super-segment
     // Window Management
     uint16_t          m_maxWinSize;       //!< Maximum window size to advertise
     
@@ -54,6 +63,9 @@ namespace ns3
     bool              m_mptcpEnabled;       //!< MPTCP Enabled
     bool              m_winScalingEnabled;  //!< Window Scale option enabled (RFC 7323)
     bool              m_timestampEnabled;   //!< Timestamp option enabled
+    bool              m_sackEnabled;        //!< SACK option enabled (RFC 2018)
+    bool              m_rackEnabled;        //!< RACK-TLP loss detection enabled (RFC 8985)
+    bool              m_ecnEnabled;         //!< ECN requested in the SYN (RFC 3168)
     
     //Properties from TcpSocket
     Time              m_cnTimeout;       //!< Timeout for connection retry
@@ -21,6 +21,7 @@
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/boolean.h"
 #include "tcp-rx-buffer.h"
 
 namespace ns3 {
@@ -41,6 +42,12 @@ TcpRxBuffer<uint32_t, int32_t>::GetTypeId (void)
                      "Next sequence number expected (RCV.NXT)",
                      MakeTraceSourceAccessor (&TcpRxBuffer::m_nextRxSeq),
                      "ns3::SequenceNumber32TracedValueCallback")
+    .AddAttribute ("VirtualPayload",
+                  "Only keep track of the sequence numbers received, Extract returns zero-filled packets",
+                  BooleanValue (false),
+                  MakeBooleanAccessor (&TcpRxBuffer32::SetVirtualPayload,
+                                       &TcpRxBuffer32::GetVirtualPayload),
+                  MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -59,6 +66,12 @@ TcpRxBuffer<uint64_t, int64_t>::GetTypeId (void)
                    "Next sequence number expected (RCV.NXT)",
                    MakeTraceSourceAccessor (&TcpRxBuffer::m_nextRxSeq),
                    "ns3::SequenceNumber64TracedValueCallback")
+  .AddAttribute ("VirtualPayload",
+                "Only keep track of the sequence numbers received, Extract returns zero-filled packets",
+                BooleanValue (false),
+                MakeBooleanAccessor (&TcpRxBuffer64::SetVirtualPayload,
+                                     &TcpRxBuffer64::GetVirtualPayload),
+                MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -74,7 +87,8 @@ NS_OBJECT_ENSURE_REGISTERED (TcpRxBuffer64);
  */
 template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
 TcpRxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::TcpRxBuffer (NUMERIC_TYPE n)
-  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0)
+  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0),
+    m_virtualPayload (false)
 {
 }
 
@@ -113,7 +127,7 @@ TcpRxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::Dump() const
   BufConstIterator i = m_data.begin ();
   for( ; i != m_data.end (); ++i)
   {
-    NS_LOG_DEBUG( "head:" << i->first << " of size:" << i->second->GetSize());
+    NS_LOG_DEBUG( "head:" << i->first << " of size:" << (i->second.tail - i->first));
   }
   NS_LOG_DEBUG("=== End of dump");
 }
@@ -191,6 +205,39 @@ TcpRxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::Finished (void)
   return (m_gotFin && m_finSeq < m_nextRxSeq);
 }
 
+/*
+ * Each Packet::AddAtEnd reallocates the buffer of the packet appended to,
+ * so appending n fragments one by one copies the first ones n times. Joined
+ * pairwise, each byte is copied once per round, log2 (n) times.
+ */
+static Ptr<Packet>
+JoinFragments (std::vector<Ptr<Packet> > &fragments)
+{
+  NS_ASSERT (!fragments.empty ());
+  for (uint32_t step = 1; step < fragments.size (); step *= 2)
+    {
+      for (uint32_t i = 0; i + step < fragments.size (); i += 2 * step)
+        {
+          fragments[i]->AddAtEnd (fragments[i + step]);
+          fragments[i + step] = 0;
+        }
+    }
+  return fragments[0];
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpRxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::MergeWithNext (BufIterator i)
+{
+  BufIterator next = i;
+  ++next;
+  NS_ASSERT (next != m_data.end () && i->second.tail == next->first);
+  NS_LOG_LOGIC ("Hole filled, merging block " << i->first << " with block " << next->first);
+  i->second.tail = next->second.tail;
+  i->second.data.splice (i->second.data.end (), next->second.data);
+  m_data.erase (next);
+}
+
 template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
 bool
 TcpRxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::Add (Ptr<Packet> p, SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> headSeq)
@@ -211,61 +258,90 @@ TcpRxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::Add (Ptr<Packet> p, SequenceNumber<NUMER
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end () && i->first <= tailSeq)
+  if (headSeq >= tailSeq)
+    {
+      NS_LOG_LOGIC ("Nothing to buffer");
+      return false; // Nothing to buffer anyway
+    }
+
+  // First block that ends at or after headSeq: the only one the packet can extend
+  BufIterator i = m_data.upper_bound (headSeq);
+  if (i != m_data.begin ())
     {
-      SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> lastByteSeq = i->first + SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> (i->second->GetSize ());
-      if (lastByteSeq > headSeq)
+      BufIterator prev = i;
+      --prev;
+      if (prev->second.tail >= headSeq)
         {
-          if (i->first > headSeq && lastByteSeq < tailSeq)
-            { // Rare case: Existing packet is embedded fully in the new packet
-              m_size -= i->second->GetSize ();
-              m_data.erase (i++);
+          i = prev;
+        }
+    }
+
+  // Store the parts of [headSeq, tailSeq) falling in holes
+  uint32_t stored = 0;
+  while (headSeq < tailSeq)
+    {
+      SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> pieceTail = tailSeq;
+      if (i != m_data.end () && i->first <= headSeq)
+        { // headSeq is within or right after block i
+          if (headSeq < i->second.tail)
+            { // Skip the bytes we already have
+              headSeq = i->second.tail;
               continue;
             }
-          if (i->first <= headSeq)
-            { // Incoming head is overlapped
-              headSeq = lastByteSeq;
+          BufIterator next = i;
+          ++next;
+          if (next != m_data.end () && next->first < pieceTail)
+            {
+              pieceTail = next->first;
+            }
+          if (!m_virtualPayload)
+            {
+              i->second.data.push_back (p->CreateFragment (headSeq - prevHeadSeq, pieceTail - headSeq));
+            }
+          i->second.tail = pieceTail;
+          if (next != m_data.end () && next->first == pieceTail)
+            {
+              MergeWithNext (i);
             }
-          if (lastByteSeq >= tailSeq)
-            { // Incoming tail is overlapped
-              tailSeq = i->first;
+        }
+      else
+        { // headSeq is in the hole before block i, or after the last block
+          if (i != m_data.end () && i->first < pieceTail)
+            {
+              pieceTail = i->first;
+            }
+          Block block;
+          block.tail = pieceTail;
+          if (!m_virtualPayload)
+            {
+              block.data.push_back (p->CreateFragment (headSeq - prevHeadSeq, pieceTail - headSeq));
+            }
+          i = m_data.insert (i, std::make_pair (headSeq, block));
+          BufIterator next = i;
+          ++next;
+          if (next != m_data.end () && next->first == pieceTail)
+            {
+              MergeWithNext (i);
             }
         }
-      ++i;
+      NS_LOG_LOGIC ("Buffered seqno=" << headSeq << " len=" << (pieceTail - headSeq));
+      stored += pieceTail - headSeq;
+      headSeq = pieceTail;
     }
-  // We now know how much we are going to store, trim the packet
-  if (headSeq >= tailSeq)
+  if (stored == 0)
     {
       NS_LOG_LOGIC ("Nothing to buffer");
-      return false; // Nothing to buffer anyway
-    }
-  else
-    {
-      uint32_t start = headSeq - prevHeadSeq;
-      uint32_t length = tailSeq - headSeq;
-      p = p->CreateFragment (start, length);
-      NS_ASSERT (length == p->GetSize ());
+      return false;
     }
-  // Insert packet into buffer
-  NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
-  m_data [ headSeq ] = p;
-  NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
+
   // Update variables
-  m_size += p->GetSize ();      // Occupancy
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  m_size += stored;      // Occupancy
+  // Only the first block can hold in-sequence data
+  BufIterator first = m_data.begin ();
+  if (first->first <= m_nextRxSeq && m_nextRxSeq < first->second.tail)
     {
-      if (i->first < m_nextRxSeq)
-        {
-          continue;
-        }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
+      m_availBytes += first->second.tail - m_nextRxSeq.Get ();
+      m_nextRxSeq = first->second.tail;
     }
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
   if (m_gotFin && m_nextRxSeq == m_finSeq)
@@ -285,42 +361,90 @@ TcpRxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::Extract (uint32_t maxSize)
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return 0;  // No contiguous block to return
   NS_ASSERT (m_data.size ()); // At least we have something to extract
-  Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
-  BufIterator i;
-  while (extractSize)
-    { // Check the buffered data for delivery
-      i = m_data.begin ();
-      NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
-      // Check if we send the whole pkt or just a partial
-      uint32_t pktSize = i->second->GetSize ();
-      if (pktSize <= extractSize)
-        { // Whole packet is extracted
-          outPkt->AddAtEnd (i->second);
-          m_data.erase (i);
-          m_size -= pktSize;
-          m_availBytes -= pktSize;
-          extractSize -= pktSize;
-        }
-      else
-        { // Partial is extracted and done
-          outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
-          m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
-          m_data.erase (i);
-          m_size -= extractSize;
-          m_availBytes -= extractSize;
-          extractSize = 0;
+  BufIterator i = m_data.begin ();
+  NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
+
+  Ptr<Packet> outPkt;
+  bool whole = i->second.tail == i->first + SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> (extractSize);
+  if (m_virtualPayload)
+    {
+      outPkt = Create<Packet> (extractSize);
+    }
+  else
+    { // Take the fragments read off the block, splitting the last one if need be
+      std::vector<Ptr<Packet> > fragments;
+      uint32_t taken = 0;
+      while (taken < extractSize)
+        {
+          Ptr<Packet> fragment = i->second.data.front ();
+          uint32_t fragmentSize = fragment->GetSize ();
+          if (taken + fragmentSize <= extractSize)
+            {
+              fragments.push_back (fragment);
+              i->second.data.pop_front ();
+              taken += fragmentSize;
+            }
+          else
+            {
+              fragments.push_back (fragment->CreateFragment (0, extractSize - taken));
+              i->second.data.front () = fragment->CreateFragment (extractSize - taken,
+                                                                  fragmentSize - (extractSize - taken));
+              taken = extractSize;
+            }
         }
+      outPkt = JoinFragments (fragments);
     }
-  if (outPkt->GetSize () == 0)
+  m_size -= extractSize;
+  m_availBytes -= extractSize;
+
+  if (whole)
     {
-      NS_LOG_LOGIC ("Nothing extracted.");
-      return 0;
+      m_data.erase (i);
+    }
+  else
+    { // Re-index what is left of the block
+      Block &rest = m_data[i->first + SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> (extractSize)];
+      rest.tail = i->second.tail;
+      rest.data.swap (i->second.data);
+      m_data.erase (i);
     }
   NS_LOG_LOGIC ("Extracted " << outPkt->GetSize ( ) << " bytes, bufsize=" << m_size
-                             << ", num pkts in buffer=" << m_data.size ());
+                             << ", num blocks in buffer=" << m_data.size ());
   return outPkt;
 }
 
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpRxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::SetVirtualPayload (bool virtualPayload)
+{
+  NS_LOG_FUNCTION (this << virtualPayload);
+  NS_ASSERT_MSG (m_size == 0, "Can't change the payload mode of a non empty buffer");
+  m_virtualPayload = virtualPayload;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+bool
+TcpRxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::GetVirtualPayload (void) const
+{
+  return m_virtualPayload;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+uint32_t
+TcpRxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::GetOutOfOrderBlocks (std::vector<std::pair<SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>,
+                                                                                   SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> > > &blocks) const
+{
+  blocks.clear ();
+  for (BufConstIterator i = m_data.begin (); i != m_data.end (); ++i)
+    {
+      if (i->first > m_nextRxSeq)
+        {
+          blocks.push_back (std::make_pair (i->first, i->second.tail));
+        }
+    }
+  return blocks.size ();
+}
+
 //Explicit instantiation of the types of TcpRxBuffers
 template class TcpRxBuffer<uint32_t, int32_t>;
 template class TcpRxBuffer<uint64_t, int64_t>;
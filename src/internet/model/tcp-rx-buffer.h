@@ -21,7 +21,9 @@
 #ifndef TCP_RX_BUFFER_H
 #define TCP_RX_BUFFER_H
 
+#include <list>
 #include <map>
+#include <vector>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
@@ -36,6 +38,16 @@ class Packet;
  *
  * \brief class for the reordering buffer that keeps the data from lower layer, i.e.
  *        TcpL4Protocol, sent to the application
+ *
+ * Received data is indexed as a list of disjoint blocks of contiguous bytes,
+ * the holes being the gaps between them (like SACK blocks). A new segment only
+ * needs to look up the block it lands next to, and fills the holes it overlaps.
+ * A block keeps the fragments of the segments it is made of, in order: storing
+ * a segment or merging two blocks copies no payload, the fragments read are
+ * only joined into one packet by Extract.
+ *
+ * With the VirtualPayload attribute, the blocks hold no packet at all and
+ * Extract returns zero-filled packets of the requested size.
  */
   
 template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
@@ -136,17 +148,49 @@ public:
    */
   Ptr<Packet> Extract (uint32_t maxSize);
 
+  /**
+   * \brief Get the out of order blocks, i.e. the data received beyond the first hole
+   * \param blocks filled with the [head, tail) sequence range of each block, in order
+   * \returns number of blocks
+   */
+  uint32_t GetOutOfOrderBlocks (std::vector<std::pair<SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>,
+                                                      SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> > > &blocks) const;
+
+  /**
+   * \brief Only keep track of the sequence numbers received, possible while the buffer is empty
+   * \param virtualPayload true to drop the payload of the received packets
+   */
+  void SetVirtualPayload (bool virtualPayload);
+
+  /**
+   * \returns true if the buffer drops the payload of the received packets
+   */
+  bool GetVirtualPayload (void) const;
+
 private:
+  /// Contiguous run of received bytes, keyed by its head sequence in the buffer
+  struct Block
+  {
+    SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> tail;  //!< Sequence following the last byte of the block
+    std::list<Ptr<Packet> > data;                    //!< Fragments of the block, in order (none with a virtual payload)
+  };
   /// container for data stored in the buffer
-  typedef typename std::map<SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>, Ptr<Packet> >::iterator BufIterator;
-  typedef typename std::map<SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>, Ptr<Packet> >::const_iterator BufConstIterator;
+  typedef typename std::map<SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>, Block>::iterator BufIterator;
+  typedef typename std::map<SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>, Block>::const_iterator BufConstIterator;
+
+  /**
+   * \brief Append the next block to block i, they must be adjacent
+   */
+  void MergeWithNext (BufIterator i);
+
   TracedValue<SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>>  m_nextRxSeq; //!< Seqnum of the first missing byte in data (RCV.NXT)
   SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>               m_finSeq;                 //!< Seqnum of the FIN packet
   bool m_gotFin;                             //!< Did I received FIN packet?
   uint32_t m_size;                           //!< Number of total data bytes in the buffer, not necessarily contiguous
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
-  std::map<SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  std::map<SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>, Block> m_data; //!< Blocks of received data, separated by holes
+  bool m_virtualPayload;                     //!< Don't store the packets, only their sequence numbers
 };
   
 typedef TcpRxBuffer<uint32_t, int32_t> TcpRxBuffer32;
@@ -41,6 +41,7 @@
 #include "ns3/double.h"
 #include "ns3/pointer.h"
 #include "ns3/trace-source-accessor.h"
+#include "ns3/gso-tag.h"
 #include "tcp-socket-base.h"
 #include "tcp-l4-protocol.h"
 #include "ipv4-end-point.h"
@@ -49,6 +50,8 @@
 #include "tcp-header.h"
 #include "tcp-option-winscale.h"
 #include "tcp-option-ts.h"
+#include "tcp-option-sack-permitted.h"
+#include "tcp-option-sack.h"
 #include "rtt-estimator.h"
 #include "tcp-congestion-ops.h"
 #include "tcp-option-mptcp.h"
@@ -140,6 +143,10 @@ TcpSocketBase::GetTypeId (void)
                      "TCP slow start threshold (bytes)",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_ssThTrace),
                      "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("PacingRate",
+                     "The current TCP pacing rate",
+                     MakeTraceSourceAccessor (&TcpSocketBase::m_pacingRateTrace),
+                     "ns3::TcpSocketState::DataRateTracedValueCallback")
     .AddTraceSource ("Tx",
                      "Send tcp packet to IP protocol",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_txTrace),
@@ -165,12 +172,16 @@ TcpSocketBase::TcpSocketBase (void)
     m_delAckEvent (),
     m_persistEvent (),
     m_timewaitEvent (),
+    m_rackEvent (),
+    m_lossProbeEvent (),
+    m_pacingTimer (),
     m_dupAckCount (0),
     m_delAckCount (0),
     m_synCount (0),
     m_dataRetrCount (0),
     m_rto (Seconds (0.0)),
     m_lastRtt (Seconds (0.0)),
+    m_minRtt (Seconds (0.0)),
     m_endPoint (0),
     m_endPoint6 (0),
     m_state (CLOSED),
@@ -189,6 +200,13 @@ TcpSocketBase::TcpSocketBase (void)
     // Set m_recover to the initial sequence number
     m_recover (0),
     m_retransOut (0),
+    m_lossProbeOut (false),
+    m_lastRxSegment (0),
+    m_ecn (false),
+    m_ceReceived (false),
+    m_ecnEcho (false),
+    m_ecnSendCwr (false),
+    m_ecnRecover (0),
     m_isFirstPartialAck (true)
 
 {
@@ -214,17 +232,30 @@ TcpSocketBase::TcpSocketBase (void)
   ok = m_tcb->TraceConnectWithoutContext ("HighestSequence",
                                           MakeCallback (&TcpSocketBase::UpdateHighTxMark, this));
   NS_ASSERT (ok == true);
+
+  ok = m_tcb->TraceConnectWithoutContext ("PacingRate",
+                                          MakeCallback (&TcpSocketBase::UpdatePacingRate, this));
+  NS_ASSERT (ok == true);
 }
 
 TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
   : TcpSocketImpl (sock),
     //copy object::m_tid and socket::callbacks
+    m_retxEvent (sock.m_retxEvent),
+    m_lastAckEvent (sock.m_lastAckEvent),
+    m_delAckEvent (sock.m_delAckEvent),
+    m_persistEvent (sock.m_persistEvent),
+    m_timewaitEvent (sock.m_timewaitEvent),
+    m_rackEvent (sock.m_rackEvent),
+    m_lossProbeEvent (sock.m_lossProbeEvent),
+    m_pacingTimer (sock.m_pacingTimer),
     m_dupAckCount (sock.m_dupAckCount),
     m_delAckCount (0),
     m_synCount (sock.m_synCount),
     m_dataRetrCount (sock.m_dataRetrCount),
     m_rto (sock.m_rto),
     m_lastRtt (sock.m_lastRtt),
+    m_minRtt (sock.m_minRtt),
     m_endPoint (0),
     m_endPoint6 (0),
     m_state (sock.m_state),
@@ -240,6 +271,13 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_timestampToEcho (sock.m_timestampToEcho),
     m_recover (sock.m_recover),
     m_retransOut (sock.m_retransOut),
+    m_lossProbeOut (sock.m_lossProbeOut),
+    m_lastRxSegment (sock.m_lastRxSegment),
+    m_ecn (sock.m_ecn),
+    m_ceReceived (sock.m_ceReceived),
+    m_ecnEcho (sock.m_ecnEcho),
+    m_ecnSendCwr (sock.m_ecnSendCwr),
+    m_ecnRecover (sock.m_ecnRecover),
     m_isFirstPartialAck (sock.m_isFirstPartialAck),
     m_txTrace (sock.m_txTrace),
     m_rxTrace (sock.m_rxTrace)
@@ -283,6 +321,10 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
 
   ok = m_tcb->TraceConnectWithoutContext ("HighestSequence",
                                           MakeCallback (&TcpSocketBase::UpdateHighTxMark, this));
+  NS_ASSERT (ok == true);
+
+  ok = m_tcb->TraceConnectWithoutContext ("PacingRate",
+                                          MakeCallback (&TcpSocketBase::UpdatePacingRate, this));
 }
 
 TcpSocketBase::~TcpSocketBase (void)
@@ -314,6 +356,23 @@ TcpSocketBase::~TcpSocketBase (void)
   CancelAllTimers ();
 }
 
+void
+TcpSocketBase::SetTcp (Ptr<TcpL4Protocol> tcp)
+{
+  NS_LOG_FUNCTION (this << tcp);
+  TcpSocketImpl::SetTcp (tcp);
+  Ptr<TcpTimerWheel> wheel = tcp->GetTimerWheel ();
+  m_retxEvent.SetWheel (wheel);
+  m_lastAckEvent.SetWheel (wheel);
+  m_delAckEvent.SetWheel (wheel);
+  m_persistEvent.SetWheel (wheel);
+  m_timewaitEvent.SetWheel (wheel);
+  m_rackEvent.SetWheel (wheel);
+  m_lossProbeEvent.SetWheel (wheel);
+  // The gaps between paced segments are shorter than the ticks of the
+  // wheel: the pacing timer stays on the simulator
+}
+
 
 /* Inherit from Socket class: Returns error code */
 enum Socket::SocketErrno
@@ -990,6 +1049,7 @@ TcpSocketBase::ForwardUp (Ptr<Packet> packet, Ipv4Header header, uint16_t port,
   Address fromAddress = InetSocketAddress (header.GetSource (), port);
   Address toAddress = InetSocketAddress (header.GetDestination (),
                                          m_endPoint->GetLocalPort ());
+  m_ceReceived = (header.GetEcn () == Ipv4Header::ECN_CE);
 
   DoForwardUp (packet, fromAddress, toAddress);
 }
@@ -1007,6 +1067,8 @@ TcpSocketBase::ForwardUp6 (Ptr<Packet> packet, Ipv6Header header, uint16_t port,
   Address fromAddress = Inet6SocketAddress (header.GetSourceAddress (), port);
   Address toAddress = Inet6SocketAddress (header.GetDestinationAddress (),
                                           m_endPoint6->GetLocalPort ());
+  // The ECN field is in the two low bits of the traffic class
+  m_ceReceived = ((header.GetTrafficClass () & 0x3) == 0x3);
 
   DoForwardUp (packet, fromAddress, toAddress);
 }
@@ -1072,6 +1134,11 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
 
 
     m_rxTrace (packet, tcpHeader, this);
+
+  if (packet->GetSize () > 0)
+    { // Reported first in the SACK blocks
+      m_lastRxSegment = seq;
+    }
   
   if (tcpHeader.GetFlags () & TcpHeader::SYN)
     {
@@ -1081,9 +1148,10 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
        */
       UpdateWindowSize(tcpHeader);
 
-      if (tcpHeader.HasOption (TcpOption::WINSCALE) && m_tcpParams->m_winScalingEnabled)
+      uint8_t scale;
+      if (m_tcpParams->m_winScalingEnabled && tcpHeader.GetWindowScale (scale))
         {
-          ProcessOptionWScale (tcpHeader.GetOption (TcpOption::WINSCALE));
+          ProcessOptionWScale (scale);
         }
       else
         {
@@ -1091,16 +1159,28 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
         }
 
       // When receiving a <SYN> or <SYN-ACK> we should adapt TS to the other end
-      if (tcpHeader.HasOption (TcpOption::TS) && m_tcpParams->m_timestampEnabled)
+      uint32_t value, echo;
+      if (m_tcpParams->m_timestampEnabled && tcpHeader.GetTimestamp (value, echo))
         {
-          ProcessOptionTimestamp (tcpHeader.GetOption (TcpOption::TS),
-                                  tcpHeader.GetSequenceNumber ());
+          ProcessOptionTimestamp (value, echo, tcpHeader.GetSequenceNumber ());
         }
       else
         {
           m_tcpParams->m_timestampEnabled = false;
         }
 
+      // SACK is used only if both ends sent the SACK-permitted option
+      if (!tcpHeader.HasOption (TcpOption::SACKPERMITTED))
+        {
+          m_tcpParams->m_sackEnabled = false;
+        }
+
+      // The listening socket negotiates ECN for the socket it forks
+      if (m_state != LISTEN)
+        {
+          NegotiateEcn (tcpHeader);
+        }
+
       // Initialize cWnd and ssThresh
       m_tcb->m_cWnd = GetInitialCwnd () * GetSegSize ();
       m_tcb->m_ssThresh = GetInitialSSThresh ();
@@ -1114,9 +1194,10 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
   else if (tcpHeader.GetFlags () & TcpHeader::ACK)
     {
       NS_ASSERT (!(tcpHeader.GetFlags () & TcpHeader::SYN));
+      uint32_t value, echo;
       if (m_tcpParams->m_timestampEnabled)
         {
-          if (!tcpHeader.HasOption (TcpOption::TS))
+          if (!tcpHeader.GetTimestamp (value, echo))
             {
               // Ignoring segment without TS, RFC 7323
               NS_LOG_LOGIC ("At state " << TcpStateName[m_state] <<
@@ -1127,8 +1208,7 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
             }
           else
             {
-              ProcessOptionTimestamp (tcpHeader.GetOption (TcpOption::TS),
-                                      tcpHeader.GetSequenceNumber ());
+              ProcessOptionTimestamp (value, echo, tcpHeader.GetSequenceNumber ());
             }
         }
 
@@ -1138,18 +1218,23 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
 
   //Process any options with side effects before running main TCP state machine
   ProcessOptions(tcpHeader, false);
+
+  if (m_ecn && packet->GetSize () > 0)
+    {
+      UpdateEcnEcho (tcpHeader);
+    }
   
   if (m_rWnd.Get () == 0 && m_persistEvent.IsExpired ())
     { // Zero window: Enter persist state to send 1 byte to probe
       NS_LOG_LOGIC (this << " Enter zerowindow persist state");
       NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                    (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
       m_retxEvent.Cancel ();
       NS_LOG_LOGIC ("Schedule persist timeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_tcpParams->m_persistTimeout).GetSeconds ());
-      m_persistEvent = Simulator::Schedule (m_tcpParams->m_persistTimeout, &TcpSocketBase::PersistTimeout, this);
-      NS_ASSERT (m_tcpParams->m_persistTimeout == Simulator::GetDelayLeft (m_persistEvent));
+      m_persistEvent.Schedule (m_tcpParams->m_persistTimeout, &TcpSocketBase::PersistTimeout, this);
+      NS_ASSERT (m_tcpParams->m_persistTimeout == m_persistEvent.GetDelayLeft ());
     }
 
   // TCP state machine code in different process functions
@@ -1167,7 +1252,7 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
       break;
     case CLOSED:
       // Send RST if the incoming packet is not a RST
-      if ((tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG)) != TcpHeader::RST)
+      if ((tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR)) != TcpHeader::RST)
         { // Since m_endPoint is not configured yet, we cannot use SendRST here
           TcpHeader h;
           GenerateEmptyPacketHeader(h, TcpHeader::RST);
@@ -1226,8 +1311,8 @@ TcpSocketBase::ProcessEstablished (Ptr<Packet> packet, const TcpHeader& tcpHeade
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
 
   // Different flags are different events
   if (tcpflags == TcpHeader::ACK)
@@ -1298,6 +1383,12 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
   NS_ASSERT (0 != (tcpHeader.GetFlags () & TcpHeader::ACK));
   NS_ASSERT (m_tcb->m_segmentSize > 0);
 
+  if (m_tcpParams->m_sackEnabled)
+    {
+      ReceivedAckSack (packet, tcpHeader);
+      return;
+    }
+
   SequenceNumber32 ackNumber = tcpHeader.GetAckNumber ();
   uint32_t bytesAcked = ackNumber - m_txBuffer->HeadSequence ();
   uint32_t segsAcked  = bytesAcked / m_tcb->m_segmentSize;
@@ -1319,6 +1410,11 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 
   m_tcb->m_lastAckedSeq = ackNumber;
 
+  if (m_ecn)
+    {
+      ProcessEcnEcho (tcpHeader, ackNumber > m_txBuffer->HeadSequence () ? bytesAcked : 0);
+    }
+
   if (ackNumber == m_txBuffer->HeadSequence ()
       && ackNumber < m_tcb->m_nextTxSequence
       && packet->GetSize () == 0)
@@ -1345,19 +1441,24 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 
           NS_LOG_DEBUG ("OPEN -> DISORDER");
         }
-      else if (m_tcb->m_congState == TcpSocketState::CA_DISORDER)
+      else if (m_tcb->m_congState == TcpSocketState::CA_DISORDER
+               || m_tcb->m_congState == TcpSocketState::CA_CWR)
         {
           if ((m_dupAckCount == m_tcpParams->m_retxThresh) && (m_highRxAckMark >= m_recover))
             {
               // triple duplicate ack triggers fast retransmit (RFC2582 sec.3 bullet #1)
               NS_LOG_DEBUG (TcpSocketState::TcpCongStateName[m_tcb->m_congState] <<
                             " -> RECOVERY");
+              bool reduced = (m_tcb->m_congState == TcpSocketState::CA_CWR);
               m_recover = m_tcb->m_highTxMark;
               m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_RECOVERY);
               m_tcb->m_congState = TcpSocketState::CA_RECOVERY;
 
-              m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb,
-                                                                    BytesInFlight ());
+              if (!reduced)
+                { // ssThresh is not reduced twice in a window (RFC 3168 section 6.1.2)
+                  m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb,
+                                                                        BytesInFlight ());
+                }
               m_tcb->m_cWnd = m_tcb->m_ssThresh + m_dupAckCount * m_tcb->m_segmentSize;
 
               NS_LOG_INFO (m_dupAckCount << " dupack. Enter fast recovery mode." <<
@@ -1434,6 +1535,21 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 
           NS_LOG_DEBUG ("DISORDER -> OPEN");
         }
+      else if (m_tcb->m_congState == TcpSocketState::CA_CWR)
+        {
+          // The window does not grow until the data sent before the
+          // reduction is acknowledged
+          m_congestionControl->PktsAcked (m_tcb, segsAcked, m_lastRtt);
+          m_dupAckCount = 0;
+          m_retransOut = 0;
+          if (ackNumber >= m_ecnRecover)
+            {
+              m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+              m_tcb->m_congState = TcpSocketState::CA_OPEN;
+              NS_LOG_DEBUG ("CWR -> OPEN");
+            }
+          callCongestionControl = false;
+        }
       else if (m_tcb->m_congState == TcpSocketState::CA_RECOVERY)
         {
           if (ackNumber < m_recover)
@@ -1557,6 +1673,204 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
     }
 }
 
+/* Process the newly received ACK, with the SACK scoreboard (RFC 6675) */
+void
+TcpSocketBase::ReceivedAckSack (Ptr<Packet> packet, const TcpHeader& tcpHeader)
+{
+  NS_LOG_FUNCTION (this << tcpHeader);
+
+  SequenceNumber32 ackNumber = tcpHeader.GetAckNumber ();
+  SequenceNumber32 head = m_txBuffer->HeadSequence ();
+  uint32_t bytesAcked = ackNumber - head;
+  uint32_t segsAcked  = bytesAcked / m_tcb->m_segmentSize;
+  m_bytesAckedNotProcessed += bytesAcked % m_tcb->m_segmentSize;
+
+  if (m_bytesAckedNotProcessed >= m_tcb->m_segmentSize)
+    {
+      segsAcked += 1;
+      m_bytesAckedNotProcessed -= m_tcb->m_segmentSize;
+    }
+
+  m_tcb->m_lastAckedSeq = ackNumber;
+
+  if (m_ecn)
+    {
+      ProcessEcnEcho (tcpHeader, ackNumber > head ? bytesAcked : 0);
+    }
+
+  TcpTxBuffer32::SackList blocks;
+  if (tcpHeader.HasOption (TcpOption::SACK))
+    {
+      Ptr<const TcpOptionSack> sack = DynamicCast<const TcpOptionSack> (tcpHeader.GetOption (TcpOption::SACK));
+      blocks = sack->GetSackList ();
+    }
+  uint32_t sacked = m_txBuffer->UpdateScoreboard (ackNumber, blocks, Simulator::Now (), m_minRtt);
+
+  NS_LOG_DEBUG ("ACK of " << ackNumber << " SND.UNA=" << head <<
+                " SND.NXT=" << m_tcb->m_nextTxSequence << " newly SACKed " << sacked <<
+                " SACKed " << m_txBuffer->GetSacked () << " lost " << m_txBuffer->GetLost ());
+
+  bool isDupAck = ackNumber == head && ackNumber < m_tcb->m_nextTxSequence && packet->GetSize () == 0;
+  if (isDupAck)
+    {
+      ++m_dupAckCount;
+    }
+  else if (ackNumber > head)
+    {
+      m_dupAckCount = 0;
+      m_lossProbeOut = false;
+    }
+
+  if (m_tcb->m_congState == TcpSocketState::CA_OPEN && (isDupAck || sacked > 0))
+    {
+      m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_DISORDER);
+      m_tcb->m_congState = TcpSocketState::CA_DISORDER;
+      NS_LOG_DEBUG ("OPEN -> DISORDER");
+    }
+
+  uint32_t lost = DetectSackLosses ();
+  if (m_txBuffer->GetLost () > 0
+      && (m_tcb->m_congState == TcpSocketState::CA_OPEN
+          || m_tcb->m_congState == TcpSocketState::CA_DISORDER
+          || m_tcb->m_congState == TcpSocketState::CA_CWR))
+    {
+      EnterSackRecovery ();
+    }
+
+  if (ackNumber > head)
+    {
+      bool callCongestionControl = true;
+      if (m_tcb->m_congState == TcpSocketState::CA_DISORDER)
+        {
+          if (m_txBuffer->GetSacked () == 0)
+            { // Reordering: the hole was filled without retransmission
+              m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+              m_tcb->m_congState = TcpSocketState::CA_OPEN;
+              NS_LOG_DEBUG ("DISORDER -> OPEN");
+            }
+        }
+      else if (m_tcb->m_congState == TcpSocketState::CA_CWR)
+        {
+          if (ackNumber >= m_ecnRecover)
+            { // The data sent before the window reduction is acknowledged
+              TcpSocketState::TcpCongState_t next = m_txBuffer->GetSacked () > 0 ?
+                TcpSocketState::CA_DISORDER : TcpSocketState::CA_OPEN;
+              m_congestionControl->CongestionStateSet (m_tcb, next);
+              m_tcb->m_congState = next;
+              NS_LOG_DEBUG ("CWR -> " << TcpSocketState::TcpCongStateName[next]);
+            }
+          callCongestionControl = false;
+        }
+      else if (m_tcb->m_congState == TcpSocketState::CA_RECOVERY)
+        {
+          if (ackNumber >= m_recover)
+            { // Full ACK: the window ends the recovery at ssThresh
+              m_tcb->m_cWnd = m_tcb->m_ssThresh.Get ();
+              m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+              m_tcb->m_congState = TcpSocketState::CA_OPEN;
+              NS_LOG_INFO ("Received full ACK for seq " << ackNumber <<
+                           ". Leaving fast recovery with cwnd set to " << m_tcb->m_cWnd);
+              NS_LOG_DEBUG ("RECOVERY -> OPEN");
+            }
+          callCongestionControl = false;
+        }
+      else if (m_tcb->m_congState == TcpSocketState::CA_LOSS && ackNumber >= m_recover)
+        { // Everything sent before the timeout is acknowledged
+          m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+          m_tcb->m_congState = TcpSocketState::CA_OPEN;
+          NS_LOG_DEBUG ("LOSS -> OPEN");
+        }
+
+      m_congestionControl->PktsAcked (m_tcb, std::max (segsAcked, 1U), m_lastRtt);
+      if (callCongestionControl)
+        {
+          m_congestionControl->IncreaseWindow (m_tcb, segsAcked);
+
+          NS_LOG_LOGIC ("Congestion control called: " <<
+                        " cWnd: " << m_tcb->m_cWnd <<
+                        " ssTh: " << m_tcb->m_ssThresh);
+        }
+
+      // Reset the data retransmission count. We got a new ACK!
+      m_dataRetrCount = m_tcpParams->m_dataRetries;
+
+      NewAck (tcpHeader, true);
+      ScheduleLossProbe ();
+    }
+  else if (isDupAck)
+    {
+      // Artificially call PktsAcked. After all, one segment has been ACKed.
+      m_congestionControl->PktsAcked (m_tcb, 1, m_lastRtt);
+    }
+
+  // Try to send more data, or to retransmit: the pipe may have shrunk
+  if ((ackNumber > head || sacked > 0 || lost > 0) && !m_sendPendingDataEvent.IsRunning ())
+    {
+      m_sendPendingDataEvent = Simulator::Schedule (TimeStep (1),
+                                                    &TcpSocketBase::SendPendingData,
+                                                    this, m_connected);
+    }
+
+  // If there is any data piggybacked, store it into m_rxBuffer
+  if (packet->GetSize () > 0)
+    {
+      ReceivedData (packet, tcpHeader);
+    }
+}
+
+uint32_t
+TcpSocketBase::DetectSackLosses (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_tcpParams->m_rackEnabled)
+    {
+      return m_txBuffer->MarkLostByCount (m_tcpParams->m_retxThresh, m_tcb->m_segmentSize);
+    }
+
+  // RFC 8985 section 6.2: no reordering window in the recovery, or once the
+  // duplicate threshold is reached, a quarter of the minimum RTT otherwise
+  Time reoWnd = Time (0);
+  if (m_tcb->m_congState != TcpSocketState::CA_RECOVERY
+      && m_tcb->m_congState != TcpSocketState::CA_LOSS
+      && m_txBuffer->GetSacked () < m_tcpParams->m_retxThresh * m_tcb->m_segmentSize)
+    {
+      reoWnd = std::min (Time (m_minRtt / 4), m_rtt->GetEstimate ());
+    }
+  Time timeout;
+  uint32_t lost = m_txBuffer->MarkLostByTime (Simulator::Now (), reoWnd, timeout);
+  if (timeout.IsStrictlyPositive ())
+    {
+      NS_LOG_LOGIC (this << " Schedule RACK reordering timeout in " << timeout.GetSeconds ());
+      m_rackEvent.Schedule (timeout, &TcpSocketBase::RackTimeout, this);
+    }
+  else
+    {
+      m_rackEvent.Cancel ();
+    }
+  return lost;
+}
+
+void
+TcpSocketBase::EnterSackRecovery (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_DEBUG (TcpSocketState::TcpCongStateName[m_tcb->m_congState] << " -> RECOVERY");
+  bool reduced = (m_tcb->m_congState == TcpSocketState::CA_CWR);
+  m_recover = m_tcb->m_highTxMark;
+  m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_RECOVERY);
+  m_tcb->m_congState = TcpSocketState::CA_RECOVERY;
+  if (!reduced)
+    { // ssThresh is not reduced twice in a window (RFC 3168 section 6.1.2)
+      m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb, UnAckDataCount ());
+    }
+  m_tcb->m_cWnd = m_tcb->m_ssThresh.Get ();
+  m_lossProbeEvent.Cancel ();
+
+  NS_LOG_INFO ("Enter fast recovery with " << m_txBuffer->GetLost () << " bytes lost. " <<
+               "Reset cwnd to " << m_tcb->m_cWnd << ", ssthresh to " <<
+               m_tcb->m_ssThresh << " at fast recovery seqnum " << m_recover);
+}
+
 /* Received a packet upon LISTEN state. */
 void
 TcpSocketBase::ProcessListen (Ptr<Packet> packet, const TcpHeader& tcpHeader,
@@ -1564,8 +1878,8 @@ TcpSocketBase::ProcessListen (Ptr<Packet> packet, const TcpHeader& tcpHeader,
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
 
   // Fork a socket if received a SYN. Do nothing otherwise.
   // C.f.: the LISTEN part in tcp_v4_do_rcv() in tcp_ipv4.c in Linux kernel
@@ -1628,8 +1942,8 @@ TcpSocketBase::ProcessSynSent (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
 
   if (tcpflags == 0)
     { // Bare data, accept it and move to ESTABLISHED state. This is not a normal behaviour. Remove this?
@@ -1685,8 +1999,8 @@ TcpSocketBase::ProcessSynRcvd (Ptr<Packet> packet, const TcpHeader& tcpHeader,
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
 
   if (tcpflags == 0
       || (tcpflags == TcpHeader::ACK
@@ -1778,8 +2092,8 @@ TcpSocketBase::ProcessWait (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
 
   if (packet->GetSize () > 0 && tcpflags != TcpHeader::ACK)
     { // Bare data, accept it
@@ -1850,8 +2164,8 @@ TcpSocketBase::ProcessClosing (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
 
   if (tcpflags == TcpHeader::ACK)
     {
@@ -1882,8 +2196,8 @@ TcpSocketBase::ProcessLastAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG | TcpHeader::ECE | TcpHeader::CWR);
 
   if (tcpflags == 0)
     {
@@ -1983,7 +2297,7 @@ TcpSocketBase::DoPeerClose (void)
     {
       NS_LOG_LOGIC ("TcpSocketBase " << this << " scheduling LATO1");
       Time lastRto = m_rtt->GetEstimate () + Max (m_tcpParams->m_clockGranularity, m_rtt->GetVariation () * 4);
-      m_lastAckEvent = Simulator::Schedule (lastRto, &TcpSocketBase::LastAckTimeout, this);
+      m_lastAckEvent.Schedule (lastRto, &TcpSocketBase::LastAckTimeout, this);
     }
 }
 
@@ -1999,7 +2313,7 @@ TcpSocketBase::Destroy (void)
       m_tcp->RemoveSocket (this);
     }
   NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
   CancelAllTimers ();
 }
 
@@ -2015,7 +2329,7 @@ TcpSocketBase::Destroy6 (void)
       m_tcp->RemoveSocket(this);
     }
   NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
   CancelAllTimers ();
 }
 
@@ -2065,25 +2379,48 @@ void
 TcpSocketBase::SendPacket(TcpHeader header, Ptr<Packet> p)
 {
   NS_LOG_LOGIC ("Send packet via TcpL4Protocol with flags");
-  NS_ASSERT(header.GetWindowSize() == AdvertisedWindowSize ());
+  // The window of a SYN segment is never scaled (RFC 7323 section 2.2)
+  NS_ASSERT(header.GetWindowSize() == AdvertisedWindowSize (!(header.GetFlags () & TcpHeader::SYN)));
+
+  // ECN (RFC 3168 sections 6.1.2 to 6.1.4): the ACKs echo the congestion,
+  // and new data segments, not the retransmissions, are ECN-capable and
+  // carry the CWR flag after a window reduction
+  uint8_t ect = 0;
+  if (m_ecn && !(header.GetFlags () & TcpHeader::SYN))
+    {
+      if (m_ecnEcho && (header.GetFlags () & TcpHeader::ACK))
+        {
+          header.SetFlags (header.GetFlags () | TcpHeader::ECE);
+        }
+      if (p->GetSize () > 0 && header.GetSequenceNumber () >= m_tcb->m_highTxMark)
+        {
+          ect = Ipv4Header::ECN_ECT0;
+          if (m_ecnSendCwr)
+            {
+              header.SetFlags (header.GetFlags () | TcpHeader::CWR);
+              m_ecnSendCwr = false;
+            }
+        }
+    }
 
   /*
    * Add tags for each socket option.
    * Note that currently the socket adds both IPv4 tag and IPv6 tag
    * if both options are set. Once the packet got to layer three, only
-   * the corresponding tags will be read.
+   * the corresponding tags will be read. The ECN codepoint is only added
+   * to the tag of the endpoint.
    */
-  if (GetIpTos ())
+  if (GetIpTos () || (ect && m_endPoint != 0))
     {
       SocketIpTosTag ipTosTag;
-      ipTosTag.SetTos (GetIpTos ());
+      ipTosTag.SetTos (GetIpTos () | (m_endPoint != 0 ? ect : 0));
       p->AddPacketTag (ipTosTag);
     }
 
-  if (IsManualIpv6Tclass ())
+  if (IsManualIpv6Tclass () || (ect && m_endPoint6 != 0))
     {
       SocketIpv6TclassTag ipTclassTag;
-      ipTclassTag.SetTclass (GetIpv6Tclass ());
+      ipTclassTag.SetTclass (GetIpv6Tclass () | (m_endPoint6 != 0 ? ect : 0));
       p->AddPacketTag (ipTclassTag);
     }
 
@@ -2185,6 +2522,21 @@ TcpSocketBase::SendEmptyPacket (TcpHeader& header)
           AddOptionWScale (header);
         }
 
+      if (m_tcpParams->m_sackEnabled)
+        {
+          AddOptionSackPermitted (header);
+        }
+
+      // ECN-setup SYN and SYN-ACK (RFC 3168 section 6.1.1)
+      if (!(flags & TcpHeader::ACK) && IsEcnRequested ())
+        {
+          header.SetFlags (header.GetFlags () | TcpHeader::ECE | TcpHeader::CWR);
+        }
+      else if ((flags & TcpHeader::ACK) && m_ecn)
+        {
+          header.SetFlags (header.GetFlags () | TcpHeader::ECE);
+        }
+
       if (m_synCount == 0)
         { // No more connection retries, give up
           NS_LOG_LOGIC ("Connection failed.");
@@ -2220,7 +2572,7 @@ TcpSocketBase::SendEmptyPacket (TcpHeader& header)
       NS_LOG_LOGIC ("Schedule retransmission timeout at time "
                     << Simulator::Now ().GetSeconds () << " to expire at time "
                     << (Simulator::Now () + m_rto.Get ()).GetSeconds ());
-      m_retxEvent = Simulator::Schedule (m_rto, (void (TcpSocketBase::*)(uint8_t ))&TcpSocketBase::SendEmptyPacket, this, header.GetFlags());
+      m_retxEvent.Schedule (m_rto, (void (TcpSocketBase::*)(uint8_t ))&TcpSocketBase::SendEmptyPacket, this, header.GetFlags());
     }
 }
 
@@ -2359,6 +2711,7 @@ TcpSocketBase::CompleteFork (Ptr<Packet> p, const TcpHeader& h,
   SetupCallback ();
   // Set the sequence number and send SYN+ACK
   m_rxBuffer->SetNextRxSequence (h.GetSequenceNumber () + SequenceNumber32 (1));
+  NegotiateEcn (h);
 
   SendEmptyPacket (TcpHeader::SYN | TcpHeader::ACK);
 }
@@ -2401,6 +2754,10 @@ TcpSocketBase::SendDataPacket (TcpHeader& header, SequenceNumber32 seq, uint32_t
 
   Ptr<Packet> p = m_txBuffer->CopyFromSequence (maxSize, seq);
   uint32_t sz = p->GetSize (); // Size of packet
+  if (sz > m_tcb->m_segmentSize)
+    { // Cut into segments by the device
+      p->AddPacketTag (GsoTag (m_tcb->m_segmentSize));
+    }
   uint32_t remainingData = m_txBuffer->SizeFromSequence (seq + SequenceNumber32 (sz));
 
   if (m_tcpParams->m_closeOnEmpty && (remainingData == 0))
@@ -2434,13 +2791,25 @@ TcpSocketBase::SendDataPacket (TcpHeader& header, SequenceNumber32 seq, uint32_t
       NS_LOG_LOGIC (this << " SendDataPacket Schedule ReTxTimeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_rto.Get ()).GetSeconds () );
-      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
+      m_retxEvent.Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
     }
 
 
   SendPacket(header, p);
 
-  UpdateRttHistory (seq, sz, isRetransmission);
+  // One entry per segment on the wire
+  uint32_t offset = 0;
+  do
+    {
+      uint32_t segment = std::min (sz - offset, m_tcb->m_segmentSize);
+      UpdateRttHistory (seq + offset, segment, isRetransmission);
+      if (m_tcpParams->m_sackEnabled)
+        {
+          m_txBuffer->RecordSent (seq + offset, segment, Simulator::Now ());
+        }
+      offset += segment;
+    }
+  while (offset < sz);
 
   // Notify the application of the data being sent unless this is a retransmit
   if (seq + sz > m_tcb->m_highTxMark)
@@ -2516,8 +2885,36 @@ TcpSocketBase::SendPendingData (bool withAck)
       NS_LOG_INFO ("TcpSocketBase::SendPendingData: No endpoint; m_shutdownSend=" << m_tcpParams->m_shutdownSend);
       return false; // Is this the right way to handle this condition?
     }
+  bool paced = false;
+  if (m_tcpParams->m_pacing)
+    {
+      ComputePacingRate ();
+      if (m_pacingTimer.IsRunning ())
+        {
+          NS_LOG_LOGIC ("Pacing: next segment in " << m_pacingTimer.GetDelayLeft ().GetSeconds () << " s");
+          return false;
+        }
+      paced = m_tcb->m_pacingRate.Get ().GetBitRate () > 0;
+    }
   uint32_t nPacketsSent = 0;
-  while (m_txBuffer->SizeFromSequence (m_tcb->m_nextTxSequence))
+  if (m_tcpParams->m_sackEnabled)
+    { // Retransmit the lost segments first (RFC 6675 NextSeg () rule 1)
+      SequenceNumber32 lostSeq;
+      uint32_t lostSize;
+      while (m_txBuffer->NextLost (lostSeq, lostSize)
+             && m_tcb->m_cWnd.Get () >= m_txBuffer->GetPipe () + lostSize)
+        {
+          NS_LOG_DEBUG ("Retransmit lost segment " << lostSeq << " of size " << lostSize <<
+                        " pipe " << m_txBuffer->GetPipe () << " cWnd " << m_tcb->m_cWnd);
+          SendDataPacket (lostSeq, lostSize, withAck);
+          nPacketsSent++;
+          if (paced)
+            {
+              break;
+            }
+        }
+    }
+  while (m_txBuffer->SizeFromSequence (m_tcb->m_nextTxSequence) && !(paced && nPacketsSent > 0))
     {
       uint32_t w = AvailableWindow (); // Get available window size
       // Stop sending if we need to wait for a larger Tx window (prevent silly window syndrome)
@@ -2539,6 +2936,13 @@ TcpSocketBase::SendPendingData (bool withAck)
                     " unAck: " << UnAckDataCount ());
 
       uint32_t s = std::min (w, m_tcb->m_segmentSize);  // Send no more than window
+      if (m_tcpParams->m_gso && !paced && m_endPoint != 0)
+        { // A super-segment of whole segments, or of all the data left
+          uint32_t data = m_txBuffer->SizeFromSequence (m_tcb->m_nextTxSequence);
+          uint32_t batch = std::min (w, static_cast<uint32_t> (m_tcpParams->m_gsoMaxSize));
+          batch = data > batch ? batch - batch % m_tcb->m_segmentSize : data;
+          s = std::max (s, batch);
+        }
       uint32_t sz = SendDataPacket (m_tcb->m_nextTxSequence, s, withAck);
       nPacketsSent++;                             // Count sent this loop
       m_tcb->m_nextTxSequence += sz;                     // Advance next tx sequence
@@ -2546,6 +2950,12 @@ TcpSocketBase::SendPendingData (bool withAck)
   if (nPacketsSent > 0)
     {
       NS_LOG_DEBUG ("SendPendingData sent " << nPacketsSent << " segments");
+      if (paced)
+        { // One segment per pacing interval: the timer sends the next one
+          m_pacingTimer.Schedule (m_tcb->m_pacingRate.Get ().CalculateBytesTxTime (m_tcb->m_segmentSize),
+                                  &TcpSocketBase::PacingTimeout, this);
+        }
+      ScheduleLossProbe ();
     }
   return (nPacketsSent > 0);
 }
@@ -2571,7 +2981,11 @@ TcpSocketBase::BytesInFlight ()
   uint32_t duplicatedSize;
   uint32_t bytesInFlight;
 
-  if (m_retransOut > m_dupAckCount)
+  if (m_tcpParams->m_sackEnabled)
+    { // The scoreboard knows: RFC 6675 pipe
+      bytesInFlight = m_txBuffer->GetPipe ();
+    }
+  else if (m_retransOut > m_dupAckCount)
     {
       duplicatedSize = (m_retransOut - m_dupAckCount)*m_tcb->m_segmentSize;
       bytesInFlight = flightSize + duplicatedSize;
@@ -2634,18 +3048,32 @@ TcpSocketBase::Window (void) const
  * acked. With SACK this is easy to obtain, but with DUPACK is easy too
  * (sacket_out=m_dupAckCount). lost_out is the only guessed value: with FACK,
  * which is the most conservative heuristic, you assume that all not SACKed
- * packets until the most forward SACK are lost. Since we have not SACK, NewReno
+ * packets until the most forward SACK are lost. Without SACK, NewReno
  * estimate could be used, which basically assumes that only one segment is
  * lost (classical Reno). If we are in recovery and a partial ACK arrives,
  * it means that one more packet has been lost.
+ *
+ * Once SACK is negotiated, the scoreboard of the Tx buffer gives this
+ * estimate (the pipe of RFC 6675), and cWnd is no longer inflated. The
+ * receiver window still bounds SND.NXT - SND.UNA.
  */
 uint32_t
 TcpSocketBase::AvailableWindow () const
 {
   NS_LOG_FUNCTION_NOARGS ();
-  uint32_t unack = UnAckDataCount (); // Number of outstanding bytes
+  // Number of outstanding bytes
+  uint32_t unack = UnAckDataCount ();
   uint32_t win = Window ();           // Number of bytes allowed to be outstanding
 
+  if (m_tcpParams->m_sackEnabled)
+    {
+      uint32_t pipe = m_txBuffer->GetPipe ();
+      uint32_t cWnd = m_tcb->m_cWnd.Get ();
+      uint32_t rWnd = m_rWnd.Get ();
+      NS_LOG_DEBUG ("Pipe=" << pipe << ", UnAckCount=" << unack << ", cWnd=" << cWnd << ", rWnd=" << rWnd);
+      return std::min (cWnd < pipe ? 0 : cWnd - pipe, rWnd < unack ? 0 : rWnd - unack);
+    }
+
   NS_LOG_DEBUG ("UnAckCount=" << unack << ", Win=" << win);
   return (win < unack) ? 0 : (win - unack);
 }
@@ -2699,10 +3127,10 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
         }
       else if (m_delAckEvent.IsExpired ())
         {
-          m_delAckEvent = Simulator::Schedule (m_tcpParams->m_delAckTimeout,
-                                               &TcpSocketBase::DelAckTimeout, this);
+          m_delAckEvent.Schedule (m_tcpParams->m_delAckTimeout,
+                                  &TcpSocketBase::DelAckTimeout, this);
           NS_LOG_LOGIC (this << " scheduled delayed ACK at " <<
-                        (Simulator::Now () + Simulator::GetDelayLeft (m_delAckEvent)).GetSeconds ());
+                        (Simulator::Now () + m_delAckEvent.GetDelayLeft ()).GetSeconds ());
         }
     }
   // Notify app to receive if necessary
@@ -2747,11 +3175,10 @@ TcpSocketBase::EstimateRtt (const TcpHeader& tcpHeader)
       RttHistory& h = m_history.front ();
       if (!h.retx && ackSeq >= (h.seq + SequenceNumber32 (h.count)))
         { // Ok to use this sample
-          if (m_tcpParams->m_timestampEnabled && tcpHeader.HasOption (TcpOption::TS))
+          uint32_t value, echo;
+          if (m_tcpParams->m_timestampEnabled && tcpHeader.GetTimestamp (value, echo))
             {
-              Ptr<TcpOptionTS> ts;
-              ts = DynamicCast<TcpOptionTS> (tcpHeader.GetOption (TcpOption::TS));
-              m = TcpOptionTS::ElapsedTimeFromTsValue (ts->GetEcho ());
+              m = TcpOptionTS::ElapsedTimeFromTsValue (echo);
             }
           else
             {
@@ -2780,6 +3207,10 @@ TcpSocketBase::EstimateRtt (const TcpHeader& tcpHeader)
       // RFC 6298, clause 2.4
       m_rto = Max (m_rtt->GetEstimate () + Max (m_tcpParams->m_clockGranularity, m_rtt->GetVariation () * 4), m_tcpParams->m_minRto);
       m_lastRtt = m_rtt->GetEstimate ();
+      if (m_minRtt.IsZero () || m < m_minRtt)
+        {
+          m_minRtt = m;
+        }
       NS_LOG_FUNCTION (this << m_lastRtt);
     }
 }
@@ -2803,7 +3234,7 @@ TcpSocketBase::NewAck (const TcpHeader& header, bool resetRTO)
   if (m_state != SYN_RCVD && resetRTO)
     { // Set RTO unless the ACK is received in SYN_RCVD state
       NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                    (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
       m_retxEvent.Cancel ();
       // On receiving a "New" ack we restart retransmission timer .. RFC 6298
       // RFC 6298, clause 2.4
@@ -2812,19 +3243,19 @@ TcpSocketBase::NewAck (const TcpHeader& header, bool resetRTO)
       NS_LOG_LOGIC (this << " Schedule ReTxTimeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_rto.Get ()).GetSeconds ());
-      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
+      m_retxEvent.Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
     }
   if (m_rWnd.Get () == 0 && m_persistEvent.IsExpired ())
     { // Zero window: Enter persist state to send 1 byte to probe
       NS_LOG_LOGIC (this << "Enter zerowindow persist state");
       NS_LOG_LOGIC (this << "Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                    (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
       m_retxEvent.Cancel ();
       NS_LOG_LOGIC ("Schedule persist timeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_tcpParams->m_persistTimeout).GetSeconds ());
-      m_persistEvent = Simulator::Schedule (m_tcpParams->m_persistTimeout, &TcpSocketBase::PersistTimeout, this);
-      NS_ASSERT (m_tcpParams->m_persistTimeout == Simulator::GetDelayLeft (m_persistEvent));
+      m_persistEvent.Schedule (m_tcpParams->m_persistTimeout, &TcpSocketBase::PersistTimeout, this);
+      NS_ASSERT (m_tcpParams->m_persistTimeout == m_persistEvent.GetDelayLeft ());
     }
   // Note the highest ACK and tell app to send more
   NS_LOG_LOGIC ("TCP " << this << " NewAck " << ack <<
@@ -2843,8 +3274,9 @@ TcpSocketBase::NewAck (const TcpHeader& header, bool resetRTO)
   if (m_txBuffer->Size () == 0 && m_state != FIN_WAIT_1 && m_state != CLOSING)
     { // No retransmit timer if no data to retransmit
       NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                    (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
       m_retxEvent.Cancel ();
+      m_lossProbeEvent.Cancel ();
     }
 }
 
@@ -2915,7 +3347,7 @@ TcpSocketBase::PersistTimeout ()
   NS_LOG_LOGIC ("Schedule persist timeout at time "
                 << Simulator::Now ().GetSeconds () << " to expire at time "
                 << (Simulator::Now () + m_tcpParams->m_persistTimeout).GetSeconds ());
-  m_persistEvent = Simulator::Schedule (m_tcpParams->m_persistTimeout, &TcpSocketBase::PersistTimeout, this);
+  m_persistEvent.Schedule (m_tcpParams->m_persistTimeout, &TcpSocketBase::PersistTimeout, this);
 }
 
 void
@@ -2971,7 +3403,17 @@ TcpSocketBase::Retransmit ()
       m_tcb->m_cWnd = m_tcb->m_segmentSize;
     }
 
-  m_tcb->m_nextTxSequence = m_txBuffer->HeadSequence (); // Restart from highest Ack
+  if (m_tcpParams->m_sackEnabled)
+    { // Retransmit what was not SACKed, without going back to the head (RFC 6675 sec. 5.1)
+      m_txBuffer->MarkAllLost ();
+      m_rackEvent.Cancel ();
+      m_lossProbeEvent.Cancel ();
+      m_lossProbeOut = false;
+    }
+  else
+    {
+      m_tcb->m_nextTxSequence = m_txBuffer->HeadSequence (); // Restart from highest Ack
+    }
   m_dupAckCount = 0;
 
   NS_LOG_DEBUG ("RTO. Reset cwnd to " <<  m_tcb->m_cWnd << ", ssthresh to " <<
@@ -3019,13 +3461,212 @@ TcpSocketBase::DoRetransmit ()
       return;
     }
   // Retransmit a data packet: Call SendDataPacket
-  NS_LOG_LOGIC ("TcpSocketBase " << this << " retxing seq " << m_txBuffer->HeadSequence ());
-  uint32_t sz = SendDataPacket (m_txBuffer->HeadSequence (), GetSegSize(), true);
+  SequenceNumber32 seq = m_txBuffer->HeadSequence ();
+  uint32_t size = GetSegSize ();
+  if (m_tcpParams->m_sackEnabled)
+    { // The first segment not SACKed, as it was sent
+      m_txBuffer->NextLost (seq, size);
+    }
+  NS_LOG_LOGIC ("TcpSocketBase " << this << " retxing seq " << seq);
+  uint32_t sz = SendDataPacket (seq, size, true);
   ++m_retransOut;
 
   // In case of RTO, advance m_tcb->m_nextTxSequence
-  m_tcb->m_nextTxSequence = std::max (m_tcb->m_nextTxSequence.Get (), m_txBuffer->HeadSequence () + sz);
-  NS_LOG_DEBUG ("retxing seq " << m_txBuffer->HeadSequence ());
+  m_tcb->m_nextTxSequence = std::max (m_tcb->m_nextTxSequence.Get (), seq + sz);
+  NS_LOG_DEBUG ("retxing seq " << seq);
+}
+
+void
+TcpSocketBase::RackTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_state == CLOSED || m_state == TIME_WAIT)
+    {
+      return;
+    }
+  if (DetectSackLosses () == 0)
+    {
+      return;
+    }
+  if (m_tcb->m_congState == TcpSocketState::CA_OPEN
+      || m_tcb->m_congState == TcpSocketState::CA_DISORDER
+      || m_tcb->m_congState == TcpSocketState::CA_CWR)
+    {
+      EnterSackRecovery ();
+    }
+  SendPendingData (m_connected);
+}
+
+void
+TcpSocketBase::ScheduleLossProbe (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_tcpParams->m_sackEnabled || !m_tcpParams->m_rackEnabled || m_lossProbeOut
+      || (m_tcb->m_congState != TcpSocketState::CA_OPEN
+          && m_tcb->m_congState != TcpSocketState::CA_DISORDER
+          && m_tcb->m_congState != TcpSocketState::CA_CWR)
+      || m_txBuffer->HeadSequence () >= m_tcb->m_highTxMark
+      || m_rtt->GetEstimate ().IsZero ())
+    {
+      return;
+    }
+  // RFC 8985 section 7.2: twice the SRTT, plus the delayed ACK timeout
+  // when a single segment is outstanding
+  Time pto = 2 * m_rtt->GetEstimate ();
+  if (m_txBuffer->GetPipe () <= m_tcb->m_segmentSize)
+    {
+      pto += m_tcpParams->m_delAckTimeout;
+    }
+  if (m_retxEvent.IsRunning () && pto >= m_retxEvent.GetDelayLeft ())
+    { // The retransmission timeout comes first
+      m_lossProbeEvent.Cancel ();
+      return;
+    }
+  m_lossProbeEvent.Schedule (pto, &TcpSocketBase::LossProbeTimeout, this);
+}
+
+void
+TcpSocketBase::LossProbeTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_state == CLOSED || m_state == TIME_WAIT
+      || m_txBuffer->HeadSequence () >= m_tcb->m_highTxMark)
+    {
+      return;
+    }
+
+  uint32_t available = m_txBuffer->SizeFromSequence (m_tcb->m_nextTxSequence);
+  uint32_t window = m_rWnd.Get () > UnAckDataCount () ? m_rWnd.Get () - UnAckDataCount () : 0;
+  if (available > 0 && window >= std::min (available, m_tcb->m_segmentSize))
+    { // A new segment is the probe
+      uint32_t sz = SendDataPacket (m_tcb->m_nextTxSequence, std::min (window, m_tcb->m_segmentSize), true);
+      m_tcb->m_nextTxSequence += sz;
+      NS_LOG_INFO ("Tail loss probe with new data of size " << sz);
+    }
+  else
+    { // The last segment sent is the probe
+      SequenceNumber32 seq;
+      uint32_t size;
+      if (!m_txBuffer->LastSent (seq, size))
+        {
+          return;
+        }
+      SendDataPacket (seq, size, true);
+      NS_LOG_INFO ("Tail loss probe retransmitting seq " << seq);
+    }
+  m_lossProbeOut = true;
+
+  // The probe gets a full RTO to be answered
+  m_rto = ComputeRTO ();
+  m_retxEvent.Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
+}
+
+void
+TcpSocketBase::ComputePacingRate (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time srtt = m_rtt->GetEstimate ();
+  if (srtt.IsZero ())
+    {
+      m_tcb->m_pacingRate = DataRate (0);
+      return;
+    }
+  // Above Window ()/SRTT, so that the window and not the pacing limits the
+  // flow: by more in slow start, where cWnd doubles every RTT. cWnd keeps
+  // growing while rWnd limits the flow, hence Window () and not cWnd.
+  uint16_t ratio = m_tcb->m_cWnd < m_tcb->m_ssThresh / 2 ?
+    m_tcpParams->m_pacingSsRatio : m_tcpParams->m_pacingCaRatio;
+  double bps = Window () * 8.0 * ratio / 100 / srtt.GetSeconds ();
+  m_tcb->m_pacingRate = std::min (DataRate (static_cast<uint64_t> (bps)), m_tcpParams->m_maxPacingRate);
+  NS_LOG_LOGIC ("Pacing rate " << m_tcb->m_pacingRate.Get ().GetBitRate () << " bps, cWnd " <<
+                m_tcb->m_cWnd << " rWnd " << m_rWnd << " srtt " << srtt.GetSeconds ());
+}
+
+void
+TcpSocketBase::PacingTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+  SendPendingData (m_connected);
+}
+
+bool
+TcpSocketBase::IsEcnRequested (void) const
+{
+  return m_tcpParams->m_ecnEnabled || m_congestionControl->NeedsEcn ();
+}
+
+void
+TcpSocketBase::NegotiateEcn (const TcpHeader& tcpHeader)
+{
+  NS_LOG_FUNCTION (this << tcpHeader);
+  uint8_t ecnFlags = tcpHeader.GetFlags () & (TcpHeader::ECE | TcpHeader::CWR);
+  if (tcpHeader.GetFlags () & TcpHeader::ACK)
+    {
+      m_ecn = IsEcnRequested () && ecnFlags == TcpHeader::ECE;
+    }
+  else
+    {
+      m_ecn = IsEcnRequested () && ecnFlags == (TcpHeader::ECE | TcpHeader::CWR);
+    }
+  m_ecnEcho = false;
+  m_ecnSendCwr = false;
+  m_ecnRecover = m_tcb->m_nextTxSequence;
+  NS_LOG_LOGIC (this << " ECN " << (m_ecn ? "negotiated" : "not negotiated"));
+}
+
+void
+TcpSocketBase::UpdateEcnEcho (const TcpHeader& tcpHeader)
+{
+  NS_LOG_FUNCTION (this << tcpHeader << m_ceReceived);
+  if (m_congestionControl->NeedsEcn ())
+    {
+      // RFC 8257 section 3.2: the ECE flag tells the CE codepoint of the
+      // segments acknowledged. When it changes, the delayed ACK of the
+      // previous segments is sent at once with the previous state
+      if (m_ceReceived != m_ecnEcho && !m_delAckEvent.IsExpired ())
+        {
+          SendEmptyPacket (TcpHeader::ACK);
+        }
+      m_ecnEcho = m_ceReceived;
+    }
+  else
+    {
+      // RFC 3168 section 6.1.3: set the ECE flag from a CE segment until a
+      // data segment with the CWR flag
+      if (tcpHeader.GetFlags () & TcpHeader::CWR)
+        {
+          m_ecnEcho = false;
+        }
+      if (m_ceReceived)
+        {
+          m_ecnEcho = true;
+        }
+    }
+}
+
+void
+TcpSocketBase::ProcessEcnEcho (const TcpHeader& tcpHeader, uint32_t bytesAcked)
+{
+  NS_LOG_FUNCTION (this << tcpHeader << bytesAcked);
+  bool ece = tcpHeader.GetFlags () & TcpHeader::ECE;
+  m_congestionControl->InAckEvent (m_tcb, bytesAcked, ece);
+
+  if (!ece || tcpHeader.GetAckNumber () <= m_ecnRecover
+      || (m_tcb->m_congState != TcpSocketState::CA_OPEN
+          && m_tcb->m_congState != TcpSocketState::CA_DISORDER))
+    { // At most one reduction per window, and none in the loss recovery
+      return;
+    }
+  NS_LOG_DEBUG (TcpSocketState::TcpCongStateName[m_tcb->m_congState] << " -> CWR");
+  m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_CWR);
+  m_tcb->m_congState = TcpSocketState::CA_CWR;
+  m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb, BytesInFlight ());
+  m_tcb->m_cWnd = m_tcb->m_ssThresh.Get ();
+  m_ecnRecover = m_tcb->m_highTxMark;
+  m_ecnSendCwr = true;
+  NS_LOG_INFO ("ECN-Echo for seq " << tcpHeader.GetAckNumber () <<
+               ": reset cwnd to " << m_tcb->m_cWnd << ", ssthresh to " <<
+               m_tcb->m_ssThresh << " until seqnum " << m_ecnRecover);
 }
 
 void
@@ -3036,6 +3677,9 @@ TcpSocketBase::CancelAllTimers ()
   m_delAckEvent.Cancel ();
   m_lastAckEvent.Cancel ();
   m_timewaitEvent.Cancel ();
+  m_rackEvent.Cancel ();
+  m_lossProbeEvent.Cancel ();
+  m_pacingTimer.Cancel ();
   m_sendPendingDataEvent.Cancel ();
 }
 
@@ -3048,8 +3692,8 @@ TcpSocketBase::TimeWait ()
   CancelAllTimers ();
   // Move from TIME_WAIT to CLOSED after 2*MSL. Max segment lifetime is 2 min
   // according to RFC793, p.28
-  m_timewaitEvent = Simulator::Schedule (Seconds (2 * m_tcpParams->m_msl),
-                                         &TcpSocketBase::CloseAndNotify, this);
+  m_timewaitEvent.Schedule (Seconds (2 * m_tcpParams->m_msl),
+                            &TcpSocketBase::CloseAndNotify, this);
 }
 
 /* Below are the attribute get/set functions */
@@ -3118,6 +3762,9 @@ TcpSocketBase::IsTcpOptionAllowed(uint8_t kind) const
         return m_tcpParams->m_timestampEnabled;
       case TcpOption::WINSCALE:
         return m_tcpParams->m_winScalingEnabled;
+      case TcpOption::SACKPERMITTED:
+      case TcpOption::SACK:
+        return m_tcpParams->m_sackEnabled;
       case TcpOption::MPTCP:
         NS_LOG_INFO("MpTcp Active=" << m_tcpParams->m_mptcpEnabled);
         return m_tcpParams->m_mptcpEnabled;
@@ -3136,18 +3783,23 @@ TcpSocketBase::AddOptions (TcpHeader& header)
   {
     AddOptionTimestamp (header);
   }
+
+  // Last, in the space left by the other options
+  if (m_tcpParams->m_sackEnabled
+      && (header.GetFlags () & (TcpHeader::SYN | TcpHeader::ACK)) == TcpHeader::ACK)
+  {
+    AddOptionSack (header);
+  }
 }
 
 void
-TcpSocketBase::ProcessOptionWScale (const Ptr<const TcpOption> option)
+TcpSocketBase::ProcessOptionWScale (uint8_t scale)
 {
-  NS_LOG_FUNCTION (this << option);
-
-  Ptr<const TcpOptionWinScale> ws = DynamicCast<const TcpOptionWinScale> (option);
+  NS_LOG_FUNCTION (this << static_cast<int> (scale));
 
   // In naming, we do the contrary of RFC 1323. The received scaling factor
   // is Rcv.Wind.Scale (and not Snd.Wind.Scale)
-  m_sndWindShift = ws->GetScale ();
+  m_sndWindShift = scale;
 
   if (m_sndWindShift > 14)
     {
@@ -3189,45 +3841,50 @@ TcpSocketBase::AddOptionWScale (TcpHeader &header)
   NS_LOG_FUNCTION (this << header);
   NS_ASSERT (header.GetFlags () & TcpHeader::SYN);
 
-  Ptr<TcpOptionWinScale> option = CreateObject<TcpOptionWinScale> ();
-
   // In naming, we do the contrary of RFC 1323. The sended scaling factor
   // is Snd.Wind.Scale (and not Rcv.Wind.Scale)
 
   m_rcvWindShift = CalculateWScale ();
-  option->SetScale (m_rcvWindShift);
 
-  header.AppendOption (option);
+  header.AppendWindowScale (m_rcvWindShift);
 
   NS_LOG_INFO (m_node->GetId () << " Send a scaling factor of " <<
                static_cast<int> (m_rcvWindShift));
 }
 
 void
-TcpSocketBase::ProcessOptionTimestamp (const Ptr<const TcpOption> option,
+TcpSocketBase::ProcessOptionTimestamp (uint32_t value, uint32_t echo,
                                        const SequenceNumber32 &seq)
 {
-  NS_LOG_FUNCTION (this << option);
-
-  Ptr<const TcpOptionTS> ts = DynamicCast<const TcpOptionTS> (option);
+  NS_LOG_FUNCTION (this << value << echo);
 
   if (seq == m_rxBuffer->NextRxSequence () && seq <= m_highTxAck)
     {
-      m_timestampToEcho = ts->GetTimestamp ();
+      m_timestampToEcho = value;
     }
 
   NS_LOG_INFO (m_node->GetId () << " Got timestamp=" <<
-               m_timestampToEcho << " and Echo="     << ts->GetEcho ());
+               m_timestampToEcho << " and Echo="     << echo);
 }
 
 void TcpSocketBase::ProcessOptions (const TcpHeader& header, bool post)
 {
-  TcpHeader::TcpOptionList options;
-  header.GetOptions (options);
-  
-  for(TcpHeader::TcpOptionList::const_iterator it(options.begin()); it != options.end(); ++it)
+  // The options of TcpSocketBase are read in place, the others are
+  // deserialized for the subclasses
+  for (const uint8_t *it = header.NextOption (); it != 0; it = header.NextOption (it))
   {
-    Ptr<const TcpOption> option = *it;
+    switch (it[0])
+      {
+      case TcpOption::NOP:
+      case TcpOption::WINSCALE:
+      case TcpOption::SACKPERMITTED:
+      case TcpOption::SACK:
+      case TcpOption::TS:
+        continue;
+      default:
+        break;
+      }
+    Ptr<const TcpOption> option = TcpHeader::DeserializeOption (it);
     if(post)
     {
       PostProcessOption (option);
@@ -3267,14 +3924,61 @@ TcpSocketBase::AddOptionTimestamp (TcpHeader& header)
 {
   NS_LOG_FUNCTION (this << header);
 
-  Ptr<TcpOptionTS> option = CreateObject<TcpOptionTS> ();
+  uint32_t value = TcpOptionTS::NowToTsValue ();
+  header.AppendTimestamp (value, m_timestampToEcho);
+  NS_LOG_INFO (m_node->GetId () << " Add option TS, ts=" <<
+               value << " echo=" << m_timestampToEcho);
+}
+
+void
+TcpSocketBase::AddOptionSackPermitted (TcpHeader& header)
+{
+  NS_LOG_FUNCTION (this << header);
+
+  header.AppendOption (CreateObject<TcpOptionSackPermitted> ());
+  NS_LOG_INFO (m_node->GetId () << " Add option SACK-permitted");
+}
+
+void
+TcpSocketBase::AddOptionSack (TcpHeader& header)
+{
+  NS_LOG_FUNCTION (this << header);
+
+  TcpTxBuffer32::SackList blocks;
+  if (m_rxBuffer->GetOutOfOrderBlocks (blocks) == 0)
+    {
+      return;
+    }
+  uint32_t room = header.GetMaxOptionLength () - header.GetOptionLength ();
+  if (room < 10)
+    {
+      NS_LOG_WARN ("No room left for the SACK option");
+      return;
+    }
+  uint32_t maxBlocks = std::min<uint32_t> ((room - 2) / 8, TcpOptionSack::MAX_BLOCKS);
 
-  option->SetTimestamp (TcpOptionTS::NowToTsValue ());
-  option->SetEcho (m_timestampToEcho);
+  Ptr<TcpOptionSack> option = CreateObject<TcpOptionSack> ();
+  // RFC 2018: the first block holds the last segment received
+  uint32_t first = blocks.size ();
+  for (uint32_t i = 0; i < blocks.size (); ++i)
+    {
+      if (blocks[i].first <= m_lastRxSegment && m_lastRxSegment < blocks[i].second)
+        {
+          first = i;
+          option->AddSackBlock (blocks[i]);
+          break;
+        }
+    }
+  for (uint32_t i = blocks.size (); i > 0 && option->GetNumSackBlocks () < maxBlocks; --i)
+    {
+      if (i - 1 != first)
+        {
+          option->AddSackBlock (blocks[i - 1]);
+        }
+    }
 
   header.AppendOption (option);
-  NS_LOG_INFO (m_node->GetId () << " Add option TS, ts=" <<
-               option->GetTimestamp () << " echo=" << m_timestampToEcho);
+  NS_LOG_INFO (m_node->GetId () << " Add option SACK with " << option->GetNumSackBlocks () << " blocks");
 }
 
 bool
@@ -3356,6 +4060,12 @@ TcpSocketBase::UpdateHighTxMark (SequenceNumber32 oldValue, SequenceNumber32 new
   m_highTxMarkTrace (oldValue, newValue);
 }
 
+void
+TcpSocketBase::UpdatePacingRate (DataRate oldValue, DataRate newValue)
+{
+  m_pacingRateTrace (oldValue, newValue);
+}
+
 Ptr<TcpSocketImpl>
 TcpSocketBase::Fork (void)
 {
@@ -33,6 +33,7 @@
 #include "ns3/ipv6-header.h"
 #include "ns3/ipv6-interface.h"
 #include "ns3/event-id.h"
+#include "tcp-timer-wheel.h"
 #include "tcp-tx-buffer.h"
 #include "tcp-rx-buffer.h"
 #include "rtt-estimator.h"
@@ -207,6 +208,12 @@ public:
   //  virtual void SetTxHead(const SequenceNumber32& seq);
   
   virtual TcpSocket::TcpStates_t GetState() const;
+
+  /**
+   * \brief Associate the L4 protocol, and run the timers with its timer wheel
+   * \param tcp the L4 protocol
+   */
+  virtual void SetTcp (Ptr<TcpL4Protocol> tcp);
   
   /**
    * \brief Callback pointer for cWnd trace chaining
@@ -233,6 +240,11 @@ public:
    */
   TracedCallback<SequenceNumber32, SequenceNumber32> m_nextTxSequenceTrace;
 
+  /**
+   * \brief Callback pointer for pacing rate chaining
+   */
+  TracedCallback<DataRate, DataRate> m_pacingRateTrace;
+
   /**
    * \brief Callback function to hook to TcpSocketState congestion window
    * \param oldValue old cWnd value
@@ -261,6 +273,13 @@ public:
    * \param newValue new high tx mark
    */
   void UpdateHighTxMark (SequenceNumber32 oldValue, SequenceNumber32 newValue);
+
+  /**
+   * \brief Callback function to hook to TcpSocketState pacing rate
+   * \param oldValue old pacing rate
+   * \param newValue new pacing rate
+   */
+  void UpdatePacingRate (DataRate oldValue, DataRate newValue);
   
   /**
    * \brief Callback function to hook to TcpSocketState next tx sequence
@@ -694,6 +713,99 @@ protected:
    */
   virtual void ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader);
 
+  /**
+   * \brief Process an ACK with the SACK based loss recovery of \RFC{6675}
+   *
+   * Called by ReceivedAck() once SACK has been negotiated. The scoreboard
+   * of the Tx buffer takes the place of the duplicate ACK counting: the
+   * segments are deemed lost with the duplicate threshold, or with RACK
+   * if enabled, and the window is not inflated during the recovery, the
+   * transmissions are limited by the pipe instead.
+   *
+   * \param packet the packet
+   * \param tcpHeader the packet's TCP header
+   */
+  void ReceivedAckSack (Ptr<Packet> packet, const TcpHeader& tcpHeader);
+
+  /**
+   * \brief Mark the lost segments in the scoreboard, with RACK or the duplicate threshold
+   *
+   * With RACK, arm the reordering timer for the segments which may still be
+   * delivered out of order.
+   *
+   * \returns the number of bytes newly marked lost
+   */
+  uint32_t DetectSackLosses (void);
+
+  /**
+   * \brief Enter the fast recovery on losses detected by the scoreboard
+   */
+  void EnterSackRecovery (void);
+
+  /**
+   * \brief Action upon expiration of the RACK reordering timer
+   */
+  void RackTimeout (void);
+
+  /**
+   * \brief Arm the tail loss probe timer (\RFC{8985} section 7.2)
+   *
+   * Only in the open state, with RACK enabled and data outstanding, and if
+   * the probe would come before the retransmission timeout.
+   */
+  void ScheduleLossProbe (void);
+
+  /**
+   * \brief Send a tail loss probe: new data if possible, the last segment sent otherwise
+   */
+  void LossProbeTimeout (void);
+
+  /**
+   * \brief Compute the pacing rate from the window and the smoothed RTT
+   *
+   * The rate is Window ()/SRTT scaled by PacingSsRatio in slow start and by
+   * PacingCaRatio afterwards, bounded by MaxPacingRate. It stays at zero,
+   * and the segments are not paced, until the first RTT sample.
+   */
+  void ComputePacingRate (void);
+
+  /**
+   * \brief Action upon expiration of the pacing timer: send the next segments
+   */
+  void PacingTimeout (void);
+
+  /**
+   * \brief Tell if the socket asks for ECN in its SYN
+   *
+   * \returns true with the "Ecn" attribute, or if the congestion control needs ECN
+   */
+  bool IsEcnRequested (void) const;
+
+  /**
+   * \brief Negotiate ECN (\RFC{3168} section 6.1.1) from a received SYN or SYN-ACK
+   *
+   * A SYN asks for ECN with both the ECE and CWR flags, a SYN-ACK accepts
+   * it with the ECE flag only.
+   *
+   * \param tcpHeader the SYN's TCP header
+   */
+  void NegotiateEcn (const TcpHeader& tcpHeader);
+
+  /**
+   * \brief Update the ECN-Echo state of the receiver from a data segment
+   *
+   * \param tcpHeader the segment's TCP header
+   */
+  void UpdateEcnEcho (const TcpHeader& tcpHeader);
+
+  /**
+   * \brief React to the ECN-Echo flag of an ACK: reduce the window once per window of data
+   *
+   * \param tcpHeader the ACK's TCP header
+   * \param bytesAcked bytes newly acked, 0 for a duplicate ACK
+   */
+  void ProcessEcnEcho (const TcpHeader& tcpHeader, uint32_t bytesAcked);
+
   /**
    * \brief Recv of a data, put into buffer, call L7 to get it if necessary
    * \param packet the packet
@@ -784,6 +896,10 @@ protected:
    */
   virtual void PostProcessOption(Ptr<const TcpOption> option);
   
+  /**
+   * Hand the options of a received segment to PreProcessOption or
+   * PostProcessOption, but those read by TcpSocketBase itself
+   */
   virtual void ProcessOptions (const TcpHeader& header, bool post);
   
   /**
@@ -792,9 +908,9 @@ protected:
    * Read the window scale option (encoded logarithmically) and save it.
    * Per RFC 1323, the value can't exceed 14.
    *
-   * \param option Window scale option read from the header
+   * \param scale shift count of the window scale option read from the header
    */
-  virtual void ProcessOptionWScale (const Ptr<const TcpOption> option);
+  virtual void ProcessOptionWScale (uint8_t scale);
   
   /**
    * \brief Add the window scale option to the header
@@ -805,6 +921,23 @@ protected:
    * \param header TcpHeader where the method should add the window scale option
    */
   virtual void AddOptionWScale (TcpHeader& header);
+
+  /**
+   * \brief Add the SACK-permitted option to the header of a SYN
+   *
+   * \param header TcpHeader where the method should add the option
+   */
+  void AddOptionSackPermitted (TcpHeader& header);
+
+  /**
+   * \brief Add the SACK option to the header of an ACK, if data is out of order
+   *
+   * The first block holds the last segment received, the others follow from
+   * the highest one, as many as the option space left allows.
+   *
+   * \param header TcpHeader where the method should add the option
+   */
+  void AddOptionSack (TcpHeader& header);
   
   /**
    * \brief Calculate window scale value based on receive buffer space
@@ -822,10 +955,11 @@ protected:
    * to utilize later to calculate RTT.
    *
    * \see EstimateRtt
-   * \param option Option from the segment
+   * \param value TSval of the option of the segment
+   * \param echo TSecr of the option of the segment
    * \param seq Sequence number of the segment
    */
-  void ProcessOptionTimestamp (const Ptr<const TcpOption> option,
+  void ProcessOptionTimestamp (uint32_t value, uint32_t echo,
                                const SequenceNumber32 &seq);
   /**
    * \brief Add the timestamp option to the header
@@ -899,11 +1033,14 @@ protected:
   virtual void SetState (TcpStates_t aState);
   
   // Counters and events
-  EventId           m_retxEvent;       //!< Retransmission event
-  EventId           m_lastAckEvent;    //!< Last ACK timeout event
-  EventId           m_delAckEvent;     //!< Delayed ACK timeout event
-  EventId           m_persistEvent;    //!< Persist event: Send 1 byte to probe for a non-zero Rx window
-  EventId           m_timewaitEvent;   //!< TIME_WAIT expiration event: Move this socket to CLOSED state
+  TcpTimer          m_retxEvent;       //!< Retransmission event
+  TcpTimer          m_lastAckEvent;    //!< Last ACK timeout event
+  TcpTimer          m_delAckEvent;     //!< Delayed ACK timeout event
+  TcpTimer          m_persistEvent;    //!< Persist event: Send 1 byte to probe for a non-zero Rx window
+  TcpTimer          m_timewaitEvent;   //!< TIME_WAIT expiration event: Move this socket to CLOSED state
+  TcpTimer          m_rackEvent;       //!< RACK reordering timer: Mark segments lost once the reordering window is over
+  TcpTimer          m_lossProbeEvent;  //!< Tail loss probe timer
+  TcpTimer          m_pacingTimer;     //!< Pacing timer: no segment is sent while it runs
   uint32_t          m_dupAckCount;     //!< Dupack counter
   uint32_t          m_delAckCount;     //!< Delayed ACK counter
   uint32_t          m_synCount;        //!< Count of remaining connection retries
@@ -911,6 +1048,7 @@ protected:
   TracedValue<Time> m_rto;             //!< Retransmit timeout
   
   TracedValue<Time> m_lastRtt;         //!< Last RTT sample collected
+  Time              m_minRtt;          //!< Minimum RTT sample collected, for RACK
   
   RttHistory_t      m_history;         //!< List of sent packet
 
@@ -946,6 +1084,17 @@ protected:
   // Fast Retransmit and Recovery
   SequenceNumber32       m_recover;      //!< Previous highest Tx seqnum for fast recovery
   uint32_t               m_retransOut;   //!< Number of retransmissions in this window
+  bool                   m_lossProbeOut; //!< A tail loss probe was sent and nothing new acknowledged since
+
+  // SACK receiver
+  SequenceNumber32       m_lastRxSegment; //!< Sequence number of the last data segment received
+
+  // ECN
+  bool                   m_ecn;          //!< ECN negotiated on the connection
+  bool                   m_ceReceived;   //!< The segment being processed was marked CE
+  bool                   m_ecnEcho;      //!< Set the ECE flag on the ACKs
+  bool                   m_ecnSendCwr;   //!< Set the CWR flag on the next new data segment
+  SequenceNumber32       m_ecnRecover;   //!< Highest Tx seqnum when the window was reduced on ECN-Echo
 
   // Transmission Control Block
   Ptr<TcpSocketState>    m_tcb;               //!< Congestion control information
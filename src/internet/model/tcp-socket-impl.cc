@@ -118,6 +118,54 @@ TcpSocketImpl::GetTypeId(void)
                  MakeBooleanAccessor (&TcpSocketImpl::SetLimitedTransmit,
                                       &TcpSocketImpl::GetLimitedTransmit),
                  MakeBooleanChecker ())
+  .AddAttribute ("Sack", "Enable or disable SACK option (RFC 2018) and SACK based loss recovery",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&TcpSocketImpl::SetSackEnabled,
+                                      &TcpSocketImpl::GetSackEnabled),
+                 MakeBooleanChecker ())
+  .AddAttribute ("Rack", "Enable or disable RACK-TLP time based loss detection (RFC 8985), "
+                 "used when SACK is negotiated",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&TcpSocketImpl::SetRackEnabled,
+                                      &TcpSocketImpl::GetRackEnabled),
+                 MakeBooleanChecker ())
+  .AddAttribute ("Ecn", "Negotiate ECN (RFC 3168): send ECN-capable data, echo the "
+                 "congestion experienced and reduce the window on ECN-Echo",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&TcpSocketImpl::SetEcnEnabled,
+                                      &TcpSocketImpl::GetEcnEnabled),
+                 MakeBooleanChecker ())
+  .AddAttribute ("Pacing", "Release the segments at the pacing rate instead of sending bursts",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&TcpSocketImpl::SetPacing,
+                                      &TcpSocketImpl::GetPacing),
+                 MakeBooleanChecker ())
+  .AddAttribute ("PacingSsRatio", "Pacing rate in slow start, in percent of cWnd/SRTT",
+                 UintegerValue (200),
+                 MakeUintegerAccessor (&TcpSocketImpl::SetPacingSsRatio,
+                                       &TcpSocketImpl::GetPacingSsRatio),
+                 MakeUintegerChecker<uint16_t> (1))
+  .AddAttribute ("PacingCaRatio", "Pacing rate in congestion avoidance, in percent of cWnd/SRTT",
+                 UintegerValue (120),
+                 MakeUintegerAccessor (&TcpSocketImpl::SetPacingCaRatio,
+                                       &TcpSocketImpl::GetPacingCaRatio),
+                 MakeUintegerChecker<uint16_t> (1))
+  .AddAttribute ("MaxPacingRate", "Upper bound of the pacing rate",
+                 DataRateValue (DataRate ("4Gb/s")),
+                 MakeDataRateAccessor (&TcpSocketImpl::SetMaxPacingRate,
+                                       &TcpSocketImpl::GetMaxPacingRate),
+                 MakeDataRateChecker ())
+  .AddAttribute ("Gso", "Send the new data in super-segments of several segments, "
+                 "cut into segments by the device that transmits them",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&TcpSocketImpl::SetGso,
+                                      &TcpSocketImpl::GetGso),
+                 MakeBooleanChecker ())
+  .AddAttribute ("GsoMaxSize", "Largest payload of a super-segment, in bytes",
+                 UintegerValue (64000),
+                 MakeUintegerAccessor (&TcpSocketImpl::SetGsoMaxSize,
+                                       &TcpSocketImpl::GetGsoMaxSize),
+                 MakeUintegerChecker<uint16_t> (1, 65000))
   
   ;
   return tid;
@@ -347,6 +395,96 @@ bool TcpSocketImpl::GetLimitedTransmit () const
 {
   return m_tcpParams->m_limitedTx;
 }
+
+void TcpSocketImpl::SetSackEnabled (bool flag)
+{
+  m_tcpParams->m_sackEnabled = flag;
+}
+
+bool TcpSocketImpl::GetSackEnabled () const
+{
+  return m_tcpParams->m_sackEnabled;
+}
+
+void TcpSocketImpl::SetRackEnabled (bool flag)
+{
+  m_tcpParams->m_rackEnabled = flag;
+}
+
+bool TcpSocketImpl::GetRackEnabled () const
+{
+  return m_tcpParams->m_rackEnabled;
+}
+
+void TcpSocketImpl::SetEcnEnabled (bool flag)
+{
+  m_tcpParams->m_ecnEnabled = flag;
+}
+
+bool TcpSocketImpl::GetEcnEnabled () const
+{
+  return m_tcpParams->m_ecnEnabled;
+}
+
+void TcpSocketImpl::SetPacing (bool flag)
+{
+  m_tcpParams->m_pacing = flag;
+}
+
+bool TcpSocketImpl::GetPacing () const
+{
+  return m_tcpParams->m_pacing;
+}
+
+void TcpSocketImpl::SetPacingSsRatio (uint16_t ratio)
+{
+  m_tcpParams->m_pacingSsRatio = ratio;
+}
+
+uint16_t TcpSocketImpl::GetPacingSsRatio () const
+{
+  return m_tcpParams->m_pacingSsRatio;
+}
+
+void TcpSocketImpl::SetPacingCaRatio (uint16_t ratio)
+{
+  m_tcpParams->m_pacingCaRatio = ratio;
+}
+
+uint16_t TcpSocketImpl::GetPacingCaRatio () const
+{
+  return m_tcpParams->m_pacingCaRatio;
+}
+
+void TcpSocketImpl::SetMaxPacingRate (DataRate rate)
+{
+  m_tcpParams->m_maxPacingRate = rate;
+}
+
+DataRate TcpSocketImpl::GetMaxPacingRate () const
+{
+  return m_tcpParams->m_maxPacingRate;
+}
+
+void TcpSocketImpl::SetGso (bool flag)
+{
+  m_tcpParams->m_gso = flag;
+}
+
+bool TcpSocketImpl::GetGso () const
+{
+  return m_tcpParams->m_gso;
+}
+
+void TcpSocketImpl::SetGsoMaxSize (uint16_t size)
+{
+  m_tcpParams->m_gsoMaxSize = size;
+}
+
+uint16_t TcpSocketImpl::GetGsoMaxSize () const
+{
+  return m_tcpParams->m_gsoMaxSize;
+}
   
 void TcpSocketImpl::SetMinRto (Time minRto)
 {
@@ -213,6 +213,33 @@ namespace ns3
     virtual void SetLimitedTransmit (bool flag);
     virtual bool GetLimitedTransmit () const;
     
+    virtual void SetSackEnabled (bool flag);
+    virtual bool GetSackEnabled () const;
+    
+    virtual void SetRackEnabled (bool flag);
+    virtual bool GetRackEnabled () const;
+    
+    virtual void SetEcnEnabled (bool flag);
+    virtual bool GetEcnEnabled () const;
+    
+    virtual void SetPacing (bool flag);
+    virtual bool GetPacing () const;
+    
+    virtual void SetPacingSsRatio (uint16_t ratio);
+    virtual uint16_t GetPacingSsRatio () const;
+    
+    virtual void SetPacingCaRatio (uint16_t ratio);
+    virtual uint16_t GetPacingCaRatio () const;
+    
+    virtual void SetMaxPacingRate (DataRate rate);
+    virtual DataRate GetMaxPacingRate () const;
+    
+    virtual void SetGso (bool flag);
+    virtual bool GetGso () const;
+    
+    virtual void SetGsoMaxSize (uint16_t size);
+    virtual uint16_t GetGsoMaxSize () const;
+    
     /**
      * \brief Call CopyObject<> to clone me
      * \returns a copy of the socket
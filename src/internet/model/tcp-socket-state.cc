@@ -41,6 +41,10 @@ namespace ns3
                      "Next sequence number to send (SND.NXT)",
                      MakeTraceSourceAccessor (&TcpSocketState::m_nextTxSequence),
                      "ns3::SequenceNumber32TracedValueCallback")
+    .AddTraceSource ("PacingRate",
+                     "The current TCP pacing rate",
+                     MakeTraceSourceAccessor (&TcpSocketState::m_pacingRate),
+                     "ns3::TcpSocketState::DataRateTracedValueCallback")
     ;
     return tid;
   }
@@ -57,7 +61,8 @@ namespace ns3
   m_congState (CA_OPEN),
   m_highTxMark (0),
   // Change m_nextTxSequence for non-zero initial sequence number
-  m_nextTxSequence (0)
+  m_nextTxSequence (0),
+  m_pacingRate (DataRate (0))
   {
   }
   
@@ -72,7 +77,8 @@ namespace ns3
   m_lastAckedSeq (other.m_lastAckedSeq),
   m_congState (other.m_congState),
   m_highTxMark (other.m_highTxMark),
-  m_nextTxSequence (other.m_nextTxSequence)
+  m_nextTxSequence (other.m_nextTxSequence),
+  m_pacingRate (other.m_pacingRate)
   {
   }
   
@@ -25,6 +25,7 @@
 #include "ns3/object.h"
 #include "ns3/traced-value.h"
 #include "ns3/sequence-number.h"
+#include "ns3/data-rate.h"
 
 namespace ns3 {
   
@@ -70,7 +71,7 @@ public:
                    *  we see some SACKs or dupacks. It is split of "Open" */
     CA_CWR,       /**< cWnd was reduced due to some Congestion Notification event.
                    *  It can be ECN, ICMP source quench, local device congestion.
-                   *  Not used in NS-3 right now. */
+                   *  In NS-3, it is entered on an ECN-Echo. */
     CA_RECOVERY,  /**< CWND was reduced, we are fast-retransmitting. */
     CA_LOSS,      /**< CWND was reduced due to RTO timeout or SACK reneging. */
     CA_LAST_STATE /**< Used only in debug messages */
@@ -86,6 +87,16 @@ public:
   typedef void (* TcpCongStatesTracedValueCallback)(const TcpCongState_t oldValue,
                       const TcpCongState_t newValue);
   
+  /**
+   * \ingroup tcp
+   * TracedValue Callback signature for the pacing rate
+   *
+   * \param [in] oldValue original value of the traced variable
+   * \param [in] newValue new value of the traced variable
+   */
+  typedef void (* DataRateTracedValueCallback)(const DataRate oldValue,
+                      const DataRate newValue);
+  
   /**
    * \brief Literal names of TCP states for use in log messages
    */
@@ -107,6 +118,8 @@ public:
   TracedValue<SequenceNumber32> m_highTxMark; //!< Highest seqno ever sent, regardless of ReTx
   TracedValue<SequenceNumber32> m_nextTxSequence; //!< Next seqnum to be sent (SND.NXT), ReTx pushes it back
   
+  TracedValue<DataRate>  m_pacingRate;      //!< Pacing rate, zero while the segments are not paced
+  
   /**
    * \brief Get cwnd in segments rather than bytes
    *
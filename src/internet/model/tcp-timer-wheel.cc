@@ -0,0 +1,434 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "tcp-timer-wheel.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpTimerWheel");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpTimerWheel);
+
+const uint32_t TcpTimerWheel::LEVELS;
+const uint32_t TcpTimerWheel::SLOT_BITS;
+const uint32_t TcpTimerWheel::SLOTS;
+
+static const uint64_t SLOT_MASK = TcpTimerWheel::SLOTS - 1;
+
+TcpTimer::TcpTimer ()
+  : m_wheel (0),
+    m_running (false),
+    m_slotTick (0),
+    m_pprev (0),
+    m_next (0)
+{
+}
+
+TcpTimer::TcpTimer (const TcpTimer &other)
+  : m_wheel (other.m_wheel),
+    m_running (false),
+    m_slotTick (0),
+    m_pprev (0),
+    m_next (0)
+{
+}
+
+TcpTimer::~TcpTimer ()
+{
+  Unlink ();
+}
+
+void
+TcpTimer::SetWheel (Ptr<TcpTimerWheel> wheel)
+{
+  NS_ASSERT_MSG (IsExpired (), "The timer must be stopped to change its wheel");
+  // A cancelled timer may still be linked in its slot
+  Unlink ();
+  m_wheel = wheel;
+}
+
+void
+TcpTimer::Arm (const Time &delay, const Callback<void> &callback)
+{
+  m_callback = callback;
+  m_expiry = Simulator::Now () + delay;
+  m_running = true;
+  // Re-armed to a later time: the timer is re-inserted when its slot is processed
+  if (m_pprev != 0 && m_slotTick <= m_wheel->TickOf (m_expiry))
+    {
+      return;
+    }
+  Unlink ();
+  m_wheel->Arm (this);
+}
+
+void
+TcpTimer::Cancel (void)
+{
+  if (m_wheel == 0)
+    {
+      m_event.Cancel ();
+    }
+  else
+    {
+      // Dropped when its slot is processed
+      m_running = false;
+    }
+}
+
+bool
+TcpTimer::IsExpired (void) const
+{
+  if (m_wheel == 0)
+    {
+      return m_event.IsExpired ();
+    }
+  return !m_running;
+}
+
+bool
+TcpTimer::IsRunning (void) const
+{
+  return !IsExpired ();
+}
+
+Time
+TcpTimer::GetDelayLeft (void) const
+{
+  if (m_wheel == 0)
+    {
+      return Simulator::GetDelayLeft (m_event);
+    }
+  return m_running ? m_expiry - Simulator::Now () : Seconds (0);
+}
+
+void
+TcpTimer::Unlink (void)
+{
+  if (m_pprev == 0)
+    {
+      return;
+    }
+  *m_pprev = m_next;
+  if (m_next != 0)
+    {
+      m_next->m_pprev = m_pprev;
+    }
+  m_pprev = 0;
+  m_next = 0;
+}
+
+TypeId
+TcpTimerWheel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpTimerWheel")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpTimerWheel> ()
+  ;
+  return tid;
+}
+
+TcpTimerWheel::TcpTimerWheel ()
+  : m_granularity (MilliSeconds (1)),
+    m_currentTick (0),
+    m_wakeupTick (0),
+    m_advancing (false),
+    m_nWakeups (0),
+    m_nEventsScheduled (0),
+    m_nExpirations (0)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t level = 0; level < LEVELS; ++level)
+    {
+      m_occupied[level] = 0;
+      for (uint32_t index = 0; index < SLOTS; ++index)
+        {
+          m_slots[level][index] = 0;
+        }
+    }
+}
+
+TcpTimerWheel::~TcpTimerWheel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TcpTimerWheel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_wakeup.Cancel ();
+  for (uint32_t level = 0; level < LEVELS; ++level)
+    {
+      for (uint32_t index = 0; index < SLOTS; ++index)
+        {
+          while (m_slots[level][index] != 0)
+            {
+              TcpTimer *timer = m_slots[level][index];
+              timer->m_running = false;
+              timer->Unlink ();
+            }
+        }
+      m_occupied[level] = 0;
+    }
+  Object::DoDispose ();
+}
+
+void
+TcpTimerWheel::SetGranularity (Time granularity)
+{
+  NS_LOG_FUNCTION (this << granularity);
+  NS_ASSERT_MSG (granularity.IsStrictlyPositive (), "The granularity must be positive");
+  NS_ASSERT_MSG (NextTick () == 0, "The wheel must be empty to change its granularity");
+  m_granularity = granularity;
+  m_currentTick = Simulator::Now ().GetTimeStep () / m_granularity.GetTimeStep ();
+}
+
+Time
+TcpTimerWheel::GetGranularity (void) const
+{
+  return m_granularity;
+}
+
+uint64_t
+TcpTimerWheel::GetNWakeups (void) const
+{
+  return m_nWakeups;
+}
+
+uint64_t
+TcpTimerWheel::GetNEventsScheduled (void) const
+{
+  return m_nEventsScheduled;
+}
+
+uint64_t
+TcpTimerWheel::GetNExpirations (void) const
+{
+  return m_nExpirations;
+}
+
+uint64_t
+TcpTimerWheel::TickOf (const Time &t) const
+{
+  int64_t step = m_granularity.GetTimeStep ();
+  return (t.GetTimeStep () + step - 1) / step;
+}
+
+void
+TcpTimerWheel::Arm (TcpTimer *timer)
+{
+  if (m_advancing)
+    {
+      // The wake-up is rescheduled once the slots are processed
+      Insert (timer, m_currentTick + 1);
+      return;
+    }
+
+  // Catch up with the time elapsed since the last wake-up, so that the
+  // timer does not land in a slot whose tick is already past. Nothing
+  // expires before the next wake-up, so this only cascades slots.
+  uint64_t now = Simulator::Now ().GetTimeStep () / m_granularity.GetTimeStep ();
+  if (!m_wakeup.IsRunning ())
+    {
+      m_currentTick = std::max (m_currentTick, now);
+    }
+  else if (m_currentTick + 1 < m_wakeupTick)
+    {
+      Advance (std::min (now, m_wakeupTick - 1));
+    }
+
+  Insert (timer, m_currentTick + 1);
+  if (!m_wakeup.IsRunning () || timer->m_slotTick < m_wakeupTick)
+    {
+      ScheduleWakeup ();
+    }
+}
+
+void
+TcpTimerWheel::Insert (TcpTimer *timer, uint64_t earliest)
+{
+  uint64_t tick = std::max (TickOf (timer->m_expiry), earliest);
+  uint64_t delta = tick - m_currentTick;
+
+  uint32_t level = 0;
+  while (level < LEVELS && (delta >> (SLOT_BITS * (level + 1))) != 0)
+    {
+      level++;
+    }
+  if (level == LEVELS)
+    {
+      // Beyond the range of the wheel: parked in the farthest slot, and
+      // re-inserted from there
+      level = LEVELS - 1;
+      tick = m_currentTick + (uint64_t (1) << (SLOT_BITS * LEVELS)) - 1;
+    }
+
+  uint32_t shift = SLOT_BITS * level;
+  uint32_t index = (tick >> shift) & SLOT_MASK;
+  timer->m_slotTick = (tick >> shift) << shift;
+
+  TcpTimer **head = &m_slots[level][index];
+  timer->m_next = *head;
+  if (*head != 0)
+    {
+      (*head)->m_pprev = &timer->m_next;
+    }
+  *head = timer;
+  timer->m_pprev = head;
+  m_occupied[level] |= uint64_t (1) << index;
+}
+
+uint64_t
+TcpTimerWheel::NextTick (void) const
+{
+  uint64_t next = 0;
+  for (uint32_t level = 0; level < LEVELS; ++level)
+    {
+      uint64_t occupied = m_occupied[level];
+      if (occupied == 0)
+        {
+          continue;
+        }
+      uint32_t shift = SLOT_BITS * level;
+      uint32_t current = (m_currentTick >> shift) & SLOT_MASK;
+      // First slot after the current one; the current slot itself is a full
+      // turn away
+      uint64_t after = (current == SLOT_MASK) ? 0 : occupied & (~uint64_t (0) << (current + 1));
+      uint64_t distance;
+      if (after != 0)
+        {
+          distance = __builtin_ctzll (after) - current;
+        }
+      else
+        {
+          distance = __builtin_ctzll (occupied) + SLOTS - current;
+        }
+      uint64_t tick = ((m_currentTick >> shift) + distance) << shift;
+      if (next == 0 || tick < next)
+        {
+          next = tick;
+        }
+    }
+  return next;
+}
+
+void
+TcpTimerWheel::ScheduleWakeup (void)
+{
+  uint64_t next = NextTick ();
+  if (next == 0)
+    {
+      m_wakeup.Cancel ();
+      return;
+    }
+  if (m_wakeup.IsRunning () && m_wakeupTick == next)
+    {
+      return;
+    }
+  m_wakeup.Cancel ();
+  m_wakeupTick = next;
+  Time delay = TimeStep (next * m_granularity.GetTimeStep ()) - Simulator::Now ();
+  NS_ASSERT (!delay.IsStrictlyNegative ());
+  m_wakeup = Simulator::Schedule (delay, &TcpTimerWheel::Wakeup, this);
+  m_nEventsScheduled++;
+}
+
+void
+TcpTimerWheel::Wakeup (void)
+{
+  NS_LOG_FUNCTION (this << m_wakeupTick);
+  m_nWakeups++;
+  Advance (m_wakeupTick);
+  ScheduleWakeup ();
+}
+
+void
+TcpTimerWheel::Advance (uint64_t target)
+{
+  m_advancing = true;
+  while (true)
+    {
+      uint64_t next = NextTick ();
+      if (next == 0 || next > target)
+        {
+          // No slot to process in between
+          m_currentTick = std::max (m_currentTick, target);
+          break;
+        }
+      m_currentTick = next;
+      // Cascade the higher levels first, their timers may expire on this tick
+      for (uint32_t level = LEVELS - 1; level > 0; --level)
+        {
+          if ((next & ((uint64_t (1) << (SLOT_BITS * level)) - 1)) == 0)
+            {
+              ProcessSlot (level);
+            }
+        }
+      ProcessSlot (0);
+    }
+  m_advancing = false;
+}
+
+void
+TcpTimerWheel::ProcessSlot (uint32_t level)
+{
+  uint32_t index = (m_currentTick >> (SLOT_BITS * level)) & SLOT_MASK;
+  TcpTimer *list = m_slots[level][index];
+  if (list == 0)
+    {
+      m_occupied[level] &= ~(uint64_t (1) << index);
+      return;
+    }
+
+  // Detach the slot: the expired timers may re-arm themselves or others
+  m_slots[level][index] = 0;
+  m_occupied[level] &= ~(uint64_t (1) << index);
+  list->m_pprev = &list;
+
+  while (list != 0)
+    {
+      TcpTimer *timer = list;
+      timer->Unlink ();
+      if (!timer->m_running)
+        {
+          continue;
+        }
+      if (level > 0)
+        {
+          // Timers expiring on this tick go to the level 0 slot processed next
+          Insert (timer, m_currentTick);
+        }
+      else if (TickOf (timer->m_expiry) > m_currentTick)
+        {
+          // Re-armed since it was inserted
+          Insert (timer, m_currentTick + 1);
+        }
+      else
+        {
+          timer->m_running = false;
+          m_nExpirations++;
+          Callback<void> callback = timer->m_callback;
+          callback ();
+        }
+    }
+}
+
+} // namespace ns3
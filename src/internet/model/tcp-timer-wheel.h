@@ -0,0 +1,250 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef TCP_TIMER_WHEEL_H
+#define TCP_TIMER_WHEEL_H
+
+#include <stdint.h>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/callback.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+class TcpTimerWheel;
+
+/**
+ * \ingroup tcp
+ * \brief A TCP timer, run either by the simulator or by a TcpTimerWheel
+ *
+ * Same interface as the EventId it replaces in the sockets. Without a wheel,
+ * every Schedule () inserts an event in the simulator. With a wheel, the
+ * timer is only linked in one of its slots; re-arming a timer to a later
+ * time (the RTO on every new ACK) or cancelling it is done lazily, without
+ * moving it, and the simulator only sees the wake-ups of the wheel.
+ *
+ * Copying a timer only copies its wheel: a forked socket gets stopped timers.
+ */
+class TcpTimer
+{
+public:
+  TcpTimer ();
+  TcpTimer (const TcpTimer &other);
+  ~TcpTimer ();
+
+  /**
+   * \brief Run the timer with a wheel rather than with the simulator
+   * \param wheel the wheel, or 0 to use the simulator
+   *
+   * Must be called while the timer is stopped.
+   */
+  void SetWheel (Ptr<TcpTimerWheel> wheel);
+
+  /**
+   * \brief (Re)arm the timer, cancelling any pending expiration
+   * \param delay delay before the expiration
+   * \param mem_ptr member method to call on expiration
+   * \param obj object on which to call the method
+   */
+  template <typename MEM, typename OBJ>
+  void Schedule (const Time &delay, MEM mem_ptr, OBJ obj);
+
+  /**
+   * \brief (Re)arm the timer, cancelling any pending expiration
+   * \param delay delay before the expiration
+   * \param mem_ptr member method to call on expiration
+   * \param obj object on which to call the method
+   * \param a1 argument of the method
+   */
+  template <typename MEM, typename OBJ, typename T1>
+  void Schedule (const Time &delay, MEM mem_ptr, OBJ obj, T1 a1);
+
+  /// Stop the timer
+  void Cancel (void);
+
+  /// \return true if the timer is not running
+  bool IsExpired (void) const;
+
+  /// \return true if the timer is running
+  bool IsRunning (void) const;
+
+  /// \return the delay before the expiration, zero if not running
+  Time GetDelayLeft (void) const;
+
+private:
+  friend class TcpTimerWheel;
+
+  TcpTimer &operator = (const TcpTimer &);
+
+  /**
+   * \brief (Re)arm the timer on its wheel
+   * \param delay delay before the expiration
+   * \param callback function to call on expiration
+   */
+  void Arm (const Time &delay, const Callback<void> &callback);
+
+  /// Unlink the timer from the slot it is in, if any
+  void Unlink (void);
+
+  Ptr<TcpTimerWheel> m_wheel;   //!< Wheel running the timer, 0 for the simulator
+  EventId m_event;              //!< Simulator event, when there is no wheel
+  Callback<void> m_callback;    //!< Function to call on expiration
+  Time m_expiry;                //!< Expiration time, when running on a wheel
+  bool m_running;               //!< True if the timer runs on the wheel
+  uint64_t m_slotTick;          //!< Tick at which the slot holding the timer is processed
+  TcpTimer **m_pprev;           //!< Link pointing to this timer, 0 if not linked
+  TcpTimer *m_next;             //!< Next timer in the same slot
+};
+
+/**
+ * \ingroup tcp
+ * \brief Hierarchical timer wheel for the TCP timers of a node
+ *
+ * The time is divided in ticks of the wheel granularity, and a timer expires
+ * on the first tick at or after its expiration time. The wheel has LEVELS
+ * levels of SLOTS slots: level 0 holds the timers expiring in the next SLOTS
+ * ticks, each slot of level L covers SLOTS^L ticks and is cascaded to the
+ * lower levels when the wheel reaches it.
+ *
+ * The wheel keeps a single simulator event, on the next tick with work to do
+ * (timers to expire or a slot to cascade). Timers are re-armed lazily: a
+ * timer pushed back or cancelled stays in its slot, and is re-inserted or
+ * dropped when the slot is processed.
+ */
+class TcpTimerWheel : public Object
+{
+public:
+  /**
+   * Get the type ID.
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TcpTimerWheel ();
+  virtual ~TcpTimerWheel ();
+
+  /**
+   * \param granularity duration of a tick
+   *
+   * Must be set while the wheel is empty.
+   */
+  void SetGranularity (Time granularity);
+
+  /// \return the duration of a tick
+  Time GetGranularity (void) const;
+
+  /// \return the number of times the wheel woke up
+  uint64_t GetNWakeups (void) const;
+
+  /// \return the number of simulator events scheduled by the wheel
+  uint64_t GetNEventsScheduled (void) const;
+
+  /// \return the number of timer expirations
+  uint64_t GetNExpirations (void) const;
+
+  static const uint32_t LEVELS = 4;       //!< Number of levels
+  static const uint32_t SLOT_BITS = 6;    //!< log2 of the number of slots per level
+  static const uint32_t SLOTS = 1 << SLOT_BITS; //!< Number of slots per level
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  friend class TcpTimer;
+
+  /// Insert a timer armed by a socket, waking up the wheel earlier if needed
+  void Arm (TcpTimer *timer);
+
+  /**
+   * \brief Link a running timer in the slot matching its expiration
+   * \param timer the timer
+   * \param earliest the earliest tick the timer can expire at
+   */
+  void Insert (TcpTimer *timer, uint64_t earliest);
+
+  /**
+   * \brief Process the ticks up to a given one
+   * \param target the last tick to process
+   */
+  void Advance (uint64_t target);
+
+  /**
+   * \brief Process the timers of the slot of a level reached by the wheel
+   * \param level the level: the timers of level 0 expire, the others are cascaded
+   */
+  void ProcessSlot (uint32_t level);
+
+  /// Simulator event of the wheel
+  void Wakeup (void);
+
+  /// (Re)schedule the simulator event on the next tick with work to do
+  void ScheduleWakeup (void);
+
+  /// \return the next tick with work to do, or 0 if the wheel is empty
+  uint64_t NextTick (void) const;
+
+  /// \return the first tick at or after a time
+  uint64_t TickOf (const Time &t) const;
+
+  Time m_granularity;           //!< Duration of a tick
+  uint64_t m_currentTick;       //!< Last tick processed
+  uint64_t m_wakeupTick;        //!< Tick of m_wakeup
+  bool m_advancing;             //!< True while the wheel processes its slots
+  EventId m_wakeup;             //!< Simulator event of the wheel
+  /// Bitmap of the slots of each level that may hold timers
+  uint64_t m_occupied[LEVELS];
+  TcpTimer *m_slots[LEVELS][SLOTS]; //!< Heads of the slot lists
+
+  uint64_t m_nWakeups;          //!< Number of wake-ups
+  uint64_t m_nEventsScheduled;  //!< Number of simulator events scheduled
+  uint64_t m_nExpirations;      //!< Number of timer expirations
+};
+
+template <typename MEM, typename OBJ>
+void
+TcpTimer::Schedule (const Time &delay, MEM mem_ptr, OBJ obj)
+{
+  if (m_wheel == 0)
+    {
+      m_event.Cancel ();
+      m_event = Simulator::Schedule (delay, mem_ptr, obj);
+    }
+  else
+    {
+      Arm (delay, MakeCallback (mem_ptr, obj));
+    }
+}
+
+template <typename MEM, typename OBJ, typename T1>
+void
+TcpTimer::Schedule (const Time &delay, MEM mem_ptr, OBJ obj, T1 a1)
+{
+  if (m_wheel == 0)
+    {
+      m_event.Cancel ();
+      m_event = Simulator::Schedule (delay, mem_ptr, obj, a1);
+    }
+  else
+    {
+      Arm (delay, MakeCallback (mem_ptr, obj).Bind (a1));
+    }
+}
+
+} // namespace ns3
+
+#endif /* TCP_TIMER_WHEEL_H */
@@ -25,6 +25,7 @@
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/boolean.h"
 
 #include "tcp-tx-buffer.h"
 
@@ -46,6 +47,18 @@ TcpTxBuffer<uint32_t, int32_t>::GetTypeId (void)
                      "First unacknowledged sequence number (SND.UNA)",
                      MakeTraceSourceAccessor (&TcpTxBuffer32::m_firstByteSeq),
                      "ns3::SequenceNumber32TracedValueCallback")
+    .AddAttribute ("UseRing",
+                   "Keep the data in a ring indexed by byte offset rather than in a list",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpTxBuffer32::SetUseRing,
+                                        &TcpTxBuffer32::GetUseRing),
+                   MakeBooleanChecker ())
+    .AddAttribute ("VirtualPayload",
+                   "Only count the bytes sent by the application, segments are zero-filled packets",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpTxBuffer32::SetVirtualPayload,
+                                        &TcpTxBuffer32::GetVirtualPayload),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -64,6 +77,18 @@ NS_OBJECT_ENSURE_REGISTERED (TcpTxBuffer32);
                      "First unacknowledged sequence number (SND.UNA)",
                      MakeTraceSourceAccessor (&TcpTxBuffer64::m_firstByteSeq),
                      "ns3::SequenceNumber64TracedValueCallback")
+    .AddAttribute ("UseRing",
+                   "Keep the data in a ring indexed by byte offset rather than in a list",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpTxBuffer64::SetUseRing,
+                                        &TcpTxBuffer64::GetUseRing),
+                   MakeBooleanChecker ())
+    .AddAttribute ("VirtualPayload",
+                   "Only count the bytes sent by the application, segments are zero-filled packets",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpTxBuffer64::SetVirtualPayload,
+                                        &TcpTxBuffer64::GetVirtualPayload),
+                   MakeBooleanChecker ())
     ;
     return tid;
   }
@@ -80,7 +105,9 @@ NS_OBJECT_ENSURE_REGISTERED (TcpTxBuffer64);
   
 template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
 TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::TcpTxBuffer (NUMERIC_TYPE n)
-  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0)
+  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0),
+    m_virtualPayload (false), m_useRing (false), m_ringHead (0), m_ringCount (0), m_ringCursor (0), m_ringDiscarded (0),
+    m_sentOut (0), m_sackedOut (0), m_lostOut (0), m_retransOut (0), m_rackEnd (n), m_rackValid (false)
 {
 }
 
@@ -142,7 +169,18 @@ TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          m_data.push_back (p);
+          if (m_virtualPayload)
+            {
+              // The payload is generated again by CopyFromSequence
+            }
+          else if (m_useRing)
+            {
+              RingPush (p);
+            }
+          else
+            {
+              m_data.push_back (p);
+            }
           m_size += p->GetSize ();
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" << m_firstByteSeq + SequenceNumber32 (m_size));
         }
@@ -176,13 +214,17 @@ TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::CopyFromSequence (uint32_t numBytes,
     {
       return Create<Packet> (); // Empty packet returned
     }
-  if (m_data.size () == 0)
+  if (m_data.size () == 0 && m_ringCount == 0)
     { // No actual data, just return dummy-data packet of correct size
       return Create<Packet> (s);
     }
 
   // Extract data from the buffer and return
   uint32_t offset = seq - m_firstByteSeq.Get ();
+  if (m_useRing)
+    {
+      return RingCopyFromSequence (s, offset);
+    }
   uint32_t count = 0;      // Offset of the first byte of a packet in the buffer
   uint32_t pktSize = 0;
   bool beginFound = false;
@@ -253,10 +295,19 @@ TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::DiscardUpTo (const SequenceNumber<NUMERI
   // Cases do not need to scan the buffer
   if (m_firstByteSeq >= seq) return;
 
+  DiscardSentUpTo (seq);
+
   // Scan the buffer and discard packets
   uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
   uint32_t pktSize;
   NS_LOG_LOGIC ("Offset=" << offset);
+  if (m_useRing || m_virtualPayload)
+    { // Beyond m_size only when ACKing a FIN
+      pktSize = std::min (offset, m_size);
+      RingDiscard (pktSize);
+      m_size -= pktSize;
+      m_firstByteSeq += pktSize;
+    }
   BufIterator i = m_data.begin ();
   while (i != m_data.end ())
     {
@@ -288,6 +339,509 @@ TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::DiscardUpTo (const SequenceNumber<NUMERI
                         <<" numPkts="<< m_data.size ());
   NS_ASSERT (m_firstByteSeq == seq);
 }
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::SetUseRing (bool useRing)
+{
+  NS_LOG_FUNCTION (this << useRing);
+  NS_ASSERT_MSG (m_size == 0, "Can't change the storage of a non empty buffer");
+  m_useRing = useRing;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+bool
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::GetUseRing (void) const
+{
+  return m_useRing;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::SetVirtualPayload (bool virtualPayload)
+{
+  NS_LOG_FUNCTION (this << virtualPayload);
+  NS_ASSERT_MSG (m_size == 0, "Can't change the payload mode of a non empty buffer");
+  m_virtualPayload = virtualPayload;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+bool
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::GetVirtualPayload (void) const
+{
+  return m_virtualPayload;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+typename TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::Chunk&
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::RingAt (uint32_t i)
+{
+  return m_ring[(m_ringHead + i) & (m_ring.size () - 1)];
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::RingPush (Ptr<Packet> p)
+{
+  if (m_ringCount == m_ring.size ())
+    { // Double the ring, and unwrap it on the way
+      std::vector<Chunk> ring (std::max<size_t> (16, 2 * m_ring.size ()));
+      for (uint32_t i = 0; i < m_ringCount; ++i)
+        {
+          ring[i] = RingAt (i);
+        }
+      m_ring.swap (ring);
+      m_ringHead = 0;
+      NS_LOG_LOGIC ("Ring grown to " << m_ring.size () << " packets");
+    }
+  Chunk &chunk = RingAt (m_ringCount);
+  chunk.packet = p;
+  chunk.end = m_ringDiscarded + m_size + p->GetSize ();
+  ++m_ringCount;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+uint32_t
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::RingFind (uint64_t byte)
+{
+  // Segments are mostly sent in sequence: try where the last one ended first
+  for (uint32_t i = m_ringCursor; i < m_ringCount && i <= m_ringCursor + 1; ++i)
+    {
+      Chunk &chunk = RingAt (i);
+      if (chunk.end > byte && chunk.end - chunk.packet->GetSize () <= byte)
+        {
+          return i;
+        }
+    }
+  // Retransmission, look for the first chunk ending after byte
+  uint32_t first = 0;
+  uint32_t count = m_ringCount;
+  while (count > 0)
+    {
+      uint32_t step = count / 2;
+      if (RingAt (first + step).end <= byte)
+        {
+          first += step + 1;
+          count -= step + 1;
+        }
+      else
+        {
+          count = step;
+        }
+    }
+  NS_ASSERT (first < m_ringCount);
+  return first;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+Ptr<Packet>
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::RingCopyFromSequence (uint32_t numBytes, uint32_t offset)
+{
+  uint64_t byte = m_ringDiscarded + offset;
+  uint32_t i = RingFind (byte);
+  Chunk *chunk = &RingAt (i);
+  uint32_t packetOffset = byte - (chunk->end - chunk->packet->GetSize ());
+  uint32_t fragmentLength = std::min<uint64_t> (chunk->end - byte, numBytes);
+  NS_LOG_LOGIC ("First byte found in packet #" << i << " at offset " << packetOffset);
+  Ptr<Packet> outPacket = chunk->packet->CreateFragment (packetOffset, fragmentLength);
+  while (outPacket->GetSize () < numBytes)
+    { // Segment spanning several packets
+      chunk = &RingAt (++i);
+      fragmentLength = std::min (chunk->packet->GetSize (), numBytes - outPacket->GetSize ());
+      if (fragmentLength == chunk->packet->GetSize ())
+        {
+          outPacket->AddAtEnd (chunk->packet);
+        }
+      else
+        {
+          outPacket->AddAtEnd (chunk->packet->CreateFragment (0, fragmentLength));
+        }
+    }
+  m_ringCursor = i;
+  NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
+  return outPacket;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::RingDiscard (uint32_t numBytes)
+{
+  m_ringDiscarded += numBytes;
+  while (m_ringCount > 0 && RingAt (0).end <= m_ringDiscarded)
+    {
+      NS_LOG_LOGIC ("Removed one packet of size " << RingAt (0).packet->GetSize ());
+      RingAt (0).packet = 0;
+      m_ringHead = (m_ringHead + 1) & (m_ring.size () - 1);
+      --m_ringCount;
+      if (m_ringCursor > 0)
+        {
+          --m_ringCursor;
+        }
+    }
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::RecordSent (const SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>& seq,
+                                                    uint32_t size, Time now)
+{
+  NS_LOG_FUNCTION (this << seq << size << now);
+  if (size == 0)
+    {
+      return;
+    }
+  SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> end = seq + size;
+  SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> recordedEnd = seq;
+  if (!m_sentList.empty ())
+    {
+      recordedEnd = m_sentList.back ().start + m_sentList.back ().size;
+    }
+  if (seq < recordedEnd)
+    { // Retransmission of recorded segments
+      uint32_t first = SplitAt (seq);
+      uint32_t last = SplitAt (std::min (end, recordedEnd));
+      for (uint32_t k = first; k < last; ++k)
+        {
+          SentSegment &segment = m_sentList[k];
+          segment.sent = now;
+          if (!segment.sacked && !segment.retrans)
+            {
+              segment.retrans = true;
+              m_retransOut += segment.size;
+            }
+        }
+    }
+  if (end > recordedEnd)
+    { // New data
+      SentSegment segment;
+      segment.start = std::max (seq, recordedEnd);
+      segment.size = end - segment.start;
+      segment.sent = now;
+      segment.sacked = false;
+      segment.lost = false;
+      segment.retrans = false;
+      m_sentList.push_back (segment);
+      m_sentOut += segment.size;
+    }
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+uint32_t
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::UpdateScoreboard (const SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>& ack,
+                                                          const SackList& blocks, Time now, Time minRtt)
+{
+  NS_LOG_FUNCTION (this << ack << blocks.size () << now);
+  // Segments delivered by the cumulative acknowledgment
+  for (typename SentList::const_iterator it = m_sentList.begin ();
+       it != m_sentList.end () && it->start + it->size <= ack; ++it)
+    {
+      if (!it->sacked)
+        {
+          RackDelivered (*it, now, minRtt);
+        }
+    }
+  DiscardSentUpTo (ack);
+
+  uint32_t newlySacked = 0;
+  for (typename SackList::const_iterator block = blocks.begin (); block != blocks.end (); ++block)
+    {
+      if (m_sentList.empty () || block->second <= ack || block->first >= block->second)
+        {
+          continue;
+        }
+      SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> recordedEnd = m_sentList.back ().start + m_sentList.back ().size;
+      SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> left = std::max (block->first, std::max (ack, m_sentList.front ().start));
+      SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> right = std::min (block->second, recordedEnd);
+      if (left >= right)
+        {
+          continue;
+        }
+      uint32_t first = SplitAt (left);
+      uint32_t last = SplitAt (right);
+      for (uint32_t k = first; k < last; ++k)
+        {
+          SentSegment &segment = m_sentList[k];
+          if (segment.sacked)
+            {
+              continue;
+            }
+          RackDelivered (segment, now, minRtt);
+          segment.sacked = true;
+          m_sackedOut += segment.size;
+          newlySacked += segment.size;
+          if (segment.lost)
+            {
+              segment.lost = false;
+              m_lostOut -= segment.size;
+            }
+          if (segment.retrans)
+            {
+              segment.retrans = false;
+              m_retransOut -= segment.size;
+            }
+        }
+    }
+  NS_LOG_LOGIC ("Newly SACKed " << newlySacked << " sacked=" << m_sackedOut <<
+                " lost=" << m_lostOut << " retrans=" << m_retransOut);
+  return newlySacked;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+uint32_t
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::MarkLostByCount (uint32_t dupThresh, uint32_t segSize)
+{
+  NS_LOG_FUNCTION (this << dupThresh << segSize);
+  if (m_sackedOut == 0)
+    {
+      return 0;
+    }
+  // Walk down from the highest segment, counting what has been SACKed above
+  uint32_t lost = m_lostOut;
+  uint32_t sackedBytes = 0;
+  uint32_t sackedSegments = 0;
+  for (typename SentList::reverse_iterator it = m_sentList.rbegin (); it != m_sentList.rend (); ++it)
+    {
+      if (it->sacked)
+        {
+          sackedBytes += it->size;
+          ++sackedSegments;
+        }
+      else if (!it->lost && !it->retrans
+               && (sackedSegments >= dupThresh || sackedBytes > (dupThresh - 1) * segSize))
+        {
+          MarkLost (*it);
+        }
+    }
+  return m_lostOut - lost;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+uint32_t
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::MarkLostByTime (Time now, Time reoWnd, Time& timeout)
+{
+  NS_LOG_FUNCTION (this << now << reoWnd);
+  timeout = Time (0);
+  if (!m_rackValid || (m_sackedOut == 0 && m_lostOut == 0 && m_retransOut == 0))
+    { // Nothing delivered out of order: the segments sent before the last delivery are acknowledged
+      return 0;
+    }
+  uint32_t lost = m_lostOut;
+  for (typename SentList::iterator it = m_sentList.begin (); it != m_sentList.end (); ++it)
+    {
+      if (it->sent > m_rackSent || (it->sent == m_rackSent && it->start + it->size >= m_rackEnd))
+        { // Sent after the last delivery: nothing to tell yet
+          continue;
+        }
+      if (it->sacked || (it->lost && !it->retrans))
+        {
+          continue;
+        }
+      Time remaining = it->sent + m_rackRtt + reoWnd - now;
+      if (!remaining.IsStrictlyPositive ())
+        {
+          MarkLost (*it);
+        }
+      else if (remaining > timeout)
+        {
+          timeout = remaining;
+        }
+    }
+  return m_lostOut - lost;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::MarkAllLost (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (typename SentList::iterator it = m_sentList.begin (); it != m_sentList.end (); ++it)
+    {
+      if (!it->sacked)
+        {
+          MarkLost (*it);
+        }
+    }
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+bool
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::NextLost (SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>& seq,
+                                                  uint32_t& size) const
+{
+  if (m_lostOut == 0)
+    {
+      return false;
+    }
+  for (typename SentList::const_iterator it = m_sentList.begin (); it != m_sentList.end (); ++it)
+    {
+      if (it->lost && !it->retrans)
+        {
+          seq = it->start;
+          size = it->size;
+          return true;
+        }
+    }
+  return false;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+bool
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::LastSent (SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>& seq,
+                                                  uint32_t& size) const
+{
+  if (m_sentList.empty ())
+    {
+      return false;
+    }
+  seq = m_sentList.back ().start;
+  size = m_sentList.back ().size;
+  return true;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+uint32_t
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::GetPipe (void) const
+{
+  return m_sentOut - m_sackedOut - m_lostOut + m_retransOut;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+uint32_t
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::GetSacked (void) const
+{
+  return m_sackedOut;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+uint32_t
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::GetLost (void) const
+{
+  return m_lostOut;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+uint32_t
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::GetRetransmitted (void) const
+{
+  return m_retransOut;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+Time
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::GetRackRtt (void) const
+{
+  return m_rackRtt;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::ResetScoreboard (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_sentList.clear ();
+  m_sentOut = 0;
+  m_sackedOut = 0;
+  m_lostOut = 0;
+  m_retransOut = 0;
+  m_rackValid = false;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+uint32_t
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::SplitAt (const SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>& seq)
+{
+  // Binary search of the first segment ending after seq
+  uint32_t low = 0;
+  uint32_t high = m_sentList.size ();
+  while (low < high)
+    {
+      uint32_t middle = (low + high) / 2;
+      if (m_sentList[middle].start + m_sentList[middle].size <= seq)
+        {
+          low = middle + 1;
+        }
+      else
+        {
+          high = middle;
+        }
+    }
+  if (low == m_sentList.size () || m_sentList[low].start >= seq)
+    {
+      return low;
+    }
+  SentSegment tail = m_sentList[low];
+  uint32_t headSize = seq - m_sentList[low].start;
+  m_sentList[low].size = headSize;
+  tail.start = seq;
+  tail.size -= headSize;
+  m_sentList.insert (m_sentList.begin () + low + 1, tail);
+  return low + 1;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::RackDelivered (const SentSegment& segment, Time now, Time minRtt)
+{
+  Time rtt = now - segment.sent;
+  if (segment.retrans && rtt < minRtt)
+    { // Probably delivered by the original transmission: ambiguous
+      return;
+    }
+  SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> end = segment.start + segment.size;
+  if (!m_rackValid || segment.sent > m_rackSent || (segment.sent == m_rackSent && end > m_rackEnd))
+    {
+      m_rackSent = segment.sent;
+      m_rackEnd = end;
+      m_rackRtt = rtt;
+      m_rackValid = true;
+    }
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::MarkLost (SentSegment& segment)
+{
+  NS_LOG_LOGIC ("Segment " << segment.start << " of size " << segment.size << " lost");
+  if (!segment.lost)
+    {
+      segment.lost = true;
+      m_lostOut += segment.size;
+    }
+  if (segment.retrans)
+    { // The retransmission was lost too, or it is a probe
+      segment.retrans = false;
+      m_retransOut -= segment.size;
+    }
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::DiscardSentUpTo (const SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>& seq)
+{
+  if (m_sentList.empty ())
+    {
+      return;
+    }
+  SplitAt (seq);
+  while (!m_sentList.empty () && m_sentList.front ().start < seq)
+    {
+      const SentSegment &segment = m_sentList.front ();
+      m_sentOut -= segment.size;
+      if (segment.sacked)
+        {
+          m_sackedOut -= segment.size;
+        }
+      if (segment.lost)
+        {
+          m_lostOut -= segment.size;
+        }
+      if (segment.retrans)
+        {
+          m_retransOut -= segment.size;
+        }
+      m_sentList.pop_front ();
+    }
+}
   
 //Explicit instantiation of the TcpTxBuffer types
 template class TcpTxBuffer<uint32_t, int32_t>;
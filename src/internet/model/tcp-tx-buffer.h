@@ -21,7 +21,11 @@
 #ifndef TCP_TX_BUFFER_H
 #define TCP_TX_BUFFER_H
 
+#include <deque>
 #include <list>
+#include <utility>
+#include <vector>
+#include "ns3/nstime.h"
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object.h"
@@ -36,12 +40,37 @@ class Packet;
  *
  * \brief class for keeping the data sent by the application to the TCP socket, i.e.
  *        the sending buffer.
+ *
+ * By default the application packets are kept in a list, which is walked
+ * from the head to build each segment. With the UseRing attribute they are
+ * kept in a ring indexed by byte offset instead: a segment is located with a
+ * lookup starting at the last segment sent, and handed out as a fragment of
+ * the application packet (sharing its data) unless it spans several packets.
+ * Acknowledged packets are popped from the ring head, a partially acknowledged
+ * packet is only trimmed when it is sent again.
+ *
+ * With the VirtualPayload attribute no packet is stored at all, only the
+ * byte count, and segments are built as zero-filled packets.
+ *
+ * When the connection uses selective acknowledgments, the socket also keeps
+ * here the scoreboard of \RFC{6675}: one record per segment sent, telling
+ * when it was last sent and whether it was SACKed, deemed lost or
+ * retransmitted. The scoreboard gives the estimate of the bytes in the
+ * network (the pipe), the next segment to retransmit, and detects losses
+ * either with the duplicate threshold of \RFC{6675} or with the
+ * transmission times of RACK (\RFC{8985}). It is left empty, and costs
+ * nothing, on the connections without SACK.
  */
   
 template <typename NUMERIC_TYPE, typename SIGNED_TYPE>
 class TcpTxBuffer : public Object
 {
 public:
+  /// A SACK block: the first sequence number of the range and the one following it
+  typedef std::pair<SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>, SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> > SackBlock;
+  /// The SACK blocks of an ACK
+  typedef std::vector<SackBlock> SackList;
+
   /**
    * \brief Get the type ID.
    * \return the object TypeId
@@ -131,7 +160,202 @@ public:
    */
   void DiscardUpTo (const SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>& seq);
 
+  /**
+   * \brief Select the storage of the buffer, only possible while it is empty
+   * \param useRing true to use the ring of packets, false for the list
+   */
+  void SetUseRing (bool useRing);
+
+  /**
+   * \returns true if the buffer uses the ring of packets
+   */
+  bool GetUseRing (void) const;
+
+  /**
+   * \brief Only count the bytes added, possible while the buffer is empty
+   * \param virtualPayload true to drop the payload of the application packets
+   */
+  void SetVirtualPayload (bool virtualPayload);
+
+  /**
+   * \returns true if the buffer drops the payload of the application packets
+   */
+  bool GetVirtualPayload (void) const;
+
+  // Scoreboard
+
+  /**
+   * \brief Record the transmission of a segment in the scoreboard
+   *
+   * A segment above the ones recorded is new data. Otherwise the segments
+   * covering the range are retransmissions: they are split to the range if
+   * needed and marked as retransmitted.
+   *
+   * \param seq first sequence number of the segment
+   * \param size number of data bytes of the segment
+   * \param now time of the transmission
+   */
+  void RecordSent (const SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>& seq, uint32_t size, Time now);
+
+  /**
+   * \brief Update the scoreboard with an ACK
+   *
+   * Mark the segments covered by the SACK blocks, and follow the most
+   * recently sent segment among those delivered by this ACK, cumulatively
+   * acknowledged or SACKed, for RACK. A delivered segment which has been
+   * retransmitted is not followed if the delivery came less than \p minRtt
+   * after the retransmission: the ACK may be for the original transmission.
+   *
+   * \param ack cumulative acknowledgment of the ACK
+   * \param blocks SACK blocks of the ACK
+   * \param now time of reception of the ACK
+   * \param minRtt minimum RTT observed on the connection
+   * \returns the number of bytes newly SACKed
+   */
+  uint32_t UpdateScoreboard (const SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>& ack,
+                             const SackList& blocks, Time now, Time minRtt);
+
+  /**
+   * \brief Mark the segments lost as of \RFC{6675} IsLost ()
+   *
+   * A segment not SACKed is lost if dupThresh segments, or more than
+   * (dupThresh - 1) * segSize bytes, above it have been SACKed.
+   *
+   * \param dupThresh the duplicate threshold
+   * \param segSize the segment size
+   * \returns the number of bytes newly marked lost
+   */
+  uint32_t MarkLostByCount (uint32_t dupThresh, uint32_t segSize);
+
+  /**
+   * \brief Mark the segments lost by RACK (\RFC{8985} section 6.2)
+   *
+   * A segment not SACKed which was sent before the most recently sent
+   * segment delivered is lost once it has been in the network for the RTT
+   * of that delivery plus the reordering window.
+   *
+   * \param now the current time
+   * \param reoWnd the reordering window
+   * \param [out] timeout time left before the next segment may be marked
+   *               lost, zero if there is none
+   * \returns the number of bytes newly marked lost
+   */
+  uint32_t MarkLostByTime (Time now, Time reoWnd, Time& timeout);
+
+  /**
+   * \brief Mark all the segments not SACKed as lost, on a retransmission timeout
+   */
+  void MarkAllLost (void);
+
+  /**
+   * \brief Find the first segment to retransmit, \RFC{6675} NextSeg () rule 1
+   * \param [out] seq first sequence number of the segment
+   * \param [out] size size of the segment
+   * \returns true if a segment is lost and not retransmitted yet
+   */
+  bool NextLost (SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>& seq, uint32_t& size) const;
+
+  /**
+   * \brief Find the last segment sent, for a tail loss probe
+   * \param [out] seq first sequence number of the segment
+   * \param [out] size size of the segment
+   * \returns true if a segment is outstanding
+   */
+  bool LastSent (SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>& seq, uint32_t& size) const;
+
+  /**
+   * \returns the estimate of the bytes in the network (\RFC{6675} pipe):
+   *          bytes outstanding, less the bytes SACKed or lost, plus the
+   *          bytes retransmitted
+   */
+  uint32_t GetPipe (void) const;
+
+  /// \returns the number of bytes SACKed above the cumulative acknowledgment
+  uint32_t GetSacked (void) const;
+
+  /// \returns the number of bytes deemed lost and not SACKed
+  uint32_t GetLost (void) const;
+
+  /// \returns the number of bytes retransmitted and neither SACKed nor lost again
+  uint32_t GetRetransmitted (void) const;
+
+  /// \returns the RTT of the most recently sent segment delivered, for RACK
+  Time GetRackRtt (void) const;
+
+  /// \brief Forget the segments recorded and the RACK state
+  void ResetScoreboard (void);
+
 private:
+  /// Segment recorded in the scoreboard
+  struct SentSegment
+  {
+    SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> start; //!< First sequence number
+    uint32_t size;                                   //!< Number of data bytes
+    Time sent;                                       //!< Time of the last transmission
+    bool sacked;                                     //!< SACKed by the receiver
+    bool lost;                                       //!< Deemed lost, waiting for a retransmission
+    bool retrans;                                    //!< Retransmitted since it was deemed lost
+  };
+
+  /// Container of the segments recorded, in sequence order
+  typedef std::deque<SentSegment> SentList;
+
+  /**
+   * \brief Make a segment boundary at seq, splitting the segment holding it
+   * \param seq the sequence number
+   * \returns index of the first segment starting at or after seq
+   */
+  uint32_t SplitAt (const SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>& seq);
+
+  /**
+   * \brief Follow a delivered segment for RACK
+   * \param segment the delivered segment
+   * \param now time of the delivery
+   * \param minRtt minimum RTT observed on the connection
+   */
+  void RackDelivered (const SentSegment& segment, Time now, Time minRtt);
+
+  /**
+   * \brief Mark a segment lost, updating the counters
+   * \param segment the segment
+   */
+  void MarkLost (SentSegment& segment);
+
+  /**
+   * \brief Remove the scoreboard of the segments below seq
+   * \param seq the new head sequence number
+   */
+  void DiscardSentUpTo (const SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>& seq);
+
+  /// Application packet stored in the ring
+  struct Chunk
+  {
+    Ptr<Packet> packet; //!< Packet as added by the application
+    uint64_t end;       //!< Number of bytes added to the buffer up to the end of this packet
+  };
+
+  /**
+   * \brief Append a packet to the ring, growing it if needed
+   * \param p packet to append
+   */
+  void RingPush (Ptr<Packet> p);
+
+  /**
+   * \brief Find the chunk holding a byte
+   * \param byte offset of the byte, counted like Chunk::end
+   * \returns index of the chunk, relative to the ring head
+   */
+  uint32_t RingFind (uint64_t byte);
+
+  /// \returns the chunk at index i, relative to the ring head
+  Chunk& RingAt (uint32_t i);
+
+  /// CopyFromSequence with the ring storage
+  Ptr<Packet> RingCopyFromSequence (uint32_t numBytes, uint32_t offset);
+
+  /// DiscardUpTo with the ring storage
+  void RingDiscard (uint32_t numBytes);
+
   /// container for data stored in the buffer
   typedef std::list<Ptr<Packet> >::iterator BufIterator;
 
@@ -139,6 +363,24 @@ private:
   uint32_t m_size;                          //!< Number of data bytes
   uint32_t m_maxBuffer;                     //!< Max number of data bytes in buffer (SND.WND), for now possible max is ~4GB
   std::list<Ptr<Packet> > m_data;           //!< Corresponding data (may be null)
+
+  bool m_virtualPayload;                    //!< Don't store the packets, only their size
+  bool m_useRing;                           //!< Store the data in m_ring rather than m_data
+  std::vector<Chunk> m_ring;                //!< Ring of packets, its size is a power of two
+  uint32_t m_ringHead;                      //!< Index of the first chunk in m_ring
+  uint32_t m_ringCount;                     //!< Number of chunks in m_ring
+  uint32_t m_ringCursor;                    //!< Chunk of the last byte sent, relative to the ring head
+  uint64_t m_ringDiscarded;                 //!< Number of bytes discarded since the buffer creation
+
+  SentList m_sentList;                      //!< Scoreboard of the segments sent
+  uint32_t m_sentOut;                       //!< Bytes of the segments recorded
+  uint32_t m_sackedOut;                     //!< Bytes of the segments SACKed
+  uint32_t m_lostOut;                       //!< Bytes of the segments lost, not SACKed
+  uint32_t m_retransOut;                    //!< Bytes of the segments retransmitted, not SACKed
+  Time m_rackSent;                          //!< RACK.xmit_ts: transmission of the most recently sent segment delivered
+  SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> m_rackEnd; //!< RACK.end_seq: end of that segment
+  Time m_rackRtt;                           //!< RACK.rtt: RTT of that delivery
+  bool m_rackValid;                         //!< A delivery has been followed
 };
   
 
@@ -0,0 +1,177 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv6-interface.h"
+#include "../model/ipv4-end-point-demux.h"
+#include "../model/ipv4-end-point.h"
+#include "../model/ipv6-end-point-demux.h"
+#include "../model/ipv6-end-point.h"
+
+namespace ns3 {
+
+/**
+ * \brief Checks the match precedence of Ipv4EndPointDemux::Lookup and that
+ * end points are found again after their four-tuple changed
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  Ipv4EndPoint* LookupOne (Ipv4EndPointDemux& demux, Ipv4Address daddr, uint16_t dport,
+                           Ipv4Address saddr, uint16_t sport);
+
+  Ptr<Ipv4Interface> m_interface;
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("IPv4 end point demux lookup")
+{
+}
+
+Ipv4EndPoint*
+Ipv4EndPointDemuxTestCase::LookupOne (Ipv4EndPointDemux& demux, Ipv4Address daddr, uint16_t dport,
+                                      Ipv4Address saddr, uint16_t sport)
+{
+  Ipv4EndPointDemux::EndPoints endPoints = demux.Lookup (daddr, dport, saddr, sport, m_interface);
+  if (endPoints.size () != 1)
+    {
+      return 0;
+    }
+  return endPoints.front ();
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  m_interface = CreateObject<Ipv4Interface> ();
+  Ipv4EndPointDemux demux;
+  Ipv4Address local ("10.0.0.1");
+  Ipv4Address peer ("10.0.0.2");
+
+  Ipv4EndPoint* any = demux.Allocate (80);
+  NS_TEST_ASSERT_MSG_EQ (LookupOne (demux, local, 80, peer, 1000), any, "Only the listener matches");
+
+  Ipv4EndPoint* bound = demux.Allocate (local, 80);
+  NS_TEST_ASSERT_MSG_EQ (demux.Allocate (local, 80), 0, "Duplicate address/port");
+  NS_TEST_ASSERT_MSG_EQ (LookupOne (demux, local, 80, peer, 1000), bound, "Local address match preferred");
+
+  Ipv4EndPoint* remote = demux.Allocate (Ipv4Address::GetAny (), 80, peer, 1000);
+  NS_TEST_ASSERT_MSG_EQ (LookupOne (demux, local, 80, peer, 1000), remote, "Remote match preferred");
+
+  std::vector<Ipv4EndPoint*> connected;
+  for (uint16_t sport = 1000; sport < 1100; ++sport)
+    {
+      connected.push_back (demux.Allocate (local, 80, peer, sport));
+    }
+  NS_TEST_ASSERT_MSG_EQ (demux.Allocate (local, 80, peer, 1000), 0, "Duplicate four-tuple");
+  for (uint16_t sport = 1000; sport < 1100; ++sport)
+    {
+      NS_TEST_ASSERT_MSG_EQ (LookupOne (demux, local, 80, peer, sport), connected[sport - 1000], "Exact match");
+    }
+  NS_TEST_ASSERT_MSG_EQ (demux.SimpleLookup (local, 80, peer, 1050), connected[50], "Exact match");
+  NS_TEST_ASSERT_MSG_EQ (LookupOne (demux, local, 80, peer, 2000), bound, "No exact match");
+
+  // An end point set up after its allocation, as TCP does
+  Ipv4EndPoint* active = demux.Allocate ();
+  uint16_t port = active->GetLocalPort ();
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (port), true, "Ephemeral port is used");
+  active->SetLocalAddress (local);
+  active->SetPeer (peer, 80);
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupLocal (local, port), true, "Local address updated");
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupLocal (Ipv4Address::GetAny (), port), false, "Local address updated");
+  NS_TEST_ASSERT_MSG_EQ (LookupOne (demux, local, port, peer, 80), active, "Updated four-tuple");
+  NS_TEST_ASSERT_MSG_NE (demux.Allocate (), active, "Ephemeral port reused");
+
+  active->SetRxEnabled (false);
+  NS_TEST_ASSERT_MSG_EQ (demux.Lookup (local, port, peer, 80, m_interface).size (), 0, "Rx disabled");
+
+  demux.DeAllocate (connected[50]);
+  NS_TEST_ASSERT_MSG_EQ (LookupOne (demux, local, 80, peer, 1050), bound, "Deallocated end point");
+  demux.DeAllocate (bound);
+  NS_TEST_ASSERT_MSG_EQ (LookupOne (demux, local, 80, peer, 1050), any, "Deallocated end point");
+  demux.DeAllocate (remote);
+  demux.DeAllocate (any);
+  NS_TEST_ASSERT_MSG_EQ (demux.Lookup (local, 80, peer, 1050, m_interface).size (), 0, "No more listener");
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (80), true, "Connected end points remain");
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupLocal (Ipv4Address::GetAny (), 80), false, "Listener deallocated");
+  NS_TEST_ASSERT_MSG_EQ (demux.GetAllEndPoints ().size (), 101u, "Wrong number of end points");
+
+  m_interface = 0;
+}
+
+/**
+ * \brief Same checks as Ipv4EndPointDemuxTestCase, for IPv6
+ */
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("IPv6 end point demux lookup")
+{
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  Ptr<Ipv6Interface> interface = CreateObject<Ipv6Interface> ();
+  Ipv6EndPointDemux demux;
+  Ipv6Address local ("2001:1::1");
+  Ipv6Address peer ("2001:1::2");
+
+  Ipv6EndPoint* any = demux.Allocate (80);
+  Ipv6EndPoint* bound = demux.Allocate (local, 80);
+  Ipv6EndPoint* connected = demux.Allocate (local, 80, peer, 1000);
+  NS_TEST_ASSERT_MSG_EQ (demux.Allocate (local, 80, peer, 1000), 0, "Duplicate four-tuple");
+  NS_TEST_ASSERT_MSG_EQ (demux.Lookup (local, 80, peer, 1000, interface).front (), connected, "Exact match");
+  NS_TEST_ASSERT_MSG_EQ (demux.Lookup (local, 80, peer, 1001, interface).front (), bound, "Local address match");
+  NS_TEST_ASSERT_MSG_EQ (demux.Lookup (peer, 80, peer, 1001, interface).front (), any, "Only the port matches");
+
+  connected->SetLocalPort (81);
+  NS_TEST_ASSERT_MSG_EQ (demux.Lookup (local, 81, peer, 1000, interface).front (), connected, "Updated port");
+  NS_TEST_ASSERT_MSG_EQ (demux.SimpleLookup (local, 81, peer, 1000), connected, "Updated port");
+  NS_TEST_ASSERT_MSG_EQ (demux.Lookup (local, 80, peer, 1000, interface).front (), bound, "Updated port");
+
+  demux.DeAllocate (connected);
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (81), false, "Deallocated end point");
+  NS_TEST_ASSERT_MSG_EQ (demux.GetEndPoints ().size (), 2u, "Wrong number of end points");
+}
+
+static class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ()
+    : TestSuite ("end-point-demux", UNIT)
+  {
+    AddTestCase (new Ipv4EndPointDemuxTestCase (), TestCase::QUICK);
+    AddTestCase (new Ipv6EndPointDemuxTestCase (), TestCase::QUICK);
+  }
+
+} g_endPointDemuxTestSuite;
+
+} // namespace ns3
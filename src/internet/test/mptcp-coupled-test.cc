@@ -0,0 +1,200 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <map>
+#include "mptcp-general-test.h"
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/config.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/mptcp-meta-socket.h"
+#include "ns3/mptcp-subflow.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpCoupledTest");
+
+/**
+ * \brief Coupled congestion control aggregates over heterogeneous paths
+ *
+ * The meta socket maintains the sum of the windows, the sum of cwnd_i / rtt_i
+ * and the max of cwnd_i / rtt_i^2 as its subflows' windows and RTTs change.
+ * The test records the congestion windows, slow start thresholds and congestion
+ * states traced by the source subflows, and after each change compares the
+ * aggregates with a scan of the active subflows computing them from scratch.
+ */
+class MpTcpCoupledAggregatesTestCase : public MpTcpGeneralTest
+{
+public:
+  MpTcpCoupledAggregatesTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  virtual void ConfigureEnvironment (void);
+  virtual void ConfigureSource (Ptr<MpTcpMetaSocket> source);
+
+  void SourceSubflowAdded (Ptr<MpTcpSubflow> subflow, bool isMaster);
+  void CwndChanged (MpTcpSubflow *subflow, uint32_t oldValue, uint32_t newValue);
+  void SsThreshChanged (MpTcpSubflow *subflow, uint32_t oldValue, uint32_t newValue);
+  void CongStateChanged (MpTcpSubflow *subflow, TcpSocketState::TcpCongState_t oldValue,
+                         TcpSocketState::TcpCongState_t newValue);
+  void ScheduleCheck (void);
+  void CheckAggregates (void);
+
+  /// Window state traced by a subflow
+  struct SubflowTrace
+  {
+    uint32_t cwnd;
+    uint32_t ssThresh;
+    TcpSocketState::TcpCongState_t congState;
+  };
+  std::map<MpTcpSubflow *, SubflowTrace> m_traces;
+
+  uint32_t m_checks;
+  uint32_t m_checksWithBothPaths;
+  EventId m_checkEvent;
+};
+
+MpTcpCoupledAggregatesTestCase::MpTcpCoupledAggregatesTestCase ()
+  : MpTcpGeneralTest ("Coupled congestion control aggregates match a scan of the subflows")
+{
+}
+
+void
+MpTcpCoupledAggregatesTestCase::ConfigureEnvironment (void)
+{
+  // Enter congestion avoidance early so the coupled increase is exercised
+  Config::SetDefault ("ns3::TcpSocket::InitialSlowStartThreshold", UintegerValue (8 * 1400));
+}
+
+void
+MpTcpCoupledAggregatesTestCase::ConfigureSource (Ptr<MpTcpMetaSocket> source)
+{
+  // The master subflow is created along with the meta socket
+  SourceSubflowAdded (source->GetSubflow (0), true);
+  source->SetSubflowAddedCallback (MakeCallback (&MpTcpCoupledAggregatesTestCase::SourceSubflowAdded, this));
+}
+
+void
+MpTcpCoupledAggregatesTestCase::SourceSubflowAdded (Ptr<MpTcpSubflow> subflow, bool isMaster)
+{
+  MpTcpSubflow *sf = PeekPointer (subflow);
+  SubflowTrace trace = { 0, 0, TcpSocketState::CA_OPEN };
+  m_traces[sf] = trace;
+  subflow->TraceConnectWithoutContext ("CongestionWindow",
+                                       MakeCallback (&MpTcpCoupledAggregatesTestCase::CwndChanged, this).Bind (sf));
+  subflow->TraceConnectWithoutContext ("SlowStartThreshold",
+                                       MakeCallback (&MpTcpCoupledAggregatesTestCase::SsThreshChanged, this).Bind (sf));
+  subflow->TraceConnectWithoutContext ("CongState",
+                                       MakeCallback (&MpTcpCoupledAggregatesTestCase::CongStateChanged, this).Bind (sf));
+}
+
+void
+MpTcpCoupledAggregatesTestCase::CwndChanged (MpTcpSubflow *subflow, uint32_t oldValue, uint32_t newValue)
+{
+  m_traces[subflow].cwnd = newValue;
+  ScheduleCheck ();
+}
+
+void
+MpTcpCoupledAggregatesTestCase::SsThreshChanged (MpTcpSubflow *subflow, uint32_t oldValue, uint32_t newValue)
+{
+  m_traces[subflow].ssThresh = newValue;
+  ScheduleCheck ();
+}
+
+void
+MpTcpCoupledAggregatesTestCase::CongStateChanged (MpTcpSubflow *subflow, TcpSocketState::TcpCongState_t oldValue,
+                                                  TcpSocketState::TcpCongState_t newValue)
+{
+  m_traces[subflow].congState = newValue;
+  ScheduleCheck ();
+}
+
+void
+MpTcpCoupledAggregatesTestCase::ScheduleCheck (void)
+{
+  // The socket traces fire before the meta socket is notified, compare once the event is over
+  if (!m_checkEvent.IsRunning ())
+    {
+      m_checkEvent = Simulator::ScheduleNow (&MpTcpCoupledAggregatesTestCase::CheckAggregates, this);
+    }
+}
+
+void
+MpTcpCoupledAggregatesTestCase::CheckAggregates (void)
+{
+  uint32_t totalCwnd = 0;
+  double sumi = 0;
+  double maxi = 0;
+  for (uint32_t i = 0; i < m_source->GetNActiveSubflows (); ++i)
+    {
+      Ptr<MpTcpSubflow> sf = m_source->GetActiveSubflow (i);
+      const SubflowTrace &trace = m_traces[PeekPointer (sf)];
+      totalCwnd += (trace.congState == TcpSocketState::CA_RECOVERY) ? trace.ssThresh : trace.cwnd;
+      double rtt = sf->GetRttEstimator ()->GetEstimate ().GetSeconds ();
+      if (rtt > 0)
+        {
+          sumi += trace.cwnd / rtt;
+          maxi = std::max (maxi, trace.cwnd / (rtt * rtt));
+        }
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (m_source->GetTotalCwnd (), totalCwnd, "Total window differs from the scan");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_source->GetSumCwndOverRtt (), sumi, sumi * 1e-9, "Sum of cwnd/rtt differs from the scan");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_source->GetMaxCwndOverRtt2 (), maxi, maxi * 1e-9, "Max of cwnd/rtt^2 differs from the scan");
+  m_checks++;
+  if (m_source->GetNActiveSubflows () == 2)
+    {
+      m_checksWithBothPaths++;
+    }
+}
+
+void
+MpTcpCoupledAggregatesTestCase::DoRun (void)
+{
+  m_checks = 0;
+  m_checksWithBothPaths = 0;
+
+  RunTransfer ();
+
+  NS_LOG_INFO (GetName () << ": " << m_checks << " checks, " << m_checksWithBothPaths << " with both paths");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBytes, m_totalBytes, "Server received all bytes");
+  NS_TEST_EXPECT_MSG_GT (m_checksWithBothPaths, 0, "Aggregates never checked with both paths active");
+}
+
+void
+MpTcpCoupledAggregatesTestCase::DoTeardown (void)
+{
+  m_traces.clear ();
+  MpTcpGeneralTest::DoTeardown ();
+}
+
+static class MpTcpCoupledTestSuite : public TestSuite
+{
+public:
+  MpTcpCoupledTestSuite ()
+    : TestSuite ("mptcp-coupled", SYSTEM)
+  {
+    AddTestCase (new MpTcpCoupledAggregatesTestCase (), TestCase::QUICK);
+  }
+
+} g_mptcpCoupledTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,325 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include "mptcp-general-test.h"
+#include "ns3/test.h"
+#include "ns3/core-module.h"
+#include "ns3/mptcp-crypto.h"
+#include "ns3/mptcp-subflow.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-option-mptcp.h"
+#include "ns3/error-model.h"
+#include "ns3/simple-net-device.h"
+
+namespace ns3 {
+
+static std::string
+ToHex (const uint8_t* digest)
+{
+  std::ostringstream oss;
+  for (uint32_t i = 0; i < MpTcpSha1::DIGEST_SIZE; ++i)
+    {
+      oss << std::hex << std::setw (2) << std::setfill ('0') << uint32_t (digest[i]);
+    }
+  return oss.str ();
+}
+
+/**
+ * \brief Checks SHA-1 and HMAC-SHA1 against the FIPS 180 and RFC 2202 vectors
+ */
+class MpTcpSha1TestCase : public TestCase
+{
+public:
+  MpTcpSha1TestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  std::string Sha1 (const std::string& message, uint32_t chunk) const;
+  std::string Hmac (const std::string& key, const std::string& message) const;
+};
+
+MpTcpSha1TestCase::MpTcpSha1TestCase ()
+  : TestCase ("SHA-1 and HMAC-SHA1 known answers")
+{
+}
+
+std::string
+MpTcpSha1TestCase::Sha1 (const std::string& message, uint32_t chunk) const
+{
+  MpTcpSha1 sha;
+  const uint8_t* data = reinterpret_cast<const uint8_t*> (message.data ());
+  for (uint32_t i = 0; i < message.size (); i += chunk)
+    {
+      sha.Update (data + i, std::min<uint32_t> (chunk, message.size () - i));
+    }
+  uint8_t digest[MpTcpSha1::DIGEST_SIZE];
+  sha.Final (digest);
+  return ToHex (digest);
+}
+
+std::string
+MpTcpSha1TestCase::Hmac (const std::string& key, const std::string& message) const
+{
+  uint8_t digest[MpTcpSha1::DIGEST_SIZE];
+  ComputeHmacSha1 (reinterpret_cast<const uint8_t*> (key.data ()), key.size (),
+                   reinterpret_cast<const uint8_t*> (message.data ()), message.size (),
+                   digest);
+  return ToHex (digest);
+}
+
+void
+MpTcpSha1TestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (Sha1 ("", 1), "da39a3ee5e6b4b0d3255bfef95601890afd80709", "Empty message");
+  NS_TEST_ASSERT_MSG_EQ (Sha1 ("abc", 1), "a9993e364706816aba3e25717850c26c9cd0d89d", "One block");
+
+  // 56 bytes: the length no longer fits in the first block
+  std::string twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+  for (uint32_t chunk = 1; chunk <= 64; chunk *= 3)
+    {
+      NS_TEST_ASSERT_MSG_EQ (Sha1 (twoBlocks, chunk), "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+                             "Digest should not depend on how the message is split, chunk=" << chunk);
+    }
+  NS_TEST_ASSERT_MSG_EQ (Sha1 (std::string (1000000, 'a'), 1000), "34aa973cd4c4daa4f61eeb2bdbad27316534016f",
+                         "One million 'a'");
+
+  NS_TEST_ASSERT_MSG_EQ (Hmac (std::string (20, '\x0b'), "Hi There"),
+                         "b617318655057264e28bc0b6fb378c8ef146be00", "RFC 2202 test case 1");
+  NS_TEST_ASSERT_MSG_EQ (Hmac ("Jefe", "what do ya want for nothing?"),
+                         "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79", "RFC 2202 test case 2");
+  NS_TEST_ASSERT_MSG_EQ (Hmac (std::string (80, '\xaa'), "Test Using Larger Than Block-Size Key - Hash Key First"),
+                         "aa4ae5e15272d00e95705637ce8a3b55ed402112", "RFC 2202 test case 6");
+}
+
+/**
+ * \brief Checks the token, IDSN and MP_JOIN HMAC derived from the keys, and the key pool
+ */
+class MpTcpKeyTestCase : public TestCase
+{
+public:
+  MpTcpKeyTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MpTcpKeyTestCase::MpTcpKeyTestCase ()
+  : TestCase ("MPTCP token, IDSN, join HMAC and key pool")
+{
+}
+
+void
+MpTcpKeyTestCase::DoRun (void)
+{
+  uint32_t token;
+  uint64_t idsn;
+  GenerateTokenForKey (HMAC_SHA1, 0x0123456789abcdefULL, token, idsn);
+  NS_TEST_ASSERT_MSG_EQ (token, 0x0ca2eadbU, "Token is the leftmost 32 bits of SHA1(key)");
+  NS_TEST_ASSERT_MSG_EQ (idsn, 0xe3df8ee121f10547ULL, "IDSN is the rightmost 64 bits of SHA1(key)");
+
+  uint8_t hmac[MpTcpSha1::DIGEST_SIZE];
+  GenerateJoinHmac (1, 2, 3, 4, hmac);
+  NS_TEST_ASSERT_MSG_EQ (ToHex (hmac), "3e9d3c463abd55f71a0858f079f8bae4b5599f26", "Join HMAC");
+  NS_TEST_ASSERT_MSG_EQ (GenerateTruncatedJoinHmac (1, 2, 3, 4), 0x3e9d3c463abd55f7ULL,
+                         "Truncated join HMAC is the leftmost 64 bits");
+
+  const uint32_t batch = 16;
+  Ptr<MpTcpKeyPool> pool = Create<MpTcpKeyPool> (batch);
+  NS_TEST_ASSERT_MSG_EQ (pool->GetNAvailable (), batch, "Pool should be filled at construction");
+  for (uint32_t i = 0; i < 3 * batch; ++i)
+    {
+      uint64_t key;
+      uint32_t poolToken;
+      uint64_t poolIdsn;
+      pool->Draw (key, poolToken, poolIdsn);
+      NS_TEST_ASSERT_MSG_NE (key, 0, "Key 0 should never be drawn");
+      GenerateTokenForKey (HMAC_SHA1, key, token, idsn);
+      NS_TEST_ASSERT_MSG_EQ (poolToken, token, "Pool token does not match its key");
+      NS_TEST_ASSERT_MSG_EQ (poolIdsn, idsn, "Pool IDSN does not match its key");
+      NS_TEST_ASSERT_MSG_EQ (pool->GetNAvailable (), batch - 1 - (i % batch), "Wrong number of keys left");
+    }
+}
+
+/**
+ * \brief Flips a bit of the truncated HMAC in the MP_JOIN of the SYN/ACKs it sees
+ *
+ * The packets are read as an IPv4 header without options followed by the TCP
+ * header. None is dropped.
+ */
+class MpTcpJoinHmacCorrupter : public ErrorModel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MpTcpJoinHmacCorrupter ();
+
+  /**
+   * \return Number of SYN/ACKs whose HMAC was changed
+   */
+  uint32_t GetNCorrupted (void) const;
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+
+  uint32_t m_corrupted;
+};
+
+TypeId
+MpTcpJoinHmacCorrupter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpJoinHmacCorrupter")
+    .SetParent<ErrorModel> ()
+    .AddConstructor<MpTcpJoinHmacCorrupter> ()
+  ;
+  return tid;
+}
+
+MpTcpJoinHmacCorrupter::MpTcpJoinHmacCorrupter ()
+  : m_corrupted (0)
+{
+}
+
+uint32_t
+MpTcpJoinHmacCorrupter::GetNCorrupted (void) const
+{
+  return m_corrupted;
+}
+
+bool
+MpTcpJoinHmacCorrupter::DoCorrupt (Ptr<Packet> p)
+{
+  const uint32_t ipLength = 20;
+  uint32_t size = p->GetSize ();
+  if (size < ipLength + 20)
+    {
+      return false;
+    }
+  std::vector<uint8_t> bytes (size);
+  p->CopyData (&bytes[0], size);
+  uint8_t *tcp = &bytes[ipLength];
+  if (bytes[9] != 6 || (tcp[13] & (TcpHeader::SYN | TcpHeader::ACK)) != (TcpHeader::SYN | TcpHeader::ACK))
+    {
+      return false;
+    }
+
+  uint32_t tcpLength = (tcp[12] >> 4) * 4;
+  uint32_t i = 20;
+  while (i + 2 < tcpLength && tcp[i] != TcpOption::END)
+    {
+      if (tcp[i] == TcpOption::NOP)
+        {
+          i++;
+          continue;
+        }
+      if (tcp[i] == TcpOption::MPTCP && (tcp[i + 2] >> 4) == TcpOptionMpTcpMain::MP_JOIN)
+        {
+          // Kind, length, subtype and address id come before the HMAC
+          tcp[i + 4] ^= 0x01;
+          p->RemoveAtEnd (size);
+          p->AddAtEnd (Create<Packet> (&bytes[0], size));
+          m_corrupted++;
+          return false;
+        }
+      i += tcp[i + 1];
+    }
+  return false;
+}
+
+void
+MpTcpJoinHmacCorrupter::DoReset (void)
+{
+}
+
+/**
+ * \brief A subflow whose SYN/ACK carries a wrong MP_JOIN HMAC is reset
+ *
+ * The HMAC of the SYN/ACKs received by the source on the second path is
+ * changed. The source should reset the second subflow (RFC 6824 section 3.2),
+ * so that neither end establishes it, and the transfer goes through the
+ * master subflow.
+ */
+class MpTcpJoinHmacTestCase : public MpTcpGeneralTest
+{
+public:
+  MpTcpJoinHmacTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  virtual void ConfigureSource (Ptr<MpTcpMetaSocket> source);
+
+  Ptr<MpTcpJoinHmacCorrupter> m_corrupter;
+};
+
+MpTcpJoinHmacTestCase::MpTcpJoinHmacTestCase ()
+  : MpTcpGeneralTest ("MP_JOIN with a wrong HMAC resets the subflow")
+{
+}
+
+void
+MpTcpJoinHmacTestCase::ConfigureSource (Ptr<MpTcpMetaSocket> source)
+{
+  // The devices of the paths are installed before the loopback
+  m_corrupter = CreateObject<MpTcpJoinHmacCorrupter> ();
+  Ptr<SimpleNetDevice> secondPath = DynamicCast<SimpleNetDevice> (source->GetNode ()->GetDevice (1));
+  NS_ASSERT (secondPath);
+  secondPath->SetReceiveErrorModel (m_corrupter);
+}
+
+void
+MpTcpJoinHmacTestCase::DoRun (void)
+{
+  RunTransfer ();
+
+  NS_TEST_ASSERT_MSG_GT (m_corrupter->GetNCorrupted (), 0, "No MP_JOIN SYN/ACK was received on the second path");
+  NS_TEST_ASSERT_MSG_EQ (m_source->GetNSubflows (), 2, "The source should have opened a second subflow");
+  NS_TEST_ASSERT_MSG_EQ (m_source->GetSubflow (1)->GetState (), TcpSocket::CLOSED,
+                         "The source should have reset the second subflow");
+  NS_TEST_ASSERT_MSG_EQ (m_source->GetNActiveSubflows (), 1, "The source should only use the master subflow");
+  NS_TEST_ASSERT_MSG_NE (m_server, 0, "The connection should have been accepted");
+  NS_TEST_ASSERT_MSG_EQ (m_server->GetNActiveSubflows (), 1, "The server should not establish the second subflow");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBytes, m_totalBytes, "The transfer should complete on the master subflow");
+  NS_TEST_ASSERT_MSG_EQ (m_rxContentOk, true, "Received data differs from the data sent");
+}
+
+void
+MpTcpJoinHmacTestCase::DoTeardown (void)
+{
+  m_corrupter = 0;
+  MpTcpGeneralTest::DoTeardown ();
+}
+
+static class MpTcpCryptoTestSuite : public TestSuite
+{
+public:
+  MpTcpCryptoTestSuite ()
+    : TestSuite ("mptcp-crypto", UNIT)
+  {
+    AddTestCase (new MpTcpSha1TestCase (), TestCase::QUICK);
+    AddTestCase (new MpTcpKeyTestCase (), TestCase::QUICK);
+    AddTestCase (new MpTcpJoinHmacTestCase (), TestCase::QUICK);
+  }
+
+} g_mpTcpCryptoTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,203 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <vector>
+#include "mptcp-general-test.h"
+#include "ns3/log.h"
+#include "ns3/config.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/mptcp-socket-factory.h"
+#include "ns3/mptcp-subflow.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpGeneralTest");
+
+MpTcpGeneralTest::MpTcpGeneralTest (const std::string &desc)
+  : TestCase (desc),
+    m_firstPathRate ("10Mbps"),
+    m_firstPathDelay (MilliSeconds (10)),
+    m_secondPathRate ("2Mbps"),
+    m_secondPathDelay (MilliSeconds (50)),
+    m_totalBytes (1000000),
+    m_writeSize (1400),
+    m_txBytes (0),
+    m_rxBytes (0),
+    m_rxContentOk (true)
+{
+}
+
+uint8_t
+MpTcpGeneralTest::PayloadByte (uint32_t offset)
+{
+  return static_cast<uint8_t> (offset % 251);
+}
+
+void
+MpTcpGeneralTest::ConfigureEnvironment (void)
+{
+}
+
+void
+MpTcpGeneralTest::ConfigureSource (Ptr<MpTcpMetaSocket> source)
+{
+}
+
+void
+MpTcpGeneralTest::DataWritten (void)
+{
+}
+
+void
+MpTcpGeneralTest::DataDelivered (void)
+{
+}
+
+NetDeviceContainer
+MpTcpGeneralTest::AddLink (NodeContainer nodes, std::string rate, Time delay)
+{
+  SimpleNetDeviceHelper link;
+  link.SetNetDevicePointToPointMode (true);
+  link.SetDeviceAttribute ("DataRate", StringValue (rate));
+  link.SetChannelAttribute ("Delay", TimeValue (delay));
+  return link.Install (nodes);
+}
+
+void
+MpTcpGeneralTest::SourceConnect (void)
+{
+  m_source->Bind ();
+  m_source->Connect (InetSocketAddress (Ipv4Address ("10.1.1.2"), 50000));
+}
+
+void
+MpTcpGeneralTest::SourceFullyEstablished (Ptr<MpTcpMetaSocket> meta)
+{
+  meta->ConnectNewSubflow (InetSocketAddress (Ipv4Address ("10.1.2.1"), 0),
+                           InetSocketAddress (Ipv4Address ("10.1.2.2"), 50000));
+}
+
+void
+MpTcpGeneralTest::SourceHandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  if (m_txBytes == 0)
+    {
+      m_firstWrite = Simulator::Now ();
+    }
+  while (sock->GetTxAvailable () >= m_writeSize && m_txBytes < m_totalBytes)
+    {
+      uint32_t toSend = std::min (m_writeSize, m_totalBytes - m_txBytes);
+      std::vector<uint8_t> data (toSend);
+      for (uint32_t i = 0; i < toSend; ++i)
+        {
+          data[i] = PayloadByte (m_txBytes + i);
+        }
+      int sent = sock->Send (Create<Packet> (&data[0], toSend));
+      NS_TEST_EXPECT_MSG_EQ ((sent != -1), true, "Error during send ?");
+      m_txBytes += sent;
+      DataWritten ();
+    }
+}
+
+void
+MpTcpGeneralTest::ServerHandleConnectionCreated (Ptr<Socket> s, const Address & addr)
+{
+  m_server = DynamicCast<MpTcpMetaSocket> (s);
+  NS_TEST_EXPECT_MSG_NE (m_server, 0, "Accepted socket should be a meta socket");
+  s->SetRecvCallback (MakeCallback (&MpTcpGeneralTest::ServerHandleRecv, this));
+}
+
+void
+MpTcpGeneralTest::ServerHandleRecv (Ptr<Socket> sock)
+{
+  while (sock->GetRxAvailable () > 0)
+    {
+      Ptr<Packet> p = sock->Recv ();
+      std::vector<uint8_t> data (p->GetSize ());
+      p->CopyData (&data[0], data.size ());
+      for (uint32_t i = 0; i < data.size (); ++i)
+        {
+          m_rxContentOk = m_rxContentOk && (data[i] == PayloadByte (m_rxBytes + i));
+        }
+      m_rxBytes += p->GetSize ();
+    }
+  m_completion = Simulator::Now ();
+  DataDelivered ();
+}
+
+void
+MpTcpGeneralTest::RunTransfer (void)
+{
+  m_txBytes = 0;
+  m_rxBytes = 0;
+  m_rxContentOk = true;
+  m_firstWrite = Seconds (0);
+  m_completion = Seconds (0);
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1400));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (65535));
+  Config::SetDefault ("ns3::TcpSocketImpl::Timestamp", BooleanValue (false));
+  ConfigureEnvironment ();
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  NetDeviceContainer firstPath = AddLink (nodes, m_firstPathRate, m_firstPathDelay);
+  NetDeviceContainer secondPath = AddLink (nodes, m_secondPathRate, m_secondPathDelay);
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (firstPath);
+  address.SetBase ("10.1.2.0", "255.255.255.0");
+  address.Assign (secondPath);
+
+  Ptr<Socket> listening = nodes.Get (1)->GetObject<MpTcpSocketFactory> ()->CreateSocket ();
+  listening->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  listening->Listen ();
+  listening->SetAcceptCallback (MakeNullCallback<bool, Ptr< Socket >, const Address &> (),
+                                MakeCallback (&MpTcpGeneralTest::ServerHandleConnectionCreated, this));
+
+  m_source = DynamicCast<MpTcpMetaSocket> (nodes.Get (0)->GetObject<MpTcpSocketFactory> ()->CreateSocket ());
+  NS_ASSERT_MSG (m_source, "MPTCP socket factory should create meta sockets");
+  m_source->SetFullyEstablishedCallback (MakeCallback (&MpTcpGeneralTest::SourceFullyEstablished, this));
+  m_source->SetSendCallback (MakeCallback (&MpTcpGeneralTest::SourceHandleSend, this));
+  ConfigureSource (m_source);
+  // The queue discs of the devices are only set up once the nodes are initialized
+  Simulator::Schedule (MilliSeconds (1), &MpTcpGeneralTest::SourceConnect, this);
+
+  Simulator::Stop (Seconds (30));
+  Simulator::Run ();
+}
+
+void
+MpTcpGeneralTest::DoTeardown (void)
+{
+  m_source = 0;
+  m_server = 0;
+  Simulator::Destroy ();
+  Config::Reset ();
+}
+
+} // namespace ns3
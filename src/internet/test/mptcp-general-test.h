@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef MPTCPGENERALTEST_H
+#define MPTCPGENERALTEST_H
+
+#include "ns3/test.h"
+#include "ns3/nstime.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/mptcp-meta-socket.h"
+
+namespace ns3 {
+
+/**
+ * \brief Bulk transfer over two paths between two MPTCP nodes
+ *
+ * The source connects its master subflow over the first path (10.1.1.0/24)
+ * and, once the connection is fully established, a second subflow over the
+ * second path (10.1.2.0/24). It then writes m_totalBytes, m_writeSize bytes
+ * at a time, whose content the server checks as it reads them.
+ *
+ * Subclasses set the attributes of the transfer in ConfigureEnvironment, hook
+ * their traces onto the source in ConfigureSource, call RunTransfer from
+ * their DoRun and check the counters of the transfer once it returns.
+ * RunTransfer may run several transfers in a row, as long as DoTeardown is
+ * called in between.
+ */
+class MpTcpGeneralTest : public TestCase
+{
+public:
+  /**
+   * \param desc description of the test
+   */
+  MpTcpGeneralTest (const std::string &desc);
+
+protected:
+  virtual void DoTeardown (void);
+
+  /**
+   * \brief Set the attributes of the transfer
+   *
+   * Called by RunTransfer after it set the defaults of the transfer:
+   * 1400 bytes segments, a 65535 bytes receive buffer and no timestamps.
+   */
+  virtual void ConfigureEnvironment (void);
+
+  /**
+   * \brief Hook the traces and events of a test onto the source
+   *
+   * Called once the source socket is created, before it connects.
+   */
+  virtual void ConfigureSource (Ptr<MpTcpMetaSocket> source);
+
+  /**
+   * \brief Called after each write of the source application
+   */
+  virtual void DataWritten (void);
+
+  /**
+   * \brief Called after the server application read the data available
+   */
+  virtual void DataDelivered (void);
+
+  /**
+   * \brief Run the transfer until all the bytes are read or 30 seconds elapsed
+   */
+  void RunTransfer (void);
+
+  /**
+   * \return The payload byte at offset in the transfer
+   */
+  static uint8_t PayloadByte (uint32_t offset);
+
+  std::string m_firstPathRate;   //!< Rate of the first path
+  Time m_firstPathDelay;         //!< One way delay of the first path
+  std::string m_secondPathRate;  //!< Rate of the second path
+  Time m_secondPathDelay;        //!< One way delay of the second path
+  uint32_t m_totalBytes;         //!< Bytes to transfer
+  uint32_t m_writeSize;          //!< Bytes per write of the source application
+
+  uint32_t m_txBytes;            //!< Bytes written by the source application
+  uint32_t m_rxBytes;            //!< Bytes read by the server application
+  bool m_rxContentOk;            //!< Whether the bytes read so far are those written
+  Time m_firstWrite;             //!< Time of the first write
+  Time m_completion;             //!< Time of the last read
+  Ptr<MpTcpMetaSocket> m_source; //!< Source meta socket
+  Ptr<MpTcpMetaSocket> m_server; //!< Meta socket accepted by the server
+
+private:
+  NetDeviceContainer AddLink (NodeContainer nodes, std::string rate, Time delay);
+  void SourceConnect (void);
+  void SourceFullyEstablished (Ptr<MpTcpMetaSocket> meta);
+  void SourceHandleSend (Ptr<Socket> sock, uint32_t available);
+  void ServerHandleConnectionCreated (Ptr<Socket> s, const Address & addr);
+  void ServerHandleRecv (Ptr<Socket> sock);
+};
+
+} // namespace ns3
+
+#endif /* MPTCPGENERALTEST_H */
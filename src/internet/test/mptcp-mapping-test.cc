@@ -0,0 +1,281 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of Sussex
+ * Copyright (c) 2015 Université Pierre et Marie Curie (UPMC)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/core-module.h"
+#include "ns3/mptcp-mapping.h"
+
+namespace ns3 {
+
+/**
+ * \brief Checks a mapping container backend against hand computed results
+ */
+class MpTcpMappingContainerTestCase : public TestCase
+{
+public:
+  MpTcpMappingContainerTestCase (TypeId containerTypeId);
+
+private:
+  virtual void DoRun (void);
+
+  void TestLookup (void);
+  void TestDiscard (void);
+  void TestOutOfOrder (void);
+  void TestPartlyAcked (void);
+
+  Ptr<MpTcpMappingContainer> CreateContainer (void) const;
+
+  TypeId m_containerTypeId;
+};
+
+MpTcpMappingContainerTestCase::MpTcpMappingContainerTestCase (TypeId containerTypeId)
+  : TestCase ("Mapping container " + containerTypeId.GetName ()),
+    m_containerTypeId (containerTypeId)
+{
+}
+
+Ptr<MpTcpMappingContainer>
+MpTcpMappingContainerTestCase::CreateContainer (void) const
+{
+  ObjectFactory factory;
+  factory.SetTypeId (m_containerTypeId);
+  return factory.Create<MpTcpMappingContainer> ();
+}
+
+void
+MpTcpMappingContainerTestCase::DoRun (void)
+{
+  TestLookup ();
+  TestDiscard ();
+  TestOutOfOrder ();
+  TestPartlyAcked ();
+}
+
+void
+MpTcpMappingContainerTestCase::TestLookup (void)
+{
+  Ptr<MpTcpMappingContainer> c = CreateContainer ();
+  MpTcpMapping mapping;
+  SequenceNumber32 ssn;
+
+  NS_TEST_ASSERT_MSG_EQ (c->FirstUnmappedSSN (ssn), false, "Empty container has no mapping");
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingForSSN (SequenceNumber32 (1), mapping), false, "Empty container has no mapping");
+
+  // 100 contiguous mappings of 1000 bytes, enough to grow the ring a few times
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (c->AddMapping (SequenceNumber64 (5000 + i * 1000), SequenceNumber32 (1 + i * 1000), 1000),
+                             true, "Could not add mapping");
+    }
+  NS_TEST_ASSERT_MSG_EQ (c->AddMapping (SequenceNumber64 (0), SequenceNumber32 (1001), 10), false,
+                         "Mappings starting at the same SSN are duplicates");
+  NS_TEST_ASSERT_MSG_EQ (c->GetNMappings (), 100u, "Wrong number of mappings");
+
+  NS_TEST_ASSERT_MSG_EQ (c->FirstUnmappedSSN (ssn), true, "Container is not empty");
+  NS_TEST_ASSERT_MSG_EQ (ssn, SequenceNumber32 (100001), "Wrong first unmapped SSN");
+
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingForSSN (SequenceNumber32 (0), mapping), false, "SSN before first mapping");
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingForSSN (SequenceNumber32 (100001), mapping), false, "SSN after last mapping");
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingForSSN (SequenceNumber32 (42500), mapping), true, "SSN should be mapped");
+  NS_TEST_ASSERT_MSG_EQ (mapping.HeadSSN (), SequenceNumber32 (42001), "Wrong mapping");
+  NS_TEST_ASSERT_MSG_EQ (mapping.GetDSNFromSSN (SequenceNumber32 (42500)), SequenceNumber64 (47499), "Wrong DSN");
+
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingForDSN (SequenceNumber64 (47499), mapping), true, "DSN should be mapped");
+  NS_TEST_ASSERT_MSG_EQ (mapping.HeadSSN (), SequenceNumber32 (42001), "Wrong mapping");
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingForDSN (SequenceNumber64 (4999), mapping), false, "DSN before first mapping");
+
+  std::vector<MpTcpMapping> mappings;
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingsStartingFromSSN (SequenceNumber32 (97001), mappings), true, "Should find mappings");
+  NS_TEST_ASSERT_MSG_EQ (mappings.size (), 3u, "Wrong number of mappings");
+  NS_TEST_ASSERT_MSG_EQ (mappings[0].HeadSSN (), SequenceNumber32 (97001), "Mappings not sorted");
+  NS_TEST_ASSERT_MSG_EQ (mappings[2].HeadSSN (), SequenceNumber32 (100001 - 1000), "Mappings not sorted");
+}
+
+void
+MpTcpMappingContainerTestCase::TestDiscard (void)
+{
+  Ptr<MpTcpMappingContainer> c = CreateContainer ();
+  MpTcpMapping mapping;
+
+  // Slide a window of 10 mappings over 1000 mappings: the ring wraps around
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      c->AddMapping (SequenceNumber64 (i * 100), SequenceNumber32 (i * 100), 100);
+      if (i >= 10)
+        {
+          c->DiscardMappingsInSSNRange (SequenceNumber32 ((i - 10) * 100), 100);
+        }
+      NS_TEST_ASSERT_MSG_EQ (c->GetNMappings (), std::min (i + 1, 10u), "Head mapping not discarded");
+    }
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingForSSN (SequenceNumber32 (98999), mapping), false, "Mapping was discarded");
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingForSSN (SequenceNumber32 (99050), mapping), true, "Mapping still in window");
+  NS_TEST_ASSERT_MSG_EQ (mapping.HeadSSN (), SequenceNumber32 (99000), "Wrong mapping");
+
+  // A range that only partially covers the last mapping keeps it
+  c->DiscardMappingsInSSNRange (SequenceNumber32 (99000), 450);
+  NS_TEST_ASSERT_MSG_EQ (c->GetNMappings (), 6u, "Only fully covered mappings are discarded");
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingForSSN (SequenceNumber32 (99400), mapping), true, "Mapping partially covered");
+
+  c->DiscardMappingsInSSNRange (SequenceNumber32 (99400), 600);
+  NS_TEST_ASSERT_MSG_EQ (c->GetNMappings (), 0u, "All mappings discarded");
+}
+
+void
+MpTcpMappingContainerTestCase::TestOutOfOrder (void)
+{
+  Ptr<MpTcpMappingContainer> c = CreateContainer ();
+  MpTcpMapping mapping;
+
+  // Mappings received out of order, with the 5th one reinjected from another subflow
+  uint32_t order[] = { 3, 0, 7, 1, 5, 2, 6, 4 };
+  for (uint32_t i = 0; i < 8; ++i)
+    {
+      uint32_t n = order[i];
+      uint64_t dsn = (n == 5) ? 100 : 1000 + n * 10;
+      NS_TEST_ASSERT_MSG_EQ (c->AddMapping (SequenceNumber64 (dsn), SequenceNumber32 (n * 10), 10), true,
+                             "Could not add mapping");
+    }
+
+  for (uint32_t n = 0; n < 8; ++n)
+    {
+      NS_TEST_ASSERT_MSG_EQ (c->GetMappingForSSN (SequenceNumber32 (n * 10 + 9), mapping), true, "SSN should be mapped");
+      NS_TEST_ASSERT_MSG_EQ (mapping.HeadSSN (), SequenceNumber32 (n * 10), "Wrong mapping");
+    }
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingForDSN (SequenceNumber64 (105), mapping), true, "Reinjected DSN should be mapped");
+  NS_TEST_ASSERT_MSG_EQ (mapping.HeadSSN (), SequenceNumber32 (50), "Wrong mapping");
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingForDSN (SequenceNumber64 (1075), mapping), true, "DSN should be mapped");
+  NS_TEST_ASSERT_MSG_EQ (mapping.HeadSSN (), SequenceNumber32 (70), "Wrong mapping");
+
+  // Remove a mapping in the middle then the head
+  c->DiscardMappingsInSSNRange (SequenceNumber32 (40), 10);
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingForSSN (SequenceNumber32 (45), mapping), false, "Mapping was discarded");
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingForSSN (SequenceNumber32 (55), mapping), true, "Mapping should remain");
+  c->DiscardMappingsInSSNRange (SequenceNumber32 (0), 40);
+  NS_TEST_ASSERT_MSG_EQ (c->GetNMappings (), 3u, "Wrong number of mappings");
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingForSSN (SequenceNumber32 (79), mapping), true, "Mapping should remain");
+}
+
+void
+MpTcpMappingContainerTestCase::TestPartlyAcked (void)
+{
+  Ptr<MpTcpMappingContainer> c = CreateContainer ();
+  std::vector<MpTcpMapping> mappings;
+
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      c->AddMapping (SequenceNumber64 (5000 + i * 100), SequenceNumber32 (1 + i * 100), 100);
+    }
+
+  // An ACK up to the middle of the second mapping discards the first one only
+  c->DiscardMappingsInSSNRange (SequenceNumber32 (1), 150);
+  NS_TEST_ASSERT_MSG_EQ (c->GetNMappings (), 3u, "Partly acked mapping should be kept");
+
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingsStartingFromSSN (SequenceNumber32 (151), mappings), true, "Should find mappings");
+  NS_TEST_ASSERT_MSG_EQ (mappings.size (), 2u, "Mappings starting after SND.UNA only");
+
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingsFromSSN (SequenceNumber32 (151), mappings), true, "Should find mappings");
+  NS_TEST_ASSERT_MSG_EQ (mappings.size (), 3u, "Mapping holding SND.UNA should be included");
+  NS_TEST_ASSERT_MSG_EQ (mappings[0].HeadSSN (), SequenceNumber32 (151), "Head mapping not trimmed to SND.UNA");
+  NS_TEST_ASSERT_MSG_EQ (mappings[0].HeadDSN (), SequenceNumber64 (5150), "Wrong DSN of the unacked part");
+  NS_TEST_ASSERT_MSG_EQ (mappings[0].GetLength (), 50, "Wrong length of the unacked part");
+  NS_TEST_ASSERT_MSG_EQ (mappings[1].HeadSSN (), SequenceNumber32 (201), "Mappings not sorted");
+
+  // On a mapping boundary, nothing is trimmed
+  NS_TEST_ASSERT_MSG_EQ (c->GetMappingsFromSSN (SequenceNumber32 (201), mappings), true, "Should find mappings");
+  NS_TEST_ASSERT_MSG_EQ (mappings.size (), 2u, "Wrong number of mappings");
+  NS_TEST_ASSERT_MSG_EQ (mappings[0].GetLength (), 100, "Whole mapping expected");
+}
+
+/**
+ * \brief Checks that mapping churn is served by the pool once it is warmed up
+ */
+class MpTcpMappingPoolTestCase : public TestCase
+{
+public:
+  MpTcpMappingPoolTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Churn (Ptr<MpTcpMappingContainer> c, uint32_t first, uint32_t count);
+};
+
+MpTcpMappingPoolTestCase::MpTcpMappingPoolTestCase ()
+  : TestCase ("Mapping containers recycle their storage through a shared pool")
+{
+}
+
+void
+MpTcpMappingPoolTestCase::Churn (Ptr<MpTcpMappingContainer> c, uint32_t first, uint32_t count)
+{
+  // Keep 100 mappings in flight
+  for (uint32_t i = first; i < first + count; ++i)
+    {
+      c->AddMapping (SequenceNumber64 (i * 100), SequenceNumber32 (i * 100), 100);
+      if (i >= 100)
+        {
+          c->DiscardMappingsInSSNRange (SequenceNumber32 ((i - 100) * 100), 100);
+        }
+    }
+}
+
+void
+MpTcpMappingPoolTestCase::DoRun (void)
+{
+  Ptr<MpTcpMappingPool> pool = Create<MpTcpMappingPool> ();
+  Ptr<MpTcpMappingContainer> set = CreateObject<MpTcpMappingSet> ();
+  Ptr<MpTcpMappingContainer> ring = CreateObject<MpTcpMappingRing> ();
+  set->SetPool (pool);
+  ring->SetPool (pool);
+
+  Churn (set, 0, 1000);
+  Churn (ring, 0, 1000);
+  uint64_t requests = pool->GetNRequests ();
+  uint64_t heapAllocations = pool->GetNHeapAllocations ();
+  NS_TEST_ASSERT_MSG_GT (heapAllocations, 0, "Warming up should allocate");
+
+  Churn (set, 1000, 10000);
+  Churn (ring, 1000, 10000);
+  NS_TEST_ASSERT_MSG_EQ (pool->GetNRequests (), requests + 20000, "Each set mapping uses two nodes, the ring does not grow");
+  NS_TEST_ASSERT_MSG_EQ (pool->GetNHeapAllocations (), heapAllocations, "Storage should be recycled");
+  NS_TEST_ASSERT_MSG_EQ (set->GetNMappings (), 100u, "Wrong number of mappings");
+  NS_TEST_ASSERT_MSG_EQ (ring->GetNMappings (), 100u, "Wrong number of mappings");
+
+  // Releasing a container gives its storage back to the pool
+  ring = 0;
+  Ptr<MpTcpMappingContainer> other = CreateObject<MpTcpMappingRing> ();
+  other->SetPool (pool);
+  Churn (other, 0, 100);
+  NS_TEST_ASSERT_MSG_EQ (pool->GetNHeapAllocations (), heapAllocations, "Ring storage should be recycled");
+}
+
+static class MpTcpMappingTestSuite : public TestSuite
+{
+public:
+  MpTcpMappingTestSuite ()
+    : TestSuite ("mptcp-mapping", UNIT)
+  {
+    AddTestCase (new MpTcpMappingContainerTestCase (MpTcpMappingSet::GetTypeId ()), TestCase::QUICK);
+    AddTestCase (new MpTcpMappingContainerTestCase (MpTcpMappingRing::GetTypeId ()), TestCase::QUICK);
+    AddTestCase (new MpTcpMappingPoolTestCase (), TestCase::QUICK);
+  }
+
+} g_mpTcpMappingTestSuite;
+
+} // namespace ns3
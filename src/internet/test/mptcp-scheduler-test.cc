@@ -0,0 +1,369 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <deque>
+#include "mptcp-general-test.h"
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/config.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/type-id.h"
+#include "ns3/mptcp-meta-socket.h"
+#include "ns3/mptcp-subflow.h"
+#include "ns3/mptcp-scheduler-round-robin.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpSchedulerTest");
+
+/**
+ * \brief Regression scenario for the MPTCP schedulers
+ *
+ * A bulk transfer over a fast path (10Mbps, 10ms) and a slow path (2Mbps, 50ms).
+ * Measures the out-of-order bytes held in the receiver's meta buffer and the
+ * delay between a segment's write by the application and its delivery to the
+ * receiving application, with or without opportunistic reinjection and
+ * penalisation of the slow subflow.
+ *
+ * If asked to, the case also runs a baseline transfer: with the round robin
+ * scheduler, to check the scheduler under test delivers the data sooner, or
+ * with the same scheduler without reinjection, to check reinjecting raises
+ * the goodput.
+ */
+class MpTcpSchedulerTestCase : public MpTcpGeneralTest
+{
+public:
+  /// Transfer the results are compared with
+  enum Baseline
+  {
+    NO_BASELINE,
+    ROUND_ROBIN,    //!< Round robin scheduler without reinjection
+    NO_REINJECTION  //!< Same scheduler without reinjection
+  };
+
+  MpTcpSchedulerTestCase (std::string scheduler, bool reinjection, uint32_t maxMeanOccupancy,
+                          Time maxMeanLatency, Baseline baseline = NO_BASELINE);
+
+private:
+  /// Measures of a transfer
+  struct Results
+  {
+    bool complete;          //!< All the bytes were received, in order, on both paths
+    uint32_t meanOccupancy; //!< Mean out-of-order bytes in the receiver's meta buffer
+    Time meanLatency;       //!< Mean delay from a write to its delivery
+    Time completion;        //!< Time the last byte was delivered
+    double goodput;         //!< Bits per second delivered from the first write to completion
+  };
+
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  virtual void ConfigureEnvironment (void);
+  virtual void ConfigureSource (Ptr<MpTcpMetaSocket> source);
+  virtual void DataWritten (void);
+  virtual void DataDelivered (void);
+
+  Results RunScheduler (std::string scheduler, bool reinjection);
+  void SampleOccupancy (void);
+
+  std::string m_scheduler;
+  bool m_reinjection;
+  uint32_t m_maxMeanOccupancy;
+  Time m_maxMeanLatency;
+  Baseline m_baseline;
+
+  std::string m_runScheduler;  //!< Scheduler of the transfer being run
+  bool m_runReinjection;       //!< Whether the transfer being run reinjects
+  std::deque<std::pair<uint32_t, Time> > m_writes;  //!< End offset and time of the writes not yet delivered
+  uint64_t m_occupancySum;
+  uint32_t m_occupancySamples;
+  uint32_t m_maxOccupancy;
+  Time m_latencySum;
+  uint32_t m_latencySamples;
+  Time m_maxLatency;
+};
+
+MpTcpSchedulerTestCase::MpTcpSchedulerTestCase (std::string scheduler, bool reinjection,
+                                                uint32_t maxMeanOccupancy, Time maxMeanLatency,
+                                                Baseline baseline)
+  : MpTcpGeneralTest ("Bulk transfer over heterogeneous paths with " + scheduler
+                      + (reinjection ? ", reinjection" : ", no reinjection")),
+    m_scheduler (scheduler),
+    m_reinjection (reinjection),
+    m_maxMeanOccupancy (maxMeanOccupancy),
+    m_maxMeanLatency (maxMeanLatency),
+    m_baseline (baseline)
+{
+}
+
+void
+MpTcpSchedulerTestCase::ConfigureEnvironment (void)
+{
+  Config::SetDefault ("ns3::MpTcpMetaSocket::Scheduler", TypeIdValue (TypeId::LookupByName (m_runScheduler)));
+  Config::SetDefault ("ns3::MpTcpMetaSocket::OpportunisticReinjection", BooleanValue (m_runReinjection));
+  Config::SetDefault ("ns3::MpTcpMetaSocket::Penalisation", BooleanValue (m_runReinjection));
+}
+
+void
+MpTcpSchedulerTestCase::ConfigureSource (Ptr<MpTcpMetaSocket> source)
+{
+  Simulator::Schedule (MilliSeconds (1), &MpTcpSchedulerTestCase::SampleOccupancy, this);
+}
+
+void
+MpTcpSchedulerTestCase::DataWritten (void)
+{
+  m_writes.push_back (std::make_pair (m_txBytes, Simulator::Now ()));
+}
+
+void
+MpTcpSchedulerTestCase::DataDelivered (void)
+{
+  while (!m_writes.empty () && m_writes.front ().first <= m_rxBytes)
+    {
+      Time latency = Simulator::Now () - m_writes.front ().second;
+      m_latencySum += latency;
+      m_latencySamples++;
+      m_maxLatency = std::max (m_maxLatency, latency);
+      m_writes.pop_front ();
+    }
+}
+
+void
+MpTcpSchedulerTestCase::SampleOccupancy (void)
+{
+  if (m_server)
+    {
+      // Bytes held in the meta buffer that can't be read because of a hole
+      Ptr<TcpRxBuffer64> rxBuffer = m_server->GetRxBuffer ();
+      uint32_t occupancy = rxBuffer->Size () - rxBuffer->Available ();
+      m_occupancySum += occupancy;
+      m_occupancySamples++;
+      m_maxOccupancy = std::max (m_maxOccupancy, occupancy);
+    }
+  if (m_rxBytes < m_totalBytes)
+    {
+      Simulator::Schedule (MilliSeconds (1), &MpTcpSchedulerTestCase::SampleOccupancy, this);
+    }
+}
+
+MpTcpSchedulerTestCase::Results
+MpTcpSchedulerTestCase::RunScheduler (std::string scheduler, bool reinjection)
+{
+  m_runScheduler = scheduler;
+  m_runReinjection = reinjection;
+  m_occupancySum = 0;
+  m_occupancySamples = 0;
+  m_maxOccupancy = 0;
+  m_latencySum = Seconds (0);
+  m_latencySamples = 0;
+  m_maxLatency = Seconds (0);
+
+  RunTransfer ();
+
+  Results results;
+  results.complete = m_rxBytes == m_totalBytes && m_rxContentOk
+    && m_server && m_server->GetNActiveSubflows () == 2;
+  results.meanOccupancy = m_occupancySum / std::max (m_occupancySamples, 1u);
+  results.meanLatency = m_latencySum / std::max (m_latencySamples, 1u);
+  results.completion = m_completion;
+  results.goodput = m_rxBytes * 8 / (m_completion - m_firstWrite).GetSeconds ();
+  NS_LOG_INFO (scheduler << (reinjection ? ", reinjection" : ", no reinjection") << ": reorder buffer mean "
+               << results.meanOccupancy << " max " << m_maxOccupancy
+               << " bytes, delivery latency mean " << results.meanLatency.GetMilliSeconds ()
+               << " max " << m_maxLatency.GetMilliSeconds () << " ms, completed at "
+               << m_completion.GetSeconds () << " s, goodput " << results.goodput / 1e6
+               << " Mbps, reinjected " << m_source->GetReinjectedBytes ()
+               << " bytes, " << m_source->GetNPenalties () << " penalties");
+
+  DoTeardown ();
+  return results;
+}
+
+void
+MpTcpSchedulerTestCase::DoRun (void)
+{
+  Results results = RunScheduler (m_scheduler, m_reinjection);
+  NS_TEST_ASSERT_MSG_EQ (results.complete, true, "Server should receive all bytes in order over both paths");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (results.meanOccupancy, m_maxMeanOccupancy, "Reordering buffer occupancy regressed");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (results.meanLatency, m_maxMeanLatency, "Delivery latency regressed");
+
+  if (m_baseline == ROUND_ROBIN)
+    {
+      Results baseline = RunScheduler ("ns3::MpTcpSchedulerRoundRobin", false);
+      NS_TEST_ASSERT_MSG_EQ (baseline.complete, true, "Round robin baseline should receive all bytes");
+      NS_TEST_EXPECT_MSG_LT (results.meanLatency, baseline.meanLatency, "Delivery latency no better than round robin");
+      NS_TEST_EXPECT_MSG_LT (results.completion, baseline.completion, "Transfer completed no sooner than round robin");
+    }
+  else if (m_baseline == NO_REINJECTION)
+    {
+      Results baseline = RunScheduler (m_scheduler, false);
+      NS_TEST_ASSERT_MSG_EQ (baseline.complete, true, "Baseline without reinjection should receive all bytes");
+      NS_TEST_EXPECT_MSG_GT (results.goodput, baseline.goodput, "Reinjection did not raise the goodput");
+      NS_TEST_EXPECT_MSG_LT (results.completion, baseline.completion, "Reinjection did not complete the transfer sooner");
+    }
+}
+
+void
+MpTcpSchedulerTestCase::DoTeardown (void)
+{
+  m_writes.clear ();
+  MpTcpGeneralTest::DoTeardown ();
+}
+
+/**
+ * \brief DATA_ACK coalescing over two identical paths
+ *
+ * Segments sent on both subflows in the same scheduling pass are acknowledged
+ * at the same instant, so the meta socket gets several DATA_ACKs per timestamp.
+ * With coalescing they must be merged without losing or reordering data.
+ *
+ * During the transfer, the test also hands duplicate DATA_ACKs to the meta
+ * socket from a chain of events, each scheduled at the same instant by the
+ * previous one: they must all be merged into the first one.
+ *
+ * The test also counts the scheduler passes run right after another one,
+ * when a window that grew upon an ACK schedules a pass of its own: with
+ * coalescing, the pass of the coalesced DATA_ACK must fill it instead.
+ */
+class MpTcpDataAckCoalescingTestCase : public MpTcpGeneralTest
+{
+public:
+  MpTcpDataAckCoalescingTestCase (bool coalesce);
+
+private:
+  virtual void DoRun (void);
+  virtual void ConfigureEnvironment (void);
+  virtual void ConfigureSource (Ptr<MpTcpMetaSocket> source);
+
+  void InjectDataAcks (uint32_t count);
+  void InjectDataAck (uint32_t left, uint32_t coalescedBefore);
+  void SendPass (uint32_t oldValue, uint32_t newValue);
+
+  bool m_coalesce;
+  uint32_t m_coalescedInjected;
+  Time m_lastPass;
+  uint32_t m_followUpPasses;
+};
+
+MpTcpDataAckCoalescingTestCase::MpTcpDataAckCoalescingTestCase (bool coalesce)
+  : MpTcpGeneralTest (std::string ("Bulk transfer over identical paths, ")
+                      + (coalesce ? "coalesced DATA_ACKs" : "DATA_ACKs processed on arrival")),
+    m_coalesce (coalesce)
+{
+  m_secondPathRate = m_firstPathRate;
+  m_secondPathDelay = m_firstPathDelay;
+}
+
+void
+MpTcpDataAckCoalescingTestCase::ConfigureEnvironment (void)
+{
+  Config::SetDefault ("ns3::MpTcpMetaSocket::Scheduler", TypeIdValue (MpTcpSchedulerRoundRobin::GetTypeId ()));
+  Config::SetDefault ("ns3::MpTcpMetaSocket::CoalesceDataAcks", BooleanValue (m_coalesce));
+}
+
+void
+MpTcpDataAckCoalescingTestCase::ConfigureSource (Ptr<MpTcpMetaSocket> source)
+{
+  source->TraceConnectWithoutContext ("SendPasses", MakeCallback (&MpTcpDataAckCoalescingTestCase::SendPass, this));
+  Simulator::Schedule (MilliSeconds (200), &MpTcpDataAckCoalescingTestCase::InjectDataAcks, this, 3);
+}
+
+void
+MpTcpDataAckCoalescingTestCase::InjectDataAcks (uint32_t count)
+{
+  InjectDataAck (count, m_source->GetNCoalescedDataAcks ());
+}
+
+void
+MpTcpDataAckCoalescingTestCase::InjectDataAck (uint32_t left, uint32_t coalescedBefore)
+{
+  m_source->ReceivedAck (m_source->GetActiveSubflow (0), m_source->GetTxBuffer ()->HeadSequence ());
+  if (--left > 0)
+    {
+      Simulator::ScheduleNow (&MpTcpDataAckCoalescingTestCase::InjectDataAck, this, left, coalescedBefore);
+    }
+  else
+    {
+      m_coalescedInjected = m_source->GetNCoalescedDataAcks () - coalescedBefore;
+    }
+}
+
+void
+MpTcpDataAckCoalescingTestCase::SendPass (uint32_t oldValue, uint32_t newValue)
+{
+  if (Simulator::Now () - m_lastPass == TimeStep (1))
+    {
+      m_followUpPasses++;
+    }
+  m_lastPass = Simulator::Now ();
+}
+
+void
+MpTcpDataAckCoalescingTestCase::DoRun (void)
+{
+  m_coalescedInjected = 0;
+  m_lastPass = Seconds (0);
+  m_followUpPasses = 0;
+
+  RunTransfer ();
+
+  NS_LOG_INFO (GetName () << ": " << m_source->GetNCoalescedDataAcks () << " coalesced DATA_ACKs, "
+               << m_source->GetNSendPasses () << " scheduler passes, " << m_followUpPasses << " follow-up passes");
+  NS_TEST_EXPECT_MSG_EQ (m_coalescedInjected, (m_coalesce ? 2u : 0u), "DATA_ACKs of the injected chain not merged");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBytes, m_totalBytes, "Server received all bytes");
+  NS_TEST_EXPECT_MSG_EQ (m_rxContentOk, true, "Server received the bytes in order");
+  if (m_coalesce)
+    {
+      NS_TEST_EXPECT_MSG_GT (m_source->GetNCoalescedDataAcks (), 0, "Simultaneous DATA_ACKs should have been merged");
+      NS_TEST_EXPECT_MSG_EQ (m_followUpPasses, 0, "Grown windows should be filled by the pass of the coalesced DATA_ACK");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_source->GetNCoalescedDataAcks (), 0, "DATA_ACKs merged while coalescing is disabled");
+    }
+}
+
+static class MpTcpSchedulerTestSuite : public TestSuite
+{
+public:
+  MpTcpSchedulerTestSuite ()
+    : TestSuite ("mptcp-scheduler", SYSTEM)
+  {
+    // Bounds on the mean reordering buffer occupancy and delivery latency,
+    // with some slack over the values measured when the schedulers were added:
+    // round robin 9157 bytes and 112ms, fastest RTT and redundant 1136 bytes and
+    // 105ms, BLEST 0 bytes and 106ms, ECF 754 bytes and 106ms.
+    // Round robin puts the most data on the slow path, reinjecting what blocks
+    // the receive window should keep its reordering buffer as low as the others'
+    AddTestCase (new MpTcpSchedulerTestCase ("ns3::MpTcpSchedulerRoundRobin", false, 10000, MilliSeconds (118)), TestCase::QUICK);
+    AddTestCase (new MpTcpSchedulerTestCase ("ns3::MpTcpSchedulerFastestRTT", false, 1500, MilliSeconds (110)), TestCase::QUICK);
+    AddTestCase (new MpTcpSchedulerTestCase ("ns3::MpTcpSchedulerBlest", false, 500, MilliSeconds (111),
+                                             MpTcpSchedulerTestCase::ROUND_ROBIN), TestCase::QUICK);
+    AddTestCase (new MpTcpSchedulerTestCase ("ns3::MpTcpSchedulerEcf", false, 1000, MilliSeconds (111),
+                                             MpTcpSchedulerTestCase::ROUND_ROBIN), TestCase::QUICK);
+    AddTestCase (new MpTcpSchedulerTestCase ("ns3::MpTcpSchedulerRedundant", false, 1500, MilliSeconds (110),
+                                             MpTcpSchedulerTestCase::ROUND_ROBIN), TestCase::QUICK);
+    AddTestCase (new MpTcpSchedulerTestCase ("ns3::MpTcpSchedulerRoundRobin", true, 4000, MilliSeconds (111),
+                                             MpTcpSchedulerTestCase::NO_REINJECTION), TestCase::QUICK);
+    AddTestCase (new MpTcpDataAckCoalescingTestCase (false), TestCase::QUICK);
+    AddTestCase (new MpTcpDataAckCoalescingTestCase (true), TestCase::QUICK);
+  }
+
+} g_mptcpSchedulerTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,219 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <vector>
+#include "tcp-bulk-transfer-test.h"
+#include "ns3/log.h"
+#include "ns3/config.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/mptcp-socket-factory.h"
+#include "ns3/mptcp-meta-socket.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpBulkTransferTest");
+
+TcpBulkTransferTest::TcpBulkTransferTest (const std::string &desc, bool mptcp)
+  : TestCase (desc),
+    m_mptcp (mptcp),
+    m_pathRate ("10Mbps"),
+    m_pathDelay (MilliSeconds (20)),
+    m_totalBytes (300 * 1400),
+    m_writeSize (1400),
+    m_stopTime (Seconds (30)),
+    m_txBytes (0),
+    m_rxBytes (0),
+    m_rxContentOk (true)
+{
+}
+
+uint8_t
+TcpBulkTransferTest::PayloadByte (uint32_t offset)
+{
+  return static_cast<uint8_t> (offset % 251);
+}
+
+void
+TcpBulkTransferTest::ConfigureEnvironment (void)
+{
+}
+
+NetDeviceContainer
+TcpBulkTransferTest::InstallDevices (NodeContainer nodes)
+{
+  SimpleNetDeviceHelper link;
+  link.SetNetDevicePointToPointMode (true);
+  link.SetDeviceAttribute ("DataRate", StringValue (m_pathRate));
+  link.SetChannelAttribute ("Delay", TimeValue (m_pathDelay));
+  return link.Install (nodes);
+}
+
+void
+TcpBulkTransferTest::ConfigureNetwork (Ptr<Node> source, Ptr<Node> server, NetDeviceContainer devices)
+{
+}
+
+Ptr<Socket>
+TcpBulkTransferTest::CreateServerSocket (Ptr<Node> node)
+{
+  if (m_mptcp)
+    {
+      return node->GetObject<MpTcpSocketFactory> ()->CreateSocket ();
+    }
+  return node->GetObject<TcpSocketFactory> ()->CreateSocket ();
+}
+
+Ptr<Socket>
+TcpBulkTransferTest::CreateSourceSocket (Ptr<Node> node)
+{
+  if (m_mptcp)
+    {
+      return node->GetObject<MpTcpSocketFactory> ()->CreateSocket ();
+    }
+  return node->GetObject<TcpSocketFactory> ()->CreateSocket ();
+}
+
+void
+TcpBulkTransferTest::DataDelivered (void)
+{
+}
+
+void
+TcpBulkTransferTest::SourceConnect (void)
+{
+  m_source->Bind ();
+  m_source->Connect (InetSocketAddress (Ipv4Address ("10.1.1.2"), 50000));
+}
+
+void
+TcpBulkTransferTest::SourceConnected (Ptr<Socket> sock)
+{
+  SourceHandleSend (sock, sock->GetTxAvailable ());
+}
+
+void
+TcpBulkTransferTest::SourceHandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  while (sock->GetTxAvailable () >= m_writeSize && m_txBytes < m_totalBytes)
+    {
+      uint32_t toSend = std::min (m_writeSize, m_totalBytes - m_txBytes);
+      std::vector<uint8_t> data (toSend);
+      for (uint32_t i = 0; i < toSend; ++i)
+        {
+          data[i] = PayloadByte (m_txBytes + i);
+        }
+      int sent = sock->Send (Create<Packet> (&data[0], toSend));
+      NS_TEST_EXPECT_MSG_EQ ((sent != -1), true, "Error during send ?");
+      if (sent <= 0)
+        {
+          break;
+        }
+      m_txBytes += sent;
+    }
+}
+
+void
+TcpBulkTransferTest::ServerHandleConnectionCreated (Ptr<Socket> s, const Address & addr)
+{
+  s->SetRecvCallback (MakeCallback (&TcpBulkTransferTest::ServerHandleRecv, this));
+}
+
+void
+TcpBulkTransferTest::ServerHandleRecv (Ptr<Socket> sock)
+{
+  while (sock->GetRxAvailable () > 0)
+    {
+      Ptr<Packet> p = sock->Recv ();
+      std::vector<uint8_t> data (p->GetSize ());
+      p->CopyData (&data[0], data.size ());
+      for (uint32_t i = 0; i < data.size (); ++i)
+        {
+          m_rxContentOk = m_rxContentOk && (data[i] == PayloadByte (m_rxBytes + i));
+        }
+      m_rxBytes += p->GetSize ();
+    }
+  m_completion = Simulator::Now ();
+  DataDelivered ();
+}
+
+void
+TcpBulkTransferTest::RunTransfer (void)
+{
+  m_txBytes = 0;
+  m_rxBytes = 0;
+  m_rxContentOk = true;
+  m_completion = Seconds (0);
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1400));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (65535));
+  Config::SetDefault ("ns3::TcpSocketImpl::Timestamp", BooleanValue (false));
+  ConfigureEnvironment ();
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  Ptr<Node> source = nodes.Get (0);
+  Ptr<Node> server = nodes.Get (1);
+
+  NetDeviceContainer devices = InstallDevices (nodes);
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  ConfigureNetwork (source, server, devices);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (devices);
+
+  // The sockets take the parameters of the defaults when they are created
+  Ptr<Socket> listening = CreateServerSocket (server);
+  m_source = CreateSourceSocket (source);
+  if (m_mptcp)
+    {
+      NS_TEST_ASSERT_MSG_NE (DynamicCast<MpTcpMetaSocket> (m_source), 0, "MPTCP socket factory should create meta sockets");
+    }
+  listening->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  listening->Listen ();
+  listening->SetAcceptCallback (MakeNullCallback<bool, Ptr< Socket >, const Address &> (),
+                                MakeCallback (&TcpBulkTransferTest::ServerHandleConnectionCreated, this));
+
+  m_source->SetConnectCallback (MakeCallback (&TcpBulkTransferTest::SourceConnected, this),
+                                MakeNullCallback<void, Ptr<Socket> > ());
+  m_source->SetSendCallback (MakeCallback (&TcpBulkTransferTest::SourceHandleSend, this));
+  // The queue discs of the devices are only set up once the nodes are initialized
+  Simulator::Schedule (MilliSeconds (1), &TcpBulkTransferTest::SourceConnect, this);
+
+  Simulator::Stop (m_stopTime);
+  Simulator::Run ();
+}
+
+void
+TcpBulkTransferTest::DoTeardown (void)
+{
+  m_source = 0;
+  Simulator::Destroy ();
+  Config::Reset ();
+}
+
+} // namespace ns3
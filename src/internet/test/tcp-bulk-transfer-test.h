@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef TCPBULKTRANSFERTEST_H
+#define TCPBULKTRANSFERTEST_H
+
+#include "ns3/test.h"
+#include "ns3/nstime.h"
+#include "ns3/node.h"
+#include "ns3/socket.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+
+namespace ns3 {
+
+/**
+ * \brief Bulk transfer over one path between two nodes, over TCP or MPTCP
+ *
+ * The source connects over a point to point link (10.1.1.0/24) to the
+ * server, then writes m_totalBytes, m_writeSize bytes at a time, whose
+ * content the server checks as it reads them. Over MPTCP, the transfer
+ * runs on the master subflow only.
+ *
+ * Subclasses set the attributes of the transfer in ConfigureEnvironment,
+ * may replace the devices in InstallDevices, set them up and hook their
+ * traces in ConfigureNetwork, call
+ * RunTransfer from their DoRun and check the counters of the transfer
+ * once it returns.
+ */
+class TcpBulkTransferTest : public TestCase
+{
+public:
+  /**
+   * \param desc description of the test
+   * \param mptcp whether the sockets are MPTCP meta sockets
+   */
+  TcpBulkTransferTest (const std::string &desc, bool mptcp);
+
+protected:
+  virtual void DoTeardown (void);
+
+  /**
+   * \brief Set the attributes of the transfer
+   *
+   * Called by RunTransfer after it set the defaults of the transfer:
+   * 1400 bytes segments, a 65535 bytes receive buffer and no timestamps.
+   */
+  virtual void ConfigureEnvironment (void);
+
+  /**
+   * \brief Create the devices of the link, SimpleNetDevices by default
+   * \param nodes the source and the server
+   * \return the devices of the link, the first one on the source
+   */
+  virtual NetDeviceContainer InstallDevices (NodeContainer nodes);
+
+  /**
+   * \brief Set up the devices of the link and hook the traces of the nodes
+   *
+   * Called once the internet stack is installed, before the addresses are
+   * assigned, which would install the default queue discs of the devices.
+   *
+   * \param source the source node
+   * \param server the server node
+   * \param devices the devices of the link, the first one on the source
+   */
+  virtual void ConfigureNetwork (Ptr<Node> source, Ptr<Node> server, NetDeviceContainer devices);
+
+  /**
+   * \brief Create the listening socket of the server
+   * \param node the server node
+   * \return a TCP socket, or an MPTCP meta socket
+   */
+  virtual Ptr<Socket> CreateServerSocket (Ptr<Node> node);
+
+  /**
+   * \brief Create the socket of the source
+   * \param node the source node
+   * \return a TCP socket, or an MPTCP meta socket
+   */
+  virtual Ptr<Socket> CreateSourceSocket (Ptr<Node> node);
+
+  /**
+   * \brief Called after the server application read the data available
+   */
+  virtual void DataDelivered (void);
+
+  /**
+   * \brief Run the transfer until all the bytes are read or m_stopTime
+   */
+  void RunTransfer (void);
+
+  /**
+   * \return The payload byte at offset in the transfer
+   */
+  static uint8_t PayloadByte (uint32_t offset);
+
+  bool m_mptcp;                  //!< Whether the sockets are MPTCP meta sockets
+  std::string m_pathRate;        //!< Rate of the path
+  Time m_pathDelay;              //!< One way delay of the path
+  uint32_t m_totalBytes;         //!< Bytes to transfer
+  uint32_t m_writeSize;          //!< Bytes per write of the source application
+  Time m_stopTime;               //!< End of the simulation
+
+  uint32_t m_txBytes;            //!< Bytes written by the source application
+  uint32_t m_rxBytes;            //!< Bytes read by the server application
+  bool m_rxContentOk;            //!< Whether the bytes read so far are those written
+  Time m_completion;             //!< Time of the last read
+  Ptr<Socket> m_source;          //!< Source socket
+
+private:
+  void SourceConnect (void);
+  void SourceConnected (Ptr<Socket> sock);
+  void SourceHandleSend (Ptr<Socket> sock, uint32_t available);
+  void ServerHandleConnectionCreated (Ptr<Socket> s, const Address & addr);
+  void ServerHandleRecv (Ptr<Socket> sock);
+};
+
+} // namespace ns3
+
+#endif /* TCPBULKTRANSFERTEST_H */
@@ -42,7 +42,7 @@ public:
   {
   }
 protected:
-  virtual Ptr<TcpSocketBase> Fork ();
+  virtual Ptr<TcpSocketImpl> Fork ();
   virtual void ReceivedData (Ptr<Packet> packet, const TcpHeader& tcpHeader);
 };
 
@@ -59,7 +59,7 @@ TcpSocketHalfAck::GetTypeId (void)
   return tid;
 }
 
-Ptr<TcpSocketBase>
+Ptr<TcpSocketImpl>
 TcpSocketHalfAck::Fork (void)
 {
   return CopyObject<TcpSocketHalfAck> (this);
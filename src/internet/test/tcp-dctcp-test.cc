@@ -0,0 +1,163 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/tcp-congestion-ops.h"
+#include "ns3/tcp-socket-base.h"
+#include "ns3/tcp-dctcp.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpDctcpTestSuite");
+
+/**
+ * \brief Testing the estimate of alpha on TcpDctcp
+ *
+ * A window of segments is acked one segment at a time, the first ones with
+ * the ECN-Echo flag. Alpha is only updated at the end of the window.
+ */
+class TcpDctcpAlphaTest : public TestCase
+{
+public:
+  TcpDctcpAlphaTest (uint32_t segments, uint32_t marked, uint32_t segmentSize,
+                     const std::string &name);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_segments;
+  uint32_t m_marked;
+  uint32_t m_segmentSize;
+  Ptr<TcpSocketState> m_state;
+};
+
+TcpDctcpAlphaTest::TcpDctcpAlphaTest (uint32_t segments, uint32_t marked,
+                                      uint32_t segmentSize, const std::string &name)
+  : TestCase (name),
+    m_segments (segments),
+    m_marked (marked),
+    m_segmentSize (segmentSize)
+{
+}
+
+void
+TcpDctcpAlphaTest::DoRun ()
+{
+  m_state = CreateObject<TcpSocketState> ();
+
+  m_state->m_segmentSize = m_segmentSize;
+  m_state->m_highTxMark = SequenceNumber32 (1 + m_segments * m_segmentSize);
+  m_state->m_lastAckedSeq = SequenceNumber32 (1);
+
+  Ptr<TcpDctcp> cong = CreateObject <TcpDctcp> ();
+  DoubleValue g;
+  cong->GetAttribute ("G", g);
+  double alpha = cong->GetAlpha ();
+
+  for (uint32_t i = 0; i < m_segments; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (cong->GetAlpha (), alpha, "Alpha updated before the end of the window");
+      m_state->m_lastAckedSeq += m_segmentSize;
+      cong->InAckEvent (m_state, m_segmentSize, i < m_marked);
+    }
+
+  double expected = (1.0 - g.Get ()) * alpha + g.Get () * m_marked / m_segments;
+  NS_TEST_ASSERT_MSG_EQ_TOL (cong->GetAlpha (), expected, 1e-9, "Alpha not updated at the end of the window");
+}
+
+/**
+ * \brief Testing the window reduction on TcpDctcp
+ *
+ * With the default initial alpha of 1, the window is halved on ECN-Echo;
+ * once alpha is set to 0.5, it is reduced by a quarter. A loss halves the
+ * flight as NewReno.
+ */
+class TcpDctcpDecrementTest : public TestCase
+{
+public:
+  TcpDctcpDecrementTest (uint32_t cWnd, uint32_t segmentSize, const std::string &name);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_cWnd;
+  uint32_t m_segmentSize;
+  Ptr<TcpSocketState> m_state;
+};
+
+TcpDctcpDecrementTest::TcpDctcpDecrementTest (uint32_t cWnd, uint32_t segmentSize,
+                                              const std::string &name)
+  : TestCase (name),
+    m_cWnd (cWnd),
+    m_segmentSize (segmentSize)
+{
+}
+
+void
+TcpDctcpDecrementTest::DoRun ()
+{
+  m_state = CreateObject<TcpSocketState> ();
+
+  m_state->m_cWnd = m_cWnd;
+  m_state->m_segmentSize = m_segmentSize;
+
+  Ptr<TcpDctcp> cong = CreateObject <TcpDctcp> ();
+
+  m_state->m_congState = TcpSocketState::CA_CWR;
+  NS_TEST_ASSERT_MSG_EQ (cong->GetSsThresh (m_state, m_cWnd), std::max (m_cWnd / 2, 2 * m_segmentSize),
+                         "Window not halved with alpha = 1");
+
+  cong->SetAttribute ("InitialAlpha", DoubleValue (0.5));
+  NS_TEST_ASSERT_MSG_EQ (cong->GetSsThresh (m_state, m_cWnd),
+                         std::max (static_cast<uint32_t> (m_cWnd * 0.75), 2 * m_segmentSize),
+                         "Window not reduced by alpha / 2");
+
+  m_state->m_congState = TcpSocketState::CA_RECOVERY;
+  NS_TEST_ASSERT_MSG_EQ (cong->GetSsThresh (m_state, m_cWnd / 2), std::max (m_cWnd / 4, 2 * m_segmentSize),
+                         "Flight not halved on a loss");
+}
+
+
+// -------------------------------------------------------------------
+
+static class TcpDctcpTestSuite : public TestSuite
+{
+public:
+  TcpDctcpTestSuite () : TestSuite ("tcp-dctcp-test", UNIT)
+  {
+    AddTestCase (new TcpDctcpAlphaTest (10, 0, 1400,
+                                        "DCTCP alpha on a window of 10 segments, none marked"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpDctcpAlphaTest (10, 3, 1400,
+                                        "DCTCP alpha on a window of 10 segments, 3 marked"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpDctcpAlphaTest (40, 40, 536,
+                                        "DCTCP alpha on a window of 40 segments, all marked"),
+                 TestCase::QUICK);
+
+    AddTestCase (new TcpDctcpDecrementTest (40 * 1400, 1400,
+                                            "DCTCP decrement test on cWnd = 40 segments"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpDctcpDecrementTest (3 * 536, 536,
+                                            "DCTCP decrement test on cWnd = 3 segments"),
+                 TestCase::QUICK);
+  }
+} g_tcpDctcpTest;
+
+} // namespace ns3
@@ -0,0 +1,315 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tcp-bulk-transfer-test.h"
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/config.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/queue-disc.h"
+#include "ns3/ipv4-queue-disc-item.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-dctcp.h"
+#include "ns3/mptcp-lia.h"
+#include "ns3/mptcp-dctcp.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpEcnTest");
+
+/**
+ * \brief FIFO queue disc marking one ECN-capable packet out of Interval
+ *
+ * The devices of the test have no flow control, so that the queue of an
+ * AQM would not build up: the marks are set regardless of the queue.
+ */
+class TcpEcnTestMarker : public QueueDisc
+{
+public:
+  static TypeId GetTypeId (void);
+
+  TcpEcnTestMarker ();
+
+  uint32_t m_interval;   //!< Packets between two marks
+  uint32_t m_ect;        //!< ECN-capable packets enqueued
+  uint32_t m_marks;      //!< Packets marked
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+};
+
+NS_OBJECT_ENSURE_REGISTERED (TcpEcnTestMarker);
+
+TypeId
+TcpEcnTestMarker::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpEcnTestMarker")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpEcnTestMarker> ()
+    .AddAttribute ("Interval", "Packets between two marks, 0 for none",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpEcnTestMarker::m_interval),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+TcpEcnTestMarker::TcpEcnTestMarker ()
+  : m_interval (0),
+    m_ect (0),
+    m_marks (0)
+{
+}
+
+bool
+TcpEcnTestMarker::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  Ptr<Ipv4QueueDiscItem> ipv4Item = DynamicCast<Ipv4QueueDiscItem> (item);
+  if (ipv4Item && ipv4Item->GetHeader ().GetEcn () != Ipv4Header::ECN_NotECT)
+    {
+      ++m_ect;
+      if (m_interval > 0 && m_ect % m_interval == 0 && item->Mark ())
+        {
+          ++m_marks;
+        }
+    }
+  return GetInternalQueue (0)->Enqueue (item);
+}
+
+Ptr<QueueDiscItem>
+TcpEcnTestMarker::DoDequeue (void)
+{
+  return StaticCast<QueueDiscItem> (GetInternalQueue (0)->Dequeue ());
+}
+
+Ptr<const QueueDiscItem>
+TcpEcnTestMarker::DoPeek (void) const
+{
+  return StaticCast<const QueueDiscItem> (GetInternalQueue (0)->Peek ());
+}
+
+bool
+TcpEcnTestMarker::CheckConfig (void)
+{
+  if (GetNInternalQueues () == 0)
+    {
+      AddInternalQueue (CreateObject<DropTailQueue> ());
+    }
+  return true;
+}
+
+void
+TcpEcnTestMarker::InitializeParams (void)
+{
+}
+
+/**
+ * \brief ECN negotiation, marking, echo and window reduction
+ *
+ * A bulk transfer of 500 segments over one path (100Mbps, 10ms), over TCP
+ * or over an MPTCP subflow. The queue disc of the source marks one
+ * ECN-capable packet out of 20. ECN is only used when both ends ask for
+ * it, or with a congestion control which needs it: then all the data
+ * segments are ECN-capable, the server echoes the marks, and the source
+ * reduces its window and signals it with the CWR flag.
+ */
+class TcpEcnTestCase : public TcpBulkTransferTest
+{
+public:
+  TcpEcnTestCase (std::string name, bool mptcp, bool sourceEcn, bool serverEcn,
+                  TypeId congestion, bool expectEcn);
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  virtual void ConfigureEnvironment (void);
+  virtual void ConfigureNetwork (Ptr<Node> source, Ptr<Node> server, NetDeviceContainer devices);
+  virtual Ptr<Socket> CreateServerSocket (Ptr<Node> node);
+  virtual Ptr<Socket> CreateSourceSocket (Ptr<Node> node);
+
+  void SourceTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+  void ServerTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  bool m_sourceEcn;
+  bool m_serverEcn;
+  TypeId m_congestion;
+  bool m_expectEcn;
+
+  uint32_t m_dataSegments;  //!< Data segments sent by the source
+  uint32_t m_ectSegments;   //!< ECN-capable data segments sent by the source
+  uint32_t m_cwrSegments;   //!< Segments sent by the source with the CWR flag
+  uint32_t m_eceAcks;       //!< Segments sent by the server with the ECE flag
+  Ptr<TcpEcnTestMarker> m_marker;
+};
+
+TcpEcnTestCase::TcpEcnTestCase (std::string name, bool mptcp, bool sourceEcn, bool serverEcn,
+                                TypeId congestion, bool expectEcn)
+  : TcpBulkTransferTest (name, mptcp),
+    m_sourceEcn (sourceEcn),
+    m_serverEcn (serverEcn),
+    m_congestion (congestion),
+    m_expectEcn (expectEcn)
+{
+  m_pathRate = "100Mbps";
+  m_pathDelay = MilliSeconds (10);
+  m_totalBytes = 500 * 1400;
+  m_stopTime = Seconds (10);
+}
+
+void
+TcpEcnTestCase::ConfigureEnvironment (void)
+{
+  Config::SetDefault ("ns3::TcpL4Protocol::SocketType", TypeIdValue (m_congestion));
+  Config::SetDefault ("ns3::MpTcpSocketFactory::CongestionControl", TypeIdValue (m_congestion));
+  Config::SetDefault ("ns3::MpTcpMetaSocket::ForkCongestionControl", BooleanValue (true));
+}
+
+void
+TcpEcnTestCase::ConfigureNetwork (Ptr<Node> source, Ptr<Node> server, NetDeviceContainer devices)
+{
+  TrafficControlHelper tch;
+  tch.SetRootQueueDisc ("ns3::TcpEcnTestMarker", "Interval", UintegerValue (20));
+  m_marker = DynamicCast<TcpEcnTestMarker> (tch.Install (devices.Get (0)).Get (0));
+  source->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("Tx",
+    MakeCallback (&TcpEcnTestCase::SourceTx, this));
+  server->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("Tx",
+    MakeCallback (&TcpEcnTestCase::ServerTx, this));
+}
+
+Ptr<Socket>
+TcpEcnTestCase::CreateServerSocket (Ptr<Node> node)
+{
+  Config::SetDefault ("ns3::TcpSocketImpl::Ecn", BooleanValue (m_serverEcn));
+  return TcpBulkTransferTest::CreateServerSocket (node);
+}
+
+Ptr<Socket>
+TcpEcnTestCase::CreateSourceSocket (Ptr<Node> node)
+{
+  Config::SetDefault ("ns3::TcpSocketImpl::Ecn", BooleanValue (m_sourceEcn));
+  return TcpBulkTransferTest::CreateSourceSocket (node);
+}
+
+void
+TcpEcnTestCase::SourceTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Ptr<Packet> copy = p->Copy ();
+  Ipv4Header ipHeader;
+  copy->RemoveHeader (ipHeader);
+  TcpHeader tcpHeader;
+  copy->RemoveHeader (tcpHeader);
+  if (tcpHeader.GetFlags () & TcpHeader::SYN)
+    {
+      return;
+    }
+  if (copy->GetSize () > 0)
+    {
+      ++m_dataSegments;
+      if (ipHeader.GetEcn () == Ipv4Header::ECN_ECT0)
+        {
+          ++m_ectSegments;
+        }
+    }
+  if (tcpHeader.GetFlags () & TcpHeader::CWR)
+    {
+      ++m_cwrSegments;
+    }
+}
+
+void
+TcpEcnTestCase::ServerTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Ptr<Packet> copy = p->Copy ();
+  Ipv4Header ipHeader;
+  copy->RemoveHeader (ipHeader);
+  TcpHeader tcpHeader;
+  copy->RemoveHeader (tcpHeader);
+  if (!(tcpHeader.GetFlags () & TcpHeader::SYN) && (tcpHeader.GetFlags () & TcpHeader::ECE))
+    {
+      ++m_eceAcks;
+    }
+}
+
+void
+TcpEcnTestCase::DoRun (void)
+{
+  m_dataSegments = 0;
+  m_ectSegments = 0;
+  m_cwrSegments = 0;
+  m_eceAcks = 0;
+
+  RunTransfer ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_rxBytes, m_totalBytes, "Server received all bytes");
+  NS_TEST_EXPECT_MSG_EQ (m_rxContentOk, true, "Server received the bytes in order");
+  NS_LOG_INFO (GetName () << ": " << m_ectSegments << " ECN-capable of " << m_dataSegments <<
+               " data segments, " << m_marker->m_marks << " marked, " << m_eceAcks <<
+               " ECE, " << m_cwrSegments << " CWR");
+  NS_TEST_ASSERT_MSG_GT (m_dataSegments, 0, "No data segment sent");
+  if (m_expectEcn)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_ectSegments, m_dataSegments, "Data segments should all be ECN-capable");
+      NS_TEST_EXPECT_MSG_GT (m_marker->m_marks, 0, "No segment marked");
+      NS_TEST_EXPECT_MSG_GT (m_eceAcks, 0, "Marks not echoed");
+      NS_TEST_EXPECT_MSG_GT (m_cwrSegments, 0, "Window reductions not signalled");
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (m_cwrSegments, m_marker->m_marks, "More window reductions than marks");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_ectSegments, 0, "ECN-capable segments without ECN");
+      NS_TEST_EXPECT_MSG_EQ (m_marker->m_marks, 0, "Segments marked without ECN");
+      NS_TEST_EXPECT_MSG_EQ (m_eceAcks, 0, "ECE flag without ECN");
+      NS_TEST_EXPECT_MSG_EQ (m_cwrSegments, 0, "CWR flag without ECN");
+    }
+}
+
+void
+TcpEcnTestCase::DoTeardown (void)
+{
+  m_marker = 0;
+  TcpBulkTransferTest::DoTeardown ();
+}
+
+static class TcpEcnTestSuite : public TestSuite
+{
+public:
+  TcpEcnTestSuite ()
+    : TestSuite ("tcp-ecn", SYSTEM)
+  {
+    AddTestCase (new TcpEcnTestCase ("No ECN, TCP", false, false, false, TcpNewReno::GetTypeId (), false), TestCase::QUICK);
+    AddTestCase (new TcpEcnTestCase ("ECN refused by the server, TCP", false, true, false, TcpNewReno::GetTypeId (), false), TestCase::QUICK);
+    AddTestCase (new TcpEcnTestCase ("ECN not asked by the source, TCP", false, false, true, TcpNewReno::GetTypeId (), false), TestCase::QUICK);
+    AddTestCase (new TcpEcnTestCase ("ECN, TCP", false, true, true, TcpNewReno::GetTypeId (), true), TestCase::QUICK);
+    AddTestCase (new TcpEcnTestCase ("DCTCP, TCP", false, false, false, TcpDctcp::GetTypeId (), true), TestCase::QUICK);
+    AddTestCase (new TcpEcnTestCase ("No ECN, MPTCP subflow", true, false, false, MpTcpLia::GetTypeId (), false), TestCase::QUICK);
+    AddTestCase (new TcpEcnTestCase ("ECN, MPTCP subflow", true, true, true, MpTcpLia::GetTypeId (), true), TestCase::QUICK);
+    AddTestCase (new TcpEcnTestCase ("Coupled DCTCP, MPTCP subflow", true, false, false, MpTcpDctcp::GetTypeId (), true), TestCase::QUICK);
+  }
+
+} g_tcpEcnTestSuite;
+
+} // namespace ns3
@@ -518,11 +518,11 @@ TcpGeneralTest::GetReTxThreshold (SocketWho who)
 {
   if (who == SENDER)
     {
-      return DynamicCast<TcpSocketMsgBase> (m_senderSocket)->m_retxThresh;
+      return DynamicCast<TcpSocketMsgBase> (m_senderSocket)->m_tcpParams->m_retxThresh;
     }
   else if (who == RECEIVER)
     {
-      return DynamicCast<TcpSocketMsgBase> (m_receiverSocket)->m_retxThresh;
+      return DynamicCast<TcpSocketMsgBase> (m_receiverSocket)->m_tcpParams->m_retxThresh;
     }
   else
     {
@@ -552,11 +552,11 @@ TcpGeneralTest::GetDelAckCount (SocketWho who)
 {
   if (who == SENDER)
     {
-      return DynamicCast<TcpSocketMsgBase> (m_senderSocket)->m_delAckMaxCount;
+      return DynamicCast<TcpSocketMsgBase> (m_senderSocket)->m_tcpParams->m_delAckMaxCount;
     }
   else if (who == RECEIVER)
     {
-      return DynamicCast<TcpSocketMsgBase> (m_receiverSocket)->m_delAckMaxCount;
+      return DynamicCast<TcpSocketMsgBase> (m_receiverSocket)->m_tcpParams->m_delAckMaxCount;
     }
   else
     {
@@ -660,11 +660,11 @@ TcpGeneralTest::GetMinRto (SocketWho who)
 {
   if (who == SENDER)
     {
-      return DynamicCast<TcpSocketMsgBase> (m_senderSocket)->m_minRto;
+      return DynamicCast<TcpSocketMsgBase> (m_senderSocket)->m_tcpParams->m_minRto;
     }
   else if (who == RECEIVER)
     {
-      return DynamicCast<TcpSocketMsgBase> (m_receiverSocket)->m_minRto;
+      return DynamicCast<TcpSocketMsgBase> (m_receiverSocket)->m_tcpParams->m_minRto;
     }
   else
     {
@@ -677,11 +677,11 @@ TcpGeneralTest::GetConnTimeout (SocketWho who)
 {
   if (who == SENDER)
     {
-      return DynamicCast<TcpSocketMsgBase> (m_senderSocket)->m_cnTimeout;
+      return DynamicCast<TcpSocketMsgBase> (m_senderSocket)->m_tcpParams->m_cnTimeout;
     }
   else if (who == RECEIVER)
     {
-      return DynamicCast<TcpSocketMsgBase> (m_receiverSocket)->m_cnTimeout;
+      return DynamicCast<TcpSocketMsgBase> (m_receiverSocket)->m_tcpParams->m_cnTimeout;
     }
   else
     {
@@ -711,11 +711,11 @@ TcpGeneralTest::GetClockGranularity (SocketWho who)
 {
   if (who == SENDER)
     {
-      return DynamicCast<TcpSocketMsgBase> (m_senderSocket)->m_clockGranularity;
+      return DynamicCast<TcpSocketMsgBase> (m_senderSocket)->m_tcpParams->m_clockGranularity;
     }
   else if (who == RECEIVER)
     {
-      return DynamicCast<TcpSocketMsgBase> (m_receiverSocket)->m_clockGranularity;
+      return DynamicCast<TcpSocketMsgBase> (m_receiverSocket)->m_tcpParams->m_clockGranularity;
     }
   else
     {
@@ -759,7 +759,7 @@ TcpGeneralTest::GetRWnd (SocketWho who)
     }
 }
 
-EventId
+const TcpTimer &
 TcpGeneralTest::GetPersistentEvent (SocketWho who)
 {
   if (who == SENDER)
@@ -782,12 +782,12 @@ TcpGeneralTest::GetPersistentTimeout (SocketWho who)
 {
   if (who == SENDER)
     {
-      return DynamicCast<TcpSocketMsgBase> (m_senderSocket)->m_persistTimeout;
+      return DynamicCast<TcpSocketMsgBase> (m_senderSocket)->m_tcpParams->m_persistTimeout;
     }
   else if (who == RECEIVER)
     {
 
-      return DynamicCast<TcpSocketMsgBase> (m_receiverSocket)->m_persistTimeout;
+      return DynamicCast<TcpSocketMsgBase> (m_receiverSocket)->m_tcpParams->m_persistTimeout;
     }
   else
     {
@@ -813,7 +813,7 @@ TcpGeneralTest::GetTcb (SocketWho who)
     }
 }
 
-Ptr<TcpRxBuffer>
+Ptr<TcpRxBuffer32>
 TcpGeneralTest::GetRxBuffer (SocketWho who)
 {
   if (who == SENDER)
@@ -912,7 +912,7 @@ TcpSocketMsgBase::GetTypeId (void)
   return tid;
 }
 
-Ptr<TcpSocketBase>
+Ptr<TcpSocketImpl>
 TcpSocketMsgBase::Fork (void)
 {
   return CopyObject<TcpSocketMsgBase> (this);
@@ -1009,80 +1009,18 @@ TcpSocketSmallAcks::GetTypeId (void)
 }
 
 /**
- * \brief Send empty packet, copied/pasted from TcpSocketBase
+ * \brief Send empty packet, acking at most m_bytesToAck bytes at a time
  *
- * The rationale for copying/pasting is that we need to edit a little the
- * code inside. Since there isn't a well-defined division of duties,
- * we are forced to do this.
+ * The header is built by TcpSocketBase, only its ack number is changed.
  */
 void
 TcpSocketSmallAcks::SendEmptyPacket (uint8_t flags)
 {
-  Ptr<Packet> p = Create<Packet> ();
   TcpHeader header;
-  SequenceNumber32 s = m_tcb->m_nextTxSequence;
-
-  /*
-   * Add tags for each socket option.
-   * Note that currently the socket adds both IPv4 tag and IPv6 tag
-   * if both options are set. Once the packet got to layer three, only
-   * the corresponding tags will be read.
-   */
-  if (GetIpTos ())
-    {
-      SocketIpTosTag ipTosTag;
-      ipTosTag.SetTos (GetIpTos ());
-      p->AddPacketTag (ipTosTag);
-    }
-
-  if (IsManualIpv6Tclass ())
-    {
-      SocketIpv6TclassTag ipTclassTag;
-      ipTclassTag.SetTclass (GetIpv6Tclass ());
-      p->AddPacketTag (ipTclassTag);
-    }
-
-  if (IsManualIpTtl ())
-    {
-      SocketIpTtlTag ipTtlTag;
-      ipTtlTag.SetTtl (GetIpTtl ());
-      p->AddPacketTag (ipTtlTag);
-    }
-
-  if (IsManualIpv6HopLimit ())
-    {
-      SocketIpv6HopLimitTag ipHopLimitTag;
-      ipHopLimitTag.SetHopLimit (GetIpv6HopLimit ());
-      p->AddPacketTag (ipHopLimitTag);
-    }
-
-  if (m_endPoint == 0 && m_endPoint6 == 0)
-    {
-      NS_LOG_WARN ("Failed to send empty packet due to null endpoint");
-      return;
-    }
-  if (flags & TcpHeader::FIN)
-    {
-      flags |= TcpHeader::ACK;
-    }
-  else if (m_state == FIN_WAIT_1 || m_state == LAST_ACK || m_state == CLOSING)
-    {
-      ++s;
-    }
-
-  bool hasSyn = flags & TcpHeader::SYN;
-  bool hasFin = flags & TcpHeader::FIN;
-  bool isAck = flags == TcpHeader::ACK;
-
-  header.SetFlags (flags);
-  header.SetSequenceNumber (s);
+  GenerateEmptyPacketHeader (header, flags);
 
   // Actual division in small acks.
-  if (hasSyn || hasFin)
-    {
-      header.SetAckNumber (m_rxBuffer->NextRxSequence ());
-    }
-  else
+  if (!(flags & (TcpHeader::SYN | TcpHeader::FIN)))
     {
       SequenceNumber32 ackSeq;
 
@@ -1105,63 +1043,7 @@ TcpSocketSmallAcks::SendEmptyPacket (uint8_t flags)
 
   // end of division in small acks
 
-  if (m_endPoint != 0)
-    {
-      header.SetSourcePort (m_endPoint->GetLocalPort ());
-      header.SetDestinationPort (m_endPoint->GetPeerPort ());
-    }
-  else
-    {
-      header.SetSourcePort (m_endPoint6->GetLocalPort ());
-      header.SetDestinationPort (m_endPoint6->GetPeerPort ());
-    }
-  AddOptions (header);
-  header.SetWindowSize (AdvertisedWindowSize ());
-
-  // RFC 6298, clause 2.4
-  m_rto = Max (m_rtt->GetEstimate () + Max (m_clockGranularity, m_rtt->GetVariation () * 4), m_minRto);
-
-  if (hasSyn)
-    {
-      if (m_synCount == 0)
-        { // No more connection retries, give up
-          NS_LOG_LOGIC ("Connection failed.");
-          m_rtt->Reset (); //According to recommendation -> RFC 6298
-          CloseAndNotify ();
-          return;
-        }
-      else
-        { // Exponential backoff of connection time out
-          int backoffCount = 0x1 << (m_synRetries - m_synCount);
-          m_rto = m_cnTimeout * backoffCount;
-          m_synCount--;
-        }
-    }
-  if (m_endPoint != 0)
-    {
-      m_tcp->SendPacket (p, header, m_endPoint->GetLocalAddress (),
-                         m_endPoint->GetPeerAddress (), m_boundnetdevice);
-    }
-  else
-    {
-      m_tcp->SendPacket (p, header, m_endPoint6->GetLocalAddress (),
-                         m_endPoint6->GetPeerAddress (), m_boundnetdevice);
-    }
-
-  m_txTrace (p, header, this);
-
-  if (flags & TcpHeader::ACK)
-    { // If sending an ACK, cancel the delay ACK as well
-      m_delAckEvent.Cancel ();
-      m_delAckCount = 0;
-    }
-  if (m_retxEvent.IsExpired () && (hasSyn || hasFin) && !isAck )
-    { // Retransmit SYN / SYN+ACK / FIN / FIN+ACK to guard against lost
-      NS_LOG_LOGIC ("Schedule retransmission timeout at time "
-                    << Simulator::Now ().GetSeconds () << " to expire at time "
-                    << (Simulator::Now () + m_rto.Get ()).GetSeconds ());
-      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketSmallAcks::SendEmptyPacket, this, flags);
-    }
+  TcpSocketMsgBase::SendEmptyPacket (header);
 
   // send another ACK if bytes remain
   if (m_bytesLeftToBeAcked > 0 && m_rxBuffer->NextRxSequence () > m_lastAckedSeq)
@@ -1170,7 +1052,7 @@ TcpSocketSmallAcks::SendEmptyPacket (uint8_t flags)
     }
 }
 
-Ptr<TcpSocketBase>
+Ptr<TcpSocketImpl>
 TcpSocketSmallAcks::Fork (void)
 {
   return CopyObject<TcpSocketSmallAcks> (this);
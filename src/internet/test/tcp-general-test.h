@@ -106,7 +106,7 @@ public:
 protected:
   virtual void ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader);
   virtual void Retransmit (void);
-  virtual Ptr<TcpSocketBase> Fork (void);
+  virtual Ptr<TcpSocketImpl> Fork (void);
   virtual void CompleteFork (Ptr<Packet> p, const TcpHeader& tcpHeader,
                              const Address& fromAddress, const Address& toAddress);
   virtual void UpdateRttHistory (const SequenceNumber32 &seq, uint32_t sz,
@@ -163,7 +163,7 @@ public:
 
 protected:
   virtual void SendEmptyPacket (uint8_t flags);
-  Ptr<TcpSocketBase> Fork (void);
+  Ptr<TcpSocketImpl> Fork (void);
 
   uint32_t m_bytesToAck;
   uint32_t m_bytesLeftToBeAcked;
@@ -473,7 +473,7 @@ protected:
    * \param who socket where get the TCB
    * \return the rx buffer
    */
-  Ptr<TcpRxBuffer> GetRxBuffer (SocketWho who);
+  Ptr<TcpRxBuffer32> GetRxBuffer (SocketWho who);
 
   /**
    * \brief Get the rWnd of the selected socket
@@ -487,9 +487,9 @@ protected:
    * \brief Get the persistent event of the selected socket
    *
    * \param who socket where check the parameter
-   * \return the persistent event in the selected socket
+   * \return the persistent timer in the selected socket
    */
-  EventId GetPersistentEvent (SocketWho who);
+  const TcpTimer &GetPersistentEvent (SocketWho who);
 
   /**
    * \brief Get the persistent timeout of the selected socket
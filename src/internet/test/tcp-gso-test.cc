@@ -0,0 +1,314 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tcp-bulk-transfer-test.h"
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/config.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+#include "ns3/abort.h"
+#include "ns3/gso-tag.h"
+#include "ns3/error-model.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/mac48-address.h"
+#include "ns3/queue-disc.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/mptcp-scheduler-fastest-rtt.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpGsoTest");
+
+/**
+ * \brief Bulk transfer in super-segments, over a device without GSO
+ *
+ * A transfer of 200 segments over one path (100Mbps, 20ms), over TCP or
+ * over MPTCP, with the "Gso" attribute of the sockets. IPv4 receives
+ * super-segments of several segments from the sockets and, since the
+ * SimpleNetDevice cannot segment them, cuts them into segments that fit
+ * in the MTU of the device. The server must receive every byte, in order.
+ */
+class TcpGsoTransferTestCase : public TcpBulkTransferTest
+{
+public:
+  TcpGsoTransferTestCase (std::string name, bool mptcp, bool gso, bool timestamps);
+
+private:
+  virtual void DoRun (void);
+  virtual void ConfigureEnvironment (void);
+  virtual void ConfigureNetwork (Ptr<Node> source, Ptr<Node> server, NetDeviceContainer devices);
+
+  void SourceSendOutgoing (const Ipv4Header &header, Ptr<const Packet> p, uint32_t interface);
+  void SourceTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  bool m_gso;
+  bool m_timestamps;
+
+  uint32_t m_superSegments;  //!< Packets from the sockets larger than a segment
+  uint32_t m_maxTxSize;      //!< Largest packet given to the device
+  uint32_t m_mtu;
+};
+
+TcpGsoTransferTestCase::TcpGsoTransferTestCase (std::string name, bool mptcp, bool gso, bool timestamps)
+  : TcpBulkTransferTest (name, mptcp),
+    m_gso (gso),
+    m_timestamps (timestamps)
+{
+  m_pathRate = "100Mbps";
+  m_pathDelay = MilliSeconds (20);
+  m_totalBytes = 200 * 1400;
+  m_stopTime = Seconds (10);
+}
+
+void
+TcpGsoTransferTestCase::ConfigureEnvironment (void)
+{
+  Config::SetDefault ("ns3::TcpSocketImpl::Timestamp", BooleanValue (m_timestamps));
+  Config::SetDefault ("ns3::TcpSocketImpl::Gso", BooleanValue (m_gso));
+  // The round robin scheduler hands one segment at a time to the subflows
+  Config::SetDefault ("ns3::MpTcpMetaSocket::Scheduler", TypeIdValue (MpTcpSchedulerFastestRTT::GetTypeId ()));
+}
+
+void
+TcpGsoTransferTestCase::ConfigureNetwork (Ptr<Node> source, Ptr<Node> server, NetDeviceContainer devices)
+{
+  m_mtu = devices.Get (0)->GetMtu ();
+  source->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("SendOutgoing",
+    MakeCallback (&TcpGsoTransferTestCase::SourceSendOutgoing, this));
+  source->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("Tx",
+    MakeCallback (&TcpGsoTransferTestCase::SourceTx, this));
+}
+
+void
+TcpGsoTransferTestCase::SourceSendOutgoing (const Ipv4Header &header, Ptr<const Packet> p, uint32_t interface)
+{
+  // TCP header of at least 20 bytes
+  if (p->GetSize () > m_writeSize + 20)
+    {
+      ++m_superSegments;
+    }
+}
+
+void
+TcpGsoTransferTestCase::SourceTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  m_maxTxSize = std::max (m_maxTxSize, p->GetSize ());
+}
+
+void
+TcpGsoTransferTestCase::DoRun (void)
+{
+  m_superSegments = 0;
+  m_maxTxSize = 0;
+
+  RunTransfer ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_rxBytes, m_totalBytes, "Server received all bytes");
+  NS_TEST_EXPECT_MSG_EQ (m_rxContentOk, true, "Server received the bytes in order");
+  NS_LOG_INFO (GetName () << ": " << m_superSegments << " super-segments");
+  if (m_gso)
+    {
+      NS_TEST_EXPECT_MSG_GT (m_superSegments, 0, "No data sent in super-segments");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_superSegments, 0, "Super-segments sent without GSO");
+    }
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (m_maxTxSize, m_mtu, "Packet larger than the MTU given to the device");
+}
+
+/**
+ * \brief SimpleNetDevice that cuts the super-segments itself, as
+ * PointToPointNetDevice does
+ */
+class TcpGsoTestNetDevice : public SimpleNetDevice
+{
+public:
+  static TypeId GetTypeId (void);
+
+  virtual bool Send (Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber);
+  virtual bool SupportsGso (void) const;
+};
+
+TypeId
+TcpGsoTestNetDevice::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpGsoTestNetDevice")
+    .SetParent<SimpleNetDevice> ()
+    .AddConstructor<TcpGsoTestNetDevice> ()
+  ;
+  return tid;
+}
+
+bool
+TcpGsoTestNetDevice::Send (Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber)
+{
+  GsoTag tag;
+  if (!packet->PeekPacketTag (tag))
+    {
+      return SimpleNetDevice::Send (packet, dest, protocolNumber);
+    }
+  std::list<Ptr<Packet> > segments;
+  NS_ABORT_MSG_UNLESS (GsoTag::Segment (packet->Copy (), protocolNumber, segments), "No segmenter");
+  bool sent = true;
+  for (std::list<Ptr<Packet> >::iterator it = segments.begin (); it != segments.end (); ++it)
+    {
+      sent = SimpleNetDevice::Send (*it, dest, protocolNumber) && sent;
+    }
+  return sent;
+}
+
+bool
+TcpGsoTestNetDevice::SupportsGso (void) const
+{
+  return true;
+}
+
+/**
+ * \brief Super-segments are cut before a queue disc limited in packets
+ *
+ * The devices of the path take super-segments, but the source has a
+ * pfifo_fast queue disc, which counts its packets. IPv4 must hand it
+ * segments that fit in the MTU, or each super-segment would take a single
+ * place of its limit.
+ */
+class TcpGsoQueueDiscTestCase : public TcpBulkTransferTest
+{
+public:
+  TcpGsoQueueDiscTestCase (std::string name, bool mptcp);
+
+private:
+  virtual void DoRun (void);
+  virtual void ConfigureEnvironment (void);
+  virtual NetDeviceContainer InstallDevices (NodeContainer nodes);
+  virtual void ConfigureNetwork (Ptr<Node> source, Ptr<Node> server, NetDeviceContainer devices);
+
+  void SourceSendOutgoing (const Ipv4Header &header, Ptr<const Packet> p, uint32_t interface);
+  void Enqueue (Ptr<const QueueItem> item);
+
+  uint32_t m_superSegments;  //!< Packets from the sockets larger than a segment
+  uint32_t m_enqueued;       //!< Packets enqueued in the queue disc
+  uint32_t m_maxQueuedSize;  //!< Largest packet enqueued, with its IPv4 header
+  uint32_t m_mtu;
+};
+
+TcpGsoQueueDiscTestCase::TcpGsoQueueDiscTestCase (std::string name, bool mptcp)
+  : TcpBulkTransferTest (name, mptcp)
+{
+  m_pathRate = "100Mbps";
+  m_pathDelay = MilliSeconds (20);
+  m_totalBytes = 200 * 1400;
+  m_stopTime = Seconds (10);
+}
+
+void
+TcpGsoQueueDiscTestCase::ConfigureEnvironment (void)
+{
+  Config::SetDefault ("ns3::TcpSocketImpl::Gso", BooleanValue (true));
+  Config::SetDefault ("ns3::MpTcpMetaSocket::Scheduler", TypeIdValue (MpTcpSchedulerFastestRTT::GetTypeId ()));
+}
+
+NetDeviceContainer
+TcpGsoQueueDiscTestCase::InstallDevices (NodeContainer nodes)
+{
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (m_pathDelay));
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      Ptr<TcpGsoTestNetDevice> device = CreateObject<TcpGsoTestNetDevice> ();
+      device->SetAttribute ("PointToPointMode", BooleanValue (true));
+      device->SetAttribute ("DataRate", DataRateValue (DataRate (m_pathRate)));
+      device->SetAddress (Mac48Address::Allocate ());
+      nodes.Get (i)->AddDevice (device);
+      device->SetChannel (channel);
+      device->SetQueue (CreateObject<DropTailQueue> ());
+      devices.Add (device);
+    }
+  return devices;
+}
+
+void
+TcpGsoQueueDiscTestCase::ConfigureNetwork (Ptr<Node> source, Ptr<Node> server, NetDeviceContainer devices)
+{
+  m_mtu = devices.Get (0)->GetMtu ();
+  TrafficControlHelper tch;
+  tch.SetRootQueueDisc ("ns3::PfifoFastQueueDisc", "Limit", UintegerValue (100));
+  Ptr<QueueDisc> queueDisc = tch.Install (devices.Get (0)).Get (0);
+  queueDisc->TraceConnectWithoutContext ("Enqueue", MakeCallback (&TcpGsoQueueDiscTestCase::Enqueue, this));
+  source->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("SendOutgoing",
+    MakeCallback (&TcpGsoQueueDiscTestCase::SourceSendOutgoing, this));
+}
+
+void
+TcpGsoQueueDiscTestCase::SourceSendOutgoing (const Ipv4Header &header, Ptr<const Packet> p, uint32_t interface)
+{
+  // TCP header of at least 20 bytes
+  if (p->GetSize () > m_writeSize + 20)
+    {
+      ++m_superSegments;
+    }
+}
+
+void
+TcpGsoQueueDiscTestCase::Enqueue (Ptr<const QueueItem> item)
+{
+  ++m_enqueued;
+  m_maxQueuedSize = std::max (m_maxQueuedSize, item->GetPacketSize ());
+}
+
+void
+TcpGsoQueueDiscTestCase::DoRun (void)
+{
+  m_superSegments = 0;
+  m_enqueued = 0;
+  m_maxQueuedSize = 0;
+
+  RunTransfer ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_rxBytes, m_totalBytes, "Server received all bytes");
+  NS_TEST_EXPECT_MSG_EQ (m_rxContentOk, true, "Server received the bytes in order");
+  NS_LOG_INFO (GetName () << ": " << m_superSegments << " super-segments, " << m_enqueued << " packets enqueued");
+  NS_TEST_EXPECT_MSG_GT (m_superSegments, 0, "No data sent in super-segments");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (m_enqueued, m_totalBytes / m_writeSize, "Fewer packets enqueued than segments");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (m_maxQueuedSize, m_mtu, "Packet larger than the MTU enqueued in the queue disc");
+}
+
+static class TcpGsoTestSuite : public TestSuite
+{
+public:
+  TcpGsoTestSuite ()
+    : TestSuite ("tcp-gso", SYSTEM)
+  {
+    AddTestCase (new TcpGsoTransferTestCase ("Segments, TCP", false, false, false), TestCase::QUICK);
+    AddTestCase (new TcpGsoTransferTestCase ("Super-segments, TCP", false, true, false), TestCase::QUICK);
+    AddTestCase (new TcpGsoTransferTestCase ("Super-segments with timestamps, TCP", false, true, true), TestCase::QUICK);
+    AddTestCase (new TcpGsoTransferTestCase ("Super-segments, MPTCP", true, true, false), TestCase::QUICK);
+    AddTestCase (new TcpGsoQueueDiscTestCase ("Super-segments before a queue disc, TCP", false), TestCase::QUICK);
+    AddTestCase (new TcpGsoQueueDiscTestCase ("Super-segments before a queue disc, MPTCP", true), TestCase::QUICK);
+  }
+
+} g_tcpGsoTestSuite;
+
+} // namespace ns3
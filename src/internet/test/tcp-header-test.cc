@@ -19,11 +19,15 @@
 
 #define __STDC_LIMIT_MACROS
 #include <stdint.h>
+#include <cstring>
 #include "ns3/test.h"
 #include "ns3/core-module.h"
 #include "ns3/tcp-header.h"
 #include "ns3/buffer.h"
 #include "../model/tcp-option-rfc793.h"
+#include "../model/tcp-option-ts.h"
+#include "../model/tcp-option-winscale.h"
+#include "ns3/tcp-option-mptcp.h"
 
 namespace ns3 {
 
@@ -381,6 +385,82 @@ TcpHeaderFlagsToString::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (str, target, "str " << str <<  " does not equal target " << target);
 }
 
+/**
+ * \brief Options read and written in place in the header
+ *
+ * The timestamp, window scale and DSS options written by the typed
+ * accessors must read back the same, after a round trip through a buffer,
+ * as TcpOption objects from GetOption.
+ */
+class TcpHeaderInPlaceOptionsTestCase : public TestCase
+{
+public:
+  TcpHeaderInPlaceOptionsTestCase (std::string name);
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpHeaderInPlaceOptionsTestCase::TcpHeaderInPlaceOptionsTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+TcpHeaderInPlaceOptionsTestCase::DoRun (void)
+{
+  TcpHeader header, dest;
+  header.AppendWindowScale (7);
+  header.AppendTimestamp (0x01020304, 0xa0b0c0d0);
+
+  MpTcpDss dss;
+  dss.SetDataAck (0x1122334455667788ULL, false);
+  dss.SetMapping (SequenceNumber64 (0x12345678), SequenceNumber32 (1000), 1400, false);
+  NS_TEST_ASSERT_MSG_EQ (dss.AppendTo (header), true, "DSS option should fit");
+  NS_TEST_ASSERT_MSG_EQ (header.GetOptionLength (), 3 + 10 + dss.GetSerializedSize (), "Options not packed");
+  NS_TEST_ASSERT_MSG_EQ (header.GetSerializedSize (), 20 + 36, "Options not padded to a word");
+
+  header.SetTimestampValue (0x05060708);
+
+  Buffer buffer;
+  buffer.AddAtStart (header.GetSerializedSize ());
+  header.Serialize (buffer.Begin ());
+  dest.Deserialize (buffer.Begin ());
+
+  uint8_t scale = 0;
+  NS_TEST_ASSERT_MSG_EQ (dest.GetWindowScale (scale), true, "Window scale option lost");
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (scale), 7, "Wrong window scale");
+  Ptr<const TcpOptionWinScale> ws = DynamicCast<const TcpOptionWinScale> (dest.GetOption (TcpOption::WINSCALE));
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (ws->GetScale ()), 7, "Window scale option differs from the typed one");
+
+  uint32_t value = 0, echo = 0;
+  NS_TEST_ASSERT_MSG_EQ (dest.GetTimestamp (value, echo), true, "Timestamp option lost");
+  NS_TEST_ASSERT_MSG_EQ (value, 0x05060708, "Timestamp value not updated in place");
+  NS_TEST_ASSERT_MSG_EQ (echo, 0xa0b0c0d0, "Wrong timestamp echo");
+  Ptr<const TcpOptionTS> ts = DynamicCast<const TcpOptionTS> (dest.GetOption (TcpOption::TS));
+  NS_TEST_ASSERT_MSG_EQ (ts->GetTimestamp (), value, "Timestamp option differs from the typed one");
+  NS_TEST_ASSERT_MSG_EQ (ts->GetEcho (), echo, "Timestamp option differs from the typed one");
+
+  MpTcpDss read;
+  NS_TEST_ASSERT_MSG_EQ (read.ReadFrom (dest), true, "DSS option lost");
+  NS_TEST_ASSERT_MSG_EQ ((read == dss), true, "DSS option changed by the round trip");
+  NS_TEST_ASSERT_MSG_EQ (read.GetDataAck (), SequenceNumber64 (0x1122334455667788ULL), "Wrong data ACK");
+  NS_TEST_ASSERT_MSG_EQ (read.GetMappingLength (), 1400, "Wrong mapping length");
+  Ptr<const TcpOptionMpTcpDSS> option = DynamicCast<const TcpOptionMpTcpDSS> (dest.GetOption (TcpOption::MPTCP));
+  NS_TEST_ASSERT_MSG_NE (option, 0, "DSS option not deserialized as a TcpOptionMpTcpDSS");
+  NS_TEST_ASSERT_MSG_EQ ((*option == dss), true, "DSS option differs from the typed one");
+
+  // The compatibility shim serializes the same bytes
+  TcpHeader shim;
+  Ptr<TcpOptionMpTcpDSS> dssOption = CreateObject<TcpOptionMpTcpDSS> ();
+  dssOption->SetDataAck (0x1122334455667788ULL, false);
+  dssOption->SetMapping (SequenceNumber64 (0x12345678), SequenceNumber32 (1000), 1400, false);
+  shim.AppendOption (dssOption);
+  const uint8_t *typed = header.FindOption (TcpOption::MPTCP);
+  const uint8_t *shimmed = shim.FindOption (TcpOption::MPTCP);
+  NS_TEST_ASSERT_MSG_EQ (std::memcmp (typed, shimmed, dss.GetSerializedSize ()), 0, "AppendOption and MpTcpDss serialize differently");
+}
+
 static class TcpHeaderTestSuite : public TestSuite
 {
 public:
@@ -390,6 +470,7 @@ public:
     AddTestCase (new TcpHeaderGetSetTestCase ("GetSet test cases"), TestCase::QUICK);
     AddTestCase (new TcpHeaderWithRFC793OptionTestCase ("Test for options in RFC 793"), TestCase::QUICK);
     AddTestCase (new TcpHeaderFlagsToString ("Test flags to string function"), TestCase::QUICK);
+    AddTestCase (new TcpHeaderInPlaceOptionsTestCase ("Test options read and written in place"), TestCase::QUICK);
   }
 
 } g_TcpHeaderTestSuite;
@@ -22,6 +22,8 @@
 #include "ns3/tcp-option.h"
 #include "ns3/private/tcp-option-winscale.h"
 #include "ns3/private/tcp-option-ts.h"
+#include "ns3/private/tcp-option-sack-permitted.h"
+#include "ns3/private/tcp-option-sack.h"
 
 #include <string.h>
 
@@ -164,6 +166,64 @@ TcpOptionTSTestCase::DoTeardown ()
 {
 }
 
+class TcpOptionSackTestCase : public TestCase
+{
+public:
+  TcpOptionSackTestCase (std::string name, uint32_t blocks);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_blocks;
+};
+
+TcpOptionSackTestCase::TcpOptionSackTestCase (std::string name, uint32_t blocks)
+  : TestCase (name),
+    m_blocks (blocks)
+{
+}
+
+void
+TcpOptionSackTestCase::DoRun ()
+{
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+
+  TcpOptionSack opt;
+  for (uint32_t i = 0; i < m_blocks; ++i)
+    {
+      SequenceNumber32 left (x->GetInteger ());
+      opt.AddSackBlock (TcpOptionSack::SackBlock (left, left + x->GetInteger (1, 100000)));
+    }
+  NS_TEST_EXPECT_MSG_EQ (opt.GetNumSackBlocks (), m_blocks, "Blocks not saved");
+  NS_TEST_EXPECT_MSG_EQ (opt.GetSerializedSize (), 2 + 8 * m_blocks, "Wrong size");
+
+  Buffer buffer;
+  buffer.AddAtStart (opt.GetSerializedSize ());
+  opt.Serialize (buffer.Begin ());
+
+  Buffer::Iterator start = buffer.Begin ();
+  NS_TEST_EXPECT_MSG_EQ (start.PeekU8 (), TcpOption::SACK, "Different kind found");
+
+  TcpOptionSack copy;
+  uint32_t read = copy.Deserialize (start);
+  NS_TEST_EXPECT_MSG_EQ (read, opt.GetSerializedSize (), "Different size read");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetNumSackBlocks (), m_blocks, "Different number of blocks");
+  for (uint32_t i = 0; i < m_blocks; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (copy.GetSackList ()[i].first, opt.GetSackList ()[i].first,
+                             "Different left edge of block " << i);
+      NS_TEST_EXPECT_MSG_EQ (copy.GetSackList ()[i].second, opt.GetSackList ()[i].second,
+                             "Different right edge of block " << i);
+    }
+
+  TcpOptionSackPermitted permitted;
+  NS_TEST_EXPECT_MSG_EQ (permitted.GetSerializedSize (), 2u, "Wrong SACK-permitted size");
+  buffer.AddAtStart (permitted.GetSerializedSize ());
+  permitted.Serialize (buffer.Begin ());
+  NS_TEST_EXPECT_MSG_EQ (buffer.Begin ().PeekU8 (), TcpOption::SACKPERMITTED, "Different kind found");
+  NS_TEST_EXPECT_MSG_EQ (permitted.Deserialize (buffer.Begin ()), 2u, "Different size read");
+}
+
 static class TcpOptionTestSuite : public TestSuite
 {
 public:
@@ -176,6 +236,10 @@ public:
                                               "scale value", i), TestCase::QUICK);
       }
     AddTestCase (new TcpOptionTSTestCase ("Testing serialization of random values for timestamp"), TestCase::QUICK);
+    for (uint32_t i = 1; i <= TcpOptionSack::MAX_BLOCKS; ++i)
+      {
+        AddTestCase (new TcpOptionSackTestCase ("Testing serialization of SACK blocks", i), TestCase::QUICK);
+      }
   }
 
 } g_TcpOptionTestSuite;
@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tcp-bulk-transfer-test.h"
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/config.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/ipv4-l3-protocol.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpPacingTest");
+
+/**
+ * \brief Spacing of the data segments, with and without pacing
+ *
+ * A bulk transfer of 200 segments over one path (100Mbps, 20ms), over TCP
+ * or over an MPTCP subflow. Once the first RTT sample is taken, a paced
+ * sender never sends two data segments at the same time, while an
+ * unpaced sender sends a burst for each ACK in slow start.
+ */
+class TcpPacingSpacingTestCase : public TcpBulkTransferTest
+{
+public:
+  TcpPacingSpacingTestCase (std::string name, bool mptcp, bool pacing);
+
+private:
+  virtual void DoRun (void);
+  virtual void ConfigureEnvironment (void);
+  virtual void ConfigureNetwork (Ptr<Node> source, Ptr<Node> server, NetDeviceContainer devices);
+
+  void SourceTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  bool m_pacing;
+
+  Time m_lastTx;
+  uint32_t m_segments;    //!< Data segments sent after the first RTT sample
+  uint32_t m_bursts;      //!< Data segments sent at the time of the previous one
+};
+
+TcpPacingSpacingTestCase::TcpPacingSpacingTestCase (std::string name, bool mptcp, bool pacing)
+  : TcpBulkTransferTest (name, mptcp),
+    m_pacing (pacing)
+{
+  m_pathRate = "100Mbps";
+  m_pathDelay = MilliSeconds (20);
+  m_totalBytes = 200 * 1400;
+  m_stopTime = Seconds (10);
+}
+
+void
+TcpPacingSpacingTestCase::ConfigureEnvironment (void)
+{
+  Config::SetDefault ("ns3::TcpSocketImpl::Pacing", BooleanValue (m_pacing));
+}
+
+void
+TcpPacingSpacingTestCase::ConfigureNetwork (Ptr<Node> source, Ptr<Node> server, NetDeviceContainer devices)
+{
+  source->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("Tx",
+    MakeCallback (&TcpPacingSpacingTestCase::SourceTx, this));
+}
+
+void
+TcpPacingSpacingTestCase::SourceTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  // Data segments only, once the first data segment is acknowledged
+  if (p->GetSize () < m_writeSize || Simulator::Now () < MilliSeconds (150))
+    {
+      return;
+    }
+  ++m_segments;
+  if (Simulator::Now () == m_lastTx)
+    {
+      ++m_bursts;
+    }
+  m_lastTx = Simulator::Now ();
+}
+
+void
+TcpPacingSpacingTestCase::DoRun (void)
+{
+  m_segments = 0;
+  m_bursts = 0;
+
+  RunTransfer ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_rxBytes, m_totalBytes, "Server received all bytes");
+  NS_TEST_EXPECT_MSG_EQ (m_rxContentOk, true, "Server received the bytes in order");
+  NS_LOG_INFO (GetName () << ": " << m_bursts << " of " << m_segments << " segments sent with the previous one");
+  NS_TEST_ASSERT_MSG_GT (m_segments, 100, "Transfer over before the first RTT sample");
+  if (m_pacing)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_bursts, 0, "Paced segments sent in a burst");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_GT (m_bursts, 0, "Unpaced segments should be sent in bursts");
+    }
+}
+
+static class TcpPacingTestSuite : public TestSuite
+{
+public:
+  TcpPacingTestSuite ()
+    : TestSuite ("tcp-pacing", SYSTEM)
+  {
+    AddTestCase (new TcpPacingSpacingTestCase ("Segments in bursts, TCP", false, false), TestCase::QUICK);
+    AddTestCase (new TcpPacingSpacingTestCase ("Paced segments, TCP", false, true), TestCase::QUICK);
+    AddTestCase (new TcpPacingSpacingTestCase ("Paced segments, MPTCP subflow", true, true), TestCase::QUICK);
+  }
+
+} g_tcpPacingTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,306 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of Sussex
+ * Copyright (c) 2015 Université Pierre et Marie Curie (UPMC)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/boolean.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-rx-buffer.h"
+
+namespace ns3 {
+
+/**
+ * \brief Checks the reassembly of TcpRxBuffer: holes, overlaps and content
+ *
+ * Segments carry the low byte of their sequence numbers, so that the
+ * extracted data tells whether the bytes were reassembled in order.
+ */
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+class TcpRxBufferTestCase : public TestCase
+{
+public:
+  typedef TcpRxBuffer<NUMERIC_TYPE, SIGNED_TYPE> Buffer;
+  typedef SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> Seq;
+
+  TcpRxBufferTestCase (std::string name, NUMERIC_TYPE isn);
+
+private:
+  virtual void DoRun (void);
+
+  void TestInOrder (void);
+  void TestOutOfOrder (void);
+  void TestOverlap (void);
+  void TestWindow (void);
+  void TestVirtualPayload (void);
+  void TestManySegments (void);
+
+  /// Segment [from, from + len) of the stream
+  Ptr<Packet> MakeSegment (Seq from, uint32_t len) const;
+  /// Check that p holds the stream bytes starting at from
+  bool CheckContent (Ptr<Packet> p, Seq from) const;
+
+  NUMERIC_TYPE m_isn;
+};
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+TcpRxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::TcpRxBufferTestCase (std::string name, NUMERIC_TYPE isn)
+  : TestCase (name),
+    m_isn (isn)
+{
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+Ptr<Packet>
+TcpRxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::MakeSegment (Seq from, uint32_t len) const
+{
+  std::vector<uint8_t> data (len);
+  for (uint32_t i = 0; i < len; ++i)
+    {
+      data[i] = static_cast<uint8_t> ((from + Seq (i)).GetValue ());
+    }
+  return Create<Packet> (len ? &data[0] : 0, len);
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+bool
+TcpRxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::CheckContent (Ptr<Packet> p, Seq from) const
+{
+  std::vector<uint8_t> data (p->GetSize ());
+  p->CopyData (&data[0], data.size ());
+  for (uint32_t i = 0; i < data.size (); ++i)
+    {
+      if (data[i] != static_cast<uint8_t> ((from + Seq (i)).GetValue ()))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpRxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::TestInOrder (void)
+{
+  Ptr<Buffer> buffer = CreateObject<Buffer> (m_isn);
+  buffer->SetMaxBufferSize (100000);
+  Seq isn (m_isn);
+
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (buffer->Add (MakeSegment (isn + Seq (i * 500), 500), isn + Seq (i * 500)), true, "Segment not added");
+    }
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 5000u, "Wrong occupancy");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Available (), 5000u, "Wrong available bytes");
+  NS_TEST_ASSERT_MSG_EQ (buffer->NextRxSequence (), isn + Seq (5000), "Wrong next sequence");
+
+  // Within a segment, across segments, then the remainder
+  Ptr<Packet> p = buffer->Extract (200);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 200u, "Wrong extracted size");
+  NS_TEST_ASSERT_MSG_EQ (CheckContent (p, isn), true, "Wrong content");
+  p = buffer->Extract (1800);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1800u, "Wrong extracted size");
+  NS_TEST_ASSERT_MSG_EQ (CheckContent (p, isn + Seq (200)), true, "Wrong content");
+  NS_TEST_ASSERT_MSG_EQ (buffer->HeadSequence (), isn + Seq (2000), "Wrong head sequence");
+  p = buffer->Extract (10000);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 3000u, "Wrong extracted size");
+  NS_TEST_ASSERT_MSG_EQ (CheckContent (p, isn + Seq (2000)), true, "Wrong content");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 0u, "Buffer should be empty");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Extract (100), 0, "Nothing left to extract");
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpRxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::TestOutOfOrder (void)
+{
+  Ptr<Buffer> buffer = CreateObject<Buffer> (m_isn);
+  buffer->SetMaxBufferSize (100000);
+  Seq isn (m_isn);
+  std::vector<std::pair<Seq, Seq> > blocks;
+
+  // Two blocks beyond a hole at the head
+  buffer->Add (MakeSegment (isn + Seq (1000), 500), isn + Seq (1000));
+  buffer->Add (MakeSegment (isn + Seq (3000), 500), isn + Seq (3000));
+  buffer->Add (MakeSegment (isn + Seq (1500), 500), isn + Seq (1500));
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 1500u, "Wrong occupancy");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Available (), 0u, "Data beyond a hole is not available");
+  NS_TEST_ASSERT_MSG_EQ (buffer->NextRxSequence (), isn, "Next sequence should not move");
+  NS_TEST_ASSERT_MSG_EQ (buffer->GetOutOfOrderBlocks (blocks), 2u, "Wrong number of blocks");
+  NS_TEST_ASSERT_MSG_EQ (blocks[0].first, isn + Seq (1000), "Wrong block head");
+  NS_TEST_ASSERT_MSG_EQ (blocks[0].second, isn + Seq (2000), "Wrong block tail");
+  NS_TEST_ASSERT_MSG_EQ (blocks[1].first, isn + Seq (3000), "Wrong block head");
+  NS_TEST_ASSERT_MSG_EQ (blocks[1].second, isn + Seq (3500), "Wrong block tail");
+
+  // Filling the head hole makes the first block available
+  buffer->Add (MakeSegment (isn, 1000), isn);
+  NS_TEST_ASSERT_MSG_EQ (buffer->Available (), 2000u, "Wrong available bytes");
+  NS_TEST_ASSERT_MSG_EQ (buffer->NextRxSequence (), isn + Seq (2000), "Wrong next sequence");
+  NS_TEST_ASSERT_MSG_EQ (buffer->GetOutOfOrderBlocks (blocks), 1u, "Wrong number of blocks");
+
+  // Filling the last hole merges everything
+  buffer->Add (MakeSegment (isn + Seq (2000), 1000), isn + Seq (2000));
+  NS_TEST_ASSERT_MSG_EQ (buffer->Available (), 3500u, "Wrong available bytes");
+  NS_TEST_ASSERT_MSG_EQ (buffer->GetOutOfOrderBlocks (blocks), 0u, "There should be no hole left");
+  Ptr<Packet> p = buffer->Extract (3500);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 3500u, "Wrong extracted size");
+  NS_TEST_ASSERT_MSG_EQ (CheckContent (p, isn), true, "Wrong content");
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpRxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::TestOverlap (void)
+{
+  Ptr<Buffer> buffer = CreateObject<Buffer> (m_isn);
+  buffer->SetMaxBufferSize (100000);
+  Seq isn (m_isn);
+  std::vector<std::pair<Seq, Seq> > blocks;
+
+  buffer->Add (MakeSegment (isn + Seq (100), 100), isn + Seq (100));
+  buffer->Add (MakeSegment (isn + Seq (300), 100), isn + Seq (300));
+  buffer->Add (MakeSegment (isn + Seq (500), 100), isn + Seq (500));
+  // Duplicates are refused
+  NS_TEST_ASSERT_MSG_EQ (buffer->Add (MakeSegment (isn + Seq (320), 50), isn + Seq (320)), false, "Duplicate accepted");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 300u, "Wrong occupancy");
+
+  // Covers three blocks and the holes around them
+  NS_TEST_ASSERT_MSG_EQ (buffer->Add (MakeSegment (isn + Seq (50), 600), isn + Seq (50)), true, "Segment not added");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 600u, "Only the holes should be stored");
+  NS_TEST_ASSERT_MSG_EQ (buffer->GetOutOfOrderBlocks (blocks), 1u, "Wrong number of blocks");
+  NS_TEST_ASSERT_MSG_EQ (blocks[0].first, isn + Seq (50), "Wrong block head");
+  NS_TEST_ASSERT_MSG_EQ (blocks[0].second, isn + Seq (650), "Wrong block tail");
+
+  // Overlaps the head, is trimmed to the next expected sequence
+  buffer->Add (MakeSegment (isn, 100), isn);
+  NS_TEST_ASSERT_MSG_EQ (buffer->Available (), 650u, "Wrong available bytes");
+  Ptr<Packet> p = buffer->Extract (400);
+  NS_TEST_ASSERT_MSG_EQ (CheckContent (p, isn), true, "Wrong content");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Add (MakeSegment (isn + Seq (200), 600), isn + Seq (200)), true, "Segment not added");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Available (), 400u, "Wrong available bytes");
+  p = buffer->Extract (1000);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 400u, "Wrong extracted size");
+  NS_TEST_ASSERT_MSG_EQ (CheckContent (p, isn + Seq (400)), true, "Wrong content");
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpRxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::TestWindow (void)
+{
+  Ptr<Buffer> buffer = CreateObject<Buffer> (m_isn);
+  buffer->SetMaxBufferSize (1000);
+  Seq isn (m_isn);
+
+  buffer->Add (MakeSegment (isn, 500), isn);
+  // Beyond the window: trimmed to MaxRxSequence
+  NS_TEST_ASSERT_MSG_EQ (buffer->Add (MakeSegment (isn + Seq (800), 500), isn + Seq (800)), true, "Segment not added");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 700u, "Segment not trimmed to the window");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Add (MakeSegment (isn + Seq (1000), 100), isn + Seq (1000)), false, "Segment out of window accepted");
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpRxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::TestVirtualPayload (void)
+{
+  Ptr<Buffer> buffer = CreateObject<Buffer> (m_isn);
+  buffer->SetAttribute ("VirtualPayload", BooleanValue (true));
+  buffer->SetMaxBufferSize (100000);
+  Seq isn (m_isn);
+  std::vector<std::pair<Seq, Seq> > blocks;
+
+  buffer->Add (MakeSegment (isn + Seq (1000), 1000), isn + Seq (1000));
+  buffer->Add (MakeSegment (isn + Seq (1500), 1000), isn + Seq (1500));
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 1500u, "Wrong occupancy");
+  NS_TEST_ASSERT_MSG_EQ (buffer->GetOutOfOrderBlocks (blocks), 1u, "Wrong number of blocks");
+  buffer->Add (MakeSegment (isn, 1000), isn);
+  NS_TEST_ASSERT_MSG_EQ (buffer->Available (), 2500u, "Wrong available bytes");
+
+  Ptr<Packet> p = buffer->Extract (700);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 700u, "Wrong extracted size");
+  NS_TEST_ASSERT_MSG_EQ (buffer->HeadSequence (), isn + Seq (700), "Wrong head sequence");
+  p = buffer->Extract (5000);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1800u, "Wrong extracted size");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 0u, "Buffer should be empty");
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpRxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::TestManySegments (void)
+{
+  // Storing a segment or merging blocks must not copy the bytes already
+  // stored: when they did, this test took seconds instead of milliseconds
+  const uint32_t segments = 4000;
+  const uint32_t segmentSize = 1460;
+  Ptr<Buffer> buffer = CreateObject<Buffer> (m_isn);
+  buffer->SetMaxBufferSize (segments * segmentSize);
+  Seq isn (m_isn);
+  std::vector<std::pair<Seq, Seq> > blocks;
+
+  // The odd segments leave a hole before each of them, the even ones fill them
+  for (uint32_t i = 1; i < segments; i += 2)
+    {
+      buffer->Add (MakeSegment (isn + Seq (i * segmentSize), segmentSize), isn + Seq (i * segmentSize));
+    }
+  NS_TEST_ASSERT_MSG_EQ (buffer->GetOutOfOrderBlocks (blocks), segments / 2, "Wrong number of blocks");
+  for (uint32_t i = 0; i < segments; i += 2)
+    {
+      buffer->Add (MakeSegment (isn + Seq (i * segmentSize), segmentSize), isn + Seq (i * segmentSize));
+    }
+  NS_TEST_ASSERT_MSG_EQ (buffer->GetOutOfOrderBlocks (blocks), 0u, "There should be no hole left");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Available (), segments * segmentSize, "Wrong available bytes");
+
+  // Reads across segments, then the rest at once
+  uint32_t half = segments * segmentSize / 2;
+  uint32_t read = 0;
+  while (read < half)
+    {
+      Ptr<Packet> p = buffer->Extract (std::min (10000u, half - read));
+      NS_TEST_ASSERT_MSG_EQ (CheckContent (p, isn + Seq (read)), true, "Wrong content");
+      read += p->GetSize ();
+    }
+  Ptr<Packet> p = buffer->Extract (segments * segmentSize);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), segments * segmentSize - half, "Wrong extracted size");
+  NS_TEST_ASSERT_MSG_EQ (CheckContent (p, isn + Seq (half)), true, "Wrong content");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 0u, "Buffer should be empty");
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpRxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::DoRun (void)
+{
+  TestInOrder ();
+  TestOutOfOrder ();
+  TestOverlap ();
+  TestWindow ();
+  TestVirtualPayload ();
+  TestManySegments ();
+}
+
+static class TcpRxBufferTestSuite : public TestSuite
+{
+public:
+  TcpRxBufferTestSuite ()
+    : TestSuite ("tcp-rx-buffer", UNIT)
+  {
+    AddTestCase (new TcpRxBufferTestCase<uint32_t, int32_t> ("TcpRxBuffer32", 1), TestCase::QUICK);
+    AddTestCase (new TcpRxBufferTestCase<uint32_t, int32_t> ("TcpRxBuffer32 wrapping", 0xFFFFFE00), TestCase::QUICK);
+    AddTestCase (new TcpRxBufferTestCase<uint64_t, int64_t> ("TcpRxBuffer64", 1), TestCase::QUICK);
+  }
+
+} g_tcpRxBufferTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,281 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tcp-bulk-transfer-test.h"
+#include "tcp-error-model.h"
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/config.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/pointer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpSackTest");
+
+/**
+ * \brief Drops the first transmission of consecutive data segments
+ *
+ * The segments are counted in the order of their first transmission, so
+ * that the burst does not depend on the initial sequence number, and the
+ * retransmissions always get through.
+ */
+class TcpBurstErrorModel : public TcpGeneralErrorModel
+{
+public:
+  static TypeId GetTypeId (void);
+  TcpBurstErrorModel ();
+
+  /**
+   * \brief Set the segments to drop
+   * \param first Index of the first segment dropped, from 0
+   * \param length Number of segments dropped
+   */
+  void SetBurst (uint32_t first, uint32_t length);
+
+  /// \return the time of the first drop
+  Time GetFirstDropTime (void) const;
+  /// \return the offset of the byte following the last segment dropped
+  uint32_t GetBurstEnd (void) const;
+  /// \return the number of segments dropped
+  uint32_t GetDropped (void) const;
+
+protected:
+  virtual bool ShouldDrop (const Ipv4Header &ipHeader, const TcpHeader &tcpHeader,
+                           uint32_t packetSize);
+
+private:
+  virtual void DoReset (void);
+
+  uint32_t m_first;
+  uint32_t m_length;
+  uint32_t m_segments;
+  uint32_t m_dropped;
+  bool m_started;
+  SequenceNumber32 m_firstSeq;
+  SequenceNumber32 m_highSeq;
+  Time m_firstDrop;
+  uint32_t m_burstEnd;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (TcpBurstErrorModel);
+
+TypeId
+TcpBurstErrorModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpBurstErrorModel")
+    .SetParent<TcpGeneralErrorModel> ()
+    .AddConstructor<TcpBurstErrorModel> ()
+  ;
+  return tid;
+}
+
+TcpBurstErrorModel::TcpBurstErrorModel ()
+  : TcpGeneralErrorModel (),
+    m_first (0),
+    m_length (0)
+{
+  DoReset ();
+}
+
+void
+TcpBurstErrorModel::SetBurst (uint32_t first, uint32_t length)
+{
+  m_first = first;
+  m_length = length;
+}
+
+Time
+TcpBurstErrorModel::GetFirstDropTime (void) const
+{
+  return m_firstDrop;
+}
+
+uint32_t
+TcpBurstErrorModel::GetBurstEnd (void) const
+{
+  return m_burstEnd;
+}
+
+uint32_t
+TcpBurstErrorModel::GetDropped (void) const
+{
+  return m_dropped;
+}
+
+bool
+TcpBurstErrorModel::ShouldDrop (const Ipv4Header &ipHeader, const TcpHeader &tcpHeader,
+                                uint32_t packetSize)
+{
+  if (packetSize == 0)
+    {
+      return false;
+    }
+  SequenceNumber32 seq = tcpHeader.GetSequenceNumber ();
+  if (!m_started)
+    {
+      m_started = true;
+      m_firstSeq = seq;
+      m_highSeq = seq;
+    }
+  if (seq < m_highSeq)
+    { // A retransmission
+      return false;
+    }
+  m_highSeq = seq + packetSize;
+  uint32_t segment = m_segments++;
+  if (segment < m_first || segment >= m_first + m_length)
+    {
+      return false;
+    }
+  if (m_dropped == 0)
+    {
+      m_firstDrop = Simulator::Now ();
+    }
+  ++m_dropped;
+  m_burstEnd = m_highSeq - m_firstSeq;
+  NS_LOG_INFO ("Dropping segment " << segment << " at " << seq);
+  return true;
+}
+
+void
+TcpBurstErrorModel::DoReset (void)
+{
+  m_segments = 0;
+  m_dropped = 0;
+  m_started = false;
+  m_burstEnd = 0;
+}
+
+/**
+ * \brief Recovery from a burst of losses, with and without SACK and RACK-TLP
+ *
+ * A bulk transfer of 300 segments over one path (10Mbps, 20ms), of which
+ * a burst of consecutive segments is dropped once. Measures the recovery
+ * time, from the first drop to the delivery of the last segment of the
+ * burst to the receiving application, over TCP or over an MPTCP subflow.
+ */
+class TcpSackRecoveryTestCase : public TcpBulkTransferTest
+{
+public:
+  TcpSackRecoveryTestCase (std::string name, bool mptcp, bool sack, bool rack,
+                           uint32_t burstFirst, uint32_t burstLength, Time maxRecovery);
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  virtual void ConfigureEnvironment (void);
+  virtual void ConfigureNetwork (Ptr<Node> source, Ptr<Node> server, NetDeviceContainer devices);
+  virtual void DataDelivered (void);
+
+  bool m_sack;
+  bool m_rack;
+  uint32_t m_burstFirst;
+  uint32_t m_burstLength;
+  Time m_maxRecovery;
+
+  Time m_recovered;
+  Ptr<TcpBurstErrorModel> m_errorModel;
+};
+
+TcpSackRecoveryTestCase::TcpSackRecoveryTestCase (std::string name, bool mptcp, bool sack, bool rack,
+                                                  uint32_t burstFirst, uint32_t burstLength,
+                                                  Time maxRecovery)
+  : TcpBulkTransferTest (name, mptcp),
+    m_sack (sack),
+    m_rack (rack),
+    m_burstFirst (burstFirst),
+    m_burstLength (burstLength),
+    m_maxRecovery (maxRecovery)
+{
+  m_pathRate = "10Mbps";
+  m_pathDelay = MilliSeconds (20);
+  m_totalBytes = 300 * 1400;
+}
+
+void
+TcpSackRecoveryTestCase::ConfigureEnvironment (void)
+{
+  Config::SetDefault ("ns3::TcpSocketImpl::Sack", BooleanValue (m_sack));
+  Config::SetDefault ("ns3::TcpSocketImpl::Rack", BooleanValue (m_rack));
+}
+
+void
+TcpSackRecoveryTestCase::ConfigureNetwork (Ptr<Node> source, Ptr<Node> server, NetDeviceContainer devices)
+{
+  m_errorModel = CreateObject<TcpBurstErrorModel> ();
+  m_errorModel->SetBurst (m_burstFirst, m_burstLength);
+  devices.Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (m_errorModel));
+}
+
+void
+TcpSackRecoveryTestCase::DataDelivered (void)
+{
+  if (m_recovered.IsZero () && m_errorModel->GetDropped () == m_burstLength
+      && m_rxBytes >= m_errorModel->GetBurstEnd ())
+    {
+      m_recovered = Simulator::Now ();
+    }
+}
+
+void
+TcpSackRecoveryTestCase::DoRun (void)
+{
+  m_recovered = Seconds (0);
+
+  RunTransfer ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_rxBytes, m_totalBytes, "Server received all bytes");
+  NS_TEST_EXPECT_MSG_EQ (m_rxContentOk, true, "Server received the bytes in order");
+  NS_TEST_ASSERT_MSG_EQ (m_errorModel->GetDropped (), m_burstLength, "Burst not dropped");
+
+  Time recovery = m_recovered - m_errorModel->GetFirstDropTime ();
+  NS_LOG_INFO (GetName () << ": recovered in " << recovery.GetMilliSeconds ()
+               << " ms, completed at " << m_completion.GetSeconds () << " s");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (recovery, m_maxRecovery, "Recovery from the burst took too long");
+}
+
+void
+TcpSackRecoveryTestCase::DoTeardown (void)
+{
+  m_errorModel = 0;
+  TcpBulkTransferTest::DoTeardown ();
+}
+
+static class TcpSackTestSuite : public TestSuite
+{
+public:
+  TcpSackTestSuite ()
+    : TestSuite ("tcp-sack", SYSTEM)
+  {
+    // Bounds on the recovery time, with some slack over the values measured
+    // when SACK and RACK-TLP were added. NewReno repairs one hole per round
+    // trip, SACK repairs the whole burst in one. Without a loss probe, the
+    // loss of the last segments waits for the retransmission timeout
+    AddTestCase (new TcpSackRecoveryTestCase ("Burst of 6 losses, NewReno", false, false, false, 100, 6, MilliSeconds (300)), TestCase::QUICK);
+    AddTestCase (new TcpSackRecoveryTestCase ("Burst of 6 losses, SACK", false, true, false, 100, 6, MilliSeconds (100)), TestCase::QUICK);
+    AddTestCase (new TcpSackRecoveryTestCase ("Burst of 6 losses, SACK and RACK-TLP", false, true, true, 100, 6, MilliSeconds (100)), TestCase::QUICK);
+    AddTestCase (new TcpSackRecoveryTestCase ("Tail loss, SACK", false, true, false, 297, 3, MilliSeconds (1500)), TestCase::QUICK);
+    AddTestCase (new TcpSackRecoveryTestCase ("Tail loss, SACK and RACK-TLP", false, true, true, 297, 3, MilliSeconds (250)), TestCase::QUICK);
+    AddTestCase (new TcpSackRecoveryTestCase ("Burst of 6 losses on an MPTCP subflow", true, false, false, 100, 6, MilliSeconds (300)), TestCase::QUICK);
+    AddTestCase (new TcpSackRecoveryTestCase ("Burst of 6 losses on an MPTCP subflow, SACK and RACK-TLP", true, true, true, 100, 6, MilliSeconds (100)), TestCase::QUICK);
+  }
+
+} g_tcpSackTestSuite;
+
+} // namespace ns3
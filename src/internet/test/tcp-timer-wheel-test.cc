@@ -0,0 +1,217 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <vector>
+#include "mptcp-general-test.h"
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/config.h"
+#include "ns3/simulator.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "../model/tcp-timer-wheel.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpTimerWheelTest");
+
+/**
+ * \brief Expiration of the timers run by a TcpTimerWheel
+ *
+ * Timers on every level of the wheel must expire in order, on the first tick
+ * at or after their expiration time. Timers re-armed, cancelled or re-armed
+ * from their own expiration must expire once, at their last expiration time.
+ */
+class TcpTimerWheelTestCase : public TestCase
+{
+public:
+  TcpTimerWheelTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  void Arm (uint32_t timer, Time delay);
+  void Cancel (uint32_t timer);
+  void Expire (uint32_t timer);
+  void Periodic (void);
+
+  static const uint32_t N_TIMERS = 8;
+
+  Ptr<TcpTimerWheel> m_wheel;
+  TcpTimer m_timers[N_TIMERS];
+  Time m_expected[N_TIMERS];        //!< Last expiration time the timers were armed for
+  std::vector<uint32_t> m_expired;  //!< Timers in their order of expiration
+  uint32_t m_periods;               //!< Expirations of the periodic timer
+};
+
+TcpTimerWheelTestCase::TcpTimerWheelTestCase ()
+  : TestCase ("Timer wheel expirations")
+{
+}
+
+void
+TcpTimerWheelTestCase::Arm (uint32_t timer, Time delay)
+{
+  m_expected[timer] = Simulator::Now () + delay;
+  m_timers[timer].Schedule (delay, &TcpTimerWheelTestCase::Expire, this, timer);
+}
+
+void
+TcpTimerWheelTestCase::Cancel (uint32_t timer)
+{
+  m_timers[timer].Cancel ();
+  NS_TEST_EXPECT_MSG_EQ (m_timers[timer].IsRunning (), false, "Cancelled timer still running");
+}
+
+void
+TcpTimerWheelTestCase::Expire (uint32_t timer)
+{
+  Time now = Simulator::Now ();
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (now, m_expected[timer], "Timer " << timer << " expired early");
+  NS_TEST_EXPECT_MSG_LT (now, m_expected[timer] + m_wheel->GetGranularity (), "Timer " << timer << " expired late");
+  NS_TEST_EXPECT_MSG_EQ (m_timers[timer].IsExpired (), true, "Expired timer still running");
+  m_expired.push_back (timer);
+}
+
+void
+TcpTimerWheelTestCase::Periodic (void)
+{
+  if (++m_periods < 10)
+    {
+      m_timers[N_TIMERS - 1].Schedule (MilliSeconds (7), &TcpTimerWheelTestCase::Periodic, this);
+    }
+}
+
+void
+TcpTimerWheelTestCase::DoRun (void)
+{
+  m_periods = 0;
+  m_wheel = CreateObject<TcpTimerWheel> ();
+  m_wheel->SetGranularity (MilliSeconds (1));
+  for (uint32_t i = 0; i < N_TIMERS; ++i)
+    {
+      m_timers[i].SetWheel (m_wheel);
+    }
+
+  // One timer per level, plus one beyond the range of the wheel
+  Arm (4, Seconds (20000));
+  Arm (3, Seconds (300));
+  Arm (2, MicroSeconds (5000500));
+  Arm (1, MilliSeconds (70));
+  Arm (0, MicroSeconds (500));
+  NS_TEST_ASSERT_MSG_EQ (m_timers[0].GetDelayLeft (), MicroSeconds (500), "Wrong delay left");
+
+  // Pushed back lazily, then cancelled
+  Arm (5, MilliSeconds (10));
+  Simulator::Schedule (MilliSeconds (5), &TcpTimerWheelTestCase::Arm, this, 5, MilliSeconds (150));
+  Simulator::Schedule (MilliSeconds (100), &TcpTimerWheelTestCase::Cancel, this, 5);
+  // Brought forward, from a level 1 slot to a level 0 one
+  Arm (6, MilliSeconds (200));
+  Simulator::Schedule (MicroSeconds (2500), &TcpTimerWheelTestCase::Arm, this, 6, MilliSeconds (30));
+  // Re-armed from its own expiration
+  m_timers[N_TIMERS - 1].Schedule (MilliSeconds (7), &TcpTimerWheelTestCase::Periodic, this);
+
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_expired.size (), 6u, "Wrong number of expirations");
+  NS_TEST_EXPECT_MSG_EQ (m_expired[0], 0u, "Wrong expiration order");
+  NS_TEST_EXPECT_MSG_EQ (m_expired[1], 6u, "Wrong expiration order");
+  NS_TEST_EXPECT_MSG_EQ (m_expired[2], 1u, "Wrong expiration order");
+  NS_TEST_EXPECT_MSG_EQ (m_expired[3], 2u, "Wrong expiration order");
+  NS_TEST_EXPECT_MSG_EQ (m_expired[4], 3u, "Wrong expiration order");
+  NS_TEST_EXPECT_MSG_EQ (m_expired[5], 4u, "Wrong expiration order");
+  NS_TEST_EXPECT_MSG_EQ (m_periods, 10u, "Wrong number of periodic expirations");
+  NS_TEST_EXPECT_MSG_EQ (m_wheel->GetNExpirations (), 16u, "Wrong number of expirations");
+
+  // An RTO pushed back on every ACK only costs the simulator its wake-ups
+  uint64_t events = m_wheel->GetNEventsScheduled ();
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      Simulator::Schedule (MilliSeconds (i), &TcpTimerWheelTestCase::Arm, this, 0, MilliSeconds (200));
+    }
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_expired.size (), 7u, "Wrong number of expirations");
+  NS_TEST_EXPECT_MSG_LT (m_wheel->GetNEventsScheduled () - events, 50u, "Too many simulator events");
+}
+
+void
+TcpTimerWheelTestCase::DoTeardown (void)
+{
+  m_wheel->Dispose ();
+  m_wheel = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief MPTCP bulk transfer with the TCP timers on a timer wheel
+ *
+ * The transfer has to complete with the meta socket and subflow timers run
+ * by the timer wheels of the nodes.
+ */
+class TcpTimerWheelTransferTestCase : public MpTcpGeneralTest
+{
+public:
+  TcpTimerWheelTransferTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void ConfigureEnvironment (void);
+};
+
+TcpTimerWheelTransferTestCase::TcpTimerWheelTransferTestCase ()
+  : MpTcpGeneralTest ("MPTCP bulk transfer with the timers on a wheel")
+{
+  m_secondPathRate = "5Mbps";
+  m_secondPathDelay = MilliSeconds (30);
+  m_totalBytes = 500000;
+}
+
+void
+TcpTimerWheelTransferTestCase::ConfigureEnvironment (void)
+{
+  Config::SetDefault ("ns3::TcpL4Protocol::TimerWheelGranularity", TimeValue (MilliSeconds (1)));
+}
+
+void
+TcpTimerWheelTransferTestCase::DoRun (void)
+{
+  RunTransfer ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_rxBytes, m_totalBytes, "Server received all bytes");
+  NS_TEST_EXPECT_MSG_EQ (m_rxContentOk, true, "Server received the bytes in order");
+  Ptr<Node> nodes[] = { m_source->GetNode (), m_server->GetNode () };
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<TcpTimerWheel> wheel = nodes[i]->GetObject<TcpL4Protocol> ()->GetTimerWheel ();
+      NS_TEST_ASSERT_MSG_NE (wheel, 0, "No timer wheel");
+      NS_TEST_EXPECT_MSG_GT (wheel->GetNEventsScheduled (), 0u, "Timers not run by the wheel");
+    }
+}
+
+static class TcpTimerWheelTestSuite : public TestSuite
+{
+public:
+  TcpTimerWheelTestSuite ()
+    : TestSuite ("tcp-timer-wheel", UNIT)
+  {
+    AddTestCase (new TcpTimerWheelTestCase (), TestCase::QUICK);
+    AddTestCase (new TcpTimerWheelTransferTestCase (), TestCase::QUICK);
+  }
+
+} g_tcpTimerWheelTestSuite;
+
+} // namespace ns3
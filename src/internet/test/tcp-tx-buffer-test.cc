@@ -0,0 +1,320 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of Sussex
+ * Copyright (c) 2015 Université Pierre et Marie Curie (UPMC)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/boolean.h"
+#include "ns3/tcp-tx-buffer.h"
+
+namespace ns3 {
+
+/**
+ * \brief Checks that the list and ring storages of TcpTxBuffer hand out
+ * the same segments
+ *
+ * The application writes carry the low byte of their sequence numbers, so
+ * that the content of a segment tells where it was taken from.
+ */
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+class TcpTxBufferTestCase : public TestCase
+{
+public:
+  typedef TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE> Buffer;
+  typedef SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> Seq;
+
+  TcpTxBufferTestCase (std::string name, NUMERIC_TYPE isn);
+
+private:
+  virtual void DoRun (void);
+
+  void TestSegments (bool useRing);
+  void TestInterleaved (void);
+  void TestVirtualPayload (void);
+  void TestScoreboard (void);
+
+  Ptr<Buffer> CreateBuffer (bool useRing) const;
+  /// Application write of the stream bytes [from, from + len)
+  Ptr<Packet> MakeWrite (Seq from, uint32_t len) const;
+  /// Check that p holds the stream bytes starting at from
+  bool CheckContent (Ptr<Packet> p, Seq from) const;
+
+  NUMERIC_TYPE m_isn;
+};
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+TcpTxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::TcpTxBufferTestCase (std::string name, NUMERIC_TYPE isn)
+  : TestCase (name),
+    m_isn (isn)
+{
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+Ptr<TcpTxBuffer<NUMERIC_TYPE, SIGNED_TYPE> >
+TcpTxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::CreateBuffer (bool useRing) const
+{
+  Ptr<Buffer> buffer = CreateObject<Buffer> (m_isn);
+  buffer->SetAttribute ("UseRing", BooleanValue (useRing));
+  buffer->SetMaxBufferSize (1 << 20);
+  return buffer;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+Ptr<Packet>
+TcpTxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::MakeWrite (Seq from, uint32_t len) const
+{
+  std::vector<uint8_t> data (len);
+  for (uint32_t i = 0; i < len; ++i)
+    {
+      data[i] = static_cast<uint8_t> ((from + Seq (i)).GetValue ());
+    }
+  return Create<Packet> (&data[0], len);
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+bool
+TcpTxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::CheckContent (Ptr<Packet> p, Seq from) const
+{
+  std::vector<uint8_t> data (p->GetSize ());
+  p->CopyData (&data[0], data.size ());
+  for (uint32_t i = 0; i < data.size (); ++i)
+    {
+      if (data[i] != static_cast<uint8_t> ((from + Seq (i)).GetValue ()))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::TestSegments (bool useRing)
+{
+  Ptr<Buffer> buffer = CreateBuffer (useRing);
+  Seq isn (m_isn);
+
+  // Writes of 1000 bytes, segments of 536 bytes
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (buffer->Add (MakeWrite (isn + Seq (i * 1000), 1000)), true, "Write refused");
+    }
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 100000u, "Wrong size");
+  NS_TEST_ASSERT_MSG_EQ (buffer->TailSequence (), isn + Seq (100000), "Wrong tail sequence");
+
+  Seq next = isn;
+  while (buffer->SizeFromSequence (next) > 0)
+    {
+      Ptr<Packet> p = buffer->CopyFromSequence (536, next);
+      NS_TEST_ASSERT_MSG_EQ (p->GetSize (), std::min (536u, buffer->SizeFromSequence (next)), "Wrong segment size");
+      NS_TEST_ASSERT_MSG_EQ (CheckContent (p, next), true, "Wrong segment content");
+      next += p->GetSize ();
+    }
+
+  // Acks in the middle of writes, then a retransmission from the head
+  buffer->DiscardUpTo (isn + Seq (2500));
+  NS_TEST_ASSERT_MSG_EQ (buffer->HeadSequence (), isn + Seq (2500), "Wrong head sequence");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 97500u, "Wrong size");
+  Ptr<Packet> p = buffer->CopyFromSequence (1400, isn + Seq (2500));
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1400u, "Wrong segment size");
+  NS_TEST_ASSERT_MSG_EQ (CheckContent (p, isn + Seq (2500)), true, "Wrong retransmitted content");
+  p = buffer->CopyFromSequence (3000, isn + Seq (50100));
+  NS_TEST_ASSERT_MSG_EQ (CheckContent (p, isn + Seq (50100)), true, "Wrong retransmitted content");
+
+  buffer->DiscardUpTo (isn + Seq (99999));
+  p = buffer->CopyFromSequence (536, isn + Seq (99999));
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1u, "Wrong segment size");
+  NS_TEST_ASSERT_MSG_EQ (CheckContent (p, isn + Seq (99999)), true, "Wrong segment content");
+
+  // Acking the FIN
+  buffer->DiscardUpTo (isn + Seq (100001));
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 0u, "Buffer should be empty");
+  NS_TEST_ASSERT_MSG_EQ (buffer->HeadSequence (), isn + Seq (100001), "Wrong head sequence");
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::TestInterleaved (void)
+{
+  Ptr<Buffer> list = CreateBuffer (false);
+  Ptr<Buffer> ring = CreateBuffer (true);
+  Seq isn (m_isn);
+  Seq written = isn;
+  Seq next = isn;
+
+  // Writes of varying sizes, interleaved with sends and acks, as a socket would
+  for (uint32_t i = 0; i < 2000; ++i)
+    {
+      uint32_t len = 1 + (i * 7919) % 3000;
+      list->Add (MakeWrite (written, len));
+      ring->Add (MakeWrite (written, len));
+      written += len;
+
+      uint32_t segSize = 100 + (i * 104729) % 1400;
+      if (list->SizeFromSequence (next) > 0)
+        {
+          Ptr<Packet> a = list->CopyFromSequence (segSize, next);
+          Ptr<Packet> b = ring->CopyFromSequence (segSize, next);
+          NS_TEST_ASSERT_MSG_EQ (b->GetSize (), a->GetSize (), "Segment sizes differ");
+          NS_TEST_ASSERT_MSG_EQ (CheckContent (b, next), true, "Wrong segment content");
+          next += a->GetSize ();
+        }
+      if (i % 3 == 0)
+        {
+          Seq acked = list->HeadSequence () + Seq ((next - list->HeadSequence ()) / 2);
+          list->DiscardUpTo (acked);
+          ring->DiscardUpTo (acked);
+          NS_TEST_ASSERT_MSG_EQ (ring->Size (), list->Size (), "Sizes differ");
+          NS_TEST_ASSERT_MSG_EQ (ring->HeadSequence (), acked, "Wrong head sequence");
+        }
+    }
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::TestVirtualPayload (void)
+{
+  Ptr<Buffer> buffer = CreateBuffer (false);
+  buffer->SetAttribute ("VirtualPayload", BooleanValue (true));
+  Seq isn (m_isn);
+
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (buffer->Add (MakeWrite (isn + Seq (i * 1000), 1000)), true, "Write refused");
+    }
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 10000u, "Wrong size");
+  Ptr<Packet> p = buffer->CopyFromSequence (1400, isn + Seq (9000));
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1000u, "Wrong segment size");
+
+  buffer->DiscardUpTo (isn + Seq (2500));
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 7500u, "Wrong size");
+  NS_TEST_ASSERT_MSG_EQ (buffer->SizeFromSequence (isn + Seq (3000)), 7000u, "Wrong size from sequence");
+  // Acking the FIN
+  buffer->DiscardUpTo (isn + Seq (10001));
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 0u, "Buffer should be empty");
+  NS_TEST_ASSERT_MSG_EQ (buffer->HeadSequence (), isn + Seq (10001), "Wrong head sequence");
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::TestScoreboard (void)
+{
+  typedef typename Buffer::SackList SackList;
+  typedef typename Buffer::SackBlock SackBlock;
+  Ptr<Buffer> buffer = CreateBuffer (false);
+  Seq isn (m_isn);
+  Time rtt = MilliSeconds (100);
+  Time minRtt = MilliSeconds (100);
+
+  // Ten segments of 1000 bytes, sent 1 ms apart
+  buffer->Add (MakeWrite (isn, 10000));
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      buffer->RecordSent (isn + Seq (i * 1000), 1000, MilliSeconds (i));
+    }
+  NS_TEST_ASSERT_MSG_EQ (buffer->GetPipe (), 10000u, "Wrong pipe");
+
+  // The first ack covers segment 0, and SACKs segments 2 to 4: segment 1 is lost
+  SackList blocks;
+  blocks.push_back (SackBlock (isn + Seq (2000), isn + Seq (5000)));
+  uint32_t sacked = buffer->UpdateScoreboard (isn + Seq (1000), blocks, rtt + MilliSeconds (4), minRtt);
+  buffer->DiscardUpTo (isn + Seq (1000));
+  NS_TEST_EXPECT_MSG_EQ (sacked, 3000u, "Wrong newly SACKed bytes");
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetSacked (), 3000u, "Wrong SACKed bytes");
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetPipe (), 6000u, "Wrong pipe");
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetRackRtt (), rtt, "Wrong RACK RTT");
+
+  // A second report of the same block is not counted again
+  sacked = buffer->UpdateScoreboard (isn + Seq (1000), blocks, rtt + MilliSeconds (5), minRtt);
+  NS_TEST_EXPECT_MSG_EQ (sacked, 0u, "Block counted twice");
+
+  // Three segments SACKed above segment 1: lost by the duplicate threshold
+  NS_TEST_EXPECT_MSG_EQ (buffer->MarkLostByCount (3, 1000), 1000u, "Wrong lost bytes");
+  Seq seq;
+  uint32_t size = 0;
+  NS_TEST_ASSERT_MSG_EQ (buffer->NextLost (seq, size), true, "No lost segment");
+  NS_TEST_EXPECT_MSG_EQ (seq, isn + Seq (1000), "Wrong lost segment");
+  NS_TEST_EXPECT_MSG_EQ (size, 1000u, "Wrong lost segment size");
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetPipe (), 5000u, "Wrong pipe");
+
+  // The retransmission goes back in the pipe
+  buffer->RecordSent (seq, size, MilliSeconds (105));
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetRetransmitted (), 1000u, "Wrong retransmitted bytes");
+  NS_TEST_EXPECT_MSG_EQ (buffer->NextLost (seq, size), false, "Lost segment not retransmitted");
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetPipe (), 6000u, "Wrong pipe");
+
+  // Segment 5 is lost, and segment 6 is SACKed: RACK waits for the reordering window
+  blocks.clear ();
+  blocks.push_back (SackBlock (isn + Seq (6000), isn + Seq (7000)));
+  blocks.push_back (SackBlock (isn + Seq (2000), isn + Seq (5000)));
+  buffer->UpdateScoreboard (isn + Seq (1000), blocks, rtt + MilliSeconds (6), minRtt);
+  Time timeout;
+  NS_TEST_EXPECT_MSG_EQ (buffer->MarkLostByTime (rtt + MilliSeconds (6), MilliSeconds (25), timeout),
+                         0u, "Segment lost within the reordering window");
+  NS_TEST_EXPECT_MSG_EQ (timeout, MilliSeconds (24), "Wrong reordering timeout");
+  NS_TEST_EXPECT_MSG_EQ (buffer->MarkLostByTime (rtt + MilliSeconds (30), MilliSeconds (25), timeout),
+                         1000u, "Segment not lost after the reordering window");
+  NS_TEST_ASSERT_MSG_EQ (buffer->NextLost (seq, size), true, "No lost segment");
+  NS_TEST_EXPECT_MSG_EQ (seq, isn + Seq (5000), "Wrong lost segment");
+
+  // The cumulative ack of the retransmission leaves segment 5 lost
+  sacked = buffer->UpdateScoreboard (isn + Seq (5000), blocks, MilliSeconds (205), minRtt);
+  buffer->DiscardUpTo (isn + Seq (5000));
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetRetransmitted (), 0u, "Retransmission not acknowledged");
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetLost (), 1000u, "Wrong lost bytes");
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetSacked (), 1000u, "Wrong SACKed bytes");
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetPipe (), 3000u, "Wrong pipe");
+
+  // A timeout marks everything not SACKed as lost
+  buffer->MarkAllLost ();
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetLost (), 4000u, "Wrong lost bytes");
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetPipe (), 0u, "Wrong pipe");
+
+  buffer->DiscardUpTo (isn + Seq (10000));
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetPipe (), 0u, "Wrong pipe");
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetLost (), 0u, "Wrong lost bytes");
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetSacked (), 0u, "Wrong SACKed bytes");
+}
+
+template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
+void
+TcpTxBufferTestCase<NUMERIC_TYPE, SIGNED_TYPE>::DoRun (void)
+{
+  TestSegments (false);
+  TestSegments (true);
+  TestInterleaved ();
+  TestVirtualPayload ();
+  TestScoreboard ();
+}
+
+static class TcpTxBufferTestSuite : public TestSuite
+{
+public:
+  TcpTxBufferTestSuite ()
+    : TestSuite ("tcp-tx-buffer", UNIT)
+  {
+    AddTestCase (new TcpTxBufferTestCase<uint32_t, int32_t> ("TcpTxBuffer32", 1), TestCase::QUICK);
+    AddTestCase (new TcpTxBufferTestCase<uint32_t, int32_t> ("TcpTxBuffer32 wrapping", 0xFFFF0000), TestCase::QUICK);
+    AddTestCase (new TcpTxBufferTestCase<uint64_t, int64_t> ("TcpTxBuffer64", 1), TestCase::QUICK);
+  }
+
+} g_tcpTxBufferTestSuite;
+
+} // namespace ns3
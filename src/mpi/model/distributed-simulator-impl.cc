@@ -117,6 +117,7 @@ DistributedSimulatorImpl::DistributedSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
+  m_eventCount = 0;
   m_events = 0;
 }
 
@@ -327,6 +328,7 @@ DistributedSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
+  m_eventCount++;
   next.impl->Invoke ();
   next.impl->Unref ();
 }
@@ -643,4 +645,10 @@ DistributedSimulatorImpl::GetContext (void) const
   return m_currentContext;
 }
 
+uint64_t
+DistributedSimulatorImpl::GetEventCount (void) const
+{
+  return m_eventCount;
+}
+
 } // namespace ns3
@@ -71,6 +71,7 @@ public:
   virtual void SetScheduler (ObjectFactory schedulerFactory);
   virtual uint32_t GetSystemId (void) const;
   virtual uint32_t GetContext (void) const;
+  virtual uint64_t GetEventCount (void) const;
 
   /**
    * \return singleton instance
@@ -180,6 +181,9 @@ private:
   // not counting the "destroy" events; this is used for validation
   int m_unscheduledEvents;
 
+  // number of events executed
+  uint64_t m_eventCount;
+
   uint32_t     m_myId;        // MPI Rank
   uint32_t     m_systemCount; // MPI Size
 
@@ -21,6 +21,7 @@
 #include "ns3/assert.h"
 #include "ns3/log.h"
 #include "address.h"
+#include <atomic>
 #include <cstring>
 #include <iostream>
 #include <iomanip>
@@ -138,9 +139,9 @@ uint8_t
 Address::Register (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  static uint8_t type = 1;
-  type++;
-  return type;
+  // The address types may be registered by several threads at once
+  static std::atomic<uint8_t> type (1);
+  return ++type;
 }
 
 uint32_t
@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "block-free-list.h"
+
+namespace ns3 {
+
+uint32_t
+BlockFreeList::GetClass (uint32_t size)
+{
+  if (size <= 16)
+    {
+      return 0;
+    }
+  // The classes of [2^e + 1, 2^(e+1)] have the sizes 5, 6, 7 and 8 times
+  // 2^(e-2)
+  uint32_t n = size - 1;
+  uint32_t e = 31 - __builtin_clz (n);
+  uint32_t quarter = (n >> (e - 2)) & 3;
+  return (e - 4) * 4 + quarter + 1;
+}
+
+uint32_t
+BlockFreeList::GetClassCapacity (uint32_t sizeClass)
+{
+  if (sizeClass == 0)
+    {
+      return 16;
+    }
+  uint32_t e = (sizeClass - 1) / 4 + 4;
+  uint32_t quarter = (sizeClass - 1) % 4;
+  return (5 + quarter) << (e - 2);
+}
+
+uint32_t
+BlockFreeList::GetCapacity (uint32_t size)
+{
+  uint32_t sizeClass = GetClass (size);
+  if (sizeClass >= N_CLASSES)
+    {
+      return size;
+    }
+  return GetClassCapacity (sizeClass);
+}
+
+uint8_t *
+BlockFreeList::Get (uint32_t size)
+{
+  if (m_nonEmpty == 0)
+    {
+      return 0;
+    }
+  uint32_t largest = 63 - __builtin_clzll (m_nonEmpty);
+  if (GetClassCapacity (largest) < size)
+    {
+      return 0;
+    }
+  std::vector<uint8_t *> *list = m_lists[largest];
+  uint8_t *block = list->back ();
+  list->pop_back ();
+  if (list->empty ())
+    {
+      m_nonEmpty &= ~(uint64_t (1) << largest);
+    }
+  return block;
+}
+
+bool
+BlockFreeList::Put (uint8_t *block, uint32_t capacity)
+{
+  if (m_released)
+    {
+      return false;
+    }
+  // The largest class whose blocks are not larger than this one
+  uint32_t sizeClass = GetClass (capacity);
+  if (sizeClass >= N_CLASSES)
+    {
+      return false;
+    }
+  if (GetClassCapacity (sizeClass) > capacity)
+    {
+      if (sizeClass == 0)
+        {
+          return false;
+        }
+      sizeClass--;
+    }
+  std::vector<uint8_t *> *list = m_lists[sizeClass];
+  if (list == 0)
+    {
+      list = new std::vector<uint8_t *> ();
+      m_lists[sizeClass] = list;
+    }
+  if (list->size () >= MAX_FREE)
+    {
+      return false;
+    }
+  list->push_back (block);
+  m_nonEmpty |= uint64_t (1) << sizeClass;
+  return true;
+}
+
+void
+BlockFreeList::Release (void)
+{
+  for (uint32_t i = 0; i < N_CLASSES; ++i)
+    {
+      if (m_lists[i] == 0)
+        {
+          continue;
+        }
+      for (std::vector<uint8_t *>::iterator j = m_lists[i]->begin ();
+           j != m_lists[i]->end (); ++j)
+        {
+          delete [] *j;
+        }
+      delete m_lists[i];
+      m_lists[i] = 0;
+    }
+  m_nonEmpty = 0;
+  m_released = true;
+}
+
+} // namespace ns3
@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BLOCK_FREE_LIST_H
+#define BLOCK_FREE_LIST_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ * \brief Free list of variable size blocks, bucketed by size class.
+ *
+ * Buffer, PacketMetadata and ByteTagList allocate their data as arrays
+ * of bytes starting with a header which records the usable size of the
+ * block. They keep the released blocks in a thread local instance of this
+ * class, so that independent simulations may run in the threads of one
+ * process:
+ *  - the sizes are rounded up by GetCapacity to a size class, with four
+ *    classes per power of two, and each class has its own list, so that
+ *    the fragments of different sizes do not evict each other;
+ *  - Get returns a block of the largest class held if it fits, so that
+ *    new data are created with the room of the largest data seen, as the
+ *    free lists used to do;
+ *  - each class keeps at most 1000 blocks.
+ *
+ * An instance must have thread storage duration. It is trivially
+ * destructible, so that the blocks of the objects destroyed late in the
+ * life of the thread can still be given to Put: Release, called when the
+ * thread exits, frees the blocks held and makes Put fail from then on.
+ */
+class BlockFreeList
+{
+public:
+  /**
+   * \param [in] size A requested size.
+   * \return The size to allocate for it, the capacity of its size class.
+   */
+  static uint32_t GetCapacity (uint32_t size);
+
+  /**
+   * Take a block from the list.
+   *
+   * \param [in] size The size needed.
+   * \return A block of at least \p size bytes, or 0 if none is held.
+   */
+  uint8_t *Get (uint32_t size);
+  /**
+   * Give a block to the list.
+   *
+   * \param [in] block The block, allocated with new [].
+   * \param [in] capacity The usable size of the block.
+   * \return \c false if the block was not kept and must be freed.
+   */
+  bool Put (uint8_t *block, uint32_t capacity);
+  /** Free the blocks held, called when the thread exits. */
+  void Release (void);
+
+private:
+  /** The number of size classes, up to blocks of 512 KiB. */
+  static const uint32_t N_CLASSES = 64;
+  /** Maximum number of blocks kept in each class. */
+  static const uint32_t MAX_FREE = 1000;
+
+  /**
+   * \param [in] size A size.
+   * \return The smallest class whose blocks can hold \p size bytes.
+   */
+  static uint32_t GetClass (uint32_t size);
+  /**
+   * \param [in] sizeClass A size class.
+   * \return The size of the blocks of the class.
+   */
+  static uint32_t GetClassCapacity (uint32_t sizeClass);
+
+  std::vector<uint8_t *> *m_lists[N_CLASSES]; //!< The blocks of each class
+  uint64_t m_nonEmpty;                        //!< One bit per non-empty list
+  bool m_released;                            //!< Has Release been called
+};
+
+} // namespace ns3
+
+#endif /* BLOCK_FREE_LIST_H */
@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "buffer.h"
+#include "block-free-list.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 
@@ -49,69 +50,49 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
+namespace {
 
-uint32_t Buffer::g_recommendedStart = 0;
-#ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
+/**
+ * Location in a newly-allocated buffer where you should start writing
+ * data. i.e., m_start should be initialized to this value.
  */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
-
-Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
+thread_local uint32_t g_recommendedStart = 0;
+
+} // unnamed namespace
+
+#ifdef BUFFER_FREE_LIST
+namespace {
+
+/** The buffer data released by the thread. */
+thread_local BlockFreeList g_freeList;
+
+/** Releases the free list of a thread when it exits. */
+struct FreeListReaper
 {
-  NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
-    {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
-    }
-}
+  ~FreeListReaper ()
+  {
+    g_freeList.Release ();
+  }
+};
+/** The reaper of the current thread. */
+thread_local FreeListReaper g_freeListReaper;
+
+} // unnamed namespace
 
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
   /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
+  if (g_freeList.Put (reinterpret_cast<uint8_t *> (data), data->m_size))
     {
-      Buffer::Deallocate (data);
+      // Odr-use the reaper so that it is destroyed when the thread exits
+      (void)&g_freeListReaper;
     }
   else
     {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
+      Buffer::Deallocate (data);
     }
 }
 
@@ -120,23 +101,12 @@ Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
   /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
+  uint8_t *block = g_freeList.Get (dataSize);
+  if (block != 0)
     {
-      g_freeList = new Buffer::FreeList ();
-    }
-  else if (IS_INITIALIZED (g_freeList))
-    {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
+      struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data *> (block);
+      data->m_count = 1;
+      return data;
     }
   struct Buffer::Data *data = Buffer::Allocate (dataSize);
   NS_ASSERT (data->m_count == 1);
@@ -168,6 +138,7 @@ Buffer::Allocate (uint32_t reqSize)
       reqSize = 1;
     }
   NS_ASSERT (reqSize >= 1);
+  reqSize = BlockFreeList::GetCapacity (reqSize);
   uint32_t size = reqSize - 1 + sizeof (struct Buffer::Data);
   uint8_t *b = new uint8_t [size];
   struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
@@ -839,8 +810,12 @@ Buffer::Iterator::Write (Iterator start, Iterator end)
   NS_ASSERT (start.m_current <= end.m_current);
   NS_ASSERT (start.m_zeroStart == end.m_zeroStart);
   NS_ASSERT (start.m_zeroEnd == end.m_zeroEnd);
-  NS_ASSERT (m_data != start.m_data);
   uint32_t size = end.m_current - start.m_current;
+  // The source may share the data of the destination, as when a buffer
+  // is appended to a fragment of itself, but not overlap it
+  NS_ASSERT (m_data != start.m_data ||
+             m_current >= end.m_current ||
+             m_current + size <= start.m_current);
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + size),
                  GetWriteErrorMessage ());
   if (start.m_current <= start.m_zeroStart)
@@ -40,7 +40,9 @@ namespace ns3 {
  * to ensure that the number of buffer resizes is minimized,
  * by creating new Buffers of the maximum size ever used.
  * The correct maximum size is learned at runtime during use by 
- * recording the maximum size of each packet.
+ * recording the maximum size of each packet. The free list of the
+ * buffer data and this heuristic are per thread, so that independent
+ * simulations may run in the threads of one process.
  *
  * \internal
  * The implementation of the Buffer class uses a COW (Copy On Write)
@@ -750,18 +752,12 @@ private:
    * the lifetime of a Buffer instance. This variable is used
    * purely as a source of information for the heuristics which
    * decide on the position of the zero area in new buffers.
-   * It is read from the Buffer destructor to update the global
-   * heuristic data and these global heuristic data are used from
+   * It is read from the Buffer destructor to update the per-thread
+   * heuristic data and these heuristic data are used from
    * the Buffer constructor to choose an initial value for 
    * m_zeroAreaStart.
    */
   uint32_t m_maxZeroAreaStart;
-  /**
-   * location in a newly-allocated buffer where you should start
-   * writing data. i.e., m_start should be initialized to this 
-   * value.
-   */
-  static uint32_t g_recommendedStart;
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -783,19 +779,6 @@ private:
    * instance from the start of m_data->m_data
    */
   uint32_t m_end;
-
-#ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
-#endif
 };
 
 } // namespace ns3
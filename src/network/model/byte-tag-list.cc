@@ -18,12 +18,12 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "byte-tag-list.h"
+#include "block-free-list.h"
 #include "ns3/log.h"
 #include <vector>
 #include <cstring>
 
 #define USE_FREE_LIST 1
-#define FREE_LIST_SIZE 1000
 #define OFFSET_MAX (2147483647)
 
 namespace ns3 {
@@ -45,30 +45,25 @@ struct ByteTagListData {
 };
 
 #ifdef USE_FREE_LIST
-/**
- * \ingroup packet
- *
- * \brief Container class for struct ByteTagListData
- *
- * Internal use only.
- */
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
-{
-public:
-  ~ByteTagListDataFreeList ();
-} g_freeList; //!< Container for struct ByteTagListData
-static uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+namespace {
 
-ByteTagListDataFreeList::~ByteTagListDataFreeList ()
+/** The data released by the thread. */
+thread_local BlockFreeList g_freeList;
+/** Maximum data size of the thread (used for allocation). */
+thread_local uint32_t g_maxSize = 0;
+
+/** Releases the free list of a thread when it exits. */
+struct FreeListReaper
 {
-  NS_LOG_FUNCTION (this);
-  for (ByteTagListDataFreeList::iterator i = begin ();
-       i != end (); i++)
-    {
-      uint8_t *buffer = (uint8_t *)(*i);
-      delete [] buffer;
-    }
-}
+  ~FreeListReaper ()
+  {
+    g_freeList.Release ();
+  }
+};
+/** The reaper of the current thread. */
+thread_local FreeListReaper g_freeListReaper;
+
+} // unnamed namespace
 #endif /* USE_FREE_LIST */
 
 ByteTagList::Iterator::Item::Item (TagBuffer buf_)
@@ -344,24 +339,19 @@ struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  while (!g_freeList.empty ())
+  uint8_t *block = g_freeList.Get (size);
+  if (block != 0)
     {
-      struct ByteTagListData *data = g_freeList.back ();
-      g_freeList.pop_back ();
-      NS_ASSERT (data != 0);
-      if (data->size >= size)
-        {
-          data->count = 1;
-          data->dirty = 0;
-          return data;
-        }
-      uint8_t *buffer = (uint8_t *)data;
-      delete [] buffer;
+      struct ByteTagListData *data = (struct ByteTagListData *)block;
+      data->count = 1;
+      data->dirty = 0;
+      return data;
     }
-  uint8_t *buffer = new uint8_t [std::max (size, g_maxSize) + sizeof (struct ByteTagListData) - 4];
+  uint32_t capacity = BlockFreeList::GetCapacity (std::max (size, g_maxSize));
+  uint8_t *buffer = new uint8_t [capacity + sizeof (struct ByteTagListData) - 4];
   struct ByteTagListData *data = (struct ByteTagListData *)buffer;
   data->count = 1;
-  data->size = size;
+  data->size = capacity;
   data->dirty = 0;
   return data;
 }
@@ -378,15 +368,15 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
   data->count--;
   if (data->count == 0)
     {
-      if (g_freeList.size () > FREE_LIST_SIZE ||
-          data->size < g_maxSize)
+      if (g_freeList.Put ((uint8_t *)data, data->size))
         {
-          uint8_t *buffer = (uint8_t *)data;
-          delete [] buffer;
+          // Odr-use the reaper so that it is destroyed when the thread exits
+          (void)&g_freeListReaper;
         }
       else
         {
-          g_freeList.push_back (data);
+          uint8_t *buffer = (uint8_t *)data;
+          delete [] buffer;
         }
     }
 }
@@ -17,6 +17,7 @@
  */
 
 #include "ns3/simulator.h"
+#include "ns3/isolated-simulation.h"
 #include "ns3/object-vector.h"
 #include "ns3/config.h"
 #include "ns3/log.h"
@@ -77,6 +78,9 @@ public:
 
   /**
    * \brief Get the channel list object
+   *
+   * A thread running an IsolatedSimulation has a list of its own.
+   *
    * \returns the channel list
    */
   static Ptr<ChannelListPriv> Get (void);
@@ -129,13 +133,15 @@ ChannelListPriv::DoGet (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
   static Ptr<ChannelListPriv> ptr = 0;
-  if (ptr == 0)
+  static thread_local Ptr<ChannelListPriv> isolatedPtr = 0;
+  Ptr<ChannelListPriv> *pptr = IsolatedSimulation::IsActive () ? &isolatedPtr : &ptr;
+  if (*pptr == 0)
     {
-      ptr = CreateObject<ChannelListPriv> ();
-      Config::RegisterRootNamespaceObject (ptr);
+      *pptr = CreateObject<ChannelListPriv> ();
+      Config::RegisterRootNamespaceObject (*pptr);
       Simulator::ScheduleDestroy (&ChannelListPriv::Delete);
     }
-  return &ptr;
+  return pptr;
 }
 
 void 
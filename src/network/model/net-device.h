@@ -624,6 +624,15 @@ public:
    */
   virtual bool SupportsSendFrom (void) const = 0;
 
+  /**
+   * \return true if this interface cuts the super-segments marked with a
+   * GsoTag into wire sized packets itself, false otherwise.
+   *
+   * Packets larger than the MTU are then given to Send () and queued as a
+   * whole. The default implementation returns false.
+   */
+  virtual bool SupportsGso (void) const;
+
 };
 
 } // namespace ns3
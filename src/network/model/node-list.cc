@@ -20,6 +20,7 @@
  */
 
 #include "ns3/simulator.h"
+#include "ns3/isolated-simulation.h"
 #include "ns3/object-vector.h"
 #include "ns3/config.h"
 #include "ns3/log.h"
@@ -80,6 +81,9 @@ public:
 
   /**
    * \brief Get the node list object
+   *
+   * A thread running an IsolatedSimulation has a list of its own.
+   *
    * \returns the node list
    */
   static Ptr<NodeListPriv> Get (void);
@@ -131,13 +135,15 @@ NodeListPriv::DoGet (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
   static Ptr<NodeListPriv> ptr = 0;
-  if (ptr == 0)
+  static thread_local Ptr<NodeListPriv> isolatedPtr = 0;
+  Ptr<NodeListPriv> *pptr = IsolatedSimulation::IsActive () ? &isolatedPtr : &ptr;
+  if (*pptr == 0)
     {
-      ptr = CreateObject<NodeListPriv> ();
-      Config::RegisterRootNamespaceObject (ptr);
+      *pptr = CreateObject<NodeListPriv> ();
+      Config::RegisterRootNamespaceObject (*pptr);
       Simulator::ScheduleDestroy (&NodeListPriv::Delete);
     }
-  return &ptr;
+  return pptr;
 }
 void 
 NodeListPriv::Delete (void)
@@ -18,12 +18,14 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include <utility>
+#include <algorithm>
 #include <list>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include "packet-metadata.h"
 #include "buffer.h"
+#include "block-free-list.h"
 #include "header.h"
 #include "trailer.h"
 
@@ -33,20 +35,27 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
-bool PacketMetadata::m_metadataSkipped = false;
-uint32_t PacketMetadata::m_maxSize = 0;
-uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+std::atomic<bool> PacketMetadata::m_metadataSkipped (false);
+thread_local uint32_t PacketMetadata::m_maxSize = 0;
+thread_local uint16_t PacketMetadata::m_chunkUid = 0;
 
-PacketMetadata::DataFreeList::~DataFreeList ()
+namespace {
+
+/** The metadata storage released by the thread. */
+thread_local BlockFreeList g_freeList;
+
+/** Releases the free list of a thread when it exits. */
+struct FreeListReaper
 {
-  NS_LOG_FUNCTION (this);
-  for (iterator i = begin (); i != end (); i++)
-    {
-      PacketMetadata::Deallocate (*i);
-    }
-  PacketMetadata::m_enable = false;
-}
+  ~FreeListReaper ()
+  {
+    g_freeList.Release ();
+  }
+};
+/** The reaper of the current thread. */
+thread_local FreeListReaper g_freeListReaper;
+
+} // unnamed namespace
 
 void 
 PacketMetadata::Enable (void)
@@ -62,6 +71,16 @@ PacketMetadata::Enable (void)
   m_enable = true;
 }
 
+void
+PacketMetadata::SetMetadataSkipped (void)
+{
+  // Only written once, so that the threads do not contend on the flag
+  if (!m_metadataSkipped.load (std::memory_order_relaxed))
+    {
+      m_metadataSkipped.store (true, std::memory_order_relaxed);
+    }
+}
+
 void 
 PacketMetadata::EnableChecking (void)
 {
@@ -99,7 +118,14 @@ void
 PacketMetadata::Reserve (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  NS_ASSERT (m_data != 0);
+  if (m_data == 0)
+    {
+      // Packet created before the metadata was enabled, with no items yet
+      NS_ASSERT (m_head == 0xffff && m_used == 0);
+      m_data = PacketMetadata::Create (std::max (size, 10U));
+      memset (m_data->m_data, 0xff, 4);
+      return;
+    }
   if (m_data->m_size >= m_used + size &&
       (m_head == 0xffff ||
        m_data->m_count == 1 ||
@@ -133,6 +159,10 @@ bool
 PacketMetadata::IsStateOk (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_data == 0)
+    {
+      return m_head == 0xffff && m_tail == 0xffff && m_used == 0;
+    }
   bool ok = m_used <= m_data->m_size;
   ok &= IsPointerOk (m_head);
   ok &= IsPointerOk (m_tail);
@@ -576,18 +606,13 @@ PacketMetadata::Create (uint32_t size)
     {
       m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
+  uint8_t *block = g_freeList.Get (size);
+  if (block != 0)
     {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
-      if (data->m_size >= size) 
-        {
-          NS_LOG_LOGIC ("create found size="<<data->m_size);
-          data->m_count = 1;
-          return data;
-        }
-      PacketMetadata::Deallocate (data);
-      NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
+      struct PacketMetadata::Data *data = reinterpret_cast<struct PacketMetadata::Data *> (block);
+      NS_LOG_LOGIC ("create found size="<<data->m_size);
+      data->m_count = 1;
+      return data;
     }
   NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
   return PacketMetadata::Allocate (m_maxSize);
@@ -602,16 +627,16 @@ PacketMetadata::Recycle (struct PacketMetadata::Data *data)
       PacketMetadata::Deallocate (data);
       return;
     } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
+  NS_LOG_LOGIC ("recycle size="<<data->m_size);
   NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
+  if (g_freeList.Put (reinterpret_cast<uint8_t *> (data), data->m_size))
     {
-      PacketMetadata::Deallocate (data);
-    } 
-  else 
+      // Odr-use the reaper so that it is destroyed when the thread exits
+      (void)&g_freeListReaper;
+    }
+  else
     {
-      m_freeList.push_back (data);
+      PacketMetadata::Deallocate (data);
     }
 }
 
@@ -624,6 +649,8 @@ PacketMetadata::Allocate (uint32_t n)
     {
       n = PACKET_METADATA_DATA_M_DATA_SIZE;
     }
+  // Round up to the size class of the free list, within the 16 bit size
+  n = std::min (BlockFreeList::GetCapacity (n), 0xffffU);
   size += n - PACKET_METADATA_DATA_M_DATA_SIZE;
   uint8_t *buf = new uint8_t [size];
   struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)buf;
@@ -666,7 +693,7 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
   NS_LOG_FUNCTION (this << uid << size);
   if (!m_enable)
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
       return;
     }
 
@@ -688,7 +715,7 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
       return;
     }
   struct PacketMetadata::SmallItem item;
@@ -736,7 +763,7 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
   NS_ASSERT (IsStateOk ());
   if (!m_enable)
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
       return;
     }
   struct PacketMetadata::SmallItem item;
@@ -758,7 +785,7 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
       return;
     }
   struct PacketMetadata::SmallItem item;
@@ -805,7 +832,7 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
       return;
     }
   if (m_tail == 0xffff)
@@ -882,7 +909,7 @@ PacketMetadata::AddPaddingAtEnd (uint32_t end)
   NS_LOG_FUNCTION (this << end);
   if (!m_enable)
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
       return;
     }
 }
@@ -893,10 +920,14 @@ PacketMetadata::RemoveAtStart (uint32_t start)
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
+      return;
+    }
+  if (m_data == 0)
+    {
+      // no items to remove
       return;
     }
-  NS_ASSERT (m_data != 0);
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
   while (current != 0xffff && leftToRemove > 0)
@@ -956,10 +987,14 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
+      return;
+    }
+  if (m_data == 0)
+    {
+      // no items to remove
       return;
     }
-  NS_ASSERT (m_data != 0);
 
   uint32_t leftToRemove = end;
   uint16_t current = m_tail;
@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <vector>
 #include <limits>
+#include <atomic>
 #include "ns3/callback.h"
 #include "ns3/assert.h"
 #include "ns3/type-id.h"
@@ -491,16 +492,6 @@ private:
     uint64_t packetUid;
   };
 
-  /**
-   * \brief Class to hold all the metadata
-   */
-  class DataFreeList : public std::vector<struct Data *>
-  {
-public:
-    ~DataFreeList ();
-  };
-
-  friend DataFreeList::~DataFreeList ();
   friend class ItemIterator;
 
   PacketMetadata ();
@@ -656,21 +647,31 @@ public:
    */
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList; //!< the metadata data storage
+  /**
+   * Record that adding metadata to a packet was skipped because
+   * m_enable is false.
+   */
+  static void SetMetadataSkipped (void);
+
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
 
   /**
    * Set to true when adding metadata to a packet is skipped because
    * m_enable is false; used to detect enabling of metadata in the
-   * middle of a simulation, which isn't allowed.
+   * middle of a simulation, which isn't allowed. Shared by the threads,
+   * and only written once.
    */
-  static bool m_metadataSkipped;
+  static std::atomic<bool> m_metadataSkipped;
 
-  static uint32_t m_maxSize; //!< maximum metadata size
-  static uint16_t m_chunkUid; //!< Chunk Uid
+  static thread_local uint32_t m_maxSize; //!< maximum metadata size of the thread
+  static thread_local uint16_t m_chunkUid; //!< Chunk Uid of the thread
 
-  struct Data *m_data; //!< Metadata storage
+  /**
+   * Metadata storage, only allocated when the metadata is enabled: the
+   * packets created while it is disabled have none and carry no items.
+   */
+  struct Data *m_data;
   /*
      head -(next)-> tail
        ^             |
@@ -687,13 +688,17 @@ public:
 namespace ns3 {
 
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
+  : m_data (0),
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
     m_packetUid (uid)
 {
-  memset (m_data->m_data, 0xff, 4);
+  if (m_enable)
+    {
+      m_data = PacketMetadata::Create (10);
+      memset (m_data->m_data, 0xff, 4);
+    }
   if (size > 0)
     {
       DoAddHeader (0, size);
@@ -706,9 +711,11 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_used (o.m_used),
     m_packetUid (o.m_packetUid)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  if (m_data != 0)
+    {
+      NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
+      m_data->m_count++;
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -716,15 +723,19 @@ PacketMetadata::operator = (PacketMetadata const& o)
   if (m_data != o.m_data) 
     {
       // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (m_data != 0)
         {
-          PacketMetadata::Recycle (m_data);
+          m_data->m_count--;
+          if (m_data->m_count == 0) 
+            {
+              PacketMetadata::Recycle (m_data);
+            }
         }
       m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      if (m_data != 0)
+        {
+          m_data->m_count++;
+        }
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
@@ -734,7 +745,10 @@ PacketMetadata::operator = (PacketMetadata const& o)
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
+  if (m_data == 0)
+    {
+      return;
+    }
   m_data->m_count--;
   if (m_data->m_count == 0) 
     {
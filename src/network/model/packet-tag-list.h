@@ -28,6 +28,7 @@
 #include <stdint.h>
 #include <ostream>
 #include "ns3/type-id.h"
+#include "ns3/small-object-pool.h"
 
 namespace ns3 {
 
@@ -165,6 +166,25 @@ public:
     struct TagData * next;   /**< Pointer to next in list */
     TypeId tid;               /**< Type of the tag serialized into #data */
     uint32_t count;           /**< Number of incoming links */
+
+    /**
+     * Allocate a tag from the free lists of the thread.
+     * \param [in] size The size of the tag.
+     * \returns The storage of the tag.
+     */
+    static void * operator new (std::size_t size)
+    {
+      return SmallObjectPool::Allocate (size);
+    }
+    /**
+     * Release a tag to the free lists of the thread.
+     * \param [in] p The storage of the tag.
+     * \param [in] size The size of the tag.
+     */
+    static void operator delete (void *p, std::size_t size)
+    {
+      SmallObjectPool::Deallocate (p, size);
+    }
   };  /* struct TagData */
 
   /**
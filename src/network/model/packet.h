@@ -34,6 +34,7 @@
 #include "ns3/assert.h"
 #include "ns3/ptr.h"
 #include "ns3/deprecated.h"
+#include "ns3/small-object-pool.h"
 
 namespace ns3 {
 
@@ -428,7 +429,9 @@ public:
    * \brief Returns the packet's Uid.
    *
    * A packet is allocated a new uid when it is created
-   * empty or with zero-filled payload.
+   * empty or with zero-filled payload. The uids are counted per
+   * thread, so that the simulations run in the threads of a process
+   * each number their own packets.
    *
    * Note: This uid is an internal uid and cannot be counted on to
    * provide an accurate counter of how many "simulated packets" of a
@@ -698,7 +701,29 @@ public:
    */
   typedef void (* SinrTracedCallback)
     (Ptr<const Packet> packet, double sinr);
-    
+
+  /**
+   * \brief Allocate a packet from the free lists of the thread.
+   *
+   * Packets are copied and fragmented several times on their way down
+   * and up the stack, so they reuse the storage of released packets.
+   *
+   * \param [in] size The size of the packet.
+   * \returns The storage of the packet.
+   */
+  static void * operator new (std::size_t size)
+  {
+    return SmallObjectPool::Allocate (size);
+  }
+  /**
+   * \brief Release a packet to the free lists of the thread.
+   * \param [in] p The storage of the packet.
+   * \param [in] size The size of the packet.
+   */
+  static void operator delete (void *p, std::size_t size)
+  {
+    SmallObjectPool::Deallocate (p, size);
+  }
   
 private:
   /**
@@ -727,7 +752,7 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  static thread_local uint32_t m_globalUid; //!< Counter of the packets Uid of the thread
 };
 
 /**
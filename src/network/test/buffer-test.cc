@@ -19,9 +19,13 @@
  */
 
 #include "ns3/buffer.h"
+#include "ns3/block-free-list.h"
+#include "ns3/system-thread.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/double.h"
 #include "ns3/test.h"
+#include <vector>
+#include <utility>
 
 using namespace ns3;
 
@@ -360,6 +364,128 @@ BufferTest::DoRun (void)
   val2 |= i.ReadU8 ();
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
+//-----------------------------------------------------------------------------
+/**
+ * Check the size classes of the free list of the buffer data, and that
+ * the blocks of each size are kept.
+ */
+class BlockFreeListTest : public TestCase
+{
+public:
+  BlockFreeListTest ();
+private:
+  virtual void DoRun (void);
+};
+
+BlockFreeListTest::BlockFreeListTest ()
+  : TestCase ("Check the size classes of the block free list")
+{
+}
+
+void
+BlockFreeListTest::DoRun (void)
+{
+  NS_TEST_EXPECT_MSG_EQ (BlockFreeList::GetCapacity (1), 16u, "Bad smallest class");
+  NS_TEST_EXPECT_MSG_EQ (BlockFreeList::GetCapacity (16), 16u, "Bad smallest class");
+  NS_TEST_EXPECT_MSG_EQ (BlockFreeList::GetCapacity (17), 20u, "Bad class");
+  NS_TEST_EXPECT_MSG_EQ (BlockFreeList::GetCapacity (33), 40u, "Bad class");
+  NS_TEST_EXPECT_MSG_EQ (BlockFreeList::GetCapacity (1500), 1536u, "Bad class");
+  NS_TEST_EXPECT_MSG_EQ (BlockFreeList::GetCapacity (2048), 2048u, "Bad class");
+
+  BlockFreeList list = BlockFreeList ();
+  uint8_t *small = new uint8_t [20];
+  uint8_t *large = new uint8_t [1536];
+  NS_TEST_EXPECT_MSG_EQ (list.Put (small, 20), true, "Small block not kept");
+  NS_TEST_EXPECT_MSG_EQ (list.Put (large, 1536), true, "Large block not kept");
+  // The largest block comes first, whatever the size asked for
+  NS_TEST_EXPECT_MSG_EQ ((list.Get (10) == large), true, "Largest block not returned");
+  NS_TEST_EXPECT_MSG_EQ ((list.Get (30) == 0), true, "Block too small returned");
+  NS_TEST_EXPECT_MSG_EQ ((list.Get (10) == small), true, "Small block lost");
+  NS_TEST_EXPECT_MSG_EQ ((list.Get (10) == 0), true, "Block returned twice");
+
+  NS_TEST_EXPECT_MSG_EQ (list.Put (large, 1536), true, "Large block not kept");
+  list.Release ();
+  NS_TEST_EXPECT_MSG_EQ (list.Put (small, 20), false, "Block kept after the release");
+  delete [] small;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Check that buffers may be used by several threads at once, each with
+ * its own free list.
+ */
+class BufferThreadsTest : public TestCase
+{
+public:
+  BufferThreadsTest ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Create, fragment and merge buffers filled with a pattern.
+   * \param context The test case and the index of the thread.
+   */
+  static void Work (std::pair<BufferThreadsTest *, uint32_t> context);
+
+  std::vector<uint32_t> m_errors; //!< The corrupted buffers of each thread
+};
+
+BufferThreadsTest::BufferThreadsTest ()
+  : TestCase ("Check the buffers used by concurrent threads")
+{
+}
+
+void
+BufferThreadsTest::Work (std::pair<BufferThreadsTest *, uint32_t> context)
+{
+  uint32_t index = context.second;
+  uint32_t errors = 0;
+  for (uint32_t i = 0; i < 2000; ++i)
+    {
+      uint8_t pattern = static_cast<uint8_t> (index * 32 + i);
+      Buffer buffer;
+      buffer.AddAtStart (100 + i % 1400);
+      Buffer::Iterator it = buffer.Begin ();
+      for (uint32_t j = 0; j < buffer.GetSize (); ++j)
+        {
+          it.WriteU8 (pattern);
+        }
+      Buffer fragment = buffer.CreateFragment (50, 50);
+      fragment.AddAtEnd (buffer);
+      it = fragment.Begin ();
+      for (uint32_t j = 0; j < fragment.GetSize (); ++j)
+        {
+          if (it.ReadU8 () != pattern)
+            {
+              errors++;
+              break;
+            }
+        }
+    }
+  context.first->m_errors[index] = errors;
+}
+
+void
+BufferThreadsTest::DoRun (void)
+{
+  const uint32_t threads = 4;
+  m_errors.assign (threads, 0);
+  std::vector<Ptr<SystemThread> > workers;
+  for (uint32_t i = 0; i < threads; ++i)
+    {
+      workers.push_back (Create<SystemThread> (MakeBoundCallback (
+          &BufferThreadsTest::Work, std::pair<BufferThreadsTest *, uint32_t> (this, i))));
+    }
+  for (uint32_t i = 0; i < threads; ++i)
+    {
+      workers[i]->Start ();
+    }
+  for (uint32_t i = 0; i < threads; ++i)
+    {
+      workers[i]->Join ();
+      NS_TEST_EXPECT_MSG_EQ (m_errors[i], 0u, "Corrupted buffers in thread " << i);
+    }
+}
+
 //-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
@@ -371,6 +497,8 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BlockFreeListTest, TestCase::QUICK);
+  AddTestCase (new BufferThreadsTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
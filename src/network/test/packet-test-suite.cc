@@ -24,6 +24,7 @@
 #include <limits>     // std:numeric_limits
 #include <string>
 #include <cstdarg>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <ctime>
@@ -847,6 +848,59 @@ PacketTagListTest::DoRun (void)
     
 }
 
+//-----------------------------------------------------------------------------
+/**
+ * Check that the fragments of a packet put back together give the original
+ * bytes, and that the storage of the packets and of their tags is reused.
+ */
+class PacketStorageTest : public TestCase
+{
+public:
+  PacketStorageTest ();
+private:
+  void DoRun (void);
+};
+
+PacketStorageTest::PacketStorageTest ()
+  : TestCase ("Packet fragments and storage reuse")
+{
+}
+
+void
+PacketStorageTest::DoRun (void)
+{
+  uint8_t data[1000];
+  for (uint32_t i = 0; i < sizeof (data); ++i)
+    {
+      data[i] = i % 251;
+    }
+  Ptr<Packet> packet = Create<Packet> (data, sizeof (data));
+  Ptr<Packet> merged = packet->CreateFragment (0, 400);
+  Ptr<Packet> second = packet->CreateFragment (400, 600);
+  merged->AddAtEnd (second);
+  NS_TEST_ASSERT_MSG_EQ (merged->GetSize (), sizeof (data), "Bad merged size");
+  NS_TEST_EXPECT_MSG_EQ (merged->GetUid (), packet->GetUid (), "Fragment without the uid of its packet");
+  uint8_t copy[1000];
+  merged->CopyData (copy, sizeof (copy));
+  NS_TEST_EXPECT_MSG_EQ (memcmp (copy, data, sizeof (data)), 0, "Bad merged data");
+
+  const Packet *released;
+  {
+    Ptr<Packet> p = Create<Packet> (10);
+    released = PeekPointer (p);
+  }
+  Ptr<Packet> reused = Create<Packet> (10);
+  NS_TEST_EXPECT_MSG_EQ (PeekPointer (reused), released, "Packet storage not reused");
+
+  reused->AddPacketTag (ATestTag<1> ());
+  Ptr<Packet> tagged = reused->Copy ();
+  ATestTag<1> tag;
+  NS_TEST_EXPECT_MSG_EQ (tagged->PeekPacketTag (tag), true, "Tag not shared by the copy");
+  reused->RemovePacketTag (tag);
+  NS_TEST_EXPECT_MSG_EQ (tagged->PeekPacketTag (tag), true, "Tag removed from the copy");
+  NS_TEST_EXPECT_MSG_EQ (reused->PeekPacketTag (tag), false, "Tag not removed");
+}
+
 //-----------------------------------------------------------------------------
 class PacketTestSuite : public TestSuite
 {
@@ -859,6 +913,7 @@ PacketTestSuite::PacketTestSuite ()
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
+  AddTestCase (new PacketStorageTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite;
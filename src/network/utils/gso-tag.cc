@@ -0,0 +1,135 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <map>
+
+#include "gso-tag.h"
+#include "ns3/packet.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("GsoTag");
+
+NS_OBJECT_ENSURE_REGISTERED (GsoTag);
+
+/**
+ * \returns the segmenters, by L3 protocol number
+ *
+ * Only written while the libraries are loaded, so the threads of a sweep
+ * can read it without locking.
+ */
+static std::map<uint16_t, GsoTag::Segmenter> &
+GetSegmenters (void)
+{
+  static std::map<uint16_t, GsoTag::Segmenter> segmenters;
+  return segmenters;
+}
+
+TypeId
+GsoTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::GsoTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("Network")
+    .AddConstructor<GsoTag> ()
+  ;
+  return tid;
+}
+
+TypeId
+GsoTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+GsoTag::GetSerializedSize (void) const
+{
+  return 2;
+}
+
+void
+GsoTag::Serialize (TagBuffer buf) const
+{
+  buf.WriteU16 (m_segmentSize);
+}
+
+void
+GsoTag::Deserialize (TagBuffer buf)
+{
+  m_segmentSize = buf.ReadU16 ();
+}
+
+void
+GsoTag::Print (std::ostream &os) const
+{
+  os << "GsoSegmentSize=" << m_segmentSize;
+}
+
+GsoTag::GsoTag ()
+  : Tag (),
+    m_segmentSize (0)
+{
+}
+
+GsoTag::GsoTag (uint16_t segmentSize)
+  : Tag (),
+    m_segmentSize (segmentSize)
+{
+}
+
+void
+GsoTag::SetSegmentSize (uint16_t segmentSize)
+{
+  m_segmentSize = segmentSize;
+}
+
+uint16_t
+GsoTag::GetSegmentSize (void) const
+{
+  return m_segmentSize;
+}
+
+void
+GsoTag::SetSegmenter (uint16_t protocolNumber, Segmenter segmenter)
+{
+  NS_LOG_FUNCTION (protocolNumber);
+  GetSegmenters ()[protocolNumber] = segmenter;
+}
+
+bool
+GsoTag::Segment (Ptr<Packet> packet, uint16_t protocolNumber, std::list<Ptr<Packet> > &segments)
+{
+  NS_LOG_FUNCTION (packet << protocolNumber);
+  GsoTag tag;
+  bool found = packet->PeekPacketTag (tag);
+  NS_ASSERT_MSG (found, "Not a super-segment");
+  std::map<uint16_t, Segmenter>::const_iterator it = GetSegmenters ().find (protocolNumber);
+  if (it == GetSegmenters ().end ())
+    {
+      NS_LOG_WARN ("No segmenter for protocol " << protocolNumber);
+      return false;
+    }
+  std::list<Ptr<Packet> >::iterator first = segments.insert (segments.end (), Ptr<Packet> ());
+  it->second (packet, tag.GetSegmentSize (), segments);
+  for (std::list<Ptr<Packet> >::iterator i = segments.erase (first); i != segments.end (); ++i)
+    {
+      (*i)->RemovePacketTag (tag);
+    }
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef GSO_TAG_H
+#define GSO_TAG_H
+
+#include <list>
+
+#include "ns3/tag.h"
+#include "ns3/ptr.h"
+#include "ns3/callback.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \ingroup network
+ *
+ * \brief Marks a super-segment, a packet larger than the MTU that is cut
+ * into wire sized packets by the device that transmits it (generic
+ * segmentation offload).
+ *
+ * The protocol that builds super-segments registers, for its L3 protocol
+ * number, the function that cuts them. Devices call Segment () on the
+ * packets that carry this tag, without knowing the headers inside.
+ */
+class GsoTag : public Tag
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+  GsoTag ();
+
+  /**
+   * Constructs a GsoTag
+   * \param segmentSize the payload size of each wire segment
+   */
+  GsoTag (uint16_t segmentSize);
+  /**
+   * \param segmentSize the payload size of each wire segment
+   */
+  void SetSegmentSize (uint16_t segmentSize);
+  /**
+   * \returns the payload size of each wire segment
+   */
+  uint16_t GetSegmentSize (void) const;
+
+  /**
+   * Cuts a super-segment, starting with its L3 header, into wire sized
+   * packets that also start with their L3 headers.
+   * The arguments are the super-segment, the payload size of each segment
+   * and the list to append the segments to.
+   */
+  typedef Callback<void, Ptr<Packet>, uint16_t, std::list<Ptr<Packet> > &> Segmenter;
+
+  /**
+   * Register the segmenter of an L3 protocol. Meant to be called while
+   * the libraries are loaded, before any simulation runs.
+   * \param protocolNumber the L3 protocol number, as given to NetDevice::Send
+   * \param segmenter the function that cuts the super-segments
+   */
+  static void SetSegmenter (uint16_t protocolNumber, Segmenter segmenter);
+
+  /**
+   * Cut a super-segment into wire sized packets. The tag is removed from
+   * the segments.
+   * \param packet the super-segment, starting with its L3 header and
+   * carrying a GsoTag
+   * \param protocolNumber the L3 protocol number of the packet
+   * \param segments the list to append the segments to
+   * \returns false if no segmenter is registered for protocolNumber
+   */
+  static bool Segment (Ptr<Packet> packet, uint16_t protocolNumber, std::list<Ptr<Packet> > &segments);
+
+private:
+  uint16_t m_segmentSize; //!< Payload size of each wire segment
+};
+
+} // namespace ns3
+
+#endif /* GSO_TAG_H */
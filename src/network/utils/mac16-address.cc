@@ -140,7 +140,7 @@ Mac16Address
 Mac16Address::Allocate (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  static uint64_t id = 0;
+  static thread_local uint64_t id = 0;
   id++;
   Mac16Address address;
   address.m_address[0] = (id >> 8) & 0xff;
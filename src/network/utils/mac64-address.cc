@@ -137,7 +137,7 @@ Mac64Address
 Mac64Address::Allocate (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  static uint64_t id = 0;
+  static thread_local uint64_t id = 0;
   id++;
   Mac64Address address;
   address.m_address[0] = (id >> 56) & 0xff;
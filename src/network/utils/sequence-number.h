@@ -86,16 +86,8 @@ public:
     return *this;
   }
 
-  /**
-   * \brief Constructs a SequenceNumber from an assignment of another sequence number
-   * \param value sequence number to copy
-   * \returns reference to the assignee
-   */
-  SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE>& operator= (SequenceNumber<NUMERIC_TYPE, SIGNED_TYPE> const &value)
-  {
-    m_value = value.m_value;
-    return *this;
-  }
+  // Copy construction and assignment are left implicit so that sequence
+  // numbers, and the structures embedding them, stay trivially copyable.
 
 #if 0
   // a SequenceNumber implicitly converts to a plain number, but not the other way around
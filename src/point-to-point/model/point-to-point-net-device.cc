@@ -25,6 +25,7 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/gso-tag.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
@@ -206,6 +207,32 @@ PointToPointNetDevice::ProcessHeader (Ptr<Packet> p, uint16_t& param)
   return true;
 }
 
+Ptr<Packet>
+PointToPointNetDevice::Segment (Ptr<Packet> p)
+{
+  GsoTag tag;
+  if (!p->PeekPacketTag (tag))
+    {
+      return p;
+    }
+  NS_LOG_FUNCTION (this << p << tag.GetSegmentSize ());
+  uint16_t protocol = 0;
+  Ptr<Packet> packet = p->Copy ();
+  ProcessHeader (packet, protocol);
+  if (!GsoTag::Segment (packet, protocol, m_gsoSegments))
+    {
+      return p;
+    }
+  for (std::list<Ptr<Packet> >::iterator it = m_gsoSegments.begin (); it != m_gsoSegments.end (); ++it)
+    {
+      AddHeader (*it, protocol);
+    }
+  NS_LOG_LOGIC ("Super-segment cut into " << m_gsoSegments.size () << " frames");
+  Ptr<Packet> first = m_gsoSegments.front ();
+  m_gsoSegments.pop_front ();
+  return first;
+}
+
 void
 PointToPointNetDevice::NotifyNewAggregate (void)
 {
@@ -231,6 +258,7 @@ PointToPointNetDevice::DoDispose ()
   m_channel = 0;
   m_receiveErrorModel = 0;
   m_currentPkt = 0;
+  m_gsoSegments.clear ();
   m_queue = 0;
   m_queueInterface = 0;
   NetDevice::DoDispose ();
@@ -299,6 +327,17 @@ PointToPointNetDevice::TransmitComplete (void)
   m_phyTxEndTrace (m_currentPkt);
   m_currentPkt = 0;
 
+  if (!m_gsoSegments.empty ())
+    {
+      // The frames of a super-segment go out before the next packet
+      Ptr<Packet> p = m_gsoSegments.front ();
+      m_gsoSegments.pop_front ();
+      m_snifferTrace (p);
+      m_promiscSnifferTrace (p);
+      TransmitStart (p);
+      return;
+    }
+
   Ptr<NetDeviceQueue> txq;
   if (m_queueInterface)
   {
@@ -337,7 +376,7 @@ PointToPointNetDevice::TransmitComplete (void)
           txq->Start ();
         }
     }
-  Ptr<Packet> p = item->GetPacket ();
+  Ptr<Packet> p = Segment (item->GetPacket ());
   m_snifferTrace (p);
   m_promiscSnifferTrace (p);
   TransmitStart (p);
@@ -596,7 +635,7 @@ PointToPointNetDevice::Send (
       // 
       if (m_txMachineState == READY)
         {
-          packet = m_queue->Dequeue ()->GetPacket ();
+          packet = Segment (m_queue->Dequeue ()->GetPacket ());
           // We have enqueued a packet and dequeued a (possibly different) packet. We
           // need to check if there is still room for another packet only if the queue
           // is in byte mode (the enqueued packet might be larger than the dequeued
@@ -695,6 +734,12 @@ PointToPointNetDevice::SupportsSendFrom (void) const
   return false;
 }
 
+bool
+PointToPointNetDevice::SupportsGso (void) const
+{
+  return true;
+}
+
 void
 PointToPointNetDevice::DoMpiReceive (Ptr<Packet> p)
 {
@@ -20,6 +20,7 @@
 #define POINT_TO_POINT_NET_DEVICE_H
 
 #include <cstring>
+#include <list>
 #include "ns3/address.h"
 #include "ns3/node.h"
 #include "ns3/net-device.h"
@@ -189,6 +190,7 @@ public:
 
   virtual void SetPromiscReceiveCallback (PromiscReceiveCallback cb);
   virtual bool SupportsSendFrom (void) const;
+  virtual bool SupportsGso (void) const;
 
 protected:
   /**
@@ -252,6 +254,15 @@ private:
    */
   bool ProcessHeader (Ptr<Packet> p, uint16_t& param);
 
+  /**
+   * Cuts a super-segment, dequeued as a whole, into wire sized frames.
+   * The frames but the first one wait in m_gsoSegments, to be transmitted
+   * before the next packet of the queue.
+   * \param p a packet dequeued, with its PPP header
+   * \returns p if it is not a super-segment, its first frame otherwise
+   */
+  Ptr<Packet> Segment (Ptr<Packet> p);
+
   /**
    * Start Sending a Packet Down the Wire.
    *
@@ -459,6 +470,7 @@ private:
   uint32_t m_mtu;
 
   Ptr<Packet> m_currentPkt; //!< Current packet processed
+  std::list<Ptr<Packet> > m_gsoSegments; //!< Frames left of the super-segment being transmitted
 
   /**
    * \brief PPP to Ethernet protocol number mapping
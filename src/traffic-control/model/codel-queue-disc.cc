@@ -28,6 +28,7 @@
 #include "ns3/log.h"
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/abort.h"
 #include "codel-queue-disc.h"
 #include "ns3/object-factory.h"
@@ -183,6 +184,16 @@ TypeId CoDelQueueDisc::GetTypeId (void)
                    StringValue ("5ms"),
                    MakeTimeAccessor (&CoDelQueueDisc::m_target),
                    MakeTimeChecker ())
+    .AddAttribute ("UseEcn",
+                   "True to mark ECN-capable packets instead of dropping them",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&CoDelQueueDisc::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CeThreshold",
+                   "The sojourn time above which ECN-capable packets are marked, 0 to disable",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&CoDelQueueDisc::m_ceThreshold),
+                   MakeTimeChecker ())
     .AddTraceSource ("Count",
                      "CoDel count",
                      MakeTraceSourceAccessor (&CoDelQueueDisc::m_count),
@@ -227,6 +238,9 @@ CoDelQueueDisc::CoDelQueueDisc ()
     m_state3 (0),
     m_states (0),
     m_dropOverLimit (0),
+    m_useEcn (false),
+    m_markCount (0),
+    m_ceMarkCount (0),
     m_sojourn (0)
 {
   NS_LOG_FUNCTION (this);
@@ -396,12 +410,21 @@ CoDelQueueDisc::DoDequeue (void)
               // A large amount of packets in queue might result in drop
               // rates so high that the next drop should happen now,
               // hence the while loop.
+              ++m_count;
+              NewtonStep ();
+              if (m_useEcn && item->Mark ())
+                {
+                  // A mark does not shorten the queue: keep the packet
+                  // and schedule the next mark
+                  NS_LOG_LOGIC ("Sojourn time is still above target and it's time for next drop; marking " << p);
+                  ++m_markCount;
+                  m_dropNext = ControlLaw (m_dropNext);
+                  break;
+                }
               NS_LOG_LOGIC ("Sojourn time is still above target and it's time for next drop; dropping " << p);
               Drop (item);
 
               ++m_dropCount;
-              ++m_count;
-              NewtonStep ();
               if (GetInternalQueue (0)->IsEmpty ())
                 {
                   m_dropping = false;
@@ -440,28 +463,37 @@ CoDelQueueDisc::DoDequeue (void)
       if (okToDrop)
         {
           // Drop the first packet and enter dropping state unless the queue is empty
-          NS_LOG_LOGIC ("Sojourn time goes above target, dropping the first packet " << p << " and entering the dropping state");
-          ++m_dropCount;
-          Drop (item);
-
-          if (GetInternalQueue (0)->IsEmpty ())
+          if (m_useEcn && item->Mark ())
             {
-              m_dropping = false;
-              okToDrop = false;
-              NS_LOG_LOGIC ("Queue empty");
-              ++m_states;
+              NS_LOG_LOGIC ("Sojourn time goes above target, marking the first packet " << p << " and entering the dropping state");
+              ++m_markCount;
+              m_dropping = true;
             }
           else
             {
-              item = StaticCast<QueueDiscItem> (GetInternalQueue (0)->Dequeue ());
-              p = item->GetPacket ();
+              NS_LOG_LOGIC ("Sojourn time goes above target, dropping the first packet " << p << " and entering the dropping state");
+              ++m_dropCount;
+              Drop (item);
 
-              NS_LOG_LOGIC ("Popped " << item);
-              NS_LOG_LOGIC ("Number packets remaining " << GetInternalQueue (0)->GetNPackets ());
-              NS_LOG_LOGIC ("Number bytes remaining " << GetInternalQueue (0)->GetNBytes ());
+              if (GetInternalQueue (0)->IsEmpty ())
+                {
+                  m_dropping = false;
+                  okToDrop = false;
+                  NS_LOG_LOGIC ("Queue empty");
+                  ++m_states;
+                }
+              else
+                {
+                  item = StaticCast<QueueDiscItem> (GetInternalQueue (0)->Dequeue ());
+                  p = item->GetPacket ();
 
-              okToDrop = OkToDrop (p, now);
-              m_dropping = true;
+                  NS_LOG_LOGIC ("Popped " << item);
+                  NS_LOG_LOGIC ("Number packets remaining " << GetInternalQueue (0)->GetNPackets ());
+                  NS_LOG_LOGIC ("Number bytes remaining " << GetInternalQueue (0)->GetNBytes ());
+
+                  okToDrop = OkToDrop (p, now);
+                  m_dropping = true;
+                }
             }
           ++m_state3;
           /*
@@ -486,6 +518,12 @@ CoDelQueueDisc::DoDequeue (void)
           NS_LOG_LOGIC ("Scheduled next drop at " << (double)m_dropNext / 1000000 << " now " << (double)now / 1000000);
         }
     }
+  // Mark the packets delayed beyond the CE threshold, whatever the state
+  if (item && m_ceThreshold > Seconds (0) && m_sojourn.Get () > m_ceThreshold && item->Mark ())
+    {
+      NS_LOG_LOGIC ("Sojourn time above the CE threshold; marking " << p);
+      ++m_ceMarkCount;
+    }
   ++m_states;
   return item;
 }
@@ -520,6 +558,18 @@ CoDelQueueDisc::GetDropCount (void)
   return m_dropCount;
 }
 
+uint32_t
+CoDelQueueDisc::GetMarkCount (void)
+{
+  return m_markCount;
+}
+
+uint32_t
+CoDelQueueDisc::GetCeMarkCount (void)
+{
+  return m_ceMarkCount;
+}
+
 Time
 CoDelQueueDisc::GetTarget (void)
 {
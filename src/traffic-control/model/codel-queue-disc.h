@@ -114,6 +114,21 @@ public:
    */
   uint32_t GetDropCount (void);
 
+  /**
+   * \brief Get the number of packets marked according to CoDel algorithm
+   *
+   * \returns The number of packets marked instead of dropped, with UseEcn
+   */
+  uint32_t GetMarkCount (void);
+
+  /**
+   * \brief Get the number of packets marked because their sojourn time
+   * exceeded the CE threshold
+   *
+   * \returns The number of marked packets
+   */
+  uint32_t GetCeMarkCount (void);
+
   /**
    * \brief Get the target queue delay
    *
@@ -243,6 +258,10 @@ private:
   uint32_t m_states;                      //!< Total number of times we are in state 1, state 2, or state 3
   uint32_t m_dropOverLimit;               //!< The number of packets dropped due to full queue
   Queue::QueueMode     m_mode;                   //!< The operating mode (Bytes or packets)
+  bool m_useEcn;                          //!< True to mark ECN-capable packets instead of dropping them
+  Time m_ceThreshold;                     //!< Sojourn time above which packets are marked, 0 to disable
+  uint32_t m_markCount;                   //!< Number of packets marked according CoDel algorithm
+  uint32_t m_ceMarkCount;                 //!< Number of packets marked above the CE threshold
   TracedValue<Time> m_sojourn;            //!< Time in queue
 };
 
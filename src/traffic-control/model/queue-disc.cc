@@ -68,6 +68,12 @@ QueueDiscItem::SetTxQueueIndex (uint8_t txq)
   m_txq = txq;
 }
 
+bool
+QueueDiscItem::Mark (void)
+{
+  return false;
+}
+
 void
 QueueDiscItem::Print (std::ostream& os) const
 {
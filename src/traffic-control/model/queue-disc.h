@@ -85,6 +85,17 @@ public:
    */
   virtual void AddHeader (void) = 0;
 
+  /**
+   * \brief Mark the packet as having experienced congestion
+   *
+   * Queue discs using ECN call this method instead of dropping the packet.
+   * Subclasses whose header carries the ECN field set it to CE if the packet
+   * is ECN-capable. The default implementation cannot mark any packet.
+   *
+   * \return true if the packet is marked, false if it is not ECN-capable
+   */
+  virtual bool Mark (void);
+
   /**
    * \brief Print the item contents.
    * \param os output stream in which the data should be printed.
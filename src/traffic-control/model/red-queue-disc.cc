@@ -183,6 +183,16 @@ TypeId RedQueueDisc::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&RedQueueDisc::m_isNs1Compat),
                    MakeBooleanChecker ())
+    .AddAttribute ("UseEcn",
+                   "True to mark ECN-capable packets instead of dropping them",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RedQueueDisc::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UseHardDrop",
+                   "True to always drop packets above max threshold, even with UseEcn",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&RedQueueDisc::m_useHardDrop),
+                   MakeBooleanChecker ())
     .AddAttribute ("LinkBandwidth", 
                    "The RED link bandwidth",
                    DataRateValue (DataRate ("1.5Mbps")),
@@ -349,6 +359,7 @@ RedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   m_countBytes += item->GetPacketSize ();
 
   uint32_t dropType = DTYPE_NONE;
+  bool full = false;
   if (m_qAvg >= m_minTh && nQueued > 1)
     {
       if ((!m_isGentle && m_qAvg >= m_maxTh) ||
@@ -387,10 +398,23 @@ RedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
     {
       NS_LOG_DEBUG ("\t Dropping due to Queue Full " << nQueued);
       dropType = DTYPE_FORCED;
+      full = true;
       m_stats.qLimDrop++;
     }
 
-  if (dropType == DTYPE_UNFORCED)
+  // ECN-capable packets are marked rather than dropped, unless the queue is
+  // full or, with UseHardDrop, the average queue is above max threshold
+  if (dropType == DTYPE_UNFORCED && m_useEcn && item->Mark ())
+    {
+      NS_LOG_DEBUG ("\t Marking due to Prob Mark " << m_qAvg);
+      m_stats.unforcedMark++;
+    }
+  else if (dropType == DTYPE_FORCED && !full && m_useEcn && !m_useHardDrop && item->Mark ())
+    {
+      NS_LOG_DEBUG ("\t Marking due to Hard Mark " << m_qAvg);
+      m_stats.forcedMark++;
+    }
+  else if (dropType == DTYPE_UNFORCED)
     {
       NS_LOG_DEBUG ("\t Dropping due to Prob Mark " << m_qAvg);
       m_stats.unforcedDrop++;
@@ -471,6 +495,8 @@ RedQueueDisc::InitializeParams (void)
   m_stats.forcedDrop = 0;
   m_stats.unforcedDrop = 0;
   m_stats.qLimDrop = 0;
+  m_stats.unforcedMark = 0;
+  m_stats.forcedMark = 0;
 
   m_qAvg = 0.0;
   m_count = 0;
@@ -644,7 +670,6 @@ RedQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
       // DROP or MARK
       m_count = 0;
       m_countBytes = 0;
-      /// \todo Implement set bit to mark
 
       return 1; // drop
     }
@@ -108,6 +108,8 @@ public:
     uint32_t unforcedDrop;  //!< Early probability drops
     uint32_t forcedDrop;    //!< Forced drops, qavg > max threshold
     uint32_t qLimDrop;      //!< Drops due to queue limits
+    uint32_t unforcedMark;  //!< Early probability marks
+    uint32_t forcedMark;    //!< Forced marks, qavg > max threshold
   } Stats;
 
   /** 
@@ -296,6 +298,8 @@ private:
   double m_beta;            //!< Decrement parameter for m_curMaxP in ARED
   Time m_rtt;               //!< Rtt to be considered while automatically setting m_bottom in ARED
   bool m_isNs1Compat;       //!< Ns-1 compatibility
+  bool m_useEcn;            //!< True to mark ECN-capable packets instead of dropping them
+  bool m_useHardDrop;       //!< True to drop, rather than mark, when qavg > max threshold
   DataRate m_linkBandwidth; //!< Link bandwidth
   Time m_linkDelay;         //!< Link delay
 
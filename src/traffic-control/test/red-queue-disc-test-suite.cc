@@ -33,18 +33,21 @@ using namespace ns3;
 
 class RedQueueDiscTestItem : public QueueDiscItem {
 public:
-  RedQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol);
+  RedQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, bool ecnCapable = false);
   virtual ~RedQueueDiscTestItem ();
   virtual void AddHeader (void);
+  virtual bool Mark (void);
 
 private:
   RedQueueDiscTestItem ();
   RedQueueDiscTestItem (const RedQueueDiscTestItem &);
   RedQueueDiscTestItem &operator = (const RedQueueDiscTestItem &);
+  bool m_ecnCapable;
 };
 
-RedQueueDiscTestItem::RedQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol)
-  : QueueDiscItem (p, addr, protocol)
+RedQueueDiscTestItem::RedQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, bool ecnCapable)
+  : QueueDiscItem (p, addr, protocol),
+    m_ecnCapable (ecnCapable)
 {
 }
 
@@ -57,13 +60,19 @@ RedQueueDiscTestItem::AddHeader (void)
 {
 }
 
+bool
+RedQueueDiscTestItem::Mark (void)
+{
+  return m_ecnCapable;
+}
+
 class RedQueueDiscTestCase : public TestCase
 {
 public:
   RedQueueDiscTestCase ();
   virtual void DoRun (void);
 private:
-  void Enqueue (Ptr<RedQueueDisc> queue, uint32_t size, uint32_t nPkt);
+  void Enqueue (Ptr<RedQueueDisc> queue, uint32_t size, uint32_t nPkt, bool ecnCapable = false);
   void RunRedTest (StringValue mode);
 };
 
@@ -287,15 +296,61 @@ RedQueueDiscTestCase::RunRedTest (StringValue mode)
   st = StaticCast<RedQueueDisc> (queue)->GetStats ();
   drop.test7 = st.unforcedDrop + st.forcedDrop + st.qLimDrop;
   NS_TEST_EXPECT_MSG_GT (drop.test7, drop.test3, "Test 7 should have more drops than test 3");
+
+
+  // test 8: as test 3, with ECN-capable packets marked instead of dropped
+  queue = CreateObject<RedQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
+                         "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MinTh", DoubleValue (minTh)), true,
+                         "Verify that we can actually set the attribute MinTh");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxTh", DoubleValue (maxTh)), true,
+                         "Verify that we can actually set the attribute MaxTh");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QW", DoubleValue (0.020)), true,
+                         "Verify that we can actually set the attribute QW");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseEcn", BooleanValue (true)), true,
+                         "Verify that we can actually set the attribute UseEcn");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseHardDrop", BooleanValue (false)), true,
+                         "Verify that we can actually set the attribute UseHardDrop");
+  queue->Initialize ();
+  Enqueue (queue, pktSize, 300, true);
+  st = StaticCast<RedQueueDisc> (queue)->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.unforcedDrop + st.forcedDrop, 0, "There should be no early drops with ECN");
+  NS_TEST_EXPECT_MSG_GT (st.unforcedMark + st.forcedMark, 0, "There should be marked packets with ECN");
+
+
+  // test 9: as test 8, but the packets are not ECN-capable
+  queue = CreateObject<RedQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
+                         "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MinTh", DoubleValue (minTh)), true,
+                         "Verify that we can actually set the attribute MinTh");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxTh", DoubleValue (maxTh)), true,
+                         "Verify that we can actually set the attribute MaxTh");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QW", DoubleValue (0.020)), true,
+                         "Verify that we can actually set the attribute QW");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseEcn", BooleanValue (true)), true,
+                         "Verify that we can actually set the attribute UseEcn");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseHardDrop", BooleanValue (false)), true,
+                         "Verify that we can actually set the attribute UseHardDrop");
+  queue->Initialize ();
+  Enqueue (queue, pktSize, 300);
+  st = StaticCast<RedQueueDisc> (queue)->GetStats ();
+  NS_TEST_EXPECT_MSG_GT (st.unforcedDrop + st.forcedDrop, 0, "Packets not ECN-capable should be dropped");
+  NS_TEST_EXPECT_MSG_EQ (st.unforcedMark + st.forcedMark, 0, "Packets not ECN-capable should not be marked");
 }
 
 void 
-RedQueueDiscTestCase::Enqueue (Ptr<RedQueueDisc> queue, uint32_t size, uint32_t nPkt)
+RedQueueDiscTestCase::Enqueue (Ptr<RedQueueDisc> queue, uint32_t size, uint32_t nPkt, bool ecnCapable)
 {
   Address dest;
   for (uint32_t i = 0; i < nPkt; i++)
     {
-      queue->Enqueue (Create<RedQueueDiscTestItem> (Create<Packet> (size), dest, 0));
+      queue->Enqueue (Create<RedQueueDiscTestItem> (Create<Packet> (size), dest, 0, ecnCapable));
     }
 }
 
@@ -0,0 +1,257 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Benchmark of the cost of scheduling and running events.
+ *
+ * A population of events reschedule themselves until a total number of
+ * events has run, for the usual shapes of Simulator::Schedule: a member
+ * function with no argument, a member function with the packet and the
+ * values TCP passes around, a plain function, and a bound callback. The
+ * global operator new is counted to report the heap allocations per event;
+ * the map scheduler, the default one, allocates a node for each event.
+ */
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+#include "ns3/core-module.h"
+#include "ns3/packet.h"
+
+using namespace ns3;
+
+#define LOG(x)   std::cout << x << std::endl
+
+// Output field width
+int g_fwidth = 14;
+
+/** Number of calls to the global operator new. */
+static uint64_t g_allocations = 0;
+
+// The replacements are kept out of line: once inlined into a new or delete
+// expression, GCC sees a free of memory from operator new and warns about
+// mismatched allocation functions (-Wmismatched-new-delete).
+__attribute__ ((noinline)) void *
+operator new (std::size_t size)
+{
+  g_allocations++;
+  void *p = std::malloc (size == 0 ? 1 : size);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+__attribute__ ((noinline)) void
+operator delete (void *p) noexcept
+{
+  std::free (p);
+}
+
+__attribute__ ((noinline)) void
+operator delete (void *p, std::size_t size) noexcept
+{
+  std::free (p);
+}
+
+class EventBench
+{
+public:
+  EventBench (uint32_t population, uint32_t total);
+
+  /**
+   * Run one shape of events
+   * \param name the name of the shape
+   * \param start the function starting one event of the shape
+   */
+  void Run (std::string name, void (EventBench::*start)(void));
+
+  void StartMember0 (void);
+  void StartMember2 (void);
+  void StartFunction (void);
+  void StartCallback (void);
+
+private:
+  bool Done (void);
+  void Member0 (void);
+  void Member2 (Ptr<Packet> p, uint32_t seq);
+  static void Function (EventBench *bench);
+  void Bound (void);
+  static void InvokeCallback (Callback<void> cb);
+
+  uint32_t m_population;
+  uint32_t m_total;
+  uint32_t m_count;
+  Ptr<Packet> m_packet;
+};
+
+EventBench::EventBench (uint32_t population, uint32_t total)
+  : m_population (population),
+    m_total (total),
+    m_count (0)
+{
+  m_packet = Create<Packet> (100);
+}
+
+bool
+EventBench::Done (void)
+{
+  return ++m_count >= m_total;
+}
+
+void
+EventBench::StartMember0 (void)
+{
+  Simulator::Schedule (NanoSeconds (1), &EventBench::Member0, this);
+}
+
+void
+EventBench::Member0 (void)
+{
+  if (!Done ())
+    {
+      StartMember0 ();
+    }
+}
+
+void
+EventBench::StartMember2 (void)
+{
+  Simulator::Schedule (NanoSeconds (1), &EventBench::Member2, this, m_packet, m_count);
+}
+
+void
+EventBench::Member2 (Ptr<Packet> p, uint32_t seq)
+{
+  if (!Done ())
+    {
+      StartMember2 ();
+    }
+}
+
+void
+EventBench::StartFunction (void)
+{
+  Simulator::Schedule (NanoSeconds (1), &EventBench::Function, this);
+}
+
+void
+EventBench::Function (EventBench *bench)
+{
+  if (!bench->Done ())
+    {
+      bench->StartFunction ();
+    }
+}
+
+void
+EventBench::StartCallback (void)
+{
+  Simulator::Schedule (NanoSeconds (1), &EventBench::InvokeCallback,
+                       MakeCallback (&EventBench::Bound, this));
+}
+
+void
+EventBench::Bound (void)
+{
+  if (!Done ())
+    {
+      StartCallback ();
+    }
+}
+
+void
+EventBench::InvokeCallback (Callback<void> cb)
+{
+  cb ();
+}
+
+void
+EventBench::Run (std::string name, void (EventBench::*start)(void))
+{
+  m_count = 0;
+  for (uint32_t i = 0; i < m_population; ++i)
+    {
+      (this->*start)();
+    }
+  // Warm up, then measure the steady state
+  Simulator::Run ();
+
+  m_count = 0;
+  for (uint32_t i = 0; i < m_population; ++i)
+    {
+      (this->*start)();
+    }
+  uint64_t eventStart = Simulator::GetEventCount ();
+  uint64_t allocStart = g_allocations;
+  SystemWallClockMs wall;
+  wall.Start ();
+  Simulator::Run ();
+  double elapsed = wall.End () / 1000.0;
+  uint64_t allocations = g_allocations - allocStart;
+  uint64_t events = Simulator::GetEventCount () - eventStart;
+
+  LOG (std::left << std::setw (g_fwidth) << name <<
+       std::right << std::setw (g_fwidth) << elapsed <<
+       std::setw (g_fwidth) << events <<
+       std::setw (g_fwidth) << (events / elapsed) <<
+       std::setw (g_fwidth) << (double (allocations) / events));
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t population = 1000;
+  uint32_t total = 10000000;
+  std::string scheduler = "ns3::MapScheduler";
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the scheduling of events.\n"
+             "\n"
+             "Reports the events run per second and the heap allocations\n"
+             "per event for the usual shapes of Simulator::Schedule.");
+  cmd.AddValue ("population", "number of events in the queue (default 1000)",    population);
+  cmd.AddValue ("total",      "number of events to run (default 1E7)",           total);
+  cmd.AddValue ("scheduler",  "scheduler type (default ns3::MapScheduler)",      scheduler);
+  cmd.Parse (argc, argv);
+
+  ObjectFactory factory;
+  factory.SetTypeId (scheduler);
+  Simulator::SetScheduler (factory);
+
+  LOG (cmd.GetName () << ": population " << population << " total " << total <<
+       " scheduler " << scheduler);
+
+  EventBench bench (population, total);
+
+  LOG ("");
+  LOG (std::left << std::setw (g_fwidth) << "Event" <<
+       std::right << std::setw (g_fwidth) << "Time (s)" <<
+       std::setw (g_fwidth) << "Events" <<
+       std::setw (g_fwidth) << "Rate (ev/s)" <<
+       std::setw (g_fwidth) << "Allocs/event");
+  bench.Run ("member0", &EventBench::StartMember0);
+  bench.Run ("member2", &EventBench::StartMember2);
+  bench.Run ("function", &EventBench::StartFunction);
+  bench.Run ("callback", &EventBench::StartCallback);
+  LOG ("");
+
+  Simulator::Destroy ();
+  return 0;
+}
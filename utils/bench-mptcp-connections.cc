@@ -0,0 +1,517 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of Sussex
+ * Copyright (c) 2015 Université Pierre et Marie Curie (UPMC)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Connection-scale benchmark for MPTCP.
+ *
+ * Opens many MPTCP connections with several subflows each over a
+ * multi-plane dumbbell: every host has one interface per plane and each
+ * plane has its own pair of routers and bottleneck, so that the subflows
+ * of a connection follow disjoint paths.
+ *
+ *   client i --+-- left router (plane k) ---- right router (plane k) --+-- server i
+ *
+ * The run is split in three phases, measured separately:
+ *  - handshake: connections are opened during the ramp-up, each one sends
+ *    a short greeting to become fully established and then joins one
+ *    subflow per remaining plane;
+ *  - steady: every connection transfers data for a fixed simulated time;
+ *  - teardown: all connections are closed, and their subflows go through
+ *    TIME_WAIT.
+ *
+ * For each phase the wall clock time, simulated time, number of events,
+ * event rate and peak resident set size are written as JSON, on the
+ * standard output or in the file given by --json.
+ */
+
+#include <sys/resource.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/mptcp-socket-factory.h"
+#include "ns3/mptcp-meta-socket.h"
+#include "ns3/mptcp-subflow.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("BenchMpTcpConnections");
+
+#define LOG(x)   std::cerr << x << std::endl
+
+/// Ephemeral ports available to the sockets of a host
+static const uint32_t EPHEMERAL_PORTS = 65535 - 49152;
+
+static void
+StopSimulation (void)
+{
+  Simulator::Stop ();
+}
+
+/**
+ * Metrics of one phase of the benchmark
+ */
+struct PhaseResult
+{
+  std::string name;     //!< Phase name
+  double wallSeconds;   //!< Wall clock time spent in the phase
+  double simSeconds;    //!< Simulated time spent in the phase
+  uint64_t events;      //!< Events executed during the phase
+  long peakRssKb;       //!< Peak resident set size at the end of the phase
+  uint32_t completed;   //!< Connections (or subflows) that completed the phase
+  uint32_t expected;    //!< Connections (or subflows) expected to complete it
+};
+
+/**
+ * Drives the connections and collects the per-phase metrics
+ */
+class MpTcpConnectionBench
+{
+public:
+  MpTcpConnectionBench ();
+
+  void Setup (void);
+  void Run (void);
+  void Report (std::ostream &os) const;
+
+  uint32_t m_connections;   //!< Number of MPTCP connections
+  uint32_t m_subflows;      //!< Subflows per connection, one per plane
+  uint32_t m_hosts;         //!< Clients (and servers) per side
+  uint32_t m_greeting;      //!< Bytes sent to become fully established
+  uint32_t m_writeSize;     //!< Size of the application writes
+  double m_rampUp;          //!< Seconds over which the connections are opened
+  double m_handshakeLimit;  //!< Simulated seconds allowed to the handshake phase
+  double m_steady;          //!< Simulated seconds of data transfer
+  double m_teardownLimit;   //!< Simulated seconds allowed to the teardown phase
+  double m_msl;             //!< Maximum segment lifetime, bounds the TIME_WAIT state
+  std::string m_accessRate;
+  std::string m_bottleneckRate;
+  std::string m_delay;
+
+private:
+  PhaseResult RunPhase (const std::string &name, double limit, uint32_t expected);
+  void CheckPhaseDone (void);
+  uint32_t PhaseCompleted (void) const;
+
+  void Connect (uint32_t i);
+  void FullyEstablished (Ptr<MpTcpMetaSocket> meta);
+  void SubflowSucceeded (Ptr<MpTcpSubflow> sf);
+  void SubflowFailed (Ptr<MpTcpSubflow> sf);
+  void HandleSend (Ptr<Socket> sock, uint32_t available);
+  void Accept (Ptr<Socket> sock, const Address &from);
+  void HandleRecv (Ptr<Socket> sock);
+  void ServerClosed (Ptr<Socket> sock);
+
+  enum Phase
+  {
+    HANDSHAKE,
+    STEADY,
+    TEARDOWN
+  };
+
+  Phase m_phase;
+  NodeContainer m_clients;
+  NodeContainer m_servers;
+  /// Address of server j on plane k, indexed by j * m_subflows + k
+  std::vector<Ipv4Address> m_serverAddresses;
+  /// Address of client i on plane k, indexed by i * m_subflows + k
+  std::vector<Ipv4Address> m_clientAddresses;
+  std::vector<Ptr<MpTcpMetaSocket> > m_metas;
+  std::map<Ptr<Socket>, uint32_t> m_index;  //!< Connection index of a client meta socket
+  std::vector<Ptr<Socket> > m_accepted;
+  std::vector<uint32_t> m_txBytes;          //!< Bytes written per connection
+  std::vector<uint8_t> m_payload;
+
+  uint32_t m_established;
+  uint32_t m_joined;
+  uint32_t m_joinFailed;
+  uint32_t m_closed;       //!< Connections whose DATA_FIN was accepted by the server
+  uint64_t m_rxBytes;
+  std::vector<PhaseResult> m_results;
+};
+
+MpTcpConnectionBench::MpTcpConnectionBench ()
+  : m_connections (1000),
+    m_subflows (2),
+    m_hosts (16),
+    m_greeting (100),
+    m_writeSize (1400),
+    m_rampUp (1.0),
+    m_handshakeLimit (30.0),
+    m_steady (2.0),
+    m_teardownLimit (30.0),
+    m_msl (1.0),
+    m_accessRate ("1Gbps"),
+    m_bottleneckRate ("10Gbps"),
+    m_delay ("1ms"),
+    m_phase (HANDSHAKE),
+    m_established (0),
+    m_joined (0),
+    m_joinFailed (0),
+    m_closed (0),
+    m_rxBytes (0)
+{
+}
+
+void
+MpTcpConnectionBench::Setup (void)
+{
+  NS_ABORT_MSG_UNLESS (m_subflows >= 1 && m_subflows <= 254, "1 to 254 subflows");
+  NS_ABORT_MSG_UNLESS (m_hosts >= 1 && m_hosts <= m_connections, "Between 1 and --connections hosts");
+  uint32_t portsPerHost = (m_connections + m_hosts - 1) / m_hosts * m_subflows;
+  NS_ABORT_MSG_UNLESS (portsPerHost < EPHEMERAL_PORTS,
+                       "Each client would need " << portsPerHost << " ephemeral ports, use more --hosts");
+
+  m_clients.Create (m_hosts);
+  m_servers.Create (m_hosts);
+  NodeContainer routers;
+  routers.Create (2 * m_subflows);
+
+  InternetStackHelper internet;
+  internet.Install (m_clients);
+  internet.Install (m_servers);
+  internet.Install (routers);
+
+  PointToPointHelper access;
+  access.SetDeviceAttribute ("DataRate", StringValue (m_accessRate));
+  access.SetChannelAttribute ("Delay", StringValue (m_delay));
+  PointToPointHelper bottleneck;
+  bottleneck.SetDeviceAttribute ("DataRate", StringValue (m_bottleneckRate));
+  bottleneck.SetChannelAttribute ("Delay", StringValue (m_delay));
+
+  m_clientAddresses.resize (m_hosts * m_subflows);
+  m_serverAddresses.resize (m_hosts * m_subflows);
+  // Static routes: the hosts are multihomed, global routing would make them
+  // transit nodes between the planes and send the replies on any plane
+  Ipv4StaticRoutingHelper routing;
+  Ipv4AddressHelper address;
+  for (uint32_t k = 0; k < m_subflows; ++k)
+    {
+      Ptr<Node> left = routers.Get (2 * k);
+      Ptr<Node> right = routers.Get (2 * k + 1);
+
+      // One /30 per link in 10.<k + 1>.0.0/16
+      std::ostringstream base;
+      base << "10." << k + 1 << ".0.0";
+      Ipv4Address plane (base.str ().c_str ());
+      address.SetBase (plane, "255.255.255.252");
+      Ipv4InterfaceContainer itf = address.Assign (bottleneck.Install (left, right));
+      routing.GetStaticRouting (left->GetObject<Ipv4> ())->SetDefaultRoute (itf.GetAddress (1), itf.Get (0).second);
+      routing.GetStaticRouting (right->GetObject<Ipv4> ())->SetDefaultRoute (itf.GetAddress (0), itf.Get (1).second);
+      address.NewNetwork ();
+      for (uint32_t i = 0; i < m_hosts; ++i)
+        {
+          itf = address.Assign (access.Install (m_clients.Get (i), left));
+          m_clientAddresses[i * m_subflows + k] = itf.GetAddress (0);
+          routing.GetStaticRouting (itf.Get (0).first)->AddNetworkRouteTo (plane, Ipv4Mask ("255.255.0.0"),
+                                                                           itf.GetAddress (1), itf.Get (0).second);
+          address.NewNetwork ();
+          itf = address.Assign (access.Install (m_servers.Get (i), right));
+          m_serverAddresses[i * m_subflows + k] = itf.GetAddress (0);
+          routing.GetStaticRouting (itf.Get (0).first)->AddNetworkRouteTo (plane, Ipv4Mask ("255.255.0.0"),
+                                                                           itf.GetAddress (1), itf.Get (0).second);
+          address.NewNetwork ();
+        }
+    }
+
+  for (uint32_t i = 0; i < m_hosts; ++i)
+    {
+      Ptr<Socket> listening = m_servers.Get (i)->GetObject<MpTcpSocketFactory> ()->CreateSocket ();
+      listening->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+      listening->Listen ();
+      listening->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                                    MakeCallback (&MpTcpConnectionBench::Accept, this));
+    }
+
+  m_payload.resize (m_writeSize, 'x');
+  m_txBytes.resize (m_connections, 0);
+  m_metas.resize (m_connections);
+  for (uint32_t i = 0; i < m_connections; ++i)
+    {
+      Ptr<Node> client = m_clients.Get (i % m_hosts);
+      Ptr<MpTcpMetaSocket> meta = DynamicCast<MpTcpMetaSocket> (client->GetObject<MpTcpSocketFactory> ()->CreateSocket ());
+      NS_ABORT_MSG_UNLESS (meta, "MPTCP socket factory should create meta sockets");
+      meta->SetFullyEstablishedCallback (MakeCallback (&MpTcpConnectionBench::FullyEstablished, this));
+      meta->SetSubflowConnectCallback (MakeCallback (&MpTcpConnectionBench::SubflowSucceeded, this),
+                                       MakeCallback (&MpTcpConnectionBench::SubflowFailed, this));
+      meta->SetSendCallback (MakeCallback (&MpTcpConnectionBench::HandleSend, this));
+      m_metas[i] = meta;
+      m_index[meta] = i;
+
+      // The queue discs of the devices are only set up once the nodes are initialized
+      Time start = MilliSeconds (1) + Seconds (m_rampUp * i / m_connections);
+      Simulator::Schedule (start, &MpTcpConnectionBench::Connect, this, i);
+    }
+}
+
+void
+MpTcpConnectionBench::Connect (uint32_t i)
+{
+  uint32_t host = i % m_hosts;
+  Ptr<MpTcpMetaSocket> meta = m_metas[i];
+  meta->Bind (InetSocketAddress (m_clientAddresses[host * m_subflows], 0));
+  meta->Connect (InetSocketAddress (m_serverAddresses[host * m_subflows], 50000));
+}
+
+void
+MpTcpConnectionBench::FullyEstablished (Ptr<MpTcpMetaSocket> meta)
+{
+  m_established++;
+  uint32_t host = m_index[meta] % m_hosts;
+  for (uint32_t k = 1; k < m_subflows; ++k)
+    {
+      meta->ConnectNewSubflow (InetSocketAddress (m_clientAddresses[host * m_subflows + k], 0),
+                               InetSocketAddress (m_serverAddresses[host * m_subflows + k], 50000));
+    }
+  CheckPhaseDone ();
+}
+
+void
+MpTcpConnectionBench::SubflowSucceeded (Ptr<MpTcpSubflow> sf)
+{
+  // The master subflow is accounted for by FullyEstablished
+  if (!sf->IsMaster ())
+    {
+      m_joined++;
+      CheckPhaseDone ();
+    }
+}
+
+void
+MpTcpConnectionBench::SubflowFailed (Ptr<MpTcpSubflow> sf)
+{
+  m_joinFailed++;
+}
+
+void
+MpTcpConnectionBench::HandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  uint32_t i = m_index[sock];
+  if (m_phase == HANDSHAKE)
+    {
+      if (m_txBytes[i] == 0 && sock->GetTxAvailable () >= m_greeting)
+        {
+          m_txBytes[i] += sock->Send (&m_payload[0], m_greeting, 0);
+        }
+      return;
+    }
+  if (m_phase != STEADY)
+    {
+      return;
+    }
+  while (sock->GetTxAvailable () >= m_writeSize)
+    {
+      int sent = sock->Send (&m_payload[0], m_writeSize, 0);
+      if (sent <= 0)
+        {
+          break;
+        }
+      m_txBytes[i] += sent;
+    }
+}
+
+void
+MpTcpConnectionBench::Accept (Ptr<Socket> sock, const Address &from)
+{
+  sock->SetRecvCallback (MakeCallback (&MpTcpConnectionBench::HandleRecv, this));
+  sock->SetCloseCallbacks (MakeCallback (&MpTcpConnectionBench::ServerClosed, this),
+                           MakeCallback (&MpTcpConnectionBench::ServerClosed, this));
+  m_accepted.push_back (sock);
+}
+
+void
+MpTcpConnectionBench::HandleRecv (Ptr<Socket> sock)
+{
+  Ptr<Packet> p;
+  while ((p = sock->Recv ()))
+    {
+      m_rxBytes += p->GetSize ();
+    }
+}
+
+void
+MpTcpConnectionBench::ServerClosed (Ptr<Socket> sock)
+{
+  // The DATA_FIN of the client was accepted, close our side
+  m_closed++;
+  sock->Close ();
+}
+
+uint32_t
+MpTcpConnectionBench::PhaseCompleted (void) const
+{
+  switch (m_phase)
+    {
+    case HANDSHAKE:
+      return m_established + m_joined;
+    case STEADY:
+      return m_established;
+    default:
+      return m_closed;
+    }
+}
+
+void
+MpTcpConnectionBench::CheckPhaseDone (void)
+{
+  if (m_phase == HANDSHAKE && PhaseCompleted () == m_connections * m_subflows)
+    {
+      Simulator::Stop ();
+    }
+}
+
+PhaseResult
+MpTcpConnectionBench::RunPhase (const std::string &name, double limit, uint32_t expected)
+{
+  LOG ("Running " << name << " phase");
+  PhaseResult result;
+  result.name = name;
+  result.expected = expected;
+
+  Time simStart = Simulator::Now ();
+  uint64_t eventStart = Simulator::GetEventCount ();
+  SystemWallClockMs wall;
+  wall.Start ();
+  // Not Simulator::Stop (delay): the deadline of a phase that completed
+  // early must not stop the next one
+  EventId deadline = Simulator::Schedule (Seconds (limit), &StopSimulation);
+  Simulator::Run ();
+  deadline.Cancel ();
+  result.wallSeconds = wall.End () / 1000.0;
+  result.simSeconds = (Simulator::Now () - simStart).GetSeconds ();
+  result.events = Simulator::GetEventCount () - eventStart;
+
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  result.peakRssKb = usage.ru_maxrss;
+  result.completed = PhaseCompleted ();
+
+  LOG ("  " << result.completed << "/" << expected << " done in " << result.simSeconds
+       << " simulated seconds, " << result.wallSeconds << " s, " << result.events << " events");
+  return result;
+}
+
+void
+MpTcpConnectionBench::Run (void)
+{
+  m_phase = HANDSHAKE;
+  m_results.push_back (RunPhase ("handshake", m_rampUp + m_handshakeLimit, m_connections * m_subflows));
+
+  m_phase = STEADY;
+  for (uint32_t i = 0; i < m_connections; ++i)
+    {
+      if (m_metas[i]->FullyEstablished ())
+        {
+          HandleSend (m_metas[i], m_metas[i]->GetTxAvailable ());
+        }
+    }
+  m_results.push_back (RunPhase ("steady", m_steady, m_connections));
+
+  m_phase = TEARDOWN;
+  for (uint32_t i = 0; i < m_connections; ++i)
+    {
+      m_metas[i]->Close ();
+    }
+  // Runs until the subflows left TIME_WAIT and the event list is empty,
+  // or until the deadline
+  m_results.push_back (RunPhase ("teardown", m_teardownLimit, m_connections));
+}
+
+void
+MpTcpConnectionBench::Report (std::ostream &os) const
+{
+  os << "{" << std::endl
+     << "  \"connections\": " << m_connections << "," << std::endl
+     << "  \"subflows\": " << m_subflows << "," << std::endl
+     << "  \"hosts\": " << m_hosts << "," << std::endl
+     << "  \"failedJoins\": " << m_joinFailed << "," << std::endl
+     << "  \"receivedBytes\": " << m_rxBytes << "," << std::endl
+     << "  \"phases\": [" << std::endl;
+  for (uint32_t i = 0; i < m_results.size (); ++i)
+    {
+      const PhaseResult &r = m_results[i];
+      double eventRate = r.wallSeconds > 0 ? r.events / r.wallSeconds : 0;
+      double wallPerSimSecond = r.simSeconds > 0 ? r.wallSeconds / r.simSeconds : 0;
+      os << "    {\"name\": \"" << r.name << "\""
+         << ", \"completed\": " << r.completed
+         << ", \"expected\": " << r.expected
+         << ", \"wallSeconds\": " << r.wallSeconds
+         << ", \"simSeconds\": " << r.simSeconds
+         << ", \"events\": " << r.events
+         << ", \"eventsPerSecond\": " << eventRate
+         << ", \"wallSecondsPerSimSecond\": " << wallPerSimSecond
+         << ", \"peakRssKb\": " << r.peakRssKb
+         << "}" << (i + 1 < m_results.size () ? "," : "") << std::endl;
+    }
+  os << "  ]" << std::endl
+     << "}" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  MpTcpConnectionBench bench;
+  std::string json;
+
+  CommandLine cmd;
+  cmd.AddValue ("connections", "number of MPTCP connections", bench.m_connections);
+  cmd.AddValue ("subflows", "number of subflows (and planes) per connection", bench.m_subflows);
+  cmd.AddValue ("hosts", "number of client and server hosts", bench.m_hosts);
+  cmd.AddValue ("rampUp", "seconds over which the connections are opened", bench.m_rampUp);
+  cmd.AddValue ("handshakeLimit", "simulated seconds allowed to establish the connections", bench.m_handshakeLimit);
+  cmd.AddValue ("steady", "simulated seconds of data transfer", bench.m_steady);
+  cmd.AddValue ("teardownLimit", "simulated seconds allowed to close the connections", bench.m_teardownLimit);
+  cmd.AddValue ("msl", "maximum segment lifetime in seconds, bounds the TIME_WAIT state", bench.m_msl);
+  cmd.AddValue ("accessRate", "rate of the host links", bench.m_accessRate);
+  cmd.AddValue ("bottleneckRate", "rate of the links between routers", bench.m_bottleneckRate);
+  cmd.AddValue ("delay", "delay of every link", bench.m_delay);
+  cmd.AddValue ("json", "write the results to this file instead of the standard output", json);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (bench.m_writeSize));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (65535));
+  Config::SetDefault ("ns3::TcpSocketImpl::Timestamp", BooleanValue (false));
+  Config::SetDefault ("ns3::TcpSocketImpl::MaxSegLifetime", DoubleValue (bench.m_msl));
+
+  SystemWallClockMs setup;
+  setup.Start ();
+  bench.Setup ();
+  LOG ("Setup took " << setup.End () / 1000.0 << " s");
+
+  bench.Run ();
+
+  if (json.empty ())
+    {
+      bench.Report (std::cout);
+    }
+  else
+    {
+      std::ofstream os (json.c_str ());
+      bench.Report (os);
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
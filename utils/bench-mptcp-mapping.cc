@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of Sussex
+ * Copyright (c) 2015 Université Pierre et Marie Curie (UPMC)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/mptcp-mapping.h"
+
+using namespace ns3;
+
+#define LOG(x)   std::cout << x << std::endl
+
+// Output field width
+int g_fwidth = 14;
+
+/**
+ * Replays the life of the mappings of a subflow: one mapping is added per
+ * segment, every segment is looked up a few times (send, receive, data fin
+ * check) and mappings are discarded from the head once acked.
+ */
+static void
+RunBench (TypeId containerTypeId, uint32_t window, uint32_t total,
+          uint32_t lookups, uint16_t segSize, Ptr<UniformRandomVariable> rng)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (containerTypeId);
+  Ptr<MpTcpMappingContainer> container = factory.Create<MpTcpMappingContainer> ();
+
+  SequenceNumber32 head (1);
+  SequenceNumber32 tail (1);
+  SequenceNumber64 dsn (1);
+  MpTcpMapping mapping;
+  uint32_t found = 0;
+
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < total; ++i)
+    {
+      container->AddMapping (dsn, tail, segSize);
+      tail += segSize;
+      dsn += segSize;
+
+      uint32_t inFlight = tail - head;
+      for (uint32_t j = 0; j < lookups; ++j)
+        {
+          SequenceNumber32 ssn = head + rng->GetInteger (0, inFlight - 1);
+          found += container->GetMappingForSSN (ssn, mapping);
+        }
+
+      if (container->GetNMappings () > window)
+        {
+          container->DiscardMappingsInSSNRange (head, segSize);
+          head += segSize;
+        }
+    }
+  double elapsed = time.End () / 1000.0;
+
+  NS_ABORT_MSG_UNLESS (found == total * lookups, "Lookups failed");
+  Ptr<MpTcpMappingPool> pool = container->GetPool ();
+  LOG (std::left << std::setw (2 * g_fwidth) << containerTypeId.GetName () <<
+       std::right << std::setw (g_fwidth) << elapsed <<
+       std::setw (g_fwidth) << (total / elapsed) <<
+       std::setw (g_fwidth) << (elapsed / total) <<
+       std::setw (g_fwidth) << pool->GetNRequests () <<
+       std::setw (g_fwidth) << pool->GetNHeapAllocations ());
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t window  =   10000;
+  uint32_t total   = 1000000;
+  uint32_t lookups =       3;
+  uint32_t runs    =       1;
+  uint16_t segSize =    1400;
+  bool useSet  = true;
+  bool useRing = true;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the MPTCP mapping containers.\n"
+             "\n"
+             "Each iteration maps a new segment at the tail of the window,\n"
+             "looks up random in-flight SSNs and discards the head mapping\n"
+             "once the window is full.");
+  cmd.AddValue ("window",  "number of mappings in flight (default 1E4)", window);
+  cmd.AddValue ("total",   "total number of mappings (default 1E6)",     total);
+  cmd.AddValue ("lookups", "SSN lookups per mapping (default 3)",        lookups);
+  cmd.AddValue ("segsize", "mapping length (default 1400)",              segSize);
+  cmd.AddValue ("runs",    "number of runs (default 1)",                 runs);
+  cmd.AddValue ("set",     "benchmark MpTcpMappingSet",                  useSet);
+  cmd.AddValue ("ring",    "benchmark MpTcpMappingRing",                 useRing);
+  cmd.Parse (argc, argv);
+
+  LOG (cmd.GetName () << ": window " << window << " total " << total <<
+       " lookups " << lookups << " runs " << runs);
+
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+
+  std::vector<TypeId> containers;
+  if (useSet)  { containers.push_back (MpTcpMappingSet::GetTypeId ());  }
+  if (useRing) { containers.push_back (MpTcpMappingRing::GetTypeId ()); }
+
+  LOG ("");
+  LOG (std::left << std::setw (2 * g_fwidth) << "Container" <<
+       std::right << std::setw (g_fwidth) << "Time (s)" <<
+       std::setw (g_fwidth) << "Rate (map/s)" <<
+       std::setw (g_fwidth) << "Per (s/map)" <<
+       std::setw (g_fwidth) << "Pool allocs" <<
+       std::setw (g_fwidth) << "Heap allocs");
+  for (uint32_t i = 0; i < runs; ++i)
+    {
+      for (std::vector<TypeId>::const_iterator it = containers.begin (); it != containers.end (); ++it)
+        {
+          RunBench (*it, window, total, lookups, segSize, rng);
+        }
+    }
+  LOG ("");
+  return 0;
+}
@@ -0,0 +1,292 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Parameter sweep of MPTCP, run in one process by a SweepRunner.
+ *
+ * Each run transfers bulk data over one MPTCP connection with two
+ * subflows, each on its own point to point link between the client and
+ * the server:
+ *
+ *   client ==== path 0 (fixed delay) ==== server
+ *          ==== path 1 (swept delay) ====
+ *
+ * The sweep covers every combination of the MPTCP schedulers, of the
+ * delays of the second path and of the initial congestion windows, each
+ * one repeated with --replications values of RngRun. The runs are
+ * executed by --threads threads: the wall clock time and the runs per
+ * second are written on the standard error, to compare with one thread,
+ * and the goodput and the number of events of each run are written as
+ * comma separated values, on the standard output or in the file given by
+ * --output.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/mptcp-socket-factory.h"
+#include "ns3/mptcp-meta-socket.h"
+#include "ns3/sweep-runner.h"
+
+using namespace ns3;
+
+#define LOG(x)   std::cerr << x << std::endl
+
+/**
+ * The parameters of one run
+ */
+struct SweepPoint
+{
+  std::string scheduler;  //!< TypeId name of the MPTCP scheduler
+  std::string delay;      //!< Delay of the second path
+  uint32_t initialCwnd;   //!< Initial congestion window, in segments
+  uint32_t run;           //!< RngRun of the simulation
+};
+
+/// The parameters of the runs, by index
+static std::vector<SweepPoint> g_points;
+
+/**
+ * One simulation of the sweep
+ */
+class SweepRun
+{
+public:
+  SweepRun (const SweepPoint &point, double duration);
+
+  void Execute (void);
+
+private:
+  void Setup (void);
+  void Connect (void);
+  void FullyEstablished (Ptr<MpTcpMetaSocket> meta);
+  void HandleSend (Ptr<Socket> sock, uint32_t available);
+  void Accept (Ptr<Socket> sock, const Address &from);
+  void HandleRecv (Ptr<Socket> sock);
+
+  SweepPoint m_point;
+  double m_duration;
+  uint32_t m_writeSize;
+  Ipv4Address m_clientAddresses[2];
+  Ipv4Address m_serverAddresses[2];
+  Ptr<MpTcpMetaSocket> m_meta;
+  std::vector<Ptr<Socket> > m_accepted;
+  std::vector<uint8_t> m_payload;
+  uint64_t m_rxBytes;
+};
+
+SweepRun::SweepRun (const SweepPoint &point, double duration)
+  : m_point (point),
+    m_duration (duration),
+    m_writeSize (1400),
+    m_rxBytes (0)
+{
+}
+
+void
+SweepRun::Setup (void)
+{
+  // Seen by this simulation only
+  Config::SetDefault ("ns3::MpTcpMetaSocket::Scheduler",
+                      TypeIdValue (TypeId::LookupByName (m_point.scheduler)));
+  Config::SetDefault ("ns3::TcpSocket::InitialCwnd", UintegerValue (m_point.initialCwnd));
+  RngSeedManager::SetRun (m_point.run);
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  Ipv4AddressHelper address;
+  for (uint32_t k = 0; k < 2; ++k)
+    {
+      PointToPointHelper link;
+      link.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+      link.SetChannelAttribute ("Delay", StringValue (k == 0 ? "10ms" : m_point.delay));
+      std::ostringstream base;
+      base << "10." << k + 1 << ".0.0";
+      address.SetBase (base.str ().c_str (), "255.255.255.252");
+      Ipv4InterfaceContainer itf = address.Assign (link.Install (nodes));
+      m_clientAddresses[k] = itf.GetAddress (0);
+      m_serverAddresses[k] = itf.GetAddress (1);
+    }
+
+  Ptr<Socket> listening = nodes.Get (1)->GetObject<MpTcpSocketFactory> ()->CreateSocket ();
+  listening->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  listening->Listen ();
+  listening->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                                MakeCallback (&SweepRun::Accept, this));
+
+  m_payload.resize (m_writeSize, 'x');
+  m_meta = DynamicCast<MpTcpMetaSocket> (nodes.Get (0)->GetObject<MpTcpSocketFactory> ()->CreateSocket ());
+  NS_ABORT_MSG_UNLESS (m_meta, "MPTCP socket factory should create meta sockets");
+  m_meta->SetFullyEstablishedCallback (MakeCallback (&SweepRun::FullyEstablished, this));
+  m_meta->SetSendCallback (MakeCallback (&SweepRun::HandleSend, this));
+  // The queue discs of the devices are only set up once the nodes are initialized
+  Simulator::Schedule (MilliSeconds (1), &SweepRun::Connect, this);
+}
+
+void
+SweepRun::Connect (void)
+{
+  m_meta->Bind (InetSocketAddress (m_clientAddresses[0], 0));
+  m_meta->Connect (InetSocketAddress (m_serverAddresses[0], 50000));
+}
+
+void
+SweepRun::FullyEstablished (Ptr<MpTcpMetaSocket> meta)
+{
+  meta->ConnectNewSubflow (InetSocketAddress (m_clientAddresses[1], 0),
+                           InetSocketAddress (m_serverAddresses[1], 50000));
+}
+
+void
+SweepRun::HandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  // The first data completes the MPTCP handshake
+  while (sock->GetTxAvailable () >= m_writeSize)
+    {
+      if (sock->Send (&m_payload[0], m_writeSize, 0) <= 0)
+        {
+          break;
+        }
+    }
+}
+
+void
+SweepRun::Accept (Ptr<Socket> sock, const Address &from)
+{
+  sock->SetRecvCallback (MakeCallback (&SweepRun::HandleRecv, this));
+  m_accepted.push_back (sock);
+}
+
+void
+SweepRun::HandleRecv (Ptr<Socket> sock)
+{
+  Ptr<Packet> p;
+  while ((p = sock->Recv ()))
+    {
+      m_rxBytes += p->GetSize ();
+    }
+}
+
+void
+SweepRun::Execute (void)
+{
+  Setup ();
+  Simulator::Stop (Seconds (m_duration));
+  Simulator::Run ();
+  SweepRunner::Record ("goodputMbps", m_rxBytes * 8 / m_duration / 1e6);
+  SweepRunner::Record ("events", Simulator::GetEventCount ());
+}
+
+/**
+ * Run one simulation of the sweep, in an isolated thread
+ * \param i the index of the parameters of the run
+ * \param duration the simulated seconds
+ */
+static void
+RunPoint (uint32_t i, double duration)
+{
+  SweepRun run (g_points[i], duration);
+  run.Execute ();
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t threads = 1;
+  uint32_t replications = 1;
+  double duration = 2.0;
+  std::string output;
+
+  CommandLine cmd;
+  cmd.AddValue ("threads", "number of threads executing the runs", threads);
+  cmd.AddValue ("replications", "number of RngRun values of each combination", replications);
+  cmd.AddValue ("duration", "simulated seconds of each run", duration);
+  cmd.AddValue ("output", "write the results to this file instead of the standard output", output);
+  cmd.Parse (argc, argv);
+  NS_ABORT_MSG_UNLESS (threads > 0, "At least one thread is needed");
+
+  // Seen by all the runs
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1400));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (65535));
+  Config::SetDefault ("ns3::TcpSocketImpl::Timestamp", BooleanValue (false));
+
+  const char *schedulers[] = {
+    "ns3::MpTcpSchedulerRoundRobin",
+    "ns3::MpTcpSchedulerFastestRTT",
+    "ns3::MpTcpSchedulerBlest",
+    "ns3::MpTcpSchedulerEcf",
+    "ns3::MpTcpSchedulerRedundant"
+  };
+  const char *delays[] = { "5ms", "20ms", "80ms" };
+  const uint32_t initialCwnds[] = { 2, 10 };
+
+  std::vector<SweepPoint> &points = g_points;
+  SweepRunner sweep;
+  for (uint32_t s = 0; s < sizeof (schedulers) / sizeof (schedulers[0]); ++s)
+    {
+      for (uint32_t d = 0; d < sizeof (delays) / sizeof (delays[0]); ++d)
+        {
+          for (uint32_t c = 0; c < sizeof (initialCwnds) / sizeof (initialCwnds[0]); ++c)
+            {
+              for (uint32_t r = 1; r <= replications; ++r)
+                {
+                  SweepPoint point;
+                  point.scheduler = schedulers[s];
+                  point.delay = delays[d];
+                  point.initialCwnd = initialCwnds[c];
+                  point.run = r;
+                  points.push_back (point);
+                  sweep.AddRun (MakeBoundCallback (&RunPoint, uint32_t (points.size () - 1), duration));
+                }
+            }
+        }
+    }
+
+  LOG (cmd.GetName () << ": " << sweep.GetNRuns () << " runs on " << threads << " threads");
+  SystemWallClockMs wall;
+  wall.Start ();
+  sweep.Execute (threads);
+  double elapsed = wall.End () / 1000.0;
+  LOG ("  " << elapsed << " s, " << sweep.GetNRuns () / elapsed << " runs/s");
+
+  std::ofstream file;
+  if (!output.empty ())
+    {
+      file.open (output.c_str ());
+    }
+  std::ostream &os = output.empty () ? std::cout : file;
+  os << "run,scheduler,delay,initialCwnd,rngRun,goodputMbps,events" << std::endl;
+  for (uint32_t i = 0; i < points.size (); ++i)
+    {
+      double goodput = 0;
+      double events = 0;
+      sweep.GetResult (i, "goodputMbps", goodput);
+      sweep.GetResult (i, "events", events);
+      os << i << "," << points[i].scheduler << "," << points[i].delay << ","
+         << points[i].initialCwnd << "," << points[i].run << ","
+         << goodput << "," << events << std::endl;
+    }
+  return 0;
+}
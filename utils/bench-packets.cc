@@ -21,12 +21,14 @@
 #include "ns3/system-wall-clock-ms.h"
 #include "ns3/packet.h"
 #include "ns3/packet-metadata.h"
+#include "ns3/system-thread.h"
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <stdlib.h> // for exit ()
 #include <limits>
 #include <algorithm>
+#include <vector>
 
 using namespace ns3;
 
@@ -303,26 +305,50 @@ benchByteTags (uint32_t n)
 }
 
 static uint64_t
-runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
+runBenchOneIteration (void (*bench) (uint32_t), uint32_t n, uint32_t threads)
 {
   SystemWallClockMs time;
   time.Start ();
-  (*bench) (n);
+  if (threads == 1)
+    {
+      (*bench) (n);
+    }
+  else
+    {
+      // Each thread runs the whole benchmark, as would independent
+      // simulations running in the threads of the process
+      std::vector<Ptr<SystemThread> > workers;
+      for (uint32_t i = 0; i < threads; i++)
+        {
+          workers.push_back (Create<SystemThread> (MakeBoundCallback (bench, n)));
+        }
+      for (uint32_t i = 0; i < threads; i++)
+        {
+          workers[i]->Start ();
+        }
+      for (uint32_t i = 0; i < threads; i++)
+        {
+          workers[i]->Join ();
+        }
+    }
   uint64_t deltaMs = time.End ();
   return deltaMs;
 }
 
 
 static void
-runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name)
+runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, uint32_t threads, char const *name)
 {
+  // Register the types of the headers and tags before the threads use them
+  (*bench) (1);
   uint64_t minDelay = std::numeric_limits<uint64_t>::max();
   for (uint32_t i = 0; i < minIterations; i++)
     {
-      uint64_t delay = runBenchOneIteration(bench, n);
+      uint64_t delay = runBenchOneIteration(bench, n, threads);
       minDelay = std::min(minDelay, delay);
     }
   double ps = n;
+  ps *= threads;
   ps *= 1000;
   ps /= minDelay;
   std::cout << ps << " packets/s"
@@ -336,12 +362,14 @@ int main (int argc, char *argv[])
   uint32_t n = 0;
   uint32_t minIterations = 1;
   bool enablePrinting = false;
+  uint32_t threads = 1;
 
   CommandLine cmd;
   cmd.Usage ("Benchmark Packet class");
   cmd.AddValue ("n", "number of iterations", n);
   cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
   cmd.AddValue ("enable-printing", "enable packet printing", enablePrinting);
+  cmd.AddValue ("threads", "number of threads running the benchmarks concurrently", threads);
   cmd.Parse (argc, argv);
 
   if (n == 0)
@@ -350,15 +378,20 @@ int main (int argc, char *argv[])
         "by command-line argument --n=(number of packets)" << std::endl;
       exit (1);
     }
-  std::cout << "Running bench-packets with n=" << n << std::endl;
+  if (threads == 0)
+    {
+      std::cerr << "Error-- number of threads must be at least 1" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-packets with n=" << n << " threads=" << threads << std::endl;
   std::cout << "All tests begin by adding UDP and IPv4 headers." << std::endl;
 
-  runBench (&benchA, n, minIterations, "Copy packet, remove headers");
-  runBench (&benchB, n, minIterations, "Just add headers");
-  runBench (&benchC, n, minIterations, "Remove by func call");
-  runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
-  runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
-  runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  runBench (&benchA, n, minIterations, threads, "Copy packet, remove headers");
+  runBench (&benchB, n, minIterations, threads, "Just add headers");
+  runBench (&benchC, n, minIterations, threads, "Remove by func call");
+  runBench (&benchD, n, minIterations, threads, "Intermixed add/remove headers and tags");
+  runBench (&benchFragment, n, minIterations, threads, "Fragmentation and concatenation");
+  runBench (&benchByteTags, n, minIterations, threads, "Benchmark byte tags");
 
   return 0;
 }
@@ -45,6 +45,7 @@ public:
   Bench (const uint32_t population, const uint32_t total)
   : m_population (population),
     m_total (total),
+    m_burst (1),
     m_count (0)
   { };
   
@@ -62,6 +63,15 @@ public:
   {
     m_total = total;
   }
+
+  /**
+   * Draw a new event interval only every \p burst events, so that events
+   * scheduled in a row share their time stamp.
+   */
+  void SetBurst (const uint32_t burst)
+  {
+    m_burst = burst;
+  }
     
   void RunBench (void);
 private:
@@ -70,7 +80,9 @@ private:
   Ptr<RandomVariableStream> m_rand;
   uint32_t m_population;
   uint32_t m_total;
+  uint32_t m_burst;
   uint32_t m_count;
+  Time m_interval;
 };
 
 void
@@ -86,8 +98,11 @@ Bench::RunBench (void)
   time.Start ();
   for (uint32_t i = 0; i < m_population; ++i)
     {
-      Time at = NanoSeconds (m_rand->GetValue ());
-      Simulator::Schedule (at, &Bench::Cb, this);
+      if (i % m_burst == 0)
+        {
+          m_interval = NanoSeconds (m_rand->GetValue ());
+        }
+      Simulator::Schedule (m_interval, &Bench::Cb, this);
     }
   init = time.End ();
   init /= 1000;
@@ -118,8 +133,11 @@ Bench::Cb (void)
     }
   DEB ("event at " << Simulator::Now ().GetSeconds () << "s");
 
-  Time after = NanoSeconds (m_rand->GetValue ());
-  Simulator::Schedule (after, &Bench::Cb, this);
+  if (m_count % m_burst == 0)
+    {
+      m_interval = NanoSeconds (m_rand->GetValue ());
+    }
+  Simulator::Schedule (m_interval, &Bench::Cb, this);
   ++m_count;
 }
 
@@ -186,10 +204,13 @@ int main (int argc, char *argv[])
   bool schedHeap = false;
   bool schedList = false;
   bool schedMap  = true;
+  bool schedQuad = false;
+  bool schedAll  = false;
 
   uint32_t pop   =  100000;
   uint32_t total = 1000000;
   uint32_t runs  =       1;
+  uint32_t burst =       1;
   std::string filename = "";
   
   CommandLine cmd;
@@ -200,73 +221,102 @@ int main (int argc, char *argv[])
              "  an ascii file, given by the --file=\"<filename>\" argument,\n"
              "  or standard input, by the argument --file=\"-\"\n"
              "In the case of either --file form, the input is expected\n"
-             "to be ascii, giving the relative event times in ns.");
+             "to be ascii, giving the relative event times in ns.\n"
+             "\n"
+             "Each event schedules a new one (hold model). With --burst=N,\n"
+             "runs of N events scheduled in a row share their time stamp.");
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
+  cmd.AddValue ("quad",  "use QuadHeapScheduler",         schedQuad);
+  cmd.AddValue ("all",   "run the benchmark with every scheduler in turn", schedAll);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
   cmd.AddValue ("pop",   "event population size (default 1E5)",         pop);
   cmd.AddValue ("total", "total number of events to run (default 1E6)", total);
   cmd.AddValue ("runs",  "number of runs (default 1)",    runs);
+  cmd.AddValue ("burst", "events sharing a time stamp (default 1)", burst);
   cmd.AddValue ("file",  "file of relative event times",  filename);
   cmd.AddValue ("prec",  "printed output precision",      g_fwidth);
   cmd.Parse (argc, argv);
   g_me = cmd.GetName () + ": ";
   g_fwidth += 6;  // 5 extra chars in '2.000002e+07 ': . e+0 _
 
-  ObjectFactory factory ("ns3::MapScheduler");
-  if (schedCal)  { factory.SetTypeId ("ns3::CalendarScheduler"); }
-  if (schedHeap) { factory.SetTypeId ("ns3::HeapScheduler");     }
-  if (schedList) { factory.SetTypeId ("ns3::ListScheduler");     }  
-  Simulator::SetScheduler (factory);
+  std::vector<std::string> schedulers;
+  if (schedAll)
+    {
+      schedulers.push_back ("ns3::ListScheduler");
+      schedulers.push_back ("ns3::MapScheduler");
+      schedulers.push_back ("ns3::HeapScheduler");
+      schedulers.push_back ("ns3::QuadHeapScheduler");
+      schedulers.push_back ("ns3::CalendarScheduler");
+    }
+  else
+    {
+      std::string scheduler = "ns3::MapScheduler";
+      if (schedCal)  { scheduler = "ns3::CalendarScheduler"; }
+      if (schedHeap) { scheduler = "ns3::HeapScheduler";     }
+      if (schedList) { scheduler = "ns3::ListScheduler";     }
+      if (schedQuad) { scheduler = "ns3::QuadHeapScheduler"; }
+      schedulers.push_back (scheduler);
+    }
 
   LOGME (std::setprecision (g_fwidth - 6));
   DEB ("debugging is ON");
 
-  LOGME ("scheduler: " << factory.GetTypeId ().GetName ());
   LOGME ("population: " << pop);
   LOGME ("total events: " << total);
+  LOGME ("burst: " << burst);
   LOGME ("runs: " << runs);
   
   Bench *bench = new Bench (pop, total);
   bench->SetRandomStream (GetRandomStream (filename));
+  bench->SetBurst (burst);
 
-  // table header
-  LOG ("");
-  LOG (std::left << std::setw (g_fwidth) << "Run #" <<
-       std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
-       std::left << std::setw (3 * g_fwidth) << "Simulation:");
-  LOG (std::left << std::setw (g_fwidth) << "" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
-  LOG (std::setfill ('-') <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<
-       std::setfill (' ')
-       );
-       
-  // prime
-  DEB ("priming");
-  std::cout << std::left << std::setw (g_fwidth) << "(prime)";
-  bench->RunBench ();
-
-  bench->SetPopulation (pop);
-  bench->SetTotal (total);
-  for (uint32_t i = 0; i < runs; i++)
+  for (std::vector<std::string>::const_iterator it = schedulers.begin (); it != schedulers.end (); ++it)
     {
-      std::cout << std::setw (g_fwidth) << i;
-      
+      ObjectFactory factory (*it);
+      Simulator::SetScheduler (factory);
+
+      LOG ("");
+      LOGME ("scheduler: " << factory.GetTypeId ().GetName ());
+
+      // table header
+      LOG ("");
+      LOG (std::left << std::setw (g_fwidth) << "Run #" <<
+           std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
+           std::left << std::setw (3 * g_fwidth) << "Simulation:");
+      LOG (std::left << std::setw (g_fwidth) << "" <<
+           std::left << std::setw (g_fwidth) << "Time (s)" <<
+           std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+           std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
+           std::left << std::setw (g_fwidth) << "Time (s)" <<
+           std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+           std::left << std::setw (g_fwidth) << "Per (s/ev)" );
+      LOG (std::setfill ('-') <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::setfill (' ')
+           );
+
+      // prime
+      DEB ("priming");
+      std::cout << std::left << std::setw (g_fwidth) << "(prime)";
       bench->RunBench ();
+
+      bench->SetPopulation (pop);
+      bench->SetTotal (total);
+      for (uint32_t i = 0; i < runs; i++)
+        {
+          std::cout << std::setw (g_fwidth) << i;
+
+          bench->RunBench ();
+        }
     }
 
   LOG ("");
@@ -0,0 +1,224 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Benchmark of the heap allocations of a TCP bulk transfer.
+ *
+ * A client sends bulk data to a server over one 1 Gbps, 1 ms link, in
+ * segments of 1400 bytes. The global operator new is counted, and the
+ * program reports the heap allocations and the events per segment
+ * delivered to the server. Only the steady state is measured: the count
+ * starts once the connection is set up and the window has grown, after
+ * the time given by --warmup.
+ *
+ * This is the measure behind the allocations per segment quoted for the
+ * packet and tag pools, e.g.
+ *
+ *   ./waf --run "bench-tcp-allocs --bytes=20000000"
+ */
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+
+using namespace ns3;
+
+#define LOG(x)   std::cout << x << std::endl
+
+/** Number of calls to the global operator new. */
+static uint64_t g_allocations = 0;
+
+// Kept out of line, see bench-events.cc
+__attribute__ ((noinline)) void *
+operator new (std::size_t size)
+{
+  g_allocations++;
+  void *p = std::malloc (size == 0 ? 1 : size);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+__attribute__ ((noinline)) void
+operator delete (void *p) noexcept
+{
+  std::free (p);
+}
+
+__attribute__ ((noinline)) void
+operator delete (void *p, std::size_t size) noexcept
+{
+  std::free (p);
+}
+
+/**
+ * One bulk transfer
+ */
+class AllocBench
+{
+public:
+  AllocBench (uint32_t totalBytes, uint32_t segmentSize);
+
+  /**
+   * Run the transfer
+   * \param warmup time from which the allocations are counted
+   */
+  void Run (Time warmup);
+
+private:
+  void SourceHandleSend (Ptr<Socket> sock, uint32_t available);
+  void ServerHandleConnectionCreated (Ptr<Socket> s, const Address &addr);
+  void ServerHandleRecv (Ptr<Socket> sock);
+  void StartCount (void);
+
+  uint32_t m_totalBytes;
+  uint32_t m_segmentSize;
+  uint32_t m_txBytes;
+  uint64_t m_rxBytes;
+
+  uint64_t m_rxStart;
+  uint64_t m_allocStart;
+  uint64_t m_eventStart;
+};
+
+AllocBench::AllocBench (uint32_t totalBytes, uint32_t segmentSize)
+  : m_totalBytes (totalBytes),
+    m_segmentSize (segmentSize),
+    m_txBytes (0),
+    m_rxBytes (0),
+    m_rxStart (0),
+    m_allocStart (0),
+    m_eventStart (0)
+{
+}
+
+void
+AllocBench::SourceHandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  while (m_txBytes < m_totalBytes && sock->GetTxAvailable () > 0)
+    {
+      uint32_t toSend = std::min (sock->GetTxAvailable (), m_totalBytes - m_txBytes);
+      int sent = sock->Send (Create<Packet> (toSend));
+      if (sent <= 0)
+        {
+          break;
+        }
+      m_txBytes += sent;
+    }
+}
+
+void
+AllocBench::ServerHandleConnectionCreated (Ptr<Socket> s, const Address &addr)
+{
+  s->SetRecvCallback (MakeCallback (&AllocBench::ServerHandleRecv, this));
+}
+
+void
+AllocBench::ServerHandleRecv (Ptr<Socket> sock)
+{
+  Ptr<Packet> p;
+  while ((p = sock->Recv ()))
+    {
+      m_rxBytes += p->GetSize ();
+    }
+}
+
+void
+AllocBench::StartCount (void)
+{
+  m_rxStart = m_rxBytes;
+  m_allocStart = g_allocations;
+  m_eventStart = Simulator::GetEventCount ();
+}
+
+void
+AllocBench::Run (Time warmup)
+{
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (m_segmentSize));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (65535));
+  Config::SetDefault ("ns3::TcpSocketImpl::Timestamp", BooleanValue (false));
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  SimpleNetDeviceHelper link;
+  link.SetNetDevicePointToPointMode (true);
+  link.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  link.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (1)));
+  NetDeviceContainer devices = link.Install (nodes);
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (devices);
+
+  Ptr<Socket> listening = Socket::CreateSocket (nodes.Get (1), TcpSocketFactory::GetTypeId ());
+  listening->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  listening->Listen ();
+  listening->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                                MakeCallback (&AllocBench::ServerHandleConnectionCreated, this));
+
+  Ptr<Socket> source = Socket::CreateSocket (nodes.Get (0), TcpSocketFactory::GetTypeId ());
+  source->SetSendCallback (MakeCallback (&AllocBench::SourceHandleSend, this));
+  source->Bind ();
+  Simulator::Schedule (MilliSeconds (1), &Socket::Connect, source,
+                       Address (InetSocketAddress (Ipv4Address ("10.1.1.2"), 50000)));
+  Simulator::Schedule (MilliSeconds (2), &AllocBench::SourceHandleSend, this, source, 0);
+  Simulator::Schedule (warmup, &AllocBench::StartCount, this);
+
+  Simulator::Run ();
+
+  double segments = double (m_rxBytes - m_rxStart) / m_segmentSize;
+  uint64_t allocations = g_allocations - m_allocStart;
+  uint64_t events = Simulator::GetEventCount () - m_eventStart;
+  LOG ("received " << m_rxBytes << " bytes, " << segments << " segments after the warm up");
+  LOG ("allocs/segment " << allocations / segments);
+  LOG ("events/segment " << events / segments);
+
+  Simulator::Destroy ();
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t bytes = 20000000;
+  uint32_t segmentSize = 1400;
+  Time warmup = MilliSeconds (50);
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the heap allocations of a TCP bulk transfer.\n"
+             "\n"
+             "Reports the heap allocations and the events per segment\n"
+             "delivered, in the steady state of the transfer.");
+  cmd.AddValue ("bytes",   "bytes to transfer (default 2E7)",               bytes);
+  cmd.AddValue ("segment", "segment size (default 1400)",                   segmentSize);
+  cmd.AddValue ("warmup",  "time the count starts from (default 50ms)",     warmup);
+  cmd.Parse (argc, argv);
+
+  LOG (cmd.GetName () << ": bytes " << bytes << " segment " << segmentSize <<
+       " warmup " << warmup.GetSeconds () << " s");
+
+  AllocBench bench (bytes, segmentSize);
+  bench.Run (warmup);
+  return 0;
+}
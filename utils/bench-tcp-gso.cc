@@ -0,0 +1,292 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Bulk transfer benchmark of the TCP segmentation offload.
+ *
+ * A client sends bulk data to a server over TCP, or over MPTCP with one
+ * subflow per point to point link:
+ *
+ *   client ==== link 0 ==== server
+ *          ==== link 1 ====
+ *
+ * Each transfer is run with the TcpSocketImpl "Gso" attribute off, then
+ * on. With GSO, the sockets hand super-segments of several segments to
+ * IPv4, which routes them and queues them once, and the point to point
+ * devices cut them into segments when they transmit them. The devices of
+ * the client have no queue disc, as IPv4 segments what goes through one.
+ *
+ * For each run, the program prints the packets sent by IPv4 and by the
+ * devices of the client, the number of events, the wall clock time and
+ * the goodput. The runs after the first one reuse the memory of the
+ * previous ones: to compare wall clock times, run each one in its own
+ * process, e.g.
+ *
+ *   ./waf --run "bench-tcp-gso --run=mptcp-gso"
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/traffic-control-module.h"
+#include "ns3/mptcp-socket-factory.h"
+#include "ns3/mptcp-meta-socket.h"
+
+using namespace ns3;
+
+#define LOG(x)   std::cerr << x << std::endl
+
+/**
+ * One bulk transfer
+ */
+class GsoRun
+{
+public:
+  GsoRun (bool mptcp, bool gso, std::string rate, std::string delay, double duration);
+
+  void Execute (void);
+  void Print (std::ostream &os) const;
+
+private:
+  void Setup (void);
+  void Connect (void);
+  void FullyEstablished (Ptr<MpTcpMetaSocket> meta);
+  void HandleSend (Ptr<Socket> sock, uint32_t available);
+  void Accept (Ptr<Socket> sock, const Address &from);
+  void HandleRecv (Ptr<Socket> sock);
+  void IpTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+  void PhyTx (Ptr<const Packet> p);
+
+  bool m_mptcp;
+  bool m_gso;
+  std::string m_rate;
+  std::string m_delay;
+  double m_duration;
+  uint32_t m_writeSize;
+  Ipv4Address m_clientAddresses[2];
+  Ipv4Address m_serverAddresses[2];
+  Ptr<Socket> m_source;
+  std::vector<Ptr<Socket> > m_accepted;
+  std::vector<uint8_t> m_payload;
+  uint64_t m_rxBytes;
+  uint64_t m_ipPackets;      //!< Packets sent by IPv4 on the client
+  uint64_t m_wirePackets;    //!< Packets sent by the devices of the client
+  uint64_t m_events;
+  double m_wallSeconds;
+};
+
+GsoRun::GsoRun (bool mptcp, bool gso, std::string rate, std::string delay, double duration)
+  : m_mptcp (mptcp),
+    m_gso (gso),
+    m_rate (rate),
+    m_delay (delay),
+    m_duration (duration),
+    m_writeSize (1400),
+    m_rxBytes (0),
+    m_ipPackets (0),
+    m_wirePackets (0),
+    m_events (0),
+    m_wallSeconds (0)
+{
+}
+
+void
+GsoRun::Setup (void)
+{
+  Config::SetDefault ("ns3::TcpSocketImpl::Gso", BooleanValue (m_gso));
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  Ipv4AddressHelper address;
+  for (uint32_t k = 0; k < 2; ++k)
+    {
+      PointToPointHelper link;
+      link.SetDeviceAttribute ("DataRate", StringValue (m_rate));
+      link.SetChannelAttribute ("Delay", StringValue (m_delay));
+      NetDeviceContainer devices = link.Install (nodes);
+      devices.Get (0)->TraceConnectWithoutContext ("PhyTxBegin", MakeCallback (&GsoRun::PhyTx, this));
+      std::ostringstream base;
+      base << "10." << k + 1 << ".0.0";
+      address.SetBase (base.str ().c_str (), "255.255.255.252");
+      Ipv4InterfaceContainer itf = address.Assign (devices);
+      TrafficControlHelper tch;
+      tch.Uninstall (devices.Get (0));
+      m_clientAddresses[k] = itf.GetAddress (0);
+      m_serverAddresses[k] = itf.GetAddress (1);
+    }
+  nodes.Get (0)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("Tx", MakeCallback (&GsoRun::IpTx, this));
+
+  Ptr<Socket> listening;
+  if (m_mptcp)
+    {
+      listening = nodes.Get (1)->GetObject<MpTcpSocketFactory> ()->CreateSocket ();
+      Ptr<MpTcpMetaSocket> meta = DynamicCast<MpTcpMetaSocket> (nodes.Get (0)->GetObject<MpTcpSocketFactory> ()->CreateSocket ());
+      NS_ABORT_MSG_UNLESS (meta, "MPTCP socket factory should create meta sockets");
+      meta->SetFullyEstablishedCallback (MakeCallback (&GsoRun::FullyEstablished, this));
+      m_source = meta;
+    }
+  else
+    {
+      listening = nodes.Get (1)->GetObject<TcpSocketFactory> ()->CreateSocket ();
+      m_source = nodes.Get (0)->GetObject<TcpSocketFactory> ()->CreateSocket ();
+    }
+  listening->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  listening->Listen ();
+  listening->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                                MakeCallback (&GsoRun::Accept, this));
+
+  m_payload.resize (m_writeSize, 'x');
+  m_source->SetSendCallback (MakeCallback (&GsoRun::HandleSend, this));
+  // The queue discs of the devices are only set up once the nodes are initialized
+  Simulator::Schedule (MilliSeconds (1), &GsoRun::Connect, this);
+}
+
+void
+GsoRun::Connect (void)
+{
+  m_source->Bind (InetSocketAddress (m_clientAddresses[0], 0));
+  m_source->Connect (InetSocketAddress (m_serverAddresses[0], 50000));
+}
+
+void
+GsoRun::FullyEstablished (Ptr<MpTcpMetaSocket> meta)
+{
+  meta->ConnectNewSubflow (InetSocketAddress (m_clientAddresses[1], 0),
+                           InetSocketAddress (m_serverAddresses[1], 50000));
+}
+
+void
+GsoRun::HandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  // The first data completes the MPTCP handshake
+  while (sock->GetTxAvailable () >= m_writeSize)
+    {
+      if (sock->Send (&m_payload[0], m_writeSize, 0) <= 0)
+        {
+          break;
+        }
+    }
+}
+
+void
+GsoRun::Accept (Ptr<Socket> sock, const Address &from)
+{
+  sock->SetRecvCallback (MakeCallback (&GsoRun::HandleRecv, this));
+  m_accepted.push_back (sock);
+}
+
+void
+GsoRun::HandleRecv (Ptr<Socket> sock)
+{
+  Ptr<Packet> p;
+  while ((p = sock->Recv ()))
+    {
+      m_rxBytes += p->GetSize ();
+    }
+}
+
+void
+GsoRun::IpTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  ++m_ipPackets;
+}
+
+void
+GsoRun::PhyTx (Ptr<const Packet> p)
+{
+  ++m_wirePackets;
+}
+
+void
+GsoRun::Execute (void)
+{
+  Setup ();
+  SystemWallClockMs wall;
+  wall.Start ();
+  Simulator::Stop (Seconds (m_duration));
+  Simulator::Run ();
+  m_wallSeconds = wall.End () / 1000.0;
+  m_events = Simulator::GetEventCount ();
+  m_source = 0;
+  m_accepted.clear ();
+  Simulator::Destroy ();
+}
+
+void
+GsoRun::Print (std::ostream &os) const
+{
+  os << std::setw (8) << (m_mptcp ? "mptcp" : "tcp")
+     << std::setw (6) << (m_gso ? "on" : "off")
+     << std::setw (12) << m_ipPackets
+     << std::setw (12) << m_wirePackets
+     << std::setw (12) << m_events
+     << std::setw (10) << std::fixed << std::setprecision (3) << m_wallSeconds
+     << std::setw (14) << std::setprecision (2) << m_rxBytes * 8 / m_duration / 1e6 << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string rate = "1Gbps";
+  std::string delay = "1ms";
+  std::string scheduler = "ns3::MpTcpSchedulerFastestRTT";
+  double duration = 10.0;
+  std::string only = "all";
+
+  CommandLine cmd;
+  cmd.AddValue ("rate", "rate of each link", rate);
+  cmd.AddValue ("delay", "delay of each link", delay);
+  cmd.AddValue ("scheduler", "TypeId name of the MPTCP scheduler", scheduler);
+  cmd.AddValue ("duration", "simulated seconds of each run", duration);
+  cmd.AddValue ("run", "all, or the only run: tcp, tcp-gso, mptcp or mptcp-gso", only);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1400));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (65535));
+  Config::SetDefault ("ns3::TcpSocketImpl::Timestamp", BooleanValue (false));
+  // The round robin scheduler hands one segment at a time to the subflows
+  Config::SetDefault ("ns3::MpTcpMetaSocket::Scheduler", TypeIdValue (TypeId::LookupByName (scheduler)));
+
+  LOG (cmd.GetName () << ": " << duration << " s of bulk transfer over " << rate << ", " << delay << " links");
+  std::cout << std::setw (8) << "proto" << std::setw (6) << "gso"
+            << std::setw (12) << "IP packets" << std::setw (12) << "wire pkts"
+            << std::setw (12) << "events" << std::setw (10) << "wall s"
+            << std::setw (14) << "goodput Mbps" << std::endl;
+  for (uint32_t mptcp = 0; mptcp < 2; ++mptcp)
+    {
+      for (uint32_t gso = 0; gso < 2; ++gso)
+        {
+          std::string name = std::string (mptcp == 1 ? "mptcp" : "tcp") + (gso == 1 ? "-gso" : "");
+          if (only != "all" && only != name)
+            {
+              continue;
+            }
+          GsoRun run (mptcp == 1, gso == 1, rate, delay, duration);
+          run.Execute ();
+          run.Print (std::cout);
+        }
+    }
+  return 0;
+}
@@ -0,0 +1,495 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Incast benchmark of ECN and DCTCP.
+ *
+ * Each sender has two links to the switch, and the receiver is dual-homed
+ * to the switch, whose queue disc towards each of its two links is a
+ * bottleneck:
+ *
+ *   sender 0   ==== x2 ====
+ *   ...                     switch ==== x2 ==== receiver
+ *   sender N-1 ==== x2 ====
+ *
+ * The senders keep one connection each to the receiver. In each round,
+ * every sender writes --bytes at once, and the round ends when the
+ * receiver has got them all. The TCP connections are spread over the two
+ * addresses of the receiver, while each MPTCP connection has one subflow
+ * per address:
+ *
+ *   tcp          NewReno, drop tail queues of --buffer packets
+ *   tcp-ecn      NewReno with ECN, RED queues marking above --threshold
+ *   dctcp        TcpDctcp, RED queues marking above --threshold
+ *   mptcp        MpTcpLia, drop tail queues
+ *   mptcp-dctcp  MpTcpDctcp, RED queues marking above --threshold
+ *
+ * The RED queues mark on the instantaneous queue, as RFC 8257 recommends
+ * (MinTh = MaxTh, QW = 1), and only drop when they are full. After a
+ * first round which sets up the connections, the program prints the mean
+ * and maximum completion times of the rounds, the drops and marks of the
+ * bottleneck queues, their mean and maximum lengths, and the goodput.
+ *
+ *   ./waf --run "bench-tcp-incast --senders=32 --run=dctcp"
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/traffic-control-module.h"
+#include "ns3/mptcp-socket-factory.h"
+#include "ns3/mptcp-meta-socket.h"
+
+using namespace ns3;
+
+#define LOG(x)   std::cerr << x << std::endl
+
+/**
+ * One incast simulation
+ */
+class IncastRun
+{
+public:
+  IncastRun (std::string mode, uint32_t senders, uint32_t bytes, uint32_t rounds,
+             std::string rate, std::string delay, uint32_t buffer, uint32_t threshold);
+
+  void Execute (void);
+  void Print (std::ostream &os) const;
+
+private:
+  void Setup (void);
+  void Connect (void);
+  void FullyEstablished (Ptr<MpTcpMetaSocket> meta);
+  void StartRound (void);
+  void Fill (uint32_t i);
+  void HandleSend (Ptr<Socket> sock, uint32_t available);
+  void Accept (Ptr<Socket> sock, const Address &from);
+  void HandleRecv (Ptr<Socket> sock);
+  void SampleQueues (void);
+  void Drop (Ptr<const QueueItem> item);
+  uint32_t CountMarks (void) const;
+
+  std::string m_mode;
+  bool m_mptcp;
+  bool m_marking;          //!< RED queues marking ECN-capable packets
+  uint32_t m_senders;
+  uint32_t m_bytes;        //!< Bytes written by each sender in a round
+  uint32_t m_rounds;       //!< Measured rounds, after the first one
+  std::string m_rate;
+  std::string m_delay;
+  uint32_t m_buffer;
+  uint32_t m_threshold;
+  uint32_t m_writeSize;
+  std::vector<std::vector<Ipv4Address> > m_senderAddresses;
+  Ipv4Address m_receiverAddresses[2];
+  std::vector<Ptr<Socket> > m_sources;
+  std::map<Ptr<Socket>, uint32_t> m_index;
+  std::vector<uint32_t> m_pending;     //!< Bytes left to write by each sender in the round
+  std::vector<Ptr<Socket> > m_accepted;
+  std::vector<uint8_t> m_payload;
+  Ptr<QueueDisc> m_queueDiscs[2];
+  uint32_t m_round;
+  Time m_roundStart;
+  uint64_t m_roundBytes;
+  std::vector<double> m_completions;   //!< Completion times of the measured rounds, in ms
+  Time m_measureStart;
+  Time m_measureEnd;
+  uint32_t m_drops;
+  uint32_t m_marks;        //!< Marks of the measured rounds
+  uint32_t m_samples;
+  uint64_t m_queueSum;
+  uint32_t m_queueMax;
+};
+
+IncastRun::IncastRun (std::string mode, uint32_t senders, uint32_t bytes, uint32_t rounds,
+                      std::string rate, std::string delay, uint32_t buffer, uint32_t threshold)
+  : m_mode (mode),
+    m_mptcp (mode == "mptcp" || mode == "mptcp-dctcp"),
+    m_marking (mode == "tcp-ecn" || mode == "dctcp" || mode == "mptcp-dctcp"),
+    m_senders (senders),
+    m_bytes (bytes),
+    m_rounds (rounds),
+    m_rate (rate),
+    m_delay (delay),
+    m_buffer (buffer),
+    m_threshold (threshold),
+    m_writeSize (1400),
+    m_round (0),
+    m_roundBytes (0),
+    m_drops (0),
+    m_marks (0),
+    m_samples (0),
+    m_queueSum (0),
+    m_queueMax (0)
+{
+}
+
+void
+IncastRun::Setup (void)
+{
+  std::string congestion = "ns3::TcpNewReno";
+  if (m_mode == "dctcp")
+    {
+      congestion = "ns3::TcpDctcp";
+    }
+  else if (m_mode == "mptcp")
+    {
+      congestion = "ns3::MpTcpLia";
+    }
+  else if (m_mode == "mptcp-dctcp")
+    {
+      congestion = "ns3::MpTcpDctcp";
+    }
+  Config::SetDefault ("ns3::TcpL4Protocol::SocketType", TypeIdValue (TypeId::LookupByName (congestion)));
+  Config::SetDefault ("ns3::MpTcpSocketFactory::CongestionControl", TypeIdValue (TypeId::LookupByName (congestion)));
+  Config::SetDefault ("ns3::MpTcpMetaSocket::ForkCongestionControl", BooleanValue (true));
+  Config::SetDefault ("ns3::TcpSocketImpl::Ecn", BooleanValue (m_mode == "tcp-ecn"));
+
+  NodeContainer senders;
+  senders.Create (m_senders);
+  Ptr<Node> sw = CreateObject<Node> ();
+  Ptr<Node> receiver = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.InstallAll ();
+
+  PointToPointHelper link;
+  link.SetDeviceAttribute ("DataRate", StringValue (m_rate));
+  link.SetChannelAttribute ("Delay", StringValue (m_delay));
+  link.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (1));
+
+  Ipv4AddressHelper address;
+  m_senderAddresses.resize (m_senders);
+  for (uint32_t i = 0; i < m_senders; ++i)
+    {
+      for (uint32_t k = 0; k < 2; ++k)
+        {
+          std::ostringstream base;
+          base << "10." << k + 1 << "." << i << ".0";
+          address.SetBase (base.str ().c_str (), "255.255.255.0");
+          Ipv4InterfaceContainer itf = address.Assign (link.Install (senders.Get (i), sw));
+          m_senderAddresses[i].push_back (itf.GetAddress (0));
+        }
+    }
+  NetDeviceContainer bottlenecks;
+  for (uint32_t k = 0; k < 2; ++k)
+    {
+      std::ostringstream base;
+      base << "10.100." << k << ".0";
+      address.SetBase (base.str ().c_str (), "255.255.255.0");
+      NetDeviceContainer devices = link.Install (sw, receiver);
+      m_receiverAddresses[k] = address.Assign (devices).GetAddress (1);
+      bottlenecks.Add (devices.Get (0));
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  // The queue discs of the switch towards the receiver are the bottleneck
+  // queues, in front of device queues of one packet
+  TrafficControlHelper tch;
+  tch.Uninstall (bottlenecks);
+  if (m_marking)
+    {
+      tch.SetRootQueueDisc ("ns3::RedQueueDisc",
+                            "MinTh", DoubleValue (m_threshold),
+                            "MaxTh", DoubleValue (m_threshold),
+                            "QW", DoubleValue (1),
+                            "Gentle", BooleanValue (false),
+                            "QueueLimit", UintegerValue (m_buffer),
+                            "UseEcn", BooleanValue (true),
+                            "UseHardDrop", BooleanValue (false),
+                            "MeanPktSize", UintegerValue (m_writeSize + 40),
+                            "LinkBandwidth", StringValue (m_rate),
+                            "LinkDelay", StringValue (m_delay));
+    }
+  else
+    {
+      tch.SetRootQueueDisc ("ns3::PfifoFastQueueDisc", "Limit", UintegerValue (m_buffer));
+    }
+  for (uint32_t k = 0; k < 2; ++k)
+    {
+      m_queueDiscs[k] = tch.Install (bottlenecks.Get (k)).Get (0);
+      m_queueDiscs[k]->TraceConnectWithoutContext ("Drop", MakeCallback (&IncastRun::Drop, this));
+    }
+
+  Ptr<Socket> listening;
+  if (m_mptcp)
+    {
+      listening = receiver->GetObject<MpTcpSocketFactory> ()->CreateSocket ();
+    }
+  else
+    {
+      listening = receiver->GetObject<TcpSocketFactory> ()->CreateSocket ();
+    }
+  listening->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  listening->Listen ();
+  listening->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                                MakeCallback (&IncastRun::Accept, this));
+
+  m_payload.resize (m_writeSize, 'x');
+  m_pending.resize (m_senders, 0);
+  for (uint32_t i = 0; i < m_senders; ++i)
+    {
+      Ptr<Socket> source;
+      if (m_mptcp)
+        {
+          Ptr<MpTcpMetaSocket> meta = DynamicCast<MpTcpMetaSocket> (senders.Get (i)->GetObject<MpTcpSocketFactory> ()->CreateSocket ());
+          NS_ABORT_MSG_UNLESS (meta, "MPTCP socket factory should create meta sockets");
+          meta->SetFullyEstablishedCallback (MakeCallback (&IncastRun::FullyEstablished, this));
+          source = meta;
+        }
+      else
+        {
+          source = senders.Get (i)->GetObject<TcpSocketFactory> ()->CreateSocket ();
+        }
+      source->SetSendCallback (MakeCallback (&IncastRun::HandleSend, this));
+      m_index[source] = i;
+      m_sources.push_back (source);
+    }
+  // The queue discs of the devices are only set up once the nodes are initialized
+  Simulator::Schedule (MilliSeconds (1), &IncastRun::Connect, this);
+  Simulator::Schedule (MilliSeconds (10), &IncastRun::StartRound, this);
+  Simulator::Schedule (MilliSeconds (10), &IncastRun::SampleQueues, this);
+}
+
+void
+IncastRun::Connect (void)
+{
+  for (uint32_t i = 0; i < m_senders; ++i)
+    {
+      // Half of the TCP connections go to each address of the receiver
+      uint32_t k = m_mptcp ? 0 : i % 2;
+      m_sources[i]->Bind (InetSocketAddress (m_senderAddresses[i][k], 0));
+      m_sources[i]->Connect (InetSocketAddress (m_receiverAddresses[k], 50000));
+    }
+}
+
+void
+IncastRun::FullyEstablished (Ptr<MpTcpMetaSocket> meta)
+{
+  uint32_t i = m_index[meta];
+  meta->ConnectNewSubflow (InetSocketAddress (m_senderAddresses[i][1], 0),
+                           InetSocketAddress (m_receiverAddresses[1], 50000));
+}
+
+void
+IncastRun::StartRound (void)
+{
+  if (m_round == 1)
+    {
+      m_measureStart = Simulator::Now ();
+      m_marks = CountMarks ();
+    }
+  m_roundStart = Simulator::Now ();
+  m_roundBytes = 0;
+  for (uint32_t i = 0; i < m_senders; ++i)
+    {
+      m_pending[i] += m_bytes;
+      Fill (i);
+    }
+}
+
+void
+IncastRun::Fill (uint32_t i)
+{
+  Ptr<Socket> sock = m_sources[i];
+  while (m_pending[i] > 0 && sock->GetTxAvailable () > 0)
+    {
+      uint32_t size = std::min (std::min (m_pending[i], m_writeSize), sock->GetTxAvailable ());
+      int sent = sock->Send (&m_payload[0], size, 0);
+      if (sent <= 0)
+        {
+          break;
+        }
+      m_pending[i] -= sent;
+    }
+}
+
+void
+IncastRun::HandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  std::map<Ptr<Socket>, uint32_t>::const_iterator it = m_index.find (sock);
+  if (it != m_index.end ())
+    {
+      Fill (it->second);
+    }
+}
+
+void
+IncastRun::Accept (Ptr<Socket> sock, const Address &from)
+{
+  sock->SetRecvCallback (MakeCallback (&IncastRun::HandleRecv, this));
+  m_accepted.push_back (sock);
+}
+
+void
+IncastRun::HandleRecv (Ptr<Socket> sock)
+{
+  Ptr<Packet> p;
+  while ((p = sock->Recv ()))
+    {
+      m_roundBytes += p->GetSize ();
+    }
+  if (m_roundBytes < uint64_t (m_senders) * m_bytes)
+    {
+      return;
+    }
+  if (m_round > 0)
+    {
+      m_completions.push_back ((Simulator::Now () - m_roundStart).GetSeconds () * 1000);
+    }
+  if (m_round == m_rounds)
+    {
+      m_measureEnd = Simulator::Now ();
+      Simulator::Stop ();
+      return;
+    }
+  ++m_round;
+  Simulator::ScheduleNow (&IncastRun::StartRound, this);
+}
+
+void
+IncastRun::SampleQueues (void)
+{
+  if (m_round > 0)
+    {
+      for (uint32_t k = 0; k < 2; ++k)
+        {
+          uint32_t packets = m_queueDiscs[k]->GetNPackets ();
+          m_queueSum += packets;
+          m_queueMax = std::max (m_queueMax, packets);
+          ++m_samples;
+        }
+    }
+  Simulator::Schedule (MicroSeconds (20), &IncastRun::SampleQueues, this);
+}
+
+void
+IncastRun::Drop (Ptr<const QueueItem> item)
+{
+  if (m_round > 0)
+    {
+      ++m_drops;
+    }
+}
+
+uint32_t
+IncastRun::CountMarks (void) const
+{
+  uint32_t marks = 0;
+  if (m_marking)
+    {
+      for (uint32_t k = 0; k < 2; ++k)
+        {
+          RedQueueDisc::Stats stats = DynamicCast<RedQueueDisc> (m_queueDiscs[k])->GetStats ();
+          marks += stats.unforcedMark + stats.forcedMark;
+        }
+    }
+  return marks;
+}
+
+void
+IncastRun::Execute (void)
+{
+  Setup ();
+  Simulator::Stop (Seconds (600));
+  Simulator::Run ();
+  m_marks = CountMarks () - m_marks;
+  m_sources.clear ();
+  m_index.clear ();
+  m_accepted.clear ();
+  m_queueDiscs[0] = 0;
+  m_queueDiscs[1] = 0;
+  Simulator::Destroy ();
+}
+
+void
+IncastRun::Print (std::ostream &os) const
+{
+  double sum = 0;
+  for (uint32_t i = 0; i < m_completions.size (); ++i)
+    {
+      sum += m_completions[i];
+    }
+  double duration = (m_measureEnd - m_measureStart).GetSeconds ();
+  os << std::setw (12) << m_mode
+     << std::setw (10) << m_completions.size ()
+     << std::setw (10) << std::fixed << std::setprecision (3) << sum / std::max<size_t> (m_completions.size (), 1)
+     << std::setw (10) << (m_completions.empty () ? 0 : *std::max_element (m_completions.begin (), m_completions.end ()))
+     << std::setw (8) << m_drops
+     << std::setw (8) << m_marks
+     << std::setw (10) << std::setprecision (1) << double (m_queueSum) / std::max<uint32_t> (m_samples, 1)
+     << std::setw (8) << m_queueMax
+     << std::setw (14) << std::setprecision (2)
+     << (duration > 0 ? m_completions.size () * double (m_senders) * m_bytes * 8 / duration / 1e6 : 0) << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t senders = 16;
+  uint32_t bytes = 64000;
+  uint32_t rounds = 20;
+  std::string rate = "1Gbps";
+  std::string delay = "10us";
+  uint32_t buffer = 100;
+  uint32_t threshold = 20;
+  std::string minRto = "10ms";
+  std::string only = "all";
+
+  CommandLine cmd;
+  cmd.AddValue ("senders", "number of senders", senders);
+  cmd.AddValue ("bytes", "bytes written by each sender in a round", bytes);
+  cmd.AddValue ("rounds", "measured rounds, after the first one", rounds);
+  cmd.AddValue ("rate", "rate of each link", rate);
+  cmd.AddValue ("delay", "delay of each link", delay);
+  cmd.AddValue ("buffer", "packets in each bottleneck queue", buffer);
+  cmd.AddValue ("threshold", "packets above which the RED queues mark", threshold);
+  cmd.AddValue ("minRto", "minimum retransmission timeout", minRto);
+  cmd.AddValue ("run", "all, or the only run: tcp, tcp-ecn, dctcp, mptcp or mptcp-dctcp", only);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1400));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (65535));
+  Config::SetDefault ("ns3::TcpSocketImpl::Timestamp", BooleanValue (false));
+  Config::SetDefault ("ns3::TcpSocketImpl::MinRto", TimeValue (Time (minRto)));
+
+  LOG (cmd.GetName () << ": " << senders << " senders of " << bytes << " bytes per round over "
+       << rate << ", " << delay << " links, " << buffer << " packet queues marking above " << threshold);
+  std::cout << std::setw (12) << "mode" << std::setw (10) << "rounds"
+            << std::setw (10) << "mean ms" << std::setw (10) << "max ms"
+            << std::setw (8) << "drops" << std::setw (8) << "marks"
+            << std::setw (10) << "mean q" << std::setw (8) << "max q"
+            << std::setw (14) << "goodput Mbps" << std::endl;
+  const char *modes[] = { "tcp", "tcp-ecn", "dctcp", "mptcp", "mptcp-dctcp" };
+  for (uint32_t m = 0; m < 5; ++m)
+    {
+      if (only != "all" && only != modes[m])
+        {
+          continue;
+        }
+      IncastRun run (modes[m], senders, bytes, rounds, rate, delay, buffer, threshold);
+      run.Execute ();
+      run.Print (std::cout);
+    }
+  return 0;
+}
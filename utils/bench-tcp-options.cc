@@ -0,0 +1,271 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Heap allocations per segment of the TCP options.
+ *
+ * The global operator new is counted during a bulk transfer over one point
+ * to point link, with TCP and the timestamp option, then with MPTCP, whose
+ * segments all carry a DSS option:
+ *
+ *   client ==== 1Gbps, 1ms ==== server
+ *
+ * Once the transfer reaches its steady state, the program prints the
+ * allocations per packet sent by IPv4 on both nodes, data segments and
+ * ACKs alike, with the wall clock time.
+ */
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/mptcp-socket-factory.h"
+#include "ns3/mptcp-meta-socket.h"
+
+using namespace ns3;
+
+#define LOG(x)   std::cerr << x << std::endl
+
+/** Number of calls to the global operator new. */
+static uint64_t g_allocations = 0;
+
+void *
+operator new (std::size_t size)
+{
+  g_allocations++;
+  void *p = std::malloc (size == 0 ? 1 : size);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+void
+operator delete (void *p) noexcept
+{
+  std::free (p);
+}
+
+void
+operator delete (void *p, std::size_t) noexcept
+{
+  std::free (p);
+}
+
+/**
+ * One bulk transfer
+ */
+class OptionsRun
+{
+public:
+  OptionsRun (bool mptcp, double warmup, double duration);
+
+  void Execute (void);
+  void Print (std::ostream &os) const;
+
+private:
+  void Setup (void);
+  void Connect (void);
+  void StartMeasure (void);
+  void HandleSend (Ptr<Socket> sock, uint32_t available);
+  void Accept (Ptr<Socket> sock, const Address &from);
+  void HandleRecv (Ptr<Socket> sock);
+  void IpTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  bool m_mptcp;
+  double m_warmup;
+  double m_duration;
+  uint32_t m_writeSize;
+  Ipv4Address m_serverAddress;
+  Ptr<Socket> m_source;
+  std::vector<Ptr<Socket> > m_accepted;
+  std::vector<uint8_t> m_payload;
+  bool m_measuring;
+  uint64_t m_packets;       //!< Packets sent by IPv4 while measuring
+  uint64_t m_allocStart;
+  uint64_t m_allocations;
+  double m_wallSeconds;
+};
+
+OptionsRun::OptionsRun (bool mptcp, double warmup, double duration)
+  : m_mptcp (mptcp),
+    m_warmup (warmup),
+    m_duration (duration),
+    m_writeSize (1400),
+    m_measuring (false),
+    m_packets (0),
+    m_allocStart (0),
+    m_allocations (0),
+    m_wallSeconds (0)
+{
+}
+
+void
+OptionsRun::Setup (void)
+{
+  // Without timestamps for MPTCP, as in the other MPTCP benchmarks
+  Config::SetDefault ("ns3::TcpSocketImpl::Timestamp", BooleanValue (!m_mptcp));
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  PointToPointHelper link;
+  link.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  link.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.0.0", "255.255.255.252");
+  m_serverAddress = address.Assign (link.Install (nodes)).GetAddress (1);
+  for (uint32_t k = 0; k < 2; ++k)
+    {
+      nodes.Get (k)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("Tx", MakeCallback (&OptionsRun::IpTx, this));
+    }
+
+  Ptr<Socket> listening;
+  if (m_mptcp)
+    {
+      listening = nodes.Get (1)->GetObject<MpTcpSocketFactory> ()->CreateSocket ();
+      m_source = nodes.Get (0)->GetObject<MpTcpSocketFactory> ()->CreateSocket ();
+      NS_ABORT_MSG_UNLESS (DynamicCast<MpTcpMetaSocket> (m_source), "MPTCP socket factory should create meta sockets");
+    }
+  else
+    {
+      listening = nodes.Get (1)->GetObject<TcpSocketFactory> ()->CreateSocket ();
+      m_source = nodes.Get (0)->GetObject<TcpSocketFactory> ()->CreateSocket ();
+    }
+  listening->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  listening->Listen ();
+  listening->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                                MakeCallback (&OptionsRun::Accept, this));
+
+  m_payload.resize (m_writeSize, 'x');
+  m_source->SetSendCallback (MakeCallback (&OptionsRun::HandleSend, this));
+  // The queue discs of the devices are only set up once the nodes are initialized
+  Simulator::Schedule (MilliSeconds (1), &OptionsRun::Connect, this);
+  Simulator::Schedule (Seconds (m_warmup), &OptionsRun::StartMeasure, this);
+}
+
+void
+OptionsRun::Connect (void)
+{
+  m_source->Bind ();
+  m_source->Connect (InetSocketAddress (m_serverAddress, 50000));
+}
+
+void
+OptionsRun::StartMeasure (void)
+{
+  m_measuring = true;
+  m_allocStart = g_allocations;
+}
+
+void
+OptionsRun::HandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  // The first data completes the MPTCP handshake
+  while (sock->GetTxAvailable () >= m_writeSize)
+    {
+      if (sock->Send (&m_payload[0], m_writeSize, 0) <= 0)
+        {
+          break;
+        }
+    }
+}
+
+void
+OptionsRun::Accept (Ptr<Socket> sock, const Address &from)
+{
+  sock->SetRecvCallback (MakeCallback (&OptionsRun::HandleRecv, this));
+  m_accepted.push_back (sock);
+}
+
+void
+OptionsRun::HandleRecv (Ptr<Socket> sock)
+{
+  Ptr<Packet> p;
+  while ((p = sock->Recv ()))
+    {
+    }
+}
+
+void
+OptionsRun::IpTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  if (m_measuring)
+    {
+      ++m_packets;
+    }
+}
+
+void
+OptionsRun::Execute (void)
+{
+  Setup ();
+  SystemWallClockMs wall;
+  wall.Start ();
+  Simulator::Stop (Seconds (m_warmup + m_duration));
+  Simulator::Run ();
+  m_allocations = g_allocations - m_allocStart;
+  m_wallSeconds = wall.End () / 1000.0;
+  m_source = 0;
+  m_accepted.clear ();
+  Simulator::Destroy ();
+}
+
+void
+OptionsRun::Print (std::ostream &os) const
+{
+  os << std::setw (8) << (m_mptcp ? "mptcp" : "tcp")
+     << std::setw (12) << m_packets
+     << std::setw (14) << m_allocations
+     << std::setw (12) << std::fixed << std::setprecision (2) << double (m_allocations) / m_packets
+     << std::setw (10) << std::setprecision (3) << m_wallSeconds << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  double warmup = 0.5;
+  double duration = 2.0;
+
+  CommandLine cmd;
+  cmd.AddValue ("warmup", "simulated seconds before the allocations are counted", warmup);
+  cmd.AddValue ("duration", "simulated seconds during which the allocations are counted", duration);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1400));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (65535));
+
+  LOG (cmd.GetName () << ": " << duration << " s of bulk transfer, after " << warmup << " s");
+  std::cout << std::setw (8) << "proto" << std::setw (12) << "packets"
+            << std::setw (14) << "allocations" << std::setw (12) << "per packet"
+            << std::setw (10) << "wall s" << std::endl;
+  for (uint32_t mptcp = 0; mptcp < 2; ++mptcp)
+    {
+      OptionsRun run (mptcp == 1, warmup, duration);
+      run.Execute ();
+      run.Print (std::cout);
+    }
+  return 0;
+}
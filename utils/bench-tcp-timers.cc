@@ -0,0 +1,241 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Benchmark of the TCP timers.
+ *
+ * Runs the same bulk transfers, over a single bottleneck between two nodes,
+ * with the TCP timers scheduled in the simulator and with the timers on a
+ * TcpTimerWheel. Every new ACK pushes the retransmission timeout back and
+ * every other segment arms the delayed ACK timer, so without the wheel the
+ * event queue mostly holds cancelled timers.
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/tcp-timer-wheel.h"
+
+using namespace ns3;
+
+#define LOG(x)   std::cout << x << std::endl
+
+// Output field width
+int g_fwidth = 14;
+
+/**
+ * Bulk transfers from one node to another, each one on its own connection.
+ */
+class TcpTimerBench
+{
+public:
+  TcpTimerBench (uint32_t flows, uint32_t bytes, std::string rate, Time delay);
+
+  /**
+   * Run the transfers
+   * \param granularity tick of the timer wheel, zero to schedule the timers
+   *        in the simulator
+   */
+  void Run (Time granularity);
+
+private:
+  void HandleSend (Ptr<Socket> sock, uint32_t available);
+  void HandleAccept (Ptr<Socket> sock, const Address &from);
+  void HandleRecv (Ptr<Socket> sock);
+
+  uint32_t m_flows;
+  uint32_t m_bytes;
+  std::string m_rate;
+  Time m_delay;
+  std::map<Ptr<Socket>, uint32_t> m_sent;  //!< Bytes sent on each connection
+  uint64_t m_received;                     //!< Bytes received on all the connections
+  Time m_completion;                       //!< Time the last byte was received
+};
+
+TcpTimerBench::TcpTimerBench (uint32_t flows, uint32_t bytes, std::string rate, Time delay)
+  : m_flows (flows),
+    m_bytes (bytes),
+    m_rate (rate),
+    m_delay (delay),
+    m_received (0)
+{
+}
+
+void
+TcpTimerBench::HandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  uint32_t &sent = m_sent[sock];
+  while (sent < m_bytes && sock->GetTxAvailable () > 0)
+    {
+      uint32_t size = std::min (sock->GetTxAvailable (), m_bytes - sent);
+      int ret = sock->Send (Create<Packet> (size));
+      if (ret <= 0)
+        {
+          break;
+        }
+      sent += ret;
+    }
+}
+
+void
+TcpTimerBench::HandleAccept (Ptr<Socket> sock, const Address &from)
+{
+  sock->SetRecvCallback (MakeCallback (&TcpTimerBench::HandleRecv, this));
+}
+
+void
+TcpTimerBench::HandleRecv (Ptr<Socket> sock)
+{
+  Ptr<Packet> p;
+  while ((p = sock->Recv ()))
+    {
+      m_received += p->GetSize ();
+    }
+  m_completion = Simulator::Now ();
+}
+
+void
+TcpTimerBench::Run (Time granularity)
+{
+  Config::SetDefault ("ns3::TcpL4Protocol::TimerWheelGranularity", TimeValue (granularity));
+  m_sent.clear ();
+  m_received = 0;
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  SimpleNetDeviceHelper link;
+  link.SetNetDevicePointToPointMode (true);
+  link.SetDeviceAttribute ("DataRate", StringValue (m_rate));
+  link.SetChannelAttribute ("Delay", TimeValue (m_delay));
+  NetDeviceContainer devices = link.Install (nodes);
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (devices);
+
+  Ptr<Socket> listening = Socket::CreateSocket (nodes.Get (1), TcpSocketFactory::GetTypeId ());
+  listening->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  listening->Listen ();
+  listening->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                                MakeCallback (&TcpTimerBench::HandleAccept, this));
+
+  for (uint32_t i = 0; i < m_flows; ++i)
+    {
+      Ptr<Socket> sock = Socket::CreateSocket (nodes.Get (0), TcpSocketFactory::GetTypeId ());
+      sock->SetSendCallback (MakeCallback (&TcpTimerBench::HandleSend, this));
+      sock->Bind ();
+      // The queue discs of the devices are only set up once the nodes are initialized
+      Simulator::Schedule (MilliSeconds (1), &Socket::Connect, sock,
+                           Address (InetSocketAddress (Ipv4Address ("10.1.1.2"), 50000)));
+      m_sent[sock] = 0;
+    }
+
+  uint64_t eventStart = Simulator::GetEventCount ();
+  SystemWallClockMs wall;
+  wall.Start ();
+  Simulator::Run ();
+  double elapsed = wall.End () / 1000.0;
+  uint64_t events = Simulator::GetEventCount () - eventStart;
+
+  NS_ABORT_MSG_UNLESS (m_received == uint64_t (m_flows) * m_bytes, "Transfers did not complete");
+
+  uint64_t wakeups = 0;
+  uint64_t expirations = 0;
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      Ptr<TcpTimerWheel> wheel = nodes.Get (i)->GetObject<TcpL4Protocol> ()->GetTimerWheel ();
+      if (wheel != 0)
+        {
+          wakeups += wheel->GetNWakeups ();
+          expirations += wheel->GetNExpirations ();
+        }
+    }
+
+  std::ostringstream timers;
+  if (granularity.IsStrictlyPositive ())
+    {
+      timers << "wheel " << granularity.GetMicroSeconds () << "us";
+    }
+  else
+    {
+      timers << "simulator";
+    }
+  LOG (std::left << std::setw (g_fwidth) << timers.str () <<
+       std::right << std::setw (g_fwidth) << elapsed <<
+       std::setw (g_fwidth) << events <<
+       std::setw (g_fwidth) << (events / elapsed) <<
+       std::setw (g_fwidth) << m_completion.GetSeconds () <<
+       std::setw (g_fwidth) << wakeups <<
+       std::setw (g_fwidth) << expirations);
+
+  Simulator::Destroy ();
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t flows = 50;
+  uint32_t bytes = 1000000;
+  std::string rate = "100Mbps";
+  Time delay = MilliSeconds (10);
+  Time granularity = MilliSeconds (1);
+  uint32_t runs = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the TCP timers, scheduled in the simulator or on a timer wheel.\n"
+             "\n"
+             "Each run transfers the same data over parallel TCP connections\n"
+             "sharing one bottleneck, once per timer implementation.");
+  cmd.AddValue ("flows",       "number of connections (default 50)",              flows);
+  cmd.AddValue ("bytes",       "bytes sent on each connection (default 1E6)",     bytes);
+  cmd.AddValue ("rate",        "bottleneck rate (default 100Mbps)",               rate);
+  cmd.AddValue ("delay",       "bottleneck delay (default 10ms)",                 delay);
+  cmd.AddValue ("granularity", "tick of the timer wheel (default 1ms)",           granularity);
+  cmd.AddValue ("runs",        "number of runs (default 1)",                      runs);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1400));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (65535));
+  Config::SetDefault ("ns3::TcpSocketImpl::Timestamp", BooleanValue (false));
+
+  LOG (cmd.GetName () << ": flows " << flows << " bytes " << bytes <<
+       " rate " << rate << " delay " << delay.GetMilliSeconds () << "ms runs " << runs);
+
+  TcpTimerBench bench (flows, bytes, rate, delay);
+
+  LOG ("");
+  LOG (std::left << std::setw (g_fwidth) << "Timers" <<
+       std::right << std::setw (g_fwidth) << "Time (s)" <<
+       std::setw (g_fwidth) << "Events" <<
+       std::setw (g_fwidth) << "Rate (ev/s)" <<
+       std::setw (g_fwidth) << "Sim time (s)" <<
+       std::setw (g_fwidth) << "Wake-ups" <<
+       std::setw (g_fwidth) << "Expirations");
+  for (uint32_t i = 0; i < runs; ++i)
+    {
+      bench.Run (Seconds (0));
+      bench.Run (granularity);
+    }
+  LOG ("");
+  return 0;
+}